@@ -23,6 +23,8 @@
 
 
 #include "OSS/ABNF/ABNFBaseRule.h"
+#include "OSS/ABNF/ABNFLRSequence.h"
+#include "OSS/ABNF/ABNFCharTable.h"
 
 
 namespace OSS {
@@ -100,7 +102,7 @@ public:
       switch(i)
       {
       case 0:
-        if (typeid(_rule0) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_0>::value)
           return iter;
         
         newIter = _rule0.parse(iter);
@@ -108,7 +110,7 @@ public:
           return newIter;
         break;
       case 1:
-        if (typeid(_rule1) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_1>::value)
           return iter;
         
         newIter = _rule1.parse(iter);
@@ -116,7 +118,7 @@ public:
           return newIter;
         break;
       case 2:
-        if (typeid(_rule2) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_2>::value)
           return iter;
         
         newIter = _rule2.parse(iter);
@@ -124,7 +126,7 @@ public:
           return newIter;
         break;
       case 3:
-        if (typeid(_rule3) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_3>::value)
           return iter;
         
         newIter = _rule3.parse(iter);
@@ -132,7 +134,7 @@ public:
           return newIter;
         break;
       case 4:
-        if (typeid(_rule4) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_4>::value)
           return iter;
         
         newIter = _rule4.parse(iter);
@@ -140,7 +142,7 @@ public:
           return newIter;
         break;
       case 5:
-        if (typeid(_rule5) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_5>::value)
           return iter;
         
         newIter = _rule5.parse(iter);
@@ -148,7 +150,7 @@ public:
           return newIter;
         break;
       case 6:
-        if (typeid(_rule6) == typeid(ABNFLRNullRule ) )
+        if (ABNFIsNullRule<Rule_6>::value )
           return iter;
         
         newIter = _rule6.parse( iter );
@@ -156,7 +158,7 @@ public:
           return newIter;
         break;
       case 7:
-        if ( typeid( _rule7 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_7>::value )
           return iter;
         
         newIter = _rule7.parse( iter );
@@ -164,7 +166,7 @@ public:
           return newIter;
         break;
       case 8:
-        if ( typeid( _rule8 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_8>::value )
           return iter;
         
         newIter = _rule8.parse( iter );
@@ -172,7 +174,7 @@ public:
           return newIter;
         break;
       case 9:
-        if ( typeid( _rule9 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_9>::value )
           return iter;
         
         newIter = _rule9.parse( iter );
@@ -180,7 +182,7 @@ public:
           return newIter;
         break;
       case 10:
-        if ( typeid( _rule10 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_10>::value )
           return iter;
         
         newIter = _rule10.parse( iter );
@@ -188,7 +190,7 @@ public:
           return newIter;
         break;
       case 11:
-        if ( typeid( _rule11 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_11>::value )
           return iter;
         
         newIter = _rule11.parse( iter );
@@ -196,7 +198,7 @@ public:
           return newIter;
         break;
       case 12:
-        if ( typeid( _rule12 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_12>::value )
           return iter;
         
         newIter = _rule12.parse( iter );
@@ -204,7 +206,7 @@ public:
           return newIter;
         break;
       case 13:
-        if ( typeid( _rule13 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_13>::value )
           return iter;
         
         newIter = _rule13.parse( iter );
@@ -212,7 +214,7 @@ public:
           return newIter;
         break;
       case 14:
-        if ( typeid( _rule14 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_14>::value )
           return iter;
         
         newIter = _rule14.parse( iter );
@@ -220,7 +222,7 @@ public:
           return newIter;
         break;
       case 15:
-        if ( typeid( _rule15 ) == typeid( ABNFLRNullRule ) )
+        if ( ABNFIsNullRule<Rule_15>::value )
           return iter;
         
         newIter = _rule15.parse( iter );
@@ -277,7 +279,7 @@ public:
       switch(i)
       {
       case 0:
-        if (typeid(_rule0) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_0>::value)
           return iter;
         
         newIter = _rule0.parse(iter);
@@ -285,7 +287,7 @@ public:
           return newIter;
         break;
       case 1:
-        if (typeid(_rule1) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_1>::value)
           return iter;
         
         newIter = _rule1.parse(iter);
@@ -293,7 +295,7 @@ public:
           return newIter;
         break;
       case 2:
-        if (typeid(_rule2) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_2>::value)
           return iter;
         
         newIter = _rule2.parse(iter);
@@ -337,7 +339,7 @@ public:
       switch(i)
       {
       case 0:
-        if (typeid(_rule0) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_0>::value)
           return iter;
         
         newIter = _rule0.parse(iter);
@@ -345,7 +347,7 @@ public:
           return newIter;
         break;
       case 1:
-        if (typeid(_rule1) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_1>::value)
           return iter;
         
         newIter = _rule1.parse(iter);
@@ -353,7 +355,7 @@ public:
           return newIter;
         break;
       case 2:
-        if (typeid(_rule2) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_2>::value)
           return iter;
         
         newIter = _rule2.parse(iter);
@@ -361,7 +363,7 @@ public:
           return newIter;
         break;
       case 3:
-        if (typeid(_rule3) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_3>::value)
           return iter;
         
         newIter = _rule3.parse(iter);
@@ -407,7 +409,7 @@ public:
       switch(i)
       {
       case 0:
-        if (typeid(_rule0) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_0>::value)
           return iter;
         
         newIter = _rule0.parse(iter);
@@ -415,7 +417,7 @@ public:
           return newIter;
         break;
       case 1:
-        if (typeid(_rule1) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_1>::value)
           return iter;
         
         newIter = _rule1.parse(iter);
@@ -423,7 +425,7 @@ public:
           return newIter;
         break;
       case 2:
-        if (typeid(_rule2) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_2>::value)
           return iter;
         
         newIter = _rule2.parse(iter);
@@ -431,7 +433,7 @@ public:
           return newIter;
         break;
       case 3:
-        if (typeid(_rule3) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_3>::value)
           return iter;
         
         newIter = _rule3.parse(iter);
@@ -439,7 +441,7 @@ public:
           return newIter;
         break;
       case 4:
-        if (typeid(_rule4) == typeid(ABNFLRNullRule))
+        if (ABNFIsNullRule<Rule_4>::value)
           return iter;
         
         newIter = _rule4.parse(iter);
@@ -477,38 +479,84 @@ class ABNFAnyOfChars : public ABNFBaseRule
 /// This template class satifies an OR rule for a series of characters
 {
 public:
+  typedef ABNFCharSetChars
+  <
+    c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,
+    c10,c11,c12,c13,c14,c15,c16,c17,c18,c19,
+    c20,c21,c22,c23,c24,c25,c26,c27,c28,c29,
+    c30,c31,c32,c33,c34,c35,c36,c37,c38,c39,
+    c40,c41,c42,c43,c44,c45,c46,c47,c48,c49
+  > CharSet;
+
   ABNFAnyOfChars()
   {
-    _value[0]  = c0;_value[1]   = c1;_value[2]   = c2;_value[3]   = c3;_value[4] = c4;         
-    _value[5]  = c5;_value[6]   = c6;_value[7]   = c7;_value[8]   = c8;_value[9] = c9;
-    _value[10] = c10;_value[11] = c11;_value[12] = c12;_value[13] = c13;_value[14] = c14;
-    _value[15] = c15;_value[16] = c16;_value[17] = c17;_value[18] = c18;_value[19] = c19;
-    _value[20] = c20;_value[21] = c21;_value[22] = c22;_value[23] = c23;_value[24] = c24;
-    _value[25] = c25;_value[26] = c26;_value[27] = c27;_value[28] = c28;_value[29] = c29;
-    _value[30] = c30;_value[31] = c31;_value[32] = c32;_value[33] = c33;_value[34] = c34;
-    _value[35] = c35;_value[36] = c36;_value[37] = c37;_value[38] = c38;_value[39] = c39;
-    _value[40] = c40;_value[41] = c41;_value[42] = c42;_value[43] = c43;_value[44] = c44;
-    _value[45] = c45;_value[46] = c46;_value[47] = c47;_value[48] = c48;_value[49] = c49;
   }
 
   char* parse(const char* _t)
   /// Returns the next off-set if the rule is satisfied
   {
-    char* startT = const_cast<char*>(_t);
-    char* t = startT;
-    for(size_t i = 0; i < 50; i++ )
-    {
-      char c = *t;
-      if( c == 0x00 )
-        return startT;
+    char* t = const_cast<char*>(_t);
+    if (ABNFCharTable<CharSet>::map[(unsigned char)*t])
+      t++;
+    return t;
+  }
+};
 
-      if( c == _value[i] )
-        return ++t;
-    }
+template
+  <
+    typename First_0, typename Rule_0,
+    typename First_1, typename Rule_1,
+    typename First_2 = ABNFCharSetEmpty, typename Rule_2 = ABNFLRNullRule,
+    typename First_3 = ABNFCharSetEmpty, typename Rule_3 = ABNFLRNullRule
+  >
+class ABNFAnyOfByFirstChar : public ABNFBaseRule
+  /// Ordered alternatives where each rule is paired with the set of
+  /// characters it can start with.  Only the alternatives whose set
+  /// contains the current character are attempted, so an input that can
+  /// only satisfy the last rule does not backtrack through the others.
+{
+public:
+  ABNFAnyOfByFirstChar(){};
+
+  char* parse(const char* _t)
+  /// Returns the next off-set if the rule is satisfied
+  {
+    char* startIter = const_cast<char*>(_t);
+    unsigned char c = (unsigned char)*startIter;
+    char* newIter;
 
-    return startT;
+    if (ABNFCharTable<First_0>::map[c])
+    {
+      newIter = _rule_0.parse(startIter);
+      if (newIter != startIter)
+        return newIter;
+    }
+    if (ABNFCharTable<First_1>::map[c])
+    {
+      newIter = _rule_1.parse(startIter);
+      if (newIter != startIter)
+        return newIter;
+    }
+    if (!ABNFIsNullRule<Rule_2>::value && ABNFCharTable<First_2>::map[c])
+    {
+      newIter = _rule_2.parse(startIter);
+      if (newIter != startIter)
+        return newIter;
+    }
+    if (!ABNFIsNullRule<Rule_3>::value && ABNFCharTable<First_3>::map[c])
+    {
+      newIter = _rule_3.parse(startIter);
+      if (newIter != startIter)
+        return newIter;
+    }
+    return startIter;
   }
-  char _value[50];
+
+private:
+  Rule_0 _rule_0;
+  Rule_1 _rule_1;
+  Rule_2 _rule_2;
+  Rule_3 _rule_3;
 };
 
 } } //OSS::ABNF
@@ -86,6 +86,62 @@ typedef ABNFBaseRuleIdentifiable<ABNF_RULE_ID_NOT_SET> ABNFBaseRule;
 
 typedef std::vector<std::string> ABNFTokens;
 
+struct ABNFTokenRange
+  /// A token captured by parseTokenRanges() expressed as an offset from
+  /// the start of the parsed string
+{
+  std::size_t offset;
+  std::size_t length;
+};
+
+class ABNFTokenRanges
+  /// Fixed capacity token list filled by parseTokenRanges().  Unlike
+  /// ABNFTokens this never allocates.  The capacity matches the largest
+  /// LR sequence.
+{
+public:
+  enum { MAX_TOKENS = 16 };
+
+  ABNFTokenRanges() : _size(0)
+  {
+  }
+
+  void push_back(std::size_t offset, std::size_t length)
+  {
+    if (_size < MAX_TOKENS)
+    {
+      _ranges[_size].offset = offset;
+      _ranges[_size].length = length;
+      ++_size;
+    }
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  void clear()
+  {
+    _size = 0;
+  }
+
+  const ABNFTokenRange& operator[](std::size_t index) const
+  {
+    return _ranges[index];
+  }
+
+  std::string str(const char* base, std::size_t index) const
+  /// Returns a copy of the token.  base must be the string given to parseTokenRanges()
+  {
+    return std::string(base + _ranges[index].offset, _ranges[index].length);
+  }
+
+private:
+  ABNFTokenRange _ranges[MAX_TOKENS];
+  std::size_t _size;
+};
+
 OSS_API char*
 #if OSS_OS_FAMILY_WINDOWS
 __cdecl
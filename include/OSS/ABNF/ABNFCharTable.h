@@ -0,0 +1,195 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare 
+// derivative works of the Software, all subject to the 
+// "GNU Lesser General Public License (LGPL)".
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef ABNF_CHARTABLE_INCLUDED
+#define ABNF_CHARTABLE_INCLUDED
+
+
+#include "OSS/ABNF/ABNFBaseRule.h"
+
+
+namespace OSS {
+namespace ABNF {
+
+//
+// Character sets are described at compile time by a nested test<C> template
+// and expanded into a 256 entry lookup table.  The table is constant
+// initialized so it lives in read-only data and is usable even while other
+// static objects are still being constructed.  NUL is never a member since
+// every rule relies on it as the end of input.
+//
+
+#define ABNF_CHAR_TABLE_ENTRY(Set_T, c) ((c) != 0 && Set_T::template test<(c)>::value)
+#define ABNF_CHAR_TABLE_4(Set_T, c) \
+  ABNF_CHAR_TABLE_ENTRY(Set_T, c), ABNF_CHAR_TABLE_ENTRY(Set_T, c + 1), \
+  ABNF_CHAR_TABLE_ENTRY(Set_T, c + 2), ABNF_CHAR_TABLE_ENTRY(Set_T, c + 3)
+#define ABNF_CHAR_TABLE_16(Set_T, c) \
+  ABNF_CHAR_TABLE_4(Set_T, c), ABNF_CHAR_TABLE_4(Set_T, c + 4), \
+  ABNF_CHAR_TABLE_4(Set_T, c + 8), ABNF_CHAR_TABLE_4(Set_T, c + 12)
+#define ABNF_CHAR_TABLE_64(Set_T, c) \
+  ABNF_CHAR_TABLE_16(Set_T, c), ABNF_CHAR_TABLE_16(Set_T, c + 16), \
+  ABNF_CHAR_TABLE_16(Set_T, c + 32), ABNF_CHAR_TABLE_16(Set_T, c + 48)
+#define ABNF_CHAR_TABLE_256(Set_T) \
+  ABNF_CHAR_TABLE_64(Set_T, 0), ABNF_CHAR_TABLE_64(Set_T, 64), \
+  ABNF_CHAR_TABLE_64(Set_T, 128), ABNF_CHAR_TABLE_64(Set_T, 192)
+
+template <typename Set_T>
+struct ABNFCharTable
+  /// The lookup table of a character set
+{
+  static const bool map[256];
+
+  static bool test(char c)
+  /// Returns true if c belongs to the set
+  {
+    return map[(unsigned char)c];
+  }
+};
+
+template <typename Set_T>
+const bool ABNFCharTable<Set_T>::map[256] = { ABNF_CHAR_TABLE_256(Set_T) };
+
+struct ABNFCharSetEmpty
+  /// A set without members
+{
+  template <int C> struct test { enum { value = 0 }; };
+};
+
+template <int minValue, int maxValue>
+struct ABNFCharSetRange
+  /// Satisfies any octet between minValue and maxValue inclusive
+{
+  template <int C> struct test { enum { value = (C >= minValue && C <= maxValue) }; };
+};
+
+template
+  <
+  char c0 = 0x00,char c1 = 0x00,char c2 = 0x00,char c3 = 0x00,char c4 = 0x00,
+  char c5 = 0x00,char c6 = 0x00,char c7 = 0x00,char c8 = 0x00,char c9 = 0x00,
+  char c10 = 0x00,char c11 = 0x00,char c12 = 0x00,char c13 = 0x00,char c14 = 0x00,
+  char c15 = 0x00,char c16 = 0x00,char c17 = 0x00,char c18 = 0x00,char c19 = 0x00,
+  char c20 = 0x00,char c21 = 0x00,char c22 = 0x00,char c23 = 0x00,char c24 = 0x00,
+  char c25 = 0x00,char c26 = 0x00,char c27 = 0x00,char c28 = 0x00,char c29 = 0x00,
+  char c30 = 0x00,char c31 = 0x00,char c32 = 0x00,char c33 = 0x00,char c34 = 0x00,
+  char c35 = 0x00,char c36 = 0x00,char c37 = 0x00,char c38 = 0x00,char c39 = 0x00,
+  char c40 = 0x00,char c41 = 0x00,char c42 = 0x00,char c43 = 0x00,char c44 = 0x00,
+  char c45 = 0x00,char c46 = 0x00,char c47 = 0x00,char c48 = 0x00,char c49 = 0x00
+  >
+struct ABNFCharSetChars
+  /// Satisfies any of the listed characters
+{
+  template <int C> struct test
+  {
+    enum
+    {
+      value =
+        C == (unsigned char)c0 || C == (unsigned char)c1 || C == (unsigned char)c2 || C == (unsigned char)c3 || C == (unsigned char)c4 ||
+        C == (unsigned char)c5 || C == (unsigned char)c6 || C == (unsigned char)c7 || C == (unsigned char)c8 || C == (unsigned char)c9 ||
+        C == (unsigned char)c10 || C == (unsigned char)c11 || C == (unsigned char)c12 || C == (unsigned char)c13 || C == (unsigned char)c14 ||
+        C == (unsigned char)c15 || C == (unsigned char)c16 || C == (unsigned char)c17 || C == (unsigned char)c18 || C == (unsigned char)c19 ||
+        C == (unsigned char)c20 || C == (unsigned char)c21 || C == (unsigned char)c22 || C == (unsigned char)c23 || C == (unsigned char)c24 ||
+        C == (unsigned char)c25 || C == (unsigned char)c26 || C == (unsigned char)c27 || C == (unsigned char)c28 || C == (unsigned char)c29 ||
+        C == (unsigned char)c30 || C == (unsigned char)c31 || C == (unsigned char)c32 || C == (unsigned char)c33 || C == (unsigned char)c34 ||
+        C == (unsigned char)c35 || C == (unsigned char)c36 || C == (unsigned char)c37 || C == (unsigned char)c38 || C == (unsigned char)c39 ||
+        C == (unsigned char)c40 || C == (unsigned char)c41 || C == (unsigned char)c42 || C == (unsigned char)c43 || C == (unsigned char)c44 ||
+        C == (unsigned char)c45 || C == (unsigned char)c46 || C == (unsigned char)c47 || C == (unsigned char)c48 || C == (unsigned char)c49
+    };
+  };
+};
+
+template
+  <
+    typename Set_0,
+    typename Set_1,
+    typename Set_2 = ABNFCharSetEmpty,
+    typename Set_3 = ABNFCharSetEmpty
+  >
+struct ABNFCharSetUnion
+  /// Satisfies any character belonging to one of the sets
+{
+  template <int C> struct test
+  {
+    enum
+    {
+      value = Set_0::template test<C>::value || Set_1::template test<C>::value ||
+        Set_2::template test<C>::value || Set_3::template test<C>::value
+    };
+  };
+};
+
+typedef ABNFCharSetRange<0x30, 0x39> ABNFCharSetDigit;
+/// DIGIT (%x30-39)
+
+typedef ABNFCharSetUnion<ABNFCharSetRange<0x41, 0x5A>, ABNFCharSetRange<0x61, 0x7A> > ABNFCharSetAlpha;
+/// ALPHA (%x41-5A / %x61-7A)
+
+typedef ABNFCharSetUnion<ABNFCharSetAlpha, ABNFCharSetDigit> ABNFCharSetAlphaNumeric;
+/// ALPHA / DIGIT
+
+typedef ABNFCharSetUnion<ABNFCharSetDigit, ABNFCharSetRange<0x41, 0x46>, ABNFCharSetRange<0x61, 0x66> > ABNFCharSetHex;
+/// HEXDIG, case insensitive
+
+template <typename Set_T>
+class ABNFCharClass : public ABNFBaseRule
+  /// This template rule satisfies a single character belonging
+  /// to Set_T using a single table lookup
+{
+public:
+  char* parse(const char* _t)
+  /// Returns the next off-set if the rule is satisfied
+  {
+    char* t = const_cast<char*>(_t);
+    if (ABNFCharTable<Set_T>::map[(unsigned char)*t])
+      t++;
+    return t;
+  }
+};
+
+template <typename Set_T, size_t MinSize_T, size_t MaxSize_T>
+class ABNFCharClassLoop : public ABNFBaseRule
+  /// Satisfies MinSize_T up to MaxSize_T characters belonging to Set_T.
+  /// This is equivalent to ABNFLoopUntil<ABNFCharClass<Set_T>, ABNFLoopExitIfNul, MinSize_T, MaxSize_T>
+  /// without constructing a rule per character.
+{
+public:
+  char* parse(const char* _t)
+  /// Returns the next off-set if the rule is satisfied
+  {
+    if (MinSize_T == 0)
+      _optional = true;
+
+    const bool* map = ABNFCharTable<Set_T>::map;
+    char* t = const_cast<char*>(_t);
+    size_t i = 0;
+    while (i < MaxSize_T && map[(unsigned char)*t])
+    {
+      t++;
+      i++;
+    }
+
+    if (i < MinSize_T)
+      return const_cast<char*>(_t);
+    return t;
+  }
+};
+
+} } //OSS::ABNF
+
+#endif  //ABNF_CHARTABLE_INCLUDED
@@ -62,6 +62,20 @@ public:
 };
 /// Null rule marker needed by ABNFLRSequence
 
+template <typename Rule_T>
+struct ABNFIsNullRule
+  /// Compile time check for unused rule slots.  This replaces the
+  /// typeid() comparison so the unused branches are dropped by the compiler
+{
+  enum { value = 0 };
+};
+
+template <>
+struct ABNFIsNullRule<ABNFLRNullRule>
+{
+  enum { value = 1 };
+};
+
 template 
 <
   typename Rule_0 = ABNFLRNullRule,
@@ -106,7 +120,7 @@ public:
     switch(i)
     {
     case 0:
-      if (typeid(_rule_0) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_0>::value)
         return iter;
       
       newIter = _rule_0.parse(iter);
@@ -115,7 +129,7 @@ public:
       iter = newIter;
       break;
     case 1:
-      if (typeid(_rule_1) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_1>::value)
         return iter;
       
       newIter = _rule_1.parse(iter);
@@ -124,7 +138,7 @@ public:
       iter = newIter;
       break;
     case 2:
-      if (typeid(_rule_2) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_2>::value)
         return iter;
       
       newIter = _rule_2.parse(iter);
@@ -133,7 +147,7 @@ public:
       iter = newIter;
       break;
     case 3:
-      if (typeid(_rule_3) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_3>::value)
         return iter;
       
       newIter = _rule_3.parse(iter);
@@ -142,7 +156,7 @@ public:
       iter = newIter;
       break;
     case 4:
-      if ( typeid(_rule_4) == typeid(ABNFLRNullRule))
+      if ( ABNFIsNullRule<Rule_4>::value)
         return iter;
       
       newIter = _rule_4.parse(iter);
@@ -151,7 +165,7 @@ public:
       iter = newIter;
       break;
     case 5:
-      if ( typeid(_rule_5) == typeid(ABNFLRNullRule))
+      if ( ABNFIsNullRule<Rule_5>::value)
         return iter;
       
       newIter = _rule_5.parse(iter);
@@ -160,7 +174,7 @@ public:
       iter = newIter;
       break;
     case 6:
-      if (typeid(_rule_6) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_6>::value)
         return iter;
       
       newIter = _rule_6.parse(iter);
@@ -169,7 +183,7 @@ public:
       iter = newIter;
       break;
     case 7:
-      if (typeid(_rule_7) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_7>::value)
         return iter;
       
       newIter = _rule_7.parse(iter);
@@ -178,7 +192,7 @@ public:
       iter = newIter;
       break;
     case 8:
-      if (typeid(_rule_8) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_8>::value)
         return iter;
       
       newIter = _rule_8.parse(iter);
@@ -187,7 +201,7 @@ public:
       iter = newIter;
       break;
     case 9:
-      if (typeid(_rule_9) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_9>::value)
         return iter;
       
       newIter = _rule_9.parse(iter);
@@ -196,7 +210,7 @@ public:
       iter = newIter;
       break;
     case 10:
-      if (typeid( _rule_10) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_10>::value)
         return iter;
       
       newIter = _rule_10.parse(iter);
@@ -205,7 +219,7 @@ public:
       iter = newIter;
       break;
     case 11:
-      if (typeid(_rule_11) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_11>::value)
         return iter;
       
       newIter = _rule_11.parse( iter );
@@ -214,7 +228,7 @@ public:
       iter = newIter;
       break;
     case 12:
-      if (typeid(_rule_12) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_12>::value)
         return iter;
       
       newIter = _rule_12.parse(iter);
@@ -223,7 +237,7 @@ public:
       iter = newIter;
       break;
     case 13:
-      if (typeid(_rule_13) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_13>::value)
         return iter;
       
       newIter = _rule_13.parse(iter);
@@ -232,7 +246,7 @@ public:
       iter = newIter;
       break;
     case 14:
-      if (typeid(_rule_14) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_14>::value)
         return iter;
       
       newIter = _rule_14.parse(iter);
@@ -241,7 +255,7 @@ public:
       iter = newIter;
       break;
     case 15:
-      if (typeid(_rule_15) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_15>::value)
         return iter;
       
       newIter = _rule_15.parse( iter );
@@ -269,7 +283,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
     switch(i)
     {
     case 0:
-      if (typeid(_rule_0) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_0>::value)
         return iter;
       
       newIter = _rule_0.parse(iter);
@@ -279,7 +293,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 1:
-      if (typeid(_rule_1) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_1>::value)
         return iter;
       
       newIter = _rule_1.parse(iter);
@@ -289,7 +303,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 2:
-      if (typeid(_rule_2) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_2>::value)
         return iter;
       
       newIter = _rule_2.parse(iter);
@@ -299,7 +313,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 3:
-      if (typeid(_rule_3) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_3>::value)
         return iter;
       
       newIter = _rule_3.parse(iter);
@@ -309,7 +323,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 4:
-      if ( typeid(_rule_4) == typeid(ABNFLRNullRule))
+      if ( ABNFIsNullRule<Rule_4>::value)
         return iter;
       
       newIter = _rule_4.parse(iter);
@@ -319,7 +333,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 5:
-      if ( typeid(_rule_5) == typeid(ABNFLRNullRule))
+      if ( ABNFIsNullRule<Rule_5>::value)
         return iter;
       
       newIter = _rule_5.parse(iter);
@@ -329,7 +343,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 6:
-      if (typeid(_rule_6) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_6>::value)
         return iter;
       
       newIter = _rule_6.parse(iter);
@@ -339,7 +353,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 7:
-      if (typeid(_rule_7) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_7>::value)
         return iter;
       
       newIter = _rule_7.parse(iter);
@@ -349,7 +363,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 8:
-      if (typeid(_rule_8) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_8>::value)
         return iter;
       
       newIter = _rule_8.parse(iter);
@@ -359,7 +373,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 9:
-      if (typeid(_rule_9) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_9>::value)
         return iter;
       
       newIter = _rule_9.parse(iter);
@@ -369,7 +383,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 10:
-      if (typeid( _rule_10) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_10>::value)
         return iter;
       
       newIter = _rule_10.parse(iter);
@@ -379,7 +393,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 11:
-      if (typeid(_rule_11) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_11>::value)
         return iter;
       
       newIter = _rule_11.parse( iter );
@@ -389,7 +403,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 12:
-      if (typeid(_rule_12) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_12>::value)
         return iter;
       
       newIter = _rule_12.parse(iter);
@@ -399,7 +413,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 13:
-      if (typeid(_rule_13) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_13>::value)
         return iter;
       
       newIter = _rule_13.parse(iter);
@@ -409,7 +423,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 14:
-      if (typeid(_rule_14) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_14>::value)
         return iter;
    
       newIter = _rule_14.parse(iter);
@@ -419,7 +433,7 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
       iter = newIter;
       break;
     case 15:
-      if (typeid(_rule_15) == typeid(ABNFLRNullRule))
+      if (ABNFIsNullRule<Rule_15>::value)
         return iter;
       
       newIter = _rule_15.parse( iter );
@@ -433,6 +447,185 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
   return startIter;
 }
 
+char* parseTokenRanges(const char* _t, ABNFTokenRanges& tokens)
+ /// Fills tokens with the offset and length of each parsed token.
+ /// Returns the next off-set if the rule is satisfied
+ {
+  char* _iter = const_cast<char*>(_t);
+
+  char* startIter = _iter;
+  char* iter = _iter;
+  char* newIter;
+
+  for (size_t i = 0; i < 16; i++)
+  {
+    switch(i)
+    {
+    case 0:
+      if (ABNFIsNullRule<Rule_0>::value)
+        return iter;
+      
+      newIter = _rule_0.parse(iter);
+      if (newIter == iter && !_rule_0.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 1:
+      if (ABNFIsNullRule<Rule_1>::value)
+        return iter;
+      
+      newIter = _rule_1.parse(iter);
+      if (newIter == iter && !_rule_1.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 2:
+      if (ABNFIsNullRule<Rule_2>::value)
+        return iter;
+      
+      newIter = _rule_2.parse(iter);
+      if (newIter == iter && !_rule_2.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 3:
+      if (ABNFIsNullRule<Rule_3>::value)
+        return iter;
+      
+      newIter = _rule_3.parse(iter);
+      if (newIter == iter && !_rule_3.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 4:
+      if ( ABNFIsNullRule<Rule_4>::value)
+        return iter;
+      
+      newIter = _rule_4.parse(iter);
+      if (newIter == iter && !_rule_4.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 5:
+      if ( ABNFIsNullRule<Rule_5>::value)
+        return iter;
+      
+      newIter = _rule_5.parse(iter);
+      if (newIter == iter && !_rule_5.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 6:
+      if (ABNFIsNullRule<Rule_6>::value)
+        return iter;
+      
+      newIter = _rule_6.parse(iter);
+      if ( newIter == iter && !_rule_6.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 7:
+      if (ABNFIsNullRule<Rule_7>::value)
+        return iter;
+      
+      newIter = _rule_7.parse(iter);
+      if (newIter == iter && !_rule_7.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 8:
+      if (ABNFIsNullRule<Rule_8>::value)
+        return iter;
+      
+      newIter = _rule_8.parse(iter);
+      if (newIter == iter && !_rule_8.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 9:
+      if (ABNFIsNullRule<Rule_9>::value)
+        return iter;
+      
+      newIter = _rule_9.parse(iter);
+      if (newIter == iter && !_rule_9.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 10:
+      if (ABNFIsNullRule<Rule_10>::value)
+        return iter;
+      
+      newIter = _rule_10.parse(iter);
+      if (newIter == iter && !_rule_10.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 11:
+      if (ABNFIsNullRule<Rule_11>::value)
+        return iter;
+      
+      newIter = _rule_11.parse( iter );
+      if (newIter == iter && !_rule_11.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 12:
+      if (ABNFIsNullRule<Rule_12>::value)
+        return iter;
+      
+      newIter = _rule_12.parse(iter);
+      if (newIter == iter && !_rule_12.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 13:
+      if (ABNFIsNullRule<Rule_13>::value)
+        return iter;
+      
+      newIter = _rule_13.parse(iter);
+      if (newIter == iter && !_rule_13.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 14:
+      if (ABNFIsNullRule<Rule_14>::value)
+        return iter;
+   
+      newIter = _rule_14.parse(iter);
+      if (newIter == iter && !_rule_14.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    case 15:
+      if (ABNFIsNullRule<Rule_15>::value)
+        return iter;
+      
+      newIter = _rule_15.parse( iter );
+      if (newIter == iter && !_rule_15.isOptional())
+        return startIter;
+      tokens.push_back(iter - _t, newIter - iter);
+      iter = newIter;
+      break;
+    }
+  }
+  return startIter;
+}
+
 private:
   Rule_0 _rule_0;
   Rule_1 _rule_1;
@@ -509,6 +702,28 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
   return t;
 }
 
+char* parseTokenRanges(const char* _t, ABNFTokenRanges& tokens)
+/// Fills tokens with the offset and length of each parsed token.
+/// Returns the next off-set if the rule is satisfied
+{
+  char* t = const_cast<char*>(_t);
+  char* startIter = t;
+
+  char* nextIter = _rule_0.parse(t);
+  if (nextIter == t && !_rule_0.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  nextIter = _rule_1.parse(t);
+  if (nextIter == t && !_rule_1.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+ 
+  return t;
+}
+
 private:
   Rule_0 _rule_0;
   Rule_1 _rule_1;
@@ -583,6 +798,34 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
   return t;
 }
 
+char* parseTokenRanges(const char* _t, ABNFTokenRanges& tokens)
+/// Fills tokens with the offset and length of each parsed token.
+/// Returns the next off-set if the rule is satisfied
+ {
+  char* t = const_cast<char*>(_t);
+  char* startIter = t;
+
+  char* nextIter = _rule_0.parse(t);
+  if (nextIter == t && !_rule_0.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  nextIter = _rule_1.parse(t);
+  if (nextIter == t && !_rule_1.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  nextIter = _rule_2.parse(t);
+  if (nextIter == t && !_rule_2.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+  
+  return t;
+}
+
 private:
   Rule_0 _rule_0;
   Rule_1 _rule_1;
@@ -670,6 +913,40 @@ char* parseTokens(const char* _t, ABNFTokens& tokens)
   return t; 
 }
 
+char* parseTokenRanges(const char* _t, ABNFTokenRanges& tokens)
+/// Fills tokens with the offset and length of each parsed token.
+/// Returns the next off-set if the rule is satisfied
+{
+  char* t = const_cast<char*>(_t);
+  char* startIter = t;
+
+  char* nextIter = _rule_0.parse(t);
+  if (nextIter == t && !_rule_0.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  nextIter = _rule_1.parse(t);
+  if (nextIter == t && !_rule_1.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  nextIter = _rule_2.parse(t);
+  if (nextIter == t && !_rule_2.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  nextIter = _rule_3.parse(t);
+  if (nextIter == t && !_rule_3.isOptional())
+    return startIter;
+  tokens.push_back(t - _t, nextIter - t);
+  t = nextIter;
+
+  return t; 
+}
+
 private:
   Rule_0 _rule_0;
   Rule_1 _rule_1;
@@ -769,6 +1046,46 @@ public:
 
     return t; 
   }
+
+  char* parseTokenRanges(const char* _t, ABNFTokenRanges& tokens)
+  /// Fills tokens with the offset and length of each parsed token.
+  /// Returns the next off-set if the rule is satisfied
+  {
+    char* t = const_cast<char*>(_t);
+    char* startIter = t;
+
+    char* nextIter = _rule_0.parse(t);
+    if (nextIter == t && !_rule_0.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_1.parse(t);
+    if (nextIter == t && !_rule_1.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_2.parse(t);
+    if (nextIter == t && !_rule_2.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_3.parse(t);
+    if (nextIter == t && !_rule_3.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter; 
+
+    nextIter = _rule_4.parse(t);
+    if (nextIter == t && !_rule_4.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter; 
+
+    return t; 
+  }
 private:
   Rule_0 _rule_0;
   Rule_1 _rule_1;
@@ -881,6 +1198,52 @@ public:
 
     return t; 
   }
+
+  char* parseTokenRanges(const char* _t, ABNFTokenRanges& tokens)
+  /// Fills tokens with the offset and length of each parsed token.
+  /// Returns the next off-set if the rule is satisfied
+  {
+    char* t = const_cast<char*>(_t);
+    char* startIter = t;
+
+    char* nextIter = _rule_0.parse(t);
+    if (nextIter == t && !_rule_0.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_1.parse(t);
+    if (nextIter == t && !_rule_1.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_2.parse(t);
+    if (nextIter == t && !_rule_2.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_3.parse(t);
+    if (nextIter == t && !_rule_3.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter; 
+
+    nextIter = _rule_4.parse(t);
+    if (nextIter == t && !_rule_4.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter;
+
+    nextIter = _rule_5.parse(t);
+    if (nextIter == t && !_rule_5.isOptional())
+      return startIter;
+    tokens.push_back(t - _t, nextIter - t);
+    t = nextIter; 
+
+    return t; 
+  }
 private:
   Rule_0 _rule_0;
   Rule_1 _rule_1;
@@ -23,6 +23,7 @@
 
 
 #include "OSS/ABNF/ABNFBaseRule.h"
+#include "OSS/ABNF/ABNFCharTable.h"
 #include "OSS/ABNF/ABNFLRSequence.h"
 #include "OSS/ABNF/ABNFStringLiteral.h"
 #include "OSS/ABNF/ABNFLoopUntil.h"
@@ -242,7 +243,7 @@ typedef ABNFCharComparison<'\''> ABNFCharSingleQuote;
 typedef ABNFCharComparison<'~'> ABNFCharTilde;
 typedef ABNFCharComparison<'$'> ABNFCharDollar;
 typedef ABNFCharComparison<'&'> ABNFCharAmpersand;
-typedef ABNFAnyOf<ABNFCharAlpha, ABNFCharDigit> ABNFCharAlphaNumeric;
+typedef ABNFCharClass<ABNFCharSetAlphaNumeric> ABNFCharAlphaNumeric;
 typedef ABNFRange<0x61, 0x66> ABNFCharLCaseA2F;
 typedef ABNFAnyOf<ABNFCharDigit, ABNFCharLCaseA2F> ABNFCharLCaseHex;
 
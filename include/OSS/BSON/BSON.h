@@ -32,6 +32,9 @@
 #include "OSS/BSON/BSONDocument.h"
 #include "OSS/BSON/BSONIterator.h"
 #include "OSS/BSON/BSONParser.h"
+#include "OSS/BSON/BSONArena.h"
+#include "OSS/BSON/BSONWriter.h"
+#include "OSS/BSON/BSONReader.h"
 
 #include "OSS/build.h"
 #if ENABLE_FEATURE_ZMQ
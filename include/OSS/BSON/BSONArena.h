@@ -0,0 +1,112 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_BSONARENA_H_INCLUDED
+#define OSS_BSONARENA_H_INCLUDED
+
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace BSON {
+
+
+class BSONArena : boost::noncopyable
+  /// Contiguous byte buffer that BSONWriter appends to.  It may start in a
+  /// buffer supplied by the caller, typically on the stack, and only moves
+  /// to the heap if the document outgrows it.  A heap buffer can be handed
+  /// over with release() so it can be sent without copying.
+{
+public:
+  enum
+  {
+    DEFAULT_CAPACITY = 256
+  };
+
+  BSONArena(std::size_t capacity = DEFAULT_CAPACITY);
+    /// Creates an arena with a heap buffer of the given capacity
+
+  BSONArena(uint8_t* buffer, std::size_t capacity);
+    /// Creates an arena that writes into buffer.  The buffer is not owned
+    /// and must outlive the arena.
+
+  ~BSONArena();
+
+  uint8_t* allocate(std::size_t len);
+    /// Extends the arena by len bytes and returns a pointer to them.
+    /// The pointer is only valid until the next call to allocate().
+    /// Returns 0 if memory could not be allocated.
+
+  uint8_t* data();
+  const uint8_t* data() const;
+  std::size_t size() const;
+  std::size_t capacity() const;
+
+  void clear();
+    /// Discards the contents but keeps the buffer
+
+  uint8_t* release(std::size_t& len);
+    /// Hands the contents over to the caller, who must free() them.
+    /// A buffer supplied by the caller is copied to the heap first.  The
+    /// arena is empty afterwards.
+
+private:
+  bool reserve(std::size_t capacity);
+  uint8_t* _data;
+  std::size_t _size;
+  std::size_t _capacity;
+  bool _isOwner;
+};
+
+
+//
+// Inlines
+//
+
+inline uint8_t* BSONArena::data()
+{
+  return _data;
+}
+
+inline const uint8_t* BSONArena::data() const
+{
+  return _data;
+}
+
+inline std::size_t BSONArena::size() const
+{
+  return _size;
+}
+
+inline std::size_t BSONArena::capacity() const
+{
+  return _capacity;
+}
+
+inline void BSONArena::clear()
+{
+  _size = 0;
+}
+
+
+} } // OSS::BSON
+
+#endif // OSS_BSONARENA_H_INCLUDED
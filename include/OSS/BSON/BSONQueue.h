@@ -25,6 +25,7 @@
 
 #include "OSS/BSON/BSONParser.h"
 #include "OSS/BSON/BSONDocument.h"
+#include "OSS/BSON/BSONWriter.h"
 #include "OSS/ZMQ/ZMQSocket.h"
 
 namespace OSS {
@@ -46,6 +47,11 @@ public:
   bool dequeue(BSONParser& msg);
   bool enqueue(BSONDocument& msg);
   bool dequeue(BSONDocument& msg);
+  bool enqueue(BSONWriter& msg);
+    /// Hands the writer's arena to the socket without copying it.
+    /// The arena is empty afterwards.
+  bool dequeue(std::string& bson);
+    /// Receives the encoded document.  Use BSONReader to read it in place.
   const std::string& getName() const;
     
 protected:
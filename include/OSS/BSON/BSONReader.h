@@ -0,0 +1,114 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_BSONREADER_H_INCLUDED
+#define OSS_BSONREADER_H_INCLUDED
+
+#include <string>
+#include <stdint.h>
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace BSON {
+
+
+class BSONReader
+  /// Read-only cursor over an encoded BSON document.  It walks the fields
+  /// in order by byte offset and reads values in place.  Nothing is copied
+  /// or looked up by key and the buffer is never modified.  The buffer must
+  /// outlive the reader and every reader returned by recurse().
+{
+public:
+  BSONReader();
+    /// Creates an invalid reader
+
+  BSONReader(const uint8_t* data, std::size_t len);
+    /// Positions the cursor before the first field of the document.
+    /// The document length prefix must fit in len.
+
+  bool isValid() const;
+    /// Returns true if the document header is well formed
+
+  bool next();
+    /// Moves to the next field.  Returns false at the end of the document
+    /// or if the next field is malformed.
+
+  int getType() const;
+    /// Returns the BSON type of the current field (see BSONValue::TYPE_*)
+
+  const char* getKey() const;
+    /// Returns the key of the current field.  Points into the buffer.
+
+  std::size_t getOffset() const;
+    /// Returns the byte offset of the current field from the start of the
+    /// buffer passed to the constructor
+
+  bool getString(std::string& value) const;
+  bool getString(const char*& value, std::size_t& len) const;
+    /// Points value into the buffer without copying
+  bool getBoolean(bool& value) const;
+  bool getInt32(int32_t& value) const;
+  bool getInt64(int64_t& value) const;
+  bool getIntptr(intptr_t& value) const;
+  bool getDouble(double& value) const;
+
+  bool recurse(BSONReader& child) const;
+    /// Opens a reader over the current document or array field
+
+private:
+  BSONReader(const uint8_t* base, std::size_t offset, std::size_t len);
+  const uint8_t* _base;
+  std::size_t _end;
+  std::size_t _offset;
+  std::size_t _next;
+  const uint8_t* _value;
+  std::size_t _valueLength;
+  int _type;
+};
+
+
+//
+// Inlines
+//
+
+inline bool BSONReader::isValid() const
+{
+  return _base != 0;
+}
+
+inline int BSONReader::getType() const
+{
+  return _type;
+}
+
+inline const char* BSONReader::getKey() const
+{
+  return _value ? (const char*)(_base + _offset + 1) : 0;
+}
+
+inline std::size_t BSONReader::getOffset() const
+{
+  return _offset;
+}
+
+
+} } // OSS::BSON
+
+#endif // OSS_BSONREADER_H_INCLUDED
@@ -22,6 +22,8 @@
 
 #include "OSS/OSS.h"
 #include "OSS/BSON/BSONParser.h"
+#include "OSS/BSON/BSONWriter.h"
+#include "OSS/BSON/BSONReader.h"
 #include <string>
 #include <map>
 #include <vector>
@@ -138,11 +140,13 @@ public:
   //
   void toBSON(BSONParser& bson) const;
   BSONParser toBSON() const;
+  bool toBSON(BSONWriter& bson) const;
   
   //
   // serialize from BSON
   //
   void fromBSON(const BSONParser& bson);
+  bool fromBSON(const uint8_t* bson, std::size_t len);
   
 protected:
   BSONValue& get(const Tokens& keys);
@@ -151,8 +155,12 @@ protected:
   const BSONValue& undefinedValue() const;
   void serializeDocument(const Document& document, std::ostream& strm) const;
   void serializeArray(const Array& array, std::ostream& strm) const;
-  void serializeDocument(const std::string& key, const Document& document, BSONParser& bson) const;
-  void serializeArray(const std::string& key, const Array& array, BSONParser& bson) const;
+  template <typename Builder_T>
+  void serializeDocument(const std::string& key, const Document& document, Builder_T& bson) const;
+  template <typename Builder_T>
+  void serializeArray(const std::string& key, const Array& array, Builder_T& bson) const;
+  template <typename Builder_T>
+  void serializeValue(Builder_T& bson) const;
   
   int _type;
   mutable boost::any _value;
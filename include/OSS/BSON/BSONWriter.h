@@ -0,0 +1,111 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_BSONWRITER_H_INCLUDED
+#define OSS_BSONWRITER_H_INCLUDED
+
+#include <string>
+#include <stdint.h>
+#include <boost/noncopyable.hpp>
+#include "OSS/OSS.h"
+#include "OSS/BSON/BSONArena.h"
+
+
+namespace OSS {
+namespace BSON {
+
+
+class BSONWriter : boost::noncopyable
+  /// Streaming BSON builder.  Elements are encoded straight into a
+  /// BSONArena in the order they are appended.  Open sub-documents are
+  /// tracked by the byte offset of their length prefix, which is patched
+  /// when the sub-document is closed, so nothing is ever looked up by key.
+  /// The append methods mirror BSONParser so the two are interchangeable
+  /// for serialization.
+{
+public:
+  enum
+  {
+    MAX_DEPTH = 32
+  };
+
+  BSONWriter(BSONArena& arena);
+    /// Clears the arena and starts the root document in it
+
+  bool appendString(const std::string& key, const std::string& value);
+  bool appendString(const std::string& key, const char* value, std::size_t len);
+  bool appendBoolean(const std::string& key, bool value);
+  bool appendInt32(const std::string& key, int32_t value);
+  bool appendInt64(const std::string& key, int64_t value);
+  bool appendIntptr(const std::string& key, intptr_t value);
+  bool appendDouble(const std::string& key, double value);
+  bool appendUndefined(const std::string& key);
+
+  bool appendDocumentBegin(const std::string& key);
+  bool appendDocumentEnd(const std::string& key);
+    /// Closes the innermost open document.  The key is not used.
+    /// Returns false if the innermost open container is an array.
+
+  bool appendArrayBegin(const std::string& key);
+  bool appendArrayEnd(const std::string& key);
+    /// Closes the innermost open array.  The key is not used.
+    /// Returns false if the innermost open container is a document.
+    /// Array elements are keyed by their index as strings, "0", "1", ...
+
+  bool finish();
+    /// Terminates the root document.  Returns false if a sub-document is
+    /// still open or an allocation failed.  Nothing can be appended after.
+
+  const uint8_t* getData();
+  std::size_t getDataLength();
+    /// Finishes the document if needed
+
+  BSONArena& arena();
+
+private:
+  uint8_t* appendElement(int type, const std::string& key, std::size_t valueLength);
+  bool beginContainer(int type, const std::string& key);
+  bool endContainer(int type);
+  BSONArena& _arena;
+  std::size_t _offsets[MAX_DEPTH];
+  int _types[MAX_DEPTH];
+  std::size_t _depth;
+  bool _finished;
+  bool _failed;
+};
+
+
+//
+// Inlines
+//
+
+inline BSONArena& BSONWriter::arena()
+{
+  return _arena;
+}
+
+inline bool BSONWriter::appendString(const std::string& key, const std::string& value)
+{
+  return appendString(key, value.data(), value.size());
+}
+
+
+} } // OSS::BSON
+
+#endif // OSS_BSONWRITER_H_INCLUDED
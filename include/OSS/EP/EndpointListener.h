@@ -24,7 +24,7 @@
 #include "OSS/SIP/SIPListener.h"
 #include "OSS/SIP/SIPTransportService.h"
 #include "OSS/SIP/SIPMessage.h"
-#include "OSS/UTL/BlockingQueue.h"
+#include "OSS/UTL/LockFreeQueue.h"
 
 
 namespace OSS {
@@ -37,7 +37,7 @@ using OSS::SIP::SIPTransportService;
 class EndpointListener : public SIPListener
 {
 public:
-  typedef BlockingQueue<SIPMessage::Ptr> EventQueue;
+  typedef LockFreeQueue<SIPMessage::Ptr> EventQueue;
   typedef boost::shared_ptr<EndpointListener> Ptr;
   
   EndpointListener( const std::string& endpointName);
@@ -32,6 +32,7 @@
 
 #include "OSS/UTL/Thread.h"
 #include "OSS/Exec/Command.h"
+#include "OSS/Exec/ProcessSupervisor.h"
 #include <unistd.h>
 #include <signal.h>
 #include <boost/filesystem.hpp>
@@ -88,18 +89,39 @@ public:
   void setInitializeWait(unsigned int ms);
   pid_t getPID() const;
 protected:
-  void internalExecuteAndMonitor(int intialWait);
+  void startMonitor(unsigned int initialWait);
+  bool stopMonitor();
+    /// Returns true if a watch was dropped
+  bool onSample(const ProcessSample& sample);
+    /// Called by the ProcessSupervisor at every sample interval.  Returns
+    /// false when the watch on the current PID is no longer needed.
+  void postRespawn(bool alive);
+    /// Hands the respawn to a worker thread.  Shutting down and restarting
+    /// can block for seconds and must not stall the supervisor thread that
+    /// samples every other process.
+  void respawn(bool alive);
+    /// Runs on the respawn thread.  Does nothing if monitoring was stopped
+    /// after the respawn was posted.
+  void joinRespawn();
+  bool isUnmonitored();
+  void setUnmonitored(bool unmonitor);
   std::string _processName;
   std::string _startupCommand;
   std::string _shutdownCommand;
   std::string _pidFile;
   pid_t _pid;
-  boost::thread* _pMonitorThread;
-  OSS::semaphore _frequencySync;
-  OSS::semaphore _backoffSync;
+  ProcessSupervisor::WatchId _watchId;
+  OSS::mutex_critic_sec _monitorMutex;
+    /// Guards _watchId, _unmonitor and _respawnPending.  They are written by
+    /// the caller, the supervisor thread and the respawn thread.
+  OSS::mutex_critic_sec _respawnMutex;
+    /// Held for the whole respawn so unmonitor() can wait for it to finish
+  boost::thread* _respawnThread;
+  bool _respawnPending;
   OSS::semaphore _pidSync;
   unsigned int _frequencyTime;
   unsigned int _backoffTime;
+  OSS::UInt64 _backoffExpires;
   unsigned int _maxIteration;
   unsigned int _deadProcessIteration;
   unsigned int _maxMemViolationIteration;
@@ -0,0 +1,193 @@
+// OSS Software Solutions Application Programmer Interface
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: EXEC
+//
+// Copyright (c) 2011, OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version..
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+
+
+#ifndef OSS_EXEC_PROCESS_SUPERVISOR_H_INCLUDED
+#define	OSS_EXEC_PROCESS_SUPERVISOR_H_INCLUDED
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include <unistd.h>
+#include <map>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+
+namespace OSS {
+namespace Exec {
+
+
+struct ProcessSample
+{
+  pid_t pid;
+  bool alive;
+  std::string name;
+    /// The process name as reported by /proc/<pid>/stat
+  OSS::UInt64 residentBytes;
+  double memPercent;
+    /// Resident memory relative to physical memory (0 - 100)
+  double cpuPercent;
+    /// CPU used since the previous sample.  100 means one full core.
+  int exitStatus;
+    /// The waitid() status if the process was our child and has been reaped,
+    /// otherwise -1
+
+  ProcessSample() :
+    pid(-1),
+    alive(false),
+    residentBytes(0),
+    memPercent(0.0),
+    cpuPercent(0.0),
+    exitStatus(-1)
+  {
+  }
+};
+
+
+class OSS_API ProcessSampler : boost::noncopyable
+  /// Incremental reader for /proc/<pid>/stat and /proc/<pid>/statm.
+  /// Both files are opened once and re-read with pread() on every sample
+  /// so polling costs two small reads instead of parsing smaps.  The
+  /// CPU ticks of the previous sample are kept to compute usage deltas.
+{
+public:
+  explicit ProcessSampler(pid_t pid);
+  ~ProcessSampler();
+
+  bool sample(ProcessSample& result);
+    /// Sample the process.  Returns false if the process no longer exists
+    /// or is a zombie.
+
+  int pidfd() const;
+    /// Returns the pidfd of the process or -1 if pidfd_open is not supported
+
+  pid_t pid() const;
+
+  static bool readName(pid_t pid, std::string& name);
+    /// Read the process name from /proc/<pid>/stat using a single read
+
+  static bool readStat(int fd, std::string& name, char& state, OSS::UInt64& cpuTicks);
+    /// Parse the name, state and utime + stime from an open stat file
+
+private:
+  pid_t _pid;
+  int _pidfd;
+  int _statFd;
+  int _statmFd;
+  OSS::UInt64 _lastTicks;
+  OSS::UInt64 _lastSampleTime;
+  bool _hasBaseline;
+};
+
+
+class OSS_API ProcessSupervisor : boost::noncopyable
+  /// Watches a set of processes from a single thread.  Liveness is driven
+  /// by pidfds registered with epoll so a death is reported as soon as it
+  /// happens.  Resource samples are taken at each watch's interval.  Kernels
+  /// without pidfd_open fall back to checking liveness on every sample.
+  ///
+  /// Handlers run on the supervisor thread and may call watch() and
+  /// unwatch().  A slow handler delays the samples of every other watch.
+{
+public:
+  typedef unsigned long WatchId;
+  typedef boost::function<bool(const ProcessSample&)> SampleHandler;
+    /// Return false to stop watching the process
+
+  ProcessSupervisor();
+  ~ProcessSupervisor();
+
+  static ProcessSupervisor& instance();
+    /// Returns the supervisor shared by all Process instances
+
+  WatchId watch(pid_t pid, unsigned int intervalMs, unsigned int initialDelayMs, const SampleHandler& handler);
+    /// Start watching a process.  A pid of -1 is allowed and is always
+    /// reported as dead.  Starts the supervisor thread if needed.
+
+  void unwatch(WatchId id);
+    /// Stop watching.  If the handler is running on another thread, this
+    /// waits for it to return.
+
+  bool isWatched(WatchId id) const;
+
+  std::size_t size() const;
+
+  void stop();
+    /// Stop the supervisor thread.  Watches are kept and resume on the
+    /// next call to watch().
+
+private:
+  struct Watch
+  {
+    WatchId id;
+    ProcessSampler* sampler;
+    SampleHandler handler;
+    unsigned int interval;
+    OSS::UInt64 nextSample;
+  };
+  typedef std::map<WatchId, Watch> Watches;
+
+  void start();
+  void run();
+  void wakeup();
+  void removeWatch(Watches::iterator iter);
+  bool dispatch(WatchId id, bool exited);
+  bool isSupervisorThread() const;
+
+  mutable OSS::mutex_critic_sec _mutex;
+  boost::condition_variable _dispatchDone;
+  Watches _watches;
+  WatchId _nextId;
+  WatchId _dispatching;
+  int _epollFd;
+  int _wakeupFd;
+  boost::thread* _pThread;
+  boost::thread::id _threadId;
+  bool _isTerminating;
+};
+
+
+//
+// Inlines
+//
+
+inline int ProcessSampler::pidfd() const
+{
+  return _pidfd;
+}
+
+inline pid_t ProcessSampler::pid() const
+{
+  return _pid;
+}
+
+} }  // OSS::Exec
+
+#endif	// OSS_EXEC_PROCESS_SUPERVISOR_H_INCLUDED
+
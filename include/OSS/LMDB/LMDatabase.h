@@ -63,8 +63,12 @@ public:
     inline bool cancelAdvised() const { return _cancelAdvised; };
     inline int& lastError() { return _lastError; };
     inline int lastError() const { return _lastError; };
+    inline bool isReadOnly() const { return _readOnly; };
     
     bool begin();
+    bool beginRead();
+      /// Begin a read-only transaction.  Read-only transactions do not
+      /// serialize with writers or with each other.
     bool end();
     void cancel();
   private:
@@ -72,6 +76,7 @@ public:
     void* _transaction;
     bool _cancelAdvised;
     int _lastError;
+    bool _readOnly;
   };
   
   class TransactionLock : boost::noncopyable
@@ -94,6 +99,8 @@ public:
     
     bool top();
     bool find(const std::string& key);
+    bool seek(const std::string& key);
+      /// Position the cursor at the first key greater than or equal to key
     bool next();
     bool bottom();
     std::string value() const;
@@ -151,6 +158,7 @@ protected:
   void* _db;
   Options _opt;
   OSS::mutex _mutex;
+  OSS::mutex_read_write _readMutex;
   bool _stopped;
 };
   
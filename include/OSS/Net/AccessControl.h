@@ -30,6 +30,7 @@
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/function.hpp>
+#include "OSS/Net/NetlinkBanSet.h"
 
 
 namespace OSS {
@@ -54,6 +55,7 @@ public:
   typedef std::set<boost::asio::ip::address> IPBlackList;
   typedef std::set<boost::asio::ip::address> IPWhiteList;
   typedef std::map<boost::asio::ip::address, unsigned int> PacketCounter;
+  typedef boost::shared_ptr<NetlinkBanSet> BanSetPtr;
   
   AccessControl();
   
@@ -127,7 +129,24 @@ public:
   
   void setAutoNullRoute(bool autoNullRoute);
   
+  void setBanSet(const BanSetPtr& banSet);
+    /// Mirrors banned sources into a kernel ipset.  The set is loaded with
+    /// the current bans right away.  Later bans and releases are queued on
+    /// the set and sent by its own thread so packet handling never waits
+    /// for netlink.
+  
+  const BanSetPtr& getBanSet() const;
+  
+  bool flushBanSet();
+    /// Sends queued ban set changes now instead of waiting for the ban set
+    /// thread.  Returns true if there is no ban set.
+  
 private:
+  void jailAddress(const boost::asio::ip::address& source);
+  
+  void releaseAddress(const boost::asio::ip::address& source);
+  
+
   bool _enabled;
   unsigned long _packetsPerSecondThreshold;
   unsigned long _thresholdViolationRate;
@@ -145,6 +164,7 @@ private:
   bool _denyAllIncoming;
   BanCallback _banCallback;
   bool _autoNullRoute;
+  BanSetPtr _banSet;
 };
 
 //
@@ -263,6 +283,11 @@ inline void AccessControl::setAutoNullRoute(bool autoNullRoute)
   _autoNullRoute = autoNullRoute;
 }
 
+inline const AccessControl::BanSetPtr& AccessControl::getBanSet() const
+{
+  return _banSet;
+}
+
 
 } } // OSS::SIP
 
@@ -28,7 +28,7 @@ public:
   bool sendAndReceive(const std::string& data, std::string& response);
   bool isConnected() const;
 private:
-  short getNextReadSize();
+  bool getNextReadSize(OSS::UInt32& len);
   boost::asio::io_service& _ioService;
   boost::asio::ip::tcp::resolver _resolver;
   boost::asio::ip::tcp::socket *_pSocket;
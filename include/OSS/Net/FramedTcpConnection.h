@@ -13,25 +13,42 @@
 #include <boost/noncopyable.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/shared_ptr.hpp>
+#include "OSS/OSS.h"
 
 namespace OSS {
 
 class FramedTcpListener;
 
-#define FTCP_VERSION 1
+#define FTCP_VERSION 2
 #define FTCP_KEY 22172
+#define FTCP_HEADER_SIZE 8
 #define FTCP_READ_BUFFER_SIZE 8192
+#define FTCP_MAX_FRAME_SIZE (16 * 1024 * 1024)
+#define FTCP_MAX_COALESCED_FRAMES 64
 
 class FramedTcpConnection : public boost::enable_shared_from_this<FramedTcpConnection>, boost::noncopyable
+  /// Server side of a framed TCP session.  Every frame starts with an eight
+  /// byte header in network byte order: a 16 bit version, a 16 bit key and
+  /// a 32 bit payload length.
+  ///
+  /// Writes are asynchronous.  Frames queued while a send is in progress
+  /// are sent together in the next one.  Their headers and payloads go to
+  /// the socket as a single gather list, without being copied into one
+  /// buffer.
+  ///
+  /// Reads land in a buffer that is reused for the life of the connection.
+  /// Complete frames are handed to the listener directly from it.  A
+  /// partial frame at the end is moved back to the front before the next
+  /// read.
 {
 public:
   typedef boost::asio::ip::tcp::socket::endpoint_type EndPoint;
   typedef boost::shared_ptr<FramedTcpConnection> Ptr;
-  struct Packet
+  struct Header
   {
-    short version; // Expecting version 1
-    short size; // size of the data buffer
-    char* data;
+    OSS::UInt16 version; // Expecting FTCP_VERSION
+    OSS::UInt16 key; // Expecting FTCP_KEY
+    OSS::UInt32 size; // size of the payload
   };
 
   explicit FramedTcpConnection(FramedTcpListener& listener);
@@ -44,6 +61,10 @@ public:
   void handleRead(const boost::system::error_code& e, std::size_t bytes_transferred);
 
   bool write(const std::string& data);
+    /// Queue a frame for sending.  Returns false if the connection is
+    /// closed or the frame exceeds FTCP_MAX_FRAME_SIZE.  Safe to call from
+    /// any thread.
+
   boost::asio::ip::tcp::socket& socket();
 
   const std::string& getLocalAddress() const;
@@ -52,20 +73,43 @@ public:
   unsigned short getRemotePort() const;
   const std::string& getApplicationId() const;
   void setApplicationId(const std::string& id);
+
+  static void encodeHeader(char* buffer, std::size_t size);
+    /// Write the frame header for a payload of size bytes to buffer.
+    /// buffer must hold FTCP_HEADER_SIZE bytes.
+
+  static bool decodeHeader(const char* buffer, Header& header);
+    /// Read a frame header from buffer.  Returns false if the version or
+    /// key do not match.
+
 protected:
-  void readMore(std::size_t bytes_transferred);
+  struct Frame
+  {
+    boost::array<char, FTCP_HEADER_SIZE> header;
+    std::string payload;
+  };
+  typedef std::vector<Frame> Frames;
+
+  bool processFrames();
+  void startWrite();
+  void handleWrite(const boost::system::error_code& e, std::size_t bytes_transferred);
   void startInactivityTimer();
   void onInactivityTimeout(const boost::system::error_code&);
+  void abort();
+    /// Drops the frames not yet written, shuts the socket down and removes
+    /// the connection from the listener
   boost::asio::io_service& _ioService;
   FramedTcpListener& _listener;
   boost::asio::ip::tcp::socket _socket;
   boost::asio::ip::tcp::resolver _resolver;
-  boost::array<char, 8192> _buffer;
-
-  std::string _messageBuffer;
-  std::string _spillOverBuffer;
-  std::size_t _moreReadRequired;
-  std::size_t _lastExpectedPacketSize;
+  std::vector<char> _readBuffer;
+  std::size_t _readStart;
+  std::size_t _readEnd;
+  boost::mutex _writeMutex;
+  Frames _pendingFrames;
+  Frames _writingFrames;
+  bool _isWriting;
+  bool _isOpen;
   std::string _localAddress;
   std::string _remoteAddress;
   unsigned short _localPort;
@@ -19,7 +19,7 @@ public:
   typedef boost::recursive_mutex mutex;
   typedef boost::lock_guard<mutex> mutex_lock;
   FramedTcpListener();
-  ~FramedTcpListener();
+  virtual ~FramedTcpListener();
   void run(const std::string& address, const std::string& port);
   void handleAccept(const boost::system::error_code& e);
   
@@ -29,7 +29,9 @@ public:
   void setInactivityThreshold(int threshold);
   int getInactivityThreshold() const;
 
-  void onIncomingRequest(FramedTcpConnection& connection, const char* data, std::size_t len);
+  virtual void onIncomingRequest(FramedTcpConnection& connection, const char* data, std::size_t len);
+    /// Called for every complete frame.  data points into the connection's
+    /// read buffer and is only valid for the duration of the call.
 
 protected:
   boost::asio::io_service _ioService;
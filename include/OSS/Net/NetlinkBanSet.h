@@ -0,0 +1,180 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef NETLINKBANSET_H_INCLUDED
+#define	NETLINKBANSET_H_INCLUDED
+
+
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "OSS/OSS.h"
+
+
+namespace OSS {
+namespace Net {
+
+class NetlinkBanSet : boost::noncopyable
+  /// Keeps banned source addresses in a pair of kernel ipset hash:ip sets,
+  /// one for IPv4 and one for IPv6 named after the IPv4 set with a "6"
+  /// suffix.  The sets are managed directly over nfnetlink so a ban is a
+  /// single hash insert instead of a route or a firewall rule per address.
+  ///
+  /// Adds and removals are queued and sent by a thread of the set, which
+  /// runs while the set is open.  Queueing never waits for netlink, so the
+  /// packet path never waits for the kernel.  Changes queued while a flush
+  /// is in progress go out in the next one.  Each message carries up to
+  /// MAX_BATCH_SIZE elements and several messages share one send, so a
+  /// burst of bans costs a handful of system calls.
+  ///
+  /// The sets only take effect when a packet filter rule references them,
+  /// for example
+  ///
+  ///   iptables -I INPUT -m set --match-set oss_banned src -j DROP
+  ///   ip6tables -I INPUT -m set --match-set oss_banned6 src -j DROP
+  ///
+  /// Such a rule is installed once and never changes while bans come and go.
+  /// Managing the sets requires CAP_NET_ADMIN.  Only Linux is supported.
+  /// open() fails on other platforms.
+{
+public:
+  typedef std::vector<boost::asio::ip::address> Addresses;
+
+  enum
+  {
+    DEFAULT_MAX_ELEMENTS = 1 << 20,
+    MAX_BATCH_SIZE = 1024,
+      /// Elements carried by one message
+    MAX_SEND_SIZE = 65536
+      /// Messages are packed into a single send up to this many bytes
+  };
+
+  enum Command
+  {
+    ADD,
+    DEL
+  };
+
+  explicit NetlinkBanSet(const std::string& setName = "oss_banned");
+
+  ~NetlinkBanSet();
+
+  bool open();
+    /// Opens the netlink socket, creates both sets and starts the thread
+    /// that sends queued changes.  Existing sets of the same name and type
+    /// are reused with their current contents.
+
+  void close();
+    /// Stops the sending thread and closes the socket.  Changes still
+    /// queued are dropped.
+
+  bool isOpen() const;
+
+  void add(const boost::asio::ip::address& address);
+    /// Queues an address for insertion.  Cancels a queued removal of the
+    /// same address.  Does nothing if the set is not open.
+
+  void remove(const boost::asio::ip::address& address);
+    /// Queues an address for removal.  Cancels a queued insertion of the
+    /// same address.  Does nothing if the set is not open.
+
+  std::size_t pending() const;
+    /// Number of queued adds and removals
+
+  bool flush();
+    /// Sends all queued changes now and waits for the kernel to acknowledge
+    /// them.  The sending thread calls this.  Adding an address already in
+    /// a set or removing one that is not there is not an error.
+
+  bool sync(const Addresses& banned);
+    /// Empties both sets and loads the given addresses.  Pending changes
+    /// are discarded.
+
+  const std::string& getSetName() const;
+
+  const std::string& getSetName6() const;
+
+  static bool encode(
+    std::string& buffer,
+    Command command,
+    const std::string& setName,
+    const Addresses& addresses,
+    OSS::UInt32 sequence);
+    /// Appends one ipset ADD or DEL message carrying the addresses to
+    /// buffer.  Every address must belong to the family of the set.
+    /// Returns false if the list is empty or mixes families.
+
+private:
+  typedef std::set<boost::asio::ip::address> Pending;
+
+  bool createSet(const std::string& setName, bool v6);
+  bool flushSet(const std::string& setName);
+  bool send(Command command, const Pending& pending);
+  bool transact(const std::string& buffer, OSS::UInt32 firstSequence, std::size_t messageCount);
+    /// Sends buffer and waits for the acknowledgements of the messageCount
+    /// messages numbered from firstSequence.  Acknowledgements left over
+    /// from a request that timed out are skipped.
+
+  void runFlusher();
+    /// Sends queued changes until the set is closed
+
+  std::string _setName;
+  std::string _setName6;
+  int _fd;
+  OSS::UInt32 _sequence;
+  boost::mutex _ioMutex;
+    /// Serializes netlink requests.  Guards _fd and _sequence.
+  mutable boost::mutex _mutex;
+    /// Guards the queued changes and _isFlushing
+  boost::condition_variable _pendingCondition;
+  bool _isFlushing;
+  boost::thread* _pFlusher;
+  Pending _adds;
+  Pending _dels;
+};
+
+//
+// Inlines
+//
+
+inline bool NetlinkBanSet::isOpen() const
+{
+  return _fd != -1;
+}
+
+inline const std::string& NetlinkBanSet::getSetName() const
+{
+  return _setName;
+}
+
+inline const std::string& NetlinkBanSet::getSetName6() const
+{
+  return _setName6;
+}
+
+} } // OSS::Net
+
+
+#endif	/* NETLINKBANSET_H_INCLUDED */
+
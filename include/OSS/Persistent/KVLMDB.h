@@ -0,0 +1,125 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef KVLMDB_H_INCLUDED
+#define	KVLMDB_H_INCLUDED
+
+#include "OSS/OSS.h"
+#include "OSS/LMDB/LMDatabase.h"
+#include "OSS/Persistent/KeyValueStoreBase.h"
+
+
+namespace OSS {
+namespace Persistent {
+
+
+class KVLMDB : boost::noncopyable
+  /// LMDB backend for KeyValueStoreBase.  Reads run in read-only
+  /// transactions that do not block each other or the writer, which makes
+  /// this backend a better fit than LevelDB for read-heavy workloads.
+{
+public: 
+  typedef KVRecord Record;
+  typedef KVKeys Keys;
+  typedef KVRecords Records;
+  
+  enum
+  {
+    DEFAULT_MAP_SIZE_MB = 1024
+  };
+  
+  KVLMDB();
+  
+  ~KVLMDB();
+
+  bool open(const std::string& path);
+    /// Open the environment in the directory given by path.  The directory
+    /// is created if it does not exist.
+
+  bool isOpen();
+
+  bool close();
+
+  bool put(const std::string& key, const std::string& value);
+
+  bool get(const std::string& key, std::string& value);
+  
+  bool del(const std::string& key);
+  
+  bool getKeys(Keys& keys);
+  
+  bool getKeys(const std::string& filter, Keys& keys);
+  
+  bool getRecords(Records& records);
+  
+  bool getRecords(const std::string& filter, Records& records);
+  
+  bool delKeys(const std::string& filter);
+
+  bool write(const KVOperations& operations);
+    /// Commit the operations in a single write transaction
+
+  bool scan(const std::string& startKey, std::size_t maxRecords, Records& records);
+    /// Return up to maxRecords records starting at the first key greater
+    /// than or equal to startKey
+  
+  const std::string getPath() const;
+  
+  const std::string& getKeyPrefix() const;
+  
+  void setKeyPrefix(const std::string& keyPrefix);
+
+  void setMapSize(std::size_t sizeMb);
+    /// Set the maximum size of the database.  Takes effect on the next open.
+
+private:
+  bool scan(const std::string& filter, bool withValues, Keys* keys, Records* records);
+
+  OSS::LMDB::LMDatabase* _pDb;
+  std::string _path;
+  std::string _keyPrefix;
+  std::size_t _mapSize;
+};
+
+
+//
+// Inlines
+//
+
+inline const std::string& KVLMDB::getKeyPrefix() const
+{
+  return _keyPrefix;
+}
+  
+inline void KVLMDB::setKeyPrefix(const std::string& keyPrefix)
+{
+  _keyPrefix = keyPrefix;
+}
+
+inline void KVLMDB::setMapSize(std::size_t sizeMb)
+{
+  _mapSize = sizeMb;
+}
+
+} } // OSS::Persistent
+
+#endif	// KVLMDB_H_INCLUDED
+
@@ -28,6 +28,7 @@
 #if OSS_HAVE_LEVELDB
 
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include "OSS/UTL/Thread.h"
 #include "OSS/Persistent/KeyValueStoreBase.h"
@@ -69,6 +70,13 @@ public:
   bool getRecords(const std::string& filter, Records& records);
   
   bool delKeys(const std::string& filter);
+
+  bool write(const KVOperations& operations);
+    /// Commit the operations in a single leveldb::WriteBatch
+
+  bool scan(const std::string& startKey, std::size_t maxRecords, Records& records);
+    /// Return up to maxRecords records starting at the first key greater
+    /// than or equal to startKey
   
   const std::string getPath() const;
   
@@ -23,12 +23,16 @@
 
 #include "OSS/Persistent/KeyValueStoreBase.h"
 #include "OSS/Persistent/KVLevelDB.h"
+#include "OSS/Persistent/KVLMDB.h"
 
 
 namespace OSS {
 namespace Persistent {
+#if OSS_HAVE_LEVELDB
   typedef KeyValueStoreBase<OSS::Persistent::KVLevelDB> KeyValueStoreLevelDB;
   typedef KeyValueStoreLevelDB KeyValueStore;
+#endif
+  typedef KeyValueStoreBase<OSS::Persistent::KVLMDB> KeyValueStoreLMDB;
 } }
 
 
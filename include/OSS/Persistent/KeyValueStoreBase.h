@@ -18,14 +18,17 @@
 //
 
 
+
 #ifndef OSS_KEYVALUESTOREBASE_H_INCLUDED
 #define OSS_KEYVALUESTOREBASE_H_INCLUDED
 
 
 #include "OSS/OSS.h"
 #include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
+#include <boost/thread.hpp>
 #include <vector>
 
 
@@ -33,6 +36,7 @@ namespace OSS {
 namespace Persistent {
 
 #define PERSISTENT_STORE_EXPIRES_SUFFIX ".KV_EXPIRES"
+#define PERSISTENT_STORE_TTL_HEADER_SIZE 12
   
 struct KVRecord
 {
@@ -43,6 +47,135 @@ struct KVRecord
 typedef std::vector<std::string> KVKeys;
 typedef std::vector<KVRecord> KVRecords;
 
+struct KVOperation
+  /// A single put or delete inside a write batch.  Backends receive the
+  /// value already encoded with its expiry header.
+{
+  enum Type
+  {
+    Put,
+    Del
+  };
+
+  Type type;
+  std::string key;
+  std::string value;
+  unsigned int expireInSeconds;
+    /// Zero means the record never expires
+};
+
+typedef std::vector<KVOperation> KVOperations;
+
+class KVWriteBatch
+  /// Collects puts and deletes that are committed together by
+  /// KeyValueStoreBase::write().  Operations are applied in order.
+{
+public:
+  void put(const std::string& key, const std::string& value)
+  {
+    append(KVOperation::Put, key, value, 0);
+  }
+
+  void put(const std::string& key, const std::string& value, unsigned int expireInSeconds)
+  {
+    append(KVOperation::Put, key, value, expireInSeconds);
+  }
+
+  void del(const std::string& key)
+  {
+    append(KVOperation::Del, key, std::string(), 0);
+  }
+
+  void clear()
+  {
+    _operations.clear();
+  }
+
+  std::size_t size() const
+  {
+    return _operations.size();
+  }
+
+  bool empty() const
+  {
+    return _operations.empty();
+  }
+
+  const KVOperations& operations() const
+  {
+    return _operations;
+  }
+
+private:
+  void append(KVOperation::Type type, const std::string& key, const std::string& value, unsigned int expireInSeconds)
+  {
+    _operations.push_back(KVOperation());
+    KVOperation& op = _operations.back();
+    op.type = type;
+    op.key = key;
+    op.value = value;
+    op.expireInSeconds = expireInSeconds;
+  }
+
+  KVOperations _operations;
+};
+
+//
+// Expiring values are stored behind a fixed size header made of a four byte
+// magic followed by the absolute expiry time in milliseconds (big endian).
+// Values that never expire are stored as is unless they happen to begin
+// with the magic, in which case they get a header with a zero expiry.
+//
+static const char PERSISTENT_STORE_TTL_MAGIC[4] = { '\0', 'K', 'V', 'T' };
+
+inline bool kv_has_ttl_header(const std::string& stored)
+{
+  return stored.size() >= PERSISTENT_STORE_TTL_HEADER_SIZE &&
+    stored.compare(0, 4, PERSISTENT_STORE_TTL_MAGIC, 4) == 0;
+}
+
+inline void kv_encode_value(const std::string& value, OSS::UInt64 expiresAt, std::string& stored)
+{
+  if (!expiresAt && !(value.size() >= 4 && value.compare(0, 4, PERSISTENT_STORE_TTL_MAGIC, 4) == 0))
+  {
+    stored = value;
+    return;
+  }
+  stored.clear();
+  stored.reserve(PERSISTENT_STORE_TTL_HEADER_SIZE + value.size());
+  stored.append(PERSISTENT_STORE_TTL_MAGIC, 4);
+  for (int shift = 56; shift >= 0; shift -= 8)
+    stored.push_back((char)((expiresAt >> shift) & 0xFF));
+  stored.append(value);
+}
+
+inline OSS::UInt64 kv_decode_expires(const std::string& stored)
+{
+  if (!kv_has_ttl_header(stored))
+    return 0;
+  OSS::UInt64 expiresAt = 0;
+  for (std::size_t i = 4; i < PERSISTENT_STORE_TTL_HEADER_SIZE; i++)
+    expiresAt = (expiresAt << 8) | (unsigned char)stored[i];
+  return expiresAt;
+}
+
+inline OSS::UInt64 kv_decode_value(const std::string& stored, std::string& value)
+  /// Strip the header from a stored value and return its expiry time
+{
+  if (!kv_has_ttl_header(stored))
+  {
+    value = stored;
+    return 0;
+  }
+  value = stored.substr(PERSISTENT_STORE_TTL_HEADER_SIZE);
+  return kv_decode_expires(stored);
+}
+
+inline bool kv_is_expired(OSS::UInt64 expiresAt, OSS::UInt64 now)
+{
+  return expiresAt && expiresAt <= now;
+}
+
  struct KVInputProcessor
 {
   enum Action
@@ -64,19 +197,37 @@ typedef std::vector<KVInputProcessor> KVInputProcessors;
   
 template <typename KV>
 class KeyValueStoreBase : boost::noncopyable
+  /// Key/value store front end shared by the LevelDB and LMDB backends.
+  ///
+  /// Expiry is encoded in the value itself so a put with a TTL is a single
+  /// write and a get is a single point read.  Expired records are purged
+  /// when read and reclaimed in the background by an incremental sweeper
+  /// started with startSweeper().
+  ///
+  /// Older versions kept the expiry under a separate
+  /// PERSISTENT_STORE_EXPIRES_SUFFIX key.  Such records are folded into the
+  /// new format when the store is opened so reads never look for them.
 {
 public:
-  KeyValueStoreBase()
+  KeyValueStoreBase() :
+    _pSweeperThread(0),
+    _sweeperInterval(0),
+    _sweeperBatchSize(0),
+    _isSweeperTerminating(false)
   {
   }
   
   ~KeyValueStoreBase()
   {
+    stopSweeper();
   }
 
   bool open(const std::string& path)
   {
-    return _impl.open(path);
+    if (!_impl.open(path))
+      return false;
+    foldLegacyExpires();
+    return true;
   }
 
   bool isOpen()
@@ -86,6 +237,7 @@ public:
 
   bool close()
   {
+    stopSweeper();
     return _impl.close();
   }
 
@@ -97,7 +249,10 @@ public:
         if (iter->put(key, value, -1) == KVInputProcessor::Ignore)
           return false;
     }
-    return _impl.put(key, value);
+    std::string stored;
+    kv_encode_value(value, 0, stored);
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
+    return _impl.put(key, stored);
   }
 
   bool put(const std::string& key, const std::string& value, unsigned int expireInSeconds)
@@ -109,38 +264,68 @@ public:
           return false;
     }
     
-    OSS::UInt64 expires = OSS::getTime() + (expireInSeconds*1000);
-    std::string expireString = OSS::string_from_number(expires);
-    std::string expireKey = key + PERSISTENT_STORE_EXPIRES_SUFFIX;
-  
-    if (!_impl.put(expireKey, expireString))
-      return false;
-    
-    return _impl.put(key, value);
+    std::string stored;
+    kv_encode_value(value, OSS::getTime() + ((OSS::UInt64)expireInSeconds * 1000), stored);
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
+    return _impl.put(key, stored);
   }
 
-  bool get(const std::string& key, std::string& value)
+  bool write(const KVWriteBatch& batch)
+    /// Commit every operation in the batch atomically.  Operations rejected
+    /// by an input processor are left out of the batch.
   {
-    if (is_expired(key))
+    const KVOperations& operations = batch.operations();
+    KVOperations encoded;
+    encoded.reserve(operations.size());
+    OSS::UInt64 now = OSS::getTime();
+    for (KVOperations::const_iterator op = operations.begin(); op != operations.end(); op++)
     {
-      purge_expired(key);
-      return false;
+      bool allowed = true;
+      for (KVInputProcessors::iterator iter = _inputProc.begin(); iter != _inputProc.end() && allowed; iter++)
+      {
+        if (op->type == KVOperation::Put && iter->put)
+          allowed = iter->put(op->key, op->value, op->expireInSeconds ? op->expireInSeconds : -1) != KVInputProcessor::Ignore;
+        else if (op->type == KVOperation::Del && iter->del)
+          allowed = iter->del(op->key) != KVInputProcessor::Ignore;
+      }
+      if (!allowed)
+        continue;
+
+      encoded.push_back(KVOperation());
+      KVOperation& out = encoded.back();
+      out.type = op->type;
+      out.key = op->key;
+      out.expireInSeconds = op->expireInSeconds;
+      if (op->type == KVOperation::Put)
+        kv_encode_value(op->value, op->expireInSeconds ? now + ((OSS::UInt64)op->expireInSeconds * 1000) : 0, out.value);
     }
-    
-    return _impl.get(key, value);
+
+    if (encoded.empty())
+      return true;
+
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
+    return _impl.write(encoded);
+  }
+
+  bool get(const std::string& key, std::string& value)
+  {
+    return get(key, value, true);
   }
   
   bool get(const std::string& key, std::string& value, bool purgeExpired)
   {
-    if (purgeExpired)
+    std::string stored;
+    if (!_impl.get(key, stored))
+      return false;
+
+    OSS::UInt64 expiresAt = kv_decode_value(stored, value);
+    if (purgeExpired && kv_is_expired(expiresAt, OSS::getTime()))
     {
-      if (is_expired(key))
-      {
-        purge_expired(key);
-        return false;
-      }
+      purge_expired(key);
+      value.clear();
+      return false;
     }
-    return _impl.get(key, value);
+    return true;
   }
 
   bool del(const std::string& key)
@@ -151,6 +336,7 @@ public:
         if (iter->del(key) == KVInputProcessor::Ignore)
           return false;
     }
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
     return _impl.del(key);
   }
   
@@ -162,10 +348,13 @@ public:
         if (iter->delKeys(filter) == KVInputProcessor::Ignore)
           return false;
     }
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
     return _impl.delKeys(filter);
   }
   
   bool getKeys(KVKeys& keys)
+    /// Return all keys.  Keys that expired but have not been reclaimed
+    /// yet may be included.
   {
     return _impl.getKeys(keys);
   }
@@ -177,12 +366,138 @@ public:
   
   bool getRecords(KVRecords& records)
   {
-    return _impl.getRecords(records);
+    if (!_impl.getRecords(records))
+      return false;
+    decode_records(records);
+    return true;
   }
   
   bool getRecords(const std::string& filter, KVRecords& records)
   {
-    return _impl.getRecords(filter, records);
+    if (!_impl.getRecords(filter, records))
+      return false;
+    decode_records(records);
+    return true;
+  }
+
+  std::size_t sweepExpired(std::size_t maxRecords)
+    /// Examine up to maxRecords records starting where the previous sweep
+    /// stopped and delete the expired ones in a single batch.  Returns the
+    /// number of records reclaimed.
+  {
+    KVRecords records;
+    std::string startKey;
+    {
+      OSS::mutex_critic_sec_lock lock(_sweeperMutex);
+      startKey = _sweeperCursor;
+    }
+
+    if (!_impl.scan(startKey, maxRecords, records))
+      return 0;
+
+    {
+      OSS::mutex_critic_sec_lock lock(_sweeperMutex);
+      if (records.size() < maxRecords)
+        _sweeperCursor.clear();
+      else
+        _sweeperCursor = records.back().key + '\0';
+    }
+
+    OSS::UInt64 now = OSS::getTime();
+    KVKeys candidates;
+    KVRecords legacy;
+    for (KVRecords::const_iterator iter = records.begin(); iter != records.end(); iter++)
+    {
+      if (OSS::string_ends_with(iter->key, PERSISTENT_STORE_EXPIRES_SUFFIX))
+        legacy.push_back(*iter);
+      else if (kv_is_expired(kv_decode_expires(iter->value), now))
+        candidates.push_back(iter->key);
+    }
+
+    if (candidates.empty() && legacy.empty())
+      return 0;
+
+    //
+    // Re-check under the write lock so that a record refreshed after the
+    // scan is never deleted
+    //
+    std::size_t reclaimed = 0;
+    KVOperations operations;
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
+    for (KVKeys::const_iterator iter = candidates.begin(); iter != candidates.end(); iter++)
+    {
+      std::string stored;
+      if (_impl.get(*iter, stored) && kv_is_expired(kv_decode_expires(stored), now))
+      {
+        append_delete(operations, *iter);
+        ++reclaimed;
+      }
+    }
+
+    reclaimed += fold_legacy(legacy, now, operations);
+
+    if (operations.empty() || !_impl.write(operations))
+      return 0;
+    return reclaimed;
+  }
+
+  std::size_t foldLegacyExpires(std::size_t batchSize = 1000)
+    /// Convert every record written with a separate expires key and drop
+    /// the ones that already expired.  Called by open().  Returns the
+    /// number of records reclaimed.
+  {
+    std::size_t reclaimed = 0;
+    std::string startKey;
+    for (;;)
+    {
+      KVRecords records;
+      if (!_impl.scan(startKey, batchSize, records))
+        break;
+
+      KVRecords legacy;
+      for (KVRecords::const_iterator iter = records.begin(); iter != records.end(); iter++)
+      {
+        if (OSS::string_ends_with(iter->key, PERSISTENT_STORE_EXPIRES_SUFFIX))
+          legacy.push_back(*iter);
+      }
+
+      if (!legacy.empty())
+      {
+        KVOperations operations;
+        OSS::mutex_critic_sec_lock lock(_writeMutex);
+        std::size_t folded = fold_legacy(legacy, OSS::getTime(), operations);
+        if (!operations.empty() && _impl.write(operations))
+          reclaimed += folded;
+      }
+
+      if (records.size() < batchSize)
+        break;
+      startKey = records.back().key + '\0';
+    }
+    return reclaimed;
+  }
+
+  void startSweeper(unsigned int intervalMs, std::size_t batchSize)
+    /// Start the background thread that calls sweepExpired(batchSize)
+    /// every intervalMs milliseconds
+  {
+    if (_pSweeperThread)
+      return;
+    _sweeperInterval = intervalMs;
+    _sweeperBatchSize = batchSize;
+    _isSweeperTerminating = false;
+    _pSweeperThread = new boost::thread(boost::bind(&KeyValueStoreBase<KV>::runSweeperThread, this));
+  }
+
+  void stopSweeper()
+  {
+    if (!_pSweeperThread)
+      return;
+    _isSweeperTerminating = true;
+    _sweeperSignal.set();
+    _pSweeperThread->join();
+    delete _pSweeperThread;
+    _pSweeperThread = 0;
   }
   
   std::string getPath() const
@@ -213,30 +528,101 @@ public:
 protected:
   bool is_expired(const std::string& key)
   {
-    std::string expireKey = key + PERSISTENT_STORE_EXPIRES_SUFFIX;
+    std::string stored;
+    if (!_impl.get(key, stored))
+      return false;
+    return kv_is_expired(kv_decode_expires(stored), OSS::getTime());
+  }
 
-    std::string expires;
-    if (!get(expireKey, expires, false))
+  bool purge_expired(const std::string& key)
+  {
+    OSS::mutex_critic_sec_lock lock(_writeMutex);
+    if (!is_expired(key))
       return false;
+    return _impl.del(key);
+  }
 
-    OSS::UInt64 expireTime = OSS::string_to_number<OSS::UInt64>(expires);
+  void decode_records(KVRecords& records)
+  {
+    OSS::UInt64 now = OSS::getTime();
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < records.size(); i++)
+    {
+      if (OSS::string_ends_with(records[i].key, PERSISTENT_STORE_EXPIRES_SUFFIX))
+        continue;
+      std::string value;
+      if (kv_is_expired(kv_decode_value(records[i].value, value), now))
+        continue;
+      records[count].key.swap(records[i].key);
+      records[count].value.swap(value);
+      ++count;
+    }
+    records.resize(count);
+  }
 
-    return expireTime <= OSS::getTime();
+  std::size_t fold_legacy(const KVRecords& legacy, OSS::UInt64 now, KVOperations& operations)
+    /// Append the operations that move the expiry of each legacy expires
+    /// record into its value.  The caller holds the write lock.  Returns
+    /// the number of expired records deleted.
+  {
+    std::size_t reclaimed = 0;
+    for (KVRecords::const_iterator iter = legacy.begin(); iter != legacy.end(); iter++)
+    {
+      std::string key = iter->key.substr(0, iter->key.size() - (sizeof(PERSISTENT_STORE_EXPIRES_SUFFIX) - 1));
+      OSS::UInt64 expiresAt = OSS::string_to_number<OSS::UInt64>(iter->value.c_str());
+      std::string stored;
+      bool exists = _impl.get(key, stored);
+      append_delete(operations, iter->key);
+      if (!exists || kv_has_ttl_header(stored))
+        continue;
+      if (kv_is_expired(expiresAt, now))
+      {
+        append_delete(operations, key);
+        ++reclaimed;
+      }
+      else
+      {
+        operations.push_back(KVOperation());
+        operations.back().type = KVOperation::Put;
+        operations.back().key = key;
+        operations.back().expireInSeconds = 0;
+        kv_encode_value(stored, expiresAt, operations.back().value);
+      }
+    }
+    return reclaimed;
   }
 
-  bool purge_expired(const std::string& key)
+  static void append_delete(KVOperations& operations, const std::string& key)
   {
-    std::string expireKey = key + PERSISTENT_STORE_EXPIRES_SUFFIX;
-    if (!del(key))
-      return false;
-    return del(expireKey);
+    operations.push_back(KVOperation());
+    operations.back().type = KVOperation::Del;
+    operations.back().key = key;
+    operations.back().expireInSeconds = 0;
+  }
+
+  void runSweeperThread()
+  {
+    while (!_isSweeperTerminating)
+    {
+      _sweeperSignal.tryWait(_sweeperInterval);
+      if (!_isSweeperTerminating)
+        sweepExpired(_sweeperBatchSize);
+    }
   }
   
   KV _impl;  
   KVInputProcessors _inputProc;
+  OSS::mutex_critic_sec _writeMutex;
+  OSS::mutex_critic_sec _sweeperMutex;
+  std::string _sweeperCursor;
+  boost::thread* _pSweeperThread;
+  OSS::semaphore _sweeperSignal;
+  unsigned int _sweeperInterval;
+  std::size_t _sweeperBatchSize;
+  bool _isSweeperTerminating;
 };
 
 
 } } // OSS::Persistent
 
-#endif
\ No newline at end of file
+#endif
@@ -142,6 +142,10 @@ public:
   bool del(const std::string& key);
 
   bool hdel(const std::string& key, const std::string& field);
+
+  bool pipeline(const std::vector< std::vector<std::string> >& commands);
+    /// Send all commands in one write and read back all replies.  Returns
+    /// false if the connection failed or any command returned an error.
   
   bool publish(const std::string& channel, const std::string& eventData);
   
@@ -177,6 +181,10 @@ public:
   bool getKeys(const std::string& pattern, std::vector<std::string>& keys);
 
   bool del(const std::string& key);
+
+  bool hgetall(const std::string& key, std::vector<std::string>& value) const;
+
+  bool pipeline(const std::vector< std::vector<std::string> >& commands);
   
   RedisClient* defaultClient();
   
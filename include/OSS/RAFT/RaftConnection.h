@@ -25,6 +25,7 @@
 #include "OSS/OSS.h"
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include "OSS/RAFT/RaftLogStore.h"
 
 extern "C"
 {
@@ -50,6 +51,10 @@ public:
   virtual int onSendAppendEntries(msg_appendentries_t& data) = 0;
   virtual int onSendRequestVoteResponse(msg_requestvote_response_t& data) = 0;
   virtual int onSendAppendEntriesResponse(msg_appendentries_response_t& data) = 0;
+  virtual int onSendSnapshot(RaftSnapshot& snapshot);
+    /// Send a snapshot to a peer that is behind the compacted log.
+    /// The peer answers with an append entries response.  The default
+    /// implementation does not support snapshot transfer and returns -1.
 
   RaftNode& getNode();
   const RaftNode& getNode() const;
@@ -25,7 +25,10 @@
 #include "OSS/UTL/Thread.h"
 #include "OSS/RAFT/RaftNode.h"
 #include "OSS/RAFT/RaftConnection.h"
+#include "OSS/RAFT/RaftLogStore.h"
 #include <map>
+#include <list>
+#include <vector>
 
 
 namespace OSS {
@@ -34,6 +37,9 @@ namespace RAFT {
   
 #define RAFT_ELECTION_TIMEOUT_MS 2000;
 #define RAFT_PERIODIC_TIMER_MS 1000;
+#define RAFT_MAX_ENTRIES_PER_APPEND 64
+#define RAFT_MAX_INFLIGHT_APPENDS 8
+#define RAFT_SNAPSHOT_THRESHOLD 0
   
   
 class RaftConsensus : public OSS::Thread
@@ -53,12 +59,41 @@ public:
       election_timeout_ms = RAFT_ELECTION_TIMEOUT_MS;
       periodic_timer_ms = RAFT_PERIODIC_TIMER_MS;
       is_master = false;
+      max_entries_per_append = RAFT_MAX_ENTRIES_PER_APPEND;
+      max_inflight_appends = RAFT_MAX_INFLIGHT_APPENDS;
+      snapshot_threshold = RAFT_SNAPSHOT_THRESHOLD;
     }
     int node_id;
     int election_timeout_ms;
     int periodic_timer_ms;
     bool is_master;
+    std::string log_store_path;
+      /// Directory of the durable log.  The log is kept in memory only if empty.
+    int max_entries_per_append;
+      /// Maximum number of entries carried by a single append entries message
+    int max_inflight_appends;
+      /// Maximum number of unacknowledged append entries messages per peer
+    int snapshot_threshold;
+      /// Number of applied entries after which a snapshot is taken and the
+      /// log compacted.  Zero disables automatic snapshots.
   };
+
+  struct Peer
+    /// Replication pipeline state of a single peer
+  {
+    Peer() :
+      next_send_idx(0),
+      inflight(0)
+    {
+    }
+    int next_send_idx;
+      /// Index of the next entry to send.  Runs ahead of the peer next index
+      /// while append entries messages are in flight.
+    int inflight;
+      /// Number of append entries messages not yet acknowledged
+  };
+
+  typedef std::map<int, Peer> Peers;
     
   RaftConsensus();
   virtual ~RaftConsensus();
@@ -72,6 +107,27 @@ public:
   bool addNoneVotingNode(int node_id);
   void removeNode(int node_id);
   bool findNode(int node_id, Node& node);
+
+  //
+  // Replication
+  //
+  bool submit(const std::string& data);
+    /// Append an entry to the replicated log.  Returns false if this node
+    /// is not the leader.
+
+  bool submit(const std::vector<std::string>& batch);
+    /// Append several entries to the replicated log.  The entries are
+    /// written to the durable log in one transaction and shipped to the
+    /// peers together.  Returns false if this node is not the leader.
+
+  bool takeSnapshot();
+    /// Snapshot the finite state machine and compact the log.  Returns
+    /// false if there is nothing new to snapshot or onCreateSnapshot() fails.
+
+  bool isLeader();
+  int getCommitIndex();
+  int getLastAppliedIndex();
+  int getCurrentIndex();
   
   //
   // RAFT Protocol Handlers.  All returns zero when successful
@@ -82,13 +138,27 @@ public:
   virtual int onReceivedAppendEntries(const Connection::Ptr& pConnection, msg_appendentries_t& data);
   virtual int onReceivedRequestVoteResponse(const Connection::Ptr& pConnection, msg_requestvote_response_t& data);
   virtual int onReceivedAppendEntriesResponse(const Connection::Ptr& pConnection, msg_appendentries_response_t& data);
+  virtual int onReceivedSnapshot(const Connection::Ptr& pConnection, RaftSnapshot& snapshot);
   
   
   virtual int onApplyEntry(const raft_entry_t& entry);
   virtual int onAppendEntry(const raft_entry_t& entry, int index);
+  virtual int onPopEntry(const raft_entry_t& entry, int index);
+  virtual int onPollEntry(const raft_entry_t& entry, int index);
   virtual int onPersistVote(int vote);
   virtual int onPersistTerm(int vote);
   virtual void onSufficientLogs(Node& node);
+  virtual bool onCreateSnapshot(std::string& data);
+    /// Serialize the finite state machine as of the last applied entry.
+    /// The default implementation returns false which disables compaction.
+  virtual bool onRestoreSnapshot(const std::string& data);
+    /// Replace the finite state machine with the content of a snapshot
+
+  //
+  // Called by the raft callbacks with the raft mutex held
+  //
+  int queueRequestVote(Node& node, msg_requestvote_t& data);
+  int queueAppendEntries(Node& node);
 
   //
   // Connection related handlers
@@ -104,6 +174,14 @@ protected:
   void callPeriodicTimer();
   void becomeMaster();
 
+  void dispatchOutbound();
+  bool hasOutbound();
+  void applyCommitted();
+  bool createSnapshot();
+  void compactLog();
+  bool restoreState();
+  void freeEntries();
+
   Connection::Ptr findConnection(const Node& node);
   Connection::Ptr findConnection(int id);
   Connection::Ptr findOrCreateConnection(Node& node);
@@ -111,13 +189,43 @@ protected:
   void removeConnection(int id);
 
 private:
+  enum OutboundType
+  {
+    OUTBOUND_REQUEST_VOTE,
+    OUTBOUND_APPEND_ENTRIES,
+    OUTBOUND_SNAPSHOT
+  };
+
+  struct Outbound
+    /// A message built under the raft mutex and sent after it is released
+  {
+    int type;
+    Node node;
+    Connection::Ptr pConnection;
+    msg_requestvote_t requestVote;
+    msg_appendentries_t appendEntries;
+    std::vector<msg_entry_t> entries;
+    std::vector<std::string> payloads;
+    RaftSnapshot snapshot;
+  };
+
+  typedef std::list<Outbound> OutboundQueue;
+
   OSS::mutex _raftMutex;
   OSS::mutex_critic_sec _connectionMutex;
+  OSS::mutex_critic_sec _dispatchMutex;
   OSS::semaphore _sem;
   raft_server_t* _raft;
   Options _opt;
   Connections _connections;
   Nodes _nodes;
+  Peers _peers;
+  OutboundQueue _outbound;
+  RaftLogStore _logStore;
+  RaftSnapshot _snapshot;
+  unsigned int _lastEntryId;
+  bool _suppressAppends;
+  bool _ackInProgress;
 };
 
 
@@ -0,0 +1,161 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_RAFTLOGSTORE_H_INCLUDED
+#define OSS_RAFTLOGSTORE_H_INCLUDED
+
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/LMDB/LMDatabase.h"
+#include <boost/noncopyable.hpp>
+#include <vector>
+#include <string>
+
+extern "C"
+{
+  #include "OSS/RAFT/libraft.h"
+};
+
+
+namespace OSS {
+namespace RAFT {
+
+
+struct RaftSnapshot
+{
+  RaftSnapshot() :
+    term(0),
+    last_idx(0),
+    last_term(0)
+  {
+  }
+
+  int term;
+    /// Current term of the node that sent the snapshot
+  int last_idx;
+    /// Index of the last log entry covered by the snapshot
+  int last_term;
+    /// Term of the last log entry covered by the snapshot
+  std::string data;
+    /// Serialized state of the finite state machine
+};
+
+
+class RaftLogStore : boost::noncopyable
+  /// Durable storage for the raft log, term, vote and snapshot.
+  ///
+  /// Entries are kept in an LMDB database keyed by their zero padded index
+  /// so a cursor walk returns them in log order.  Every write is flushed
+  /// to disk when its transaction commits.  Writes issued between
+  /// beginBatch() and endBatch() share a single transaction so a batch of
+  /// entries costs one sync instead of one per entry.
+{
+public:
+  struct Entry
+  {
+    Entry() :
+      index(0),
+      term(0),
+      id(0),
+      type(RAFT_LOGTYPE_NORMAL)
+    {
+    }
+    int index;
+    unsigned int term;
+    unsigned int id;
+    int type;
+    std::string data;
+  };
+
+  typedef std::vector<Entry> Entries;
+
+  RaftLogStore();
+  ~RaftLogStore();
+
+  bool open(const std::string& path);
+    /// Open or create the log database in the specified directory
+
+  void close();
+    /// Close the database.  Pending batch writes are committed first.
+
+  bool isOpen() const;
+    /// Returns true if the database is open
+
+  bool beginBatch();
+    /// Group every write until the matching endBatch() in one transaction.
+    /// Batches may nest.  Only the outermost endBatch() commits.
+
+  bool endBatch();
+    /// Commit the batch.  Returns false if any write in the batch failed
+    /// in which case none of them are stored.
+
+  bool appendEntry(int index, const raft_entry_t& entry);
+    /// Store an entry at the specified log index
+
+  bool removeEntry(int index);
+    /// Remove the entry at the specified log index
+
+  bool setTerm(int term);
+    /// Store the current term
+
+  bool setVote(int vote);
+    /// Store the node voted for in the current term
+
+  bool saveSnapshot(const RaftSnapshot& snapshot);
+    /// Store the snapshot and drop every entry it covers
+
+  bool loadSnapshot(RaftSnapshot& snapshot);
+    /// Load the last stored snapshot.  Returns false if there is none.
+
+  bool load(int& term, int& vote, RaftSnapshot& snapshot, Entries& entries);
+    /// Load the complete persistent state.  Entries start right after
+    /// the snapshot and stop at the first gap in the log.
+
+  static std::string entryKey(int index);
+    /// Returns the database key of the entry at the specified index
+
+private:
+  bool write(const std::string& key, const std::string& value);
+  bool erase(const std::string& key);
+  bool compact(LMDB::LMDatabase::Transaction& transaction, int lastIndex);
+
+  OSS::mutex _mutex;
+  LMDB::LMDatabase* _pDb;
+  LMDB::LMDatabase::Transaction* _pBatch;
+  int _batchDepth;
+  bool _batchFailed;
+};
+
+
+//
+// Inlines
+//
+
+inline bool RaftLogStore::isOpen() const
+{
+  return _pDb != 0;
+}
+
+
+} } // OSS::RAFT
+
+
+#endif // OSS_RAFTLOGSTORE_H_INCLUDED
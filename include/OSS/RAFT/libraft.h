@@ -682,6 +682,26 @@ int raft_entry_is_voting_cfg_change(raft_entry_t* ety);
  * @return 1 if this is a configuration change. */
 int raft_entry_is_cfg_change(raft_entry_t* ety);
 
+/** Remove the oldest entry from the log.
+ * Only entries that have been applied to the FSM can be removed. This is
+ * used to compact the log once a snapshot covers the entry.
+ * @return 0 on success; -1 if the log is empty or the entry is not applied */
+int raft_poll_entry(raft_server_t* me);
+
+/** @return index of the newest entry removed by compaction; 0 if none */
+int raft_get_log_base_idx(raft_server_t* me);
+
+/** Get the term of an entry, including the newest compacted entry.
+ * @return the term; -1 if the entry is unknown */
+int raft_get_log_term_at_idx(raft_server_t* me, int idx);
+
+/** Discard the log and continue from a snapshot.
+ * The snapshot covers every entry up to and including last_idx. The commit
+ * and last applied indexes are moved forward to last_idx.
+ * @param[in] last_idx Index of the last entry included in the snapshot
+ * @param[in] last_term Term of the last entry included in the snapshot */
+void raft_load_snapshot(raft_server_t* me, int last_idx, int last_term);
+
 #endif /* RAFT_H_ */
 #ifndef RAFT_LOG_H_
 #define RAFT_LOG_H_
@@ -730,6 +750,14 @@ void log_delete(log_t* me_, int idx);
 
 int log_get_current_idx(log_t* me_);
 
+/**
+ * @return index of the newest entry removed by log_poll */
+int log_get_base(log_t* me_);
+
+/**
+ * Restart an empty log so that the next entry appended gets index base + 1 */
+void log_set_base(log_t* me_, int base);
+
 #endif /* RAFT_LOG_H_ */
 
 #ifndef RAFT_PRIVATE_H_
@@ -792,6 +820,9 @@ typedef struct {
 
     /* the log which has a voting cfg change, otherwise -1 */
     int voting_cfg_change_log_idx;
+
+    /* term of the newest entry removed from the log by compaction */
+    int log_base_term;
 } raft_server_private_t;
 
 void raft_election_start(raft_server_t* me);
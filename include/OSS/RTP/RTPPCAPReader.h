@@ -35,6 +35,7 @@
 #include <string>
 #include <boost/noncopyable.hpp>
 #include "OSS/RTP/RTPPacket.h"
+#include "OSS/Net/IPAddress.h"
 
 
 namespace OSS {
@@ -44,12 +45,35 @@ namespace RTP {
 class RTPPCAPReader : boost::noncopyable
 {
 public:
+  struct Datagram
+  {
+    OSS::UInt64 timestamp;
+      /// Capture time in microseconds
+    OSS::Net::IPAddress source;
+    OSS::Net::IPAddress destination;
+    std::string payload;
+  };
+
   RTPPCAPReader();
   RTPPCAPReader(const std::string& filename);
+  ~RTPPCAPReader();
   bool open(const std::string& filename);
+  void close();
   bool read(RTPPacket& packet);
+
+  bool readDatagram(Datagram& datagram);
+    /// Reads the next UDP datagram of the capture.  Frames that do not
+    /// carry a complete unfragmented UDP datagram over IPv4 or IPv6 are
+    /// skipped.  Returns false at the end of the capture.
+
+  static bool decodeDatagram(int linkType, const u_char* pData, std::size_t len, Datagram& datagram);
+    /// Extracts the UDP datagram from a captured frame.  Supported link
+    /// types are Ethernet with optional VLAN tags, Linux cooked capture,
+    /// raw IP and BSD loopback.  The timestamp is left untouched.
+
 private:
   pcap_t* _pCap;
+  int _linkType;
 };
 
 //
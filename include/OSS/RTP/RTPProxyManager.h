@@ -30,6 +30,7 @@
 #include "OSS/UTL/Thread.h"
 #include "OSS/RTP/RTPProxySession.h"
 #include "OSS/RTP/RTPProxyRecord.h"
+#include "OSS/RTP/RTPProxyStateJournal.h"
 #include "OSS/RTP/RTPProxy.h"
 #include "OSS/Persistent/RedisClient.h"
 
@@ -177,6 +178,9 @@ public:
     /// Connect to redis database for state persistence
 #endif
   
+  RTPProxyStateJournal& stateJournal();
+    /// return the write-behind journal used to persist session state
+
   bool hasRtpDb() const;
 
     /// returns true if redis client is connected to the rtp proxy db
@@ -229,6 +233,7 @@ private:
   mutable OSS::mutex_critic_sec _sessionCounterMutex;
   mutable RTPProxyCounter _sessionCounter;
   bool _persistStateFiles;
+  RTPProxyStateJournal _stateJournal;
   bool _enabled;
   bool _alwaysProxyMedia;
   bool _enableHairpins;
@@ -249,6 +254,11 @@ inline Persistent::RedisBroadcastClient& RTPProxyManager::redisClient()
 }
 #endif
 
+inline RTPProxyStateJournal& RTPProxyManager::stateJournal()
+{
+  return _stateJournal;
+}
+
 inline bool RTPProxyManager::hasRtpDb() const
 {
   return _hasRtpDb;
@@ -296,6 +306,7 @@ inline void RTPProxyManager::setStateDirectory(const boost::filesystem::path& st
 {
   _rtpStateDirectory = stateDirectory;
   _persistStateFiles = true;
+  _stateJournal.open(stateDirectory);
 }
 
 inline OSS::mutex_critic_sec& RTPProxyManager::sessionListMutex()
@@ -24,6 +24,9 @@
 #if ENABLE_FEATURE_RTP
 
 #include "OSS/Persistent/RedisClient.h"
+#include "OSS/JSON/reader.h"
+#include "OSS/JSON/writer.h"
+#include "OSS/JSON/elements.h"
 #include <boost/filesystem.hpp>
 
 namespace OSS {
@@ -56,6 +59,19 @@ struct SBCMediaTuple
 struct RTPProxyRecord
 {
   RTPProxyRecord();
+
+  void toJson(json::Object& params) const;
+    /// Serialize the record to a json object
+
+  bool fromJson(json::Object& params);
+    /// Deserialize the record from a json object
+
+  bool toString(std::string& buff) const;
+    /// Serialize the record to a json string
+
+  bool fromString(const std::string& buff);
+    /// Deserialize the record from a json string
+
 #if ENABLE_FEATURE_REDIS
   bool writeToRedis(Persistent::RedisBroadcastClient& client, const std::string& key) const;
   bool writeToRedis(Persistent::RedisBroadcastClient& client, const boost::filesystem::path& key) const;
@@ -25,6 +25,7 @@
 
 #include "OSS/UTL/Thread.h"
 #include "OSS/RTP/RTPProxyTuple.h"
+#include "OSS/RTP/RTPProxyRecord.h"
 
 
 namespace OSS {
@@ -117,17 +118,18 @@ public:
     /// True if verbose logging is set by the application.
     /// Use this only to debug the rtp stream and not for production
     /// environment.
-#if ENABLE_FEATURE_CONFIG
-  void dumpStateFile();
-    /// This method will save session information to a state-file to allow the
-    /// manager to reconstruct during retarts
-#endif
-  
-#if ENABLE_FEATURE_REDIS
-  void dumpStateToRedis();
-    /// This method will save session information to a redis to allow the
-    /// manager to reconstruct during retarts
-#endif
+  void captureState(RTPProxyRecord& record);
+    /// Copy the persistent session state into the record
+
+  void persistState();
+    /// Queue the session state in the manager's write-behind state journal
+    /// to allow the manager to reconstruct during restarts.  The state is
+    /// written to the state directory or redis by the journal thread.
+
+  static RTPProxySession::Ptr reconstructFromRecord(RTPProxyManager* pManager,
+    const RTPProxyRecord& record);
+    /// Reconstruct session-state from a record loaded from the state journal.
+    /// Will return a null pointer if the session can't be reconstructed
 
 #if ENABLE_FEATURE_CONFIG
   static RTPProxySession::Ptr reconstructFromStateFile(RTPProxyManager* pManager,
@@ -0,0 +1,193 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef RTP_RTPProxyStateJournal_INCLUDED
+#define RTP_RTPProxyStateJournal_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_RTP
+
+#include <fstream>
+#include <map>
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include "OSS/UTL/Thread.h"
+#include "OSS/RTP/RTPProxyRecord.h"
+
+
+namespace OSS {
+namespace RTP {
+
+
+class OSS_API RTPProxyStateJournal : private boost::noncopyable
+  /// Write-behind journal for RTP session state.
+  ///
+  /// Sessions hand their state to update() and remove() which only record the
+  /// change in memory.  Changes to the same session are coalesced so only the
+  /// latest state is ever written.  A background thread flushes pending
+  /// changes in batches either every flush interval or as soon as the number
+  /// of pending sessions reaches the batch size.  Flushes are serialized so
+  /// changes to a single session reach the backend in the order they were made.
+  ///
+  /// The file backend appends each batch to a single journal file in the state
+  /// directory with one line per change:
+  ///
+  ///   S <json-record>
+  ///   D <session-id>
+  ///
+  /// The journal is compacted into a snapshot of live sessions whenever the
+  /// number of journal lines grows well beyond the number of live sessions.
+  ///
+  /// The redis backend stores all sessions as fields of a single hash and
+  /// writes each batch as one pipelined HMSET/HDEL round trip.
+{
+public:
+  typedef std::map<std::string, RTPProxyRecord> Records;
+
+  enum Backend
+  {
+    BACKEND_NONE,
+    BACKEND_FILE,
+    BACKEND_REDIS
+  };
+
+  static const char* JOURNAL_FILE_NAME;
+    /// Name of the journal file inside the state directory
+
+  static const char* REDIS_HASH_KEY;
+    /// Redis hash holding the session records
+
+  RTPProxyStateJournal();
+    /// Creates a journal without a backend.  Updates are ignored until
+    /// a backend is opened.
+
+  ~RTPProxyStateJournal();
+    /// Flushes pending changes and stops the background thread
+
+  bool open(const boost::filesystem::path& stateDirectory);
+    /// Use the journal file in the state directory as backend and start
+    /// the background flush thread.
+
+#if ENABLE_FEATURE_REDIS
+  bool open(Persistent::RedisBroadcastClient* pRedisClient);
+    /// Use redis as backend and start the background flush thread.  Redis takes
+    /// precedence over a previously opened file backend.
+#endif
+
+  void close();
+    /// Flush pending changes, stop the background thread and close the backend
+
+  bool isOpen() const;
+    /// Returns true if a backend has been opened
+
+  Backend getBackend() const;
+    /// Return the active backend
+
+  void update(const RTPProxyRecord& record);
+    /// Queue the latest state of a session
+
+  void remove(const std::string& identifier);
+    /// Queue the removal of a session
+
+  void flush();
+    /// Write all pending changes to the backend now
+
+  bool load(Records& records);
+    /// Read all live session records from the backend.  The file backend is
+    /// compacted as part of loading.
+
+  void setFlushInterval(unsigned int milliseconds);
+    /// Maximum time a change stays in memory.  The default is 100 ms.
+
+  void setBatchSize(std::size_t batchSize);
+    /// Number of pending sessions that triggers an early flush.  The default is 256.
+
+  std::size_t getPendingCount() const;
+    /// Return the number of sessions waiting to be flushed
+
+private:
+  struct Change
+  {
+    bool isRemoved;
+    RTPProxyRecord record;
+  };
+
+  typedef boost::unordered_map<std::string, Change> Changes;
+  typedef boost::unordered_map<std::string, std::string> Snapshot;
+
+  void start();
+  void stop();
+  void runFlushThread();
+  void writeToFile(const Changes& changes);
+  void writeToRedis(const Changes& changes);
+  bool loadFromFile(Records& records);
+  bool loadFromRedis(Records& records);
+  bool compact();
+
+  Backend _backend;
+  mutable OSS::mutex_critic_sec _pendingMutex;
+  Changes _pending;
+  OSS::mutex_critic_sec _flushMutex;
+  OSS::semaphore _flushSignal;
+  boost::thread* _pFlushThread;
+  bool _isTerminating;
+  unsigned int _flushInterval;
+  std::size_t _batchSize;
+  boost::filesystem::path _journalFile;
+  std::ofstream _journal;
+  Snapshot _snapshot;
+  std::size_t _journalLines;
+#if ENABLE_FEATURE_REDIS
+  Persistent::RedisBroadcastClient* _pRedisClient;
+#endif
+};
+
+
+//
+// Inlines
+//
+
+inline bool RTPProxyStateJournal::isOpen() const
+{
+  return _backend != BACKEND_NONE;
+}
+
+inline RTPProxyStateJournal::Backend RTPProxyStateJournal::getBackend() const
+{
+  return _backend;
+}
+
+inline void RTPProxyStateJournal::setFlushInterval(unsigned int milliseconds)
+{
+  _flushInterval = milliseconds;
+}
+
+inline void RTPProxyStateJournal::setBatchSize(std::size_t batchSize)
+{
+  _batchSize = batchSize;
+}
+
+
+} } // OSS::RTP
+
+#endif // ENABLE_FEATURE_RTP
+#endif // RTP_RTPProxyStateJournal_INCLUDED
@@ -26,7 +26,7 @@
 #include <list>
 #include <boost/function.hpp>
 
-#include "OSS/UTL/Cache.h"
+#include "OSS/UTL/ExpireCache.h"
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Thread.h"
 #include "OSS/UTL/Logger.h"
@@ -85,6 +85,12 @@ struct SIPB2BDialogDataStoreCb
 class  SIPB2BDialogStateManager 
 {
 public:
+  typedef boost::shared_ptr<DialogList> DialogListPtr;
+  typedef OSS::ExpireCache<std::string, DialogListPtr> DialogCache;
+    /// Dialogs sharing a Call-ID keyed by Call-ID
+  typedef OSS::ExpireCache<std::string, SIPMessage::Ptr> RetransmitCache;
+    /// 2xx responses to INVITE keyed by dialog-id and CSeq
+
   SIPB2BDialogStateManager(
     SIPB2BTransactionManager* pTransactionManager,
     int cacheLifeTime = 3600*24);
@@ -184,7 +190,7 @@ public:
   void onRouteAckRequest(
     const SIPMessage::Ptr& pMsg,
     const OSS::SIP::SIPTransportSession::Ptr& pTransport,
-    OSS::CacheManager& retransmitCache,
+    RetransmitCache& retransmitCache,
     std::string& sessionId,
     std::string& peerXOR,
     OSS::Net::IPAddress& routeLocalInterface,
@@ -195,7 +201,7 @@ protected:
   SIPB2BDialogDataStoreCb _dataStore;
   mutable OSS::mutex_critic_sec _csDialogsMutex;
   int _cacheLifeTime;
-  CacheManager _dialogs;
+  DialogCache _dialogs;
   OSS::semaphore _exitSync;
   boost::thread* _pThread;
   
@@ -0,0 +1,194 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SIPB2BKEEPALIVESCHEDULER_H_INCLUDED
+#define SIPB2BKEEPALIVESCHEDULER_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "OSS/OSS.h"
+#include "OSS/Net/IPAddress.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/TimerWheel.h"
+#include "OSS/SIP/SIPMessage.h"
+#include "OSS/SIP/B2BUA/SIPB2BDialogData.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+class OSS_API SIPB2BOptionsTemplate
+  /// Pre-serialized OPTIONS keep-alive request for a single binding.
+  ///
+  /// Everything that does not change between keep-alives (request line,
+  /// To, From, Via sent-by, Contact and Content-Length) is formatted once
+  /// when the binding is registered.  Rendering a request only appends the
+  /// From tag, Via branch, Call-ID and CSeq into a reserved buffer.
+  ///
+  /// The compiled request is also parsed once.  createRequest() copies that
+  /// message, which shares its header storage, and replaces the four
+  /// headers that change so a keep-alive is never parsed again.
+{
+public:
+  SIPB2BOptionsTemplate();
+
+  void compile(const RegData& regData,
+    const std::string& transportScheme,
+    const std::string& sentBy);
+    /// Format the static parts of the request.  transportScheme is the
+    /// upper case Via transport and sentBy is the host:port advertised in
+    /// Via and Contact.
+
+  void render(const std::string& token, OSS::UInt64 sequence, std::string& packet) const;
+    /// Render a complete request into packet.  The token and sequence
+    /// number are combined to form a unique tag, branch and Call-ID.
+    /// The sequence number is also used as the CSeq number.
+
+  SIPMessage::Ptr createRequest(const std::string& token, OSS::UInt64 sequence) const;
+    /// Return the same request as render() as a message ready to send
+
+  bool isCompiled() const;
+    /// Returns true if compile() has been called
+
+private:
+  std::string _head;
+  std::string _via;
+  std::string _tail;
+  std::string _fromPrefix;
+  std::string _viaPrefix;
+  SIPMessage::Ptr _prototype;
+};
+
+
+struct SIPB2BKeepAliveBinding
+  /// Everything needed to send a keep-alive to a registered contact without
+  /// going back to the registration store.
+{
+  RegData registration;
+  OSS::Net::IPAddress localInterface;
+  OSS::Net::IPAddress target;
+  std::string transportScheme;
+  SIPB2BOptionsTemplate options;
+};
+
+
+class OSS_API SIPB2BKeepAliveScheduler : private boost::noncopyable
+  /// Schedules OPTIONS keep-alives for registered contacts.
+  ///
+  /// Bindings are placed in a hashed timer wheel keyed by their next due
+  /// time.  A new binding is given a phase derived from the hash of its
+  /// registration key so that keep-alives are spread evenly over the
+  /// interval instead of being sent in bursts.  Each call to collectDue()
+  /// only visits the slots that elapsed since the previous call.
+  ///
+  /// Removal is lazy.  unschedule() drops the binding from the index and
+  /// its stale timer is discarded when the wheel reaches it.
+{
+public:
+  typedef boost::shared_ptr<SIPB2BKeepAliveBinding> BindingPtr;
+  typedef std::vector<BindingPtr> BindingList;
+
+  SIPB2BKeepAliveScheduler(unsigned int interval = 60000, unsigned int resolution = 1000);
+    /// Creates a scheduler that visits every binding once per interval.
+    /// Both values are in milliseconds.
+
+  void schedule(const BindingPtr& binding, OSS::UInt64 now);
+    /// Add or refresh a binding.  A refreshed binding keeps its place in
+    /// the wheel.  The binding is dropped once now exceeds its registration
+    /// expires.  A registration with expires of zero never lapses.
+
+  bool unschedule(const std::string& key);
+    /// Remove the binding with the given registration key
+
+  BindingPtr find(const std::string& key) const;
+    /// Return the binding with the given registration key or null
+
+  void collectDue(OSS::UInt64 now, BindingList& due);
+    /// Advance the wheel up to now and append every binding that is due to
+    /// the list.  Due bindings are re-armed for the next interval.
+
+  std::size_t size() const;
+    /// Return the number of scheduled bindings
+
+  unsigned int getInterval() const;
+    /// Return the keep-alive interval in milliseconds
+
+  unsigned int getResolution() const;
+    /// Return the wheel resolution in milliseconds
+
+private:
+  struct Entry
+  {
+    BindingPtr binding;
+    OSS::UInt64 generation;
+    OSS::UInt64 expiresAt;
+  };
+
+  struct TimerKey
+  {
+    std::string key;
+    OSS::UInt64 generation;
+  };
+
+  typedef boost::unordered_map<std::string, Entry> Bindings;
+  typedef OSS::TimerWheel<TimerKey> Wheel;
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Bindings _bindings;
+  Wheel _wheel;
+  OSS::UInt64 _generation;
+  unsigned int _interval;
+  unsigned int _resolution;
+};
+
+
+//
+// Inlines
+//
+
+inline bool SIPB2BOptionsTemplate::isCompiled() const
+{
+  return !_head.empty();
+}
+
+inline unsigned int SIPB2BKeepAliveScheduler::getInterval() const
+{
+  return _interval;
+}
+
+inline unsigned int SIPB2BKeepAliveScheduler::getResolution() const
+{
+  return _resolution;
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+#endif // ENABLE_FEATURE_B2BUA
+#endif // SIPB2BKEEPALIVESCHEDULER_H_INCLUDED
@@ -0,0 +1,156 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_SIPB2BREQUESTPIPELINE_H_INCLUDED
+#define	OSS_SIPB2BREQUESTPIPELINE_H_INCLUDED
+
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/LatencyHistogram.h"
+#include "OSS/SIP/SIPMessage.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+class SIPB2BTransaction;
+
+class OSS_API SIPB2BRequestPipeline : boost::noncopyable
+  /// Stages a new B2B transaction passes through before its request is
+  /// forwarded.  Each stage runs a chain of handlers ordered by priority.
+  /// The processing of the transaction manager itself is registered in
+  /// every stage with BUILTIN_PRIORITY.  Handlers with a lower priority run
+  /// before it and handlers with a higher priority run after it.
+  ///
+  /// A handler that has to wait for I/O returns Suspend and calls the
+  /// resume function once the result is in.  No thread is held by the
+  /// transaction in between.  The chain continues on the transaction
+  /// manager thread pool.
+  ///
+  /// Chains are published as immutable snapshots.  A transaction takes the
+  /// pipeline mutex just long enough to copy the pointer to the current
+  /// snapshot and walks it after the lock is released, so any number of
+  /// requests evaluate the same chain in parallel and handlers may be added
+  /// while requests are in flight.
+{
+public:
+  enum Stage
+  {
+    StageCreated,
+    StageAuthenticate,
+    StageRoute,
+    StageOutbound,
+    StageMax
+  };
+
+  enum Result
+  {
+    Continue,
+      /// Run the next handler
+    Respond,
+      /// Send the response and end the transaction
+    Suspend,
+      /// Wait until the resume function is called
+    Stop
+      /// End the transaction without sending anything
+  };
+
+  enum
+  {
+    BUILTIN_PRIORITY = 100
+  };
+
+  typedef boost::shared_ptr<SIPB2BTransaction> TransactionPtr;
+
+  typedef boost::function<void(Result, const SIPMessage::Ptr&)> Resume;
+    /// Continues a suspended transaction with the handler's result and
+    /// response.  It must be called exactly once and only after the handler
+    /// returned Suspend.  Any thread may call it.
+
+  typedef boost::function<Result(const TransactionPtr&, SIPMessage::Ptr&, const Resume&)> Handler;
+    /// Handlers receive the transaction, a response to fill in when they
+    /// return Respond and the resume function for when they return Suspend.
+
+  struct Entry
+  {
+    std::string name;
+    std::size_t priority;
+    Handler handler;
+    bool operator < (const Entry& entry) const;
+  };
+
+  typedef std::vector<Entry> Handlers;
+  typedef boost::shared_ptr<const Handlers> HandlersPtr;
+
+  SIPB2BRequestPipeline();
+
+  ~SIPB2BRequestPipeline();
+
+  void addHandler(Stage stage, const std::string& name, std::size_t priority, const Handler& handler);
+    /// Handlers with equal priority run in the order they were added
+
+  bool removeHandler(Stage stage, const std::string& name);
+
+  HandlersPtr getHandlers(Stage stage) const;
+    /// Returns the current chain of a stage.  The snapshot stays valid and
+    /// unchanged while it is held.
+
+  void recordLatency(Stage stage, OSS::UInt64 micros);
+    /// Records the time a transaction spent in a stage including the time
+    /// it was suspended.  Stage latency is published in the metrics
+    /// registry as b2bua_stage_<name>_microseconds.
+
+  void getLatency(Stage stage, LatencyHistogram::Snapshot& snapshot) const;
+
+  static const char* stageName(Stage stage);
+
+private:
+  mutable OSS::mutex_critic_sec _mutex;
+  HandlersPtr _handlers[StageMax];
+  LatencyHistogram* _latency[StageMax];
+};
+
+//
+// Inlines
+//
+
+inline bool SIPB2BRequestPipeline::Entry::operator < (const Entry& entry) const
+{
+  return priority < entry.priority;
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+
+#endif // ENABLE_FEATURE_B2BUA
+
+#endif	/// OSS_SIPB2BREQUESTPIPELINE_H_INCLUDED
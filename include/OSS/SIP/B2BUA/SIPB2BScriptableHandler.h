@@ -24,7 +24,9 @@
 #if ENABLE_FEATURE_V8
 
 #include <map>
-#include "OSS/UTL/Cache.h"
+#include <boost/atomic.hpp>
+#include "OSS/UTL/ExpireCache.h"
+#include "OSS/UTL/LockFreeQueue.h"
 #include "OSS/SIP/SIPMessage.h"
 #include "OSS/SIP/SIPRequestLine.h"
 #include "OSS/SIP/SIPURI.h"
@@ -35,6 +37,7 @@
 #include "OSS/SIP/B2BUA/SIPB2BHandler.h"
 #include "OSS/SIP/B2BUA/SIPB2BContact.h"
 #include "OSS/SIP/B2BUA/SIPB2BDialogData.h"
+#include "OSS/SIP/B2BUA/SIPB2BKeepAliveScheduler.h"
 #include "OSS/RTP/RTPProxyManager.h"
 
 namespace OSS {
@@ -327,6 +330,12 @@ public:
   // REGISTER handlers
   //
   void sendOptionsKeepAlive(RegData& regData);
+  void sendOptionsKeepAlive(const SIPB2BKeepAliveScheduler::BindingPtr& binding);
+    /// Send an OPTIONS keep-alive rendered from the binding template
+
+  SIPB2BKeepAliveScheduler::BindingPtr createKeepAliveBinding(const RegData& regData);
+    /// Resolve the addresses of a registration and compile its OPTIONS template
+
   void handleOptionsResponse(
     const OSS::SIP::SIPTransaction::Error& e,
     const OSS::SIP::SIPMessage::Ptr& pMsg,
@@ -365,7 +374,7 @@ protected:
   //
   // INVITE related variables
   //
-  OSS::CacheManager _2xxRetransmitCache;
+  OSS::ExpireCache<std::string, SIPMessage::Ptr> _2xxRetransmitCache;
   OSS::mutex_read_write _rwInvitePoolMutex;
   std::map<std::string, SIPMessage::Ptr> _invitePool;
   //
@@ -373,13 +382,16 @@ protected:
   //
   boost::thread* _pOptionsThread;
   OSS::semaphore _optionsThreadExit;
-  OSS::BlockingQueue<std::string> _optionsResponseQueue;
+  OSS::LockFreeQueue<std::string> _optionsResponseQueue;
   boost::thread* _pOptionsResponseThread;
   OSS::semaphore _optionsResponseThreadExit;
   OSS::SIP::SIPTransaction::Callback _keepAliveResponseCb;
   OSS::mutex_read_write _rwKeepAliveListMutex;
   typedef std::map<OSS::Net::IPAddress, OSS::Net::IPAddress> KeepAliveList;
   KeepAliveList _keepAliveList;
+  SIPB2BKeepAliveScheduler _keepAliveScheduler;
+  std::string _keepAliveToken;
+  boost::atomic<OSS::UInt64> _keepAliveSequence;
   OSS::thread_pool _threadPool;
 #if ENABLE_FEATURE_RTP
   //
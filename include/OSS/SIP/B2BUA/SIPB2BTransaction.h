@@ -30,13 +30,16 @@
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "OSS/Net/DNS.h"
 #include "OSS/SIP/B2BUA/B2BUA.h"
 #include "OSS/SIP/SIPTransaction.h"
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/UTL/PropertyMap.h"
+#include "OSS/UTL/SlabAllocated.h"
 #include "OSS/SIP/B2BUA/SIPB2BDialogData.h"
+#include "OSS/SIP/B2BUA/SIPB2BRequestPipeline.h"
 
 
 namespace OSS {
@@ -67,8 +70,11 @@ OSS_CREATE_INLINE_EXCEPTION(B2BUAStateException, B2BUABaseException, "B2BUA Stat
 
 class SIPB2BTransactionManager;
 
-class OSS_API SIPB2BTransaction : private boost::noncopyable, public boost::enable_shared_from_this<SIPB2BTransaction>
+class OSS_API SIPB2BTransaction : private boost::noncopyable, public boost::enable_shared_from_this<SIPB2BTransaction>,
+  public OSS::SlabAllocated<SIPB2BTransaction>
   /// Base class for SIP Call implementation
+  ///
+  /// Transactions come from the b2bua_transaction slab pool
 {
 public:
   typedef boost::shared_ptr<SIPB2BTransaction> Ptr;
@@ -94,6 +100,10 @@ public:
     /// in the subsystem.  It is therefore safe to call blocking functions
     /// in this method.
     ///
+    /// The request is taken through the stages of the manager's request
+    /// pipeline.  A suspended stage returns the thread to the pool and the
+    /// rest of the pipeline runs on whichever thread resumes it.
+    ///
 
   virtual void runResponseTask();
     /// Execute the transaction tasks for handling responses
@@ -215,6 +225,25 @@ protected:
   void releaseInternalRef();
     /// release the internal reference and signal transaction destruction
 
+  void runPipeline(SIPB2BRequestPipeline::Result result, SIPMessage::Ptr response);
+    /// Runs pipeline handlers until one suspends or ends the transaction,
+    /// or every stage is done and the request is sent
+
+  void resumePipeline(SIPB2BRequestPipeline::Result result, const SIPMessage::Ptr& response);
+    /// Resume function handed to pipeline handlers
+
+  void endPipelineStage();
+
+  void sendServerResponse(const SIPMessage::Ptr& response);
+
+  void sendClientRequest();
+
+  SIPB2BRequestPipeline::Result onCreatedStage(SIPMessage::Ptr& response);
+  SIPB2BRequestPipeline::Result onAuthenticateStage(SIPMessage::Ptr& response);
+  SIPB2BRequestPipeline::Result onRouteStage(SIPMessage::Ptr& response);
+  SIPB2BRequestPipeline::Result onOutboundStage(SIPMessage::Ptr& response);
+    /// Built in handlers registered by the manager in each stage
+
   OSS::dns_srv_record_list _udpSrvTargets;
   OSS::dns_srv_record_list _tcpSrvTargets;
   OSS::dns_srv_record_list _wsSrvTargets;
@@ -223,6 +252,12 @@ protected:
   SIPB2BDialogData _dialogData;
   bool _isChallenged;
   std::string _pendingSubscriptionId;
+  OSS::Net::IPAddress _outboundTarget;
+  int _pipelineStage;
+  std::size_t _pipelineIndex;
+  SIPB2BRequestPipeline::HandlersPtr _pipelineHandlers;
+  boost::posix_time::ptime _pipelineStageStart;
+  OSS::UInt64 _createTime;
   friend class SIPB2BTransactionManager;
 };
 
@@ -324,6 +359,8 @@ inline const SIPB2BTransaction::CustomProperties& SIPB2BTransaction::properties(
   
 } } } // OSS::SIP::B2BUA
 
+OSS_SLAB_POOL_DECLARE(OSS::SIP::B2BUA::SIPB2BTransaction)
+
 #endif // ENABLE_FEATURE_B2BUA
 
 #endif
@@ -41,6 +41,7 @@
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
 #include "OSS/SIP/B2BUA/SIPB2BHandler.h"
 #include "OSS/SIP/B2BUA/SIPB2BUserAgentHandlerList.h"
+#include "OSS/SIP/B2BUA/SIPB2BRequestPipeline.h"
 
 
 namespace OSS {
@@ -245,6 +246,10 @@ public:
   OSS::thread_pool& threadPool();
     /// Returns a direct reference to the thread pool
 
+  SIPB2BRequestPipeline& requestPipeline();
+    /// Returns the stages new transactions pass through.  Applications add
+    /// their own stage handlers here.
+
   bool& useSourceAddressForResponses();
 
   MessageHandlers& handlers();
@@ -398,6 +403,7 @@ private:
   //
   SIPB2BUserAgentHandlerList _userAgentHandler;
   SIPB2BUserAgentHandlerLoader _pluginLoader;  
+  SIPB2BRequestPipeline _requestPipeline;
 };
 
 //
@@ -408,6 +414,11 @@ inline OSS::thread_pool& SIPB2BTransactionManager::threadPool()
   return _threadPool;
 }
 
+inline SIPB2BRequestPipeline& SIPB2BTransactionManager::requestPipeline()
+{
+  return _requestPipeline;
+}
+
 inline bool& SIPB2BTransactionManager::useSourceAddressForResponses()
 {
   return _useSourceAddressForResponses;
@@ -24,6 +24,8 @@
 #include "OSS/build.h"
 #if ENABLE_FEATURE_B2BUA
 
+#include <list>
+#include <boost/shared_ptr.hpp>
 #include "OSS/UTL/Thread.h"
 #include "OSS/SIP/B2BUA/SIPB2BUserAgentHandler.h"
 #include "OSS/UTL/DynamicHashTable.h"
@@ -34,6 +36,9 @@ namespace B2BUA {
 
 
 class SIPB2BUserAgentHandlerList : boost::noncopyable
+  /// Handlers are kept in an immutable list that is replaced whenever a
+  /// handler is added.  Requests walk the list they picked up without
+  /// holding the mutex so handlers for different requests run in parallel.
 {
 public:
   struct Item
@@ -42,6 +47,9 @@ public:
     bool operator < (const SIPB2BUserAgentHandlerList::Item& h) const;
   };
 
+  typedef std::list<Item> Handlers;
+  typedef boost::shared_ptr<const Handlers> HandlersPtr;
+
   SIPB2BUserAgentHandlerList();
 
   ~SIPB2BUserAgentHandlerList();
@@ -53,7 +61,7 @@ public:
     const OSS::SIP::SIPTransportSession::Ptr& pTransport,
     const OSS::SIP::SIPTransaction::Ptr& pTransaction);
 private:
-  std::list<Item> _handlers;
+  HandlersPtr _handlers;
   OSS::mutex_critic_sec _mutex;
 };
 
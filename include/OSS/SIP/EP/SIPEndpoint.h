@@ -25,6 +25,7 @@
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPStack.h"
 #include "OSS/SIP/EP/SIPEndpointRetransmitter.h"
+#include "OSS/UTL/BlockingQueue.h"
 
 
 #define TCP_PORT_BASE 20000
@@ -61,7 +61,7 @@ namespace SIP {
 
       _finalized = false;
       _startLine = "";
-      _body = "";
+      _body.reset();
       _badHeaders.clear();
       _headers.clear();
       _headerOffSet = 0;
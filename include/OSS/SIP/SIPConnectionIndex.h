@@ -0,0 +1,427 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef SIP_SIPConnectionIndex_INCLUDED
+#define SIP_SIPConnectionIndex_INCLUDED
+
+
+#include <ctime>
+#include <vector>
+#include <boost/array.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include "OSS/Net/IPAddress.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/TimerWheel.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+struct SIPConnectionEndpoint
+  /// Hashable (address, port) key of a remote transport endpoint.  Every
+  /// connection manager serves exactly one transport scheme so the transport
+  /// part of the (ip, port, transport) tuple is implied by the index that
+  /// holds the key.
+{
+  typedef boost::array<unsigned char, 16> Bytes;
+
+  Bytes bytes;
+  unsigned short port;
+  bool isV6;
+
+  SIPConnectionEndpoint();
+  explicit SIPConnectionEndpoint(const OSS::Net::IPAddress& address);
+
+  bool isValid() const;
+  bool operator == (const SIPConnectionEndpoint& other) const;
+};
+
+std::size_t hash_value(const SIPConnectionEndpoint& endpoint);
+  /// Hash function picked up by boost::hash
+
+
+template <typename Connection>
+class SIPConnectionIndex : private boost::noncopyable
+  /// Sharded hash index of live stream connections.
+  ///
+  /// Connections are indexed both by their numeric identifier (which doubles
+  /// as the flow token placed in transport-id parameters) and by their remote
+  /// endpoint.  Each shard owns its own read-write mutex so lookups on
+  /// unrelated connections never contend, and no operation ever holds more
+  /// than one shard lock at a time.
+  ///
+  /// Idle detection uses a hashed timer wheel with one second resolution.
+  /// A connection is placed in the slot of its idle deadline and re-examined
+  /// only when the wheel reaches that slot, at which point it is either
+  /// expired or re-armed using its last activity time.  This replaces a
+  /// per-connection deadline timer with a single periodic tick.
+{
+public:
+  typedef boost::shared_ptr<Connection> ConnectionPtr;
+  typedef std::vector<ConnectionPtr> ConnectionList;
+
+  enum
+  {
+    SHARD_COUNT = 64
+  };
+
+  SIPConnectionIndex();
+    /// Creates an empty index with idle sweeping disabled
+
+  void insert(const ConnectionPtr& conn, const OSS::Net::IPAddress& remoteAddress);
+    /// Index the connection by identifier and by remote address.  Calling this
+    /// again for an indexed connection refreshes its remote address.
+
+  ConnectionPtr remove(OSS::UInt64 identifier);
+    /// Remove the connection from both indexes and return it
+
+  void removeAll(ConnectionList& connections);
+    /// Remove every connection and return them in the list
+
+  ConnectionPtr findById(OSS::UInt64 identifier) const;
+    /// Return the connection with the given identifier or null
+
+  ConnectionPtr findByEndpoint(const OSS::Net::IPAddress& remoteAddress) const;
+    /// Return the connection with the given remote address or null
+
+  std::size_t size() const;
+    /// Return the number of indexed connections
+
+  void setIdleTimeout(unsigned int seconds);
+    /// Set the idle timeout.  Zero disables idle sweeping.  Connections already
+    /// in the index are armed from the time of the call.
+
+  unsigned int getIdleTimeout() const;
+    /// Return the idle timeout in seconds
+
+  void collectIdle(std::time_t now, ConnectionList& expired);
+    /// Advance the timer wheel up to now and remove connections whose last
+    /// activity is older than the idle timeout.  Removed connections are
+    /// appended to expired so the caller can stop them outside of any lock.
+
+private:
+  struct Entry
+  {
+    ConnectionPtr connection;
+    SIPConnectionEndpoint endpoint;
+  };
+
+  typedef boost::unordered_map<OSS::UInt64, Entry> IdMap;
+  typedef boost::unordered_map<SIPConnectionEndpoint, OSS::UInt64> EndpointMap;
+
+  struct Shard
+  {
+    mutable OSS::mutex_read_write mutex;
+    IdMap connections;
+    EndpointMap endpoints;
+  };
+
+  typedef OSS::TimerWheel<OSS::UInt64> Wheel;
+
+  Shard& idShard(OSS::UInt64 identifier) const;
+  Shard& endpointShard(const SIPConnectionEndpoint& endpoint) const;
+  void unmapEndpoint(const SIPConnectionEndpoint& endpoint, OSS::UInt64 identifier);
+
+  mutable boost::array<Shard, SHARD_COUNT> _shards;
+  OSS::mutex_critic_sec _wheelMutex;
+  Wheel _wheel;
+  unsigned int _idleTimeout;
+};
+
+
+//
+// Inlines
+//
+
+inline SIPConnectionEndpoint::SIPConnectionEndpoint() :
+  port(0),
+  isV6(false)
+{
+  bytes.assign(0);
+}
+
+inline SIPConnectionEndpoint::SIPConnectionEndpoint(const OSS::Net::IPAddress& address) :
+  port(0),
+  isV6(false)
+{
+  bytes.assign(0);
+  if (!address.isValid())
+    return;
+  port = address.getPort();
+  const boost::asio::ip::address& ip = address.address();
+  if (ip.is_v4())
+  {
+    boost::asio::ip::address_v4::bytes_type v4 = ip.to_v4().to_bytes();
+    std::copy(v4.begin(), v4.end(), bytes.begin());
+  }
+  else
+  {
+    boost::asio::ip::address_v6::bytes_type v6 = ip.to_v6().to_bytes();
+    std::copy(v6.begin(), v6.end(), bytes.begin());
+    isV6 = true;
+  }
+}
+
+inline bool SIPConnectionEndpoint::isValid() const
+{
+  return port != 0;
+}
+
+inline bool SIPConnectionEndpoint::operator == (const SIPConnectionEndpoint& other) const
+{
+  return port == other.port && isV6 == other.isV6 && bytes == other.bytes;
+}
+
+inline std::size_t hash_value(const SIPConnectionEndpoint& endpoint)
+{
+  std::size_t seed = boost::hash_range(endpoint.bytes.begin(), endpoint.bytes.end());
+  boost::hash_combine(seed, endpoint.port);
+  return seed;
+}
+
+template <typename Connection>
+SIPConnectionIndex<Connection>::SIPConnectionIndex() :
+  _idleTimeout(0)
+{
+}
+
+template <typename Connection>
+typename SIPConnectionIndex<Connection>::Shard& SIPConnectionIndex<Connection>::idShard(OSS::UInt64 identifier) const
+{
+  return _shards[boost::hash<OSS::UInt64>()(identifier) % SHARD_COUNT];
+}
+
+template <typename Connection>
+typename SIPConnectionIndex<Connection>::Shard& SIPConnectionIndex<Connection>::endpointShard(const SIPConnectionEndpoint& endpoint) const
+{
+  return _shards[hash_value(endpoint) % SHARD_COUNT];
+}
+
+template <typename Connection>
+void SIPConnectionIndex<Connection>::insert(const ConnectionPtr& conn, const OSS::Net::IPAddress& remoteAddress)
+{
+  OSS::UInt64 identifier = conn->getIdentifier();
+  SIPConnectionEndpoint endpoint(remoteAddress);
+  SIPConnectionEndpoint previous;
+  bool isNew = false;
+
+  {
+    Shard& shard = idShard(identifier);
+    OSS::mutex_write_lock lock(shard.mutex);
+    typename IdMap::iterator iter = shard.connections.find(identifier);
+    if (iter == shard.connections.end())
+    {
+      Entry& entry = shard.connections[identifier];
+      entry.connection = conn;
+      entry.endpoint = endpoint;
+      isNew = true;
+    }
+    else
+    {
+      previous = iter->second.endpoint;
+      iter->second.connection = conn;
+      if (endpoint.isValid())
+        iter->second.endpoint = endpoint;
+    }
+  }
+
+  if (endpoint.isValid() && !(previous == endpoint))
+  {
+    if (previous.isValid())
+      unmapEndpoint(previous, identifier);
+    Shard& shard = endpointShard(endpoint);
+    OSS::mutex_write_lock lock(shard.mutex);
+    shard.endpoints[endpoint] = identifier;
+  }
+
+  if (isNew)
+  {
+    OSS::mutex_critic_sec_lock lock(_wheelMutex);
+    if (_idleTimeout)
+    {
+      std::time_t now = std::time(0);
+      _wheel.schedule(identifier, now + _idleTimeout, now);
+    }
+  }
+}
+
+template <typename Connection>
+void SIPConnectionIndex<Connection>::unmapEndpoint(const SIPConnectionEndpoint& endpoint, OSS::UInt64 identifier)
+{
+  Shard& shard = endpointShard(endpoint);
+  OSS::mutex_write_lock lock(shard.mutex);
+  typename EndpointMap::iterator iter = shard.endpoints.find(endpoint);
+  //
+  // A newer connection may have claimed the same endpoint.  Leave it alone.
+  //
+  if (iter != shard.endpoints.end() && iter->second == identifier)
+    shard.endpoints.erase(iter);
+}
+
+template <typename Connection>
+typename SIPConnectionIndex<Connection>::ConnectionPtr SIPConnectionIndex<Connection>::remove(OSS::UInt64 identifier)
+{
+  Entry entry;
+  {
+    Shard& shard = idShard(identifier);
+    OSS::mutex_write_lock lock(shard.mutex);
+    typename IdMap::iterator iter = shard.connections.find(identifier);
+    if (iter == shard.connections.end())
+      return ConnectionPtr();
+    entry = iter->second;
+    shard.connections.erase(iter);
+  }
+  if (entry.endpoint.isValid())
+    unmapEndpoint(entry.endpoint, identifier);
+  return entry.connection;
+}
+
+template <typename Connection>
+void SIPConnectionIndex<Connection>::removeAll(ConnectionList& connections)
+{
+  for (std::size_t i = 0; i < SHARD_COUNT; i++)
+  {
+    Shard& shard = _shards[i];
+    OSS::mutex_write_lock lock(shard.mutex);
+    for (typename IdMap::iterator iter = shard.connections.begin(); iter != shard.connections.end(); iter++)
+      connections.push_back(iter->second.connection);
+    shard.connections.clear();
+    shard.endpoints.clear();
+  }
+  OSS::mutex_critic_sec_lock lock(_wheelMutex);
+  _wheel.clear(std::time(0));
+}
+
+template <typename Connection>
+typename SIPConnectionIndex<Connection>::ConnectionPtr SIPConnectionIndex<Connection>::findById(OSS::UInt64 identifier) const
+{
+  Shard& shard = idShard(identifier);
+  OSS::mutex_read_lock lock(shard.mutex);
+  typename IdMap::const_iterator iter = shard.connections.find(identifier);
+  if (iter == shard.connections.end())
+    return ConnectionPtr();
+  return iter->second.connection;
+}
+
+template <typename Connection>
+typename SIPConnectionIndex<Connection>::ConnectionPtr SIPConnectionIndex<Connection>::findByEndpoint(const OSS::Net::IPAddress& remoteAddress) const
+{
+  SIPConnectionEndpoint endpoint(remoteAddress);
+  if (!endpoint.isValid())
+    return ConnectionPtr();
+
+  OSS::UInt64 identifier = 0;
+  {
+    Shard& shard = endpointShard(endpoint);
+    OSS::mutex_read_lock lock(shard.mutex);
+    typename EndpointMap::const_iterator iter = shard.endpoints.find(endpoint);
+    if (iter == shard.endpoints.end())
+      return ConnectionPtr();
+    identifier = iter->second;
+  }
+  return findById(identifier);
+}
+
+template <typename Connection>
+std::size_t SIPConnectionIndex<Connection>::size() const
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < SHARD_COUNT; i++)
+  {
+    OSS::mutex_read_lock lock(_shards[i].mutex);
+    count += _shards[i].connections.size();
+  }
+  return count;
+}
+
+template <typename Connection>
+void SIPConnectionIndex<Connection>::setIdleTimeout(unsigned int seconds)
+{
+  std::vector<OSS::UInt64> identifiers;
+  for (std::size_t i = 0; i < SHARD_COUNT; i++)
+  {
+    OSS::mutex_read_lock lock(_shards[i].mutex);
+    for (typename IdMap::const_iterator iter = _shards[i].connections.begin(); iter != _shards[i].connections.end(); iter++)
+      identifiers.push_back(iter->first);
+  }
+
+  OSS::mutex_critic_sec_lock lock(_wheelMutex);
+  std::time_t now = std::time(0);
+  _wheel.clear(now);
+  _idleTimeout = seconds;
+  if (!_idleTimeout)
+    return;
+  for (std::vector<OSS::UInt64>::const_iterator iter = identifiers.begin(); iter != identifiers.end(); iter++)
+    _wheel.schedule(*iter, now + _idleTimeout, now);
+}
+
+template <typename Connection>
+unsigned int SIPConnectionIndex<Connection>::getIdleTimeout() const
+{
+  return _idleTimeout;
+}
+
+template <typename Connection>
+void SIPConnectionIndex<Connection>::collectIdle(std::time_t now, ConnectionList& expired)
+{
+  typename Wheel::TimerList due;
+  {
+    OSS::mutex_critic_sec_lock lock(_wheelMutex);
+    if (!_idleTimeout)
+      return;
+    _wheel.advance(now, due);
+  }
+
+  typename Wheel::TimerList rearm;
+  for (typename Wheel::TimerList::const_iterator iter = due.begin(); iter != due.end(); iter++)
+  {
+    ConnectionPtr conn = findById(iter->key);
+    if (!conn)
+      continue;
+    std::time_t deadline = conn->getLastActivity() + _idleTimeout;
+    if (deadline > now)
+    {
+      typename Wheel::Timer timer;
+      timer.key = iter->key;
+      timer.deadline = deadline;
+      rearm.push_back(timer);
+    }
+    else if ((conn = remove(iter->key)))
+    {
+      expired.push_back(conn);
+    }
+  }
+
+  if (!rearm.empty())
+  {
+    OSS::mutex_critic_sec_lock lock(_wheelMutex);
+    for (typename Wheel::TimerList::const_iterator iter = rearm.begin(); iter != rearm.end(); iter++)
+      _wheel.schedule(iter->key, iter->deadline, now);
+  }
+}
+
+
+} } // OSS::SIP
+#endif // SIP_SIPConnectionIndex_INCLUDED
@@ -0,0 +1,68 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef SIP_SIPConnectionSweeper_INCLUDED
+#define SIP_SIPConnectionSweeper_INCLUDED
+
+
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include "OSS/SIP/SIPConnectionIndex.h"
+#include "OSS/SIP/SIPTransportSession.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+class OSS_API SIPConnectionSweeper : private boost::noncopyable
+  /// Stops connections of an index that had no activity for the idle timeout.
+  /// A single timer ticking once a second drives the timer wheel of the index
+  /// so the cost does not grow with the number of connections.
+{
+public:
+  typedef SIPConnectionIndex<SIPTransportSession> ConnectionIndex;
+
+  SIPConnectionSweeper(const std::string& owner, ConnectionIndex& connections);
+    /// Creates a stopped sweeper.  The owner name is used for logging.
+
+  ~SIPConnectionSweeper();
+
+  void start(boost::asio::io_service& ioService, unsigned int idleTimeout);
+    /// Start sweeping.  Zero disables sweeping.
+
+  void stop();
+    /// Stop sweeping idle connections
+
+private:
+  void handleSweep(const boost::system::error_code& e);
+
+  std::string _owner;
+  ConnectionIndex& _connections;
+  OSS::mutex_critic_sec _mutex;
+  boost::asio::deadline_timer* _pTimer;
+};
+
+
+} } // OSS::SIP
+#endif // SIP_SIPConnectionSweeper_INCLUDED
@@ -0,0 +1,251 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef SIP_SIPDigestAuthEngine_INCLUDED
+#define SIP_SIPDigestAuthEngine_INCLUDED
+
+
+#include <map>
+#include <list>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/function.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+class OSS_API SIPDigestAuthEngine : boost::noncopyable
+  /// Server side digest authentication engine.
+  ///
+  /// Nonces are stateless.  They carry their creation time and an
+  /// HMAC-SHA256 signature using the engine secret so that any node
+  /// sharing the secret can validate them without a lookup.  A bounded
+  /// replay cache tracks the last nonce-count seen for each nonce and
+  /// an HA1 cache keyed by (user, realm, algorithm) avoids recomputing
+  /// the credential hash for every challenge/response pair.
+  ///
+  /// All hash computations use fixed buffers and do not allocate strings.
+  /// Both MD5 and the SHA-256 algorithms of RFC 8760 are supported.
+{
+public:
+  enum Algorithm
+  {
+    ALGORITHM_MD5,
+    ALGORITHM_MD5_SESS,
+    ALGORITHM_SHA256,
+    ALGORITHM_SHA256_SESS,
+    ALGORITHM_UNKNOWN
+  };
+
+  enum Result
+  {
+    AUTH_OK,
+    AUTH_MALFORMED,
+    AUTH_INVALID_NONCE,
+    AUTH_STALE_NONCE,
+    AUTH_REPLAY,
+    AUTH_UNKNOWN_USER,
+    AUTH_INVALID_RESPONSE
+  };
+
+  enum
+  {
+    MAX_HASH_HEX_LEN = 64,
+    NONCE_LEN = 48
+  };
+
+  struct Hash
+    /// Lower case hex representation of a digest in a fixed buffer
+  {
+    Hash() : len(0) { hex[0] = 0; }
+    bool empty() const { return len == 0; }
+    bool equals(const char* other, std::size_t otherLen) const;
+    char hex[MAX_HASH_HEX_LEN + 1];
+    std::size_t len;
+  };
+
+  typedef boost::function<bool(const std::string& /*user*/, const std::string& /*realm*/, std::string& /*password*/)> PasswordLookup;
+    /// Callback used to retrieve the password when HA1 is not in the cache
+
+  SIPDigestAuthEngine(const std::string& secret,
+    unsigned int nonceLifetime = DEFAULT_NONCE_LIFETIME,
+    std::size_t maxNonces = DEFAULT_MAX_NONCES,
+    std::size_t maxHA1 = DEFAULT_MAX_HA1);
+    /// Creates a new digest authentication engine.
+    ///
+    /// nonceLifetime is expressed in seconds.  maxNonces and maxHA1 bound
+    /// the number of entries kept in the replay and HA1 caches.
+
+  ~SIPDigestAuthEngine();
+    /// Destroys the digest authentication engine
+
+  static Algorithm parseAlgorithm(const std::string& algorithm);
+    /// Returns the algorithm from the value of the algorithm parameter.
+    /// An empty value defaults to MD5 as mandated by RFC 2617.
+
+  static const char* algorithmToString(Algorithm algorithm);
+    /// Returns the algorithm parameter value
+
+  static bool hash(Algorithm algorithm,
+    const char* const* segments,
+    const std::size_t* lengths,
+    std::size_t count,
+    Hash& result);
+    /// Computes the digest of the segments joined with ':'
+
+  static bool computeHA1(Algorithm algorithm,
+    const std::string& user,
+    const std::string& realm,
+    const std::string& password,
+    Hash& result);
+    /// Computes H(user:realm:password)
+
+  static bool computeSessionHA1(Algorithm algorithm,
+    const Hash& ha1,
+    const std::string& nonce,
+    const std::string& cnonce,
+    Hash& result);
+    /// Computes H(HA1:nonce:cnonce) for the -sess algorithms
+
+  static bool computeHA2(Algorithm algorithm,
+    const char* method,
+    const std::string& uri,
+    Hash& result);
+    /// Computes H(method:uri)
+
+  static bool computeResponse(Algorithm algorithm,
+    const Hash& ha1,
+    const std::string& nonce,
+    const std::string& nonceCount,
+    const std::string& cnonce,
+    const std::string& qop,
+    const Hash& ha2,
+    Hash& result);
+    /// Computes the request-digest.  If qop is empty, the RFC 2069
+    /// form H(HA1:nonce:HA2) is used.
+
+  std::string createNonce() const;
+    /// Create a new stateless nonce using the current time
+
+  std::string createNonce(unsigned int timestamp) const;
+    /// Create a new stateless nonce for a particular timestamp
+
+  Result validateNonce(const std::string& nonce) const;
+    /// Verifies the signature and lifetime of the nonce
+
+  Result validateNonce(const std::string& nonce, unsigned int now) const;
+    /// Verifies the signature and lifetime of the nonce against a reference time
+
+  Result checkNonceCount(const std::string& nonce, const std::string& nonceCount);
+    /// Verifies that nonceCount is greater than the last count seen for the nonce
+    /// and records it.  Returns AUTH_REPLAY if it is not.
+
+  void setHA1(const std::string& user, const std::string& realm, Algorithm algorithm, const Hash& ha1);
+    /// Store a precomputed HA1 in the cache
+
+  bool getHA1(const std::string& user, const std::string& realm, Algorithm algorithm, Hash& ha1) const;
+    /// Retrieve a precomputed HA1 from the cache
+
+  void removeHA1(const std::string& user, const std::string& realm);
+    /// Remove all the HA1 entries for a user.  This must be called
+    /// whenever the password of the user changes
+
+  void setPasswordLookup(const PasswordLookup& lookup);
+    /// Set the callback used to retrieve passwords on an HA1 cache miss
+
+  Result authenticate(const std::string& authorization, const char* method);
+    /// Authenticate the value of an Authorization or Proxy-Authorization header
+
+  Result authenticate(const std::string& authorization, const char* method, unsigned int now);
+    /// Authenticate the value of an Authorization or Proxy-Authorization header
+    /// against a reference time
+
+  std::size_t getNonceCacheSize() const;
+    /// Returns the number of nonces tracked by the replay cache
+
+  std::size_t getHA1CacheSize() const;
+    /// Returns the number of HA1 entries in the cache
+
+  static const unsigned int DEFAULT_NONCE_LIFETIME = 300;
+  static const std::size_t DEFAULT_MAX_NONCES = 65536;
+  static const std::size_t DEFAULT_MAX_HA1 = 65536;
+
+private:
+  bool signNonce(unsigned int timestamp, unsigned int salt, char* signature) const;
+
+  struct NonceEntry
+  {
+    unsigned long nonceCount;
+    unsigned int timestamp;
+  };
+  struct HA1Entry
+  {
+    Hash ha1;
+    std::list<std::string>::iterator order;
+  };
+  typedef std::map<std::string, NonceEntry> NonceCache;
+  typedef std::map<std::string, HA1Entry> HA1Cache;
+
+  static std::string createHA1Key(const std::string& user, const std::string& realm, Algorithm algorithm);
+
+  std::string _secret;
+  unsigned int _nonceLifetime;
+  std::size_t _maxNonces;
+  std::size_t _maxHA1;
+  mutable unsigned int _salt;
+  unsigned int _evictedTimestamp;
+  NonceCache _nonces;
+  std::list<std::string> _nonceOrder;
+  HA1Cache _ha1;
+  std::list<std::string> _ha1Order;
+  PasswordLookup _passwordLookup;
+  mutable OSS::mutex_critic_sec _nonceMutex;
+  mutable OSS::mutex_read_write _ha1Mutex;
+};
+
+//
+// Inlines
+//
+
+inline std::size_t SIPDigestAuthEngine::getNonceCacheSize() const
+{
+  OSS::mutex_critic_sec_lock lock(_nonceMutex);
+  return _nonces.size();
+}
+
+inline std::size_t SIPDigestAuthEngine::getHA1CacheSize() const
+{
+  OSS::mutex_read_lock lock(_ha1Mutex);
+  return _ha1.size();
+}
+
+inline void SIPDigestAuthEngine::setPasswordLookup(const PasswordLookup& lookup)
+{
+  _passwordLookup = lookup;
+}
+
+
+} } // OSS::SIP
+
+#endif // SIP_SIPDigestAuthEngine_INCLUDED
@@ -22,7 +22,7 @@
 #define SIP_SIPFSMDispatch_INCLUDED
 
 
-#include "OSS/UTL/Cache.h"
+#include "OSS/UTL/ExpireCache.h"
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPIctPool.h"
 #include "OSS/SIP/SIPNictPool.h"
@@ -136,7 +136,7 @@ private:
   SIPNistPool _nist;
   SIPTransaction::RequestCallback _requestHandler;
   UnknownTransactionCallback _ackOr2xxTransactionHandler;
-  StringPairCache _istBlocker;
+  ExpireCache<std::string, bool> _istBlocker;
   bool _enableIctForking;
 };
 
@@ -172,7 +172,7 @@ inline SIPFSMDispatch::UnknownTransactionCallback& SIPFSMDispatch::ackOr2xxTrans
 
 inline void SIPFSMDispatch::blockIst(const std::string& id)
 {
-  _istBlocker.add(id, id);
+  _istBlocker.add(id, true);
 }
 
 } } // namespace OSS::SIP
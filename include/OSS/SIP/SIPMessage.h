@@ -28,6 +28,7 @@
 #include <boost/logic/tribool.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include "OSS/SIP/Parser.h"
 #include "OSS/SIP/SIPParser.h"
@@ -35,6 +36,9 @@
 #include "OSS/SIP/SIPDigestAuth.h"
 #include "OSS/SIP/SIPURI.h"
 #include "OSS/UTL/PropertyMap.h"
+#include "OSS/UTL/PropertySlots.h"
+#include "OSS/UTL/OwnershipMutex.h"
+#include "OSS/UTL/SlabAllocated.h"
 
 
 namespace OSS {
@@ -60,19 +64,63 @@ static const char REQ_REGISTER[]   = "REGISTER";
 class OSS_API SIPMessage : 
   public SIPParser,
   public SIPDigestAuth,
-  public boost::enable_shared_from_this<SIPMessage>
+  public boost::enable_shared_from_this<SIPMessage>,
+  public OSS::SlabAllocated<SIPMessage>
   /// This class is an implementation of a standard SIP Message
   /// supporting 3261, 3262, 3265, 3515, 3892, 3325, 4028 headers.
   /// Other or future as well as proprietary extension headers
   /// are also supported using generic header handling functions.
+  ///
+  /// Messages come from the sip_message slab pool.
 {
 public:
   typedef boost::shared_ptr<SIPMessage> Ptr; /// A shared smart pointer to a SIPMessage object
-  typedef boost::shared_lock<boost::shared_mutex> ReadLock;
-  typedef boost::lock_guard<boost::shared_mutex> WriteLock;
+  typedef boost::shared_lock<OSS::OwnershipMutex> ReadLock;
+  typedef boost::lock_guard<OSS::OwnershipMutex> WriteLock;
   typedef std::map<std::string, std::string> CustomProperties;
+  typedef PropertySlots<PropertyMap::PROP_Max> PropertyValues;
+    /// Values of the predefined properties indexed by PropertyMap::Enum
   static const int NULL_HDR = 0;
 
+  struct HeaderCache
+    /// Memoized values extracted from the hot headers (Via, From, To,
+    /// CSeq, Call-ID and Contact).  Entries are computed the first time
+    /// they are requested and are dropped by any function that modifies
+    /// the header they were extracted from.
+  {
+    enum Entry
+    {
+      CACHE_VIA = 0x01,
+      CACHE_FROM = 0x02,
+      CACHE_TO = 0x04,
+      CACHE_CSEQ = 0x08,
+      CACHE_CALL_ID = 0x10,
+      CACHE_CONTACT = 0x20,
+      CACHE_TRANSACTION_ID = 0x40,
+      CACHE_ALL = 0x7F
+    };
+
+    HeaderCache() : valid(0), generation(0) {}
+
+    void invalidate(unsigned int entries)
+    {
+      valid &= ~entries;
+      ++generation;
+    }
+
+    unsigned int valid;
+    unsigned int generation;
+    std::string topVia;
+    std::string topViaBranch;
+    std::string fromTag;
+    std::string toTag;
+    std::string cseqMethod;
+    std::string cseqNumber;
+    std::string callId;
+    std::string topContact;
+    std::string transactionId;
+  };
+
   enum StatusCodes
   {
     CODE_UNKNOWN = 0,
@@ -232,10 +280,25 @@ public:
   
   explicit SIPMessage(const SIPMessage& packet);
     /// Creates a SIP Message from another SIP Message Object.
+    ///
+    /// The copy shares the header token vectors and the body with the
+    /// original.  Each side copies a header or the body only the first time
+    /// it modifies it, so a B2BUA leg built from the inbound request only
+    /// pays for the headers routing actually rewrites.
 
   virtual ~SIPMessage();
     /// Destroys the SIP Message
 
+  void setSingleOwner(bool singleOwner);
+    /// Marks the message as owned by one thread at a time.  A single owner
+    /// message takes no locks.  Transports create inbound messages this
+    /// way and the dispatcher switches them back to shared mode before it
+    /// hands them to a transaction, where timers and the application can
+    /// reach them concurrently.  Only the owning thread may call this.
+
+  bool isSingleOwner() const;
+    /// Returns true if the message does not lock on access
+
   void parse();
   void parse(std::string& data);
     /// Parse the SIP message headers.
@@ -497,6 +560,9 @@ public:
     ///
     /// Format:
     ///   transaction-id = method  cseq  (via-branch / callid)
+    ///
+    /// If method is not specified, the id is computed once and
+    /// stored in the header cache until Via, CSeq or Call-ID changes.
 
   boost::tribool isRequest(const char* method = 0) const;
     /// Returns true if the SIP Message is a request.
@@ -604,12 +670,17 @@ public:
     ///
     /// The inverse of the prior rule will be true if the asSender flag is false
 
-  std::string& body();
+  const std::string& body() const;
     /// Returns the body of the SIP Message if present;
     /// Take note that this is not thread safe
     /// use getBody() and setBody() instead for
     /// thread safe operations
 
+  std::string& modifyBody();
+    /// Returns the body for writing.  A body still shared with a copy of
+    /// this message is copied first.  Take note that this is not thread
+    /// safe.  Use setBody() to replace the body.
+
   const std::string& getBody() const;
     /// Returns the body of the SIP Message if present
 
@@ -671,6 +742,9 @@ public:
     /// Remove all custom properties
   
   CustomProperties& properties();
+    /// Properties that are not one of the predefined PropertyMap::Enum
+    /// values, such as those defined by scripts.  The predefined properties
+    /// are kept in fixed slots and do not appear here.
   
   const CustomProperties& properties() const;
   
@@ -678,6 +752,12 @@ public:
     /// Return the method portion of the CSeq.  This function would behae the same
     /// for both requests and responses.
 
+  std::string getCSeqNumber() const;
+    /// Return the number portion of the CSeq.
+
+  std::string getCallId() const;
+    /// Return the value of the Call-ID header.
+
   OSS_HANDLE& userData();
     /// Returns a reference to the user data
 
@@ -733,12 +813,53 @@ public:
 
   std::string getTopViaBranch() const;
     /// Return the top via branhc parameter
+
+  std::string getTopVia() const;
+    /// Return the top most via element
+
+  std::string getTopContact() const;
+    /// Return the first element of the Contact header
   
   void getHeaderNames(std::set<std::string>& headers) const;
     /// Return all the available header names
   
 protected:
   boost::tribool consumeOne(char input);
+
+  std::string getCachedHeaderValue(HeaderCache::Entry entry, std::string HeaderCache::* field) const;
+    /// Returns a memoized header value.  The value is computed
+    /// and stored in the header cache if it is not yet present.
+
+  void computeHeaderCache(HeaderCache::Entry entry, HeaderCache& cache) const;
+    /// Extract the value of a cache entry from the current headers
+
+  bool computeTransactionId(std::string& transactionId, const char* method) const;
+    /// Computes the transaction id without consulting the cache
+
+  void invalidateHeaderCache(const std::string& key);
+    /// Drop the cache entries affected by a change to header key.
+    /// The caller must hold the write lock.
+
+  static unsigned int headerCacheEntries(const std::string& key);
+    /// Returns the cache entries derived from the lowercased header name
+
+  typedef boost::shared_ptr<SIPHeaderTokens> HeaderTokensPtr;
+  typedef std::map<std::string, HeaderTokensPtr> HeaderMap;
+    /// Header token vectors keyed by the lowercased header name.  The
+    /// vectors may be shared with copies of this message so they are
+    /// only written through modifyHeader() or createHeader().
+
+  const SIPHeaderTokens* findHeader(const std::string& key) const;
+    /// Returns the tokens of a header for reading or 0 if it is absent
+
+  SIPHeaderTokens* modifyHeader(const std::string& key);
+    /// Returns the tokens of a header for writing or 0 if it is absent.
+    /// Tokens still shared with a copy of this message are copied first.
+
+  SIPHeaderTokens& createHeader(const std::string& key, const char* rawHeaderName);
+    /// Replaces the tokens of a header with a new empty vector that is
+    /// serialized after every existing header
+
   enum ConsumeState
   {
     IDLE,
@@ -753,22 +874,24 @@ protected:
     EXPECTING_BODY
   } _consumeState;
 
-  mutable boost::shared_mutex _rwlock;
+  mutable OSS::OwnershipMutex _rwlock;
 
   bool _finalized;
   std::string _startLine;
-  std::string _body;
+  boost::shared_ptr<std::string> _body;
   SIPHeaderTokens _badHeaders;
-  SIPHeaderList _headers;
+  HeaderMap _headers;
   static std::string _headerEmptyRet;
   size_t _headerOffSet;
   std::size_t _expectedBodyLen;
   mutable boost::tribool _isResponse;
   mutable boost::tribool _isRequest;
   CustomProperties _properties;
+  PropertyValues _propertyValues;
   OSS_HANDLE _userData;
   std::string _idleBuffer;
   mutable std::string _logContext;
+  mutable HeaderCache _headerCache;
 };
 
 //
@@ -791,14 +914,24 @@ inline size_t SIPMessage::hdrGetSize(
   return hdrPresent(headerName);
 }
 
+inline void SIPMessage::setSingleOwner(bool singleOwner)
+{
+  _rwlock.setSingleOwner(singleOwner);
+}
+
+inline bool SIPMessage::isSingleOwner() const
+{
+  return _rwlock.isSingleOwner();
+}
+
 inline SIPHeaderTokens & SIPMessage::badHeaders()
 {
   return _badHeaders;
 }
 
-inline std::string& SIPMessage::body()
+inline const std::string& SIPMessage::body() const
 {
-  return _body;
+  return _body ? *_body : _headerEmptyRet;
 }
 
 inline std::string& SIPMessage::startLine()
@@ -821,16 +954,6 @@ inline std::string& SIPMessage::idleBuffer()
   return _idleBuffer;
 }
 
-inline bool SIPMessage::getProperty(PropertyMap::Enum   property, std::string& value) const
-{
-  return getProperty(PropertyMap::propertyString(property), value);
-}
-
-inline void SIPMessage::setProperty(PropertyMap::Enum property, const std::string& value)
-{
-  setProperty(PropertyMap::propertyString(property), value);
-}
-
 inline SIPMessage::CustomProperties& SIPMessage::properties()
 {
   return _properties;
@@ -843,5 +966,8 @@ inline const SIPMessage::CustomProperties& SIPMessage::properties() const
 
 
 }} //OSS::SIP
+
+OSS_SLAB_POOL_DECLARE(OSS::SIP::SIPMessage)
+
 #endif //SIP_SIPMessage_INCLUDED
 
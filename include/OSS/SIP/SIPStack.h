@@ -280,6 +280,12 @@ public:
     int banLifeTime // violator jail lifetime
   );
   
+  bool setTransportBanSet(const std::string& setName);
+    /// Mirrors banned sources into the ipsets named setName (IPv4) and
+    /// setName + "6" (IPv6) so a firewall rule can drop them in the kernel.
+    /// The sets are created if they do not exist.  Returns false if netlink
+    /// is not available.
+  
   SIPTransaction::Ptr createClientTransaction(const SIPMessage::Ptr& pRequest);
     /// Create a new transaction for a new non-ACK outgoing request
   
@@ -22,11 +22,10 @@
 #define SIP_SIPStreamedConnectionManager_INCLUDED
 
 
-#include <set>
-#include <map>
 #include <boost/asio.hpp>
 #include <boost/noncopyable.hpp>
 #include "SIPStreamedConnection.h"
+#include "OSS/SIP/SIPConnectionSweeper.h"
 #include "OSS/UTL/Thread.h"
 
 
@@ -87,10 +86,27 @@ public:
     /// Find a connection to a specific target if it exists
 
   SIPStreamedConnection::Ptr findConnectionById(OSS::UInt64 identifier);
+    /// Find a connection using its identifier (flow token) if it exists
+
+  std::size_t getConnectionCount() const;
+    /// Return the number of managed connections
+
+  void startIdleSweeper(boost::asio::io_service& ioService, unsigned int idleTimeout);
+    /// Stop connections that had no activity for idleTimeout seconds.
+    /// A single timer ticking once a second drives the sweep for all connections.
+
+  void stopIdleSweeper();
+    /// Stop sweeping idle connections
+
 private:
-  OSS::mutex_read_write _rwConnectionsMutex;
+  typedef SIPConnectionSweeper::ConnectionIndex ConnectionIndex;
+
+  OSS::UInt64 nextIdentifier();
+
+  OSS::mutex_critic_sec _identifierMutex;
   OSS::UInt64 _currentIdentifier;
-  std::map<OSS::UInt64, SIPStreamedConnection::Ptr> _connections;
+  ConnectionIndex _connections;
+  SIPConnectionSweeper _sweeper;
   SIPTransportSession::Dispatch _dispatch;
   unsigned short _portBase;
   unsigned short _portMax;
@@ -28,6 +28,8 @@
 #include <boost/enable_shared_from_this.hpp>
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/UTL/SlabAllocated.h"
+#include "OSS/UTL/MemoryArena.h"
 #include "OSS/Net/Net.h"
 #include "OSS/SIP/SIPTransportSession.h"
 #include "OSS/SIP/SIPMessage.h"
@@ -55,8 +57,14 @@ class SIPTransportService;
 class SIPTransactionPool;
 class SIPFsm;
 
-class OSS_API SIPTransaction: public boost::enable_shared_from_this<SIPTransaction>
+class OSS_API SIPTransaction: public boost::enable_shared_from_this<SIPTransaction>,
+  public OSS::SlabAllocated<SIPTransaction>
 	/// Base class for ICT, IST, NICT, NIST state machines
+	///
+	/// Transactions come from the sip_transaction slab pool.  State that
+	/// lives and dies with the transaction, such as its state machine and
+	/// timers, is placed in the transaction arena.  Arena chunks are
+	/// accounted to sip_transaction_arena.
 {
 public:
   static const int TRN_STATE_CHILD = 0xFC;
@@ -223,6 +231,14 @@ public:
   SIPFsm::Ptr& fsm();
     /// Returns a reference to the fsm pointer
 
+  const OSS::MemoryArena::Ptr& arena() const;
+    /// Region for objects scoped to this transaction.  Allocate from it
+    /// with OSS::ArenaAllocator.  It is released once the transaction and
+    /// every object placed in it are gone.
+
+  static OSS::SlabPool& arenaChunks();
+    /// The pool transaction arenas take their chunks from
+
   void terminate();
     /// Puts the transaction in the terminated state
     /// and calls SIPTransactionPool::removeTransaction()
@@ -338,6 +354,7 @@ private:
   SIPTransaction& operator = (const SIPTransaction&);
   std::string _id;
   SIPTransactionPool* _owner;
+  OSS::MemoryArena::Ptr _arena;
   SIPFsm::Ptr _fsm;
   SIPTransportSession::Ptr _transport;
   SIPTransportService* _transportService;
@@ -392,6 +409,11 @@ inline SIPFsm::Ptr& SIPTransaction::fsm()
   return _fsm;
 }
 
+inline const OSS::MemoryArena::Ptr& SIPTransaction::arena() const
+{
+  return _arena;
+}
+
 inline SIPTransportSession::Ptr& SIPTransaction::transport()
 {
   return _transport;
@@ -474,5 +496,7 @@ inline void SIPTransaction::setResponseCallback(const ResponseCallback& response
 
 } } // namespace OSS::SIP
 
+OSS_SLAB_POOL_DECLARE(OSS::SIP::SIPTransaction)
+
 
 #endif // SIP_SIPTransaction_INCLUDED
@@ -24,6 +24,7 @@
 
 #include <map>
 #include <list>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/asio.hpp>
@@ -186,6 +187,12 @@ public:
     const OSS::Net::IPAddress& target);
     /// send UDP Keep-alive packet
 
+  std::size_t sendUDPKeepAlive(const OSS::Net::IPAddress& localInterface,
+    const std::vector<OSS::Net::IPAddress>& targets);
+    /// send UDP Keep-alive packets to all targets reachable through the
+    /// same local interface.  The listener is looked up once and the
+    /// packets are written as a batch.  Returns the number of packets sent.
+
   bool isLocalTransport(const std::string& proto, const std::string& ip,
     const std::string& port) const;
     /// Returns true if the transport is a registered listener
@@ -248,8 +255,16 @@ public:
 #if ENABLE_FEATURE_WEBSOCKETS  
   void setWSPortRange(unsigned short base, unsigned short max);
     /// Set the WebSocket port range.  Applies to both WebSocket and WebSocket Secure transports
+
+  void setWSThreadCount(std::size_t threadCount);
+    /// Set the number of threads each WebSocket listener added afterwards
+    /// accepts and serves connections on.  The default is 1.
 #endif
 
+  void setIdleConnectionTimeout(unsigned int seconds);
+    /// Close TCP, TLS and WebSocket connections that have been idle for the
+    /// specified number of seconds.  Zero (the default) disables idle sweeping.
+
   unsigned short getTCPPortBase() const;
     /// Return the minimum port for TCP clients
 
@@ -288,6 +303,7 @@ private:
   bool _wsEnabled;
   unsigned short _wsPortBase;
   unsigned short _wsPortMax;
+  std::size_t _wsThreadCount;
 #endif
 
 };
@@ -356,6 +372,11 @@ inline void SIPTransportService::setWSPortRange(unsigned short base, unsigned sh
   _wsPortBase = base;
   _wsPortMax = max;
 }
+
+inline void SIPTransportService::setWSThreadCount(std::size_t threadCount)
+{
+  _wsThreadCount = threadCount;
+}
 #endif
 
 
@@ -21,6 +21,7 @@
 #ifndef SIP_SIPTransportSession_INCLUDED
 #define SIP_SIPTransportSession_INCLUDED
 
+#include <ctime>
 #include <boost/asio.hpp>
 #include <boost/system/error_code.hpp>
 #include <boost/shared_ptr.hpp>
@@ -183,6 +184,13 @@ public:
   
   SIPListener* getListener() const;
     /// Return the associated listener for this connection
+
+  void touch();
+    /// Record activity on this transport.  Connection managers use the last
+    /// activity time to sweep idle connections.
+
+  std::time_t getLastActivity() const;
+    /// Return the time of the last recorded activity
   
 protected:
   static SIPTransportRateLimitStrategy _rateLimit;
@@ -204,6 +212,7 @@ protected:
   SIPTransactionPool* _pTransactionPool;
   bool _isConnected;
   SIPListener* _pListener;
+  std::time_t _lastActivity;
 };
 
 //
@@ -343,6 +352,16 @@ inline void SIPTransportSession::setConnected(bool connected)
   _isConnected = connected;
 }
 
+inline void SIPTransportSession::touch()
+{
+  _lastActivity = std::time(0);
+}
+
+inline std::time_t SIPTransportSession::getLastActivity() const
+{
+  return _lastActivity;
+}
+
 inline SIPListener* SIPTransportSession::getListener() const
 {
   return _pListener;
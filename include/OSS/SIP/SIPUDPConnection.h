@@ -22,6 +22,7 @@
 #define SIP_SIPUDPConnection_INCLUDED
 
 
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/array.hpp>
 #include <boost/shared_ptr.hpp>
@@ -71,6 +72,12 @@ public:
     /// reliability of the transport for stream based connections.
     /// The default packet is CRLF/CRLF
 
+  std::size_t writeKeepAlive(const std::vector<OSS::Net::IPAddress>& targets);
+    /// Send a CRLF/CRLF keep-alive to every target in the list.  Targets are
+    /// already resolved so no resolver lookup takes place.  On Linux the
+    /// datagrams are handed to the kernel in batches using sendmmsg().
+    /// Returns the number of datagrams sent.
+
   void clientBind(const OSS::Net::IPAddress& listener, unsigned short portBase, unsigned short portMax);
     /// Bind the local client.  Take note that this is not implemented at all for UDP.
 
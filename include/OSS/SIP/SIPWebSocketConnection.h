@@ -59,6 +59,7 @@
 #include <boost/array.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/atomic.hpp>
 #include "OSS/SIP/SIP.h"
 #include "OSS/SIP/SIPMessage.h"
 #include "OSS/Net/WebSocket.h"
@@ -97,10 +98,24 @@ protected:
 public:
   typedef boost::asio::ip::tcp::socket::endpoint_type EndPoint;
 
+  struct Counters
+    /// Traffic counters shared by all connections served by one listener thread
+  {
+    Counters();
+
+    boost::atomic<OSS::UInt64> connectionsAccepted;
+    boost::atomic<OSS::UInt64> connectionsActive;
+    boost::atomic<OSS::UInt64> framesReceived;
+    boost::atomic<OSS::UInt64> bytesReceived;
+    boost::atomic<OSS::UInt64> framesSent;
+    boost::atomic<OSS::UInt64> bytesSent;
+  };
+  typedef boost::shared_ptr<Counters> CountersPtr;
+
   SIPWebSocketConnection(SIPWebSocketConnectionManager& manager, SIPListener* pListener);
 
   SIPWebSocketConnection(const websocketpp::server::connection_ptr& pConnection, SIPWebSocketConnectionManager& manager,
-      SIPListener* pListener);
+      SIPListener* pListener, const CountersPtr& pCounters = CountersPtr());
 
   virtual ~SIPWebSocketConnection();
 
@@ -163,8 +178,8 @@ protected:
   SIPWebSocketConnectionManager& _connectionManager;
     /// The manager for this connection.
 
-  SIPMessage::Ptr _pRequest;
-    /// Incoming SIP Message parser
+  CountersPtr _pCounters;
+    /// Counters of the listener thread this connection is pinned to
 
 private:
 
@@ -54,11 +54,10 @@
 #include "OSS/build.h"
 #if ENABLE_FEATURE_WEBSOCKETS
 
-#include <set>
-#include <map>
 #include <boost/asio.hpp>
 #include <boost/noncopyable.hpp>
 #include "OSS/SIP/SIPWebSocketConnection.h"
+#include "OSS/SIP/SIPConnectionSweeper.h"
 #include "OSS/UTL/Thread.h"
 
 
@@ -119,11 +118,26 @@ public:
     /// Find a connection to a specific target if it exists
 
   SIPWebSocketConnection::Ptr findConnectionById(OSS::UInt64 identifier);
+    /// Find a connection using its identifier (flow token) if it exists
 
   SIPWebSocketConnection::Ptr findConnectionByPtr(websocketpp::server::connection_ptr ptr);
+
+  std::size_t getConnectionCount() const;
+    /// Return the number of managed connections
+
+  void startIdleSweeper(boost::asio::io_service& ioService, unsigned int idleTimeout);
+    /// Stop connections that had no activity for idleTimeout seconds.
+    /// A single timer ticking once a second drives the sweep for all connections.
+
+  void stopIdleSweeper();
+    /// Stop sweeping idle connections
+
 private:
-  OSS::mutex_read_write _rwConnectionsMutex;
-  std::map<OSS::UInt64, SIPWebSocketConnection::Ptr> _connections;
+  typedef SIPConnectionSweeper::ConnectionIndex ConnectionIndex;
+
+
+  ConnectionIndex _connections;
+  SIPConnectionSweeper _sweeper;
   SIPTransportSession::Dispatch _dispatch;
   unsigned short _portBase;
   unsigned short _portMax;
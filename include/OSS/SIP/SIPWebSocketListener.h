@@ -54,6 +54,7 @@
 #include "OSS/build.h"
 #if ENABLE_FEATURE_WEBSOCKETS
 
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include "OSS/SIP/SIPListener.h"
 #include "OSS/SIP/SIPWebSocketConnection.h"
@@ -81,14 +82,28 @@ public:
 	class ServerAcceptHandler : public websocketpp::server::handler
 	{
 	public:
-		ServerAcceptHandler(SIPWebSocketListener& listener);
+		ServerAcceptHandler(SIPWebSocketListener& listener,
+      const SIPWebSocketConnection::CountersPtr& pCounters = SIPWebSocketConnection::CountersPtr());
 
 		void on_fail(websocketpp::server::connection_ptr pConnection);
 		void on_open(websocketpp::server::connection_ptr pConnection);
     void validate(websocketpp::server::connection_ptr pConnection);
 		SIPWebSocketListener& _rListener;
+		SIPWebSocketConnection::CountersPtr _pCounters;
 	};
 
+  struct ThreadStatistics
+    /// Snapshot of the counters of one listener thread
+  {
+    OSS::UInt64 connectionsAccepted;
+    OSS::UInt64 connectionsActive;
+    OSS::UInt64 framesReceived;
+    OSS::UInt64 bytesReceived;
+    OSS::UInt64 framesSent;
+    OSS::UInt64 bytesSent;
+  };
+  typedef std::vector<ThreadStatistics> Statistics;
+
 
 public:
 
@@ -106,6 +121,11 @@ public:
   virtual void handleAccept(const boost::system::error_code& e, OSS_HANDLE userData = 0);
     /// Handle completion of an asynchronous accept operation.
 
+  void handleAccept(const boost::system::error_code& e, OSS_HANDLE userData,
+    const SIPWebSocketConnection::CountersPtr& pCounters);
+    /// Handle completion of an asynchronous accept operation on a listener
+    /// thread.  The connection is counted in the counters of that thread.
+
   virtual void handleStart();
     /// Handle a request to start the server.
   
@@ -120,19 +140,53 @@ public:
   
   virtual bool canBeRestarted() const;
     /// returns true if the listener can safely be restarted
+
+  void setThreadCount(std::size_t threadCount);
+    /// Set the number of threads accepting and serving connections.  Each
+    /// thread runs its own io_service and listens on the same port using
+    /// SO_REUSEPORT so the kernel spreads new connections across them.
+    /// A connection is served by the thread that accepted it for its whole
+    /// life.  Takes effect on the next call to run().  The default is 1.
+
+  std::size_t getThreadCount() const;
+    /// Return the number of listener threads
+
+  bool hasFailed() const;
+    /// Return true if a listener thread could not bind or listen.  The
+    /// other threads are stopped as well.  Call handleStop() before
+    /// running the listener again.
+
+  void getStatistics(Statistics& statistics) const;
+    /// Return the connection and frame counters of each listener thread
  
 protected:
-  void run_server();
+  struct Shard
+    /// A listener thread together with the endpoint it runs and the
+    /// counters of the connections it serves
+  {
+    Shard();
+
+    websocketpp::server::handler::ptr pServerAcceptHandler;
+    websocketpp::server* pServerEndPoint;
+    boost::thread* pServerThread;
+    SIPWebSocketConnection::CountersPtr pCounters;
+  };
+  typedef std::vector<Shard*> Shards;
+
+  void run_server(Shard* pShard);
   void run_client();
+  void handleServerFailure(Shard* pFailed);
 
-  websocketpp::server::handler::ptr _pServerAcceptHandler;
-  websocketpp::server* _pServerEndPoint;
+  Shards _shards;
+  std::size_t _threadCount;
+  bool _hasFailed;
+  mutable OSS::mutex_critic_sec _shardsMutex;
 
   SIPWebSocketConnectionManager& _connectionManager;
   boost::asio::ip::tcp::resolver _resolver;
   /// The resolver service;
+  OSS::mutex_critic_sec _resolverMutex;
 
-  boost::thread* _pServerThread;
   boost::thread* _pClientThread;
 };
 
@@ -141,6 +195,11 @@ protected:
 // Inlines
 //
 
+inline std::size_t SIPWebSocketListener::getThreadCount() const
+{
+  return _threadCount;
+}
+
 } } // OSS::SIP
 
 #endif // ENABLE_FEATURE_WEBSOCKETS
@@ -0,0 +1,120 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_ARENAALLOCATOR_H_INCLUDED
+#define OSS_ARENAALLOCATOR_H_INCLUDED
+
+#include <new>
+#include <limits>
+#include "OSS/UTL/MemoryArena.h"
+
+namespace OSS {
+
+template <typename T>
+class ArenaAllocator
+  /// Standard allocator over a MemoryArena.  Every copy holds a reference
+  /// to the arena.  Given to boost::allocate_shared the copy kept in the
+  /// control block keeps the arena alive until the object is destroyed.
+  /// Deallocation is a no-op.  The memory is reclaimed with the arena.
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind
+  {
+    typedef ArenaAllocator<U> other;
+  };
+
+  explicit ArenaAllocator(const MemoryArena::Ptr& arena) :
+    _arena(arena)
+  {
+  }
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& allocator) :
+    _arena(allocator.arena())
+  {
+  }
+
+  pointer address(reference value) const
+  {
+    return &value;
+  }
+
+  const_pointer address(const_reference value) const
+  {
+    return &value;
+  }
+
+  pointer allocate(size_type count, const void* = 0)
+  {
+    return static_cast<pointer>(_arena->allocate(count * sizeof(T)));
+  }
+
+  void deallocate(pointer, size_type)
+  {
+  }
+
+  size_type max_size() const
+  {
+    return std::numeric_limits<size_type>::max() / sizeof(T);
+  }
+
+  void construct(pointer ptr, const T& value)
+  {
+    ::new(static_cast<void*>(ptr)) T(value);
+  }
+
+  void destroy(pointer ptr)
+  {
+    ptr->~T();
+  }
+
+  const MemoryArena::Ptr& arena() const
+  {
+    return _arena;
+  }
+
+private:
+  MemoryArena::Ptr _arena;
+};
+
+template <typename T, typename U>
+inline bool operator == (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator != (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+  return a.arena() != b.arena();
+}
+
+} // OSS
+
+#endif // OSS_ARENAALLOCATOR_H_INCLUDED
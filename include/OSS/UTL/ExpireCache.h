@@ -0,0 +1,351 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_EXPIRECACHE_H_INCLUDED
+#define OSS_EXPIRECACHE_H_INCLUDED
+
+
+#include <deque>
+#include <boost/array.hpp>
+#include <boost/atomic.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+
+
+template <typename Key_T, typename Value_T>
+class ExpireCache : private boost::noncopyable
+  /// Sharded cache whose entries expire a fixed time after they were last
+  /// added.
+  ///
+  /// Each shard owns its own read-write mutex so lookups on unrelated keys
+  /// never contend.  Because every entry lives for the same duration, the
+  /// order in which keys are added is also the order in which they expire.
+  /// Each shard keeps that order in a queue and a sweep only looks at the
+  /// front of it, so expiry costs nothing for entries that are not due.
+  /// Every add, pop and lookup sweeps its shard once the front is due.
+  /// Lookups only sweep when the write lock is free so readers never wait
+  /// on each other.  Expired entries that were not swept yet are reported
+  /// as misses.
+{
+public:
+  enum
+  {
+    SHARD_COUNT = 32
+  };
+
+  typedef OSS::UInt64 (*Clock)();
+
+  ExpireCache(OSS::UInt64 expireInMilliseconds, Clock clock = OSS::getTime);
+    /// Create a cache whose entries live for expireInMilliseconds.  The
+    /// clock returns the current time in milliseconds.
+
+  void add(const Key_T& key, const Value_T& value);
+    /// Insert or overwrite the value of key and restart its lifetime
+
+  bool get(const Key_T& key, Value_T& value) const;
+    /// Copy the value of key.  Returns false if the key is missing or expired.
+
+  bool pop(const Key_T& key, Value_T& value);
+    /// Copy the value of key and remove it.  Returns false if the key is
+    /// missing or expired.
+
+  bool has(const Key_T& key) const;
+    /// Return true if the key is in cache and has not expired
+
+  void remove(const Key_T& key);
+    /// Erase the key
+
+  void clear();
+    /// Erase all entries
+
+  std::size_t size() const;
+    /// Return the number of entries including those that expired but were
+    /// not swept yet
+
+  std::size_t sweep();
+    /// Remove expired entries from every shard and return how many were
+    /// removed
+
+  OSS::UInt64 getExpireTime() const;
+    /// Return the lifetime of an entry in milliseconds
+
+  OSS::UInt64 getHits() const;
+    /// Number of lookups that found a live entry
+
+  OSS::UInt64 getMisses() const;
+    /// Number of lookups that found nothing or an expired entry
+
+  OSS::UInt64 getEvictions() const;
+    /// Number of entries removed because they expired
+
+private:
+  struct Entry
+  {
+    Value_T value;
+    OSS::UInt64 deadline;
+  };
+
+  struct Expiry
+  {
+    Key_T key;
+    OSS::UInt64 deadline;
+  };
+
+  typedef boost::unordered_map<Key_T, Entry> EntryMap;
+  typedef std::deque<Expiry> ExpiryQueue;
+
+  struct Shard
+  {
+    mutable OSS::mutex_read_write mutex;
+    EntryMap entries;
+    ExpiryQueue expiry;
+  };
+
+  Shard& shard(const Key_T& key) const;
+  std::size_t sweepShard(Shard& shard, OSS::UInt64 now) const;
+  static bool isDue(const Shard& shard, OSS::UInt64 now);
+  bool lookup(const Key_T& key, Value_T* value) const;
+
+  mutable boost::array<Shard, SHARD_COUNT> _shards;
+  OSS::UInt64 _expireTime;
+  Clock _clock;
+  mutable boost::atomic<OSS::UInt64> _hits;
+  mutable boost::atomic<OSS::UInt64> _misses;
+  mutable boost::atomic<OSS::UInt64> _evictions;
+};
+
+
+//
+// Inlines
+//
+
+template <typename Key_T, typename Value_T>
+ExpireCache<Key_T, Value_T>::ExpireCache(OSS::UInt64 expireInMilliseconds, Clock clock) :
+  _expireTime(expireInMilliseconds),
+  _clock(clock),
+  _hits(0),
+  _misses(0),
+  _evictions(0)
+{
+}
+
+template <typename Key_T, typename Value_T>
+typename ExpireCache<Key_T, Value_T>::Shard& ExpireCache<Key_T, Value_T>::shard(const Key_T& key) const
+{
+  return _shards[boost::hash<Key_T>()(key) % SHARD_COUNT];
+}
+
+template <typename Key_T, typename Value_T>
+bool ExpireCache<Key_T, Value_T>::isDue(const Shard& shard, OSS::UInt64 now)
+{
+  return !shard.expiry.empty() && shard.expiry.front().deadline <= now;
+}
+
+template <typename Key_T, typename Value_T>
+std::size_t ExpireCache<Key_T, Value_T>::sweepShard(Shard& shard, OSS::UInt64 now) const
+{
+  std::size_t evicted = 0;
+  while (isDue(shard, now))
+  {
+    const Expiry& expiry = shard.expiry.front();
+    typename EntryMap::iterator iter = shard.entries.find(expiry.key);
+    //
+    // A key that was added again carries a later deadline and has a newer
+    // record further down the queue
+    //
+    if (iter != shard.entries.end() && iter->second.deadline == expiry.deadline)
+    {
+      shard.entries.erase(iter);
+      ++evicted;
+    }
+    shard.expiry.pop_front();
+  }
+  if (evicted)
+    _evictions.fetch_add(evicted, boost::memory_order_relaxed);
+  return evicted;
+}
+
+template <typename Key_T, typename Value_T>
+void ExpireCache<Key_T, Value_T>::add(const Key_T& key, const Value_T& value)
+{
+  OSS::UInt64 now = _clock();
+  Expiry expiry;
+  expiry.key = key;
+  expiry.deadline = now + _expireTime;
+
+  Shard& target = shard(key);
+  OSS::mutex_write_lock lock(target.mutex);
+  sweepShard(target, now);
+  Entry& entry = target.entries[key];
+  entry.value = value;
+  entry.deadline = expiry.deadline;
+  target.expiry.push_back(expiry);
+}
+
+template <typename Key_T, typename Value_T>
+bool ExpireCache<Key_T, Value_T>::lookup(const Key_T& key, Value_T* value) const
+{
+  OSS::UInt64 now = _clock();
+  Shard& target = shard(key);
+  bool found = false;
+  bool due = false;
+  {
+    OSS::mutex_read_lock lock(target.mutex);
+    typename EntryMap::const_iterator iter = target.entries.find(key);
+    if (iter != target.entries.end() && iter->second.deadline > now)
+    {
+      if (value)
+        *value = iter->second.value;
+      found = true;
+    }
+    due = isDue(target, now);
+  }
+
+  if (due)
+  {
+    //
+    // Leave the sweep to the next caller if another thread holds the shard
+    //
+    boost::unique_lock<OSS::mutex_read_write> lock(target.mutex, boost::try_to_lock);
+    if (lock.owns_lock())
+      sweepShard(target, now);
+  }
+
+  if (found)
+    _hits.fetch_add(1, boost::memory_order_relaxed);
+  else
+    _misses.fetch_add(1, boost::memory_order_relaxed);
+  return found;
+}
+
+template <typename Key_T, typename Value_T>
+bool ExpireCache<Key_T, Value_T>::get(const Key_T& key, Value_T& value) const
+{
+  return lookup(key, &value);
+}
+
+template <typename Key_T, typename Value_T>
+bool ExpireCache<Key_T, Value_T>::has(const Key_T& key) const
+{
+  return lookup(key, 0);
+}
+
+template <typename Key_T, typename Value_T>
+bool ExpireCache<Key_T, Value_T>::pop(const Key_T& key, Value_T& value)
+{
+  OSS::UInt64 now = _clock();
+  Shard& target = shard(key);
+  {
+    OSS::mutex_write_lock lock(target.mutex);
+    sweepShard(target, now);
+    typename EntryMap::iterator iter = target.entries.find(key);
+    if (iter != target.entries.end())
+    {
+      value = iter->second.value;
+      target.entries.erase(iter);
+      _hits.fetch_add(1, boost::memory_order_relaxed);
+      return true;
+    }
+  }
+  _misses.fetch_add(1, boost::memory_order_relaxed);
+  return false;
+}
+
+template <typename Key_T, typename Value_T>
+void ExpireCache<Key_T, Value_T>::remove(const Key_T& key)
+{
+  //
+  // The expiry record stays queued and is discarded by the sweep
+  //
+  Shard& target = shard(key);
+  OSS::mutex_write_lock lock(target.mutex);
+  target.entries.erase(key);
+}
+
+template <typename Key_T, typename Value_T>
+void ExpireCache<Key_T, Value_T>::clear()
+{
+  for (std::size_t i = 0; i < SHARD_COUNT; i++)
+  {
+    OSS::mutex_write_lock lock(_shards[i].mutex);
+    _shards[i].entries.clear();
+    _shards[i].expiry.clear();
+  }
+}
+
+template <typename Key_T, typename Value_T>
+std::size_t ExpireCache<Key_T, Value_T>::size() const
+{
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < SHARD_COUNT; i++)
+  {
+    OSS::mutex_read_lock lock(_shards[i].mutex);
+    count += _shards[i].entries.size();
+  }
+  return count;
+}
+
+template <typename Key_T, typename Value_T>
+std::size_t ExpireCache<Key_T, Value_T>::sweep()
+{
+  OSS::UInt64 now = _clock();
+  std::size_t evicted = 0;
+  for (std::size_t i = 0; i < SHARD_COUNT; i++)
+  {
+    OSS::mutex_write_lock lock(_shards[i].mutex);
+    evicted += sweepShard(_shards[i], now);
+  }
+  return evicted;
+}
+
+template <typename Key_T, typename Value_T>
+OSS::UInt64 ExpireCache<Key_T, Value_T>::getExpireTime() const
+{
+  return _expireTime;
+}
+
+template <typename Key_T, typename Value_T>
+OSS::UInt64 ExpireCache<Key_T, Value_T>::getHits() const
+{
+  return _hits.load(boost::memory_order_relaxed);
+}
+
+template <typename Key_T, typename Value_T>
+OSS::UInt64 ExpireCache<Key_T, Value_T>::getMisses() const
+{
+  return _misses.load(boost::memory_order_relaxed);
+}
+
+template <typename Key_T, typename Value_T>
+OSS::UInt64 ExpireCache<Key_T, Value_T>::getEvictions() const
+{
+  return _evictions.load(boost::memory_order_relaxed);
+}
+
+
+} // OSS
+
+#endif // OSS_EXPIRECACHE_H_INCLUDED
@@ -35,6 +35,7 @@
 #include "OSS/JSON/reader.h"
 #include "OSS/JSON/writer.h"
 #include "OSS/JSON/elements.h"
+#include "OSS/UTL/SharedMemoryRing.h"
 
 namespace OSS {
 
@@ -213,8 +214,11 @@ protected:
   int _qid;
 };
 
-typedef IPCQueueReader<IPCMessage> IPCQueueStringReader;
-typedef IPCQueueWriter<IPCMessage> IPCQueueStringWriter;
+typedef SharedMemoryRingReader IPCQueueStringReader;
+typedef SharedMemoryRingWriter IPCQueueStringWriter;
+  /// String queues are carried by a shared memory ring.  Records are
+  /// variable length and are copied once on each side instead of going
+  /// through the fixed size SysV message buffer.
 
 class IPCQueue
 {
@@ -230,7 +234,6 @@ public:
     _type(type),
     _key(-1),
     _fileName(fileName),
-    _qid(-1),
     _pReader(0),
     _pWriter(0)
   {
@@ -252,7 +255,7 @@ public:
       _pWriter = new IPCQueueStringWriter(fileName);
       _open = _pReader->isOpen() && _pWriter->isOpen();
       if (_open)
-        assert(_pReader->getId() == _pWriter->getId());
+        assert(_pReader->getKey() == _pWriter->getKey());
       _key = _pReader->getKey();
     }
   }
@@ -260,7 +263,6 @@ public:
   IPCQueue(key_t key, Type type) :
     _type(type),
     _key(key),
-    _qid(-1),
     _pReader(0),
     _pWriter(0)
   {
@@ -280,7 +282,7 @@ public:
       _pWriter = new IPCQueueStringWriter(_key);
       _open = _pReader->isOpen() && _pWriter->isOpen();
       if (_open)
-        assert(_pReader->getId() == _pWriter->getId());
+        assert(_pReader->getKey() == _pWriter->getKey());
       _key = _pReader->getKey();
     }
   }
@@ -305,39 +307,19 @@ public:
   bool write(const std::string& buff, bool blocking  = true)
   {
     assert((_type == WRITER || _type == READWRITE)  && _pWriter);
-    IPCMessage msg;
-
-    if (buff.size() > msg.size())
-      return false;
-    msg.dataSize = buff.size();
-    msg.datatype = 1;
-    ::memccpy(msg.data, buff.data(), '\0', buff.size());
-    return _pWriter->write(msg, blocking);
+    return _pWriter->write(buff, blocking);
   }
 
   bool read(std::string& buff, bool blocking = true)
   {
     assert((_type == READER || _type == READWRITE) && _pReader);
-    IPCMessage msg;
-    if  (_pReader->read(msg, blocking) && msg.dataSize > 0)
-    {
-      buff = std::string(msg.data, msg.dataSize);
-      return true;
-    }
-    return false;
+    return _pReader->read(buff, blocking) && !buff.empty();
   }
 
   void clear()
   {
     if ((_type == READER || _type == READWRITE) && _pReader)
-    {
-      int qid = _pReader->getId();
-      if (qid != -1)
-      {
-        IPCMessage message;
-        while (msgrcv(_qid, &message, message.size(), 0, IPC_NOWAIT) != -1);
-      }
-    }
+      _pReader->clear();
   }
 
   Type getType() const { return _type; }
@@ -349,7 +331,6 @@ protected:
   key_t _key;
   bool _open;
   std::string _fileName;
-  int _qid;
   IPCQueueStringReader* _pReader;
   IPCQueueStringWriter* _pWriter;
 };
@@ -0,0 +1,155 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_LATENCYHISTOGRAM_H_INCLUDED
+#define OSS_LATENCYHISTOGRAM_H_INCLUDED
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/OSS.h"
+
+namespace OSS {
+
+class LatencyHistogram : boost::noncopyable
+  /// Latency distribution in microseconds laid out like an HDR histogram.
+  /// Samples below 2 * SUB_BUCKET_COUNT get a bucket each.  Above that every
+  /// power of two is split into SUB_BUCKET_COUNT linear sub-buckets so a
+  /// bucket is never wider than 1/SUB_BUCKET_COUNT of its lower bound.
+  /// Buckets stop at 2^MAGNITUDE_COUNT and the last bucket also takes
+  /// everything above its lower bound.  Recording is
+  /// a few relaxed atomic increments so any number of threads may record
+  /// while another takes a snapshot.
+{
+public:
+  enum
+  {
+    SUB_BUCKET_BITS = 3,
+    SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+    MAGNITUDE_COUNT = 32,
+    BUCKET_COUNT = (MAGNITUDE_COUNT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT
+  };
+
+  struct Snapshot
+  {
+    OSS::UInt64 count;
+    OSS::UInt64 sum;
+    OSS::UInt64 max;
+    OSS::UInt64 buckets[BUCKET_COUNT];
+
+    Snapshot() : count(0), sum(0), max(0)
+    {
+      for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+        buckets[i] = 0;
+    }
+
+    OSS::UInt64 mean() const
+    {
+      return count ? sum / count : 0;
+    }
+
+    OSS::UInt64 percentile(double percent) const
+      /// Upper bound of the bucket holding the given percentile.  The
+      /// result is never above the largest recorded sample.
+    {
+      if (!count)
+        return 0;
+      OSS::UInt64 rank = (OSS::UInt64)(count * percent / 100.0);
+      if (rank >= count)
+        rank = count - 1;
+      OSS::UInt64 seen = 0;
+      for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+      {
+        seen += buckets[i];
+        if (seen > rank)
+          return bucketLimit(i) < max ? bucketLimit(i) : max;
+      }
+      return max;
+    }
+  };
+
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  void record(OSS::UInt64 micros)
+  {
+    _buckets[bucketIndex(micros)].fetch_add(1, boost::memory_order_relaxed);
+    _count.fetch_add(1, boost::memory_order_relaxed);
+    _sum.fetch_add(micros, boost::memory_order_relaxed);
+    OSS::UInt64 current = _max.load(boost::memory_order_relaxed);
+    while (micros > current && !_max.compare_exchange_weak(current, micros, boost::memory_order_relaxed))
+    {
+    }
+  }
+
+  void snapshot(Snapshot& snapshot) const
+    /// Samples recorded while the snapshot is taken may be partly counted
+  {
+    snapshot.count = _count.load(boost::memory_order_relaxed);
+    snapshot.sum = _sum.load(boost::memory_order_relaxed);
+    snapshot.max = _max.load(boost::memory_order_relaxed);
+    for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+      snapshot.buckets[i] = _buckets[i].load(boost::memory_order_relaxed);
+  }
+
+  void reset()
+  {
+    _count.store(0, boost::memory_order_relaxed);
+    _sum.store(0, boost::memory_order_relaxed);
+    _max.store(0, boost::memory_order_relaxed);
+    for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+      _buckets[i].store(0, boost::memory_order_relaxed);
+  }
+
+  static std::size_t bucketIndex(OSS::UInt64 micros)
+  {
+    if (micros < 2 * SUB_BUCKET_COUNT)
+      return (std::size_t)micros;
+    if (micros >> MAGNITUDE_COUNT)
+      return BUCKET_COUNT - 1;
+
+    //
+    // The top SUB_BUCKET_BITS + 1 bits of the sample pick the bucket
+    //
+    std::size_t magnitude = 63 - __builtin_clzll(micros);
+    std::size_t shift = magnitude - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + (std::size_t)((micros >> shift) - SUB_BUCKET_COUNT);
+  }
+
+  static OSS::UInt64 bucketLimit(std::size_t index)
+    /// Exclusive upper bound of a bucket in microseconds
+  {
+    if (index < 2 * SUB_BUCKET_COUNT)
+      return index + 1;
+    std::size_t shift = index / SUB_BUCKET_COUNT - 1;
+    return ((OSS::UInt64)(index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT + 1)) << shift;
+  }
+
+private:
+  boost::atomic<OSS::UInt64> _count;
+  boost::atomic<OSS::UInt64> _sum;
+  boost::atomic<OSS::UInt64> _max;
+  boost::atomic<OSS::UInt64> _buckets[BUCKET_COUNT];
+};
+
+} // OSS
+
+#endif // OSS_LATENCYHISTOGRAM_H_INCLUDED
@@ -0,0 +1,392 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_LOCKFREEQUEUE_H_INCLUDED
+#define OSS_LOCKFREEQUEUE_H_INCLUDED
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace OSS {
+
+#define OSS_QUEUE_CACHE_LINE_SIZE 64
+
+inline std::size_t lockfree_queue_capacity(std::size_t capacity)
+  /// Rounds capacity up to the next power of two so ring positions can be
+  /// masked instead of divided
+{
+  std::size_t size = 2;
+  while (size < capacity)
+    size <<= 1;
+  return size;
+}
+
+inline void lockfree_queue_raise_watermark(boost::atomic<std::size_t>& watermark, std::size_t depth)
+{
+  std::size_t current = watermark.load(boost::memory_order_relaxed);
+  while (depth > current && !watermark.compare_exchange_weak(current, depth, boost::memory_order_relaxed))
+  {
+  }
+}
+
+template <typename T>
+class SPSCRing : boost::noncopyable
+  /// Bounded ring for exactly one producer thread and one consumer thread.
+  /// Each side keeps a private copy of the other side's position and only
+  /// reads the shared one when its copy says the ring is full or empty.
+{
+public:
+  SPSCRing(std::size_t capacity) :
+    _buffer(lockfree_queue_capacity(capacity)),
+    _mask(_buffer.size() - 1),
+    _head(0),
+    _tailCache(0),
+    _tail(0),
+    _headCache(0),
+    _highWatermark(0)
+  {
+  }
+
+  bool try_enqueue(const T& data)
+    /// Returns false if the ring is full.  Producer thread only.
+  {
+    std::size_t tail = _tail.load(boost::memory_order_relaxed);
+    if (tail - _headCache > _mask)
+    {
+      _headCache = _head.load(boost::memory_order_acquire);
+      if (tail - _headCache > _mask)
+        return false;
+    }
+
+    _buffer[tail & _mask] = data;
+    _tail.store(tail + 1, boost::memory_order_release);
+
+    std::size_t depth = tail + 1 - _headCache;
+    if (depth > _highWatermark.load(boost::memory_order_relaxed))
+    {
+      lockfree_queue_raise_watermark(_highWatermark, tail + 1 - _head.load(boost::memory_order_relaxed));
+    }
+    return true;
+  }
+
+  bool try_dequeue(T& data)
+    /// Returns false if the ring is empty.  Consumer thread only.
+  {
+    std::size_t head = _head.load(boost::memory_order_relaxed);
+    if (head == _tailCache)
+    {
+      _tailCache = _tail.load(boost::memory_order_acquire);
+      if (head == _tailCache)
+        return false;
+    }
+
+    T& slot = _buffer[head & _mask];
+    data = slot;
+    //
+    // Do not keep a reference to the element alive in the ring
+    //
+    slot = T();
+    _head.store(head + 1, boost::memory_order_release);
+    return true;
+  }
+
+  std::size_t size() const
+  {
+    std::size_t head = _head.load(boost::memory_order_acquire);
+    std::size_t tail = _tail.load(boost::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  std::size_t capacity() const
+  {
+    return _mask + 1;
+  }
+
+  std::size_t getHighWatermark() const
+  {
+    return _highWatermark.load(boost::memory_order_relaxed);
+  }
+
+private:
+  std::vector<T> _buffer;
+  const std::size_t _mask;
+  char _pad0[OSS_QUEUE_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _head;
+  std::size_t _tailCache;
+  char _pad1[OSS_QUEUE_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _tail;
+  std::size_t _headCache;
+  char _pad2[OSS_QUEUE_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _highWatermark;
+};
+
+template <typename T>
+class MPMCRing : boost::noncopyable
+  /// Bounded ring for any number of producers and consumers.  Every slot
+  /// carries a sequence number that tells a producer whether the slot is
+  /// free and a consumer whether it has been filled, so claiming a slot
+  /// is a single compare-and-swap on the shared position.
+{
+public:
+  MPMCRing(std::size_t capacity) :
+    _mask(lockfree_queue_capacity(capacity) - 1),
+    _cells(new Cell[_mask + 1]),
+    _head(0),
+    _tail(0),
+    _highWatermark(0)
+  {
+    for (std::size_t i = 0; i <= _mask; i++)
+      _cells[i].sequence.store(i, boost::memory_order_relaxed);
+  }
+
+  ~MPMCRing()
+  {
+    delete [] _cells;
+  }
+
+  bool try_enqueue(const T& data)
+    /// Returns false if the ring is full
+  {
+    Cell* cell;
+    std::size_t pos = _tail.load(boost::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &_cells[pos & _mask];
+      std::size_t sequence = cell->sequence.load(boost::memory_order_acquire);
+      long diff = (long)sequence - (long)pos;
+      if (diff == 0)
+      {
+        if (_tail.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = _tail.load(boost::memory_order_relaxed);
+      }
+    }
+
+    cell->data = data;
+    cell->sequence.store(pos + 1, boost::memory_order_release);
+
+    std::size_t head = _head.load(boost::memory_order_relaxed);
+    if (pos + 1 > head)
+    {
+      std::size_t depth = pos + 1 - head;
+      if (depth > _highWatermark.load(boost::memory_order_relaxed))
+        lockfree_queue_raise_watermark(_highWatermark, depth);
+    }
+    return true;
+  }
+
+  bool try_dequeue(T& data)
+    /// Returns false if the ring is empty
+  {
+    Cell* cell;
+    std::size_t pos = _head.load(boost::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &_cells[pos & _mask];
+      std::size_t sequence = cell->sequence.load(boost::memory_order_acquire);
+      long diff = (long)sequence - (long)(pos + 1);
+      if (diff == 0)
+      {
+        if (_head.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = _head.load(boost::memory_order_relaxed);
+      }
+    }
+
+    data = cell->data;
+    cell->data = T();
+    cell->sequence.store(pos + _mask + 1, boost::memory_order_release);
+    return true;
+  }
+
+  std::size_t size() const
+  {
+    std::size_t head = _head.load(boost::memory_order_acquire);
+    std::size_t tail = _tail.load(boost::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  std::size_t capacity() const
+  {
+    return _mask + 1;
+  }
+
+  std::size_t getHighWatermark() const
+  {
+    return _highWatermark.load(boost::memory_order_relaxed);
+  }
+
+private:
+  struct Cell
+  {
+    boost::atomic<std::size_t> sequence;
+    T data;
+  };
+
+  const std::size_t _mask;
+  Cell* _cells;
+  char _pad0[OSS_QUEUE_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _head;
+  char _pad1[OSS_QUEUE_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _tail;
+  char _pad2[OSS_QUEUE_CACHE_LINE_SIZE];
+  boost::atomic<std::size_t> _highWatermark;
+};
+
+template <typename T, typename Ring_T = MPMCRing<T> >
+class LockFreeQueue : boost::noncopyable
+  /// A bounded queue with the same enqueue/dequeue interface as
+  /// BlockingQueue.  Elements move through a lock-free ring.  A consumer
+  /// only sleeps when it finds the ring empty, and a producer only takes
+  /// the wait mutex when it sees a sleeping consumer, so the mutex and
+  /// the condition variable stay off the path while the consumer keeps up.
+{
+public:
+  enum { DEFAULT_CAPACITY = 4096 };
+
+  LockFreeQueue(std::size_t capacity = DEFAULT_CAPACITY) :
+    _ring(capacity),
+    _waiters(0)
+  {
+  }
+
+  bool enqueue(const T& data)
+    /// Returns false if the queue is full
+  {
+    if (!_ring.try_enqueue(data))
+      return false;
+
+    //
+    // Pairs with the fence in wait().  Either the consumer sees the new
+    // element before it sleeps or we see it registered as a waiter.
+    //
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (_waiters.load(boost::memory_order_relaxed) > 0)
+    {
+      boost::lock_guard<boost::mutex> lock(_waitMutex);
+      _condition.notify_one();
+    }
+    return true;
+  }
+
+  bool try_dequeue(T& data)
+    /// Returns immediately.  Returns false if the queue is empty.
+  {
+    return _ring.try_dequeue(data);
+  }
+
+  void dequeue(T& data)
+    /// Waits until an element is available
+  {
+    while (!_ring.try_dequeue(data))
+      wait(-1);
+  }
+
+  bool try_dequeue(T& data, long milliseconds)
+    /// Waits up to milliseconds for an element
+  {
+    if (_ring.try_dequeue(data))
+      return true;
+
+    boost::system_time const deadline = boost::get_system_time() + boost::posix_time::milliseconds(milliseconds);
+    for (;;)
+    {
+      long remaining = (deadline - boost::get_system_time()).total_milliseconds();
+      if (remaining < 0 || !wait(remaining))
+        return _ring.try_dequeue(data);
+      if (_ring.try_dequeue(data))
+        return true;
+    }
+  }
+
+  std::size_t size() const
+    /// Current depth of the queue
+  {
+    return _ring.size();
+  }
+
+  std::size_t capacity() const
+  {
+    return _ring.capacity();
+  }
+
+  std::size_t getHighWatermark() const
+    /// The deepest the queue has been since it was created
+  {
+    return _ring.getHighWatermark();
+  }
+
+  void clear()
+  {
+    T data;
+    while (_ring.try_dequeue(data))
+    {
+    }
+  }
+
+private:
+  bool wait(long milliseconds)
+    /// Sleeps until a producer signals or the ring is no longer empty.
+    /// A negative value waits without a time limit.  Returns false on
+    /// timeout.
+  {
+    boost::unique_lock<boost::mutex> lock(_waitMutex);
+    _waiters.fetch_add(1, boost::memory_order_relaxed);
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+    bool signalled = true;
+    if (_ring.size() == 0)
+    {
+      if (milliseconds < 0)
+        _condition.wait(lock);
+      else
+        signalled = _condition.timed_wait(lock, boost::posix_time::milliseconds(milliseconds));
+    }
+
+    _waiters.fetch_sub(1, boost::memory_order_relaxed);
+    return signalled;
+  }
+
+  Ring_T _ring;
+  boost::atomic<int> _waiters;
+  boost::mutex _waitMutex;
+  boost::condition_variable _condition;
+};
+
+} // OSS
+
+#endif //OSS_LOCKFREEQUEUE_H_INCLUDED
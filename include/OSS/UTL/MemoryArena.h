@@ -0,0 +1,76 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_MEMORYARENA_H_INCLUDED
+#define OSS_MEMORYARENA_H_INCLUDED
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/SlabPool.h"
+
+namespace OSS {
+
+class OSS_API MemoryArena : boost::noncopyable
+  /// Region for objects that share a lifetime such as the state of one
+  /// transaction.  Allocating bumps a pointer in the current chunk and
+  /// freeing does nothing.  Chunks come from a slab pool and all go back
+  /// to it at once when the arena is destroyed, so the memory is accounted
+  /// to the subsystem of that pool.
+  ///
+  /// Objects are placed in an arena with ArenaAllocator, usually through
+  /// boost::allocate_shared.  The allocator holds a reference to the arena
+  /// so the region outlives every object in it, even one still referenced
+  /// after its owner is gone.
+{
+public:
+  typedef boost::shared_ptr<MemoryArena> Ptr;
+
+  explicit MemoryArena(SlabPool& chunks);
+    /// Chunks are blocks of the pool.  Requests that do not fit in a block
+    /// get a chunk of their own.
+
+  ~MemoryArena();
+
+  void* allocate(std::size_t size);
+    /// Returns memory aligned for any type or throws std::bad_alloc
+
+  std::size_t getUsedBytes() const;
+    /// Bytes handed out so far including alignment padding
+
+private:
+  struct Chunk
+  {
+    Chunk* next;
+    std::size_t size;
+  };
+
+  SlabPool& _chunks;
+  mutable OSS::mutex_critic_sec _mutex;
+  Chunk* _pChunks;
+  char* _pNext;
+  char* _pEnd;
+  std::size_t _usedBytes;
+};
+
+} // OSS
+
+#endif // OSS_MEMORYARENA_H_INCLUDED
@@ -0,0 +1,99 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_METRICCOUNTER_H_INCLUDED
+#define OSS_METRICCOUNTER_H_INCLUDED
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include "OSS/OSS.h"
+
+namespace OSS {
+
+class MetricCounter : boost::noncopyable
+  /// Counter for hot paths.  The value is split into stripes that each sit
+  /// on their own cache line.  A thread always adds to the same stripe so
+  /// threads on different cores do not fight over one line.  Reading sums
+  /// the stripes and never blocks the writers.
+  ///
+  /// Counters only go up.  Gauges also use decrement.  A single stripe may
+  /// wrap below zero but the sum of the stripes is exact.
+{
+public:
+  enum
+  {
+    STRIPE_COUNT = 16,
+    CACHE_LINE_SIZE = 64
+  };
+
+  MetricCounter()
+  {
+    reset();
+  }
+
+  void increment(OSS::UInt64 value = 1)
+  {
+    _stripes[stripeIndex()].value.fetch_add(value, boost::memory_order_relaxed);
+  }
+
+  void decrement(OSS::UInt64 value = 1)
+  {
+    _stripes[stripeIndex()].value.fetch_sub(value, boost::memory_order_relaxed);
+  }
+
+  OSS::UInt64 value() const
+    /// Increments made while the stripes are summed may be partly counted
+  {
+    OSS::UInt64 total = 0;
+    for (std::size_t i = 0; i < STRIPE_COUNT; i++)
+      total += _stripes[i].value.load(boost::memory_order_relaxed);
+    return total;
+  }
+
+  void reset()
+  {
+    for (std::size_t i = 0; i < STRIPE_COUNT; i++)
+      _stripes[i].value.store(0, boost::memory_order_relaxed);
+  }
+
+  static std::size_t stripeIndex()
+    /// Threads are given stripes round robin the first time they count
+  {
+    static boost::atomic<std::size_t> next(0);
+    static __thread std::size_t index = 0;
+    if (!index)
+      index = (next.fetch_add(1, boost::memory_order_relaxed) % STRIPE_COUNT) + 1;
+    return index - 1;
+  }
+
+private:
+  struct Stripe
+  {
+    boost::atomic<OSS::UInt64> value;
+    char pad[CACHE_LINE_SIZE - sizeof(boost::atomic<OSS::UInt64>)];
+  };
+
+  Stripe _stripes[STRIPE_COUNT];
+};
+
+} // OSS
+
+#endif // OSS_METRICCOUNTER_H_INCLUDED
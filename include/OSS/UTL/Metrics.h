@@ -0,0 +1,128 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_METRICS_H_INCLUDED
+#define OSS_METRICS_H_INCLUDED
+
+#include <map>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/MetricCounter.h"
+#include "OSS/UTL/LatencyHistogram.h"
+
+namespace OSS {
+
+class OSS_API Metrics : boost::noncopyable
+  /// Registry of the counters, gauges and latency histograms kept by the
+  /// stack.  Metrics are created the first time they are asked for and live
+  /// as long as the registry, so callers look them up once and keep the
+  /// reference.
+  /// Updating a metric never takes the registry lock.  Snapshots are
+  /// rendered while traffic keeps flowing.
+  ///
+  /// Histograms are in microseconds.  Names follow the Prometheus naming
+  /// rules so the same name is used in both renderings.
+{
+public:
+  class Timer : boost::noncopyable
+    /// Records the time between construction and destruction
+  {
+  public:
+    Timer(LatencyHistogram& histogram);
+    ~Timer();
+  private:
+    LatencyHistogram& _histogram;
+    OSS::UInt64 _start;
+  };
+
+  Metrics();
+
+  ~Metrics();
+
+  static Metrics& instance();
+    /// The registry shared by the stack.  It is never destroyed so objects
+    /// released during static destruction can still update it.
+
+  MetricCounter& counter(const std::string& name, const std::string& help = std::string());
+    /// Returns the counter with this name.  The help text of the first
+    /// call is kept.
+
+  MetricCounter& gauge(const std::string& name, const std::string& help = std::string());
+    /// Returns the gauge with this name.  Gauges hold a current level such
+    /// as live bytes and move both ways.  The help text of the first call
+    /// is kept.
+
+  LatencyHistogram& histogram(const std::string& name, const std::string& help = std::string());
+    /// Returns the histogram with this name.  The help text of the first
+    /// call is kept.
+
+  void toJson(std::string& json) const;
+    /// Renders counters and gauges with their value and histograms with
+    /// their count, sum, max, mean and common percentiles
+
+  void toPrometheus(std::string& text) const;
+    /// Renders the Prometheus text exposition format.  Histogram buckets
+    /// are cumulative with inclusive upper bounds in microseconds.
+
+  void reset();
+    /// Zeroes every counter and histogram without removing it.  Gauges
+    /// track live state and are left alone.
+
+  static OSS::UInt64 now();
+    /// Monotonic clock in microseconds for measuring latency
+
+private:
+  template <typename T>
+  struct Entry
+  {
+    std::string help;
+    boost::shared_ptr<T> metric;
+  };
+  typedef std::map<std::string, Entry<MetricCounter> > Counters;
+  typedef std::map<std::string, Entry<LatencyHistogram> > Histograms;
+
+  mutable OSS::mutex_critic_sec _mutex;
+  Counters _counters;
+  Counters _gauges;
+  Histograms _histograms;
+};
+
+//
+// Inlines
+//
+
+inline Metrics::Timer::Timer(LatencyHistogram& histogram) :
+  _histogram(histogram),
+  _start(Metrics::now())
+{
+}
+
+inline Metrics::Timer::~Timer()
+{
+  _histogram.record(Metrics::now() - _start);
+}
+
+} // OSS
+
+#endif // OSS_METRICS_H_INCLUDED
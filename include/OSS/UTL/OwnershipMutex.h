@@ -0,0 +1,136 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_OWNERSHIPMUTEX_H_INCLUDED
+#define OSS_OWNERSHIPMUTEX_H_INCLUDED
+
+#include <cassert>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+namespace OSS {
+
+class OwnershipMutex : boost::noncopyable
+  /// Read-write mutex for objects that are usually owned by one thread at
+  /// a time.  In shared mode it locks a boost::shared_mutex.  In single
+  /// owner mode locking does nothing.  The object is then only reachable by
+  /// its owning thread and moves to the next owner through a queue, a post
+  /// or a call, and that handoff already orders the memory accesses.
+  ///
+  /// An owner that is about to make the object reachable by other threads
+  /// switches it to shared mode first.
+  ///
+  /// Debug builds record which thread holds a single owner object and
+  /// assert when a second thread enters while the first is still inside.
+  /// Nested locking by the owning thread is allowed.
+{
+public:
+  explicit OwnershipMutex(bool singleOwner = false) :
+    _singleOwner(singleOwner),
+    _depth(0)
+  {
+  }
+
+  void setSingleOwner(bool singleOwner)
+    /// Only the owning thread may switch modes and only while it does not
+    /// hold the lock
+  {
+#ifndef NDEBUG
+    {
+      boost::mutex::scoped_lock guard(_ownerMutex);
+      assert(_depth == 0);
+    }
+#endif
+    _singleOwner = singleOwner;
+  }
+
+  bool isSingleOwner() const
+  {
+    return _singleOwner;
+  }
+
+  void lock()
+  {
+    if (_singleOwner)
+      enter();
+    else
+      _mutex.lock();
+  }
+
+  void unlock()
+  {
+    if (_singleOwner)
+      leave();
+    else
+      _mutex.unlock();
+  }
+
+  void lock_shared()
+  {
+    if (_singleOwner)
+      enter();
+    else
+      _mutex.lock_shared();
+  }
+
+  void unlock_shared()
+  {
+    if (_singleOwner)
+      leave();
+    else
+      _mutex.unlock_shared();
+  }
+
+private:
+  void enter()
+  {
+#ifndef NDEBUG
+    boost::mutex::scoped_lock guard(_ownerMutex);
+    boost::thread::id self = boost::this_thread::get_id();
+    //
+    // Another thread is inside a single owner object.  The object was
+    // handed over without switching it to shared mode.
+    //
+    assert(_depth == 0 || _owner == self);
+    _owner = self;
+    _depth++;
+#endif
+  }
+
+  void leave()
+  {
+#ifndef NDEBUG
+    boost::mutex::scoped_lock guard(_ownerMutex);
+    assert(_depth > 0);
+    _depth--;
+#endif
+  }
+
+  boost::shared_mutex _mutex;
+  bool _singleOwner;
+  boost::mutex _ownerMutex;
+  boost::thread::id _owner;
+  int _depth;
+};
+
+} // OSS
+
+#endif // OSS_OWNERSHIPMUTEX_H_INCLUDED
@@ -20,6 +20,8 @@
 #ifndef PROPERTYMAP_H_INCLUDED
 #define	PROPERTYMAP_H_INCLUDED
 
+#include <string>
+
 namespace OSS {
 
 struct PropertyMap
@@ -149,6 +151,22 @@ struct PropertyMap
     
     return ret;
   }
+
+  static PropertyMap::Enum propertyEnum(const std::string& name)
+    /// returns the property whose string representation is name or
+    /// PROP_Max if name is not one of the predefined properties
+  {
+    static const char* prop_map[] = PROP_MAP_STRINGS;
+    if (name.empty())
+      return PROP_Max;
+
+    for (int i = 0; i < PROP_Max; i++)
+    {
+      if (prop_map[i][0] == name[0] && name == prop_map[i])
+        return (PropertyMap::Enum)i;
+    }
+    return PROP_Max;
+  }
 };
 
 } // namespace OSS
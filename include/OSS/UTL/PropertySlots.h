@@ -0,0 +1,183 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_PROPERTYSLOTS_H_INCLUDED
+#define OSS_PROPERTYSLOTS_H_INCLUDED
+
+#include <cstring>
+#include <string>
+#include <boost/static_assert.hpp>
+#include "OSS/OSS.h"
+
+namespace OSS {
+
+template <std::size_t SlotCount, std::size_t InlineSize = 23>
+class PropertySlots
+  /// Fixed set of string properties addressed by index.  A bitmask records
+  /// which slots hold a value so presence tests never touch the slots.
+  /// Values up to InlineSize characters are stored inside the slot.  Longer
+  /// values spill to a string on the heap that is kept for reuse when the
+  /// slot is overwritten or cleared.  The slot array itself is allocated
+  /// the first time a value is set so an object that never carries a
+  /// property costs only the mask and a pointer.
+{
+public:
+  BOOST_STATIC_ASSERT(SlotCount <= 64);
+  BOOST_STATIC_ASSERT(InlineSize < 256);
+
+  PropertySlots() :
+    _mask(0),
+    _slots(0)
+  {
+  }
+
+  PropertySlots(const PropertySlots& slots) :
+    _mask(0),
+    _slots(0)
+  {
+    assign(slots);
+  }
+
+  ~PropertySlots()
+  {
+    if (!_slots)
+      return;
+    for (std::size_t i = 0; i < SlotCount; i++)
+      delete _slots[i].spill;
+    delete [] _slots;
+  }
+
+  PropertySlots& operator=(const PropertySlots& slots)
+  {
+    if (this != &slots)
+    {
+      clear();
+      assign(slots);
+    }
+    return *this;
+  }
+
+  void set(std::size_t index, const char* value, std::size_t length)
+    /// Store a value.  Indexes past SlotCount are ignored.
+  {
+    if (index >= SlotCount)
+      return;
+    if (!_slots)
+      _slots = new Slot[SlotCount];
+
+    Slot& slot = _slots[index];
+    if (length <= InlineSize)
+    {
+      std::memcpy(slot.local, value, length);
+      slot.length = (OSS::UInt8)length;
+      slot.spilled = false;
+    }
+    else
+    {
+      if (slot.spill)
+        slot.spill->assign(value, length);
+      else
+        slot.spill = new std::string(value, length);
+      slot.spilled = true;
+    }
+    _mask |= bit(index);
+  }
+
+  void set(std::size_t index, const std::string& value)
+  {
+    set(index, value.data(), value.size());
+  }
+
+  bool get(std::size_t index, std::string& value) const
+    /// Copy a value.  Returns false if the slot is empty.
+  {
+    if (!has(index))
+      return false;
+    const Slot& slot = _slots[index];
+    if (slot.spilled)
+      value = *slot.spill;
+    else
+      value.assign(slot.local, slot.length);
+    return true;
+  }
+
+  bool has(std::size_t index) const
+  {
+    return index < SlotCount && (_mask & bit(index)) != 0;
+  }
+
+  void remove(std::size_t index)
+  {
+    if (index < SlotCount)
+      _mask &= ~bit(index);
+  }
+
+  void clear()
+  {
+    _mask = 0;
+  }
+
+  bool empty() const
+  {
+    return _mask == 0;
+  }
+
+  OSS::UInt64 mask() const
+    /// Bit n is set when slot n holds a value
+  {
+    return _mask;
+  }
+
+private:
+  struct Slot
+  {
+    Slot() : spill(0), length(0), spilled(false) {}
+    std::string* spill;
+    OSS::UInt8 length;
+    bool spilled;
+    char local[InlineSize];
+  };
+
+  static OSS::UInt64 bit(std::size_t index)
+  {
+    return ((OSS::UInt64)1) << index;
+  }
+
+  void assign(const PropertySlots& slots)
+  {
+    for (std::size_t i = 0; i < SlotCount; i++)
+    {
+      if (!slots.has(i))
+        continue;
+      const Slot& slot = slots._slots[i];
+      if (slot.spilled)
+        set(i, *slot.spill);
+      else
+        set(i, slot.local, slot.length);
+    }
+  }
+
+  OSS::UInt64 _mask;
+  Slot* _slots;
+};
+
+} // OSS
+
+#endif // OSS_PROPERTYSLOTS_H_INCLUDED
@@ -0,0 +1,197 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_SHAREDMEMORYRING_H_INCLUDED
+#define OSS_SHAREDMEMORYRING_H_INCLUDED
+
+
+#include <sys/types.h>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+
+
+namespace OSS {
+
+
+struct SharedMemoryRingHeader;
+
+
+class SharedMemoryRing : private boost::noncopyable
+  /// Byte ring in a POSIX shared memory segment carrying variable length
+  /// records between processes.
+  ///
+  /// A record is a 32 bit length followed by the payload, padded to eight
+  /// bytes.  A record that does not fit before the end of the buffer is
+  /// preceded by a pad marker and written at the start instead, so the
+  /// payload is always contiguous and is copied exactly once on each side.
+  ///
+  /// The read and write positions live in the segment header.  Writers
+  /// from any process serialize on a robust process shared mutex.  There is
+  /// a single reader which owns the segment.  Sleeping sides wait on a
+  /// futex word in the header and the other side only issues the wake
+  /// system call when it sees a registered sleeper.
+  ///
+  /// The segment name is derived from the same ftok() key the SysV message
+  /// queues used so existing queue paths map to a ring one to one.
+{
+public:
+  enum
+  {
+    DEFAULT_CAPACITY = 1024 * 1024
+  };
+
+  static std::string getSegmentName(key_t key);
+    /// Return the shared memory object name used for key
+
+  const std::string& getQueueName() const;
+    /// Return the path the key was derived from if any
+
+  const key_t& getKey() const;
+    /// Return the ftok() key of the ring
+
+  const int& getId() const;
+    /// Return the file descriptor of the mapped segment
+
+  bool isOpen() const;
+    /// Return true if the segment is mapped and was not closed
+
+  std::size_t capacity() const;
+    /// Return the size of the data area in bytes
+
+  std::size_t getMaxRecordSize() const;
+    /// Return the largest payload a single record can carry
+
+  std::size_t size() const;
+    /// Return the number of bytes waiting to be read
+
+protected:
+  SharedMemoryRing(const std::string& queueName);
+  SharedMemoryRing(key_t key);
+  ~SharedMemoryRing();
+
+  bool create(std::size_t capacity, bool reset);
+  bool attach();
+  void detach();
+  bool isOrphaned() const;
+
+  std::string _queueName;
+  key_t _key;
+  bool _open;
+  int _fd;
+  std::size_t _mappedSize;
+  SharedMemoryRingHeader* _pHeader;
+  char* _pData;
+};
+
+
+class SharedMemoryRingReader : public SharedMemoryRing
+  /// Owning side of a shared memory ring.  The path constructor replaces
+  /// any segment left behind by a previous reader of the same path.
+{
+public:
+  SharedMemoryRingReader(const std::string& queueName, std::size_t capacity = DEFAULT_CAPACITY);
+    /// Create the ring for queueName.  The file is created if it does not
+    /// exist so it can be used as an ftok() path.
+
+  SharedMemoryRingReader(key_t key, std::size_t capacity = DEFAULT_CAPACITY);
+    /// Create or open the ring for key
+
+  ~SharedMemoryRingReader();
+    /// Close and unmap the ring
+
+  void close();
+    /// Mark the ring closed, wake every sleeper and unlink the segment.
+    /// The mapping is kept until destruction so a read blocked in another
+    /// thread returns false instead of touching unmapped memory.
+
+  bool read(std::string& data, bool blocking = true);
+    /// Read the next record.  Returns false if the ring is empty and
+    /// blocking is false, or if the ring was closed.
+
+  void clear();
+    /// Discard every pending record
+};
+
+
+class SharedMemoryRingWriter : public SharedMemoryRing
+  /// Producing side of a shared memory ring.  Any number of writers in any
+  /// number of processes may share a ring.  A writer that finds no ring
+  /// attaches again on the next write, and a writer whose reader went away
+  /// detaches and looks for the reader's new segment.  Writes notice a
+  /// closed reader at once and a replaced one within a second.
+{
+public:
+  SharedMemoryRingWriter(const std::string& queueName);
+    /// Attach to the ring created by the reader of queueName
+
+  SharedMemoryRingWriter(key_t key);
+    /// Attach to the ring created by the reader of key
+
+  ~SharedMemoryRingWriter();
+    /// Unmap the ring.  The segment stays with the reader.
+
+  void close();
+    /// Unmap the ring
+
+  bool write(const char* data, std::size_t len, bool blocking = true);
+    /// Append a record.  Returns false if no reader is attached, if the
+    /// record is larger than getMaxRecordSize(), or if the ring is full and
+    /// blocking is false.
+
+  bool write(const std::string& data, bool blocking = true);
+    /// Append a record
+
+private:
+  bool reattach();
+  OSS::mutex_critic_sec _attachMutex;
+  OSS::UInt64 _orphanCheckTime;
+};
+
+
+//
+// Inlines
+//
+
+inline const std::string& SharedMemoryRing::getQueueName() const
+{
+  return _queueName;
+}
+
+inline const key_t& SharedMemoryRing::getKey() const
+{
+  return _key;
+}
+
+inline const int& SharedMemoryRing::getId() const
+{
+  return _fd;
+}
+
+inline bool SharedMemoryRingWriter::write(const std::string& data, bool blocking)
+{
+  return write(data.data(), data.size(), blocking);
+}
+
+
+} // OSS
+
+#endif // OSS_SHAREDMEMORYRING_H_INCLUDED
@@ -0,0 +1,85 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_SLABALLOCATED_H_INCLUDED
+#define OSS_SLABALLOCATED_H_INCLUDED
+
+#include <new>
+#include "OSS/UTL/SlabPool.h"
+
+namespace OSS {
+
+template <typename T>
+class SlabAllocated
+  /// Base class that serves new and delete of T from a slab pool of
+  /// sizeof(T) blocks.  Classes derived from T are larger and get their
+  /// memory from the heap, still accounted to the pool of T.  Delete must
+  /// see the real size so T needs a virtual destructor if it is deleted
+  /// through a base pointer.
+  ///
+  /// The pool is defined once in the translation unit of T with
+  /// OSS_SLAB_POOL and declared after T with OSS_SLAB_POOL_DECLARE, both at
+  /// global scope.  It is never destroyed so objects released during
+  /// static destruction still have somewhere to go.
+{
+public:
+  static void* operator new(std::size_t size)
+  {
+    if (size == sizeof(T))
+      return pool().allocate();
+    return pool().allocateOversized(size);
+  }
+
+  static void operator delete(void* ptr, std::size_t size)
+  {
+    if (size == sizeof(T))
+      pool().deallocate(ptr);
+    else
+      pool().deallocateOversized(ptr, size);
+  }
+
+  static void* operator new(std::size_t, void* ptr)
+    /// Placement new is not hidden by the class operators
+  {
+    return ptr;
+  }
+
+  static void operator delete(void*, void*)
+  {
+  }
+
+  static SlabPool& pool();
+};
+
+} // OSS
+
+#define OSS_SLAB_POOL_DECLARE(Type) \
+  namespace OSS { template <> SlabPool& SlabAllocated<Type>::pool(); }
+
+#define OSS_SLAB_POOL(Type, name) \
+  namespace OSS { \
+  template <> SlabPool& SlabAllocated<Type>::pool() \
+  { \
+    static SlabPool* pPool = new SlabPool(name, sizeof(Type)); \
+    return *pPool; \
+  } \
+  }
+
+#endif // OSS_SLABALLOCATED_H_INCLUDED
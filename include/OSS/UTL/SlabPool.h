@@ -0,0 +1,153 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#ifndef OSS_SLABPOOL_H_INCLUDED
+#define OSS_SLABPOOL_H_INCLUDED
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "OSS/UTL/Thread.h"
+#include "OSS/UTL/MetricCounter.h"
+
+namespace OSS {
+
+class OSS_API SlabPool : boost::noncopyable
+  /// Fixed size blocks carved out of larger slabs.  Freed blocks go on a
+  /// free list and are handed out again before a new slab is taken, so a
+  /// steady load stops calling the heap once the pool has grown to its
+  /// working size.  Slabs are kept until the pool is destroyed.
+  ///
+  /// Each thread keeps a small cache of free blocks so allocate and
+  /// deallocate do not take the pool lock.  An empty cache takes a batch of
+  /// blocks from the pool and a full one gives a batch back, so the lock is
+  /// taken once per batch.  A thread that frees blocks allocated by another
+  /// thread returns them the same way.  The cache is given back to the pool
+  /// when the thread exits.
+  ///
+  /// Every pool accounts for the memory of one subsystem in the metrics
+  /// registry.  memory_<name>_live_bytes and memory_<name>_live_objects are
+  /// what is in use, memory_<name>_reserved_bytes is what the pool holds
+  /// including free blocks.  Blocks of other sizes that belong to the same
+  /// subsystem go through allocateOversized so they are counted too.
+{
+public:
+  enum
+  {
+    ALIGNMENT = 16,
+    SLAB_SIZE = 64 * 1024,
+    CACHE_BATCH_SIZE = 32
+  };
+
+  SlabPool(const std::string& name, std::size_t blockSize, std::size_t blocksPerSlab = 0);
+    /// Creates a pool of blocks of at least blockSize bytes.  The default
+    /// number of blocks per slab fills SLAB_SIZE.
+
+  ~SlabPool();
+    /// Slabs are only released if no block is in use
+
+  void* allocate();
+    /// Returns a block or throws std::bad_alloc
+
+  void deallocate(void* pBlock);
+
+  void* allocateOversized(std::size_t size);
+    /// Allocates from the heap and accounts the bytes to this pool
+
+  void deallocateOversized(void* pBlock, std::size_t size);
+
+  const std::string& getName() const;
+
+  std::size_t getBlockSize() const;
+
+  OSS::UInt64 getLiveBytes() const;
+
+  OSS::UInt64 getReservedBytes() const;
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  struct ThreadCache
+  {
+    SlabPool* pPool;
+    FreeBlock* freeList;
+    std::size_t count;
+    ThreadCache* pPrev;
+    ThreadCache* pNext;
+  };
+
+  void grow();
+
+  ThreadCache& threadCache();
+
+  void refill(ThreadCache& cache);
+    /// Moves up to a batch of free blocks from the pool to cache
+
+  void drain(ThreadCache& cache, std::size_t count);
+    /// Moves count blocks from cache back to the pool
+
+  static void releaseThreadCache(ThreadCache* pCache);
+    /// Called when a thread exits.  Gives the blocks back to the pool.
+
+  std::string _name;
+  std::size_t _blockSize;
+  std::size_t _blocksPerSlab;
+  std::size_t _batchSize;
+  OSS::mutex_critic_sec _mutex;
+  FreeBlock* _freeList;
+  void* _slabs;
+  boost::thread_specific_ptr<ThreadCache> _threadCache;
+  ThreadCache* _threadCaches;
+  MetricCounter& _liveBytes;
+  MetricCounter& _liveObjects;
+  MetricCounter& _reservedBytes;
+};
+
+//
+// Inlines
+//
+
+inline const std::string& SlabPool::getName() const
+{
+  return _name;
+}
+
+inline std::size_t SlabPool::getBlockSize() const
+{
+  return _blockSize;
+}
+
+inline OSS::UInt64 SlabPool::getLiveBytes() const
+{
+  return _liveBytes.value();
+}
+
+inline OSS::UInt64 SlabPool::getReservedBytes() const
+{
+  return _reservedBytes.value();
+}
+
+} // OSS
+
+#endif // OSS_SLABPOOL_H_INCLUDED
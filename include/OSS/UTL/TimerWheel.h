@@ -0,0 +1,163 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#ifndef OSS_TIMERWHEEL_H_INCLUDED
+#define OSS_TIMERWHEEL_H_INCLUDED
+
+#include <vector>
+#include <boost/array.hpp>
+#include "OSS/OSS.h"
+
+namespace OSS {
+
+template <typename Key>
+class TimerWheel
+  /// Hashed timer wheel for large numbers of coarse timers.  A timer is
+  /// placed in the slot of its deadline and only looked at again when the
+  /// wheel reaches that slot, so advancing costs one slot per tick rather
+  /// than one check per timer.  Timers further out than one revolution sit
+  /// in their slot until a later pass finds them due.
+  ///
+  /// Cancelling is left to the owner.  It drops the key from its own index
+  /// and ignores the stale timer when it comes out of the wheel.
+  ///
+  /// The wheel does no locking.  The owner serializes access.
+{
+public:
+  enum
+  {
+    SLOTS = 512
+  };
+
+  struct Timer
+  {
+    Key key;
+    OSS::UInt64 deadline;
+  };
+
+  typedef std::vector<Timer> TimerList;
+
+  explicit TimerWheel(OSS::UInt64 resolution = 1);
+    /// Creates an empty wheel.  Deadlines and the resolution share a unit.
+
+  void schedule(const Key& key, OSS::UInt64 deadline, OSS::UInt64 now);
+    /// Arm a timer.  The wheel starts at now if this is the first timer.
+    /// A deadline in a slot that was already passed fires on the next tick.
+
+  void advance(OSS::UInt64 now, TimerList& due);
+    /// Move the wheel up to now and append the timers whose deadline passed
+
+  void clear(OSS::UInt64 now);
+    /// Drop every timer and restart the wheel at now
+
+  OSS::UInt64 getResolution() const;
+
+private:
+  typedef std::vector<Timer> Slot;
+
+  boost::array<Slot, SLOTS> _slots;
+  OSS::UInt64 _tick;
+  OSS::UInt64 _resolution;
+};
+
+
+//
+// Inlines
+//
+
+template <typename Key>
+TimerWheel<Key>::TimerWheel(OSS::UInt64 resolution) :
+  _tick(0),
+  _resolution(resolution ? resolution : 1)
+{
+}
+
+template <typename Key>
+void TimerWheel<Key>::schedule(const Key& key, OSS::UInt64 deadline, OSS::UInt64 now)
+{
+  if (!_tick)
+    _tick = now / _resolution;
+
+  //
+  // Round up so that the deadline has passed by the time the wheel reaches
+  // the slot.  Slots up to the current tick have already been visited so
+  // anything due earlier than that goes in the next slot.
+  //
+  OSS::UInt64 tick = (deadline + _resolution - 1) / _resolution;
+  if (tick <= _tick)
+    tick = _tick + 1;
+
+  Timer timer;
+  timer.key = key;
+  timer.deadline = deadline;
+  _slots[tick % SLOTS].push_back(timer);
+}
+
+template <typename Key>
+void TimerWheel<Key>::advance(OSS::UInt64 now, TimerList& due)
+{
+  OSS::UInt64 nowTick = now / _resolution;
+  if (!_tick)
+    _tick = nowTick;
+
+  //
+  // Never walk more than one revolution.  Every pending timer is reachable
+  // within SLOTS ticks.
+  //
+  if (nowTick > _tick + SLOTS)
+    _tick = nowTick - SLOTS;
+
+  while (_tick < nowTick)
+  {
+    ++_tick;
+    Slot& slot = _slots[_tick % SLOTS];
+    for (std::size_t i = 0; i < slot.size();)
+    {
+      if (slot[i].deadline > now)
+      {
+        ++i;
+        continue;
+      }
+      due.push_back(slot[i]);
+      if (i + 1 < slot.size())
+        std::swap(slot[i], slot.back());
+      slot.pop_back();
+    }
+  }
+}
+
+template <typename Key>
+void TimerWheel<Key>::clear(OSS::UInt64 now)
+{
+  for (std::size_t i = 0; i < SLOTS; i++)
+    _slots[i].clear();
+  _tick = now / _resolution;
+}
+
+template <typename Key>
+OSS::UInt64 TimerWheel<Key>::getResolution() const
+{
+  return _resolution;
+}
+
+} // OSS
+
+#endif // OSS_TIMERWHEEL_H_INCLUDED
@@ -0,0 +1,159 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_ZMQREACTOR_H_INCLUDED
+#define OSS_ZMQREACTOR_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_ZMQ
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/build.h"
+
+
+#if OSS_HAVE_ZMQ
+
+#include <map>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include "OSS/ZMQ/ZMQSocket.h"
+
+namespace OSS {
+namespace ZMQ {
+
+
+class ZMQReactor : boost::noncopyable
+  /// Waits on any number of ZMQ sockets with a single zmq_poll() on one
+  /// thread and hands every readable socket to its handler.
+  ///
+  /// A ZMQ socket must never be used by two threads at the same time, so
+  /// work on a registered socket is posted to the reactor as a task.
+  /// Posting writes to a pipe that is polled next to the sockets, which
+  /// wakes the reactor without a timeout.  Timer handlers run on the same
+  /// thread at a fixed interval.
+{
+public:
+  typedef boost::function<void(ZMQSocket&)> ReadHandler;
+  typedef boost::function<void()> Task;
+
+  enum
+  {
+    DEFAULT_TIMER_INTERVAL = 10
+  };
+
+  ZMQReactor(unsigned int timerInterval = DEFAULT_TIMER_INTERVAL);
+    /// Creates a reactor.  Timers fire every timerInterval milliseconds.
+
+  ~ZMQReactor();
+    /// Stops the reactor.  Tasks that did not run yet are dropped.
+
+  bool run();
+    /// Starts the reactor thread
+
+  void stop();
+    /// Stops and joins the reactor thread
+
+  bool isRunning() const;
+    /// Returns true if the reactor thread is running
+
+  bool isReactorThread() const;
+    /// Returns true if called from a handler, timer or task
+
+  void post(const Task& task);
+    /// Runs task on the reactor thread.  Tasks run in the order they were
+    /// posted.  Safe to call from any thread.
+
+  void execute(const Task& task);
+    /// Runs task on the reactor thread and waits for it to finish.  Runs it
+    /// right away on the reactor thread and only queues it if the reactor
+    /// is not running.
+
+  void addSocket(ZMQSocket* pSocket, const ReadHandler& handler);
+    /// Polls pSocket and calls handler each time it is readable.  The
+    /// handler should drain the socket with tryReceiveMultipart().
+
+  void removeSocket(ZMQSocket* pSocket);
+    /// Stops polling pSocket.  The reactor no longer touches the socket
+    /// once this returns.
+
+  int addTimer(const Task& handler);
+    /// Calls handler every timer interval.  Returns an id for removeTimer().
+
+  void removeTimer(int timerId);
+    /// Stops calling the timer handler.  The handler is not running and
+    /// will not run again once this returns.
+
+  unsigned int getTimerInterval() const;
+    /// Returns the timer interval in milliseconds
+
+private:
+  struct Registration
+  {
+    ZMQSocket* pSocket;
+    ReadHandler handler;
+  };
+  typedef std::vector<Registration> Registrations;
+  typedef std::map<int, Task> Timers;
+  typedef std::vector<Task> Tasks;
+
+  void runLoop();
+  void runTasks();
+  void runTimers();
+  void wake();
+  void terminate();
+  void insertSocket(ZMQSocket* pSocket, const ReadHandler& handler);
+  void eraseSocket(ZMQSocket* pSocket);
+  void insertTimer(int timerId, const Task& handler);
+  void eraseTimer(int timerId);
+
+  unsigned int _timerInterval;
+  int _wakePipe[2];
+  boost::thread* _pThread;
+  boost::thread::id _threadId;
+  bool _isTerminating;
+  bool _isAccepting;
+  Registrations _registrations;
+  Timers _timers;
+  Tasks _tasks;
+  OSS::mutex_critic_sec _tasksMutex;
+  boost::atomic<int> _lastTimerId;
+};
+
+//
+// Inlines
+//
+
+inline unsigned int ZMQReactor::getTimerInterval() const
+{
+  return _timerInterval;
+}
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
+
+#endif // ENABLE_FEATURE_ZMQ
+
+#endif // OSS_ZMQREACTOR_H_INCLUDED
@@ -0,0 +1,121 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_ZMQRPCCLIENT_H_INCLUDED
+#define OSS_ZMQRPCCLIENT_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_ZMQ
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/build.h"
+
+
+#if OSS_HAVE_ZMQ
+
+#include <map>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include "OSS/ZMQ/ZMQSocket.h"
+#include "OSS/ZMQ/ZMQReactor.h"
+
+namespace OSS {
+namespace ZMQ {
+
+
+class ZMQRpcClient : boost::noncopyable
+  /// Request/reply client on a DEALER socket that keeps any number of
+  /// requests in flight.  Every request carries an id frame that the
+  /// server echoes back, so replies are matched to requests in whatever
+  /// order they arrive.  The socket is only used by the reactor thread.
+  ///
+  /// A request is sent as [empty][id][cmd][data].  The empty delimiter
+  /// makes the envelope look like the one a REQ socket produces.
+{
+public:
+  typedef boost::function<void(bool, const std::string&)> ReplyHandler;
+    /// Receives true and the reply.  Receives false and an empty reply if
+    /// the request timed out, could not be sent or the client was closed.
+    /// A failed send reopens the socket and fails every pending request.
+
+  ZMQRpcClient(ZMQReactor& reactor);
+    /// Creates a client served by reactor
+
+  ~ZMQRpcClient();
+    /// Closes the client
+
+  bool connect(const std::string& peerAddress);
+    /// Connects to a ZMQRpcServer.  ZeroMQ reconnects the socket on its own
+    /// if the server goes away.
+
+  void close();
+    /// Closes the socket on the reactor thread and fails every pending
+    /// request
+
+  OSS::UInt64 sendRequest(const std::string& cmd, const std::string& data, const ReplyHandler& handler, unsigned int timeoutms);
+    /// Queues a request and returns its id.  The handler runs once on the
+    /// reactor thread, or on the thread calling close().  A timeout of zero
+    /// waits for the reply for as long as the client is open.
+
+  OSS::UInt64 sendRequest(const std::string& cmd, const ZMQSocket::Buffer& data, const ReplyHandler& handler, unsigned int timeoutms);
+    /// Queues a request without copying data
+
+  bool sendAndReceive(const std::string& cmd, const std::string& data, std::string& response, unsigned int timeoutms);
+    /// Sends a request and waits for the reply.  Any number of threads may
+    /// wait at the same time.  Always fails on the reactor thread.
+
+  std::size_t getPendingCount() const;
+    /// Returns the number of requests waiting for a reply
+
+private:
+  struct PendingRequest
+  {
+    ReplyHandler handler;
+    OSS::UInt64 deadline;
+  };
+  typedef std::map<OSS::UInt64, PendingRequest> PendingRequests;
+
+  void onReadable(ZMQSocket& socket);
+  void onTimer();
+  void onSend(OSS::UInt64 id, const ZMQSocket::Buffers& frames);
+  void complete(OSS::UInt64 id, bool ok, const std::string& reply);
+  void failPending();
+
+  ZMQReactor& _reactor;
+  ZMQSocket _socket;
+  std::string _peerAddress;
+  PendingRequests _pending;
+  mutable OSS::mutex_critic_sec _pendingMutex;
+  boost::atomic<OSS::UInt64> _lastId;
+  int _timerId;
+};
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
+
+#endif // ENABLE_FEATURE_ZMQ
+
+#endif // OSS_ZMQRPCCLIENT_H_INCLUDED
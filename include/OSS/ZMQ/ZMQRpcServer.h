@@ -0,0 +1,102 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_ZMQRPCSERVER_H_INCLUDED
+#define OSS_ZMQRPCSERVER_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_ZMQ
+
+#include "OSS/OSS.h"
+#include "OSS/UTL/Thread.h"
+#include "OSS/build.h"
+
+
+#if OSS_HAVE_ZMQ
+
+#include <boost/function.hpp>
+#include "OSS/ZMQ/ZMQSocket.h"
+#include "OSS/ZMQ/ZMQReactor.h"
+
+namespace OSS {
+namespace ZMQ {
+
+
+class ZMQRpcServer : boost::noncopyable
+  /// Serves requests on a ROUTER socket.  Requests reach the handler on the
+  /// reactor thread in the order they arrive.  The handler may reply at
+  /// once or keep the request and reply later from any thread, so a slow
+  /// request does not hold back the ones queued behind it.
+  ///
+  /// Requests from ZMQRpcClient carry an id that is echoed in the reply.
+  /// Requests from a plain REQ socket have none and are answered in the
+  /// envelope REQ expects, so existing ZMQSocket::sendAndReceive callers
+  /// can talk to the server unchanged.
+{
+public:
+  struct Request
+  {
+    std::string identity;
+    std::string id;
+    std::string cmd;
+    std::string data;
+  };
+
+  typedef boost::function<void(const Request&)> RequestHandler;
+
+  ZMQRpcServer(ZMQReactor& reactor, const RequestHandler& handler);
+    /// Creates a server served by reactor
+
+  ~ZMQRpcServer();
+    /// Closes the server
+
+  bool bind(const std::string& bindAddress);
+    /// Starts accepting requests on bindAddress
+
+  void close();
+    /// Stops accepting requests and closes the socket
+
+  void sendReply(const Request& request, const std::string& reply);
+    /// Sends the reply to request.  Safe to call from any thread.
+
+  void sendReply(const Request& request, const ZMQSocket::Buffer& reply);
+    /// Sends the reply to request without copying it
+
+private:
+  void onReadable(ZMQSocket& socket);
+  void onSendReply(const ZMQSocket::Buffers& frames);
+
+  ZMQReactor& _reactor;
+  ZMQSocket _socket;
+  RequestHandler _handler;
+  bool _isBound;
+};
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
+
+#endif // ENABLE_FEATURE_ZMQ
+
+#endif // OSS_ZMQRPCSERVER_H_INCLUDED
@@ -36,6 +36,7 @@
 
 #if OSS_HAVE_ZMQ
 
+#include <boost/shared_ptr.hpp>
 #include "OSS/ZMQ/zmq.hpp"
 
 namespace OSS {
@@ -52,11 +53,17 @@ public:
     PUSH,
     PULL,
     PUB,
-    SUB
+    SUB,
+    DEALER,
+    ROUTER
   };
   
   typedef zmq::pollitem_t PollItem;
   typedef std::vector<PollItem> PollItems;
+  typedef zmq::free_fn FreeFunc;
+  typedef boost::shared_ptr<std::string> Buffer;
+  typedef std::vector<Buffer> Buffers;
+  typedef std::vector<std::string> Frames;
   
   ZMQSocket(SocketType type);
   
@@ -75,8 +82,25 @@ public:
 
   bool sendRequest(const std::string& cmd, const std::string& data);
   
+  bool sendRequest(const std::string& cmd, void* data, std::size_t size, FreeFunc* freeFunc);
+    /// Sends data without copying it.  The socket takes ownership of data
+    /// even if sending fails and calls freeFunc once ZeroMQ is done with it.
+  
   bool sendReply(const std::string& data);
   
+  bool sendMultipart(const Buffers& frames);
+    /// Sends each buffer as a frame of one message without copying it.
+    /// Every frame holds a reference to its buffer until ZeroMQ releases it,
+    /// so the same buffer may be queued on several sockets at once.
+  
+  bool receiveMultipart(Frames& frames, unsigned int timeoutms);
+  bool receiveMultipart(Frames& frames);
+    /// Receives every frame of the next message
+  
+  bool tryReceiveMultipart(Frames& frames);
+    /// Returns false right away if no message is waiting.  Used to drain a
+    /// socket that a poller reported readable.
+  
   bool receiveReply(std::string& reply, unsigned int timeoutms);
   bool receiveReply(std::string& reply);
   
@@ -94,8 +118,11 @@ protected:
   bool internal_connect(const std::string& peerAddress);
   bool internal_send_reply(const std::string& data);
   bool internal_send_request(const std::string& cmd, const std::string& data);
+  bool internal_send_request(const std::string& cmd, void* data, std::size_t size, FreeFunc* freeFunc);
   bool internal_receive_reply(std::string& reply, unsigned int timeoutms);
   bool internal_receive_request(std::string& cmd, std::string& data, unsigned int timeoutms);
+  bool internal_send_multipart(const Buffers& frames);
+  bool internal_receive_multipart(Frames& frames, int flags);
   SocketType _type;
   zmq::context_t* _context;
   zmq::socket_t* _socket;
@@ -126,6 +153,11 @@ inline bool ZMQSocket::receiveReply(std::string& reply)
   return receiveReply(reply, 0);
 }
 
+inline bool ZMQSocket::receiveMultipart(Frames& frames)
+{
+  return receiveMultipart(frames, 0);
+}
+
 inline zmq::socket_t* ZMQSocket::socket()
 {
   return _socket;
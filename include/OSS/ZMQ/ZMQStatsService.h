@@ -0,0 +1,76 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef OSS_ZMQSTATSSERVICE_H_INCLUDED
+#define OSS_ZMQSTATSSERVICE_H_INCLUDED
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_ZMQ
+
+#include "OSS/OSS.h"
+
+
+#if OSS_HAVE_ZMQ
+
+#include "OSS/UTL/Metrics.h"
+#include "OSS/ZMQ/ZMQRpcServer.h"
+
+namespace OSS {
+namespace ZMQ {
+
+
+class ZMQStatsService : boost::noncopyable
+  /// Serves snapshots of a metrics registry on a ZMQRpcServer.  The command
+  /// "stats.prometheus" returns the Prometheus text format.  "stats.json"
+  /// or no command at all returns JSON.  "stats.reset" zeroes the metrics.
+  /// Rendering happens on the reactor thread and never stops the threads
+  /// that update the metrics.
+{
+public:
+  ZMQStatsService(ZMQReactor& reactor, Metrics& metrics = Metrics::instance());
+    /// Creates a service served by reactor
+
+  ~ZMQStatsService();
+    /// Closes the service
+
+  bool bind(const std::string& bindAddress);
+    /// Starts accepting requests on bindAddress
+
+  void close();
+    /// Stops accepting requests
+
+private:
+  void onRequest(const ZMQRpcServer::Request& request);
+
+  Metrics& _metrics;
+  ZMQRpcServer _server;
+};
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
+
+#endif // ENABLE_FEATURE_ZMQ
+
+#endif // OSS_ZMQSTATSSERVICE_H_INCLUDED
@@ -77,7 +77,7 @@ ABNFCharAlpha::ABNFCharAlpha()
 char* ABNFCharAlpha::parse(const char* _t)
 {
   char* t = const_cast<char*>(_t);
-  if ((*t >= 0x41 && *t <= 0x5A) || (*t >= 0x61 && *t <= 0x7A))
+  if (ABNFCharTable<ABNFCharSetAlpha>::test(*t))
     t++;
   return t;
 } 
@@ -119,7 +119,7 @@ ABNFCharHex::ABNFCharHex()
 char* ABNFCharHex::parse(const char* _t)
 {
   char* t = const_cast<char*>(_t);
-  if( (*t >= 0x30 && *t <= 0x39) || (*t >= 0x41 && *t <= 0x46 ) || (*t >= 0x61 && *t <= 0x66) )
+  if (ABNFCharTable<ABNFCharSetHex>::test(*t))
     t++;
   return t;
 } 
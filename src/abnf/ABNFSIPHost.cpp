@@ -31,7 +31,14 @@ namespace ABNF {
 
 /// Satisfies RFC 3261 ABNF Rule for 
 /// host  =  hostname / IPv4address / IPv6reference
-typedef ABNFAnyOfMultiple3<ABNF_SIP_hostname, ABNF_SIP_IPv4address, ABNF_SIP_IPv6reference> Parser;
+/// Alternatives are selected by the first character.  A digit may start
+/// either a hostname or an IPv4address so both are still tried in order.
+typedef ABNFAnyOfByFirstChar
+<
+  ABNFCharSetAlphaNumeric, ABNF_SIP_hostname,
+  ABNFCharSetDigit, ABNF_SIP_IPv4address,
+  ABNFCharSetChars<'['>, ABNF_SIP_IPv6reference
+> Parser;
 static Parser _parser;
 
 ABNFSIPHost::ABNFSIPHost()
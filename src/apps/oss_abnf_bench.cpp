@@ -0,0 +1,190 @@
+#include "OSS/ABNF/ABNFParser.h"
+#include "OSS/ABNF/ABNFSIPRules.h"
+#include "OSS/ABNF/ABNFSIPToken.h"
+#include "OSS/ABNF/ABNFSIPHost.h"
+#include "OSS/ABNF/ABNFSIPHostName.h"
+#include "OSS/ABNF/ABNFSIPHostPort.h"
+#include "OSS/ABNF/ABNFSIPIPV4Address.h"
+#include "OSS/ABNF/ABNFSIPIPV6Address.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+
+//
+// oss_abnf_bench - Compares the table driven ABNF rules against the rule
+// compositions they replace.  Each pair parses the same inputs and the
+// results are checked for equality before the timings are reported.
+//
+
+using namespace OSS::ABNF;
+
+typedef ABNFAnyOfMultiple3<ABNF_SIP_hostname, ABNF_SIP_IPv4address, ABNF_SIP_IPv6reference> LegacyHost;
+typedef ABNFLoopUntil<ABNFAnyOf<ABNFCharAlpha, ABNFCharDigit>, ABNFLoopExitIfNul, 1, 1024> LegacyAlphaNumeric;
+typedef ABNFCharClassLoop<ABNFCharSetAlphaNumeric, 1, 1024> AlphaNumeric;
+typedef ABNFLRSequence5<ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token> SentProtocol;
+typedef ABNFLRSequence3<SentProtocol, ABNF_SIP_LWS, ABNF_SIP_hostport> SentBy;
+
+static const char* hosts[] =
+{
+  "pc33.atlanta.com",
+  "192.168.10.254",
+  "[2001:db8:85a3::8a2e:370:7334]",
+  "sip-proxy-01.biloxi.example.com",
+  "10.0.0.1",
+  "[::1]",
+  0
+};
+
+static const char* vias[] =
+{
+  "SIP/2.0/UDP pc33.atlanta.com:5060;branch=z9hG4bK776asdhds",
+  "SIP/2.0/TCP 192.168.10.254:5060;branch=z9hG4bKnashds8;rport",
+  "SIP/2.0/TLS [2001:db8:85a3::8a2e:370:7334]:5061;branch=z9hG4bK77ef4c2312983.1",
+  0
+};
+
+static const char* words[] =
+{
+  "z9hG4bK776asdhds",
+  "a84b4c76e66710",
+  "1928301774",
+  "abcdefghijklmnopqrstuvwxyz0123456789",
+  0
+};
+
+//
+// Parse results are accumulated here so the compiler cannot drop the
+// parser calls from the timed loops
+//
+static volatile std::size_t sink = 0;
+
+static double elapsed(const boost::posix_time::ptime& start)
+{
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+  return (end - start).total_microseconds() / 1000000.0;
+}
+
+static void report(const char* name, int operations, double legacy, double table)
+{
+  std::cout << name
+    << " legacy: " << (legacy * 1000000000.0 / operations) << " ns/op"
+    << " table: " << (table * 1000000000.0 / operations) << " ns/op"
+    << " speedup: " << (table > 0 ? legacy / table : 0) << "x" << std::endl;
+}
+
+template <typename Legacy_T, typename Table_T>
+static bool compare(const char* name, const char** inputs, int iterations)
+{
+  Legacy_T legacy;
+  Table_T table;
+  int operations = 0;
+
+  for (int i = 0; inputs[i]; i++)
+  {
+    if (legacy.parse(inputs[i]) != table.parse(inputs[i]))
+    {
+      std::cerr << name << " mismatch on " << inputs[i] << std::endl;
+      return false;
+    }
+  }
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  for (int n = 0; n < iterations; n++)
+  {
+    for (int i = 0; inputs[i]; i++)
+    {
+      sink += legacy.parse(inputs[i]) - inputs[i];
+      operations++;
+    }
+  }
+  double legacyTime = elapsed(start);
+
+  start = boost::posix_time::microsec_clock::universal_time();
+  for (int n = 0; n < iterations; n++)
+  {
+    for (int i = 0; inputs[i]; i++)
+    {
+      sink += table.parse(inputs[i]) - inputs[i];
+    }
+  }
+  double tableTime = elapsed(start);
+
+  report(name, operations, legacyTime, tableTime);
+  return true;
+}
+
+static bool compareTokens(const char* name, const char** inputs, int iterations)
+{
+  SentBy parser;
+  ABNFTokens tokens;
+  ABNFTokenRanges ranges;
+  int operations = 0;
+
+  for (int i = 0; inputs[i]; i++)
+  {
+    tokens.clear();
+    ranges.clear();
+    parser.parseTokens(inputs[i], tokens);
+    parser.parseTokenRanges(inputs[i], ranges);
+    bool match = tokens.size() == ranges.size();
+    for (std::size_t t = 0; match && t < tokens.size(); t++)
+    {
+      match = tokens[t] == ranges.str(inputs[i], t);
+    }
+    if (!match)
+    {
+      std::cerr << name << " mismatch on " << inputs[i] << std::endl;
+      return false;
+    }
+  }
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  for (int n = 0; n < iterations; n++)
+  {
+    for (int i = 0; inputs[i]; i++)
+    {
+      ABNFTokens tokens;
+      sink += parser.parseTokens(inputs[i], tokens) - inputs[i];
+      operations++;
+    }
+  }
+  double legacyTime = elapsed(start);
+
+  start = boost::posix_time::microsec_clock::universal_time();
+  for (int n = 0; n < iterations; n++)
+  {
+    for (int i = 0; inputs[i]; i++)
+    {
+      ABNFTokenRanges ranges;
+      sink += parser.parseTokenRanges(inputs[i], ranges) - inputs[i];
+    }
+  }
+  double tableTime = elapsed(start);
+
+  report(name, operations, legacyTime, tableTime);
+  return true;
+}
+
+void usage()
+{
+  std::cout << std::endl << "Usage:  oss_abnf_bench [ITERATIONS]";
+  std::cout << std::endl << "Example:  oss_abnf_bench 1000000";
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 2 || (argc > 1 && std::string(argv[1]) == "-h"))
+  {
+    usage();
+    return -1;
+  }
+
+  int iterations = argc > 1 ? OSS::string_to_number<int>(argv[1]) : 200000;
+
+  bool ok = compare<LegacyHost, ABNFSIPHost>("host", hosts, iterations);
+  ok = compare<LegacyAlphaNumeric, AlphaNumeric>("alphanum", words, iterations) && ok;
+  ok = compareTokens("via-tokens", vias, iterations) && ok;
+
+  return ok ? 0 : -1;
+}
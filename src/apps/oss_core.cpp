@@ -39,6 +39,7 @@
 #include "OSS/SIP/SIPRoute.h"
 #include "OSS/STUN/STUNClient.h"
 #include "OSS/SIP/UA/SIPEventLoop.h"
+#include "OSS/ZMQ/ZMQStatsService.h"
 
 
 #if HAVE_CONFIG_H
@@ -713,6 +714,7 @@ bool prepareOptions(ServiceOptions& options)
   options.addOptionString("carp-interface", "Interface where the virtual IP will be registered.  Example: eth0");
   options.addOptionString("carp-up-script", "Script called to bring up the virtual interface");
   options.addOptionString("carp-down-script", "Script called to bring up the virtual interface");
+  options.addOptionString("stats-address", "ZeroMQ address where metrics are served.  Example: tcp://127.0.0.1:5070");
   
   return options.parseOptions();
 }
@@ -780,6 +782,27 @@ int main(int argc, char** argv)
     
     ua.rtpProxy().enableHairpins() = true;
 
+#if ENABLE_FEATURE_ZMQ && OSS_HAVE_ZMQ
+    //
+    // Metrics are served from their own reactor so a slow scraper never
+    // holds up SIP processing
+    //
+    OSS::ZMQ::ZMQReactor statsReactor;
+    OSS::ZMQ::ZMQStatsService statsService(statsReactor);
+    std::string statsAddress;
+    if (options.getOption("stats-address", statsAddress) && !statsAddress.empty())
+    {
+      if (statsReactor.run() && statsService.bind(statsAddress))
+      {
+        OSS_LOG_INFO("Serving metrics on " << statsAddress);
+      }
+      else
+      {
+        OSS_LOG_ERROR("Unable to serve metrics on " << statsAddress);
+      }
+    }
+#endif
+
 #if ENABLE_TURN
     if (options.hasOption("enable-turn-relay"))
     {
@@ -807,6 +830,11 @@ int main(int argc, char** argv)
       }
     }
     
+#if ENABLE_FEATURE_ZMQ && OSS_HAVE_ZMQ
+    statsService.close();
+    statsReactor.stop();
+#endif
+
     //
     // Deinit
     //
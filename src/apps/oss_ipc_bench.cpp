@@ -0,0 +1,159 @@
+#include "OSS/UTL/IPCQueue.h"
+#include "OSS/UTL/SharedMemoryRing.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+
+//
+// oss_ipc_bench - Compares the shared memory ring against the SysV message
+// queues it replaces.  A forked child first drains a burst of messages to
+// measure throughput and then echoes messages one at a time to measure the
+// round trip latency.
+//
+
+typedef OSS::IPCQueueReader<OSS::IPCMessage> MsgQueueReader;
+typedef OSS::IPCQueueWriter<OSS::IPCMessage> MsgQueueWriter;
+
+static const char* DONE = "done";
+
+static double elapsed(const boost::posix_time::ptime& start)
+{
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+  return (end - start).total_microseconds() / 1000000.0;
+}
+
+static bool send(MsgQueueWriter& writer, const std::string& data)
+{
+  OSS::IPCMessage message;
+  if (data.size() > sizeof(message.data))
+    return false;
+  message.datatype = 1;
+  message.dataSize = data.size();
+  memcpy(message.data, data.data(), data.size());
+  return writer.write(message, true);
+}
+
+static bool receive(MsgQueueReader& reader, std::string& data)
+{
+  OSS::IPCMessage message;
+  if (!reader.read(message, true))
+    return false;
+  data.assign(message.data, message.dataSize);
+  return true;
+}
+
+static bool send(OSS::SharedMemoryRingWriter& writer, const std::string& data)
+{
+  return writer.write(data, true);
+}
+
+static bool receive(OSS::SharedMemoryRingReader& reader, std::string& data)
+{
+  return reader.read(data, true);
+}
+
+template <typename Reader_T, typename Writer_T>
+static void child(Reader_T& toChild, const std::string& toParentPath, int messages)
+{
+  Writer_T toParent(toParentPath);
+  std::string data;
+  for (int i = 0; i < messages; i++)
+  {
+    if (!receive(toChild, data))
+      _exit(1);
+  }
+  send(toParent, DONE);
+
+  for (int i = 0; i < messages; i++)
+  {
+    if (!receive(toChild, data) || !send(toParent, data))
+      _exit(1);
+  }
+  //
+  // Skip the destructors.  The SysV queues would be removed under the parent.
+  //
+  _exit(0);
+}
+
+template <typename Reader_T, typename Writer_T>
+static bool run(const char* name, int messages, std::size_t size)
+{
+  std::string toChildPath = std::string("/tmp/oss_ipc_bench_") + name + "_c";
+  std::string toParentPath = std::string("/tmp/oss_ipc_bench_") + name + "_p";
+  Reader_T toChild(toChildPath);
+  Reader_T toParent(toParentPath);
+  if (!toChild.isOpen() || !toParent.isOpen())
+  {
+    std::cerr << name << " unable to create queues" << std::endl;
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid == -1)
+    return false;
+  if (pid == 0)
+    child<Reader_T, Writer_T>(toChild, toParentPath, messages);
+
+  Writer_T writer(toChildPath);
+  std::string payload(size, 'x');
+  std::string data;
+  bool ok = true;
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  for (int i = 0; ok && i < messages; i++)
+    ok = send(writer, payload);
+  ok = ok && receive(toParent, data) && data == DONE;
+  double burst = elapsed(start);
+
+  start = boost::posix_time::microsec_clock::universal_time();
+  for (int i = 0; ok && i < messages; i++)
+    ok = send(writer, payload) && receive(toParent, data) && data.size() == size;
+  double pingPong = elapsed(start);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  if (!ok)
+  {
+    std::cerr << name << " transfer failed" << std::endl;
+    return false;
+  }
+
+  std::cout << name
+    << " throughput: " << (long)(messages / burst) << " msg/s"
+    << " (" << (messages * (double)size / burst / (1024 * 1024)) << " MB/s)"
+    << " round trip: " << (pingPong * 1000000.0 / messages) << " us" << std::endl;
+  return true;
+}
+
+void usage()
+{
+  std::cout << std::endl << "Usage:  oss_ipc_bench [MESSAGES] [SIZE]";
+  std::cout << std::endl << "Example:  oss_ipc_bench 100000 256";
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 3 || (argc > 1 && std::string(argv[1]) == "-h"))
+  {
+    usage();
+    return -1;
+  }
+
+  int messages = argc > 1 ? OSS::string_to_number<int>(argv[1]) : 100000;
+  std::size_t size = argc > 2 ? OSS::string_to_number<std::size_t>(argv[2]) : 256;
+  if (size > sizeof(((OSS::IPCMessage*)0)->data))
+  {
+    std::cerr << "SIZE must not exceed the SysV message buffer" << std::endl;
+    return -1;
+  }
+
+  bool ok = run<MsgQueueReader, MsgQueueWriter>("msgqueue", messages, size);
+  ok = run<OSS::SharedMemoryRingReader, OSS::SharedMemoryRingWriter>("shmring", messages, size) && ok;
+
+  return ok ? 0 : -1;
+}
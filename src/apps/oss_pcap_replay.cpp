@@ -0,0 +1,644 @@
+#include "OSS/SIP/SIPFSMDispatch.h"
+#include "OSS/SIP/SIPTransportSession.h"
+#include "OSS/SIP/SIPMessage.h"
+#include "OSS/RTP/RTPPCAPReader.h"
+#include "OSS/RTP/RTPProxy.h"
+#include "OSS/RTP/RTPProxyManager.h"
+#include "OSS/RTP/RTPProxySession.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <getopt.h>
+#include <unistd.h>
+
+//
+// oss_pcap_replay - Replays the UDP traffic of a capture through the stack
+// to reproduce production hot spots offline.  SIP datagrams are parsed by
+// SIPMessage and then handed to SIPFSMDispatch as if a UDP listener had
+// read them.  Requests are answered with 200 OK so transactions complete
+// the way they would on a live system.  RTP flows are sent through an
+// RTPProxy relay on loopback, one relay per flow, and received again on
+// the far leg.
+//
+// Packets are sent at the capture timing or as fast as possible.  The
+// report has the throughput and latency of every stage, the time a packet
+// spends in the relay and the jitter the relay adds on top of the jitter
+// already present in the capture.
+//
+
+using namespace OSS::SIP;
+using OSS::RTP::RTPPCAPReader;
+using OSS::RTP::RTPProxy;
+using OSS::Net::IPAddress;
+using boost::asio::ip::udp;
+
+#define RTP_HEADER_SIZE 12
+#define RTP_VERSION_MASK 0xC0
+#define RTP_VERSION_2 0x80
+#define RTCP_TYPE_FIRST 200
+#define RTCP_TYPE_LAST 204
+#define MIN_SIP_SIZE 10
+
+struct Options
+{
+  std::string file;
+  bool maxSpeed;
+  int loops;
+  bool sip;
+  bool rtp;
+  std::size_t maxFlows;
+  bool dumpMetrics;
+};
+
+class Stage
+  /// Busy time and per packet latency of one replay stage
+{
+public:
+  Stage(const char* name) : _name(name), _busy(0)
+  {
+  }
+
+  void record(OSS::UInt64 micros)
+  {
+    _busy += micros;
+    _latency.record(micros);
+  }
+
+  void report() const
+  {
+    OSS::LatencyHistogram::Snapshot snapshot;
+    _latency.snapshot(snapshot);
+    std::cout << std::left << std::setw(14) << _name << std::right
+      << std::setw(10) << snapshot.count
+      << std::setw(12) << std::fixed << std::setprecision(3) << _busy / 1000000.0
+      << std::setw(12) << std::setprecision(0) << (_busy ? snapshot.count * 1000000.0 / _busy : 0)
+      << std::setw(9) << snapshot.percentile(50)
+      << std::setw(9) << snapshot.percentile(99)
+      << std::setw(9) << snapshot.max << std::endl;
+  }
+
+private:
+  const char* _name;
+  OSS::UInt64 _busy;
+  OSS::LatencyHistogram _latency;
+};
+
+class ReplayConnection : public SIPTransportSession
+  /// Stands in for the UDP connection that read a captured datagram.
+  /// Messages written by transactions are counted and dropped.
+{
+public:
+  ReplayConnection(const IPAddress& local, const IPAddress& remote) :
+    SIPTransportSession(0),
+    _local(local),
+    _remote(remote)
+  {
+    _isReliableTransport = false;
+    _transportScheme = "udp";
+  }
+
+  void setLastReadCount(std::size_t count)
+  {
+    _bytesRead = count;
+  }
+
+  virtual void writeMessage(SIPMessage::Ptr msg)
+  {
+    _writes.increment();
+  }
+
+  virtual void writeMessage(SIPMessage::Ptr msg, const std::string& ip, const std::string& port)
+  {
+    _writes.increment();
+  }
+
+  virtual void start(const SIPTransportSession::Dispatch& dispatch) {}
+  virtual void stop() {}
+  virtual void handleRead(const boost::system::error_code& e, std::size_t bytes_transferred, OSS::OSS_HANDLE userData = 0) {}
+  virtual void handleWrite(const boost::system::error_code& e) {}
+  virtual void handleConnect(const boost::system::error_code& e, boost::asio::ip::tcp::resolver::iterator endPointIter, boost::system::error_code* out_ec, OSS::Semaphore* pSem) {}
+  virtual void handleClientHandshake(const boost::system::error_code& error) {}
+  virtual void handleServerHandshake(const boost::system::error_code& error) {}
+  virtual IPAddress getLocalAddress() const { return _local; }
+  virtual IPAddress getRemoteAddress() const { return _remote; }
+  virtual void clientBind(const IPAddress& ip, unsigned short portBase, unsigned short portMax) {}
+  virtual bool clientConnect(const IPAddress& target) { return false; }
+
+  static OSS::MetricCounter _writes;
+
+private:
+  IPAddress _local;
+  IPAddress _remote;
+};
+
+OSS::MetricCounter ReplayConnection::_writes;
+
+struct RelayFlow
+  /// One captured RTP flow.  Packets go from the sender socket to leg 1 of
+  /// the relay and come out of leg 2 into the receiver socket.
+{
+  typedef boost::shared_ptr<RelayFlow> Ptr;
+
+  RTPProxy::Ptr relay;
+  boost::shared_ptr<udp::socket> sender;
+  boost::shared_ptr<udp::socket> receiver;
+  udp::endpoint leg1;
+  udp::endpoint from;
+  char buffer[2048];
+
+  OSS::mutex_critic_sec mutex;
+  std::map<OSS::UInt16, OSS::UInt64> inFlight;
+  bool hasTransit;
+  OSS::Int64 lastTransit;
+  double jitter;
+  OSS::UInt64 sent;
+  OSS::UInt64 received;
+};
+
+typedef std::map<std::string, RelayFlow::Ptr> RelayFlows;
+typedef std::map<std::string, SIPTransportSession::Ptr> SIPFlows;
+
+static Options options;
+static boost::asio::io_service io_service;
+static OSS::RTP::RTPProxyManager* pRtpManager = 0;
+static OSS::RTP::RTPProxySession* pRtpSession = 0;
+static RelayFlows relayFlows;
+static SIPFlows sipFlows;
+
+static Stage readStage("read");
+static Stage parseStage("sip-parse");
+static Stage dispatchStage("sip-dispatch");
+static Stage rtpSendStage("rtp-send");
+static OSS::LatencyHistogram relayTransit;
+static OSS::LatencyHistogram relayDelayVariation;
+static OSS::LatencyHistogram scheduleLateness;
+static OSS::MetricCounter handledRequests;
+static OSS::MetricCounter ackOr2xx;
+static OSS::UInt64 otherDatagrams = 0;
+static OSS::UInt64 rtcpDatagrams = 0;
+static OSS::UInt64 skippedRtp = 0;
+static OSS::UInt64 relayErrors = 0;
+static OSS::UInt64 lastReceive = 0;
+
+//
+// SIP
+//
+
+static bool is_sip(const std::string& payload)
+{
+  if (payload.size() < MIN_SIP_SIZE)
+    return false;
+  if (payload.compare(0, 8, "SIP/2.0 ") == 0)
+    return true;
+  std::size_t eol = payload.find("\r\n");
+  return eol != std::string::npos && eol > 8 && payload.compare(eol - 8, 8, " SIP/2.0") == 0;
+}
+
+static void handle_request(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr& pTransport, const SIPTransaction::Ptr& pTransaction)
+{
+  handledRequests.increment();
+  if (pMsg->isRequest("ACK"))
+    return;
+  SIPMessage::Ptr pResponse = pMsg->createResponse(200);
+  pTransaction->sendResponse(pResponse, pTransport->getRemoteAddress());
+}
+
+static void handle_ack_or_2xx(const SIPMessage::Ptr&, const SIPTransportSession::Ptr&)
+{
+  ackOr2xx.increment();
+}
+
+static void replay_sip(SIPFSMDispatch& dispatch, const RTPPCAPReader::Datagram& datagram)
+{
+  {
+    //
+    // The parser on its own
+    //
+    OSS::UInt64 start = OSS::Metrics::now();
+    try
+    {
+      SIPMessage msg(datagram.payload);
+      msg.parse();
+    }
+    catch(OSS::Exception& e)
+    {
+    }
+    parseStage.record(OSS::Metrics::now() - start);
+  }
+
+  std::string key = datagram.source.toIpPortString() + "-" + datagram.destination.toIpPortString();
+  SIPTransportSession::Ptr& pTransport = sipFlows[key];
+  if (!pTransport)
+    pTransport.reset(new ReplayConnection(datagram.destination, datagram.source));
+  static_cast<ReplayConnection*>(pTransport.get())->setLastReadCount(datagram.payload.size());
+
+  //
+  // The path of a datagram read by a UDP listener.  This parses again,
+  // matches or creates the transaction and runs the request handler.
+  //
+  OSS::UInt64 start = OSS::Metrics::now();
+  SIPMessage::Ptr pMsg(new SIPMessage(datagram.payload));
+  pMsg->setSingleOwner(true);
+  dispatch.onReceivedMessage(pMsg, pTransport);
+  dispatchStage.record(OSS::Metrics::now() - start);
+}
+
+//
+// RTP
+//
+
+static bool is_rtp(const std::string& payload, bool& isRtcp)
+{
+  if (payload.size() < RTP_HEADER_SIZE || ((unsigned char)payload[0] & RTP_VERSION_MASK) != RTP_VERSION_2)
+    return false;
+  unsigned char type = (unsigned char)payload[1];
+  isRtcp = type >= RTCP_TYPE_FIRST && type <= RTCP_TYPE_LAST;
+  return true;
+}
+
+static OSS::UInt16 rtp_sequence(const char* pData)
+{
+  return ((unsigned char)pData[2] << 8) | (unsigned char)pData[3];
+}
+
+static void receive_relayed(RelayFlow* pFlow, const boost::system::error_code& e, std::size_t bytes)
+{
+  if (e == boost::asio::error::operation_aborted)
+    return;
+
+  OSS::UInt64 now = OSS::Metrics::now();
+  if (!e && bytes >= RTP_HEADER_SIZE)
+  {
+    OSS::mutex_critic_sec_lock lock(pFlow->mutex);
+    std::map<OSS::UInt16, OSS::UInt64>::iterator iter = pFlow->inFlight.find(rtp_sequence(pFlow->buffer));
+    if (iter != pFlow->inFlight.end())
+    {
+      //
+      // Interarrival jitter of RFC 3550 computed over the transit through
+      // the relay.  Both ends use the same clock so it is what the relay
+      // adds and nothing else.
+      //
+      OSS::Int64 transit = now - iter->second;
+      pFlow->inFlight.erase(iter);
+      relayTransit.record(transit);
+      if (pFlow->hasTransit)
+      {
+        OSS::Int64 d = transit - pFlow->lastTransit;
+        if (d < 0)
+          d = -d;
+        relayDelayVariation.record(d);
+        pFlow->jitter += (d - pFlow->jitter) / 16.0;
+      }
+      pFlow->hasTransit = true;
+      pFlow->lastTransit = transit;
+      pFlow->received++;
+      lastReceive = now;
+    }
+  }
+
+  pFlow->receiver->async_receive_from(boost::asio::buffer(pFlow->buffer, sizeof(pFlow->buffer)), pFlow->from,
+    boost::bind(receive_relayed, pFlow, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+}
+
+static RelayFlow::Ptr create_relay_flow(const std::string& key)
+{
+  RelayFlow::Ptr pFlow(new RelayFlow());
+  pFlow->hasTransit = false;
+  pFlow->lastTransit = 0;
+  pFlow->jitter = 0;
+  pFlow->sent = 0;
+  pFlow->received = 0;
+
+  IPAddress loopback("127.0.0.1", 0);
+  pFlow->relay.reset(new RTPProxy(RTPProxy::Data, pRtpManager, pRtpSession, key));
+  if (!pFlow->relay->open(loopback, loopback))
+    return RelayFlow::Ptr();
+  pFlow->relay->start();
+  pFlow->leg1 = pFlow->relay->leg1Socket()->local_endpoint();
+  udp::endpoint leg2 = pFlow->relay->leg2Socket()->local_endpoint();
+
+  udp::endpoint local(boost::asio::ip::address_v4::loopback(), 0);
+  pFlow->sender.reset(new udp::socket(io_service, local));
+  pFlow->receiver.reset(new udp::socket(io_service, local));
+
+  //
+  // The relay forwards to the last sender it saw on the other leg.  Latch
+  // leg 2 onto the receiver before any captured packet goes out.
+  //
+  char latch[RTP_HEADER_SIZE] = { (char)RTP_VERSION_2 };
+  pFlow->receiver->send_to(boost::asio::buffer(latch, sizeof(latch)), leg2);
+  receive_relayed(pFlow.get(), boost::system::error_code(), 0);
+  return pFlow;
+}
+
+static void replay_rtp(const RTPPCAPReader::Datagram& datagram)
+{
+  std::string key = datagram.source.toIpPortString() + "-" + datagram.destination.toIpPortString();
+  RelayFlows::iterator iter = relayFlows.find(key);
+  RelayFlow::Ptr pFlow;
+  if (iter != relayFlows.end())
+  {
+    pFlow = iter->second;
+  }
+  else if (relayFlows.size() < options.maxFlows)
+  {
+    pFlow = create_relay_flow(key);
+    if (!pFlow)
+      relayErrors++;
+    else
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    relayFlows[key] = pFlow;
+  }
+
+  if (!pFlow)
+  {
+    skippedRtp++;
+    return;
+  }
+
+  OSS::UInt64 start = OSS::Metrics::now();
+  {
+    OSS::mutex_critic_sec_lock lock(pFlow->mutex);
+    pFlow->inFlight[rtp_sequence(datagram.payload.data())] = start;
+  }
+  boost::system::error_code ec;
+  pFlow->sender->send_to(boost::asio::buffer(datagram.payload), pFlow->leg1, 0, ec);
+  rtpSendStage.record(OSS::Metrics::now() - start);
+  if (!ec)
+    pFlow->sent++;
+}
+
+//
+// Replay
+//
+
+static void wait_until(OSS::UInt64 due)
+{
+  OSS::UInt64 now = OSS::Metrics::now();
+  if (now < due)
+  {
+    if (due - now > 100)
+      boost::this_thread::sleep(boost::posix_time::microseconds(due - now - 50));
+    while ((now = OSS::Metrics::now()) < due)
+    {
+    }
+  }
+  scheduleLateness.record(now - due);
+}
+
+static OSS::UInt64 replay(SIPFSMDispatch& dispatch, OSS::UInt64& sipDatagrams, OSS::UInt64& rtpDatagrams)
+{
+  OSS::UInt64 captureSpan = 0;
+  for (int loop = 0; loop < options.loops; loop++)
+  {
+    RTPPCAPReader reader;
+    if (!reader.open(options.file))
+    {
+      std::cerr << "Unable to open " << options.file << std::endl;
+      _exit(-1);
+    }
+
+    OSS::UInt64 firstPacket = 0;
+    OSS::UInt64 startTime = OSS::Metrics::now();
+    RTPPCAPReader::Datagram datagram;
+    while (true)
+    {
+      OSS::UInt64 start = OSS::Metrics::now();
+      if (!reader.readDatagram(datagram))
+        break;
+      readStage.record(OSS::Metrics::now() - start);
+
+      if (!firstPacket)
+        firstPacket = datagram.timestamp;
+      if (!options.maxSpeed && datagram.timestamp > firstPacket)
+        wait_until(startTime + datagram.timestamp - firstPacket);
+      if (loop == 0 && datagram.timestamp > firstPacket)
+        captureSpan = datagram.timestamp - firstPacket;
+
+      bool isRtcp = false;
+      if (is_sip(datagram.payload))
+      {
+        sipDatagrams++;
+        if (options.sip)
+          replay_sip(dispatch, datagram);
+      }
+      else if (is_rtp(datagram.payload, isRtcp))
+      {
+        if (isRtcp)
+        {
+          rtcpDatagrams++;
+        }
+        else
+        {
+          rtpDatagrams++;
+          if (options.rtp)
+            replay_rtp(datagram);
+        }
+      }
+      else
+      {
+        otherDatagrams++;
+      }
+    }
+  }
+  return captureSpan;
+}
+
+static void report(double elapsed, OSS::UInt64 captureSpan, OSS::UInt64 sipDatagrams, OSS::UInt64 rtpDatagrams, OSS::UInt64 replayStart)
+{
+  std::cout << std::endl
+    << "capture: " << options.file << " span: " << std::fixed << std::setprecision(3) << captureSpan / 1000000.0
+    << " s loops: " << options.loops << " mode: " << (options.maxSpeed ? "max" : "original") << std::endl
+    << "replay: " << elapsed << " s"
+    << " sip: " << sipDatagrams << " rtp: " << rtpDatagrams
+    << " rtcp: " << rtcpDatagrams << " other udp: " << otherDatagrams << std::endl;
+
+  if (!options.maxSpeed)
+  {
+    OSS::LatencyHistogram::Snapshot lateness;
+    scheduleLateness.snapshot(lateness);
+    std::cout << "schedule lateness us: p50=" << lateness.percentile(50)
+      << " p99=" << lateness.percentile(99) << " max=" << lateness.max << std::endl;
+  }
+
+  std::cout << std::endl
+    << std::left << std::setw(14) << "stage" << std::right
+    << std::setw(10) << "count"
+    << std::setw(12) << "busy s"
+    << std::setw(12) << "per sec"
+    << std::setw(9) << "p50 us"
+    << std::setw(9) << "p99 us"
+    << std::setw(9) << "max us" << std::endl;
+  readStage.report();
+  if (options.sip)
+  {
+    parseStage.report();
+    dispatchStage.report();
+  }
+  if (options.rtp)
+    rtpSendStage.report();
+
+  if (options.sip && sipDatagrams)
+  {
+    OSS::Metrics& metrics = OSS::Metrics::instance();
+    std::cout << std::endl
+      << "sip: transactions=" << metrics.counter("sip_transactions_created_total").value()
+      << " requests handled=" << handledRequests.value()
+      << " unmatched=" << metrics.counter("sip_unmatched_messages_total").value()
+      << " ack/2xx outside transactions=" << ackOr2xx.value()
+      << " parse errors=" << metrics.counter("sip_parse_errors_total").value()
+      << " writes=" << ReplayConnection::_writes.value() << std::endl;
+  }
+
+  if (options.rtp && rtpDatagrams)
+  {
+    OSS::UInt64 sent = 0;
+    OSS::UInt64 received = 0;
+    double jitterSum = 0;
+    double jitterMax = 0;
+    std::size_t flows = 0;
+    for (RelayFlows::iterator iter = relayFlows.begin(); iter != relayFlows.end(); iter++)
+    {
+      if (!iter->second)
+        continue;
+      OSS::mutex_critic_sec_lock lock(iter->second->mutex);
+      sent += iter->second->sent;
+      received += iter->second->received;
+      jitterSum += iter->second->jitter;
+      jitterMax = std::max(jitterMax, iter->second->jitter);
+      flows++;
+    }
+
+    OSS::LatencyHistogram::Snapshot transit;
+    OSS::LatencyHistogram::Snapshot variation;
+    relayTransit.snapshot(transit);
+    relayDelayVariation.snapshot(variation);
+    double relaySpan = lastReceive > replayStart ? (lastReceive - replayStart) / 1000000.0 : 0;
+
+    std::cout << std::endl
+      << "rtp relay: flows=" << flows << " sent=" << sent << " received=" << received
+      << " lost=" << (sent - received) << " skipped=" << skippedRtp << " relay errors=" << relayErrors << std::endl
+      << std::setprecision(0)
+      << "rtp relay throughput: " << (relaySpan > 0 ? received / relaySpan : 0) << " packets/s" << std::endl
+      << "rtp relay transit us: mean=" << transit.mean()
+      << " p50=" << transit.percentile(50)
+      << " p99=" << transit.percentile(99)
+      << " p99.9=" << transit.percentile(99.9)
+      << " max=" << transit.max << std::endl
+      << std::setprecision(1)
+      << "rtp relay added jitter us: mean=" << (flows ? jitterSum / flows : 0)
+      << " max=" << jitterMax
+      << " delay variation p99=" << variation.percentile(99)
+      << " max=" << variation.max << std::endl;
+  }
+
+  if (options.dumpMetrics)
+  {
+    std::string text;
+    OSS::Metrics::instance().toPrometheus(text);
+    std::cout << std::endl << text;
+  }
+}
+
+void usage()
+{
+  std::cout << std::endl << "Usage:  oss_pcap_replay [OPTIONS] FILE";
+  std::cout << std::endl << "  -x, --max-speed        send as fast as possible instead of at the capture timing";
+  std::cout << std::endl << "  -l, --loop N           replay the capture N times (default 1)";
+  std::cout << std::endl << "      --no-sip           do not replay SIP";
+  std::cout << std::endl << "      --no-rtp           do not replay RTP";
+  std::cout << std::endl << "  -f, --max-flows N      relay at most N RTP flows (default 256)";
+  std::cout << std::endl << "      --metrics          print the stack metrics at the end";
+  std::cout << std::endl << "  -v, --verbose          log at notice level";
+  std::cout << std::endl << "Example:  oss_pcap_replay --max-speed --loop 10 customer.pcap";
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  static struct option longOptions[] =
+  {
+    { "max-speed", no_argument, 0, 'x' },
+    { "loop", required_argument, 0, 'l' },
+    { "no-sip", no_argument, 0, 'S' },
+    { "no-rtp", no_argument, 0, 'R' },
+    { "max-flows", required_argument, 0, 'f' },
+    { "metrics", no_argument, 0, 'M' },
+    { "verbose", no_argument, 0, 'v' },
+    { "help", no_argument, 0, 'h' },
+    { 0, 0, 0, 0 }
+  };
+
+  options.maxSpeed = false;
+  options.loops = 1;
+  options.sip = true;
+  options.rtp = true;
+  options.maxFlows = 256;
+  options.dumpMetrics = false;
+  bool verbose = false;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "xl:f:vh", longOptions, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'x': options.maxSpeed = true; break;
+    case 'l': options.loops = OSS::string_to_number<int>(optarg); break;
+    case 'S': options.sip = false; break;
+    case 'R': options.rtp = false; break;
+    case 'f': options.maxFlows = OSS::string_to_number<std::size_t>(optarg); break;
+    case 'M': options.dumpMetrics = true; break;
+    case 'v': verbose = true; break;
+    default:
+      usage();
+      exit(-1);
+    }
+  }
+
+  if (optind != argc - 1 || options.loops <= 0)
+  {
+    usage();
+    exit(-1);
+  }
+  options.file = argv[optind];
+
+  OSS::OSS_init();
+  OSS::log_reset_level(verbose ? OSS::PRIO_NOTICE : OSS::PRIO_ERROR);
+
+  SIPFSMDispatch dispatch;
+  dispatch.requestHandler() = boost::bind(handle_request, _1, _2, _3);
+  dispatch.ackOr2xxTransactionHandler() = boost::bind(handle_ack_or_2xx, _1, _2);
+  dispatch.transport().run();
+
+  boost::asio::io_service::work work(io_service);
+  boost::thread ioThread(boost::bind(&boost::asio::io_service::run, &io_service));
+  if (options.rtp)
+  {
+    pRtpManager = new OSS::RTP::RTPProxyManager();
+    pRtpManager->run(1);
+    pRtpSession = new OSS::RTP::RTPProxySession(pRtpManager, "pcap-replay");
+  }
+
+  OSS::UInt64 sipDatagrams = 0;
+  OSS::UInt64 rtpDatagrams = 0;
+  OSS::UInt64 start = OSS::Metrics::now();
+  OSS::UInt64 captureSpan = replay(dispatch, sipDatagrams, rtpDatagrams);
+  double elapsed = (OSS::Metrics::now() - start) / 1000000.0;
+
+  //
+  // Let the relay drain before counting what arrived
+  //
+  boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+  report(elapsed, captureSpan, sipDatagrams, rtpDatagrams, start);
+
+  //
+  // Transaction timers and relay threads are still running
+  //
+  std::cout.flush();
+  _exit(0);
+}
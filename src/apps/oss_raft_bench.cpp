@@ -0,0 +1,494 @@
+#include "OSS/RAFT/RaftConsensus.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <unistd.h>
+
+//
+// oss_raft_bench - Measures committed entries per second on a three node
+// raft cluster.  All nodes run in this process and talk to each other
+// over TCP on the loopback interface.
+//
+
+using OSS::RAFT::RaftConsensus;
+using OSS::RAFT::RaftConnection;
+using OSS::RAFT::RaftNode;
+using OSS::RAFT::RaftSnapshot;
+using boost::asio::ip::tcp;
+
+#define BENCH_NODE_COUNT 3
+#define BENCH_BASE_PORT 28700
+
+enum MessageType
+{
+  MSG_REQUEST_VOTE,
+  MSG_REQUEST_VOTE_RESPONSE,
+  MSG_APPEND_ENTRIES,
+  MSG_APPEND_ENTRIES_RESPONSE,
+  MSG_SNAPSHOT
+};
+
+static boost::asio::io_service io_service;
+
+class Writer
+{
+public:
+  void i32(int32_t value)
+  {
+    _buf.append((const char*)&value, sizeof(value));
+  }
+  void bytes(const void* data, uint32_t len)
+  {
+    i32(len);
+    if (len)
+    {
+      _buf.append((const char*)data, len);
+    }
+  }
+  std::string frame(int type, int from)
+  {
+    std::string header;
+    int32_t head[3];
+    head[0] = _buf.size();
+    head[1] = type;
+    head[2] = from;
+    header.assign((const char*)head, sizeof(head));
+    return header + _buf;
+  }
+private:
+  std::string _buf;
+};
+
+class Reader
+{
+public:
+  Reader(const std::string& buf) : _buf(buf), _pos(0) {}
+  int32_t i32()
+  {
+    int32_t value = 0;
+    memcpy(&value, _buf.data() + _pos, sizeof(value));
+    _pos += sizeof(value);
+    return value;
+  }
+  std::string bytes()
+  {
+    int32_t len = i32();
+    std::string value = _buf.substr(_pos, len);
+    _pos += len;
+    return value;
+  }
+private:
+  const std::string& _buf;
+  std::size_t _pos;
+};
+
+class BenchNode;
+
+class TcpConnection : public RaftConnection
+{
+public:
+  TcpConnection(BenchNode* pNode, RaftNode& node);
+  void shutdown();
+  int onSendRequestVote(msg_requestvote_t& data);
+  int onSendAppendEntries(msg_appendentries_t& data);
+  int onSendRequestVoteResponse(msg_requestvote_response_t& data);
+  int onSendAppendEntriesResponse(msg_appendentries_response_t& data);
+  int onSendSnapshot(RaftSnapshot& snapshot);
+private:
+  int send(int type, Writer& writer);
+  BenchNode* _pNode;
+  tcp::socket _socket;
+  bool _connected;
+  OSS::mutex_critic_sec _writeMutex;
+};
+
+class BenchNode : public RaftConsensus
+{
+public:
+  BenchNode() : _acceptor(io_service), _applied(0) {}
+
+  Connection::Ptr createConnection(Node& node)
+  {
+    return Connection::Ptr(new TcpConnection(this, node));
+  }
+
+  int onApplyEntry(const raft_entry_t& entry)
+  {
+    _applied++;
+    return 0;
+  }
+
+  bool onCreateSnapshot(std::string& data)
+  {
+    data = OSS::string_from_number(_applied);
+    return true;
+  }
+
+  bool onRestoreSnapshot(const std::string& data)
+  {
+    _applied = OSS::string_to_number<int>(data.c_str());
+    return true;
+  }
+
+  bool listen(int port)
+  {
+    boost::system::error_code ec;
+    tcp::endpoint ep(boost::asio::ip::address::from_string("127.0.0.1"), port);
+    _acceptor.open(ep.protocol(), ec);
+    _acceptor.set_option(tcp::acceptor::reuse_address(true), ec);
+    _acceptor.bind(ep, ec);
+    _acceptor.listen(boost::asio::socket_base::max_connections, ec);
+    if (ec)
+    {
+      std::cerr << "Unable to listen on port " << port << ": " << ec.message() << std::endl;
+      return false;
+    }
+    _acceptThread = boost::thread(boost::bind(&BenchNode::acceptLoop, this));
+    return true;
+  }
+
+  void acceptLoop()
+  {
+    while (true)
+    {
+      boost::shared_ptr<tcp::socket> pSocket(new tcp::socket(io_service));
+      boost::system::error_code ec;
+      _acceptor.accept(*pSocket, ec);
+      if (ec)
+      {
+        return;
+      }
+      pSocket->set_option(tcp::no_delay(true), ec);
+      boost::thread(boost::bind(&BenchNode::readLoop, this, pSocket)).detach();
+    }
+  }
+
+  void readLoop(boost::shared_ptr<tcp::socket> pSocket)
+  {
+    boost::system::error_code ec;
+    std::string payload;
+    while (true)
+    {
+      int32_t head[3];
+      boost::asio::read(*pSocket, boost::asio::buffer(head, sizeof(head)), ec);
+      if (ec)
+      {
+        return;
+      }
+      payload.resize(head[0]);
+      if (head[0])
+      {
+        boost::asio::read(*pSocket, boost::asio::buffer(&payload[0], head[0]), ec);
+        if (ec)
+        {
+          return;
+        }
+      }
+
+      Node node;
+      if (!findNode(head[2], node))
+      {
+        continue;
+      }
+      Connection::Ptr pConnection = findOrCreateConnection(node);
+      dispatch(head[1], payload, pConnection);
+    }
+  }
+
+  void dispatch(int type, const std::string& payload, const Connection::Ptr& pConnection)
+  {
+    Reader reader(payload);
+    switch (type)
+    {
+    case MSG_REQUEST_VOTE:
+      {
+        msg_requestvote_t msg;
+        msg.term = reader.i32();
+        msg.candidate_id = reader.i32();
+        msg.last_log_idx = reader.i32();
+        msg.last_log_term = reader.i32();
+        onReceivedRequestVote(pConnection, msg);
+      }
+      break;
+    case MSG_REQUEST_VOTE_RESPONSE:
+      {
+        msg_requestvote_response_t msg;
+        msg.term = reader.i32();
+        msg.vote_granted = reader.i32();
+        onReceivedRequestVoteResponse(pConnection, msg);
+      }
+      break;
+    case MSG_APPEND_ENTRIES:
+      {
+        msg_appendentries_t msg;
+        msg.term = reader.i32();
+        msg.prev_log_idx = reader.i32();
+        msg.prev_log_term = reader.i32();
+        msg.leader_commit = reader.i32();
+        msg.n_entries = reader.i32();
+        std::vector<msg_entry_t> entries(msg.n_entries);
+        std::vector<std::string> payloads(msg.n_entries);
+        for (int i = 0; i < msg.n_entries; i++)
+        {
+          entries[i].term = reader.i32();
+          entries[i].id = reader.i32();
+          entries[i].type = reader.i32();
+          payloads[i] = reader.bytes();
+          entries[i].data.buf = (void*)payloads[i].data();
+          entries[i].data.len = payloads[i].size();
+        }
+        msg.entries = entries.empty() ? 0 : &entries[0];
+        onReceivedAppendEntries(pConnection, msg);
+      }
+      break;
+    case MSG_APPEND_ENTRIES_RESPONSE:
+      {
+        msg_appendentries_response_t msg;
+        msg.term = reader.i32();
+        msg.success = reader.i32();
+        msg.current_idx = reader.i32();
+        msg.first_idx = reader.i32();
+        onReceivedAppendEntriesResponse(pConnection, msg);
+      }
+      break;
+    case MSG_SNAPSHOT:
+      {
+        RaftSnapshot snapshot;
+        snapshot.term = reader.i32();
+        snapshot.last_idx = reader.i32();
+        snapshot.last_term = reader.i32();
+        snapshot.data = reader.bytes();
+        onReceivedSnapshot(pConnection, snapshot);
+      }
+      break;
+    }
+  }
+
+  void close()
+  {
+    boost::system::error_code ec;
+    _acceptor.close(ec);
+  }
+
+  int applied() const
+  {
+    return _applied;
+  }
+
+private:
+  tcp::acceptor _acceptor;
+  boost::thread _acceptThread;
+  int _applied;
+};
+
+TcpConnection::TcpConnection(BenchNode* pNode, RaftNode& node) :
+  RaftConnection(pNode, node),
+  _pNode(pNode),
+  _socket(io_service),
+  _connected(false)
+{
+}
+
+void TcpConnection::shutdown()
+{
+  boost::system::error_code ec;
+  _socket.close(ec);
+}
+
+int TcpConnection::send(int type, Writer& writer)
+{
+  OSS::mutex_critic_sec_lock lock(_writeMutex);
+  boost::system::error_code ec;
+  if (!_connected)
+  {
+    tcp::endpoint ep(boost::asio::ip::address::from_string("127.0.0.1"), BENCH_BASE_PORT + _node.getId());
+    _socket.connect(ep, ec);
+    if (ec)
+    {
+      _socket.close(ec);
+      return -1;
+    }
+    _socket.set_option(tcp::no_delay(true), ec);
+    _connected = true;
+  }
+
+  std::string frame = writer.frame(type, _pNode->opt().node_id);
+  boost::asio::write(_socket, boost::asio::buffer(frame), ec);
+  if (ec)
+  {
+    _socket.close(ec);
+    _connected = false;
+    return -1;
+  }
+  return 0;
+}
+
+int TcpConnection::onSendRequestVote(msg_requestvote_t& data)
+{
+  Writer writer;
+  writer.i32(data.term);
+  writer.i32(data.candidate_id);
+  writer.i32(data.last_log_idx);
+  writer.i32(data.last_log_term);
+  return send(MSG_REQUEST_VOTE, writer);
+}
+
+int TcpConnection::onSendAppendEntries(msg_appendentries_t& data)
+{
+  Writer writer;
+  writer.i32(data.term);
+  writer.i32(data.prev_log_idx);
+  writer.i32(data.prev_log_term);
+  writer.i32(data.leader_commit);
+  writer.i32(data.n_entries);
+  for (int i = 0; i < data.n_entries; i++)
+  {
+    writer.i32(data.entries[i].term);
+    writer.i32(data.entries[i].id);
+    writer.i32(data.entries[i].type);
+    writer.bytes(data.entries[i].data.buf, data.entries[i].data.len);
+  }
+  return send(MSG_APPEND_ENTRIES, writer);
+}
+
+int TcpConnection::onSendRequestVoteResponse(msg_requestvote_response_t& data)
+{
+  Writer writer;
+  writer.i32(data.term);
+  writer.i32(data.vote_granted);
+  return send(MSG_REQUEST_VOTE_RESPONSE, writer);
+}
+
+int TcpConnection::onSendAppendEntriesResponse(msg_appendentries_response_t& data)
+{
+  Writer writer;
+  writer.i32(data.term);
+  writer.i32(data.success);
+  writer.i32(data.current_idx);
+  writer.i32(data.first_idx);
+  return send(MSG_APPEND_ENTRIES_RESPONSE, writer);
+}
+
+int TcpConnection::onSendSnapshot(RaftSnapshot& snapshot)
+{
+  Writer writer;
+  writer.i32(snapshot.term);
+  writer.i32(snapshot.last_idx);
+  writer.i32(snapshot.last_term);
+  writer.bytes(snapshot.data.data(), snapshot.data.size());
+  return send(MSG_SNAPSHOT, writer);
+}
+
+void usage()
+{
+  std::cout << std::endl << "Usage:  oss_raft_bench [ENTRIES] [BATCH] [PAYLOAD_BYTES] [LOG_DIR]";
+  std::cout << std::endl << "Example:  oss_raft_bench 100000 64 128 /tmp/raft-bench";
+  std::cout << std::endl << "Without LOG_DIR the log is kept in memory only.";
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 5 || (argc > 1 && std::string(argv[1]) == "-h"))
+  {
+    usage();
+    exit(-1);
+  }
+
+  int entries = argc > 1 ? OSS::string_to_number<int>(argv[1]) : 100000;
+  int batchSize = argc > 2 ? OSS::string_to_number<int>(argv[2]) : 64;
+  int payloadSize = argc > 3 ? OSS::string_to_number<int>(argv[3]) : 128;
+  std::string logDir = argc > 4 ? argv[4] : "";
+  if (entries <= 0 || batchSize <= 0 || payloadSize < 0)
+  {
+    usage();
+    exit(-1);
+  }
+
+  BenchNode nodes[BENCH_NODE_COUNT];
+  for (int i = 0; i < BENCH_NODE_COUNT; i++)
+  {
+    RaftConsensus::Options opt;
+    opt.node_id = i + 1;
+    opt.is_master = (i == 0);
+    opt.periodic_timer_ms = 100;
+    opt.snapshot_threshold = 50000;
+    if (!logDir.empty())
+    {
+      opt.log_store_path = logDir + "/node-" + OSS::string_from_number(opt.node_id);
+      boost::filesystem::remove_all(opt.log_store_path);
+    }
+
+    if (!nodes[i].listen(BENCH_BASE_PORT + opt.node_id) || !nodes[i].initialize(opt))
+    {
+      std::cerr << "Unable to initialize node " << opt.node_id << std::endl;
+      exit(-1);
+    }
+
+    for (int peer = 1; peer <= BENCH_NODE_COUNT; peer++)
+    {
+      if (peer != opt.node_id)
+      {
+        nodes[i].addNode(peer);
+      }
+    }
+  }
+
+  for (int i = 0; i < BENCH_NODE_COUNT; i++)
+  {
+    nodes[i].run();
+  }
+
+  BenchNode& leader = nodes[0];
+  std::vector<std::string> batch(batchSize, std::string(payloadSize, 'x'));
+  int window = batchSize * RAFT_MAX_INFLIGHT_APPENDS * 2;
+  int submitted = 0;
+
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  while (submitted < entries)
+  {
+    if (submitted - leader.getCommitIndex() > window)
+    {
+      boost::this_thread::yield();
+      continue;
+    }
+
+    int count = std::min(batchSize, entries - submitted);
+    batch.resize(count);
+    if (!leader.submit(batch))
+    {
+      std::cerr << "Node 1 lost leadership" << std::endl;
+      exit(-1);
+    }
+    submitted += count;
+  }
+
+  while (leader.getCommitIndex() < entries)
+  {
+    boost::this_thread::sleep(boost::posix_time::microseconds(100));
+  }
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+
+  double seconds = (end - start).total_microseconds() / 1000000.0;
+  std::cout << "nodes: " << BENCH_NODE_COUNT
+    << " entries: " << entries
+    << " batch: " << batchSize
+    << " payload: " << payloadSize
+    << " store: " << (logDir.empty() ? "memory" : "lmdb") << std::endl;
+  std::cout << "elapsed: " << seconds << " s" << std::endl;
+  std::cout << "commits/s: " << (seconds > 0 ? entries / seconds : 0) << std::endl;
+
+  for (int i = 0; i < BENCH_NODE_COUNT; i++)
+  {
+    nodes[i].stop();
+    nodes[i].close();
+  }
+
+  //
+  // Reader threads may still be delivering messages
+  //
+  _exit(0);
+}
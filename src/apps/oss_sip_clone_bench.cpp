@@ -0,0 +1,131 @@
+#include "OSS/SIP/SIPMessage.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+//
+// oss_sip_clone_bench - Measures what it costs a B2BUA to produce the
+// outbound leg of a forwarded INVITE.  The inbound request is cloned and
+// then gets the edits a route normally applies: a new request-uri, our
+// Via on top, the top Route removed and our Contact.  The clone is then
+// serialized for the wire.  The same edits applied to a message parsed
+// again from the inbound wire data are reported next to it.
+//
+
+using namespace OSS::SIP;
+
+//
+// Every allocation made by the process goes through these counters.  The
+// benchmark is single threaded so plain integers are enough.
+//
+static std::size_t allocations = 0;
+static std::size_t allocatedBytes = 0;
+
+void* operator new(std::size_t size)
+{
+  allocations++;
+  allocatedBytes += size;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) throw()
+{
+  std::free(ptr);
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete[](void* ptr) throw()
+{
+  operator delete(ptr);
+}
+
+static const char* invite =
+  "INVITE sip:bob@biloxi.example.com SIP/2.0\r\n"
+  "Via: SIP/2.0/UDP pc33.atlanta.example.com:5060;branch=z9hG4bK776asdhds;rport\r\n"
+  "Max-Forwards: 70\r\n"
+  "Route: <sip:edge.atlanta.example.com;lr>\r\n"
+  "Route: <sip:core.biloxi.example.com;lr>\r\n"
+  "To: Bob <sip:bob@biloxi.example.com>\r\n"
+  "From: Alice <sip:alice@atlanta.example.com>;tag=1928301774\r\n"
+  "Call-ID: a84b4c76e66710@pc33.atlanta.example.com\r\n"
+  "CSeq: 314159 INVITE\r\n"
+  "Contact: <sip:alice@pc33.atlanta.example.com>\r\n"
+  "Allow: INVITE, ACK, CANCEL, OPTIONS, BYE, REFER, NOTIFY, MESSAGE, UPDATE\r\n"
+  "Supported: replaces, timer, 100rel\r\n"
+  "User-Agent: oss_sip_clone_bench\r\n"
+  "Content-Type: application/sdp\r\n"
+  "Content-Length: 142\r\n"
+  "\r\n"
+  "v=0\r\n"
+  "o=alice 2890844526 2890844526 IN IP4 pc33.atlanta.example.com\r\n"
+  "s=-\r\n"
+  "c=IN IP4 192.0.2.101\r\n"
+  "t=0 0\r\n"
+  "m=audio 49172 RTP/AVP 0\r\n"
+  "a=rtpmap:0 PCMU/8000\r\n";
+
+static volatile std::size_t sink = 0;
+
+static void route(SIPMessage& outbound)
+{
+  outbound.setStartLine("INVITE sip:bob@192.0.2.4:5060 SIP/2.0");
+  outbound.hdrListPrepend(HDR_VIA, "SIP/2.0/UDP 192.0.2.1:5060;branch=z9hG4bK-b2b-1;rport");
+  outbound.hdrListPopFront(HDR_ROUTE);
+  outbound.hdrSet(HDR_CONTACT, "<sip:b2b@192.0.2.1:5060>");
+  outbound.commitData();
+  sink += outbound.data().size();
+}
+
+static void forwardClone(const SIPMessage& inbound)
+{
+  SIPMessage* outbound = new SIPMessage(inbound);
+  route(*outbound);
+  delete outbound;
+}
+
+static void forwardReparse(const SIPMessage& inbound)
+{
+  SIPMessage* outbound = new SIPMessage(inbound.data());
+  outbound->parse();
+  route(*outbound);
+  delete outbound;
+}
+
+static void run(const char* name, void (*forward)(const SIPMessage&), const SIPMessage& inbound, int iterations)
+{
+  std::size_t startAllocations = allocations;
+  std::size_t startBytes = allocatedBytes;
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  for (int i = 0; i < iterations; i++)
+    forward(inbound);
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+
+  std::cout << name
+    << " bytes/invite: " << (allocatedBytes - startBytes) / iterations
+    << " allocations/invite: " << (allocations - startAllocations) / iterations
+    << " ns/invite: " << (end - start).total_microseconds() * 1000.0 / iterations
+    << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+  if (iterations <= 0)
+    iterations = 1;
+
+  SIPMessage inbound(invite);
+  inbound.parse();
+  inbound.commitData();
+
+  run("clone  ", forwardClone, inbound, iterations);
+  run("reparse", forwardReparse, inbound, iterations);
+  return 0;
+}
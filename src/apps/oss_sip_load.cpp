@@ -0,0 +1,924 @@
+#include "OSS/SIP/SIPStack.h"
+#include "OSS/SIP/SIPMessage.h"
+#include "OSS/SIP/SIPContact.h"
+#include "OSS/SIP/SIPRoute.h"
+#include "OSS/SIP/SIPStatusLine.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+
+//
+// oss_sip_load - SIP traffic generator for capacity tests.  The UAC places
+// INVITE/ACK/BYE calls or sends REGISTER requests at a fixed rate and the
+// UAS answers them.  Both sides run on their own SIPStack so the traffic
+// goes through the same transports and transaction pools as the B2BUA.
+// In loopback mode both sides run in this process.  Point the UAC at an
+// oss_core instance and run the UAS behind it to load the B2BUA.
+//
+// With --rtp every established call sends one 20 ms PCMU packet per ptime
+// to the media address of the answer until it hangs up.  Behind oss_core
+// that address is the RTP relay.  The UAS counts what reaches it.
+//
+
+using namespace OSS::SIP;
+using OSS::Net::IPAddress;
+using boost::asio::ip::udp;
+
+#define RTP_PTIME_MS 20
+#define RTP_PAYLOAD_SIZE 160
+#define RTP_HEADER_SIZE 12
+#define TIMER_T1_MS 500
+#define TIMER_T2_MS 4000
+#define TIMER_H_MS (64 * TIMER_T1_MS)
+#define CLIENT_PORT_BASE 20000
+#define CLIENT_PORT_MAX 30000
+
+struct Options
+{
+  std::string role;
+  std::string scenario;
+  std::string transport;
+  IPAddress local;
+  IPAddress remote;
+  double rate;
+  int total;
+  int holdMs;
+  bool rtp;
+  unsigned short rtpPort;
+  std::string tlsCert;
+  std::string tlsKey;
+  std::string tlsPassword;
+  bool dumpMetrics;
+};
+
+struct Stats
+{
+  OSS::MetricCounter started;
+  OSS::MetricCounter established;
+  OSS::MetricCounter completed;
+  OSS::MetricCounter failed;
+  OSS::MetricCounter timeouts;
+  OSS::MetricCounter retransmitted2xx;
+  OSS::MetricCounter rtpSent;
+  OSS::MetricCounter uasRequests;
+  OSS::MetricCounter uas2xxRetransmits;
+  OSS::MetricCounter uasStrayAcks;
+  OSS::MetricCounter rtpReceived;
+  OSS::MetricCounter rtpReceivedBytes;
+  OSS::LatencyHistogram setup;
+};
+
+struct Call
+{
+  typedef boost::shared_ptr<Call> Ptr;
+
+  std::string callId;
+  std::string fromTag;
+  std::string toTag;
+  std::string user;
+  std::string requestUri;
+  std::list<std::string> routes;
+  OSS::UInt64 startTime;
+  bool established;
+  boost::shared_ptr<boost::asio::deadline_timer> timer;
+
+  //
+  // UAC media
+  //
+  boost::shared_ptr<udp::socket> rtpSocket;
+  udp::endpoint rtpTarget;
+  OSS::UInt16 rtpSeq;
+  OSS::UInt32 rtpTimestamp;
+  OSS::UInt32 rtpSsrc;
+
+  //
+  // UAS 2xx retransmission
+  //
+  SIPMessage::Ptr response;
+  SIPTransportSession::Ptr transport;
+  IPAddress target;
+  int interval;
+};
+
+typedef std::map<std::string, Call::Ptr> Calls;
+
+static Options options;
+static Stats stats;
+static boost::asio::io_service io_service;
+static SIPStack* pUacStack = 0;
+static SIPStack* pUasStack = 0;
+static IPAddress uasAddress;
+static OSS::mutex_critic_sec uacMutex;
+static Calls uacCalls;
+static OSS::mutex_critic_sec uasMutex;
+static Calls uasCalls;
+static boost::shared_ptr<udp::socket> uasRtpSocket;
+static udp::endpoint uasRtpSender;
+static char uasRtpBuffer[2048];
+static volatile bool terminated = false;
+
+static std::string via_proto()
+{
+  std::string proto = options.transport;
+  OSS::string_to_upper(proto);
+  return proto;
+}
+
+static std::string create_sdp(const IPAddress& address, unsigned short port)
+{
+  std::ostringstream sdp;
+  sdp << "v=0\r\n"
+    << "o=oss_sip_load 1 1 IN IP4 " << address.toString() << "\r\n"
+    << "s=-\r\n"
+    << "c=IN IP4 " << address.toString() << "\r\n"
+    << "t=0 0\r\n"
+    << "m=audio " << port << " RTP/AVP 0\r\n"
+    << "a=rtpmap:0 PCMU/8000\r\n"
+    << "a=ptime:" << RTP_PTIME_MS << "\r\n";
+  return sdp.str();
+}
+
+static bool get_sdp_media(const std::string& sdp, udp::endpoint& media)
+{
+  std::size_t c = sdp.find("c=IN IP4 ");
+  std::size_t m = sdp.find("m=audio ");
+  if (c == std::string::npos || m == std::string::npos)
+    return false;
+  std::string ip = sdp.substr(c + 9, sdp.find_first_of("\r\n", c) - c - 9);
+  unsigned short port = OSS::string_to_number<unsigned short>(sdp.substr(m + 8, sdp.find(' ', m + 8) - m - 8).c_str());
+  boost::system::error_code ec;
+  boost::asio::ip::address address = boost::asio::ip::address::from_string(ip, ec);
+  if (ec || !port)
+    return false;
+  media = udp::endpoint(address, port);
+  return true;
+}
+
+static int get_status_code(const SIPMessage::Ptr& pMsg)
+{
+  std::string code;
+  if (!SIPStatusLine::getStatusCode(pMsg->startLine(), code))
+    return 0;
+  return OSS::string_to_number<int>(code.c_str());
+}
+
+static SIPMessage::Ptr create_request(const Call::Ptr& call, const std::string& method, int cseq, const std::string& body)
+{
+  std::ostringstream strm;
+  strm << method << " " << call->requestUri << " SIP/2.0\r\n"
+    << "Via: SIP/2.0/" << via_proto() << " " << options.local.toIpPortString()
+      << ";branch=" << SIPMessage::createBranchString() << ";rport\r\n"
+    << "Max-Forwards: 70\r\n";
+  for (std::list<std::string>::const_iterator iter = call->routes.begin(); iter != call->routes.end(); iter++)
+    strm << "Route: " << *iter << "\r\n";
+  strm << "From: <sip:" << call->user << "@" << options.local.toString() << ">;tag=" << call->fromTag << "\r\n";
+  if (call->toTag.empty())
+    strm << "To: <sip:" << (method == "REGISTER" ? call->user : "uas") << "@" << options.remote.toIpPortString() << ">\r\n";
+  else
+    strm << "To: <sip:uas@" << options.remote.toIpPortString() << ">;tag=" << call->toTag << "\r\n";
+  strm << "Call-ID: " << call->callId << "\r\n"
+    << "CSeq: " << cseq << " " << method << "\r\n"
+    << "Contact: <sip:" << call->user << "@" << options.local.toIpPortString() << ";transport=" << options.transport << ">\r\n";
+  if (method == "REGISTER")
+    strm << "Expires: 3600\r\n";
+  if (!body.empty())
+    strm << "Content-Type: application/sdp\r\n";
+  strm << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+
+  SIPMessage::Ptr pRequest(new SIPMessage(strm.str()));
+  pRequest->parse();
+  return pRequest;
+}
+
+//
+// UAC
+//
+
+static void uac_finish(const Call::Ptr& call, bool completed)
+{
+  {
+    OSS::mutex_critic_sec_lock lock(uacMutex);
+    if (!uacCalls.erase(call->callId))
+      return;
+    if (call->timer)
+      call->timer->cancel();
+    if (call->rtpSocket)
+    {
+      boost::system::error_code ec;
+      call->rtpSocket->close(ec);
+      call->rtpSocket.reset();
+    }
+  }
+
+  if (completed)
+    stats.completed.increment();
+  else
+    stats.failed.increment();
+}
+
+static void uac_send_ack(const Call::Ptr& call)
+{
+  pUacStack->sendRequestDirect(create_request(call, "ACK", 1, ""), options.local, options.remote);
+}
+
+static void uac_handle_bye_response(const Call::Ptr& call,
+  const SIPTransaction::Error& e, const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr&, const SIPTransaction::Ptr&)
+{
+  if (e)
+  {
+    stats.timeouts.increment();
+    uac_finish(call, false);
+    return;
+  }
+
+  int code = get_status_code(pMsg);
+  if (code >= 200)
+    uac_finish(call, code < 300);
+}
+
+static void uac_send_bye(const Call::Ptr& call, const boost::system::error_code& e)
+{
+  if (e == boost::asio::error::operation_aborted)
+    return;
+
+  {
+    //
+    // Stop the media before hanging up
+    //
+    OSS::mutex_critic_sec_lock lock(uacMutex);
+    call->rtpTarget = udp::endpoint();
+  }
+
+  try
+  {
+    pUacStack->sendRequest(create_request(call, "BYE", 2, ""), options.local, options.remote,
+      boost::bind(uac_handle_bye_response, call, _1, _2, _3, _4), SIPTransaction::TerminateCallback());
+  }
+  catch(OSS::Exception& e)
+  {
+    uac_finish(call, false);
+  }
+}
+
+static void uac_handle_invite_response(const Call::Ptr& call,
+  const SIPTransaction::Error& e, const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr&, const SIPTransaction::Ptr&)
+{
+  if (e)
+  {
+    stats.timeouts.increment();
+    uac_finish(call, false);
+    return;
+  }
+
+  int code = get_status_code(pMsg);
+  if (code < 200)
+    return;
+
+  if (code >= 300)
+  {
+    uac_finish(call, false);
+    return;
+  }
+
+  {
+    OSS::mutex_critic_sec_lock lock(uacMutex);
+    if (call->established || uacCalls.find(call->callId) == uacCalls.end())
+      return;
+    call->established = true;
+    call->toTag = pMsg->getToTag();
+
+    ContactList contacts;
+    SIPContact::msgGetContacts(pMsg.get(), contacts);
+    if (!contacts.empty())
+      call->requestUri = contacts.front().getURI();
+
+    //
+    // The UAC route set is the Record-Route of the response in reverse
+    //
+    std::list<std::string> recordRoutes;
+    SIPRecordRoute::msgGetRecordRoutes(pMsg.get(), recordRoutes);
+    call->routes.assign(recordRoutes.rbegin(), recordRoutes.rend());
+
+    if (call->rtpSocket)
+      get_sdp_media(pMsg->getBody(), call->rtpTarget);
+  }
+
+  stats.setup.record(OSS::Metrics::now() - call->startTime);
+  stats.established.increment();
+
+  uac_send_ack(call);
+  call->timer->expires_from_now(boost::posix_time::milliseconds(options.holdMs));
+  call->timer->async_wait(boost::bind(uac_send_bye, call, boost::asio::placeholders::error));
+}
+
+static void uac_handle_register_response(const Call::Ptr& call,
+  const SIPTransaction::Error& e, const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr&, const SIPTransaction::Ptr&)
+{
+  if (e)
+  {
+    stats.timeouts.increment();
+    uac_finish(call, false);
+    return;
+  }
+
+  int code = get_status_code(pMsg);
+  if (code < 200)
+    return;
+
+  if (code < 300)
+  {
+    stats.setup.record(OSS::Metrics::now() - call->startTime);
+    stats.established.increment();
+  }
+  uac_finish(call, code < 300);
+}
+
+static void uac_handle_ack_or_2xx(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr&)
+{
+  //
+  // The INVITE transaction is gone once the first 2xx arrives.  Every
+  // other 2xx is a retransmission and gets the ACK again.
+  //
+  if (pMsg->isRequest() || get_status_code(pMsg) >= 300)
+    return;
+
+  Call::Ptr call;
+  {
+    OSS::mutex_critic_sec_lock lock(uacMutex);
+    Calls::iterator iter = uacCalls.find(pMsg->getCallId());
+    if (iter == uacCalls.end() || !iter->second->established)
+      return;
+    call = iter->second;
+  }
+  stats.retransmitted2xx.increment();
+  uac_send_ack(call);
+}
+
+static void uac_start(int index)
+{
+  Call::Ptr call(new Call());
+  call->callId = SIPMessage::createTagString() + "@" + options.local.toString();
+  call->fromTag = SIPMessage::createTagString();
+  call->user = "load" + OSS::string_from_number(index);
+  call->requestUri = options.scenario == "register"
+    ? "sip:" + options.remote.toIpPortString()
+    : "sip:uas@" + options.remote.toIpPortString();
+  call->established = false;
+  call->timer.reset(new boost::asio::deadline_timer(io_service));
+  call->rtpSeq = 0;
+  call->rtpTimestamp = 0;
+  call->rtpSsrc = index;
+  call->interval = 0;
+
+  std::string body;
+  if (options.scenario == "call" && options.rtp)
+  {
+    boost::system::error_code ec;
+    call->rtpSocket.reset(new udp::socket(io_service));
+    call->rtpSocket->open(udp::v4(), ec);
+    if (!ec)
+      call->rtpSocket->bind(udp::endpoint(options.local.address(), 0), ec);
+    if (ec)
+    {
+      std::cerr << "Unable to bind RTP socket - " << ec.message() << std::endl;
+      call->rtpSocket.reset();
+    }
+    else
+    {
+      body = create_sdp(options.local, call->rtpSocket->local_endpoint().port());
+    }
+  }
+  else if (options.scenario == "call")
+  {
+    body = create_sdp(options.local, 0);
+  }
+
+  {
+    OSS::mutex_critic_sec_lock lock(uacMutex);
+    uacCalls[call->callId] = call;
+  }
+  stats.started.increment();
+  call->startTime = OSS::Metrics::now();
+
+  try
+  {
+    if (options.scenario == "register")
+    {
+      pUacStack->sendRequest(create_request(call, "REGISTER", 1, ""), options.local, options.remote,
+        boost::bind(uac_handle_register_response, call, _1, _2, _3, _4), SIPTransaction::TerminateCallback());
+    }
+    else
+    {
+      pUacStack->sendRequest(create_request(call, "INVITE", 1, body), options.local, options.remote,
+        boost::bind(uac_handle_invite_response, call, _1, _2, _3, _4), SIPTransaction::TerminateCallback());
+    }
+  }
+  catch(OSS::Exception& e)
+  {
+    std::cerr << "Unable to send request - " << e.message() << std::endl;
+    uac_finish(call, false);
+  }
+}
+
+static void uac_send_rtp(boost::asio::deadline_timer* pTimer, const boost::system::error_code& e)
+{
+  if (e == boost::asio::error::operation_aborted)
+    return;
+
+  //
+  // One packet per ptime for every established call.  The next tick is
+  // scheduled from the previous deadline so a late tick does not slow
+  // down the packet rate.
+  //
+  char packet[RTP_HEADER_SIZE + RTP_PAYLOAD_SIZE];
+  memset(packet + RTP_HEADER_SIZE, 0xFF, RTP_PAYLOAD_SIZE);
+  {
+    OSS::mutex_critic_sec_lock lock(uacMutex);
+    for (Calls::iterator iter = uacCalls.begin(); iter != uacCalls.end(); iter++)
+    {
+      Call& call = *iter->second;
+      if (!call.rtpSocket || !call.rtpTarget.port())
+        continue;
+      packet[0] = (char)0x80;
+      packet[1] = 0;
+      OSS::UInt16 seq = htons(call.rtpSeq++);
+      OSS::UInt32 timestamp = htonl(call.rtpTimestamp);
+      OSS::UInt32 ssrc = htonl(call.rtpSsrc);
+      memcpy(packet + 2, &seq, 2);
+      memcpy(packet + 4, &timestamp, 4);
+      memcpy(packet + 8, &ssrc, 4);
+      call.rtpTimestamp += RTP_PAYLOAD_SIZE;
+
+      boost::system::error_code ec;
+      call.rtpSocket->send_to(boost::asio::buffer(packet, sizeof(packet)), call.rtpTarget, 0, ec);
+      if (!ec)
+        stats.rtpSent.increment();
+    }
+  }
+
+  pTimer->expires_at(pTimer->expires_at() + boost::posix_time::milliseconds(RTP_PTIME_MS));
+  pTimer->async_wait(boost::bind(uac_send_rtp, pTimer, boost::asio::placeholders::error));
+}
+
+//
+// UAS
+//
+
+static void uas_retransmit_2xx(const Call::Ptr& call, const boost::system::error_code& e)
+{
+  if (e == boost::asio::error::operation_aborted)
+    return;
+
+  {
+    OSS::mutex_critic_sec_lock lock(uasMutex);
+    if (uasCalls.find(call->callId) == uasCalls.end())
+      return;
+    if (OSS::Metrics::now() - call->startTime > (OSS::UInt64)TIMER_H_MS * 1000)
+    {
+      uasCalls.erase(call->callId);
+      return;
+    }
+  }
+
+  stats.uas2xxRetransmits.increment();
+  call->transport->writeMessage(call->response, call->target.toString(), OSS::string_from_number(call->target.getPort()));
+  call->interval = std::min(call->interval * 2, TIMER_T2_MS);
+  call->timer->expires_from_now(boost::posix_time::milliseconds(call->interval));
+  call->timer->async_wait(boost::bind(uas_retransmit_2xx, call, boost::asio::placeholders::error));
+}
+
+static void uas_handle_request(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr& pTransport, const SIPTransaction::Ptr& pTransaction)
+{
+  stats.uasRequests.increment();
+  std::string contact = "<sip:uas@" + uasAddress.toIpPortString() + ";transport=" + options.transport + ">";
+  SIPMessage::Ptr pResponse;
+  if (pMsg->isRequest("INVITE"))
+  {
+    pResponse = pMsg->createResponse(200, "", SIPMessage::createTagString(), contact);
+    if (!pMsg->getBody().empty())
+    {
+      std::string sdp = create_sdp(uasAddress, options.rtp ? options.rtpPort : 0);
+      pResponse->hdrSet(OSS::SIP::HDR_CONTENT_TYPE, "application/sdp");
+      pResponse->hdrSet(OSS::SIP::HDR_CONTENT_LENGTH, OSS::string_from_number(sdp.size()));
+      pResponse->setBody(sdp);
+    }
+  }
+  else if (pMsg->isRequest("REGISTER"))
+  {
+    pResponse = pMsg->createResponse(200, "", SIPMessage::createTagString(), pMsg->hdrGet(OSS::SIP::HDR_CONTACT));
+    pResponse->hdrSet(OSS::SIP::HDR_EXPIRES, "3600");
+  }
+  else
+  {
+    pResponse = pMsg->createResponse(200);
+  }
+  pResponse->commitData();
+
+  IPAddress target = pTransport->getRemoteAddress();
+  pTransaction->sendResponse(pResponse, target);
+
+  if (pMsg->isRequest("INVITE") && !pTransport->isReliableTransport())
+  {
+    //
+    // The transaction layer does not retransmit 2xx.  Keep sending it
+    // until the ACK arrives.
+    //
+    Call::Ptr call(new Call());
+    call->callId = pMsg->getCallId();
+    call->startTime = OSS::Metrics::now();
+    call->response = pResponse;
+    call->transport = pTransport;
+    call->target = target;
+    call->interval = TIMER_T1_MS;
+    call->timer.reset(new boost::asio::deadline_timer(io_service));
+    {
+      OSS::mutex_critic_sec_lock lock(uasMutex);
+      uasCalls[call->callId] = call;
+    }
+    call->timer->expires_from_now(boost::posix_time::milliseconds(call->interval));
+    call->timer->async_wait(boost::bind(uas_retransmit_2xx, call, boost::asio::placeholders::error));
+  }
+}
+
+static void uas_handle_ack_or_2xx(const SIPMessage::Ptr& pMsg, const SIPTransportSession::Ptr&)
+{
+  if (!pMsg->isRequest("ACK"))
+    return;
+
+  OSS::mutex_critic_sec_lock lock(uasMutex);
+  Calls::iterator iter = uasCalls.find(pMsg->getCallId());
+  if (iter == uasCalls.end())
+  {
+    //
+    // Reliable transports and ACKs for retransmitted 2xx
+    //
+    stats.uasStrayAcks.increment();
+    return;
+  }
+  iter->second->timer->cancel();
+  uasCalls.erase(iter);
+}
+
+static void uas_receive_rtp(const boost::system::error_code& e, std::size_t bytes)
+{
+  if (e == boost::asio::error::operation_aborted)
+    return;
+  if (!e)
+  {
+    stats.rtpReceived.increment();
+    stats.rtpReceivedBytes.increment(bytes);
+  }
+  uasRtpSocket->async_receive_from(boost::asio::buffer(uasRtpBuffer, sizeof(uasRtpBuffer)), uasRtpSender,
+    boost::bind(uas_receive_rtp, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+}
+
+//
+// Setup and reporting
+//
+
+static bool add_listener(SIPStack& stack, const IPAddress& address)
+{
+  IPAddress listener(address);
+  if (options.transport == "udp")
+  {
+    listener.setProtocol(IPAddress::UDP);
+    stack.udpListeners().push_back(listener);
+  }
+  else if (options.transport == "tcp")
+  {
+    listener.setProtocol(IPAddress::TCP);
+    stack.tcpListeners().push_back(listener);
+  }
+  else if (options.transport == "tls")
+  {
+    listener.setProtocol(IPAddress::TLS);
+    stack.tlsListeners().push_back(listener);
+    if (!options.tlsCert.empty() && !stack.initializeTlsContext(options.tlsCert, options.tlsKey, options.tlsPassword, "", "", false))
+      return false;
+  }
+  else if (options.transport == "ws")
+  {
+    listener.setProtocol(IPAddress::WS);
+    stack.wsListeners().push_back(listener);
+  }
+  else
+  {
+    return false;
+  }
+
+  stack.transport().setTCPPortRange(CLIENT_PORT_BASE, CLIENT_PORT_MAX);
+  try
+  {
+    stack.transportInit();
+    stack.run();
+  }
+  catch(OSS::Exception& e)
+  {
+    std::cerr << "Unable to start transport " << address.toIpPortString() << " - " << e.message() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static OSS::UInt64 retransmissions()
+{
+  static OSS::MetricCounter& requests = OSS::Metrics::instance().counter("sip_request_retransmissions_total");
+  return requests.value() + stats.retransmitted2xx.value() + stats.uas2xxRetransmits.value();
+}
+
+static void report_progress(double seconds, OSS::UInt64 lastEstablished, double interval)
+{
+  OSS::UInt64 started = stats.started.value();
+  OSS::UInt64 completed = stats.completed.value();
+  OSS::UInt64 failed = stats.failed.value();
+  OSS::UInt64 established = stats.established.value();
+  std::cout << std::fixed << std::setprecision(1)
+    << "t=" << seconds << "s"
+    << " started=" << started
+    << " established=" << established
+    << " completed=" << completed
+    << " failed=" << failed
+    << " active=" << (started - completed - failed)
+    << " rate=" << (established - lastEstablished) / interval << "/s"
+    << " retrans=" << retransmissions();
+  if (options.rtp)
+    std::cout << " rtp-sent=" << stats.rtpSent.value() << " rtp-recv=" << stats.rtpReceived.value();
+  std::cout << std::endl;
+}
+
+static void report_summary(double seconds)
+{
+  OSS::LatencyHistogram::Snapshot setup;
+  stats.setup.snapshot(setup);
+  std::cout << std::endl
+    << "scenario: " << options.scenario << " transport: " << options.transport
+    << " offered: " << options.rate << "/s total: " << options.total << std::endl;
+  std::cout << std::fixed << std::setprecision(1)
+    << "elapsed: " << seconds << " s" << std::endl
+    << "established: " << stats.established.value()
+    << " completed: " << stats.completed.value()
+    << " failed: " << stats.failed.value()
+    << " timeouts: " << stats.timeouts.value() << std::endl
+    << "achieved: " << (seconds > 0 ? stats.established.value() / seconds : 0) << "/s" << std::endl
+    << "retransmissions: " << retransmissions()
+    << " (2xx received again: " << stats.retransmitted2xx.value()
+    << ", 2xx resent by uas: " << stats.uas2xxRetransmits.value() << ")" << std::endl
+    << "setup latency us: mean=" << setup.mean()
+    << " p50=" << setup.percentile(50)
+    << " p90=" << setup.percentile(90)
+    << " p99=" << setup.percentile(99)
+    << " p99.9=" << setup.percentile(99.9)
+    << " max=" << setup.max << std::endl;
+  if (options.rtp)
+  {
+    std::cout << "rtp sent: " << stats.rtpSent.value()
+      << " received: " << stats.rtpReceived.value()
+      << " bytes: " << stats.rtpReceivedBytes.value() << std::endl;
+  }
+  if (options.dumpMetrics)
+  {
+    std::string text;
+    OSS::Metrics::instance().toPrometheus(text);
+    std::cout << std::endl << text;
+  }
+}
+
+static void run_uac()
+{
+  boost::asio::deadline_timer rtpTimer(io_service);
+  if (options.rtp && options.scenario == "call")
+  {
+    rtpTimer.expires_from_now(boost::posix_time::milliseconds(RTP_PTIME_MS));
+    rtpTimer.async_wait(boost::bind(uac_send_rtp, &rtpTimer, boost::asio::placeholders::error));
+  }
+
+  //
+  // Requests are started on a fixed schedule from the start time.  A late
+  // wakeup starts everything that became due so the offered rate holds.
+  //
+  OSS::UInt64 start = OSS::Metrics::now();
+  OSS::UInt64 lastReport = start;
+  OSS::UInt64 lastEstablished = 0;
+  int index = 0;
+  while (!terminated && index < options.total)
+  {
+    OSS::UInt64 now = OSS::Metrics::now();
+    int due = std::min((int)((now - start) * options.rate / 1000000.0) + 1, options.total);
+    while (index < due)
+      uac_start(index++);
+
+    if (now - lastReport >= 1000000)
+    {
+      report_progress((now - start) / 1000000.0, lastEstablished, (now - lastReport) / 1000000.0);
+      lastEstablished = stats.established.value();
+      lastReport = now;
+    }
+    boost::this_thread::sleep(boost::posix_time::microseconds(500));
+  }
+
+  //
+  // Wait for the calls in progress to end
+  //
+  OSS::UInt64 drainStart = OSS::Metrics::now();
+  while (!terminated)
+  {
+    {
+      OSS::mutex_critic_sec_lock lock(uacMutex);
+      if (uacCalls.empty())
+        break;
+    }
+    OSS::UInt64 now = OSS::Metrics::now();
+    if (now - drainStart > (OSS::UInt64)(TIMER_H_MS + options.holdMs) * 1000)
+      break;
+    if (now - lastReport >= 1000000)
+    {
+      report_progress((now - start) / 1000000.0, lastEstablished, (now - lastReport) / 1000000.0);
+      lastEstablished = stats.established.value();
+      lastReport = now;
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+
+  report_summary((OSS::Metrics::now() - start) / 1000000.0);
+  rtpTimer.cancel();
+}
+
+static void run_uas()
+{
+  OSS::UInt64 start = OSS::Metrics::now();
+  while (!terminated)
+  {
+    boost::this_thread::sleep(boost::posix_time::seconds(1));
+    std::cout << std::fixed << std::setprecision(1)
+      << "t=" << (OSS::Metrics::now() - start) / 1000000.0 << "s"
+      << " requests=" << stats.uasRequests.value()
+      << " 2xx-resent=" << stats.uas2xxRetransmits.value()
+      << " rtp-recv=" << stats.rtpReceived.value() << std::endl;
+  }
+}
+
+static void on_terminate(int)
+{
+  terminated = true;
+}
+
+void usage()
+{
+  std::cout << std::endl << "Usage:  oss_sip_load [OPTIONS]";
+  std::cout << std::endl << "  -m, --role ROLE          uac, uas or loopback (default loopback)";
+  std::cout << std::endl << "  -s, --scenario NAME      call (INVITE/ACK/BYE) or register (default call)";
+  std::cout << std::endl << "  -t, --transport PROTO    udp, tcp, tls or ws (default udp)";
+  std::cout << std::endl << "  -l, --local IP:PORT      UAC address, or UAS address in uas role (default 127.0.0.1:35060)";
+  std::cout << std::endl << "  -r, --remote IP:PORT     target of the UAC, UAS address in loopback (default 127.0.0.1:35062)";
+  std::cout << std::endl << "  -c, --rate N             calls or registrations started per second (default 100)";
+  std::cout << std::endl << "  -n, --total N            number of calls or registrations (default 1000)";
+  std::cout << std::endl << "  -d, --hold MS            time between ACK and BYE (default 0)";
+  std::cout << std::endl << "  -p, --rtp PORT           send paced RTP on every call, the UAS receives on PORT";
+  std::cout << std::endl << "      --tls-cert FILE      certificate of the TLS listener";
+  std::cout << std::endl << "      --tls-key FILE       private key of the TLS listener";
+  std::cout << std::endl << "      --tls-password PASS  password of the private key";
+  std::cout << std::endl << "      --metrics            print the stack metrics at the end";
+  std::cout << std::endl << "  -v, --verbose            log at notice level";
+  std::cout << std::endl << "Example:  oss_sip_load --rate 500 --total 10000 --hold 2000 --rtp 41000";
+  std::cout << std::endl << "WS is only available in the uas role.  The transport service does not open WS client connections.";
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  static struct option longOptions[] =
+  {
+    { "role", required_argument, 0, 'm' },
+    { "scenario", required_argument, 0, 's' },
+    { "transport", required_argument, 0, 't' },
+    { "local", required_argument, 0, 'l' },
+    { "remote", required_argument, 0, 'r' },
+    { "rate", required_argument, 0, 'c' },
+    { "total", required_argument, 0, 'n' },
+    { "hold", required_argument, 0, 'd' },
+    { "rtp", required_argument, 0, 'p' },
+    { "tls-cert", required_argument, 0, 'C' },
+    { "tls-key", required_argument, 0, 'K' },
+    { "tls-password", required_argument, 0, 'P' },
+    { "metrics", no_argument, 0, 'M' },
+    { "verbose", no_argument, 0, 'v' },
+    { "help", no_argument, 0, 'h' },
+    { 0, 0, 0, 0 }
+  };
+
+  options.role = "loopback";
+  options.scenario = "call";
+  options.transport = "udp";
+  options.local = IPAddress::fromV4IPPort("127.0.0.1:35060");
+  options.remote = IPAddress::fromV4IPPort("127.0.0.1:35062");
+  options.rate = 100;
+  options.total = 1000;
+  options.holdMs = 0;
+  options.rtp = false;
+  options.rtpPort = 0;
+  options.dumpMetrics = false;
+  bool verbose = false;
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "m:s:t:l:r:c:n:d:p:vh", longOptions, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'm': options.role = optarg; break;
+    case 's': options.scenario = optarg; break;
+    case 't': options.transport = optarg; OSS::string_to_lower(options.transport); break;
+    case 'l': options.local = IPAddress::fromV4IPPort(optarg); break;
+    case 'r': options.remote = IPAddress::fromV4IPPort(optarg); break;
+    case 'c': options.rate = OSS::string_to_number<double>(optarg); break;
+    case 'n': options.total = OSS::string_to_number<int>(optarg); break;
+    case 'd': options.holdMs = OSS::string_to_number<int>(optarg); break;
+    case 'p': options.rtp = true; options.rtpPort = OSS::string_to_number<unsigned short>(optarg); break;
+    case 'C': options.tlsCert = optarg; break;
+    case 'K': options.tlsKey = optarg; break;
+    case 'P': options.tlsPassword = optarg; break;
+    case 'M': options.dumpMetrics = true; break;
+    case 'v': verbose = true; break;
+    default:
+      usage();
+      exit(-1);
+    }
+  }
+
+  bool isUac = options.role == "uac" || options.role == "loopback";
+  bool isUas = options.role == "uas" || options.role == "loopback";
+  if ((!isUac && !isUas) || (options.scenario != "call" && options.scenario != "register") ||
+    !options.local.isValid() || !options.remote.isValid() || options.rate <= 0 || options.total <= 0 ||
+    options.holdMs < 0 || (options.rtp && !options.rtpPort))
+  {
+    usage();
+    exit(-1);
+  }
+
+  if (isUac && options.transport == "ws")
+  {
+    std::cerr << "The UAC can not use WS.  Run the UAS with --role uas --transport ws instead." << std::endl;
+    exit(-1);
+  }
+
+  OSS::OSS_init();
+  OSS::log_reset_level(verbose ? OSS::PRIO_NOTICE : OSS::PRIO_ERROR);
+  signal(SIGINT, on_terminate);
+  signal(SIGTERM, on_terminate);
+
+  boost::asio::io_service::work work(io_service);
+  boost::thread ioThread(boost::bind(&boost::asio::io_service::run, &io_service));
+
+  if (isUas)
+  {
+    uasAddress = options.role == "uas" ? options.local : options.remote;
+    pUasStack = new SIPStack();
+    pUasStack->setRequestHandler(boost::bind(uas_handle_request, _1, _2, _3));
+    pUasStack->setAckOr2xxTransactionHandler(boost::bind(uas_handle_ack_or_2xx, _1, _2));
+    if (!add_listener(*pUasStack, uasAddress))
+      exit(-1);
+
+    if (options.rtp)
+    {
+      boost::system::error_code ec;
+      uasRtpSocket.reset(new udp::socket(io_service));
+      uasRtpSocket->open(udp::v4(), ec);
+      if (!ec)
+        uasRtpSocket->bind(udp::endpoint(uasAddress.address(), options.rtpPort), ec);
+      if (ec)
+      {
+        std::cerr << "Unable to bind RTP port " << options.rtpPort << " - " << ec.message() << std::endl;
+        exit(-1);
+      }
+      uas_receive_rtp(boost::system::error_code(), 0);
+      stats.rtpReceived.reset();
+    }
+  }
+
+  if (isUac)
+  {
+    pUacStack = new SIPStack();
+    pUacStack->setAckOr2xxTransactionHandler(boost::bind(uac_handle_ack_or_2xx, _1, _2));
+    if (!add_listener(*pUacStack, options.local))
+      exit(-1);
+    run_uac();
+  }
+  else
+  {
+    run_uas();
+  }
+
+  //
+  // Transport threads may still be delivering messages
+  //
+  std::cout.flush();
+  _exit(0);
+}
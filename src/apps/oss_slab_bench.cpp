@@ -0,0 +1,101 @@
+#include "OSS/UTL/SlabPool.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <vector>
+
+//
+// oss_slab_bench - Allocation throughput of a SlabPool shared by several
+// threads next to the heap.  Every thread keeps a window of blocks alive
+// like a worker holding the messages it is processing.  It frees the
+// oldest block and allocates a new one in its place.
+//
+
+enum
+{
+  BLOCK_SIZE = 256,
+  WINDOW = 64
+};
+
+static void* heap_allocate(OSS::SlabPool*)
+{
+  return ::operator new(BLOCK_SIZE);
+}
+
+static void heap_deallocate(OSS::SlabPool*, void* pBlock)
+{
+  ::operator delete(pBlock);
+}
+
+static void* pool_allocate(OSS::SlabPool* pool)
+{
+  return pool->allocate();
+}
+
+static void pool_deallocate(OSS::SlabPool* pool, void* pBlock)
+{
+  pool->deallocate(pBlock);
+}
+
+typedef void* (*Allocate)(OSS::SlabPool*);
+typedef void (*Deallocate)(OSS::SlabPool*, void*);
+
+static void worker(OSS::SlabPool* pool, Allocate allocate, Deallocate deallocate, int operations)
+{
+  std::vector<void*> window(WINDOW);
+  for (std::size_t i = 0; i < window.size(); i++)
+    window[i] = allocate(pool);
+  for (int i = 0; i < operations; i++)
+  {
+    std::size_t slot = i % WINDOW;
+    deallocate(pool, window[slot]);
+    window[slot] = allocate(pool);
+    static_cast<char*>(window[slot])[0] = (char)i;
+  }
+  for (std::size_t i = 0; i < window.size(); i++)
+    deallocate(pool, window[i]);
+}
+
+static double run(OSS::SlabPool& pool, Allocate allocate, Deallocate deallocate, int threadCount, int operations)
+{
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  boost::thread_group threads;
+  for (int i = 0; i < threadCount; i++)
+    threads.create_thread(boost::bind(worker, &pool, allocate, deallocate, operations));
+  threads.join_all();
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+  double seconds = (end - start).total_microseconds() / 1000000.0;
+  return threadCount * (double)operations / seconds;
+}
+
+void usage()
+{
+  std::cout << std::endl << "Usage:  oss_slab_bench [MAX_THREADS] [OPERATIONS]";
+  std::cout << std::endl << "Example:  oss_slab_bench 8 1000000";
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 3 || (argc > 1 && std::string(argv[1]) == "-h"))
+  {
+    usage();
+    return -1;
+  }
+
+  int maxThreads = argc > 1 ? OSS::string_to_number<int>(argv[1]) : 8;
+  int operations = argc > 2 ? OSS::string_to_number<int>(argv[2]) : 1000000;
+
+  OSS::SlabPool pool("slab_bench", BLOCK_SIZE);
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    double heap = run(pool, heap_allocate, heap_deallocate, threads, operations);
+    double slab = run(pool, pool_allocate, pool_deallocate, threads, operations);
+    std::cout << threads << " threads"
+      << " heap: " << (long)heap << " ops/s"
+      << " slab: " << (long)slab << " ops/s" << std::endl;
+  }
+  return 0;
+}
@@ -21,6 +21,7 @@
 
 
 #include "OSS/SIP/B2BUA/SIPB2BDialogStateManager.h"
+#include "OSS/UTL/Metrics.h"
 
 
 namespace OSS {
@@ -29,12 +30,18 @@ namespace B2BUA {
 
 
 bool SIPB2BDialogStateManager::gLogDialogEntries = true; 
+
+static OSS::LatencyHistogram& gDialogPersistLatency = OSS::Metrics::instance().histogram(
+  "b2bua_dialog_persist_microseconds", "Time spent writing dialog state to the data store");
+static OSS::LatencyHistogram& gRegPersistLatency = OSS::Metrics::instance().histogram(
+  "b2bua_registration_persist_microseconds", "Time spent writing registrations to the data store");
   
 
 using OSS::Net::IPAddress;  
   
 bool SIPB2BDialogDataStoreCb::dbPersist(const DialogData& dialogData)
 {
+  OSS::Metrics::Timer timer(gDialogPersistLatency);
   if (persist)
   {
     return persist(dialogData);
@@ -107,6 +114,7 @@ void SIPB2BDialogDataStoreCb::dbRemoveAllDialogs(const std::string& callId)
 
 bool SIPB2BDialogDataStoreCb::dbPersistReg(const RegData& regData)
 {
+  OSS::Metrics::Timer timer(gRegPersistLatency);
   if (persistReg)
   {
     return persistReg(regData);
@@ -235,7 +243,7 @@ SIPB2BDialogStateManager::SIPB2BDialogStateManager(
   int cacheLifeTime) :
   _pTransactionManager(pTransactionManager),
   _cacheLifeTime(cacheLifeTime),
-  _dialogs(cacheLifeTime),
+  _dialogs((OSS::UInt64)cacheLifeTime * 1000),
   _exitSync(0, 0xFFF),
   _pThread(0)
 {
@@ -336,24 +344,14 @@ void SIPB2BDialogStateManager::addDialog(const std::string& callId, const Dialog
   
   std::string logId = SIPMessage::createContextId(callId, true);
   
-  Cacheable::Ptr dialogs;
-  if (!_dialogs.has(callId))
-  {
-    DialogList dialogList;
-    dialogList.push_back(dialogData);
-    dialogs = Cacheable::Ptr(new Cacheable(callId, dialogList));
-    log_dialog_entries("SIPB2BDialogStateManager::addDialog", dialogList);
-  }
-  else
-  {
-    dialogs = _dialogs.get(callId);
-    DialogList& dialogList = boost::any_cast<DialogList&>(dialogs->data());
-    dialogList.push_back(dialogData);
-    log_dialog_entries("SIPB2BDialogStateManager::addDialog", dialogList);
-  }
+  DialogListPtr dialogs;
+  if (!_dialogs.get(callId, dialogs))
+    dialogs = DialogListPtr(new DialogList());
+  dialogs->push_back(dialogData);
+  log_dialog_entries("SIPB2BDialogStateManager::addDialog", *dialogs);
   OSS_LOG_DEBUG(logId << "Added new dialog " << "Session-ID: " << dialogData.sessionId << " Call-ID: " << callId);
   
-  _dialogs.add(dialogs);
+  _dialogs.add(callId, dialogs);
   _csDialogsMutex.unlock();
 }
 
@@ -362,10 +360,10 @@ void SIPB2BDialogStateManager::updateDialog(const std::string& sessionId, const
   OSS::mutex_critic_sec_lock lock(_csDialogsMutex);
   std::string logId = SIPMessage::createContextId(leg.callId, true);
   
-  if (_dialogs.has(leg.callId))
+  DialogListPtr dialogs;
+  if (_dialogs.get(leg.callId, dialogs))
   {  
-    Cacheable::Ptr dialogs = _dialogs.get(leg.callId);
-    DialogList& dialogList = boost::any_cast<DialogList&>(dialogs->data());
+    DialogList& dialogList = *dialogs;
     for (DialogList::iterator iter = dialogList.begin();
       iter != dialogList.end(); iter++)
     {
@@ -400,10 +398,10 @@ void SIPB2BDialogStateManager::updateDialog(const DialogData& dialog)
   
   std::string logId = SIPMessage::createContextId(dialog.leg1.callId, true);
   
-  if (_dialogs.has(dialog.leg1.callId))
+  DialogListPtr dialogs;
+  if (_dialogs.get(dialog.leg1.callId, dialogs))
   {
-    Cacheable::Ptr dialogs = _dialogs.get(dialog.leg1.callId);
-    DialogList& dialogList = boost::any_cast<DialogList&>(dialogs->data());
+    DialogList& dialogList = *dialogs;
     for (DialogList::iterator iter = dialogList.begin();
       iter != dialogList.end(); iter++)
     {
@@ -429,10 +427,10 @@ void SIPB2BDialogStateManager::removeDialog(const std::string& callId, const std
   
   std::string logId = SIPMessage::createContextId(callId, true);
   
-  if (_dialogs.has(callId))
+  DialogListPtr dialogs;
+  if (_dialogs.get(callId, dialogs))
   {
-    Cacheable::Ptr dialogs = _dialogs.get(callId);
-    DialogList& dialogList = boost::any_cast<DialogList&>(dialogs->data());
+    DialogList& dialogList = *dialogs;
     for (DialogList::iterator iter = dialogList.begin();
       iter != dialogList.end(); iter++)
     {
@@ -469,11 +467,11 @@ bool SIPB2BDialogStateManager::findReplacesTarget(
   }
   
   OSS::mutex_critic_sec_lock lock(_csDialogsMutex);
-  if (_dialogs.has(callId))
+  DialogListPtr dialogs;
+  if (_dialogs.get(callId, dialogs))
   {
     OSS_LOG_DEBUG(logId << "SIPB2BDialogStateManager::findReplacesTarget - Dialog database has a record for Call-ID: " << callId);
-    Cacheable::Ptr dialogs = _dialogs.get(callId);
-    DialogList& dialogList = boost::any_cast<DialogList&>(dialogs->data());
+    DialogList& dialogList = *dialogs;
      
     for (DialogList::const_iterator iter = dialogList.begin(); iter != dialogList.end(); iter++)
     {
@@ -516,18 +514,16 @@ bool SIPB2BDialogStateManager::findDialog(const SIPB2BTransaction::Ptr& pTransac
   
   std::string logId = pMsg->createContextId(true);
 
-  SIPFrom from = pMsg->hdrGet(OSS::SIP::HDR_FROM);
-  SIPTo to = pMsg->hdrGet(OSS::SIP::HDR_TO);
-  std::string fromTag = from.getTag();
-  std::string toTag = to.getTag();
+  std::string fromTag = pMsg->getFromTag();
+  std::string toTag = pMsg->getToTag();
 
   OSS_LOG_DEBUG(logId << "Finding dialog for Call-ID: " << callId << " SessionId: (" << sessionId << ")");
 
-  if (_dialogs.has(callId))
+  DialogListPtr dialogs;
+  if (_dialogs.get(callId, dialogs))
   {
     OSS_LOG_DEBUG(logId << "Dialog database has a record for Call-ID: " << callId);
-    Cacheable::Ptr dialogs = _dialogs.get(callId);
-    DialogList& dialogList = boost::any_cast<DialogList&>(dialogs->data());
+    DialogList& dialogList = *dialogs;
     if (dialogList.size() == 1)
     {
       dialogData = dialogList.front();
@@ -762,16 +758,16 @@ void SIPB2BDialogStateManager::onUpdateInitialUASState(
 
         std::string contentType = pResponse->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
         OSS::string_to_lower(contentType);
-        if (!pResponse->body().empty() && contentType == "application/sdp")
+        if (!pResponse->getBody().empty() && contentType == "application/sdp")
         {
-          leg1.localSdp = pResponse->body();
+          leg1.localSdp = pResponse->getBody();
         }
 
         contentType = pTransaction->serverRequest()->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
         OSS::string_to_lower(contentType);
-        if (!pTransaction->serverRequest()->body().empty() && contentType == "application/sdp")
+        if (!pTransaction->serverRequest()->getBody().empty() && contentType == "application/sdp")
         {
-          leg1.remoteSdp = pTransaction->serverRequest()->body();
+          leg1.remoteSdp = pTransaction->serverRequest()->getBody();
         }
 
         if (pResponse->hdrGetSize(OSS::SIP::HDR_RECORD_ROUTE) > 0)
@@ -871,16 +867,16 @@ void SIPB2BDialogStateManager::onUpdateInitialUACState(
 
       std::string contentType = pResponse->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
       OSS::string_to_lower(contentType);
-      if (!pResponse->body().empty() && contentType == "application/sdp")
+      if (!pResponse->getBody().empty() && contentType == "application/sdp")
       {
-        leg2.remoteSdp = pResponse->body();
+        leg2.remoteSdp = pResponse->getBody();
       }
 
       contentType = pTransaction->clientRequest()->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
       OSS::string_to_lower(contentType);
-      if (!pTransaction->clientRequest()->body().empty() && contentType == "application/sdp")
+      if (!pTransaction->clientRequest()->getBody().empty() && contentType == "application/sdp")
       {
-        leg2.localSdp = pTransaction->clientRequest()->body();
+        leg2.localSdp = pTransaction->clientRequest()->getBody();
       }
 
       std::string noRTPProxy;
@@ -985,16 +981,16 @@ void SIPB2BDialogStateManager::onUpdateMidCallUASState(
 
         std::string contentType = pResponse->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
         OSS::string_to_lower(contentType);
-        if (!pResponse->body().empty() && contentType == "application/sdp")
+        if (!pResponse->getBody().empty() && contentType == "application/sdp")
         {
-          pLeg->localSdp = pResponse->body();
+          pLeg->localSdp = pResponse->getBody();
         }
 
         contentType = pTransaction->serverRequest()->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
         OSS::string_to_lower(contentType);
-        if (!pTransaction->serverRequest()->body().empty() && contentType == "application/sdp")
+        if (!pTransaction->serverRequest()->getBody().empty() && contentType == "application/sdp")
         {
-          pLeg->remoteSdp = pTransaction->serverRequest()->body();
+          pLeg->remoteSdp = pTransaction->serverRequest()->getBody();
         }
 
         updateDialog(dialogData.sessionId, *pLeg, boost::lexical_cast<int>(legIndexNumber));
@@ -1061,16 +1057,16 @@ void SIPB2BDialogStateManager::onUpdateMidCallUACState(
 
       std::string contentType = pResponse->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
       OSS::string_to_lower(contentType);
-      if (!pResponse->body().empty() && contentType == "application/sdp")
+      if (!pResponse->getBody().empty() && contentType == "application/sdp")
       {
-        pLeg->remoteSdp = pResponse->body();
+        pLeg->remoteSdp = pResponse->getBody();
       }
 
       contentType = pTransaction->clientRequest()->hdrGet(OSS::SIP::HDR_CONTENT_TYPE);
       OSS::string_to_lower(contentType);
-      if (!pTransaction->clientRequest()->body().empty() && contentType == "application/sdp")
+      if (!pTransaction->clientRequest()->getBody().empty() && contentType == "application/sdp")
       {
-        pLeg->localSdp = pTransaction->clientRequest()->body();
+        pLeg->localSdp = pTransaction->clientRequest()->getBody();
       }
 
       updateDialog(dialogData);
@@ -1420,7 +1416,7 @@ SIPMessage::Ptr SIPB2BDialogStateManager::onRouteInviteWithReplaces(
 void SIPB2BDialogStateManager::onRouteAckRequest(
   const SIPMessage::Ptr& pMsg,
   const OSS::SIP::SIPTransportSession::Ptr& pTransport,
-  OSS::CacheManager& retransmitCache,
+  SIPB2BDialogStateManager::RetransmitCache& retransmitCache,
   std::string& sessionId,
   std::string& peerXOR,
   OSS::Net::IPAddress& routeLocalInterface,
@@ -1581,10 +1577,9 @@ void SIPB2BDialogStateManager::onRouteAckRequest(
 
     std::ostringstream cacheId;
     cacheId << pMsg->getDialogId(true) << cseq.data();
-    Cacheable::Ptr cacheItem = retransmitCache.get(cacheId.str());
-    if (cacheItem)
+    SIPMessage::Ptr p2xx;
+    if (retransmitCache.get(cacheId.str(), p2xx))
     {
-      SIPMessage::Ptr p2xx = boost::any_cast<SIPMessage::Ptr>(cacheItem->data());
       if (p2xx)
       {
         std::string oldVia;
@@ -1637,7 +1632,7 @@ void SIPB2BDialogStateManager::onRouteAckRequest(
       else
         pSenderLeg = &dialogData.leg2;
 
-      pSenderLeg->remoteSdp = pMsg->body();
+      pSenderLeg->remoteSdp = pMsg->getBody();
       //
       // Now set the B-Leg local interface using the transport info
       //
@@ -0,0 +1,247 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/SIP/B2BUA/SIPB2BKeepAliveScheduler.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <boost/functional/hash.hpp>
+#include "OSS/SIP/SIPFrom.h"
+#include "OSS/SIP/SIPHeaderTokens.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+static void appendNumber(std::string& str, OSS::UInt64 number)
+{
+  char digits[24];
+  std::size_t len = 0;
+  do
+  {
+    digits[len++] = (char)('0' + (number % 10));
+    number /= 10;
+  } while (number);
+  while (len)
+    str.push_back(digits[--len]);
+}
+
+SIPB2BOptionsTemplate::SIPB2BOptionsTemplate()
+{
+}
+
+void SIPB2BOptionsTemplate::compile(const RegData& regData,
+  const std::string& transportScheme,
+  const std::string& sentBy)
+{
+  SIPTo to(regData.aor);
+
+  _head = "OPTIONS ";
+  _head += regData.contact;
+  _head += " SIP/2.0";
+  _head += OSS::SIP::CRLF;
+  _head += "To: ";
+  _head += to.data();
+  _head += OSS::SIP::CRLF;
+  _head += "From: sip:";
+  _head += regData.key;
+  _head += "@";
+  _head += to.getHostPort();
+  _head += ";tag=";
+
+  _via = OSS::SIP::CRLF;
+  _via += "Via: SIP/2.0/";
+  _via += transportScheme;
+  _via += " ";
+  _via += sentBy;
+  _via += ";branch=z9hG4bK";
+
+  _tail = " OPTIONS";
+  _tail += OSS::SIP::CRLF;
+  _tail += "Contact: <sip:";
+  _tail += regData.key;
+  _tail += "@";
+  _tail += sentBy;
+  _tail += ">";
+  _tail += OSS::SIP::CRLF;
+  _tail += "Content-Length: 0";
+  _tail += OSS::SIP::CRLF;
+  _tail += OSS::SIP::CRLF;
+
+  _fromPrefix = "sip:";
+  _fromPrefix += regData.key;
+  _fromPrefix += "@";
+  _fromPrefix += to.getHostPort();
+  _fromPrefix += ";tag=";
+
+  _viaPrefix = "SIP/2.0/";
+  _viaPrefix += transportScheme;
+  _viaPrefix += " ";
+  _viaPrefix += sentBy;
+  _viaPrefix += ";branch=z9hG4bK";
+
+  std::string packet;
+  render("", 0, packet);
+  _prototype.reset(new SIPMessage(packet));
+}
+
+void SIPB2BOptionsTemplate::render(const std::string& token, OSS::UInt64 sequence, std::string& packet) const
+{
+  packet.clear();
+  packet.reserve(_head.size() + _via.size() + _tail.size() + (token.size() + 20) * 3 + 64);
+
+  packet += _head;
+  packet += token;
+  appendNumber(packet, sequence);
+
+  packet += _via;
+  packet += token;
+  appendNumber(packet, sequence);
+  packet += ";rport";
+  packet += OSS::SIP::CRLF;
+
+  packet += "Call-ID: ";
+  packet += token;
+  appendNumber(packet, sequence);
+  packet += OSS::SIP::CRLF;
+
+  packet += "CSeq: ";
+  appendNumber(packet, sequence);
+  packet += _tail;
+}
+
+SIPMessage::Ptr SIPB2BOptionsTemplate::createRequest(const std::string& token, OSS::UInt64 sequence) const
+{
+  SIPMessage::Ptr request(new SIPMessage(*_prototype));
+
+  std::string id = token;
+  appendNumber(id, sequence);
+  request->hdrSet(OSS::SIP::HDR_FROM, _fromPrefix + id);
+  request->hdrSet(OSS::SIP::HDR_VIA, _viaPrefix + id + ";rport");
+  request->hdrSet(OSS::SIP::HDR_CALL_ID, id);
+
+  std::string cseq;
+  appendNumber(cseq, sequence);
+  cseq += " OPTIONS";
+  request->hdrSet(OSS::SIP::HDR_CSEQ, cseq);
+
+  request->commitData();
+  return request;
+}
+
+
+SIPB2BKeepAliveScheduler::SIPB2BKeepAliveScheduler(unsigned int interval, unsigned int resolution) :
+  _wheel(resolution),
+  _generation(0),
+  _interval(interval ? interval : 1),
+  _resolution(resolution ? resolution : 1)
+{
+}
+
+void SIPB2BKeepAliveScheduler::schedule(const BindingPtr& binding, OSS::UInt64 now)
+{
+  if (!binding)
+    return;
+
+  const std::string& key = binding->registration.key;
+  OSS::UInt64 expiresAt = 0;
+  if (binding->registration.expires > 0)
+    expiresAt = now + (OSS::UInt64)binding->registration.expires * 1000;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Bindings::iterator iter = _bindings.find(key);
+  if (iter != _bindings.end())
+  {
+    iter->second.binding = binding;
+    iter->second.expiresAt = expiresAt;
+    return;
+  }
+
+  Entry& entry = _bindings[key];
+  entry.binding = binding;
+  entry.generation = ++_generation;
+  entry.expiresAt = expiresAt;
+
+  //
+  // Spread bindings across the interval using the hash of the key as phase
+  //
+  TimerKey timerKey;
+  timerKey.key = key;
+  timerKey.generation = entry.generation;
+  OSS::UInt64 phase = boost::hash<std::string>()(key) % _interval;
+  _wheel.schedule(timerKey, now + phase, now);
+}
+
+bool SIPB2BKeepAliveScheduler::unschedule(const std::string& key)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _bindings.erase(key) > 0;
+}
+
+SIPB2BKeepAliveScheduler::BindingPtr SIPB2BKeepAliveScheduler::find(const std::string& key) const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Bindings::const_iterator iter = _bindings.find(key);
+  if (iter == _bindings.end())
+    return BindingPtr();
+  return iter->second.binding;
+}
+
+void SIPB2BKeepAliveScheduler::collectDue(OSS::UInt64 now, BindingList& due)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Wheel::TimerList expired;
+  _wheel.advance(now, expired);
+
+  for (Wheel::TimerList::iterator timer = expired.begin(); timer != expired.end(); timer++)
+  {
+    Bindings::iterator iter = _bindings.find(timer->key.key);
+    if (iter == _bindings.end() || iter->second.generation != timer->key.generation)
+      continue;
+
+    if (iter->second.expiresAt && now >= iter->second.expiresAt)
+    {
+      _bindings.erase(iter);
+      continue;
+    }
+
+    due.push_back(iter->second.binding);
+
+    //
+    // Keep the phase unless we fell behind by a whole interval
+    //
+    OSS::UInt64 deadline = timer->deadline + _interval;
+    if (deadline <= now)
+      deadline = now + _interval;
+    _wheel.schedule(timer->key, deadline, now);
+  }
+}
+
+std::size_t SIPB2BKeepAliveScheduler::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _bindings.size();
+}
+
+
+} } } // OSS::SIP::B2BUA
+
+#endif // ENABLE_FEATURE_B2BUA
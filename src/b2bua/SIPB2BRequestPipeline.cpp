@@ -0,0 +1,123 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <algorithm>
+#include "OSS/SIP/B2BUA/SIPB2BRequestPipeline.h"
+#include "OSS/UTL/Metrics.h"
+
+
+namespace OSS {
+namespace SIP {
+namespace B2BUA {
+
+
+SIPB2BRequestPipeline::SIPB2BRequestPipeline()
+{
+  for (std::size_t i = 0; i < StageMax; i++)
+  {
+    _handlers[i] = HandlersPtr(new Handlers());
+    _latency[i] = &OSS::Metrics::instance().histogram(
+      std::string("b2bua_stage_") + stageName((Stage)i) + "_microseconds",
+      std::string("Time B2B transactions spend in the ") + stageName((Stage)i) + " stage");
+  }
+}
+
+SIPB2BRequestPipeline::~SIPB2BRequestPipeline()
+{
+}
+
+void SIPB2BRequestPipeline::addHandler(Stage stage, const std::string& name, std::size_t priority, const Handler& handler)
+{
+  if (stage >= StageMax)
+    return;
+
+  Entry entry;
+  entry.name = name;
+  entry.priority = priority;
+  entry.handler = handler;
+
+  //
+  // Transactions holding the old chain keep using it
+  //
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Handlers* pHandlers = new Handlers(*_handlers[stage]);
+  pHandlers->push_back(entry);
+  std::stable_sort(pHandlers->begin(), pHandlers->end());
+  _handlers[stage] = HandlersPtr(pHandlers);
+}
+
+bool SIPB2BRequestPipeline::removeHandler(Stage stage, const std::string& name)
+{
+  if (stage >= StageMax)
+    return false;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Handlers* pHandlers = new Handlers();
+  pHandlers->reserve(_handlers[stage]->size());
+  for (Handlers::const_iterator iter = _handlers[stage]->begin(); iter != _handlers[stage]->end(); iter++)
+  {
+    if (iter->name != name)
+      pHandlers->push_back(*iter);
+  }
+
+  bool removed = pHandlers->size() != _handlers[stage]->size();
+  _handlers[stage] = HandlersPtr(pHandlers);
+  return removed;
+}
+
+SIPB2BRequestPipeline::HandlersPtr SIPB2BRequestPipeline::getHandlers(Stage stage) const
+{
+  if (stage >= StageMax)
+    return HandlersPtr();
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _handlers[stage];
+}
+
+void SIPB2BRequestPipeline::recordLatency(Stage stage, OSS::UInt64 micros)
+{
+  if (stage < StageMax)
+    _latency[stage]->record(micros);
+}
+
+void SIPB2BRequestPipeline::getLatency(Stage stage, LatencyHistogram::Snapshot& snapshot) const
+{
+  if (stage < StageMax)
+    _latency[stage]->snapshot(snapshot);
+}
+
+const char* SIPB2BRequestPipeline::stageName(Stage stage)
+{
+  switch (stage)
+  {
+  case StageCreated:
+    return "created";
+  case StageAuthenticate:
+    return "authenticate";
+  case StageRoute:
+    return "route";
+  case StageOutbound:
+    return "outbound";
+  default:
+    return "unknown";
+  }
+}
+
+
+} } } // OSS::SIP::B2BUA
@@ -270,15 +270,20 @@ SIPB2BScriptableHandler::SIPB2BScriptableHandler(
   _outboundResponseScript(contextName),
   _pTransactionManager(pTransactionManager),
   _pDialogState(pDialogState),
-  _2xxRetransmitCache(32),
+  _2xxRetransmitCache(32000),
   _pOptionsThread(0),
   _optionsThreadExit(0, 0xFFFF),
   _pOptionsResponseThread(0),
   _optionsResponseThreadExit(0, 0xFFFF),
+  _keepAliveSequence(1),
   _threadPool(1, 10)
 {
   _keepAliveResponseCb = boost::bind(&SIPB2BScriptableHandler::handleOptionsResponse, this, _1, _2, _3, _4);
   //
+  // Random prefix for keep-alive tags, branches and call-ids
+  //
+  _keepAliveToken = OSS::string_create_uuid().substr(0, 8);
+  //
   // Initialize the options keep-alive thread
   //
   OSS_ASSERT(_pOptionsResponseThread == 0);
@@ -1431,6 +1436,7 @@ void SIPB2BScriptableHandler::onProcessResponseInbound(
               OSS_LOG_INFO("Deleting REGISTER state " << regId);
             }
             _pDialogState->removeRegistration(regId);
+            _keepAliveScheduler.unschedule(regId);
             //
             // Remove from the keep-alive list
             //
@@ -1493,9 +1499,8 @@ void SIPB2BScriptableHandler::onProcessResponseOutbound(
       //
       std::ostringstream cacheId;
       cacheId << pResponse->getDialogId(false) << pResponse->hdrGet(OSS::SIP::HDR_CSEQ);
-      boost::any cacheItem = pResponse;
       pResponse->setProperty(OSS::PropertyMap::PROP_SessionId, sessionId);
-      _2xxRetransmitCache.add(cacheId.str(), cacheItem);
+      _2xxRetransmitCache.add(cacheId.str(), pResponse);
       OSS_LOG_DEBUG(pTransaction->getLogId() << "Added 2xx dialog-id: " << cacheId.str() << " to retransmission cache.");
     }
     return;
@@ -1522,9 +1527,8 @@ void SIPB2BScriptableHandler::onProcessResponseOutbound(
 
       std::ostringstream cacheId;
       cacheId << pResponse->getDialogId(false) << pResponse->hdrGet(OSS::SIP::HDR_CSEQ);
-      boost::any cacheItem = pResponse;
       pResponse->setProperty(OSS::PropertyMap::PROP_SessionId, sessionId);
-      _2xxRetransmitCache.add(cacheId.str(), cacheItem);
+      _2xxRetransmitCache.add(cacheId.str(), pResponse);
       OSS_LOG_DEBUG(pTransaction->getLogId() << "Added 2xx dialog-id: " << cacheId.str() << " to retransmission cache.");
     }
   }
@@ -1706,10 +1710,13 @@ void SIPB2BScriptableHandler::onProcessResponseOutbound(
         else
           registration.expires = 3600;
 
-        OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
-        _keepAliveList[packetSource] = localInterface;
+        {
+          OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
+          _keepAliveList[packetSource] = localInterface;
+        }
 
         _pDialogState->addRegistration(registration);
+        _keepAliveScheduler.schedule(createKeepAliveBinding(registration), OSS::getTime());
       }
       catch(...)
       {
@@ -1804,10 +1811,9 @@ void SIPB2BScriptableHandler::onProcessAckOr2xxRequest(
   {
     std::ostringstream cacheId;
     cacheId << pMsg->getDialogId(false) << pMsg->hdrGet(OSS::SIP::HDR_CSEQ);
-    Cacheable::Ptr cacheItem = _2xxRetransmitCache.get(cacheId.str());
-    if (cacheItem)
+    SIPMessage::Ptr p2xx;
+    if (_2xxRetransmitCache.get(cacheId.str(), p2xx))
     {
-      SIPMessage::Ptr p2xx = boost::any_cast<SIPMessage::Ptr>(cacheItem->data());
       if (p2xx)
       {
         std::string target;
@@ -2053,47 +2059,58 @@ void SIPB2BScriptableHandler::handleOptionsResponse(
 
 void SIPB2BScriptableHandler::runOptionsThread()
 {
+  const unsigned int crlfInterval = 5000;
+  unsigned int elapsed = 0;
+  unsigned int sinceSync = _keepAliveScheduler.getInterval();
+  SIPB2BKeepAliveScheduler::BindingList due;
 
-  int currentIteration = 0;
-  unsigned int segmentSize = 0;
-  unsigned int nextSegment = 0;
-
-
-  while(!_optionsThreadExit.tryWait(5000))
+  while(!_optionsThreadExit.tryWait(_keepAliveScheduler.getResolution()))
   {
-    
     //
-    // Send CRLF keep alive for every iteration
+    // Bindings registered through this node are scheduled as they arrive.
+    // The store is shared with other nodes so pick up the bindings they
+    // registered once every keep-alive interval.  Bindings that are already
+    // scheduled keep their place and expiry.
     //
-    {
-      OSS::mutex_read_lock readLock(_rwKeepAliveListMutex);
-      for (KeepAliveList::iterator iter = _keepAliveList.begin(); iter != _keepAliveList.end(); iter++)
-        _pTransactionManager->stack().transport().sendUDPKeepAlive(iter->second, iter->first);
+    sinceSync += _keepAliveScheduler.getResolution();
+    if (sinceSync >= _keepAliveScheduler.getInterval())
+    {
+      sinceSync = 0;
+      RegList regList;
+      _pDialogState->getAllRegistrationRecords(regList);
+      OSS::UInt64 now = OSS::getTime();
+      for (RegList::const_iterator iter = regList.begin(); iter != regList.end(); iter++)
+      {
+        if (!_keepAliveScheduler.find(iter->key))
+          _keepAliveScheduler.schedule(createKeepAliveBinding(*iter), now);
+      }
     }
-    currentIteration++;
 
-    RegList regList;
-    _pDialogState->getAllRegistrationRecords(regList);
-    if (currentIteration == 1)
-    {
-      segmentSize = regList.size() / 12;
-      if (segmentSize == 0)
-        segmentSize = 12;
-      nextSegment = 0;
-      size_t maxIter = regList.size();
-      for (size_t i = nextSegment; i < nextSegment + segmentSize && i < maxIter; i++)
-        sendOptionsKeepAlive(regList[i]);
-      nextSegment += segmentSize;
-    }
-    else
+    //
+    // Send CRLF keep alive every five seconds, one batch per local interface
+    //
+    elapsed += _keepAliveScheduler.getResolution();
+    if (elapsed >= crlfInterval)
     {
-      size_t maxIter = regList.size();
-      for (size_t i = nextSegment; i < nextSegment + segmentSize && i < maxIter; i++)
-        sendOptionsKeepAlive(regList[i]);
-      nextSegment += segmentSize;
-      if (currentIteration == 12)
-        currentIteration = 0;
+      elapsed = 0;
+      typedef std::map<OSS::Net::IPAddress, std::vector<OSS::Net::IPAddress> > TargetsByInterface;
+      TargetsByInterface targets;
+      {
+        OSS::mutex_read_lock readLock(_rwKeepAliveListMutex);
+        for (KeepAliveList::iterator iter = _keepAliveList.begin(); iter != _keepAliveList.end(); iter++)
+          targets[iter->second].push_back(iter->first);
+      }
+      for (TargetsByInterface::iterator iter = targets.begin(); iter != targets.end(); iter++)
+        _pTransactionManager->stack().transport().sendUDPKeepAlive(iter->first, iter->second);
     }
+
+    //
+    // Send OPTIONS to the bindings that fell due since the last tick
+    //
+    due.clear();
+    _keepAliveScheduler.collectDue(OSS::getTime(), due);
+    for (SIPB2BKeepAliveScheduler::BindingList::const_iterator iter = due.begin(); iter != due.end(); iter++)
+      sendOptionsKeepAlive(*iter);
   }
 }
 
@@ -2119,6 +2136,7 @@ void SIPB2BScriptableHandler::runOptionsResponseThread()
         //
         // Remove from the keep-alive list
         //
+        _keepAliveScheduler.unschedule(regData.key);
         OSS::mutex_write_lock writeLock(_rwKeepAliveListMutex);
         _keepAliveList.erase(OSS::Net::IPAddress::fromV4IPPort(regData.packetSource.c_str()));
         _pDialogState->removeRegistration(regData.key);
@@ -2136,62 +2154,61 @@ void SIPB2BScriptableHandler::runOptionsResponseThread()
   }
 }
 
-void SIPB2BScriptableHandler::sendOptionsKeepAlive(RegData& regData)
+SIPB2BKeepAliveScheduler::BindingPtr SIPB2BScriptableHandler::createKeepAliveBinding(const RegData& regData)
 {
-  try
-  {
-    static int cseqNo = 1;
+  SIPB2BKeepAliveScheduler::BindingPtr binding(new SIPB2BKeepAliveBinding());
+  binding->registration = regData;
+  binding->transportScheme = regData.targetTransport;
+  OSS::string_to_upper(binding->transportScheme);
 
-    std::string callId = OSS::string_create_uuid();
-    size_t hash = OSS::string_hash(callId.c_str());
+  binding->localInterface = IPAddress::fromV4IPPort(regData.localInterface.c_str());
+  binding->target = IPAddress::fromV4IPPort(regData.packetSource.c_str());
+  _pTransactionManager->getInternalAddress(binding->localInterface, binding->localInterface);
 
-    SIPTo to(regData.aor);
-    std::string transportScheme = regData.targetTransport;
-    OSS::string_to_upper(transportScheme);
-
-    IPAddress src = IPAddress::fromV4IPPort(regData.localInterface.c_str());
-    IPAddress target = IPAddress::fromV4IPPort(regData.packetSource.c_str());
-
-    _pTransactionManager->getInternalAddress(src, src);
-
-    std::ostringstream options;
-    options << "OPTIONS " << regData.contact << " SIP/2.0" << OSS::SIP::CRLF;
-    options << "To: " << to.data() << OSS::SIP::CRLF;
-    options << "From: sip:" << regData.key << "@" << to.getHostPort() << ";tag=" << hash << OSS::SIP::CRLF;
-
-    if (src.externalAddress().empty())
-      options << "Via: " << "SIP/2.0/" << transportScheme << " " << regData.localInterface << ";branch=z9hG4bK" << hash << ";rport" << OSS::SIP::CRLF;
-    else
-      options << "Via: " << "SIP/2.0/" << transportScheme << " " << src.externalAddress() << ":" << src.getPort() << ";branch=z9hG4bK" << hash << ";rport"  << OSS::SIP::CRLF;
-
-    options << "Call-ID: " << callId << OSS::SIP::CRLF;
-    options << "CSeq: " << cseqNo++ << " OPTIONS" << OSS::SIP::CRLF;
-
-    if (src.externalAddress().empty())
-      options << "Contact: " << "<sip:" << regData.key << "@" << regData.localInterface << ">" << OSS::SIP::CRLF;
-    else
-      options << "Contact: " << "<sip:" << regData.key << "@" << src.externalAddress() << ":" << src.getPort() << ">" << OSS::SIP::CRLF;
-
-    options << "Content-Length: 0" << OSS::SIP::CRLF << OSS::SIP::CRLF;
+  std::string sentBy;
+  if (binding->localInterface.externalAddress().empty())
+  {
+    sentBy = regData.localInterface;
+  }
+  else
+  {
+    sentBy = binding->localInterface.externalAddress();
+    sentBy += ":";
+    sentBy += OSS::string_from_number<unsigned short>(binding->localInterface.getPort());
+  }
+  binding->options.compile(regData, binding->transportScheme, sentBy);
+  return binding;
+}
 
+void SIPB2BScriptableHandler::sendOptionsKeepAlive(RegData& regData)
+{
+  sendOptionsKeepAlive(createKeepAliveBinding(regData));
+}
 
-    SIPMessage::Ptr msg(new SIPMessage(options.str()));
-    if (regData.enc)
+void SIPB2BScriptableHandler::sendOptionsKeepAlive(const SIPB2BKeepAliveScheduler::BindingPtr& binding)
+{
+  try
+  {
+    SIPMessage::Ptr msg = binding->options.createRequest(_keepAliveToken, _keepAliveSequence.fetch_add(1));
+    if (binding->registration.enc)
       msg->setProperty(OSS::PropertyMap::PROP_XOR, "1");
 
-    msg->setProperty(OSS::PropertyMap::PROP_TargetTransport, transportScheme.c_str());
+    msg->setProperty(OSS::PropertyMap::PROP_TargetTransport, binding->transportScheme.c_str());
 
-    if (!regData.transportId.empty())
+    if (!binding->registration.transportId.empty())
     {
-      msg->setProperty(OSS::PropertyMap::PROP_TransportId, regData.transportId.c_str());
-      OSS_LOG_INFO("SIPB2BScriptableHandler::sendOptionsKeepAlive - Using transport " << regData.transportId.c_str() << " for remote " << transportScheme << " target");
+      msg->setProperty(OSS::PropertyMap::PROP_TransportId, binding->registration.transportId.c_str());
+      if (OSS::log_get_level() >= OSS::PRIO_DEBUG)
+      {
+        OSS_LOG_DEBUG("SIPB2BScriptableHandler::sendOptionsKeepAlive - Using transport " << binding->registration.transportId << " for remote " << binding->transportScheme << " target");
+      }
     }
     else
     {
-      OSS_LOG_WARNING("SIPB2BScriptableHandler::sendOptionsKeepAlive - Transport ID is not set for remote " << transportScheme << " target");
+      OSS_LOG_WARNING("SIPB2BScriptableHandler::sendOptionsKeepAlive - Transport ID is not set for remote " << binding->transportScheme << " target");
     }
 
-    _pTransactionManager->stack().sendRequest(msg, src, target, _keepAliveResponseCb, OSS::SIP::SIPTransaction::TerminateCallback());
+    _pTransactionManager->stack().sendRequest(msg, binding->localInterface, binding->target, _keepAliveResponseCb, OSS::SIP::SIPTransaction::TerminateCallback());
   }
   catch(std::exception& e)
   {
@@ -26,20 +26,35 @@
 #include "OSS/ABNF/ABNFSIPIPV6Address.h"
 #include "OSS/SIP/SIPVia.h"
 #include "OSS/UTL/PropertyMap.h"
+#include "OSS/UTL/Metrics.h"
 
 #define THREADED_RESPONSE 0 /// Disable threadpool for response handling.  This is the desired default to avoid race conditions!
 
+OSS_SLAB_POOL(OSS::SIP::B2BUA::SIPB2BTransaction, "b2bua_transaction")
+
 namespace OSS {
 namespace SIP {
 namespace B2BUA {
 
+static OSS::MetricCounter& gTransactions = OSS::Metrics::instance().counter(
+  "b2bua_transactions_total", "B2B transactions started");
+static OSS::MetricCounter& gLocalResponses = OSS::Metrics::instance().counter(
+  "b2bua_local_responses_total", "B2B transactions answered locally instead of forwarded");
+static OSS::LatencyHistogram& gQueueWait = OSS::Metrics::instance().histogram(
+  "b2bua_queue_wait_microseconds", "Time new B2B transactions wait for a thread pool worker");
+static OSS::LatencyHistogram& gSetupLatency = OSS::Metrics::instance().histogram(
+  "b2bua_transaction_setup_microseconds", "Time from B2B transaction creation until its request is forwarded");
+
 
 SIPB2BTransaction::SIPB2BTransaction(SIPB2BTransactionManager* pManager) :
   _pManager(pManager),
   _pInternalPtr(0),
   _hasSentLocalResponse(false),
   _isMidDialog(false),
-  _isChallenged(false)
+  _isChallenged(false),
+  _pipelineStage(-1),
+  _pipelineIndex(0),
+  _createTime(OSS::Metrics::now())
 {
 }
 
@@ -107,26 +122,23 @@ void SIPB2BTransaction::releaseInternalRef()
 
 void SIPB2BTransaction::runTask()
 {
-  static OSS::Net::IPAddress LOCALHOST("127.0.0.1");
-  _pInternalPtr = new Ptr(this);
-  try
+  gTransactions.increment();
+  gQueueWait.record(OSS::Metrics::now() - _createTime);
+
+  if (!_pServerRequest || !_pServerTransport || !_pServerTransaction)
   {
+    OSS::log_error("Transaction info is missing while calling SIPB2BTransaction::runTask()");
     //
-    // This method runs in its own thread and will not block any operation
-    // in the subsystem.  It is therefore safe to call blocking functions
-    // in this method.
+    // Not calling releaseInternalRef because transaction creation has not
+    // been signaled yet.  Dropping the only reference deletes the transaction.
     //
+    Ptr internalPtr(this);
+    return;
+  }
 
-    if (!_pServerRequest || !_pServerTransport || !_pServerTransaction)
-    {
-      //
-      // Not calling releaseInternalRef because transacton creation ahs not been signaled yet
-      //
-      delete _pInternalPtr;
-      _pInternalPtr = 0;
-      throw OSS::SIP::SIPException("Transaction info is missing while calling SIPB2BTransaction::runTask()");
-    }
-
+  _pInternalPtr = new Ptr(this);
+  try
+  {
     _logId =  _pServerTransaction->getLogId();
     _pServerTransaction->attachB2BTransaction(shared_from_this());
 
@@ -139,228 +151,308 @@ void SIPB2BTransaction::runTask()
     }
 
     _isMidDialog = _pServerRequest->isMidDialog();
-    //
-    // Signal transaction creation
-    //
-    SIPMessage::Ptr pTrnCreateResponse = _pManager->onTransactionCreated(_pServerRequest, shared_from_this());
-    if (pTrnCreateResponse)
+  }
+  catch(OSS::Exception e)
+  {
+    sendServerResponse(_pServerRequest->createResponse(500, e.message()));
+
+    std::ostringstream errorMsg;
+    errorMsg << _logId << "Fatal Exception while calling SIPB2BTransaction::runTask() - "
+            << e.message();
+    OSS::log_error(errorMsg.str());
+    releaseInternalRef();
+    return;
+  }
+
+  //
+  // Walk the request pipeline.  Handlers that wait for I/O suspend the
+  // transaction and resume it later from another thread.
+  //
+  _pipelineStage = -1;
+  runPipeline(SIPB2BRequestPipeline::Continue, SIPMessage::Ptr());
+}
+
+void SIPB2BTransaction::runPipeline(SIPB2BRequestPipeline::Result result, SIPMessage::Ptr response)
+{
+  SIPB2BRequestPipeline& pipeline = _pManager->requestPipeline();
+  for (;;)
+  {
+    if (result == SIPB2BRequestPipeline::Suspend)
     {
-      OSS::Net::IPAddress target;
-      if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-      {
-        if (target.isValid())
-          _pServerTransaction->sendResponse(pTrnCreateResponse, target);
-      }
-      releaseInternalRef();
+      //
+      // The handler owns the transaction until it calls resume
+      //
       return;
     }
 
-    //
-    // Authenticate the request
-    //
-    SIPMessage::Ptr pAuthenticator;
-    pAuthenticator = _pManager->onAuthenticateTransaction(_pServerRequest, shared_from_this());
-    if (pAuthenticator)
+    if (result != SIPB2BRequestPipeline::Continue)
     {
-      OSS::Net::IPAddress target;
-      if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-      {
-        if (target.isValid())
-        {
-          _isChallenged = true;
-          _pServerTransaction->sendResponse(pAuthenticator, target);
-        }
-      }
-      
+      endPipelineStage();
+      if (result == SIPB2BRequestPipeline::Respond && response)
+        sendServerResponse(response);
       releaseInternalRef();
       return;
     }
 
-    //
-    // Clone the server request.
-    // From now on, we will feed the clone to the server callbacks.
-    //
-    SIPMessage* outbound = new SIPMessage();
-    *outbound = *(_pServerRequest.get());
-    std::string transportAlias;
-    if (_pServerRequest->getProperty(OSS::PropertyMap::PROP_TransportAlias, transportAlias) && !transportAlias.empty())
+    if (!_pipelineHandlers || _pipelineIndex >= _pipelineHandlers->size())
     {
-      outbound->setProperty(OSS::PropertyMap::PROP_TransportAlias, transportAlias);
+      endPipelineStage();
+      if (++_pipelineStage >= SIPB2BRequestPipeline::StageMax)
+      {
+        sendClientRequest();
+        return;
+      }
+      _pipelineHandlers = pipeline.getHandlers((SIPB2BRequestPipeline::Stage)_pipelineStage);
+      _pipelineIndex = 0;
+      _pipelineStageStart = boost::posix_time::microsec_clock::universal_time();
+      continue;
     }
-    _pClientRequest = SIPMessage::Ptr(outbound);
 
     //
-    // Route the outbound request.
-    // Send a response (probably a 404) if the request is non-routable
+    // Once a handler suspends, the thread that resumes it may move on to
+    // the next stage while this one is still returning.  The local copy
+    // keeps the entry alive until then.
     //
-    OSS::Net::IPAddress outboundTarget;
-    SIPMessage::Ptr pRouteResponse;
-
+    SIPB2BRequestPipeline::HandlersPtr handlers = _pipelineHandlers;
+    const SIPB2BRequestPipeline::Entry& entry = (*handlers)[_pipelineIndex++];
+    response.reset();
     try
     {
-      pRouteResponse = _pManager->onRouteTransaction(_pClientRequest, shared_from_this(), _localInterface, outboundTarget);
+      result = entry.handler(shared_from_this(), response,
+        boost::bind(&SIPB2BTransaction::resumePipeline, this, _1, _2));
     }
     catch(OSS::Exception e)
     {
-      OSS::log_warning(_logId + e.message());
-      releaseInternalRef();
-      return;
+      std::ostringstream errorMsg;
+      errorMsg << _logId << "Fatal Exception while calling SIPB2BTransaction::runTask() - "
+              << entry.name << " - " << e.message();
+      OSS::log_error(errorMsg.str());
+      response = _pServerRequest->createResponse(500, e.message());
+      result = SIPB2BRequestPipeline::Respond;
     }
+  }
+}
 
+void SIPB2BTransaction::resumePipeline(SIPB2BRequestPipeline::Result result, const SIPMessage::Ptr& response)
+{
+  //
+  // Resume on the thread pool so the caller never runs the rest of the
+  // pipeline on its own thread.  Fall back to the caller thread like
+  // handleRequest does when the pool is depleted.
+  //
+  if (_pManager->threadPool().schedule(boost::bind(&SIPB2BTransaction::runPipeline, this, result, response)) == -1)
+    runPipeline(result, response);
+}
 
-    if (pRouteResponse)
-    {
-      if (pRouteResponse->isResponse())
-      {
-        OSS::Net::IPAddress target;
-        if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-        {
-          if (target.isValid())
-            _pServerTransaction->sendResponse(pRouteResponse, target);
-        }
-      }
-      releaseInternalRef();
-      return;
-    }
+void SIPB2BTransaction::endPipelineStage()
+{
+  if (!_pipelineHandlers)
+    return;
+  boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - _pipelineStageStart;
+  OSS::UInt64 micros = elapsed.is_negative() ? 0 : elapsed.total_microseconds();
+  _pManager->requestPipeline().recordLatency((SIPB2BRequestPipeline::Stage)_pipelineStage, micros);
+  _pipelineHandlers.reset();
+}
 
-    //
-    // Check if the route handler specified that a response would be handled locally
-    //
-    std::string invokeLocalHandler = "0";
-    if (getProperty(OSS::PropertyMap::PROP_InvokeLocalHandler, invokeLocalHandler ) && invokeLocalHandler == "1")
-    {
-      SIPMessage::Ptr localResponse = _pManager->onInvokeLocalHandler(_pServerRequest, _pServerTransport, shared_from_this());
-      if (!localResponse)
-        localResponse = _pServerRequest->createResponse(500, "No local handler specified");
-      OSS::Net::IPAddress target;
-      if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-      {
-        if (target.isValid())
-          _pServerTransaction->sendResponse(localResponse, target);
-      }
-      releaseInternalRef();
-      return;
-    }
+void SIPB2BTransaction::sendServerResponse(const SIPMessage::Ptr& response)
+{
+  gLocalResponses.increment();
+  OSS::Net::IPAddress target;
+  if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
+  {
+    if (target.isValid())
+      _pServerTransaction->sendResponse(response, target);
+  }
+}
 
-    if (_localInterface.address() != LOCALHOST.address() && _localInterface.isValid() && !_pManager->stack().transport().isLocalTransport(_localInterface))
-    {
-      OSS::log_critical(_logId + "Invalid Local-Interface returned by onRouteTransaction - " + _localInterface.toIpPortString() );
-      SIPMessage::Ptr serverError = _pServerRequest->createResponse(500, "Unable to determine local interface");
-      OSS::Net::IPAddress target;
-      if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-      {
-        if (target.isValid())
-          _pServerTransaction->sendResponse(serverError, target);
-      }
-      releaseInternalRef();
-      return;
-    }
+SIPB2BRequestPipeline::Result SIPB2BTransaction::onCreatedStage(SIPMessage::Ptr& response)
+{
+  //
+  // Signal transaction creation
+  //
+  response = _pManager->onTransactionCreated(_pServerRequest, shared_from_this());
+  return response ? SIPB2BRequestPipeline::Respond : SIPB2BRequestPipeline::Continue;
+}
 
-    if (!outboundTarget.isValid())
-    {
-      OSS::log_critical(_logId + "Invalid Outbound-Target returned by onRouteTransaction");
-      SIPMessage::Ptr serverError = _pServerRequest->createResponse(500);
-      OSS::Net::IPAddress target;
-      if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-      {
-        if (target.isValid())
-          _pServerTransaction->sendResponse(serverError, target);
-      }
-      releaseInternalRef();
-      return;
-    }
+SIPB2BRequestPipeline::Result SIPB2BTransaction::onAuthenticateStage(SIPMessage::Ptr& response)
+{
+  //
+  // Authenticate the request
+  //
+  response = _pManager->onAuthenticateTransaction(_pServerRequest, shared_from_this());
+  if (!response)
+    return SIPB2BRequestPipeline::Continue;
+  _isChallenged = true;
+  return SIPB2BRequestPipeline::Respond;
+}
 
-    //
-    // Set the target transport of the URI if specified
-    //
-    std::string targetTransport;
-    if (!_pClientRequest->getProperty(OSS::PropertyMap::PROP_TargetTransport, targetTransport))
+SIPB2BRequestPipeline::Result SIPB2BTransaction::onRouteStage(SIPMessage::Ptr& response)
+{
+  static OSS::Net::IPAddress LOCALHOST("127.0.0.1");
+
+  //
+  // Clone the server request.
+  // From now on, we will feed the clone to the server callbacks.
+  // The clone shares headers and body with the server request until
+  // routing rewrites them.
+  //
+  SIPMessage* outbound = new SIPMessage(*(_pServerRequest.get()));
+  std::string transportAlias;
+  if (_pServerRequest->getProperty(OSS::PropertyMap::PROP_TransportAlias, transportAlias) && !transportAlias.empty())
+  {
+    outbound->setProperty(OSS::PropertyMap::PROP_TransportAlias, transportAlias);
+  }
+  _pClientRequest = SIPMessage::Ptr(outbound);
+
+  //
+  // Route the outbound request.
+  // Send a response (probably a 404) if the request is non-routable
+  //
+  SIPMessage::Ptr pRouteResponse;
+
+  try
+  {
+    pRouteResponse = _pManager->onRouteTransaction(_pClientRequest, shared_from_this(), _localInterface, _outboundTarget);
+  }
+  catch(OSS::Exception e)
+  {
+    OSS::log_warning(_logId + e.message());
+    return SIPB2BRequestPipeline::Stop;
+  }
+
+
+  if (pRouteResponse)
+  {
+    if (pRouteResponse->isResponse())
     {
-       _pClientRequest->setProperty(OSS::PropertyMap::PROP_TargetTransport, "udp");
-       targetTransport = "udp";
+      response = pRouteResponse;
+      return SIPB2BRequestPipeline::Respond;
     }
+    return SIPB2BRequestPipeline::Stop;
+  }
+
+  //
+  // Check if the route handler specified that a response would be handled locally
+  //
+  std::string invokeLocalHandler = "0";
+  if (getProperty(OSS::PropertyMap::PROP_InvokeLocalHandler, invokeLocalHandler ) && invokeLocalHandler == "1")
+  {
+    response = _pManager->onInvokeLocalHandler(_pServerRequest, _pServerTransport, shared_from_this());
+    if (!response)
+      response = _pServerRequest->createResponse(500, "No local handler specified");
+    return SIPB2BRequestPipeline::Respond;
+  }
+
+  if (_localInterface.address() != LOCALHOST.address() && _localInterface.isValid() && !_pManager->stack().transport().isLocalTransport(_localInterface))
+  {
+    OSS::log_critical(_logId + "Invalid Local-Interface returned by onRouteTransaction - " + _localInterface.toIpPortString() );
+    response = _pServerRequest->createResponse(500, "Unable to determine local interface");
+    return SIPB2BRequestPipeline::Respond;
+  }
+
+  if (!_outboundTarget.isValid())
+  {
+    OSS::log_critical(_logId + "Invalid Outbound-Target returned by onRouteTransaction");
+    response = _pServerRequest->createResponse(500);
+    return SIPB2BRequestPipeline::Respond;
+  }
+
+  //
+  // Set the target transport of the URI if specified
+  //
+  std::string targetTransport;
+  if (!_pClientRequest->getProperty(OSS::PropertyMap::PROP_TargetTransport, targetTransport))
+  {
+     _pClientRequest->setProperty(OSS::PropertyMap::PROP_TargetTransport, "udp");
+     targetTransport = "udp";
+  }
 
 #if 0
-    //
-    // This conflicts with freeswitch uri authentication.  disable it for now
-    //
-    if (!targetTransport.empty())
+  //
+  // This conflicts with freeswitch uri authentication.  disable it for now
+  //
+  if (!targetTransport.empty())
+  {
+    OSS::string_to_lower(targetTransport);
+    SIPRequestLine rline = _pClientRequest->startLine();
+    SIPURI ruri;
+    if (rline.getURI(ruri))
     {
-      OSS::string_to_lower(targetTransport);
-      SIPRequestLine rline = _pClientRequest->startLine();
-      SIPURI ruri;
-      if (rline.getURI(ruri))
-      {
-        ruri.setParam("transport", targetTransport.c_str());
-        rline.setURI(ruri.data().c_str());
-        _pClientRequest->startLine() = rline.data();
-      }
+      ruri.setParam("transport", targetTransport.c_str());
+      rline.setURI(ruri.data().c_str());
+      _pClientRequest->startLine() = rline.data();
     }
+  }
 #endif
 
-    //
-    // Check if the route handler specified that a response would be generated locally
-    //
-    std::string genLocalResponse = "0";
-    if (getProperty(OSS::PropertyMap::PROP_GenerateLocalResponse, genLocalResponse ) && genLocalResponse == "1")
+  //
+  // Check if the route handler specified that a response would be generated locally
+  //
+  std::string genLocalResponse = "0";
+  if (getProperty(OSS::PropertyMap::PROP_GenerateLocalResponse, genLocalResponse ) && genLocalResponse == "1")
+  {
+    SIPMessage::Ptr localResponse = _pManager->onGenerateLocalResponse(_pServerRequest, _pServerTransport, shared_from_this());
+    if (localResponse)
     {
-      SIPMessage::Ptr localResponse = _pManager->onGenerateLocalResponse(_pServerRequest, _pServerTransport, shared_from_this());
-      if (localResponse)
+      OSS::Net::IPAddress target;
+      if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
       {
-        OSS::Net::IPAddress target;
-        if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
+        if (target.isValid())
         {
-          if (target.isValid())
-          {
-            _pManager->onProcessResponseOutbound(localResponse, shared_from_this());
-            _hasSentLocalResponse = true;
-            _pServerTransaction->sendResponse(localResponse, target);
-          }
+          _pManager->onProcessResponseOutbound(localResponse, shared_from_this());
+          _hasSentLocalResponse = true;
+          _pServerTransaction->sendResponse(localResponse, target);
         }
       }
     }
+  }
 
 
-    //
-    // Save the address properties
-    //
-    _pClientRequest->setProperty(OSS::PropertyMap::PROP_TargetAddress, outboundTarget.toIpPortString());
-    _pClientRequest->setProperty(OSS::PropertyMap::PROP_LocalAddress, _localInterface.toIpPortString());
+  //
+  // Save the address properties
+  //
+  _pClientRequest->setProperty(OSS::PropertyMap::PROP_TargetAddress, _outboundTarget.toIpPortString());
+  _pClientRequest->setProperty(OSS::PropertyMap::PROP_LocalAddress, _localInterface.toIpPortString());
+  return SIPB2BRequestPipeline::Continue;
+}
 
-    //
-    // Handle the message body
-    //
-    if (!_pClientRequest->body().empty())
-    {
-      std::string serverRequestXor = "0";
-      _pServerRequest->getProperty(OSS::PropertyMap::PROP_XOR, serverRequestXor);
-      std::string clientRequestXor = "0";
-      _pClientRequest->getProperty(OSS::PropertyMap::PROP_XOR, clientRequestXor);
-      _pClientRequest->setProperty(OSS::PropertyMap::PROP_PeerXOR, serverRequestXor);
-      _pServerRequest->setProperty(OSS::PropertyMap::PROP_PeerXOR, clientRequestXor);
-
-      SIPMessage::Ptr pBodyResponse;
-      pBodyResponse = _pManager->onProcessRequestBody(_pClientRequest, shared_from_this());
-      if (pBodyResponse)
+SIPB2BRequestPipeline::Result SIPB2BTransaction::onOutboundStage(SIPMessage::Ptr& response)
+{
+  //
+  // Handle the message body
+  //
+  if (!_pClientRequest->getBody().empty())
+  {
+    std::string serverRequestXor = "0";
+    _pServerRequest->getProperty(OSS::PropertyMap::PROP_XOR, serverRequestXor);
+    std::string clientRequestXor = "0";
+    _pClientRequest->getProperty(OSS::PropertyMap::PROP_XOR, clientRequestXor);
+    _pClientRequest->setProperty(OSS::PropertyMap::PROP_PeerXOR, serverRequestXor);
+    _pServerRequest->setProperty(OSS::PropertyMap::PROP_PeerXOR, clientRequestXor);
+
+    SIPMessage::Ptr pBodyResponse;
+    pBodyResponse = _pManager->onProcessRequestBody(_pClientRequest, shared_from_this());
+    if (pBodyResponse)
+    {
+      if (pBodyResponse->isResponse())
       {
-        if (pBodyResponse->isResponse())
-        {
-          OSS::Net::IPAddress target;
-          if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-          {
-            if (target.isValid())
-              _pServerTransaction->sendResponse(pBodyResponse, target);
-          }
-        }
-        releaseInternalRef();
-        return;
+        response = pBodyResponse;
+        return SIPB2BRequestPipeline::Respond;
       }
+      return SIPB2BRequestPipeline::Stop;
     }
-    //
-    // Last chance for the application to process the outbound request
-    //
-    _pManager->onProcessOutbound(_pClientRequest, shared_from_this());
+  }
+  //
+  // Last chance for the application to process the outbound request
+  //
+  _pManager->onProcessOutbound(_pClientRequest, shared_from_this());
+  return SIPB2BRequestPipeline::Continue;
+}
 
+void SIPB2BTransaction::sendClientRequest()
+{
+  try
+  {
     //
     // Commit the changes
     //
@@ -389,10 +481,14 @@ void SIPB2BTransaction::runTask()
     OSS::SIP::SIPTransaction::TerminateCallback terminateCallback
       = boost::bind(&SIPB2BTransaction::releaseInternalRef, this);
 
+    //
+    // Record before sending.  A failed send may release the transaction.
+    //
+    gSetupLatency.record(OSS::Metrics::now() - _createTime);
     _pManager->stack().sendRequest(
       _pClientRequest,
       _localInterface,
-      outboundTarget,
+      _outboundTarget,
       responseCallback,
       terminateCallback);
 
@@ -405,21 +501,13 @@ void SIPB2BTransaction::runTask()
   }
   catch(OSS::Exception e)
   {
-
-    SIPMessage::Ptr serverError = _pServerRequest->createResponse(500, e.message());
-    OSS::Net::IPAddress target;
-    if (onRouteResponse(_pServerRequest, _pServerTransport,_pServerTransaction, target))
-    {
-      if (target.isValid())
-        _pServerTransaction->sendResponse(serverError, target);
-    }
+    sendServerResponse(_pServerRequest->createResponse(500, e.message()));
 
     std::ostringstream errorMsg;
     errorMsg << _logId << "Fatal Exception while calling SIPB2BTransaction::runTask() - "
             << e.message();
     OSS::log_error(errorMsg.str());
     releaseInternalRef();
-    return;
   }
 }
 
@@ -549,7 +637,7 @@ void SIPB2BTransaction::runResponseTask()
           pProvisionalResponse->setProperty(OSS::PropertyMap::PROP_ResponseInterface,
             _pServerTransport->getLocalAddress().toIpPortString().c_str());
           
-          if (!pProvisionalResponse->body().empty())
+          if (!pProvisionalResponse->getBody().empty())
             _pManager->onProcessResponseBody(pProvisionalResponse, shared_from_this());
 
           if (target.isValid())
@@ -580,7 +668,7 @@ void SIPB2BTransaction::runResponseTask()
           response->setProperty(OSS::PropertyMap::PROP_PeerXOR, clientRequestPeerXor);
           pFinalResponse->setProperty(OSS::PropertyMap::PROP_PeerXOR, serverRequestPeerXor);
 
-          if (!pFinalResponse->body().empty())
+          if (!pFinalResponse->getBody().empty())
             _pManager->onProcessResponseBody(pFinalResponse, shared_from_this());
 
           pFinalResponse->setProperty(OSS::PropertyMap::PROP_ResponseTarget, target.toIpPortString().c_str());
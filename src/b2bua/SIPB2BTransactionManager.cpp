@@ -38,6 +38,14 @@ SIPB2BTransactionManager::SIPB2BTransactionManager(int minThreadcount, int maxTh
   _pDefaultHandler(0),
   _maxThreadCount(maxThreadCount)  
 {
+  _requestPipeline.addHandler(SIPB2BRequestPipeline::StageCreated, "transaction-created",
+    SIPB2BRequestPipeline::BUILTIN_PRIORITY, boost::bind(&SIPB2BTransaction::onCreatedStage, _1, _2));
+  _requestPipeline.addHandler(SIPB2BRequestPipeline::StageAuthenticate, "authenticate-transaction",
+    SIPB2BRequestPipeline::BUILTIN_PRIORITY, boost::bind(&SIPB2BTransaction::onAuthenticateStage, _1, _2));
+  _requestPipeline.addHandler(SIPB2BRequestPipeline::StageRoute, "route-transaction",
+    SIPB2BRequestPipeline::BUILTIN_PRIORITY, boost::bind(&SIPB2BTransaction::onRouteStage, _1, _2));
+  _requestPipeline.addHandler(SIPB2BRequestPipeline::StageOutbound, "process-outbound",
+    SIPB2BRequestPipeline::BUILTIN_PRIORITY, boost::bind(&SIPB2BTransaction::onOutboundStage, _1, _2));
 }
 
 SIPB2BTransactionManager::~SIPB2BTransactionManager()
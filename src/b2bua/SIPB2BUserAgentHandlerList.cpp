@@ -29,7 +29,8 @@ namespace B2BUA {
 
 
 
-SIPB2BUserAgentHandlerList::SIPB2BUserAgentHandlerList()
+SIPB2BUserAgentHandlerList::SIPB2BUserAgentHandlerList() :
+  _handlers(new Handlers())
 {
 }
 
@@ -44,8 +45,10 @@ void SIPB2BUserAgentHandlerList::addHandler(SIPB2BUserAgentHandler* pHandler)
   OSS::mutex_critic_sec_lock lock(_mutex);
   Item item;
   item.handler = pHandler;
-  _handlers.push_back(item);
-  _handlers.sort();
+  Handlers* pHandlers = new Handlers(*_handlers);
+  pHandlers->push_back(item);
+  pHandlers->sort();
+  _handlers = HandlersPtr(pHandlers);
 }
 
 SIPB2BUserAgentHandler::Action SIPB2BUserAgentHandlerList::operator()(
@@ -53,9 +56,14 @@ SIPB2BUserAgentHandler::Action SIPB2BUserAgentHandlerList::operator()(
     const OSS::SIP::SIPTransportSession::Ptr& pTransport,
     const OSS::SIP::SIPTransaction::Ptr& pTransaction)
 {
-  OSS::mutex_critic_sec_lock lock(_mutex);
+  HandlersPtr handlers;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    handlers = _handlers;
+  }
+
   SIPB2BUserAgentHandler::Action action = SIPB2BUserAgentHandler::Continue;
-  for (std::list<Item>::iterator iter = _handlers.begin(); iter != _handlers.end(); iter++)
+  for (Handlers::const_iterator iter = handlers->begin(); iter != handlers->end(); iter++)
   {
     action = iter->handler->handleRequest(pMsg, pTransport, pTransaction);
     if (action != SIPB2BUserAgentHandler::Continue)
@@ -0,0 +1,137 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "OSS/BSON/BSONArena.h"
+
+
+namespace OSS {
+namespace BSON {
+
+
+BSONArena::BSONArena(std::size_t capacity) :
+  _data(0),
+  _size(0),
+  _capacity(0),
+  _isOwner(true)
+{
+  reserve(capacity);
+}
+
+BSONArena::BSONArena(uint8_t* buffer, std::size_t capacity) :
+  _data(buffer),
+  _size(0),
+  _capacity(capacity),
+  _isOwner(false)
+{
+}
+
+BSONArena::~BSONArena()
+{
+  if (_isOwner)
+  {
+    free(_data);
+  }
+}
+
+bool BSONArena::reserve(std::size_t capacity)
+{
+  if (capacity <= _capacity && _data)
+  {
+    return true;
+  }
+
+  uint8_t* data = 0;
+  if (_isOwner)
+  {
+    data = (uint8_t*)realloc(_data, capacity);
+  }
+  else
+  {
+    //
+    // Leave the caller's buffer and continue on the heap
+    //
+    data = (uint8_t*)malloc(capacity);
+    if (data && _size)
+    {
+      memcpy(data, _data, _size);
+    }
+  }
+
+  if (!data)
+  {
+    return false;
+  }
+
+  _data = data;
+  _capacity = capacity;
+  _isOwner = true;
+  return true;
+}
+
+uint8_t* BSONArena::allocate(std::size_t len)
+{
+  if (_size + len > _capacity || !_data)
+  {
+    std::size_t capacity = _capacity ? _capacity : DEFAULT_CAPACITY;
+    while (capacity < _size + len)
+    {
+      capacity *= 2;
+    }
+    if (!reserve(capacity))
+    {
+      return 0;
+    }
+  }
+
+  uint8_t* ptr = _data + _size;
+  _size += len;
+  return ptr;
+}
+
+uint8_t* BSONArena::release(std::size_t& len)
+{
+  len = _size;
+  uint8_t* data = 0;
+  if (_isOwner)
+  {
+    data = _data;
+    _data = 0;
+    _capacity = 0;
+  }
+  else if (_size)
+  {
+    data = (uint8_t*)malloc(_size);
+    if (data)
+    {
+      memcpy(data, _data, _size);
+    }
+  }
+  if (!data)
+  {
+    len = 0;
+  }
+  _size = 0;
+  return data;
+}
+
+
+} } // OSS::BSON
@@ -19,6 +19,8 @@
 //
 
 #include "OSS/BSON/BSONQueue.h"
+#include <stdlib.h>
+#include <string.h>
 
 #if ENABLE_FEATURE_ZMQ
 
@@ -28,6 +30,11 @@ namespace BSON {
   
 using OSS::ZMQ::ZMQSocket; 
 
+static void bson_queue_free(void* data, void* hint)
+{
+  free(data);
+}
+
     
 BSONQueue::BSONQueue(Role role, const std::string& name) :
   _role(role),
@@ -61,11 +68,33 @@ bool BSONQueue::enqueue(BSONParser& msg)
     return false;
   }
   
-  std::string data((const char*)msg.getData(), msg.getDataLength());
-  return _pSocket->sendRequest("BSONQueue::enqueue", data);
+  std::size_t len = msg.getDataLength();
+  void* data = malloc(len);
+  if (!data)
+  {
+    return false;
+  }
+  memcpy(data, msg.getData(), len);
+  return _pSocket->sendRequest("BSONQueue::enqueue", data, len, bson_queue_free);
 }
 
-bool BSONQueue::dequeue(BSONParser& msg)
+bool BSONQueue::enqueue(BSONWriter& msg)
+{
+  if (!_pSocket || _role != PRODUCER || !msg.finish())
+  {
+    return false;
+  }
+  
+  std::size_t len = 0;
+  uint8_t* data = msg.arena().release(len);
+  if (!data)
+  {
+    return false;
+  }
+  return _pSocket->sendRequest("BSONQueue::enqueue", data, len, bson_queue_free);
+}
+
+bool BSONQueue::dequeue(std::string& bson)
 {
   if (_role != CONSUMER)
   {
@@ -73,7 +102,6 @@ bool BSONQueue::dequeue(BSONParser& msg)
   }
   
   std::string cmd;
-  std::string bson;
   if (!_pSocket->receiveRequest(cmd, bson))
   {
     return false;
@@ -83,6 +111,16 @@ bool BSONQueue::dequeue(BSONParser& msg)
   {
     return false;
   }
+  return true;
+}
+
+bool BSONQueue::dequeue(BSONParser& msg)
+{
+  std::string bson;
+  if (!dequeue(bson))
+  {
+    return false;
+  }
   
   msg.reset((uint8_t*)bson.data(), bson.size());
   return true;
@@ -90,20 +128,23 @@ bool BSONQueue::dequeue(BSONParser& msg)
 
 bool BSONQueue::enqueue(BSONDocument& msg)
 {
-  BSONParser bson;
-  msg.toBSON(bson);
+  BSONArena arena;
+  BSONWriter bson(arena);
+  if (!msg.toBSON(bson))
+  {
+    return false;
+  }
   return enqueue(bson);
 }
 
 bool BSONQueue::dequeue(BSONDocument& msg)
 {
-  BSONParser bson;
+  std::string bson;
   if (!dequeue(bson))
   {
     return false;
   }
-  msg.fromBSON(bson);
-  return true;
+  return msg.fromBSON((const uint8_t*)bson.data(), bson.size());
 }
 
 bool BSONQueue::initSocket()
@@ -0,0 +1,297 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <string.h>
+#include "OSS/BSON/libbson.h"
+#include "OSS/BSON/BSONReader.h"
+
+
+namespace OSS {
+namespace BSON {
+
+
+static inline uint32_t bson_read_le32(const uint8_t* ptr)
+{
+  return (uint32_t)ptr[0] |
+    ((uint32_t)ptr[1] << 8) |
+    ((uint32_t)ptr[2] << 16) |
+    ((uint32_t)ptr[3] << 24);
+}
+
+static inline uint64_t bson_read_le64(const uint8_t* ptr)
+{
+  return (uint64_t)bson_read_le32(ptr) | ((uint64_t)bson_read_le32(ptr + 4) << 32);
+}
+
+static bool bson_cstring_length(const uint8_t* ptr, std::size_t available, std::size_t& len)
+{
+  const void* nul = memchr(ptr, 0, available);
+  if (!nul)
+  {
+    return false;
+  }
+  len = (const uint8_t*)nul - ptr;
+  return true;
+}
+
+static bool bson_value_length(int type, const uint8_t* value, std::size_t available, std::size_t& len)
+  /// Determines the encoded size of a value from its type and, for
+  /// variable length types, its length prefix
+{
+  std::size_t first = 0;
+  std::size_t second = 0;
+  switch (type)
+  {
+    case BSON_TYPE_DOUBLE:
+    case BSON_TYPE_DATE_TIME:
+    case BSON_TYPE_TIMESTAMP:
+    case BSON_TYPE_INT64:
+      len = 8;
+      break;
+    case BSON_TYPE_INT32:
+      len = 4;
+      break;
+    case BSON_TYPE_BOOL:
+      len = 1;
+      break;
+    case BSON_TYPE_OID:
+      len = 12;
+      break;
+    case BSON_TYPE_UNDEFINED:
+    case BSON_TYPE_NULL:
+    case BSON_TYPE_MINKEY:
+    case BSON_TYPE_MAXKEY:
+      len = 0;
+      break;
+    case BSON_TYPE_UTF8:
+    case BSON_TYPE_CODE:
+    case BSON_TYPE_SYMBOL:
+      if (available < 4)
+        return false;
+      len = 4 + bson_read_le32(value);
+      break;
+    case BSON_TYPE_BINARY:
+      if (available < 4)
+        return false;
+      len = 5 + bson_read_le32(value);
+      break;
+    case BSON_TYPE_DBPOINTER:
+      if (available < 4)
+        return false;
+      len = 4 + bson_read_le32(value) + 12;
+      break;
+    case BSON_TYPE_DOCUMENT:
+    case BSON_TYPE_ARRAY:
+    case BSON_TYPE_CODEWSCOPE:
+      if (available < 4)
+        return false;
+      len = bson_read_le32(value);
+      break;
+    case BSON_TYPE_REGEX:
+      if (!bson_cstring_length(value, available, first) ||
+        !bson_cstring_length(value + first + 1, available - first - 1, second))
+        return false;
+      len = first + second + 2;
+      break;
+    default:
+      return false;
+  }
+  return len <= available;
+}
+
+BSONReader::BSONReader() :
+  _base(0),
+  _end(0),
+  _offset(0),
+  _next(0),
+  _value(0),
+  _valueLength(0),
+  _type(BSON_TYPE_EOD)
+{
+}
+
+BSONReader::BSONReader(const uint8_t* data, std::size_t len) :
+  _base(0),
+  _end(0),
+  _offset(0),
+  _next(0),
+  _value(0),
+  _valueLength(0),
+  _type(BSON_TYPE_EOD)
+{
+  //
+  // A document is a length prefix, its elements and a terminating zero
+  //
+  if (!data || len < 5)
+  {
+    return;
+  }
+  std::size_t documentLength = bson_read_le32(data);
+  if (documentLength < 5 || documentLength > len || data[documentLength - 1] != 0)
+  {
+    return;
+  }
+  _base = data;
+  _end = documentLength - 1;
+  _next = 4;
+}
+
+BSONReader::BSONReader(const uint8_t* base, std::size_t offset, std::size_t len) :
+  _base(0),
+  _end(0),
+  _offset(offset),
+  _next(0),
+  _value(0),
+  _valueLength(0),
+  _type(BSON_TYPE_EOD)
+{
+  if (len < 5 || base[offset + len - 1] != 0)
+  {
+    return;
+  }
+  _base = base;
+  _end = offset + len - 1;
+  _next = offset + 4;
+}
+
+bool BSONReader::next()
+{
+  _value = 0;
+  _valueLength = 0;
+  _type = BSON_TYPE_EOD;
+
+  if (!_base || _next >= _end)
+  {
+    return false;
+  }
+
+  const uint8_t* element = _base + _next;
+  std::size_t available = _end - _next;
+  std::size_t keyLength = 0;
+  if (!bson_cstring_length(element + 1, available - 1, keyLength))
+  {
+    _next = _end;
+    return false;
+  }
+
+  std::size_t header = 1 + keyLength + 1;
+  std::size_t valueLength = 0;
+  int type = element[0];
+  if (!bson_value_length(type, element + header, available - header, valueLength))
+  {
+    _next = _end;
+    return false;
+  }
+
+  _offset = _next;
+  _type = type;
+  _value = element + header;
+  _valueLength = valueLength;
+  _next += header + valueLength;
+  return true;
+}
+
+bool BSONReader::getString(const char*& value, std::size_t& len) const
+{
+  if (_type != BSON_TYPE_UTF8 || _valueLength < 5)
+  {
+    return false;
+  }
+  value = (const char*)(_value + 4);
+  len = _valueLength - 5;
+  return true;
+}
+
+bool BSONReader::getString(std::string& value) const
+{
+  const char* str = 0;
+  std::size_t len = 0;
+  if (!getString(str, len))
+  {
+    return false;
+  }
+  value.assign(str, len);
+  return true;
+}
+
+bool BSONReader::getBoolean(bool& value) const
+{
+  if (_type != BSON_TYPE_BOOL)
+  {
+    return false;
+  }
+  value = *_value != 0;
+  return true;
+}
+
+bool BSONReader::getInt32(int32_t& value) const
+{
+  if (_type != BSON_TYPE_INT32)
+  {
+    return false;
+  }
+  value = (int32_t)bson_read_le32(_value);
+  return true;
+}
+
+bool BSONReader::getInt64(int64_t& value) const
+{
+  if (_type != BSON_TYPE_INT64)
+  {
+    return false;
+  }
+  value = (int64_t)bson_read_le64(_value);
+  return true;
+}
+
+bool BSONReader::getIntptr(intptr_t& value) const
+{
+  int64_t int64Value = 0;
+  if (!getInt64(int64Value))
+  {
+    return false;
+  }
+  value = (intptr_t)int64Value;
+  return true;
+}
+
+bool BSONReader::getDouble(double& value) const
+{
+  if (_type != BSON_TYPE_DOUBLE)
+  {
+    return false;
+  }
+  uint64_t bits = bson_read_le64(_value);
+  memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+bool BSONReader::recurse(BSONReader& child) const
+{
+  if (_type != BSON_TYPE_DOCUMENT && _type != BSON_TYPE_ARRAY)
+  {
+    return false;
+  }
+  child = BSONReader(_base, _value - _base, _valueLength);
+  return child.isValid();
+}
+
+
+} } // OSS::BSON
@@ -22,6 +22,13 @@
 
 #include "OSS/BSON/libbson.h"
 #include "OSS/BSON/BSONValue.h"
+#include "OSS/BSON/BSONString.h"
+#include "OSS/BSON/BSONBool.h"
+#include "OSS/BSON/BSONDouble.h"
+#include "OSS/BSON/BSONInt32.h"
+#include "OSS/BSON/BSONInt64.h"
+#include "OSS/BSON/BSONArray.h"
+#include "OSS/BSON/BSONDocument.h"
 #include "OSS/UTL/CoreUtils.h"
 
 
@@ -437,7 +444,8 @@ std::string BSONValue::toJSON() const
 
 
 
-void BSONValue::serializeDocument(const std::string& key, const Document& document, BSONParser& bson) const
+template <typename Builder_T>
+void BSONValue::serializeDocument(const std::string& key, const Document& document, Builder_T& bson) const
 { 
   //
   // The root document doesn't have a key
@@ -483,7 +491,8 @@ void BSONValue::serializeDocument(const std::string& key, const Document& docume
   }
 }
 
-void BSONValue::serializeArray(const std::string& key, const Array& array, BSONParser& bson) const
+template <typename Builder_T>
+void BSONValue::serializeArray(const std::string& key, const Array& array, Builder_T& bson) const
 {
   if (!key.empty())
   {
@@ -529,7 +538,8 @@ void BSONValue::serializeArray(const std::string& key, const Array& array, BSONP
   }
 }
   
-void BSONValue::toBSON(BSONParser& bson) const
+template <typename Builder_T>
+void BSONValue::serializeValue(Builder_T& bson) const
 {
   switch(_type)
   {
@@ -557,6 +567,11 @@ void BSONValue::toBSON(BSONParser& bson) const
   }
 }
   
+void BSONValue::toBSON(BSONParser& bson) const
+{
+  serializeValue(bson);
+}
+  
 BSONParser BSONValue::toBSON() const
 {
   BSONParser bson;
@@ -564,9 +579,119 @@ BSONParser BSONValue::toBSON() const
   return bson;
 }
 
+bool BSONValue::toBSON(BSONWriter& bson) const
+{
+  serializeValue(bson);
+  return bson.finish();
+}
+
+static void deserializeDocument(BSONReader& reader, BSONValue::Document& document);
+static void deserializeArray(BSONReader& reader, BSONValue::Array& array);
+
+static bool deserializeValue(const BSONReader& reader, BSONValue& value)
+{
+  switch (reader.getType())
+  {
+    case BSON_TYPE_UTF8:
+    {
+      std::string stringValue;
+      reader.getString(stringValue);
+      value = BSONString(stringValue);
+      return true;
+    }
+    case BSON_TYPE_BOOL:
+    {
+      bool boolValue = false;
+      reader.getBoolean(boolValue);
+      value = BSONBool(boolValue);
+      return true;
+    }
+    case BSON_TYPE_DOUBLE:
+    {
+      double doubleValue = 0;
+      reader.getDouble(doubleValue);
+      value = BSONDouble(doubleValue);
+      return true;
+    }
+    case BSON_TYPE_INT32:
+    {
+      int32_t int32Value = 0;
+      reader.getInt32(int32Value);
+      value = BSONInt32(int32Value);
+      return true;
+    }
+    case BSON_TYPE_INT64:
+    {
+      int64_t int64Value = 0;
+      reader.getInt64(int64Value);
+      value = BSONInt64(int64Value);
+      return true;
+    }
+    case BSON_TYPE_DOCUMENT:
+    {
+      BSONReader child;
+      BSONValue::Document document;
+      if (reader.recurse(child))
+      {
+        deserializeDocument(child, document);
+      }
+      value = BSONDocument(document);
+      return true;
+    }
+    case BSON_TYPE_ARRAY:
+    {
+      BSONReader child;
+      BSONValue::Array array;
+      if (reader.recurse(child))
+      {
+        deserializeArray(child, array);
+      }
+      value = BSONArray(array);
+      return true;
+    }
+  }
+  //
+  // Types BSONValue cannot hold are left undefined
+  //
+  return false;
+}
+
+static void deserializeDocument(BSONReader& reader, BSONValue::Document& document)
+{
+  while (reader.next())
+  {
+    deserializeValue(reader, document[reader.getKey()]);
+  }
+}
+
+static void deserializeArray(BSONReader& reader, BSONValue::Array& array)
+{
+  while (reader.next())
+  {
+    array.push_back(BSONValue());
+    deserializeValue(reader, array.back());
+  }
+}
+
 void BSONValue::fromBSON(const BSONParser& bson)
 {
-  
+  BSONParser& parser = const_cast<BSONParser&>(bson);
+  fromBSON(parser.getData(), parser.getDataLength());
+}
+
+bool BSONValue::fromBSON(const uint8_t* bson, std::size_t len)
+{
+  BSONReader reader(bson, len);
+  if (!_mutable || !reader.isValid())
+  {
+    return false;
+  }
+  Document document;
+  deserializeDocument(reader, document);
+  _type = TYPE_DOCUMENT;
+  _value = Document();
+  boost::any_cast<Document&>(_value).swap(document);
+  return true;
 }
 
 } } // OSS::BSON
@@ -0,0 +1,249 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <string.h>
+#include "OSS/BSON/libbson.h"
+#include "OSS/BSON/BSONWriter.h"
+
+
+namespace OSS {
+namespace BSON {
+
+
+static inline void bson_write_le32(uint8_t* ptr, uint32_t value)
+{
+  ptr[0] = (uint8_t)value;
+  ptr[1] = (uint8_t)(value >> 8);
+  ptr[2] = (uint8_t)(value >> 16);
+  ptr[3] = (uint8_t)(value >> 24);
+}
+
+static inline void bson_write_le64(uint8_t* ptr, uint64_t value)
+{
+  bson_write_le32(ptr, (uint32_t)value);
+  bson_write_le32(ptr + 4, (uint32_t)(value >> 32));
+}
+
+BSONWriter::BSONWriter(BSONArena& arena) :
+  _arena(arena),
+  _depth(0),
+  _finished(false),
+  _failed(false)
+{
+  _arena.clear();
+  _offsets[0] = 0;
+  _types[0] = BSON_TYPE_DOCUMENT;
+  if (!_arena.allocate(4))
+  {
+    _failed = true;
+  }
+}
+
+uint8_t* BSONWriter::appendElement(int type, const std::string& key, std::size_t valueLength)
+{
+  if (_finished || _failed)
+  {
+    return 0;
+  }
+
+  //
+  // type byte, key as a C string, then the value
+  //
+  uint8_t* ptr = _arena.allocate(1 + key.size() + 1 + valueLength);
+  if (!ptr)
+  {
+    _failed = true;
+    return 0;
+  }
+  *ptr++ = (uint8_t)type;
+  memcpy(ptr, key.data(), key.size());
+  ptr += key.size();
+  *ptr++ = 0;
+  return ptr;
+}
+
+bool BSONWriter::appendString(const std::string& key, const char* value, std::size_t len)
+{
+  uint8_t* ptr = appendElement(BSON_TYPE_UTF8, key, 4 + len + 1);
+  if (!ptr)
+  {
+    return false;
+  }
+  bson_write_le32(ptr, (uint32_t)(len + 1));
+  memcpy(ptr + 4, value, len);
+  ptr[4 + len] = 0;
+  return true;
+}
+
+bool BSONWriter::appendBoolean(const std::string& key, bool value)
+{
+  uint8_t* ptr = appendElement(BSON_TYPE_BOOL, key, 1);
+  if (!ptr)
+  {
+    return false;
+  }
+  *ptr = value ? 1 : 0;
+  return true;
+}
+
+bool BSONWriter::appendInt32(const std::string& key, int32_t value)
+{
+  uint8_t* ptr = appendElement(BSON_TYPE_INT32, key, 4);
+  if (!ptr)
+  {
+    return false;
+  }
+  bson_write_le32(ptr, (uint32_t)value);
+  return true;
+}
+
+bool BSONWriter::appendInt64(const std::string& key, int64_t value)
+{
+  uint8_t* ptr = appendElement(BSON_TYPE_INT64, key, 8);
+  if (!ptr)
+  {
+    return false;
+  }
+  bson_write_le64(ptr, (uint64_t)value);
+  return true;
+}
+
+bool BSONWriter::appendIntptr(const std::string& key, intptr_t value)
+{
+  return appendInt64(key, (int64_t)value);
+}
+
+bool BSONWriter::appendDouble(const std::string& key, double value)
+{
+  uint8_t* ptr = appendElement(BSON_TYPE_DOUBLE, key, 8);
+  if (!ptr)
+  {
+    return false;
+  }
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bson_write_le64(ptr, bits);
+  return true;
+}
+
+bool BSONWriter::appendUndefined(const std::string& key)
+{
+  return appendElement(BSON_TYPE_UNDEFINED, key, 0) != 0;
+}
+
+bool BSONWriter::beginContainer(int type, const std::string& key)
+{
+  if (_depth + 1 >= MAX_DEPTH)
+  {
+    return false;
+  }
+  if (!appendElement(type, key, 4))
+  {
+    return false;
+  }
+  //
+  // The length prefix is filled in by endContainer()
+  //
+  _depth++;
+  _offsets[_depth] = _arena.size() - 4;
+  _types[_depth] = type;
+  return true;
+}
+
+bool BSONWriter::endContainer(int type)
+{
+  if (_finished || _failed || _depth == 0 || _types[_depth] != type)
+  {
+    return false;
+  }
+  uint8_t* ptr = _arena.allocate(1);
+  if (!ptr)
+  {
+    _failed = true;
+    return false;
+  }
+  *ptr = 0;
+  std::size_t offset = _offsets[_depth--];
+  bson_write_le32(_arena.data() + offset, (uint32_t)(_arena.size() - offset));
+  return true;
+}
+
+bool BSONWriter::appendDocumentBegin(const std::string& key)
+{
+  return beginContainer(BSON_TYPE_DOCUMENT, key);
+}
+
+bool BSONWriter::appendDocumentEnd(const std::string& key)
+{
+  return endContainer(BSON_TYPE_DOCUMENT);
+}
+
+bool BSONWriter::appendArrayBegin(const std::string& key)
+{
+  return beginContainer(BSON_TYPE_ARRAY, key);
+}
+
+bool BSONWriter::appendArrayEnd(const std::string& key)
+{
+  return endContainer(BSON_TYPE_ARRAY);
+}
+
+bool BSONWriter::finish()
+{
+  if (_finished)
+  {
+    return true;
+  }
+  if (_failed || _depth != 0)
+  {
+    return false;
+  }
+  uint8_t* ptr = _arena.allocate(1);
+  if (!ptr)
+  {
+    _failed = true;
+    return false;
+  }
+  *ptr = 0;
+  bson_write_le32(_arena.data(), (uint32_t)_arena.size());
+  _finished = true;
+  return true;
+}
+
+const uint8_t* BSONWriter::getData()
+{
+  if (!finish())
+  {
+    return 0;
+  }
+  return _arena.data();
+}
+
+std::size_t BSONWriter::getDataLength()
+{
+  if (!finish())
+  {
+    return 0;
+  }
+  return _arena.size();
+}
+
+
+} } // OSS::BSON
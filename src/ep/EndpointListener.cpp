@@ -97,7 +97,10 @@ void EndpointListener::monitorEvents()
 
 void EndpointListener::postEvent(const SIPMessage::Ptr& pRequest)
 {
-  _eventQueue.enqueue(pRequest);
+  if (!_eventQueue.enqueue(pRequest) && pRequest)
+  {
+    OSS_LOG_WARNING(pRequest->createContextId(true) << "EndpointListener::postEvent( " << _endpointName << " ) - event queue is full.  Dropping " << pRequest->startLine());
+  }
 }
 
 void EndpointListener::dispatchMessage(const SIPMessage::Ptr& pRequest)
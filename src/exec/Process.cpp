@@ -41,6 +41,7 @@
 #include <sys/resource.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <dirent.h>
 
 
 #define PROC_INIT_WAIT 10000
@@ -50,114 +51,48 @@ namespace OSS {
 namespace Exec {
 
 
-static bool headerSplit(
-    const std::string & header,
-    std::string & name,
-    std::string & value)
+static bool matchProcessName(pid_t pid, const std::string& process)
 {
-  size_t nameBound = header.find_first_of(':');
-  if (nameBound == std::string::npos)
-  {
-    return false;
-  }
-  name = header.substr(0,nameBound);
-  value = header.substr(nameBound+1);
-  boost::trim(name);
-  boost::trim(value);
-  return true;
+  std::string procName;
+  return ProcessSampler::readName(pid, procName) && OSS::string_starts_with(process, procName.c_str());
 }
 
-static bool getStatusHeader(const std::string& file, const std::string& name_, std::string& value_)
+static void findProcesses(const std::string& process, std::vector<pid_t>& pids, bool firstOnly)
 {
-  std::ifstream procif(file.c_str());
-  if (!procif.is_open())
-    return false;
-
-  std::string headerName = name_;
-  boost::to_lower(headerName);
-
-  
-  while(!procif.eof() && !procif.bad())
-  {
-    std::string line;
-    std::getline(procif, line);
-    std::string name;
-    std::string value;
-    if (headerSplit(line, name, value))
-    {
-      boost::to_lower(name);
-      if (name == headerName)
-      {
-        value_ = value;
-        return true;
-      }
-    }
-  }
-
-  return false;
-}
-
-static bool getStatusHeader(const std::string& file, const std::string& name_, std::vector<std::string>& values_)
-{
-  std::ifstream procif(file.c_str());
-  if (!procif.is_open())
-    return false;
-
-  std::string headerName = name_;
-  boost::to_lower(headerName);
+  //
+  // Only numeric entries are processes.  Everything else is skipped without
+  // touching the disk.
+  //
+  DIR* dir = opendir("/proc");
+  if (!dir)
+    return;
 
-  values_.clear();
-  while(!procif.eof() && !procif.bad())
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != 0)
   {
-    std::string line;
-    std::getline(procif, line);
-    std::string name;
-    std::string value;
-    if (headerSplit(line, name, value))
+    if (entry->d_name[0] < '1' || entry->d_name[0] > '9')
+      continue;
+    char* end = 0;
+    long pid = strtol(entry->d_name, &end, 10);
+    if (*end != '\0' || pid <= 0)
+      continue;
+    if (matchProcessName((pid_t)pid, process))
     {
-      boost::to_lower(name);
-      if (name == headerName)
-      {
-        values_.push_back(value);
-      }
+      pids.push_back((pid_t)pid);
+      if (firstOnly)
+        break;
     }
-    line.clear();
   }
-
-  return !values_.empty();
-}
-
-static unsigned int kbToInt(const std::string& kb)
-{
-  std::vector<std::string> tokens = OSS::string_tokenize(kb, " ");
-  if (tokens.size() < 2)
-    return 0;
-  return OSS::string_to_number<unsigned int>(tokens[0].c_str());
+  closedir(dir);
 }
 
 double getMem(int pid)
 {
-  std::string memTotal;
-  if (!getStatusHeader("/proc/meminfo", "memtotal", memTotal))
-    return 0.0;
-
-  std::ostringstream smapFile;
-  smapFile << "/proc/" << pid << "/smaps";
-
-  std::vector<std::string> memBlocks;
-  if (!getStatusHeader(smapFile.str().c_str(), "Private_Dirty", memBlocks))
-    return 0.0;
-
-  unsigned int procMem = 0;
-  unsigned int totalMem = OSS::string_to_number<unsigned int>(memTotal.c_str());
-  for (std::vector<std::string>::iterator iter = memBlocks.begin(); iter != memBlocks.end(); iter++)
-    procMem += kbToInt(*iter);
-
-
-  if (totalMem == 0 || procMem == 0)
+  ProcessSampler sampler(pid);
+  ProcessSample sample;
+  if (!sampler.sample(sample))
     return 0.0;
-
-  return (double)procMem / (double)totalMem;
+  return sample.memPercent / 100.0;
 }
 
 Process::Process(const std::string& processName, const std::string& startupCommand,
@@ -167,9 +102,12 @@ Process::Process(const std::string& processName, const std::string& startupComma
   _shutdownCommand(shutdownCommand),
   _pidFile(pidFile),
   _pid(-1),
-  _pMonitorThread(0),
+  _watchId(0),
+  _respawnThread(0),
+  _respawnPending(false),
   _frequencyTime(1000),
   _backoffTime(_frequencyTime*10),
+  _backoffExpires(0),
   _maxIteration(5),
   _deadProcessIteration(0),
   _maxMemViolationIteration(0),
@@ -188,6 +126,7 @@ Process::Process(const std::string& processName, const std::string& startupComma
 Process::~Process()
 {
   unmonitor();
+  joinRespawn();
 }
 
 pid_t Process::pollPid(const std::string& process, const std::string& pidFile, int maxIteration, long interval)
@@ -205,18 +144,8 @@ pid_t Process::pollPid(const std::string& process, const std::string& pidFile, i
       if (std::getline(ifstrm, buff))
       {
         pid = (pid_t)OSS::string_to_number<int>(buff.c_str());
-        std::ostringstream procd;
-        procd << "/proc/" << pid;
-        if (boost::filesystem::exists(procd.str().c_str()))
-        {
-          procd << "/status";
-          std::string procName;
-
-          if (getStatusHeader(procd.str().c_str(), "name", procName) && OSS::string_starts_with(process, procName.c_str()))
-          {
-            return pid;
-          }
-        }
+        if (pid > 0 && matchProcessName(pid, process))
+          return pid;
       }
     }
   } while (!_pidSync.wait(interval) && ++iter < maxIteration);
@@ -225,19 +154,32 @@ pid_t Process::pollPid(const std::string& process, const std::string& pidFile, i
 
 void Process::unmonitor()
 {
-  _unmonitor = true;
-  _frequencySync.set();
-  _backoffSync.set();
+  setUnmonitored(true);
   _pidSync.set();
-  if (_pMonitorThread)
+  //
+  // Wait for a respawn in progress.  It may have started a new watch and
+  // cleared the flag.
+  //
+  OSS::mutex_critic_sec_lock respawnLock(_respawnMutex);
+  setUnmonitored(true);
+  if (stopMonitor())
   {
-    if (_pMonitorThread->joinable())
-      _pMonitorThread->join();
-    delete _pMonitorThread;
-    _pMonitorThread = 0;
+    OSS_LOG_INFO("Stopped monitoring " << _processName);
   }
 }
 
+bool Process::isUnmonitored()
+{
+  OSS::mutex_critic_sec_lock lock(_monitorMutex);
+  return _unmonitor;
+}
+
+void Process::setUnmonitored(bool unmonitor)
+{
+  OSS::mutex_critic_sec_lock lock(_monitorMutex);
+  _unmonitor = unmonitor;
+}
+
 bool Process::execute()
 {
 
@@ -369,190 +311,218 @@ Process::Action Process::onCpuViolation(int consecutiveHits, double cpu)
 
 bool Process::exists(double& currentMem, double& currentCpu)
 {
-  std::ostringstream procd;
-  procd << "/proc/" << _pid;
-  bool ok = false;
-  if (boost::filesystem::exists(procd.str().c_str()))
-  {
-    procd << "/status";
-    std::string procName;
-    if (!_processName.empty())
-      ok = (getStatusHeader(procd.str().c_str(), "name", procName) && OSS::string_starts_with(_processName, procName.c_str()));
-    else
-      ok = true;
-  }
-
-#if 0
-  if (ok)
-    currentMem = getMem(_pid);
-#endif
-  
-  return ok;
+  ProcessSampler sampler(_pid);
+  ProcessSample sample;
+  if (!sampler.sample(sample))
+    return false;
+  if (!_processName.empty() && !OSS::string_starts_with(_processName, sample.name.c_str()))
+    return false;
+  currentMem = sample.memPercent;
+  currentCpu = sample.cpuPercent;
+  return true;
 }
 
-void Process::internalExecuteAndMonitor(int initialWait)
+void Process::startMonitor(unsigned int initialWait)
 {
+  stopMonitor();
   OSS_LOG_INFO("Started monitoring " << _processName);
+  setUnmonitored(false);
   _monitored = true;
   _deadProcessIteration = 0;
   _maxMemViolationIteration = 0;
   _maxCpuViolationIteration = 0;
-  double currentMem = 0.0;
-  double currentCpu = 0.0;
+  _backoffExpires = 0;
+  ProcessSupervisor::WatchId watchId = ProcessSupervisor::instance().watch(_pid, _frequencyTime,
+    initialWait + _frequencyTime, boost::bind(&Process::onSample, this, _1));
+  OSS::mutex_critic_sec_lock lock(_monitorMutex);
+  _watchId = watchId;
+}
 
-  if (initialWait > 0)
+bool Process::stopMonitor()
+{
+  ProcessSupervisor::WatchId watchId = 0;
   {
-    if (_frequencySync.wait(initialWait))
-    {
-      //
-      // It was signalled before we even started
-      //
-      return;
-    }
+    OSS::mutex_critic_sec_lock lock(_monitorMutex);
+    watchId = _watchId;
+    _watchId = 0;
   }
+  //
+  // unwatch waits for a sample handler running on the supervisor thread
+  // and the handler takes _monitorMutex
+  //
+  if (!watchId)
+    return false;
+  ProcessSupervisor::instance().unwatch(watchId);
+  return true;
+}
 
-  while (!_unmonitor && !_frequencySync.wait(_frequencyTime))
+void Process::postRespawn(bool alive)
+{
+  boost::thread* previous = 0;
   {
-    bool alive = exists(currentMem, currentCpu);
-
-    Action action = ProcessNormal;
-    if (!alive)
-    {
-      _isAlive = false;
-      ++_deadProcessIteration;
-      OSS_LOG_WARNING("Process monitor detected dead process "  << _processName << " PID=" << _pid);
-      action = onDeadProcess(_deadProcessIteration);
+    OSS::mutex_critic_sec_lock lock(_monitorMutex);
+    if (_unmonitor || _respawnPending)
+      return;
+    _respawnPending = true;
+    //
+    // The previous respawn is no longer pending so it has already left
+    // respawn() and the join below returns right away
+    //
+    previous = _respawnThread;
+    _respawnThread = new boost::thread(boost::bind(&Process::respawn, this, alive));
+  }
+  if (previous)
+  {
+    previous->join();
+    delete previous;
+  }
+}
 
-      if (!_pidFile.empty())
-        boost::filesystem::remove(_pidFile);
-    }
-    else /// Its alive
+void Process::respawn(bool alive)
+{
+  {
+    OSS::mutex_critic_sec_lock respawnLock(_respawnMutex);
+    if (!isUnmonitored())
     {
-      _isAlive = true;
-      _deadProcessIteration = 0;
       //
-      // We found the process, now check its memory consumption
+      // The old watch is bound to the old PID and was dropped by the
+      // handler.  Both paths below start a new watch.
       //
-      if (_maxMemUsage > 0.0 && currentMem > _maxMemUsage)
+      if (!alive)
       {
-        action = onMemoryViolation(++_maxMemViolationIteration, currentMem);
+        _pid = -1;
+        execute();
+        startMonitor(0);
       }
       else
       {
-        _maxMemViolationIteration = 0;
-      }
-      //
-      // We found the process, now check its memory consumption
-      //
-      if (_maxCpuUsage > 0.0 && currentCpu > _maxCpuUsage)
-      {
-        action = onCpuViolation(++_maxCpuViolationIteration, currentCpu);
+        restart();
       }
-      else
+      if (_pid != -1)
       {
-        _maxCpuViolationIteration = 0;
+        OSS_LOG_INFO("Process monitor monitoring process " << _processName << " PID=" << _pid);
       }
     }
+  }
+  OSS::mutex_critic_sec_lock lock(_monitorMutex);
+  _respawnPending = false;
+}
+
+void Process::joinRespawn()
+{
+  boost::thread* thread = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_monitorMutex);
+    thread = _respawnThread;
+    _respawnThread = 0;
+  }
+  if (thread)
+  {
+    thread->join();
+    delete thread;
+  }
+}
+
+bool Process::onSample(const ProcessSample& sample)
+{
+  if (isUnmonitored())
+    return false;
+
+  bool alive = sample.alive && (_processName.empty() || OSS::string_starts_with(_processName, sample.name.c_str()));
+
+  if (_backoffExpires)
+  {
+    if (OSS::getTime() < _backoffExpires)
+      return true;
+    _backoffExpires = 0;
+    postRespawn(alive);
+    return false;
+  }
+
+  Action action = ProcessNormal;
+  if (!alive)
+  {
+    _isAlive = false;
+    ++_deadProcessIteration;
+    OSS_LOG_WARNING("Process monitor detected dead process "  << _processName << " PID=" << _pid);
+    action = onDeadProcess(_deadProcessIteration);
 
-    if (action == ProcessNormal)
+    if (!_pidFile.empty())
+      boost::filesystem::remove(_pidFile);
+  }
+  else /// Its alive
+  {
+    _isAlive = true;
+    _deadProcessIteration = 0;
+    //
+    // We found the process, now check its memory consumption
+    //
+    if (_maxMemUsage > 0.0 && sample.memPercent > _maxMemUsage)
     {
-      //
-      // Everything is fine
-      //
-      continue;
+      action = onMemoryViolation(++_maxMemViolationIteration, sample.memPercent);
     }
-    else if (action == ProcessRestart)
+    else
     {
-      OSS_LOG_INFO("Process monitor is restarting process "  << _processName << " PID=" << _pid);
-      if (!alive)
-      {
-        _pid = -1;
-        if (!execute())
-          continue;
-      }
-      else
-      {
-        if (!restart())
-          continue;
-      }
-      OSS_LOG_INFO("Process monitor monitoring process " << _processName << " PID=" << _pid);
+      _maxMemViolationIteration = 0;
     }
-    else if (action == ProcessBackoff)
+    //
+    // Check the CPU used since the previous sample
+    //
+    if (_maxCpuUsage > 0.0 && sample.cpuPercent > _maxCpuUsage)
     {
-      if (!_backoffSync.wait(_backoffTime))
-      {
-        if (!alive)
-        {
-          _pid = -1;
-          if (!execute())
-            continue;
-        }
-        else
-        {
-          if (!restart())
-            continue;
-        }
-        OSS_LOG_INFO("Process monitor monitoring process " << _processName << " PID=" << _pid);
-      }
+      action = onCpuViolation(++_maxCpuViolationIteration, sample.cpuPercent);
     }
     else
     {
-      //
-      // This will exit the thread but not delete it
-      //
-      _unmonitor = true;
-      _pid = -1;
-      break;
+      _maxCpuViolationIteration = 0;
     }
   }
 
+  if (action == ProcessNormal)
+  {
+    //
+    // Everything is fine
+    //
+    return true;
+  }
+  else if (action == ProcessRestart)
+  {
+    OSS_LOG_INFO("Process monitor is restarting process "  << _processName << " PID=" << _pid);
+    postRespawn(alive);
+    return false;
+  }
+  else if (action == ProcessBackoff)
+  {
+    _backoffExpires = OSS::getTime() + _backoffTime;
+    return true;
+  }
+
+  //
+  // ProcessShutdown and ProcessUnmonitor drop the watch
+  //
+  {
+    OSS::mutex_critic_sec_lock lock(_monitorMutex);
+    _unmonitor = true;
+    _watchId = 0;
+  }
+  _pid = -1;
   OSS_LOG_INFO("Stopped monitoring " << _processName);
+  return false;
 }
 
 int Process::countProcessInstances(const std::string& process)
 {
-  int instances = 0;
-  if ( !boost::filesystem::exists("/proc"))
-    return 0;
-
-  boost::filesystem::directory_iterator end_itr; // default construction yields past-the-end
-  for (boost::filesystem::directory_iterator iter("/proc"); iter != end_itr; ++iter)
-  {
-    if (boost::filesystem::is_directory(iter->status()))
-    {
-      if (OSS::boost_file_name(iter->path()) != "self" && OSS::boost_file_name(iter->path()) != "thread-self")
-      {
-        boost::filesystem::path statusFile = operator/(iter->path(), "status");
-        std::string procName;
-        if (getStatusHeader(OSS::boost_path(statusFile), "name", procName) && OSS::string_starts_with(process, procName.c_str()))
-        {
-          ++instances;
-        }
-      }
-    }
-  }
-  return instances;
+  std::vector<pid_t> pids;
+  findProcesses(process, pids, false);
+  return (int)pids.size();
 }
 
 
 pid_t Process::getProcessId(const std::string& process)
 {
-  if ( !boost::filesystem::exists("/proc"))
-    return -1;
-
-  boost::filesystem::directory_iterator end_itr; // default construction yields past-the-end
-  for (boost::filesystem::directory_iterator iter("/proc"); iter != end_itr; ++iter)
-  {
-    if (boost::filesystem::is_directory(iter->status()))
-    {
-
-      boost::filesystem::path statusFile = operator/(iter->path(), "status");
-      std::string procName;
-      if (getStatusHeader(OSS::boost_path(statusFile), "name", procName) && OSS::string_starts_with(process, procName.c_str()))
-        return OSS::string_to_number<pid_t>(OSS::boost_file_name(iter->path()).c_str());
-    }
-  }
-  return -1;
+  std::vector<pid_t> pids;
+  findProcesses(process, pids, true);
+  return pids.empty() ? -1 : pids.front();
 }
 
 void Process::killAllDefunct(const std::string& process)
@@ -564,23 +534,10 @@ void Process::killAllDefunct(const std::string& process)
 
 void Process::killAll(const std::string& process, int signal)
 {
-  if ( !boost::filesystem::exists("/proc"))
-    return;
-
-  boost::filesystem::directory_iterator end_itr; // default construction yields past-the-end
-  for (boost::filesystem::directory_iterator iter("/proc"); iter != end_itr; ++iter)
-  {
-    if (boost::filesystem::is_directory(iter->status()))
-    {
-      if (OSS::boost_file_name(iter->path()) != "self")
-      {
-        boost::filesystem::path statusFile = operator/(iter->path(), "status");
-        std::string procName;
-        if (getStatusHeader(OSS::boost_path(statusFile), "name", procName) && OSS::string_starts_with(process, procName.c_str()))
-          ::kill(OSS::string_to_number<pid_t>(OSS::boost_file_name(iter->path()).c_str()), signal);
-      }
-    }
-  }
+  std::vector<pid_t> pids;
+  findProcesses(process, pids, false);
+  for (std::vector<pid_t>::iterator iter = pids.begin(); iter != pids.end(); iter++)
+    ::kill(*iter, signal);
 }
 
 
@@ -594,11 +551,11 @@ bool Process::executeAndMonitor()
 
 
 
-  _unmonitor = false;
+  setUnmonitored(false);
   _maxCpuUsage = 0.0;
   _maxMemUsage = 0.0;
 
-  _pMonitorThread = new boost::thread(boost::bind(&Process::internalExecuteAndMonitor, this, _initWait ? _initWait : PROC_INIT_WAIT));
+  startMonitor(_initWait ? _initWait : PROC_INIT_WAIT);
 
   return true;
 }
@@ -610,11 +567,11 @@ bool Process::executeAndMonitorMem(double maxMemPercent)
   if (!execute())
     return false;
 
-  _unmonitor = false;
+  setUnmonitored(false);
   _maxCpuUsage = 0.0;
   _maxMemUsage = maxMemPercent;
 
-  _pMonitorThread = new boost::thread(boost::bind(&Process::internalExecuteAndMonitor, this, _initWait ? _initWait : PROC_INIT_WAIT));
+  startMonitor(_initWait ? _initWait : PROC_INIT_WAIT);
 
   return true;
 }
@@ -626,11 +583,11 @@ bool Process::executeAndMonitorCpu(double maxCpuPercent)
   if (!execute())
     return false;
 
-  _unmonitor = false;
+  setUnmonitored(false);
   _maxCpuUsage = maxCpuPercent;
   _maxMemUsage = 0.0;
 
-  _pMonitorThread = new boost::thread(boost::bind(&Process::internalExecuteAndMonitor, this, _initWait ? _initWait : PROC_INIT_WAIT));
+  startMonitor(_initWait ? _initWait : PROC_INIT_WAIT);
 
   return true;
 }
@@ -642,24 +599,21 @@ bool Process::executeAndMonitorMemCpu(double maxMemPercent, double maxCpuPercent
   if (!execute())
     return false;
 
-  _unmonitor = false;
+  setUnmonitored(false);
   _maxCpuUsage = maxCpuPercent;
-  _maxMemUsage = maxCpuPercent;
+  _maxMemUsage = maxMemPercent;
 
-  _pMonitorThread = new boost::thread(boost::bind(&Process::internalExecuteAndMonitor, this, _initWait ? _initWait : PROC_INIT_WAIT));
+  startMonitor(_initWait ? _initWait : PROC_INIT_WAIT);
 
   return true;
 }
 
 bool Process::shutDown(int signal)
 {
-  _unmonitor = true;
-  if (_pMonitorThread && _pMonitorThread->joinable())
+  setUnmonitored(true);
+  if (stopMonitor())
   {
-    OSS_LOG_INFO("Process::shutDown " << _processName << " waiting for monitor thread to exit");
-    _pMonitorThread->join();
-    delete _pMonitorThread;
-    _pMonitorThread = 0;
+    OSS_LOG_INFO("Process::shutDown " << _processName << " stopped the monitor");
   }
 
 
@@ -726,31 +680,17 @@ bool Process::shutDown(int signal)
 
 bool Process::restart()
 {
-  if (!shutDown())
-    return false;
-  if (_monitored)
-  {
-    _unmonitor = true;
-    if (_pMonitorThread && _pMonitorThread->joinable())
-    {
-      _pMonitorThread->join();
-      delete _pMonitorThread;
-      _pMonitorThread = 0;
-    }
-
-    _unmonitor = false;
-    internalExecuteAndMonitor(0);
-    return true;
-  }
-  else
+  bool monitored = false;
   {
-    return execute();
+    OSS::mutex_critic_sec_lock lock(_monitorMutex);
+    monitored = _watchId != 0;
   }
+  if (!shutDown())
+    return false;
+  bool ok = execute();
+  if (monitored)
+    startMonitor(0);
+  return ok;
 }
 
 } }  // OSS::Exec
-
-
-
-
-
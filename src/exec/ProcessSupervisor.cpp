@@ -0,0 +1,516 @@
+// OSS Software Solutions Application Programmer Interface
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: EXEC
+//
+// Copyright (c) 2011, OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version..
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+
+
+#include "OSS/Exec/ProcessSupervisor.h"
+#include "OSS/UTL/Logger.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#if OSS_OS == OSS_OS_LINUX
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+
+#define SUPERVISOR_MAX_WAIT 1000
+#define SUPERVISOR_MAX_EVENTS 32
+
+
+namespace OSS {
+namespace Exec {
+
+
+static OSS::UInt64 monotonic_ms()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (OSS::UInt64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int open_proc_file(pid_t pid, const char* file)
+{
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, file);
+  return ::open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static int reap_child(pid_t pid)
+{
+  //
+  // Only succeeds for our own children.  Anything else returns ECHILD.
+  //
+  siginfo_t info;
+  memset(&info, 0, sizeof(info));
+  if (waitid(P_PID, pid, &info, WEXITED | WNOHANG) == 0 && info.si_pid == pid)
+    return info.si_status;
+  return -1;
+}
+
+//
+// ProcessSampler
+//
+
+ProcessSampler::ProcessSampler(pid_t pid) :
+  _pid(pid),
+  _pidfd(-1),
+  _statFd(-1),
+  _statmFd(-1),
+  _lastTicks(0),
+  _lastSampleTime(0),
+  _hasBaseline(false)
+{
+  if (pid <= 0)
+    return;
+
+#if OSS_OS == OSS_OS_LINUX && defined(SYS_pidfd_open)
+  _pidfd = (int)::syscall(SYS_pidfd_open, pid, 0);
+#endif
+  _statFd = open_proc_file(pid, "stat");
+  _statmFd = open_proc_file(pid, "statm");
+}
+
+ProcessSampler::~ProcessSampler()
+{
+  if (_pidfd != -1)
+    ::close(_pidfd);
+  if (_statFd != -1)
+    ::close(_statFd);
+  if (_statmFd != -1)
+    ::close(_statmFd);
+}
+
+bool ProcessSampler::readStat(int fd, std::string& name, char& state, OSS::UInt64& cpuTicks)
+{
+  char buf[1024];
+  ssize_t len = ::pread(fd, buf, sizeof(buf) - 1, 0);
+  if (len <= 0)
+    return false;
+  buf[len] = '\0';
+
+  //
+  // The name is enclosed in parenthesis and may itself contain spaces and
+  // parenthesis so the last closing one marks its end
+  //
+  char* lparen = strchr(buf, '(');
+  char* rparen = strrchr(buf, ')');
+  if (!lparen || !rparen || rparen < lparen || rparen[1] != ' ')
+    return false;
+  name.assign(lparen + 1, rparen - lparen - 1);
+
+  const char* cursor = rparen + 2;
+  state = *cursor;
+
+  //
+  // state is field 3, utime and stime are fields 14 and 15
+  //
+  OSS::UInt64 utime = 0;
+  OSS::UInt64 stime = 0;
+  int field = 3;
+  while (field < 15)
+  {
+    cursor = strchr(cursor, ' ');
+    if (!cursor)
+      return false;
+    ++cursor;
+    ++field;
+    if (field == 14)
+      utime = strtoull(cursor, 0, 10);
+    else if (field == 15)
+      stime = strtoull(cursor, 0, 10);
+  }
+  cpuTicks = utime + stime;
+  return true;
+}
+
+bool ProcessSampler::readName(pid_t pid, std::string& name)
+{
+  int fd = open_proc_file(pid, "stat");
+  if (fd == -1)
+    return false;
+  char state;
+  OSS::UInt64 cpuTicks;
+  bool ok = readStat(fd, name, state, cpuTicks);
+  ::close(fd);
+  return ok;
+}
+
+bool ProcessSampler::sample(ProcessSample& result)
+{
+  static const long pageSize = sysconf(_SC_PAGESIZE);
+  static const long clockTicks = sysconf(_SC_CLK_TCK);
+  static const OSS::UInt64 physicalMemory = (OSS::UInt64)sysconf(_SC_PHYS_PAGES) * pageSize;
+
+  result = ProcessSample();
+  result.pid = _pid;
+
+  if (_statFd == -1)
+    return false;
+
+  char state = 0;
+  OSS::UInt64 cpuTicks = 0;
+  if (!readStat(_statFd, result.name, state, cpuTicks))
+  {
+    //
+    // The stat file of an exited task returns ESRCH even if the pid
+    // has been recycled
+    //
+    result.exitStatus = reap_child(_pid);
+    return false;
+  }
+
+  if (state == 'Z' || state == 'X' || state == 'x')
+  {
+    result.exitStatus = reap_child(_pid);
+    return false;
+  }
+
+  char buf[128];
+  ssize_t len = _statmFd != -1 ? ::pread(_statmFd, buf, sizeof(buf) - 1, 0) : -1;
+  if (len > 0)
+  {
+    buf[len] = '\0';
+    char* cursor = 0;
+    strtoull(buf, &cursor, 10);
+    OSS::UInt64 residentPages = strtoull(cursor, 0, 10);
+    result.residentBytes = residentPages * pageSize;
+    if (physicalMemory)
+      result.memPercent = ((double)result.residentBytes * 100.0) / (double)physicalMemory;
+  }
+
+  OSS::UInt64 now = monotonic_ms();
+  if (_hasBaseline && now > _lastSampleTime && cpuTicks >= _lastTicks && clockTicks > 0)
+  {
+    double cpuSeconds = (double)(cpuTicks - _lastTicks) / (double)clockTicks;
+    double wallSeconds = (double)(now - _lastSampleTime) / 1000.0;
+    result.cpuPercent = (cpuSeconds * 100.0) / wallSeconds;
+  }
+  _lastTicks = cpuTicks;
+  _lastSampleTime = now;
+  _hasBaseline = true;
+
+  result.alive = true;
+  return true;
+}
+
+//
+// ProcessSupervisor
+//
+
+ProcessSupervisor::ProcessSupervisor() :
+  _nextId(0),
+  _dispatching(0),
+  _epollFd(-1),
+  _wakeupFd(-1),
+  _pThread(0),
+  _isTerminating(false)
+{
+#if OSS_OS == OSS_OS_LINUX
+  _epollFd = epoll_create1(EPOLL_CLOEXEC);
+  _wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (_epollFd != -1 && _wakeupFd != -1)
+  {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeupFd, &event);
+  }
+#endif
+}
+
+ProcessSupervisor::~ProcessSupervisor()
+{
+  stop();
+  for (Watches::iterator iter = _watches.begin(); iter != _watches.end(); iter++)
+    delete iter->second.sampler;
+  _watches.clear();
+  if (_wakeupFd != -1)
+    ::close(_wakeupFd);
+  if (_epollFd != -1)
+    ::close(_epollFd);
+}
+
+ProcessSupervisor& ProcessSupervisor::instance()
+{
+  static ProcessSupervisor* pInstance = new ProcessSupervisor();
+  return *pInstance;
+}
+
+ProcessSupervisor::WatchId ProcessSupervisor::watch(pid_t pid, unsigned int intervalMs, unsigned int initialDelayMs, const SampleHandler& handler)
+{
+  ProcessSampler* sampler = new ProcessSampler(pid);
+  WatchId id = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    id = ++_nextId;
+    Watch& watch = _watches[id];
+    watch.id = id;
+    watch.sampler = sampler;
+    watch.handler = handler;
+    watch.interval = intervalMs;
+    watch.nextSample = monotonic_ms() + initialDelayMs;
+#if OSS_OS == OSS_OS_LINUX
+    if (_epollFd != -1 && sampler->pidfd() != -1)
+    {
+      struct epoll_event event;
+      memset(&event, 0, sizeof(event));
+      event.events = EPOLLIN;
+      event.data.u64 = id;
+      epoll_ctl(_epollFd, EPOLL_CTL_ADD, sampler->pidfd(), &event);
+    }
+#endif
+  }
+  start();
+  wakeup();
+  return id;
+}
+
+void ProcessSupervisor::unwatch(WatchId id)
+{
+  boost::unique_lock<OSS::mutex_critic_sec> lock(_mutex);
+  if (!isSupervisorThread())
+  {
+    while (_dispatching == id)
+      _dispatchDone.wait(lock);
+  }
+  Watches::iterator iter = _watches.find(id);
+  if (iter != _watches.end())
+    removeWatch(iter);
+}
+
+bool ProcessSupervisor::isWatched(WatchId id) const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _watches.find(id) != _watches.end();
+}
+
+std::size_t ProcessSupervisor::size() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _watches.size();
+}
+
+void ProcessSupervisor::removeWatch(Watches::iterator iter)
+{
+#if OSS_OS == OSS_OS_LINUX
+  if (_epollFd != -1 && iter->second.sampler->pidfd() != -1)
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, iter->second.sampler->pidfd(), 0);
+#endif
+  delete iter->second.sampler;
+  _watches.erase(iter);
+}
+
+bool ProcessSupervisor::isSupervisorThread() const
+{
+  return _threadId == boost::this_thread::get_id();
+}
+
+void ProcessSupervisor::start()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pThread)
+    return;
+  _isTerminating = false;
+  _pThread = new boost::thread(boost::bind(&ProcessSupervisor::run, this));
+}
+
+void ProcessSupervisor::stop()
+{
+  boost::thread* pThread = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    if (isSupervisorThread())
+      return;
+    _isTerminating = true;
+    pThread = _pThread;
+    _pThread = 0;
+  }
+  wakeup();
+  if (pThread)
+  {
+    if (pThread->joinable())
+      pThread->join();
+    delete pThread;
+  }
+}
+
+void ProcessSupervisor::wakeup()
+{
+#if OSS_OS == OSS_OS_LINUX
+  if (_wakeupFd != -1)
+  {
+    OSS::UInt64 value = 1;
+    ssize_t ret = ::write(_wakeupFd, &value, sizeof(value));
+    (void)ret;
+  }
+#endif
+}
+
+bool ProcessSupervisor::dispatch(WatchId id, bool exited)
+{
+  ProcessSample sample;
+  SampleHandler handler;
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    Watches::iterator iter = _watches.find(id);
+    if (iter == _watches.end())
+      return false;
+    Watch& watch = iter->second;
+#if OSS_OS == OSS_OS_LINUX
+    if (exited && _epollFd != -1 && watch.sampler->pidfd() != -1)
+    {
+      //
+      // A pidfd stays readable once the process exits.  Stop polling it
+      // and let the interval samples report the death from here on.
+      //
+      epoll_ctl(_epollFd, EPOLL_CTL_DEL, watch.sampler->pidfd(), 0);
+    }
+#endif
+    watch.sampler->sample(sample);
+    watch.nextSample = monotonic_ms() + watch.interval;
+    handler = watch.handler;
+    _dispatching = id;
+  }
+
+  bool keep = true;
+  try
+  {
+    keep = handler(sample);
+  }
+  catch(std::exception& e)
+  {
+    OSS_LOG_ERROR("ProcessSupervisor::dispatch - handler for PID=" << sample.pid << " threw " << e.what());
+  }
+
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _dispatching = 0;
+    if (!keep)
+    {
+      Watches::iterator iter = _watches.find(id);
+      if (iter != _watches.end())
+        removeWatch(iter);
+    }
+  }
+  _dispatchDone.notify_all();
+  return keep;
+}
+
+void ProcessSupervisor::run()
+{
+  {
+    OSS::mutex_critic_sec_lock lock(_mutex);
+    _threadId = boost::this_thread::get_id();
+  }
+
+  std::vector<WatchId> ready;
+  while (true)
+  {
+    int timeout = SUPERVISOR_MAX_WAIT;
+    {
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      if (_isTerminating)
+        break;
+      OSS::UInt64 now = monotonic_ms();
+      for (Watches::iterator iter = _watches.begin(); iter != _watches.end(); iter++)
+      {
+        if (iter->second.nextSample <= now)
+        {
+          timeout = 0;
+          break;
+        }
+        else if (iter->second.nextSample - now < (OSS::UInt64)timeout)
+        {
+          timeout = (int)(iter->second.nextSample - now);
+        }
+      }
+    }
+
+    ready.clear();
+#if OSS_OS == OSS_OS_LINUX
+    if (_epollFd != -1)
+    {
+      struct epoll_event events[SUPERVISOR_MAX_EVENTS];
+      int count = epoll_wait(_epollFd, events, SUPERVISOR_MAX_EVENTS, timeout);
+      for (int i = 0; i < count; i++)
+      {
+        if (events[i].data.u64 == 0)
+        {
+          OSS::UInt64 value;
+          ssize_t ret = ::read(_wakeupFd, &value, sizeof(value));
+          (void)ret;
+        }
+        else
+        {
+          ready.push_back((WatchId)events[i].data.u64);
+        }
+      }
+    }
+    else
+#endif
+    if (timeout > 0)
+    {
+      boost::this_thread::sleep(boost::posix_time::milliseconds(timeout));
+    }
+
+    //
+    // Processes that just exited are reported ahead of the periodic samples
+    //
+    for (std::vector<WatchId>::iterator iter = ready.begin(); iter != ready.end(); iter++)
+      dispatch(*iter, true);
+
+    ready.clear();
+    {
+      OSS::mutex_critic_sec_lock lock(_mutex);
+      if (_isTerminating)
+        break;
+      OSS::UInt64 now = monotonic_ms();
+      for (Watches::iterator iter = _watches.begin(); iter != _watches.end(); iter++)
+      {
+        if (iter->second.nextSample <= now)
+          ready.push_back(iter->first);
+      }
+    }
+
+    for (std::vector<WatchId>::iterator iter = ready.begin(); iter != ready.end(); iter++)
+      dispatch(*iter, false);
+  }
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _threadId = boost::thread::id();
+}
+
+
+} }  // OSS::Exec
@@ -23,6 +23,7 @@
 #include "OSS/UTL/Application.h"
 #include "OSS/UTL/Logger.h"
 #include "OSS/UTL/Thread.h"
+#include "OSS/UTL/Metrics.h"
 
 
 #define ENABLE_GLOBAL_SCRIPTS_DIR 0
@@ -33,6 +34,9 @@ namespace JS {
 
 
 static std::vector<std::string> _globalScripts; 
+
+static OSS::LatencyHistogram& gScriptLatency = OSS::Metrics::instance().histogram(
+  "js_script_microseconds", "Time spent running request scripts including the wait for the engine lock");
   
 static std::string toString(v8::Handle<v8::Value> str)
 {
@@ -725,6 +729,7 @@ bool JSBase::internalRecompile()
 
 bool JSBase::processRequest(OSS_HANDLE request)
 {
+  OSS::Metrics::Timer timer(gScriptLatency);
   return internalProcessRequest(request);
 }
 
@@ -37,7 +37,8 @@ LMDatabase::Transaction::Transaction(LMDatabase* db) :
   _db(db),
   _transaction(0),
   _cancelAdvised(false),
-  _lastError(0)
+  _lastError(0),
+  _readOnly(false)
 {
   assert(_db && _db->_env);
 }
@@ -55,12 +56,41 @@ bool LMDatabase::Transaction::begin()
     return false;
   }
   assert(!_transaction);
+  _readOnly = false;
   return mdb_txn_begin((MDB_env*)_db->_env, 0, 0, (MDB_txn**)&_transaction) == 0;
 }
 
+bool LMDatabase::Transaction::beginRead()
+{
+  _db->_readMutex.lock_shared();
+  if (_db->_stopped)
+  {
+    _db->_readMutex.unlock_shared();
+    return false;
+  }
+  assert(!_transaction);
+  _readOnly = true;
+  if (mdb_txn_begin((MDB_env*)_db->_env, 0, MDB_RDONLY, (MDB_txn**)&_transaction) != 0)
+  {
+    _transaction = 0;
+    _db->_readMutex.unlock_shared();
+    return false;
+  }
+  return true;
+}
+
 bool LMDatabase::Transaction::end()
 {
   assert(_transaction);
+  if (_readOnly)
+  {
+    mdb_txn_abort((MDB_txn*)_transaction);
+    _transaction = 0;
+    _cancelAdvised = false;
+    _db->_readMutex.unlock_shared();
+    return true;
+  }
+  
   int ret = 0;
   ret = mdb_txn_commit((MDB_txn*)_transaction);
   _transaction = 0;
@@ -78,7 +108,10 @@ void LMDatabase::Transaction::cancel()
   mdb_txn_abort((MDB_txn*)_transaction);
   _transaction = 0;
   _cancelAdvised = false;
-  _db->_mutex.unlock();
+  if (_readOnly)
+    _db->_readMutex.unlock_shared();
+  else
+    _db->_mutex.unlock();
 }
 
 LMDatabase::TransactionLock::TransactionLock(Transaction& transaction) :
@@ -180,6 +213,34 @@ bool LMDatabase::Cursor::find(const std::string& key)
   return false;
 }
 
+bool LMDatabase::Cursor::seek(const std::string& key)
+{
+  if (!_cursor)
+  {
+    return false;
+  }
+  
+  MDB_val k, v;
+  k.mv_data = (void*)key.data();
+  k.mv_size = key.size();
+  
+  if (!key.empty() && mdb_cursor_get((MDB_cursor*)_cursor, &k, &v, MDB_SET_RANGE) == 0 && 
+    k.mv_data && k.mv_size && v.mv_data && v.mv_size)
+  {
+    _key = std::string((char*)k.mv_data, k.mv_size);
+    _value = std::string((char*)v.mv_data, v.mv_size);
+    return true;
+  }
+  else if (key.empty())
+  {
+    return top();
+  }
+  
+  _key = std::string();
+  _value = std::string();
+  return false;
+}
+
 bool LMDatabase::Cursor::next()
 {
   if (!_cursor)
@@ -238,6 +299,10 @@ LMDatabase::~LMDatabase()
 void LMDatabase::close()
 {
   _mutex.lock();
+  //
+  // Wait for read-only transactions to drain
+  //
+  OSS::mutex_write_lock readLock(_readMutex);
   if (!_stopped)
   {
     _stopped = true;
@@ -106,7 +106,7 @@ void AccessControl::logPacket(const boost::asio::ip::address& source, std::size_
               OSS_LOG_WARNING("ALERT: Threshold Violator Address = " << suspect.to_string() <<
                 " Packets sent within the last second is " << watermark
                 << ". Violator is now in jail for a maximum of " << _banLifeTime << " seconds.");
-              banAddress(suspect);
+              jailAddress(suspect);
               
               if (pReport)
                 pReport->violators.push_back(suspect.to_string());
@@ -164,7 +164,7 @@ bool AccessControl::isBannedAddress(const boost::asio::ip::address& source)
       {
         delNullRoute(*iter);
       }
-      _banned.erase(*iter);
+      releaseAddress(*iter);
     }
   }
 
@@ -212,21 +212,94 @@ void AccessControl::banAddress(const boost::asio::ip::address& source)
     return;
   
   _packetCounterMutex.lock();
+  jailAddress(source);
+  _packetCounterMutex.unlock();
+}
+
+void AccessControl::jailAddress(const boost::asio::ip::address& source)
+{
   _banned[source] = boost::posix_time::ptime(boost::posix_time::microsec_clock::local_time());
+  if (_banSet)
+  {
+    _banSet->add(source);
+  }
   if (_banCallback)
   {
     _banCallback(source);
   }
+}
+
+void AccessControl::releaseAddress(const boost::asio::ip::address& source)
+{
+  if (_banned.erase(source) && _banSet)
+  {
+    _banSet->remove(source);
+  }
+}
+
+void AccessControl::setBanSet(const BanSetPtr& banSet)
+{
+  if (!banSet)
+  {
+    _packetCounterMutex.lock();
+    _banSet = banSet;
+    _packetCounterMutex.unlock();
+    return;
+  }
+
+  //
+  // Loading the set talks to the kernel so it is done outside the lock
+  // with a snapshot of the bans
+  //
+  std::vector<boost::asio::ip::address> banned;
+  _packetCounterMutex.lock();
+  getBannedAddresses(banned);
+  _packetCounterMutex.unlock();
+
+  if (!banSet->sync(banned))
+  {
+    OSS_LOG_ERROR("AccessControl::setBanSet - Unable to load " << banned.size() << " banned sources into " << banSet->getSetName());
+  }
+
+  //
+  // Queue whatever changed while the set was loading
+  //
+  std::set<boost::asio::ip::address> loaded(banned.begin(), banned.end());
+  _packetCounterMutex.lock();
+  _banSet = banSet;
+  for (BannedSources::iterator iter = _banned.begin(); iter != _banned.end(); iter++)
+  {
+    if (!loaded.erase(iter->first))
+      _banSet->add(iter->first);
+  }
+  for (std::set<boost::asio::ip::address>::iterator iter = loaded.begin(); iter != loaded.end(); iter++)
+  {
+    _banSet->remove(*iter);
+  }
   _packetCounterMutex.unlock();
 }
 
+bool AccessControl::flushBanSet()
+{
+  BanSetPtr banSet;
+  _packetCounterMutex.lock();
+  banSet = _banSet;
+  _packetCounterMutex.unlock();
+  
+  if (!banSet || banSet->flush())
+    return true;
+  
+  OSS_LOG_ERROR("AccessControl::flushBanSet - Unable to update " << banSet->getSetName());
+  return false;
+}
+
 void AccessControl::clearAddress(const boost::asio::ip::address& source, bool addToWhiteList)
 {
   if (!_enabled)
     return;
   _packetCounterMutex.lock();
   
-  _banned.erase(source);
+  releaseAddress(source);
   _blackList.erase(source);
 
   if (addToWhiteList)
@@ -247,7 +320,7 @@ void AccessControl::whiteListAddress(const boost::asio::ip::address& address, bo
   OSS_LOG_NOTICE("AccessControl::whiteListAddress - " << address);
   
   if (removeFromBlackList)
-    _banned.erase(address);
+    releaseAddress(address);
 
   _whiteList.insert(address);
 
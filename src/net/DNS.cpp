@@ -22,7 +22,7 @@
 #include "OSS/Net/DNS.h"
 #include "OSS/Net/Net.h"
 #include "OSS/UTL/CoreUtils.h"
-#include "Poco/ExpireCache.h"
+#include "OSS/UTL/ExpireCache.h"
 
 #define DNS_USE_UDNSPP 1
 
@@ -61,10 +61,10 @@ namespace Private {
 #define DNS_QUERY_STANDARD 0
 #define DNS_QUERY_BYPASS_CACHE 0
 
-typedef Poco::ExpireCache<std::string, dns_srv_record_list> DnsSrvExpireCache;
-typedef Poco::ExpireCache<std::string, dns_host_record_list> DnsHostExpireCache;
-typedef Poco::SharedPtr<dns_host_record_list> DnsHostPtr;
-typedef Poco::SharedPtr<dns_srv_record_list> DnsSrvPtr;
+typedef boost::shared_ptr<dns_host_record_list> DnsHostPtr;
+typedef boost::shared_ptr<dns_srv_record_list> DnsSrvPtr;
+typedef OSS::ExpireCache<std::string, DnsSrvPtr> DnsSrvExpireCache;
+typedef OSS::ExpireCache<std::string, DnsHostPtr> DnsHostExpireCache;
 
 typedef struct _DnsAData {
   unsigned long IpAddress;
@@ -374,8 +374,8 @@ dns_host_record_list dns_lookup_host(const std::string& host)
   //
   // Check if it is cached
   //
-  OSS::Private::DnsHostPtr cached = hostCache.get(host);
-  if (cached)
+  OSS::Private::DnsHostPtr cached;
+  if (hostCache.get(host, cached))
     return *cached;
 
 
@@ -460,8 +460,8 @@ bool dns_srv_lookup(const std::string& name, dns_srv_record_list& recordList)
   //
   // Check if we have something in cache
   //
-  OSS::Private::DnsSrvPtr cached = srvCache.get(name);
-  if (cached)
+  OSS::Private::DnsSrvPtr cached;
+  if (srvCache.get(name, cached))
   {
     recordList = *cached;
     return !recordList.empty();
@@ -61,125 +61,74 @@ bool FramedTcpClient::connect(const std::string& serviceAddress, const std::stri
 bool FramedTcpClient::sendAndReceive(const std::string& data, std::string& response)
 {
   assert(_pSocket);
-  short version = FTCP_VERSION;
-  short key = FTCP_KEY;
-  short len = (short)data.size();
-  std::stringstream strm;
-  strm.write((char*)(&version), sizeof(version));
-  strm.write((char*)(&key), sizeof(key));
-  strm.write((char*)(&len), sizeof(len));
-  strm << data;
-  std::string packet = strm.str();
-  boost::system::error_code ec;
-
-  if (packet.size() > FTCP_READ_BUFFER_SIZE)
+  if (data.size() > FTCP_MAX_FRAME_SIZE)
   {
     OSS_LOG_DEBUG( "FramedTcpClient::sendAndReceive "
-                << "Packet exceeds allowable frame size " << FTCP_READ_BUFFER_SIZE);
+                << "Packet exceeds allowable frame size " << FTCP_MAX_FRAME_SIZE);
     return false;
   }
 
+  //
+  // Header and payload go out in one gather write
+  //
+  char header[FTCP_HEADER_SIZE];
+  FramedTcpConnection::encodeHeader(header, data.size());
+  boost::array<boost::asio::const_buffer, 2> buffers =
+  {{
+    boost::asio::buffer(header, FTCP_HEADER_SIZE),
+    boost::asio::buffer(data.data(), data.size())
+  }};
 
-  bool ok = _pSocket->write_some(boost::asio::buffer(packet.c_str(), packet.size()), ec) > 0;
-  if (!ok)
+  boost::system::error_code ec;
+  boost::asio::write(*_pSocket, buffers, ec);
+  if (ec)
   {
     _isConnected = false;
     return false;
   }
 
-  len = getNextReadSize();
-  if (!len)
+  OSS::UInt32 len = 0;
+  if (!getNextReadSize(len))
     return false;
 
-  char responseBuff[len];
-  _pSocket->read_some(boost::asio::buffer((char*)responseBuff, len), ec);
-  if (ec)
+  response.resize(len);
+  if (len)
   {
-    _isConnected = false;
-    return false;
+    boost::asio::read(*_pSocket, boost::asio::buffer(&response[0], len), ec);
+    if (ec)
+    {
+      _isConnected = false;
+      return false;
+    }
   }
-
-  response = std::string(responseBuff, len);
   return true;
 }
 
-short FramedTcpClient::getNextReadSize()
+bool FramedTcpClient::getNextReadSize(OSS::UInt32& len)
 {
-  short version = FTCP_VERSION;
-  short key = FTCP_KEY;
-  bool hasVersion = false;
-  bool hasKey = false;
-  short remoteLen = 0;
-  while (!hasVersion || !hasKey)
-  {
-    short remoteVersion;
-    short remoteKey;
-
-    //
-    // Read the version (must be 1)
-    //
-    while (true)
-    {
-
-      boost::system::error_code ec;
-      _pSocket->read_some(boost::asio::buffer((char*)&remoteVersion, sizeof(remoteVersion)), ec);
-      if (ec)
-      {
-        OSS_LOG_DEBUG( "FramedTcpClient::getNextReadSize "
-                << "Unable to read version "
-                << "ERROR: " << ec.message());
-        _isConnected = false;
-        return 0;
-      }
-      else
-      {
-        if (remoteVersion == version)
-        {
-          hasVersion = true;
-          break;
-        }
-      }
-    }
-
-    //
-    // Read the key (must be 22172)
-    //
-    while (true)
-    {
-
-      boost::system::error_code ec;
-      _pSocket->read_some(boost::asio::buffer((char*)&remoteKey, sizeof(remoteKey)), ec);
-      if (ec)
-      {
-        OSS_LOG_DEBUG( "FramedTcpClient::getNextReadSize "
-                << "Unable to read secret key "
-                << "ERROR: " << ec.message());
-        _isConnected = false;
-        return 0;
-      }
-      else
-      {
-        if (remoteKey == key)
-        {
-          hasKey = true;
-          break;
-        }
-      }
-    }
-  }
-
+  char header[FTCP_HEADER_SIZE];
   boost::system::error_code ec;
-  _pSocket->read_some(boost::asio::buffer((char*)&remoteLen, sizeof(remoteLen)), ec);
+  boost::asio::read(*_pSocket, boost::asio::buffer(header, FTCP_HEADER_SIZE), ec);
   if (ec)
   {
     OSS_LOG_DEBUG( "FramedTcpClient::getNextReadSize "
-            << "Unable to read secret packet length "
+            << "Unable to read frame header "
             << "ERROR: " << ec.message());
     _isConnected = false;
-    return 0;
+    return false;
+  }
+
+  FramedTcpConnection::Header frameHeader;
+  if (!FramedTcpConnection::decodeHeader(header, frameHeader) || frameHeader.size > FTCP_MAX_FRAME_SIZE)
+  {
+    OSS_LOG_DEBUG( "FramedTcpClient::getNextReadSize "
+            << "Invalid frame header");
+    _isConnected = false;
+    return false;
   }
 
-  return remoteLen;
+  len = frameHeader.size;
+  return true;
 }
 
 bool FramedTcpClient::isConnected() const
@@ -1,3 +1,4 @@
+#include <cstring>
 #include "OSS/Net/FramedTcpConnection.h"
 #include "OSS/Net/FramedTcpListener.h"
 #include "OSS/UTL/Logger.h"
@@ -10,8 +11,11 @@ FramedTcpConnection::FramedTcpConnection( FramedTcpListener& listener) :
   _listener(listener),
   _socket(_ioService),
   _resolver(_ioService),
-  _moreReadRequired(0),
-  _lastExpectedPacketSize(0),
+  _readBuffer(FTCP_READ_BUFFER_SIZE),
+  _readStart(0),
+  _readEnd(0),
+  _isWriting(false),
+  _isOpen(true),
   _localPort(0),
   _remotePort(0),
   _pInactivityTimer(0)
@@ -28,20 +32,116 @@ FramedTcpConnection::~FramedTcpConnection()
   OSS_LOG_DEBUG( "FramedTcpConnection DESTROYED.");
 }
 
+void FramedTcpConnection::encodeHeader(char* buffer, std::size_t size)
+{
+  unsigned char* out = (unsigned char*)buffer;
+  out[0] = (FTCP_VERSION >> 8) & 0xFF;
+  out[1] = FTCP_VERSION & 0xFF;
+  out[2] = (FTCP_KEY >> 8) & 0xFF;
+  out[3] = FTCP_KEY & 0xFF;
+  out[4] = (size >> 24) & 0xFF;
+  out[5] = (size >> 16) & 0xFF;
+  out[6] = (size >> 8) & 0xFF;
+  out[7] = size & 0xFF;
+}
+
+bool FramedTcpConnection::decodeHeader(const char* buffer, Header& header)
+{
+  const unsigned char* in = (const unsigned char*)buffer;
+  header.version = (OSS::UInt16)((in[0] << 8) | in[1]);
+  header.key = (OSS::UInt16)((in[2] << 8) | in[3]);
+  header.size = ((OSS::UInt32)in[4] << 24) | ((OSS::UInt32)in[5] << 16) | ((OSS::UInt32)in[6] << 8) | (OSS::UInt32)in[7];
+  return header.version == FTCP_VERSION && header.key == FTCP_KEY;
+}
+
 bool FramedTcpConnection::write(const std::string& data)
 {
-  short version = FTCP_VERSION;
-  short key = FTCP_KEY;
-  short len = (short)data.size();
-  std::stringstream strm;
-  strm.write((char*)(&version), sizeof(version));
-  strm.write((char*)(&key), sizeof(key));
-  strm.write((char*)(&len), sizeof(len));
-  strm << data;
-  std::string packet = strm.str();
-  boost::system::error_code ec;
-  bool ok = _socket.write_some(boost::asio::buffer(packet.c_str(), packet.size()), ec) > 0;
-  return ok;
+  if (data.size() > FTCP_MAX_FRAME_SIZE)
+  {
+    OSS_LOG_WARNING( "FramedTcpConnection::write "
+                << "Frame of " << data.size() << " bytes exceeds the maximum of " << FTCP_MAX_FRAME_SIZE);
+    return false;
+  }
+
+  boost::mutex::scoped_lock lock(_writeMutex);
+  if (!_isOpen)
+    return false;
+
+  _pendingFrames.push_back(Frame());
+  Frame& frame = _pendingFrames.back();
+  encodeHeader(frame.header.data(), data.size());
+  frame.payload = data;
+
+  //
+  // A send in progress picks up the new frame when it completes
+  //
+  if (!_isWriting)
+  {
+    _isWriting = true;
+    _ioService.post(boost::bind(&FramedTcpConnection::startWrite, shared_from_this()));
+  }
+  return true;
+}
+
+void FramedTcpConnection::startWrite()
+{
+  std::vector<boost::asio::const_buffer> buffers;
+  {
+    boost::mutex::scoped_lock lock(_writeMutex);
+    _writingFrames.clear();
+    if (_pendingFrames.empty() || !_isOpen)
+    {
+      _isWriting = false;
+      return;
+    }
+
+    if (_pendingFrames.size() <= FTCP_MAX_COALESCED_FRAMES)
+    {
+      _writingFrames.swap(_pendingFrames);
+    }
+    else
+    {
+      _writingFrames.assign(_pendingFrames.begin(), _pendingFrames.begin() + FTCP_MAX_COALESCED_FRAMES);
+      _pendingFrames.erase(_pendingFrames.begin(), _pendingFrames.begin() + FTCP_MAX_COALESCED_FRAMES);
+    }
+  }
+
+  //
+  // Only this handler touches _writingFrames until the write completes
+  //
+  buffers.reserve(_writingFrames.size() * 2);
+  for (Frames::const_iterator iter = _writingFrames.begin(); iter != _writingFrames.end(); iter++)
+  {
+    buffers.push_back(boost::asio::buffer(iter->header));
+    if (!iter->payload.empty())
+      buffers.push_back(boost::asio::buffer(iter->payload.data(), iter->payload.size()));
+  }
+
+  boost::asio::async_write(_socket, buffers,
+    boost::bind(&FramedTcpConnection::handleWrite, shared_from_this(),
+      boost::asio::placeholders::error,
+      boost::asio::placeholders::bytes_transferred));
+}
+
+void FramedTcpConnection::handleWrite(const boost::system::error_code& e, std::size_t bytes_transferred)
+{
+  if (e)
+  {
+    OSS_LOG_WARNING( "FramedTcpConnection::handleWrite "
+                << "Exception caught while calling write.  "
+                << "ERROR: " << e.message());
+    //
+    // The peer never got the rest of the frames so the stream can not be
+    // resumed
+    //
+    abort();
+    return;
+  }
+
+  OSS_LOG_DEBUG( "FramedTcpConnection::handleWrite"
+            << " FRAMES: " << _writingFrames.size()
+            << " BYTES: " << bytes_transferred);
+  startWrite();
 }
 
 void FramedTcpConnection::handleRead(const boost::system::error_code& e, std::size_t bytes_transferred)
@@ -68,7 +168,7 @@ void FramedTcpConnection::handleRead(const boost::system::error_code& e, std::si
       //  Exception is non relevant if it is even thrown
       //
     }
-    
+
     //
     // Start the inactivity timer
     //
@@ -79,69 +179,13 @@ void FramedTcpConnection::handleRead(const boost::system::error_code& e, std::si
             << " SRC: " << _localAddress << ":" << _localPort
             << " DST: " << _remoteAddress << ":" << _remotePort );
 
-    if (_moreReadRequired == 0)
+    _readEnd += bytes_transferred;
+    if (!processFrames())
     {
-      std::stringstream strm;
-      if (!_spillOverBuffer.empty())
-        strm << _spillOverBuffer;
-
- 
-      strm.write(_buffer.data(), bytes_transferred);
-
-      if (!_spillOverBuffer.empty())
-      {
-        bytes_transferred += _spillOverBuffer.size();
-        OSS_LOG_DEBUG("FramedTcpConnection::handleRead "
-                << "Spillover buffer is not empty.  "
-                << "Resulting BYTES: " << bytes_transferred);
-      }
-
-      short version;
-      strm.read((char*)(&version), sizeof(version));
-      short key;
-      strm.read((char*)(&key), sizeof(key));
-      if (version == FTCP_VERSION && key == FTCP_KEY)
-      {
-        short len;
-        strm.read((char*)(&len), sizeof(len));
-        
-        _lastExpectedPacketSize = len + sizeof(version) + sizeof(key) + (sizeof(len));
-        _moreReadRequired =  bytes_transferred - _lastExpectedPacketSize;
-        
-        if (!_moreReadRequired)
-        {
-          char buf[FTCP_READ_BUFFER_SIZE];
-          strm.read(buf, len);
-          _listener.onIncomingRequest(*this, buf, len);
-          _spillOverBuffer = std::string();
-          if (_lastExpectedPacketSize < bytes_transferred)
-          {
-            //
-            // We have spill over bytes
-            //
-            std::size_t extraBytes = bytes_transferred - _lastExpectedPacketSize;
-            char spillbuf[extraBytes];
-            strm.read(spillbuf, extraBytes);
-            _spillOverBuffer = std::string(spillbuf, extraBytes);
-            OSS_LOG_DEBUG("FramedTcpConnection::handleRead "
-                << "Spillover bytes from last read detected.  "
-                << "BYTES: " << extraBytes);
-          }
-        }
-        else
-        {
-          _messageBuffer += _spillOverBuffer;
-          _messageBuffer += std::string(_buffer.data(), bytes_transferred);
-          _spillOverBuffer = std::string();
-          OSS_LOG_DEBUG("FramedTcpConnection::handleRead "
-                << "More bytes required to complete message.  "
-                << "Required BYTES: " << _moreReadRequired);
-        }
-      }
-    }
-    else
-    {
-      readMore(bytes_transferred);
+      boost::system::error_code ignored_ec;
+      _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
+      _listener.destroyConnection(shared_from_this());
+      return;
     }
   }
   else if (e)
@@ -158,63 +202,71 @@ void FramedTcpConnection::handleRead(const boost::system::error_code& e, std::si
   start();
 }
 
-void FramedTcpConnection::readMore(std::size_t bytes_transferred)
+bool FramedTcpConnection::processFrames()
 {
-  _messageBuffer += std::string(_buffer.data(), bytes_transferred);
-
-  std::stringstream strm;
-  strm << _messageBuffer;
-
-  short version;
-  strm.read((char*)(&version), sizeof(version));
-  short key;
-  strm.read((char*)(&key), sizeof(key));
-  if (version == FTCP_VERSION && key == FTCP_KEY)
+  while (_readEnd - _readStart >= FTCP_HEADER_SIZE)
   {
-    short len;
-    strm.read((char*)(&len), sizeof(len));
-
-    _lastExpectedPacketSize = len + sizeof(version) + sizeof(key) + (sizeof(len));
-    if (_messageBuffer.size() < _lastExpectedPacketSize)
-      _moreReadRequired = _lastExpectedPacketSize - _messageBuffer.size();
-    else
-      _moreReadRequired = 0;
+    Header header;
+    if (!decodeHeader(&_readBuffer[0] + _readStart, header))
+    {
+      OSS_LOG_WARNING( "FramedTcpConnection::processFrames "
+                << "Invalid frame header.  Closing connection.");
+      return false;
+    }
 
-    if (!_moreReadRequired)
+    if (header.size > FTCP_MAX_FRAME_SIZE)
     {
-      char buf[FTCP_READ_BUFFER_SIZE];
-      strm.read(buf, len);
-      _listener.onIncomingRequest(*this, buf, len);
-      _spillOverBuffer = std::string();
-      if (_lastExpectedPacketSize < _messageBuffer.size())
-      {
-        //
-        // We have spill over bytes
-        //
-        std::size_t extraBytes = _messageBuffer.size() - _lastExpectedPacketSize;
-        char spillbuf[extraBytes];
-        strm.read(spillbuf, extraBytes);
-        _spillOverBuffer = std::string(spillbuf, extraBytes);
-        OSS_LOG_DEBUG( "FramedTcpConnection::readMore "
-                << "Spillover bytes from last read detected.  "
-                << "BYTES: " << extraBytes);
-      }
+      OSS_LOG_WARNING( "FramedTcpConnection::processFrames "
+                << "Frame of " << header.size << " bytes exceeds the maximum of " << FTCP_MAX_FRAME_SIZE);
+      return false;
     }
-    else
+
+    std::size_t frameSize = FTCP_HEADER_SIZE + header.size;
+    if (_readEnd - _readStart < frameSize)
     {
-      OSS_LOG_DEBUG( "FramedTcpConnection::readMore "
-                << "More bytes required to complete message.  "
-                << "Required BYTES: " << _moreReadRequired);
+      //
+      // Make sure the rest of the frame fits after what we already have
+      //
+      if (frameSize > _readBuffer.size())
+        _readBuffer.resize(frameSize);
+      break;
     }
+
+    _listener.onIncomingRequest(*this, &_readBuffer[0] + _readStart + FTCP_HEADER_SIZE, header.size);
+    _readStart += frameSize;
   }
+
+  //
+  // Move a partial frame to the front so the next read appends to it
+  //
+  if (_readStart == _readEnd)
+  {
+    _readStart = _readEnd = 0;
+  }
+  else if (_readStart > 0 && _readBuffer.size() - _readEnd < FTCP_READ_BUFFER_SIZE)
+  {
+    std::memmove(&_readBuffer[0], &_readBuffer[0] + _readStart, _readEnd - _readStart);
+    _readEnd -= _readStart;
+    _readStart = 0;
+  }
+
+  //
+  // Shrink back after an oversized frame has been consumed
+  //
+  if (_readEnd == 0 && _readBuffer.size() > FTCP_READ_BUFFER_SIZE)
+    std::vector<char>(FTCP_READ_BUFFER_SIZE).swap(_readBuffer);
+
+  return true;
 }
 
 void FramedTcpConnection::start()
 {
   OSS_LOG_DEBUG( "FramedTcpConnection::start() INVOKED");
 
+  if (_readEnd == _readBuffer.size())
+    _readBuffer.resize(_readBuffer.size() + FTCP_READ_BUFFER_SIZE);
 
-  _socket.async_read_some(boost::asio::buffer(_buffer),
+  _socket.async_read_some(boost::asio::buffer(&_readBuffer[_readEnd], _readBuffer.size() - _readEnd),
             boost::bind(&FramedTcpConnection::handleRead, shared_from_this(),
               boost::asio::placeholders::error,
               boost::asio::placeholders::bytes_transferred));
@@ -223,7 +275,27 @@ void FramedTcpConnection::start()
 void FramedTcpConnection::stop()
 {
   OSS_LOG_DEBUG( "FramedTcpConnection::stop() INVOKED");
-  _socket.close();
+  {
+    boost::mutex::scoped_lock lock(_writeMutex);
+    _isOpen = false;
+    _pendingFrames.clear();
+  }
+  boost::system::error_code ignored_ec;
+  _pInactivityTimer->cancel(ignored_ec);
+  _socket.close(ignored_ec);
+}
+
+void FramedTcpConnection::abort()
+{
+  {
+    boost::mutex::scoped_lock lock(_writeMutex);
+    _writingFrames.clear();
+    _pendingFrames.clear();
+    _isWriting = false;
+  }
+  boost::system::error_code ignored_ec;
+  _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
+  _listener.destroyConnection(shared_from_this());
 }
 
 void FramedTcpConnection::onInactivityTimeout(const boost::system::error_code& ec)
@@ -232,9 +304,7 @@ void FramedTcpConnection::onInactivityTimeout(const boost::system::error_code& e
   {
     OSS_LOG_WARNING( "FramedTcpConnection::onInactivityTimeout "
                   << "No activity on this socket for too long." );
-    boost::system::error_code ignored_ec;
-    _socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
-    _socket.close();
+    abort();
   }
 }
 
@@ -243,12 +313,10 @@ void FramedTcpConnection::startInactivityTimer()
   boost::system::error_code ignored_ec;
   _pInactivityTimer->cancel(ignored_ec);
   _pInactivityTimer->expires_from_now(boost::posix_time::milliseconds(_listener.getInactivityThreshold() * 1000));
-  _pInactivityTimer->async_wait(boost::bind(&FramedTcpConnection::onInactivityTimeout, this, boost::asio::placeholders::error));
+  _pInactivityTimer->async_wait(boost::bind(&FramedTcpConnection::onInactivityTimeout, shared_from_this(), boost::asio::placeholders::error));
 
   OSS_LOG_DEBUG( "FramedTcpConnection::startInactivityTimer "
           << " Session inactivity timeout set at " << _listener.getInactivityThreshold() << " seconds.");
 }
 
 } // OSS
-
-
@@ -0,0 +1,564 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+#include "OSS/Net/NetlinkBanSet.h"
+#include "OSS/UTL/Logger.h"
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#if OSS_OS == OSS_OS_LINUX
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter/nfnetlink.h>
+#include <linux/netfilter/ipset/ip_set.h>
+
+//
+// The oldest protocol revision still accepted by current kernels.  Older
+// kernels accept nothing else.
+//
+#ifdef IPSET_PROTOCOL_MIN
+#define OSS_IPSET_PROTOCOL IPSET_PROTOCOL_MIN
+#else
+#define OSS_IPSET_PROTOCOL IPSET_PROTOCOL
+#endif
+#endif
+
+
+namespace OSS {
+namespace Net {
+
+
+#if OSS_OS == OSS_OS_LINUX
+
+static const int NETLINK_ACK_TIMEOUT = 2; // seconds
+
+static void nl_put_attr(std::string& buffer, OSS::UInt16 type, const void* data, std::size_t len)
+{
+  struct nlattr attr;
+  attr.nla_len = NLA_HDRLEN + len;
+  attr.nla_type = type;
+  buffer.append((const char*)&attr, sizeof(attr));
+  buffer.append((const char*)data, len);
+  buffer.append(NLA_ALIGN(len) - len, '\0');
+}
+
+static void nl_put_u8(std::string& buffer, OSS::UInt16 type, OSS::UInt8 value)
+{
+  nl_put_attr(buffer, type, &value, sizeof(value));
+}
+
+static void nl_put_u32_net(std::string& buffer, OSS::UInt16 type, OSS::UInt32 value)
+{
+  value = htonl(value);
+  nl_put_attr(buffer, type | NLA_F_NET_BYTEORDER, &value, sizeof(value));
+}
+
+static void nl_put_string(std::string& buffer, OSS::UInt16 type, const std::string& value)
+{
+  nl_put_attr(buffer, type, value.c_str(), value.size() + 1);
+}
+
+static std::size_t nl_begin_nest(std::string& buffer, OSS::UInt16 type)
+{
+  std::size_t offset = buffer.size();
+  struct nlattr attr;
+  attr.nla_len = 0;
+  attr.nla_type = type | NLA_F_NESTED;
+  buffer.append((const char*)&attr, sizeof(attr));
+  return offset;
+}
+
+static void nl_end_nest(std::string& buffer, std::size_t offset)
+{
+  OSS::UInt16 len = buffer.size() - offset;
+  memcpy(&buffer[offset] + offsetof(struct nlattr, nla_len), &len, sizeof(len));
+}
+
+static std::size_t ipset_begin_message(std::string& buffer, OSS::UInt8 command, OSS::UInt8 family, OSS::UInt32 sequence)
+{
+  std::size_t offset = buffer.size();
+
+  struct nlmsghdr header;
+  memset(&header, 0, sizeof(header));
+  header.nlmsg_type = (NFNL_SUBSYS_IPSET << 8) | command;
+  header.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+  header.nlmsg_seq = sequence;
+  buffer.append((const char*)&header, sizeof(header));
+
+  struct nfgenmsg generic;
+  memset(&generic, 0, sizeof(generic));
+  generic.nfgen_family = family;
+  generic.version = NFNETLINK_V0;
+  buffer.append((const char*)&generic, sizeof(generic));
+  buffer.append(NLMSG_ALIGN(sizeof(generic)) - sizeof(generic), '\0');
+
+  nl_put_u8(buffer, IPSET_ATTR_PROTOCOL, OSS_IPSET_PROTOCOL);
+  return offset;
+}
+
+static void ipset_end_message(std::string& buffer, std::size_t offset)
+{
+  OSS::UInt32 len = buffer.size() - offset;
+  memcpy(&buffer[offset] + offsetof(struct nlmsghdr, nlmsg_len), &len, sizeof(len));
+}
+
+#endif
+
+
+NetlinkBanSet::NetlinkBanSet(const std::string& setName) :
+  _setName(setName),
+  _setName6(setName + "6"),
+  _fd(-1),
+  _sequence(0),
+  _isFlushing(false),
+  _pFlusher(0)
+{
+}
+
+NetlinkBanSet::~NetlinkBanSet()
+{
+  close();
+}
+
+bool NetlinkBanSet::open()
+{
+#if OSS_OS == OSS_OS_LINUX
+  if (isOpen())
+    return true;
+
+  if (_setName6.size() >= IPSET_MAXNAMELEN)
+  {
+    OSS_LOG_ERROR("NetlinkBanSet::open - Set name " << _setName << " is too long");
+    return false;
+  }
+
+  _fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_NETFILTER);
+  if (_fd == -1)
+  {
+    OSS_LOG_ERROR("NetlinkBanSet::open - Unable to create netlink socket.  ERROR: " << strerror(errno));
+    return false;
+  }
+
+  struct sockaddr_nl local;
+  memset(&local, 0, sizeof(local));
+  local.nl_family = AF_NETLINK;
+  if (bind(_fd, (struct sockaddr*)&local, sizeof(local)) == -1)
+  {
+    OSS_LOG_ERROR("NetlinkBanSet::open - Unable to bind netlink socket.  ERROR: " << strerror(errno));
+    close();
+    return false;
+  }
+
+  //
+  // Keep error acknowledgements short.  Without this the kernel echoes the
+  // whole failed request back.
+  //
+#ifdef NETLINK_CAP_ACK
+  int one = 1;
+  setsockopt(_fd, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+#endif
+
+  struct timeval timeout;
+  timeout.tv_sec = NETLINK_ACK_TIMEOUT;
+  timeout.tv_usec = 0;
+  setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  boost::mutex::scoped_lock lock(_ioMutex);
+  if (!createSet(_setName, false) || !createSet(_setName6, true))
+  {
+    lock.unlock();
+    close();
+    return false;
+  }
+
+  lock.unlock();
+
+  {
+    boost::mutex::scoped_lock queueLock(_mutex);
+    _isFlushing = true;
+  }
+  _pFlusher = new boost::thread(boost::bind(&NetlinkBanSet::runFlusher, this));
+
+  OSS_LOG_NOTICE("NetlinkBanSet::open - Using ipset " << _setName << " and " << _setName6 << " for banned sources");
+  return true;
+#else
+  OSS_LOG_ERROR("NetlinkBanSet::open - ipset is only available on Linux");
+  return false;
+#endif
+}
+
+void NetlinkBanSet::close()
+{
+  {
+    boost::mutex::scoped_lock lock(_mutex);
+    _isFlushing = false;
+    _adds.clear();
+    _dels.clear();
+  }
+  _pendingCondition.notify_all();
+  if (_pFlusher)
+  {
+    _pFlusher->join();
+    delete _pFlusher;
+    _pFlusher = 0;
+  }
+
+#if OSS_OS == OSS_OS_LINUX
+  boost::mutex::scoped_lock ioLock(_ioMutex);
+  if (_fd != -1)
+  {
+    ::close(_fd);
+    _fd = -1;
+  }
+#endif
+}
+
+void NetlinkBanSet::add(const boost::asio::ip::address& address)
+{
+  boost::mutex::scoped_lock lock(_mutex);
+  if (!_isFlushing)
+    return;
+  _dels.erase(address);
+  _adds.insert(address);
+  _pendingCondition.notify_one();
+}
+
+void NetlinkBanSet::remove(const boost::asio::ip::address& address)
+{
+  boost::mutex::scoped_lock lock(_mutex);
+  if (!_isFlushing)
+    return;
+  _adds.erase(address);
+  _dels.insert(address);
+  _pendingCondition.notify_one();
+}
+
+void NetlinkBanSet::runFlusher()
+{
+  boost::mutex::scoped_lock lock(_mutex);
+  while (_isFlushing)
+  {
+    if (_adds.empty() && _dels.empty())
+    {
+      _pendingCondition.wait(lock);
+      continue;
+    }
+
+    lock.unlock();
+    if (!flush())
+    {
+      OSS_LOG_ERROR("NetlinkBanSet::runFlusher - Unable to update " << _setName);
+    }
+    lock.lock();
+  }
+}
+
+std::size_t NetlinkBanSet::pending() const
+{
+  boost::mutex::scoped_lock lock(_mutex);
+  return _adds.size() + _dels.size();
+}
+
+bool NetlinkBanSet::flush()
+{
+  //
+  // Flushes are sent in the order they take the queue so a later change
+  // to the same address is never overtaken by an earlier one
+  //
+  boost::mutex::scoped_lock ioLock(_ioMutex);
+  Pending adds;
+  Pending dels;
+  {
+    boost::mutex::scoped_lock lock(_mutex);
+    adds.swap(_adds);
+    dels.swap(_dels);
+  }
+
+  if (adds.empty() && dels.empty())
+    return true;
+  if (!isOpen())
+    return false;
+
+  //
+  // An address is never queued in both lists so the order does not matter
+  //
+  bool ok = true;
+  if (!dels.empty() && !send(DEL, dels))
+    ok = false;
+  if (!adds.empty() && !send(ADD, adds))
+    ok = false;
+  return ok;
+}
+
+bool NetlinkBanSet::sync(const Addresses& banned)
+{
+  boost::mutex::scoped_lock ioLock(_ioMutex);
+  {
+    boost::mutex::scoped_lock lock(_mutex);
+    _adds.clear();
+    _dels.clear();
+  }
+
+  if (!isOpen())
+    return false;
+
+  if (!flushSet(_setName) || !flushSet(_setName6))
+    return false;
+
+  Pending all(banned.begin(), banned.end());
+  if (all.empty())
+    return true;
+
+  OSS_LOG_NOTICE("NetlinkBanSet::sync - Loading " << all.size() << " banned sources");
+  return send(ADD, all);
+}
+
+bool NetlinkBanSet::encode(
+  std::string& buffer,
+  Command command,
+  const std::string& setName,
+  const Addresses& addresses,
+  OSS::UInt32 sequence)
+{
+#if OSS_OS == OSS_OS_LINUX
+  if (addresses.empty())
+    return false;
+
+  bool v6 = addresses.front().is_v6();
+  for (Addresses::const_iterator iter = addresses.begin(); iter != addresses.end(); iter++)
+  {
+    if (iter->is_v6() != v6)
+      return false;
+  }
+
+  std::size_t message = ipset_begin_message(buffer,
+    command == ADD ? IPSET_CMD_ADD : IPSET_CMD_DEL,
+    v6 ? NFPROTO_IPV6 : NFPROTO_IPV4,
+    sequence);
+  nl_put_string(buffer, IPSET_ATTR_SETNAME, setName);
+
+  //
+  // The kernel only takes an element list together with a line number.  It
+  // reports the index of a failing element there.
+  //
+  OSS::UInt32 lineno = 0;
+  nl_put_attr(buffer, IPSET_ATTR_LINENO, &lineno, sizeof(lineno));
+
+  std::size_t adt = nl_begin_nest(buffer, IPSET_ATTR_ADT);
+  for (Addresses::const_iterator iter = addresses.begin(); iter != addresses.end(); iter++)
+  {
+    std::size_t data = nl_begin_nest(buffer, IPSET_ATTR_DATA);
+    std::size_t ip = nl_begin_nest(buffer, IPSET_ATTR_IP);
+    if (v6)
+    {
+      boost::asio::ip::address_v6::bytes_type bytes = iter->to_v6().to_bytes();
+      nl_put_attr(buffer, IPSET_ATTR_IPADDR_IPV6 | NLA_F_NET_BYTEORDER, bytes.data(), bytes.size());
+    }
+    else
+    {
+      nl_put_u32_net(buffer, IPSET_ATTR_IPADDR_IPV4, iter->to_v4().to_ulong());
+    }
+    nl_end_nest(buffer, ip);
+    nl_end_nest(buffer, data);
+  }
+  nl_end_nest(buffer, adt);
+
+  ipset_end_message(buffer, message);
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool NetlinkBanSet::createSet(const std::string& setName, bool v6)
+{
+#if OSS_OS == OSS_OS_LINUX
+  //
+  // Without NLM_F_EXCL the kernel accepts an existing set of the same type
+  //
+  OSS::UInt8 family = v6 ? NFPROTO_IPV6 : NFPROTO_IPV4;
+  std::string buffer;
+  OSS::UInt32 sequence = ++_sequence;
+  std::size_t message = ipset_begin_message(buffer, IPSET_CMD_CREATE, family, sequence);
+  nl_put_string(buffer, IPSET_ATTR_SETNAME, setName);
+  nl_put_string(buffer, IPSET_ATTR_TYPENAME, "hash:ip");
+  nl_put_u8(buffer, IPSET_ATTR_REVISION, 0);
+  nl_put_u8(buffer, IPSET_ATTR_FAMILY, family);
+  std::size_t data = nl_begin_nest(buffer, IPSET_ATTR_DATA);
+  nl_put_u32_net(buffer, IPSET_ATTR_MAXELEM, DEFAULT_MAX_ELEMENTS);
+  nl_end_nest(buffer, data);
+  ipset_end_message(buffer, message);
+
+  if (!transact(buffer, sequence, 1))
+  {
+    OSS_LOG_ERROR("NetlinkBanSet::createSet - Unable to create ipset " << setName);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool NetlinkBanSet::flushSet(const std::string& setName)
+{
+#if OSS_OS == OSS_OS_LINUX
+  std::string buffer;
+  OSS::UInt32 sequence = ++_sequence;
+  std::size_t message = ipset_begin_message(buffer, IPSET_CMD_FLUSH, NFPROTO_UNSPEC, sequence);
+  nl_put_string(buffer, IPSET_ATTR_SETNAME, setName);
+  ipset_end_message(buffer, message);
+  return transact(buffer, sequence, 1);
+#else
+  return false;
+#endif
+}
+
+bool NetlinkBanSet::send(Command command, const Pending& pending)
+{
+  Addresses v4;
+  Addresses v6;
+  for (Pending::const_iterator iter = pending.begin(); iter != pending.end(); iter++)
+  {
+    if (iter->is_v6())
+      v6.push_back(*iter);
+    else
+      v4.push_back(*iter);
+  }
+
+  bool ok = true;
+  std::string buffer;
+  std::size_t messageCount = 0;
+  OSS::UInt32 firstSequence = 0;
+  Addresses batch;
+  batch.reserve(MAX_BATCH_SIZE);
+
+  const Addresses* families[] = { &v4, &v6 };
+  for (std::size_t i = 0; i < 2; i++)
+  {
+    const Addresses& addresses = *families[i];
+    const std::string& setName = (i == 0) ? _setName : _setName6;
+    for (std::size_t offset = 0; offset < addresses.size(); offset += MAX_BATCH_SIZE)
+    {
+      std::size_t count = std::min<std::size_t>(MAX_BATCH_SIZE, addresses.size() - offset);
+      batch.assign(addresses.begin() + offset, addresses.begin() + offset + count);
+      if (!encode(buffer, command, setName, batch, _sequence + 1))
+        continue;
+      if (!messageCount)
+        firstSequence = _sequence + 1;
+      ++_sequence;
+      messageCount++;
+
+      //
+      // A full batch is well under half of MAX_SEND_SIZE so the next one
+      // still fits
+      //
+      if (buffer.size() >= MAX_SEND_SIZE / 2)
+      {
+        if (!transact(buffer, firstSequence, messageCount))
+          ok = false;
+        buffer.clear();
+        messageCount = 0;
+      }
+    }
+  }
+
+  if (messageCount && !transact(buffer, firstSequence, messageCount))
+    ok = false;
+
+  return ok;
+}
+
+bool NetlinkBanSet::transact(const std::string& buffer, OSS::UInt32 firstSequence, std::size_t messageCount)
+{
+#if OSS_OS == OSS_OS_LINUX
+  if (!isOpen())
+    return false;
+
+  struct sockaddr_nl kernel;
+  memset(&kernel, 0, sizeof(kernel));
+  kernel.nl_family = AF_NETLINK;
+
+  ssize_t sent;
+  do
+  {
+    sent = sendto(_fd, buffer.data(), buffer.size(), 0, (struct sockaddr*)&kernel, sizeof(kernel));
+  } while (sent == -1 && errno == EINTR);
+
+  if (sent != (ssize_t)buffer.size())
+  {
+    OSS_LOG_ERROR("NetlinkBanSet::transact - Unable to send to netlink.  ERROR: " << strerror(errno));
+    return false;
+  }
+
+  //
+  // Every message is answered with an NLMSG_ERROR carrying zero on success
+  //
+  bool ok = true;
+  std::size_t acks = 0;
+  char response[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+  while (acks < messageCount)
+  {
+    ssize_t len = recv(_fd, response, sizeof(response), 0);
+    if (len == -1)
+    {
+      if (errno == EINTR)
+        continue;
+      OSS_LOG_ERROR("NetlinkBanSet::transact - No response from netlink.  ERROR: " << strerror(errno));
+      return false;
+    }
+
+    int remaining = len;
+    for (struct nlmsghdr* header = (struct nlmsghdr*)response; NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining))
+    {
+      //
+      // A request that timed out earlier may still be answered.  Its
+      // sequence numbers are all below this request's.
+      //
+      if (header->nlmsg_type != NLMSG_ERROR || (OSS::UInt32)(header->nlmsg_seq - firstSequence) >= messageCount)
+        continue;
+      acks++;
+      struct nlmsgerr* error = (struct nlmsgerr*)NLMSG_DATA(header);
+      if (error->error)
+      {
+        //
+        // ipset specific errors are numbered past the errno range
+        //
+        OSS_LOG_ERROR("NetlinkBanSet::transact - ipset request " << header->nlmsg_seq
+          << " failed.  ERROR: " << -error->error
+          << (-error->error < 4096 ? std::string(" ") + strerror(-error->error) : std::string()));
+        ok = false;
+      }
+    }
+  }
+  return ok;
+#else
+  return false;
+#endif
+}
+
+} } // OSS::Net
@@ -37,6 +37,7 @@
 #include "../processors/hybi_util.hpp"
 
 using websocketpp::processor::hybi_util::circshift_prepared_key;
+using websocketpp::processor::hybi_util::word_mask_circ;
 
 namespace websocketpp {
 namespace message {
@@ -63,19 +64,8 @@ public:
         }
         
         if (m_masked) {
-            // this retrieves ceiling of size / word size
-            size_t n = static_cast<size_t>((size + sizeof(size_t) - 1) / sizeof(size_t));
-            
-            // reinterpret the input as an array of word sized integers
-            size_t* data = reinterpret_cast<size_t*>(input);
-            
-            // unmask working buffer
-            for (size_t i = 0; i < n; i++) {
-                data[i] ^= m_prepared_key;
-            }
-            
-            // circshift working key
-            m_prepared_key = circshift_prepared_key(m_prepared_key, size%4);
+            // unmask working buffer and circshift working key
+            m_prepared_key = word_mask_circ(input, static_cast<size_t>(size), m_prepared_key);
         }
                 
         // copy working buffer into
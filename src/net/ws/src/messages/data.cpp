@@ -37,6 +37,7 @@
 
 using websocketpp::message::data;
 using websocketpp::processor::hybi_util::circshift_prepared_key;
+using websocketpp::processor::hybi_util::word_mask_circ;
 
 data::data(data::pool_ptr p, size_t s) : m_prepared(false),m_index(s),m_ref_count(0),m_pool(p),m_live(false) {
     m_payload.reserve(PAYLOAD_SIZE_INIT);
@@ -73,27 +74,15 @@ void data::process_payload(char *input, size_t size) {
         
         //std::cout << "before: " << zsutil::to_hex(input, size) << std::endl;
         
-        // this retrieves ceiling of size / word size
-        size_t n = (size + sizeof(size_t) - 1) / sizeof(size_t);
-        
-        // reinterpret the input as an array of word sized integers
-        size_t* data = reinterpret_cast<size_t*>(input);
-        
-        // unmask working buffer
-        for (size_t i = 0; i < n; i++) {
-            data[i] ^= m_prepared_key;
-        }
+        // unmask working buffer and circshift working key
+        m_prepared_key = word_mask_circ(input, size, m_prepared_key);
         
         //std::cout << "after: " << zsutil::to_hex(input, size) << std::endl;
-        
-        // circshift working key
-        //std::cout << "circshift by : " << size%4 << " bytes " << zsutil::to_hex(reinterpret_cast<char*>(&m_prepared_key),sizeof(size_t));
-        m_prepared_key = circshift_prepared_key(m_prepared_key, size%4);
-        //std::cout << " to " << zsutil::to_hex(reinterpret_cast<char*>(&m_prepared_key),sizeof(size_t)) << std::endl;
     }
     
     if (m_opcode == frame::opcode::TEXT) {
-        if (!m_validator.decode(input, input+size)) {
+        const char* text = input;
+        if (!m_validator.decode(text, text+size)) {
             throw processor::exception("Invalid UTF8 data",
                                        processor::error::PAYLOAD_VIOLATION);
         }
@@ -126,7 +115,7 @@ void data::complete() {
 
 void data::validate_payload() {
     if (m_opcode == frame::opcode::TEXT) {
-        if (!m_validator.decode(m_payload.begin(), m_payload.end())) {
+        if (!m_validator.decode(m_payload.data(), m_payload.data()+m_payload.size())) {
             throw exception("Invalid UTF8 data",error::PAYLOAD_VIOLATION);
         }
         
@@ -27,6 +27,12 @@
 
 #include "hybi_util.hpp"
 
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace websocketpp {
 namespace processor {
 namespace hybi_util { 
@@ -60,6 +66,44 @@ void word_mask_exact(char* data,size_t length,const masking_key_type& key) {
     }
 }
 
+size_t word_mask_circ(char* data,size_t length,size_t prepared_key) {
+    size_t i = 0;
+    
+#if defined(__SSE2__)
+    char wide_key[16];
+    for (size_t j = 0; j < sizeof(wide_key); j += sizeof(size_t)) {
+        std::memcpy(wide_key+j,&prepared_key,sizeof(size_t));
+    }
+    __m128i key128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(wide_key));
+    
+    for (; i + 16 <= length; i += 16) {
+        __m128i* block = reinterpret_cast<__m128i*>(data+i);
+        _mm_storeu_si128(block,_mm_xor_si128(_mm_loadu_si128(block),key128));
+    }
+#endif
+    
+    // the payload buffer carries no alignment guarantee so words are moved
+    // through memcpy, which compiles down to a plain load and store
+    for (; i + sizeof(size_t) <= length; i += sizeof(size_t)) {
+        size_t word;
+        std::memcpy(&word,data+i,sizeof(size_t));
+        word ^= prepared_key;
+        std::memcpy(data+i,&word,sizeof(size_t));
+    }
+    
+    const char* key_bytes = reinterpret_cast<const char*>(&prepared_key);
+    for (; i < length; i++) {
+        data[i] ^= key_bytes[i%sizeof(size_t)];
+    }
+    
+    // a shift by the full word width is undefined so a key that is already
+    // aligned is returned untouched
+    if (length%4 == 0) {
+        return prepared_key;
+    }
+    return circshift_prepared_key(prepared_key,length%4);
+}
+
 } // namespace hybi_util
 } // namespace processor
 } // namespace websocketpp
\ No newline at end of file
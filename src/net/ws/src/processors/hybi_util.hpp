@@ -63,6 +63,12 @@ void byte_mask(iter_type b, iter_type e, const masking_key_type& key, size_t key
 // exactly masks the bytes from start to end using key `key`
 void word_mask_exact(char* data,size_t length,const masking_key_type& key);
 
+// exactly masks length bytes of data with a prepared key, sixteen bytes at a
+// time where SSE2 is available and a machine word at a time otherwise. Returns
+// the prepared key circshifted for the byte that follows the masked range so
+// that a payload split across several reads can be masked piece by piece.
+size_t word_mask_circ(char* data,size_t length,size_t prepared_key);
+
 } // namespace hybi_util
 } // namespace processor
 } // namespace websocketpp
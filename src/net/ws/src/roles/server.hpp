@@ -199,8 +199,16 @@ public:
        // ignored, as it is always overwriten later by the listen() member func
        m_acceptor(m),
        m_state(IDLE),
+       m_reuse_port(false),
        m_timer(m,boost::posix_time::seconds(0)) {}
     
+    // Several servers, each with its own io_service, may listen on the same
+    // endpoint when this is set before listen(). The kernel then spreads
+    // incoming connections across their acceptors.
+    void set_reuse_port(bool value) {
+        m_reuse_port = value;
+    }
+    
     void start_listen(uint16_t port, size_t num_threads = 1);
     void start_listen(const boost::asio::ip::tcp::endpoint& e, size_t num_threads = 1);
     // uses internal resolver
@@ -268,6 +276,7 @@ private:
     boost::asio::io_service&        m_io_service;
     boost::asio::ip::tcp::acceptor  m_acceptor;
     state                           m_state;
+    bool                            m_reuse_port;
     
     boost::asio::deadline_timer     m_timer;
 
@@ -285,6 +294,13 @@ void server<endpoint>::start_listen(const boost::asio::ip::tcp::endpoint& e,size
         
         m_acceptor.open(e.protocol());
         m_acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+        if (m_reuse_port) {
+#ifdef SO_REUSEPORT
+            m_acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#else
+            throw exception("listen called with reuse_port on a platform without SO_REUSEPORT");
+#endif
+        }
         m_acceptor.bind(e);
         m_acceptor.listen();
     
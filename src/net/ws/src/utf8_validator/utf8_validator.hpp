@@ -5,6 +5,12 @@
 #define UTF8_VALIDATOR_HPP
 
 #include <stdint.h>
+#include <cstring>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace utf8_validator {
 
@@ -61,6 +67,26 @@ public:
         return true;
     }
     
+    // contiguous buffers skip runs of ASCII sixteen bytes at a time (eight
+    // without SSE2) and only feed the state machine bytes with the high bit
+    // set. A run can only be skipped between code points, when the state is
+    // UTF8_ACCEPT, because ASCII bytes inside a sequence are errors.
+    bool decode (const char* b, const char* e) {
+        const char* i = b;
+        while (i != e) {
+            if (m_state == UTF8_ACCEPT) {
+                i = skip_ascii(i, e);
+                if (i == e) {
+                    break;
+                }
+            }
+            if (utf8_validator::decode(&m_state,&m_codepoint,static_cast<uint8_t>(*i++)) == UTF8_REJECT) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
     bool complete() {
         return m_state == UTF8_ACCEPT;
     }
@@ -70,6 +96,30 @@ public:
         m_codepoint = 0;
     }
 private:
+    static const char* skip_ascii(const char* b, const char* e) {
+#if defined(__SSE2__)
+        while (e - b >= 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+            if (_mm_movemask_epi8(block) != 0) {
+                break;
+            }
+            b += 16;
+        }
+#endif
+        while (e - b >= 8) {
+            uint64_t word;
+            std::memcpy(&word, b, sizeof(word));
+            if (word & 0x8080808080808080ULL) {
+                break;
+            }
+            b += 8;
+        }
+        while (b != e && static_cast<uint8_t>(*b) < 0x80) {
+            ++b;
+        }
+        return b;
+    }
+    
     uint32_t    m_state;
     uint32_t    m_codepoint;
 };
@@ -79,7 +129,7 @@ private:
 // TODO: should this be inline?
 inline bool validate(const std::string& s) {
     validator v;
-    if (!v.decode(s.begin(),s.end())) {
+    if (!v.decode(s.data(),s.data()+s.size())) {
         return false;
     }
     return v.complete();
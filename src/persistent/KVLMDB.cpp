@@ -0,0 +1,302 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include "OSS/Persistent/KVLMDB.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+namespace Persistent {
+
+
+typedef OSS::LMDB::LMDatabase::Transaction Transaction;
+typedef OSS::LMDB::LMDatabase::Cursor Cursor;
+
+static const char* KV_LMDB_NAME = "kv";
+
+//
+// LMDatabase reports zero length values as missing.  Empty values are
+// stored as a bare expiry header with no expiry instead.
+//
+static const std::string& kv_lmdb_value(const std::string& value, std::string& buffer)
+{
+  if (!value.empty())
+    return value;
+  buffer.assign(PERSISTENT_STORE_TTL_MAGIC, 4);
+  buffer.append(PERSISTENT_STORE_TTL_HEADER_SIZE - 4, '\0');
+  return buffer;
+}
+
+static void kv_lmdb_strip_empty(std::string& value)
+{
+  if (value.size() == PERSISTENT_STORE_TTL_HEADER_SIZE && kv_has_ttl_header(value) && !kv_decode_expires(value))
+    value.clear();
+}
+
+KVLMDB::KVLMDB() :
+  _pDb(0),
+  _mapSize(DEFAULT_MAP_SIZE_MB)
+{
+}
+  
+KVLMDB::~KVLMDB()
+{
+  close();
+}
+
+bool KVLMDB::open(const std::string& path)
+{
+  close();
+  _path = path;
+  
+  OSS::LMDB::LMDatabase::Options options;
+  options.path = path;
+  options.name = KV_LMDB_NAME;
+  options.size_mb = _mapSize;
+  
+  _pDb = new OSS::LMDB::LMDatabase();
+  if (!_pDb->initialize(options))
+  {
+    delete _pDb;
+    _pDb = 0;
+    return false;
+  }
+  return true;
+}
+
+bool KVLMDB::isOpen()
+{
+  return _pDb != 0;
+}
+
+bool KVLMDB::close()
+{
+  if (_pDb)
+  {
+    _pDb->close();
+    delete _pDb;
+    _pDb = 0;
+  }
+  return true;
+}
+
+bool KVLMDB::put(const std::string& key, const std::string& value)
+{
+  if (!_pDb)
+    return false;
+  
+  std::string buffer;
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+    return false;
+  if (!_pDb->set(transaction, key, kv_lmdb_value(value, buffer)))
+  {
+    transaction.cancel();
+    return false;
+  }
+  return transaction.end();
+}
+
+bool KVLMDB::get(const std::string& key, std::string& value)
+{
+  if (!_pDb)
+    return false;
+  
+  Transaction transaction(_pDb);
+  if (!transaction.beginRead())
+    return false;
+  bool found = _pDb->get(transaction, key, value);
+  transaction.end();
+  if (found)
+    kv_lmdb_strip_empty(value);
+  return found;
+}
+
+bool KVLMDB::del(const std::string& key)
+{
+  if (!_pDb)
+    return false;
+  
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+    return false;
+  if (!_pDb->del(transaction, key))
+  {
+    transaction.cancel();
+    return false;
+  }
+  return transaction.end();
+}
+
+bool KVLMDB::write(const KVOperations& operations)
+{
+  if (!_pDb)
+    return false;
+  
+  std::string buffer;
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+    return false;
+  
+  for (KVOperations::const_iterator iter = operations.begin(); iter != operations.end(); iter++)
+  {
+    //
+    // Deleting a missing key is not an error for a batch
+    //
+    if (iter->type == KVOperation::Put)
+    {
+      if (!_pDb->set(transaction, iter->key, kv_lmdb_value(iter->value, buffer)))
+      {
+        transaction.cancel();
+        return false;
+      }
+    }
+    else
+    {
+      _pDb->del(transaction, iter->key);
+    }
+  }
+  return transaction.end();
+}
+
+bool KVLMDB::scan(const std::string& filter, bool withValues, Keys* keys, Records* records)
+{
+  if (!_pDb)
+    return false;
+  
+  bool matchAll = filter.empty() || filter == "*";
+  std::string startKey;
+  if (!matchAll)
+    startKey = OSS::string_left(filter, filter.size() - 1);
+  
+  Transaction transaction(_pDb);
+  if (!transaction.beginRead())
+    return false;
+  
+  Cursor cursor;
+  if (!_pDb->createCursor(transaction, cursor))
+  {
+    transaction.end();
+    return false;
+  }
+  
+  for (bool found = cursor.seek(startKey); found; found = cursor.next())
+  {
+    std::string key = cursor.key();
+    if (!matchAll && !OSS::string_wildcard_compare(filter.c_str(), key))
+      break;
+    
+    if (keys)
+      keys->push_back(key);
+    
+    if (records)
+    {
+      Record record;
+      record.key = key;
+      if (withValues)
+      {
+        record.value = cursor.value();
+        kv_lmdb_strip_empty(record.value);
+      }
+      records->push_back(record);
+    }
+  }
+  
+  cursor.destroy();
+  transaction.end();
+  return true;
+}
+
+bool KVLMDB::scan(const std::string& startKey, std::size_t maxRecords, Records& records)
+{
+  if (!_pDb)
+    return false;
+  
+  Transaction transaction(_pDb);
+  if (!transaction.beginRead())
+    return false;
+  
+  Cursor cursor;
+  if (!_pDb->createCursor(transaction, cursor))
+  {
+    transaction.end();
+    return false;
+  }
+  
+  for (bool found = cursor.seek(startKey); found && records.size() < maxRecords; found = cursor.next())
+  {
+    Record record;
+    record.key = cursor.key();
+    record.value = cursor.value();
+    kv_lmdb_strip_empty(record.value);
+    records.push_back(record);
+  }
+  
+  cursor.destroy();
+  transaction.end();
+  return true;
+}
+
+bool KVLMDB::getKeys(Keys& keys)
+{
+  return scan(std::string(), false, &keys, 0);
+}
+
+bool KVLMDB::getKeys(const std::string& filter, Keys& keys)
+{
+  return scan(filter, false, &keys, 0);
+}
+
+bool KVLMDB::getRecords(Records& records)
+{
+  return scan(std::string(), true, 0, &records);
+}
+
+bool KVLMDB::getRecords(const std::string& filter, Records& records)
+{
+  return scan(filter, true, 0, &records);
+}
+
+bool KVLMDB::delKeys(const std::string& filter)
+{
+  Keys keys;
+  if (!getKeys(filter, keys))
+    return false;
+  
+  KVOperations operations;
+  operations.resize(keys.size());
+  for (std::size_t i = 0; i < keys.size(); i++)
+  {
+    operations[i].type = KVOperation::Del;
+    operations[i].key = keys[i];
+    operations[i].expireInSeconds = 0;
+  }
+  return write(operations);
+}
+
+const std::string KVLMDB::getPath() const
+{
+  return _path;
+}
+
+
+} } // OSS::Persistent
+
@@ -173,6 +173,40 @@ bool KVLevelDB::delKeys(const std::string& filter)
   return true;
 }
 
+bool KVLevelDB::write(const KVOperations& operations)
+{
+  leveldb::WriteBatch batch;
+  for (KVOperations::const_iterator iter = operations.begin(); iter != operations.end(); iter++)
+  {
+    if (iter->type == KVOperation::Put)
+      batch.Put(iter->key, iter->value);
+    else
+      batch.Delete(iter->key);
+  }
+  return _pDb->Write(leveldb::WriteOptions(), &batch).ok();
+}
+
+bool KVLevelDB::scan(const std::string& startKey, std::size_t maxRecords, Records& records)
+{
+  leveldb::Iterator* it = _pDb->NewIterator(leveldb::ReadOptions());
+  if (startKey.empty())
+    it->SeekToFirst();
+  else
+    it->Seek(startKey);
+  
+  for (; it->Valid() && records.size() < maxRecords; it->Next())
+  {
+    Record record;
+    record.key = it->key().ToString();
+    record.value = it->value().ToString();
+    records.push_back(record);
+  }
+  
+  bool status = it->status().ok();
+  delete it;
+  return status;
+}
+
 const std::string KVLevelDB::getPath() const
 {
   return _path;
@@ -841,6 +841,49 @@ bool RedisClient::hgetall(const std::string& key, std::vector<std::string>& valu
   return !value.empty();
 }
 
+bool RedisClient::pipeline(const std::vector< std::vector<std::string> >& commands)
+{
+  if (commands.empty())
+    return true;
+
+  mutex_lock lock(_mutex);
+
+  if (!_context && !connect())
+  {
+    OSS_LOG_ERROR("[REDIS] Connect FAILED.  Unable to create a new context for pipeline.");
+    return false;
+  }
+
+  for (std::vector< std::vector<std::string> >::const_iterator iter = commands.begin(); iter != commands.end(); iter++)
+  {
+    char** argv;
+    vectorToCArray(*iter, &argv);
+    redisAppendCommandArgv(_context, iter->size(), (const char**)argv, 0);
+    freeCArray(iter->size(), &argv);
+  }
+
+  bool ok = true;
+  for (std::size_t i = 0; i < commands.size(); i++)
+  {
+    void* reply = 0;
+    if (redisGetReply(_context, &reply) != REDIS_OK)
+    {
+      _lastError = strlen(_context->errstr) ? _context->errstr : "Unknown exception";
+      OSS_LOG_ERROR("[REDIS] Pipeline FAILED.  - " << _lastError);
+      //
+      // The context is unusable after an I/O error.  Reconnect so the next
+      // command starts on a clean connection.
+      //
+      connect();
+      return false;
+    }
+    if (((redisReply*)reply)->type == REDIS_REPLY_ERROR)
+      ok = false;
+    freeReply((redisReply*)reply);
+  }
+  return ok;
+}
+
 bool RedisClient::hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<std::string>& value) const
 {
   std::vector<std::string> args;
@@ -1111,6 +1154,50 @@ bool RedisBroadcastClient::del(const std::string& key)
   }
   return true;
 }
+
+bool RedisBroadcastClient::hgetall(const std::string& key, std::vector<std::string>& value) const
+{
+  if (!_defaultClient)
+    return false;
+
+  try
+  {
+    if (_defaultClient->hgetall(key, value))
+      return true;
+  }
+  catch(...)
+  {
+  }
+
+  for (Pool::const_iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+  {
+    try
+    {
+      RedisClient* client = iter->second;
+      if (client == _defaultClient)
+        continue;
+
+      if (client->hgetall(key, value))
+        return true;
+    }
+    catch(...)
+    {
+    }
+  }
+
+  return false;
+}
+
+bool RedisBroadcastClient::pipeline(const std::vector< std::vector<std::string> >& commands)
+{
+  bool ok = false;
+  for (Pool::iterator iter = _pool.begin(); iter != _pool.end(); iter++)
+  {
+    RedisClient* client = iter->second;
+    ok ? client->pipeline(commands) : ok = client->pipeline(commands);
+  }
+  return ok;
+}
   
 } } // OSS::Persistent
 
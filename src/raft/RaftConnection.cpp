@@ -35,6 +35,11 @@ RaftConnection::~RaftConnection()
 {
 }
 
+int RaftConnection::onSendSnapshot(RaftSnapshot& snapshot)
+{
+  return -1;
+}
+
 
 } } // OSS::RAFT
 
@@ -1,4 +1,3 @@
-
 // Library: OSS_CORE - Foundation API for SIP B2BUA
 // Copyright (c) OSS Software Solutions
 // Contributor: Joegen Baclor - mailto:joegen@ossapp.com
@@ -18,8 +17,12 @@
 // DEALINGS IN THE SOFTWARE.
 //
 
+
 #include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
 #include "OSS/RAFT/RaftConsensus.h"
+#include <cstdlib>
+#include <cstring>
 
 
 namespace OSS {
@@ -38,6 +41,18 @@ static void rc_seed_random()
     srand( (unsigned int)time( 0 ) + (unsigned int)getTicks() );
   }
 }
+
+static void* rc_copy_data(const raft_entry_data_t& data)
+{
+  if (!data.buf || !data.len)
+  {
+    return 0;
+  }
+  void* buf = malloc(data.len);
+  memcpy(buf, data.buf, data.len);
+  return buf;
+}
+
 //
 // Raft callback for sending request vote message
 //
@@ -47,13 +62,14 @@ static int rc_send_requestvote(
   raft_node_t* node,
   msg_requestvote_t* m)
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id <<  "----> rc_send_requestvote" << std::endl;
   Node raftNode(node);
-  return ((RaftConsensus*)user_data)->onSendRequestVote(raftNode, *m);
+  return ((RaftConsensus*)user_data)->queueRequestVote(raftNode, *m);
 }
 
 //
-// Raft callback for sending append entries message
+// Raft callback for sending append entries message.  libraft hands us
+// everything from the node next index onward.  The message is rebuilt
+// by queueAppendEntries so it can be capped and pipelined.
 //
 static int rc_send_appendentries(
   raft_server_t* raft,
@@ -61,9 +77,8 @@ static int rc_send_appendentries(
   raft_node_t* node,
   msg_appendentries_t* m)
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_send_appendentries" << std::endl;
   Node raftNode(node);
-  return ((RaftConsensus*)user_data)->onSendAppendEntries(raftNode, *m);
+  return ((RaftConsensus*)user_data)->queueAppendEntries(raftNode);
 }
 
 //
@@ -74,7 +89,6 @@ static int rc_applylog(
   void* user_data,
   raft_entry_t* ety)
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_applylog" << std::endl;
   return ((RaftConsensus*)user_data)->onApplyEntry(*ety);
 }
 
@@ -87,7 +101,6 @@ static int rc_persist_vote(
     void *user_data,
     const int voted_for )
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_persist_vote" << std::endl;
   return ((RaftConsensus*)user_data)->onPersistVote(voted_for);
 }
 
@@ -100,12 +113,12 @@ static int rc_persist_term(
   void* user_data,
   const int current_term )
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_persist_term" << std::endl;
   return ((RaftConsensus*)user_data)->onPersistTerm(current_term);
 }
 
 //
-// Raft callback for appending an item to the log
+// Raft callback for appending an item to the log.  The entry data
+// belongs to the caller so the log keeps its own copy.
 //
 static int rc_log_offer(
     raft_server_t* raft,
@@ -113,7 +126,7 @@ static int rc_log_offer(
     raft_entry_t* ety,
     int ety_idx )
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_log_offer" << std::endl;
+  ety->data.buf = rc_copy_data(ety->data);
   return ((RaftConsensus*)user_data)->onAppendEntry(*ety, ety_idx);
 }
 
@@ -126,14 +139,13 @@ static void rc_node_has_sufficient_logs(
     void *user_data,
     raft_node_t* node)
 { 
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_node_has_sufficient_logs" << std::endl;
   Node raftNode(node);
   ((RaftConsensus*)user_data)->onSufficientLogs(raftNode);
 }
 
 //
 // Raft callback for removing the first entry from the log
-// note this is provided to support log compaction in the future
+// after it has been compacted into a snapshot
 //
 static int rc_log_poll(
     raft_server_t* raft,
@@ -141,8 +153,10 @@ static int rc_log_poll(
     raft_entry_t* entry,
     int ety_idx )
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id <<  "----> rc_log_poll" << std::endl;
-  return 0;
+  int ret = ((RaftConsensus*)user_data)->onPollEntry(*entry, ety_idx);
+  free(entry->data.buf);
+  entry->data.buf = 0;
+  return ret;
 }
 
 //
@@ -156,8 +170,10 @@ static int rc_log_try_pop(
   raft_entry_t* entry,
   int ety_idx)
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id << "----> rc_log_try_pop" << std::endl;
-  return 0;
+  int ret = ((RaftConsensus*)user_data)->onPopEntry(*entry, ety_idx);
+  free(entry->data.buf);
+  entry->data.buf = 0;
+  return ret;
 }
 
 //
@@ -169,7 +185,10 @@ static void rc_log(
   void *user_data,
   const char *buf)
 {
-  std::cout << ((RaftConsensus*)user_data)->opt().node_id <<  "----> rc_log " << buf << std::endl;
+  if (OSS::log_get_level() >= OSS::PRIO_DEBUG)
+  {
+    OSS_LOG_DEBUG("RaftConsensus node " << ((RaftConsensus*)user_data)->opt().node_id << " - " << buf);
+  }
 }
   
 void rc_init_func()
@@ -187,12 +206,16 @@ void rc_init_func()
      rc_funcs.log_pop = rc_log_try_pop;
      rc_funcs.node_has_sufficient_logs = rc_node_has_sufficient_logs;
      rc_funcs.log = rc_log;
+     init_func = true;
   }
 }
 
 
 RaftConsensus::RaftConsensus() :
-  _raft(0)
+  _raft(0),
+  _lastEntryId(0),
+  _suppressAppends(false),
+  _ackInProgress(false)
 {
 }
 
@@ -200,10 +223,25 @@ RaftConsensus::~RaftConsensus()
 {
   if (_raft)
   {
+    freeEntries();
     raft_free(_raft);
   }
 }
 
+void RaftConsensus::freeEntries()
+{
+  int last = raft_get_current_idx(_raft);
+  for (int idx = raft_get_log_base_idx(_raft) + 1; idx <= last; idx++)
+  {
+    raft_entry_t* ety = raft_get_entry_from_idx(_raft, idx);
+    if (ety)
+    {
+      free(ety->data.buf);
+      ety->data.buf = 0;
+    }
+  }
+}
+
 bool RaftConsensus::initialize(const Options& options)
 {
   if (_raft)
@@ -222,6 +260,16 @@ bool RaftConsensus::initialize(const Options& options)
   //
   rc_seed_random();
   
+  //
+  // Reload the durable state before the callbacks are set
+  // so the restored entries are not written back
+  //
+  _opt = options;
+  if (!_opt.log_store_path.empty() && (!_logStore.open(_opt.log_store_path) || !restoreState()))
+  {
+    return false;
+  }
+  
   //
   // Initialize callbacks
   //
@@ -231,7 +279,6 @@ bool RaftConsensus::initialize(const Options& options)
   //
   // add self
   //
-  _opt = options;
   if (!addNode(_opt.node_id))
   {
     return false;
@@ -253,6 +300,56 @@ bool RaftConsensus::initialize(const Options& options)
   return true;
 }
 
+bool RaftConsensus::restoreState()
+{
+  int term = 0;
+  int vote = -1;
+  RaftSnapshot snapshot;
+  RaftLogStore::Entries entries;
+  
+  if (!_logStore.load(term, vote, snapshot, entries))
+  {
+    return false;
+  }
+  
+  if (snapshot.last_idx > 0)
+  {
+    if (!onRestoreSnapshot(snapshot.data))
+    {
+      OSS_LOG_ERROR("RaftConsensus::restoreState - Unable to restore snapshot at index " << snapshot.last_idx);
+      return false;
+    }
+    raft_load_snapshot(_raft, snapshot.last_idx, snapshot.last_term);
+    _snapshot = snapshot;
+  }
+  
+  raft_set_current_term(_raft, term);
+  if (vote != -1)
+  {
+    raft_vote_for_nodeid(_raft, vote);
+  }
+  
+  for (RaftLogStore::Entries::iterator iter = entries.begin(); iter != entries.end(); iter++)
+  {
+    raft_entry_t ety;
+    ety.term = iter->term;
+    ety.id = iter->id;
+    ety.type = iter->type;
+    ety.data.buf = (void*)iter->data.data();
+    ety.data.len = iter->data.size();
+    ety.data.buf = rc_copy_data(ety.data);
+    raft_append_entry(_raft, &ety);
+    if (ety.id > _lastEntryId)
+    {
+      _lastEntryId = ety.id;
+    }
+  }
+  
+  OSS_LOG_INFO("RaftConsensus::restoreState - Restored term " << term << " snapshot index " << snapshot.last_idx 
+    << " and " << entries.size() << " log entries");
+  return true;
+}
+
 bool RaftConsensus::addNode(int node_id)
 {
   OSS::mutex_lock lock(_raftMutex);
@@ -283,6 +380,7 @@ void RaftConsensus::removeNode(int node_id)
   {
     raft_remove_node(_raft, iter->second.node());
     _nodes.erase(node_id);
+    _peers.erase(node_id);
   }
 }
 
@@ -297,11 +395,113 @@ bool RaftConsensus::findNode(int node_id, Node& node)
   }
   return false;
 }
+
+bool RaftConsensus::submit(const std::string& data)
+{
+  std::vector<std::string> batch;
+  batch.push_back(data);
+  return submit(batch);
+}
+
+bool RaftConsensus::submit(const std::vector<std::string>& batch)
+{
+  bool ok = true;
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    if (!raft_is_leader(_raft))
+    {
+      return false;
+    }
+    
+    //
+    // libraft ships each entry as soon as it is received.  Hold the
+    // messages back until the whole batch is in the log so the peers
+    // get it in as few append entries messages as possible.
+    //
+    _suppressAppends = true;
+    if (_logStore.isOpen())
+    {
+      _logStore.beginBatch();
+    }
+    for (std::vector<std::string>::const_iterator iter = batch.begin(); iter != batch.end(); iter++)
+    {
+      msg_entry_t entry;
+      msg_entry_response_t response;
+      if (++_lastEntryId == 0)
+      {
+        _lastEntryId = 1;
+      }
+      entry.id = _lastEntryId;
+      entry.type = RAFT_LOGTYPE_NORMAL;
+      entry.data.buf = (void*)iter->data();
+      entry.data.len = iter->size();
+      if (raft_recv_entry(_raft, &entry, &response) != 0)
+      {
+        ok = false;
+        break;
+      }
+    }
+    if (_logStore.isOpen() && !_logStore.endBatch())
+    {
+      ok = false;
+    }
+    _suppressAppends = false;
+    
+    for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    {
+      if (iter->first != _opt.node_id)
+      {
+        queueAppendEntries(iter->second);
+      }
+    }
+    
+    //
+    // A single node cluster commits on append
+    //
+    applyCommitted();
+  }
+  dispatchOutbound();
+  return ok;
+}
+
+bool RaftConsensus::takeSnapshot()
+{
+  OSS::mutex_lock lock(_raftMutex);
+  return createSnapshot();
+}
+
+bool RaftConsensus::isLeader()
+{
+  OSS::mutex_lock lock(_raftMutex);
+  return !!raft_is_leader(_raft);
+}
+
+int RaftConsensus::getCommitIndex()
+{
+  OSS::mutex_lock lock(_raftMutex);
+  return raft_get_commit_idx(_raft);
+}
+
+int RaftConsensus::getLastAppliedIndex()
+{
+  OSS::mutex_lock lock(_raftMutex);
+  return raft_get_last_applied_idx(_raft);
+}
+
+int RaftConsensus::getCurrentIndex()
+{
+  OSS::mutex_lock lock(_raftMutex);
+  return raft_get_current_idx(_raft);
+}
   
 void RaftConsensus::callPeriodicTimer()
 {
-  OSS::mutex_lock lock(_raftMutex);
-  raft_periodic(_raft, _opt.periodic_timer_ms);
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    raft_periodic(_raft, _opt.periodic_timer_ms);
+    applyCommitted();
+  }
+  dispatchOutbound();
 }
 
 void RaftConsensus::onTerminate()
@@ -318,9 +518,253 @@ void RaftConsensus::main()
 }
 
 void RaftConsensus::becomeMaster()
+{
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    raft_become_leader(_raft);
+  }
+  dispatchOutbound();
+}
+
+void RaftConsensus::applyCommitted()
+{
+  //
+  // raft_periodic applies a single entry per tick.  Catch up fully.
+  //
+  raft_apply_all(_raft);
+  
+  if (_opt.snapshot_threshold > 0 && 
+    raft_get_last_applied_idx(_raft) - _snapshot.last_idx >= _opt.snapshot_threshold)
+  {
+    createSnapshot();
+  }
+  else if (_snapshot.last_idx > raft_get_log_base_idx(_raft))
+  {
+    compactLog();
+  }
+}
+
+bool RaftConsensus::createSnapshot()
+{
+  int lastApplied = raft_get_last_applied_idx(_raft);
+  if (lastApplied <= _snapshot.last_idx)
+  {
+    return false;
+  }
+  
+  RaftSnapshot snapshot;
+  snapshot.last_idx = lastApplied;
+  snapshot.last_term = raft_get_log_term_at_idx(_raft, lastApplied);
+  if (!onCreateSnapshot(snapshot.data))
+  {
+    return false;
+  }
+  
+  if (_logStore.isOpen() && !_logStore.saveSnapshot(snapshot))
+  {
+    OSS_LOG_ERROR("RaftConsensus::createSnapshot - Unable to store snapshot at index " << lastApplied);
+    return false;
+  }
+  
+  _snapshot = snapshot;
+  compactLog();
+  return true;
+}
+
+void RaftConsensus::compactLog()
+{
+  //
+  // The leader keeps the entries its peers have not acknowledged yet so a
+  // peer that lags a little is caught up from the log instead of a snapshot
+  //
+  int limit = _snapshot.last_idx;
+  if (raft_is_leader(_raft))
+  {
+    for (Nodes::iterator iter = _nodes.begin(); iter != _nodes.end(); iter++)
+    {
+      if (iter->first != _opt.node_id && iter->second.getMatchIndex() < limit)
+      {
+        limit = iter->second.getMatchIndex();
+      }
+    }
+  }
+  
+  while (raft_get_log_base_idx(_raft) < limit && raft_poll_entry(_raft) == 0);
+}
+
+int RaftConsensus::queueRequestVote(Node& node, msg_requestvote_t& data)
+{
+  Outbound outbound;
+  outbound.type = OUTBOUND_REQUEST_VOTE;
+  outbound.node = node;
+  outbound.requestVote = data;
+  _outbound.push_back(outbound);
+  return 0;
+}
+
+int RaftConsensus::queueAppendEntries(Node& node)
+{
+  if (_suppressAppends)
+  {
+    return 0;
+  }
+  
+  Connection::Ptr pConnection = findOrCreateConnection(node);
+  if (!pConnection)
+  {
+    return -1;
+  }
+  
+  //
+  // Entries are sent ahead of the acknowledgements up to the inflight limit.
+  // When a peer rejects a message the pipeline restarts from the peer next
+  // index which libraft has already moved back.
+  //
+  Peer& peer = _peers[node.getId()];
+  int nextIdx = node.getNextIndex();
+  if (peer.inflight == 0 || peer.next_send_idx < nextIdx)
+  {
+    peer.next_send_idx = nextIdx;
+    peer.inflight = 0;
+  }
+  
+  Outbound outbound;
+  outbound.node = node;
+  outbound.pConnection = pConnection;
+  
+  if (peer.next_send_idx - 1 < raft_get_log_base_idx(_raft))
+  {
+    if (peer.inflight > 0)
+    {
+      return 0;
+    }
+    outbound.type = OUTBOUND_SNAPSHOT;
+    outbound.snapshot = _snapshot;
+    outbound.snapshot.term = raft_get_current_term(_raft);
+    peer.next_send_idx = _snapshot.last_idx + 1;
+    peer.inflight++;
+    _outbound.push_back(outbound);
+    return 0;
+  }
+  
+  int count = 0;
+  if (peer.inflight < _opt.max_inflight_appends)
+  {
+    count = raft_get_current_idx(_raft) - peer.next_send_idx + 1;
+    if (count > _opt.max_entries_per_append)
+    {
+      count = _opt.max_entries_per_append;
+    }
+    else if (count < 0)
+    {
+      count = 0;
+    }
+  }
+  
+  //
+  // Acknowledgements only trigger messages that carry new entries.
+  // Heartbeats are left to the periodic timer.
+  //
+  if (count == 0 && _ackInProgress)
+  {
+    return 0;
+  }
+  
+  outbound.type = OUTBOUND_APPEND_ENTRIES;
+  msg_appendentries_t& ae = outbound.appendEntries;
+  memset(&ae, 0, sizeof(ae));
+  ae.term = raft_get_current_term(_raft);
+  ae.leader_commit = raft_get_commit_idx(_raft);
+  ae.prev_log_idx = peer.next_send_idx - 1;
+  ae.prev_log_term = ae.prev_log_idx > 0 ? raft_get_log_term_at_idx(_raft, ae.prev_log_idx) : 0;
+  ae.n_entries = count;
+  
+  outbound.entries.reserve(count);
+  outbound.payloads.reserve(count);
+  for (int i = 0; i < count; i++)
+  {
+    raft_entry_t* ety = raft_get_entry_from_idx(_raft, peer.next_send_idx + i);
+    outbound.entries.push_back(*ety);
+    outbound.payloads.push_back(std::string((const char*)ety->data.buf, ety->data.buf ? ety->data.len : 0));
+  }
+  
+  if (count > 0)
+  {
+    peer.next_send_idx += count;
+    peer.inflight++;
+  }
+  
+  _outbound.push_back(outbound);
+  return 0;
+}
+
+bool RaftConsensus::hasOutbound()
 {
   OSS::mutex_lock lock(_raftMutex);
-  raft_become_leader(_raft);
+  return !_outbound.empty();
+}
+
+void RaftConsensus::dispatchOutbound()
+{
+  //
+  // Messages are sent without the raft mutex so a slow peer does not stall
+  // the others.  A single dispatcher at a time keeps them in order per peer.
+  // Whoever finds the dispatcher busy leaves its messages to it.
+  //
+  while (true)
+  {
+    {
+      boost::unique_lock<OSS::mutex_critic_sec> dispatchLock(_dispatchMutex, boost::try_to_lock);
+      if (!dispatchLock.owns_lock())
+      {
+        return;
+      }
+      
+      while (true)
+      {
+        OutboundQueue outbound;
+        {
+          OSS::mutex_lock lock(_raftMutex);
+          outbound.swap(_outbound);
+        }
+        
+        if (outbound.empty())
+        {
+          break;
+        }
+        
+        for (OutboundQueue::iterator iter = outbound.begin(); iter != outbound.end(); iter++)
+        {
+          switch (iter->type)
+          {
+          case OUTBOUND_REQUEST_VOTE:
+            onSendRequestVote(iter->node, iter->requestVote);
+            break;
+          case OUTBOUND_APPEND_ENTRIES:
+            for (std::size_t i = 0; i < iter->entries.size(); i++)
+            {
+              iter->entries[i].data.buf = iter->payloads[i].empty() ? 0 : (void*)iter->payloads[i].data();
+            }
+            iter->appendEntries.entries = iter->entries.empty() ? 0 : &iter->entries[0];
+            onSendAppendEntries(iter->node, iter->appendEntries);
+            break;
+          case OUTBOUND_SNAPSHOT:
+            if (iter->pConnection->onSendSnapshot(iter->snapshot) != 0)
+            {
+              OSS_LOG_ERROR("RaftConsensus::dispatchOutbound - Peer " << iter->node.getId() 
+                << " needs a snapshot but the connection does not support snapshot transfer");
+            }
+            break;
+          }
+        }
+      }
+    }
+    
+    if (!hasOutbound())
+    {
+      return;
+    }
+  }
 }
 
 int RaftConsensus::onSendRequestVote(Node& node, msg_requestvote_t& data)
@@ -345,40 +789,165 @@ int RaftConsensus::onSendAppendEntries(Node& node, msg_appendentries_t& data)
 
 int RaftConsensus::onReceivedRequestVote(const Connection::Ptr& pConnection, msg_requestvote_t& data)
 {
-  OSS::mutex_lock lock(_raftMutex);
   int ret = 0;
   msg_requestvote_response_t response;
-  ret = raft_recv_requestvote(_raft, pConnection->getNode().node(), &data, &response);
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    ret = raft_recv_requestvote(_raft, pConnection->getNode().node(), &data, &response);
+  }
   if (ret != 0)
   {
     return ret;
   }
-  return pConnection->onSendRequestVoteResponse(response);
+  ret = pConnection->onSendRequestVoteResponse(response);
+  dispatchOutbound();
+  return ret;
 }
 
 int RaftConsensus::onReceivedAppendEntries(const Connection::Ptr& pConnection, msg_appendentries_t& data)
 {
-  OSS::mutex_lock lock(_raftMutex);
+  msg_appendentries_response_t response;
+  memset(&response, 0, sizeof(response));
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    
+    //
+    // The entries of the message are made durable in one transaction
+    // before the response goes out
+    //
+    bool batch = data.n_entries > 0 && _logStore.isOpen();
+    if (batch)
+    {
+      _logStore.beginBatch();
+    }
+    raft_recv_appendentries(_raft, pConnection->getNode().node(), &data, &response);
+    if (batch && !_logStore.endBatch())
+    {
+      response.success = 0;
+      response.current_idx = raft_get_commit_idx(_raft);
+    }
+    applyCommitted();
+  }
   
-  int ret = 0;
+  //
+  // Rejections are answered too so the leader can step back
+  //
+  int ret = pConnection->onSendAppendEntriesResponse(response);
+  dispatchOutbound();
+  return ret;
+}
+
+int RaftConsensus::onReceivedSnapshot(const Connection::Ptr& pConnection, RaftSnapshot& snapshot)
+{
   msg_appendentries_response_t response;
-  ret = raft_recv_appendentries(_raft, pConnection->getNode().node(), &data, &response);
-  if (ret != 0)
+  memset(&response, 0, sizeof(response));
   {
-    return ret;
+    OSS::mutex_lock lock(_raftMutex);
+    
+    raft_set_current_term(_raft, snapshot.term);
+    response.term = raft_get_current_term(_raft);
+    response.current_idx = raft_get_current_idx(_raft);
+    
+    if (snapshot.term < response.term)
+    {
+      response.success = 0;
+    }
+    else if (snapshot.last_idx <= raft_get_commit_idx(_raft))
+    {
+      //
+      // We already have everything the snapshot covers
+      //
+      response.success = 1;
+      response.current_idx = snapshot.last_idx;
+      response.first_idx = snapshot.last_idx;
+    }
+    else if (!onRestoreSnapshot(snapshot.data))
+    {
+      OSS_LOG_ERROR("RaftConsensus::onReceivedSnapshot - Unable to restore snapshot at index " << snapshot.last_idx);
+      response.success = 0;
+    }
+    else
+    {
+      if (_logStore.isOpen())
+      {
+        _logStore.beginBatch();
+        raft_load_snapshot(_raft, snapshot.last_idx, snapshot.last_term);
+        bool saved = _logStore.saveSnapshot(snapshot);
+        if (!_logStore.endBatch() || !saved)
+        {
+          OSS_LOG_ERROR("RaftConsensus::onReceivedSnapshot - Unable to store snapshot at index " << snapshot.last_idx);
+        }
+      }
+      else
+      {
+        raft_load_snapshot(_raft, snapshot.last_idx, snapshot.last_term);
+      }
+      _snapshot = snapshot;
+      
+      //
+      // Accept an empty append entries positioned at the snapshot to
+      // reset the election timer and learn the leader
+      //
+      msg_appendentries_t ae;
+      memset(&ae, 0, sizeof(ae));
+      ae.term = snapshot.term;
+      ae.prev_log_idx = snapshot.last_idx;
+      ae.prev_log_term = snapshot.last_term;
+      ae.leader_commit = snapshot.last_idx;
+      raft_recv_appendentries(_raft, pConnection->getNode().node(), &ae, &response);
+      response.first_idx = snapshot.last_idx;
+    }
   }
-  return pConnection->onSendAppendEntriesResponse(response);
+  
+  int ret = pConnection->onSendAppendEntriesResponse(response);
+  dispatchOutbound();
+  return ret;
 }
 
 int RaftConsensus::onReceivedRequestVoteResponse(const Connection::Ptr& pConnection, msg_requestvote_response_t& data)
 {
-  OSS::mutex_lock lock(_raftMutex);
-  return raft_recv_requestvote_response(_raft, pConnection->getNode().node(), &data);
+  int ret = 0;
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    ret = raft_recv_requestvote_response(_raft, pConnection->getNode().node(), &data);
+  }
+  dispatchOutbound();
+  return ret;
 }
+
 int RaftConsensus::onReceivedAppendEntriesResponse(const Connection::Ptr& pConnection, msg_appendentries_response_t& data)
 {
-  OSS::mutex_lock lock(_raftMutex);
-  return raft_recv_appendentries_response(_raft, pConnection->getNode().node(), &data);
+  int ret = 0;
+  {
+    OSS::mutex_lock lock(_raftMutex);
+    Node& node = pConnection->getNode();
+    Peer& peer = _peers[node.getId()];
+    
+    if (!data.success)
+    {
+      peer.inflight = 0;
+      peer.next_send_idx = 0;
+    }
+    else if (data.first_idx <= data.current_idx && peer.inflight > 0)
+    {
+      peer.inflight--;
+    }
+    
+    _ackInProgress = true;
+    ret = raft_recv_appendentries_response(_raft, node.node(), &data);
+    if (raft_is_leader(_raft))
+    {
+      //
+      // Keep the pipeline full
+      //
+      queueAppendEntries(node);
+    }
+    _ackInProgress = false;
+    
+    applyCommitted();
+  }
+  dispatchOutbound();
+  return ret;
 }
 
 int RaftConsensus::onApplyEntry(const raft_entry_t& entry)
@@ -388,16 +957,46 @@ int RaftConsensus::onApplyEntry(const raft_entry_t& entry)
 
 int RaftConsensus::onAppendEntry(const raft_entry_t& entry, int index)
 {
+  if (_logStore.isOpen() && !_logStore.appendEntry(index, entry))
+  {
+    return -1;
+  }
+  return 0;
+}
+
+int RaftConsensus::onPopEntry(const raft_entry_t& entry, int index)
+{
+  if (_logStore.isOpen() && !_logStore.removeEntry(index))
+  {
+    return -1;
+  }
+  return 0;
+}
+
+int RaftConsensus::onPollEntry(const raft_entry_t& entry, int index)
+{
+  //
+  // Polled entries are covered by the snapshot which already
+  // removed them from the log store
+  //
   return 0;
 }
 
 int RaftConsensus::onPersistVote(int vote)
 {
+  if (_logStore.isOpen() && !_logStore.setVote(vote))
+  {
+    return -1;
+  }
   return 0;
 }
 
 int RaftConsensus::onPersistTerm(int vote)
 {
+  if (_logStore.isOpen() && !_logStore.setTerm(vote))
+  {
+    return -1;
+  }
   return 0;
 }
 
@@ -405,6 +1004,16 @@ void RaftConsensus::onSufficientLogs(Node& node)
 {
 }
 
+bool RaftConsensus::onCreateSnapshot(std::string& data)
+{
+  return false;
+}
+
+bool RaftConsensus::onRestoreSnapshot(const std::string& data)
+{
+  return true;
+}
+
 
 RaftConsensus::Connection::Ptr RaftConsensus::findConnection(int id)
 {
@@ -453,4 +1062,3 @@ void RaftConsensus::removeConnection(int id)
 
 } } // OSS::RAFT
 
-
@@ -0,0 +1,466 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include "OSS/RAFT/RaftLogStore.h"
+#include "OSS/UTL/Logger.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace OSS {
+namespace RAFT {
+
+
+static const char* LOG_STORE_NAME = "raft-log";
+static const char* LOG_KEY_PREFIX = "log.";
+static const std::size_t LOG_KEY_PREFIX_LEN = 4;
+static const char* TERM_KEY = "term";
+static const char* VOTE_KEY = "vote";
+static const char* SNAPSHOT_KEY = "snapshot";
+static const std::size_t ENTRY_HEADER_LEN = 3 * sizeof(int32_t);
+static const std::size_t SNAPSHOT_HEADER_LEN = 2 * sizeof(int32_t);
+
+typedef LMDB::LMDatabase::Transaction Transaction;
+
+
+static void encode_entry(const raft_entry_t& entry, std::string& value)
+{
+  int32_t header[3];
+  header[0] = (int32_t)entry.term;
+  header[1] = (int32_t)entry.id;
+  header[2] = (int32_t)entry.type;
+  value.reserve(ENTRY_HEADER_LEN + entry.data.len);
+  value.assign((const char*)header, ENTRY_HEADER_LEN);
+  if (entry.data.buf && entry.data.len)
+  {
+    value.append((const char*)entry.data.buf, entry.data.len);
+  }
+}
+
+static bool decode_entry(const std::string& value, RaftLogStore::Entry& entry)
+{
+  if (value.size() < ENTRY_HEADER_LEN)
+  {
+    return false;
+  }
+  int32_t header[3];
+  memcpy(header, value.data(), ENTRY_HEADER_LEN);
+  entry.term = (unsigned int)header[0];
+  entry.id = (unsigned int)header[1];
+  entry.type = (int)header[2];
+  entry.data = value.substr(ENTRY_HEADER_LEN);
+  return true;
+}
+
+static bool parse_entry_key(const std::string& key, int& index)
+{
+  if (key.size() <= LOG_KEY_PREFIX_LEN || key.compare(0, LOG_KEY_PREFIX_LEN, LOG_KEY_PREFIX) != 0)
+  {
+    return false;
+  }
+  index = atoi(key.c_str() + LOG_KEY_PREFIX_LEN);
+  return index > 0;
+}
+
+
+RaftLogStore::RaftLogStore() :
+  _pDb(0),
+  _pBatch(0),
+  _batchDepth(0),
+  _batchFailed(false)
+{
+}
+
+RaftLogStore::~RaftLogStore()
+{
+  close();
+}
+
+bool RaftLogStore::open(const std::string& path)
+{
+  OSS::mutex_lock lock(_mutex);
+  if (_pDb)
+  {
+    return true;
+  }
+
+  LMDB::LMDatabase::Options opt;
+  opt.name = LOG_STORE_NAME;
+  opt.path = path;
+
+  _pDb = new LMDB::LMDatabase();
+  if (!_pDb->initialize(opt))
+  {
+    OSS_LOG_ERROR("RaftLogStore::open - Unable to open log store at " << path);
+    delete _pDb;
+    _pDb = 0;
+    return false;
+  }
+  return true;
+}
+
+void RaftLogStore::close()
+{
+  OSS::mutex_lock lock(_mutex);
+  if (!_pDb)
+  {
+    return;
+  }
+
+  while (_batchDepth > 0)
+  {
+    endBatch();
+  }
+
+  delete _pDb;
+  _pDb = 0;
+}
+
+bool RaftLogStore::beginBatch()
+{
+  //
+  // The store mutex is held for the life of the batch so that writes
+  // from other threads do not end up in, or wait on, this transaction
+  //
+  _mutex.lock();
+  if (!_pDb)
+  {
+    _mutex.unlock();
+    return false;
+  }
+
+  if (_batchDepth++ == 0)
+  {
+    _pBatch = new Transaction(_pDb);
+    _batchFailed = false;
+    if (!_pBatch->begin())
+    {
+      delete _pBatch;
+      _pBatch = 0;
+      _batchFailed = true;
+    }
+  }
+  return !_batchFailed;
+}
+
+bool RaftLogStore::endBatch()
+{
+  bool ok = true;
+  if (_batchDepth == 0)
+  {
+    return false;
+  }
+
+  if (--_batchDepth == 0)
+  {
+    if (_pBatch)
+    {
+      if (_batchFailed || _pBatch->cancelAdvised())
+      {
+        _pBatch->cancel();
+        ok = false;
+      }
+      else
+      {
+        ok = _pBatch->end();
+      }
+      delete _pBatch;
+      _pBatch = 0;
+    }
+    else
+    {
+      ok = false;
+    }
+
+    if (!ok)
+    {
+      OSS_LOG_ERROR("RaftLogStore::endBatch - Unable to commit batch to the log store");
+    }
+  }
+  else
+  {
+    ok = !_batchFailed;
+  }
+
+  _mutex.unlock();
+  return ok;
+}
+
+std::string RaftLogStore::entryKey(int index)
+{
+  char key[32];
+  snprintf(key, sizeof(key), "%s%010d", LOG_KEY_PREFIX, index);
+  return key;
+}
+
+bool RaftLogStore::write(const std::string& key, const std::string& value)
+{
+  OSS::mutex_lock lock(_mutex);
+  if (!_pDb)
+  {
+    return false;
+  }
+
+  if (_pBatch)
+  {
+    if (!_pDb->set(*_pBatch, key, value))
+    {
+      _batchFailed = true;
+      return false;
+    }
+    return true;
+  }
+
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+  {
+    return false;
+  }
+  if (!_pDb->set(transaction, key, value))
+  {
+    transaction.cancel();
+    return false;
+  }
+  return transaction.end();
+}
+
+bool RaftLogStore::erase(const std::string& key)
+{
+  OSS::mutex_lock lock(_mutex);
+  if (!_pDb)
+  {
+    return false;
+  }
+
+  //
+  // Deleting a missing key fails the whole transaction so check first
+  //
+  void* data = 0;
+  std::size_t len = 0;
+  if (_pBatch)
+  {
+    if (!_pDb->get(*_pBatch, key, &data, len))
+    {
+      return true;
+    }
+    if (!_pDb->del(*_pBatch, key))
+    {
+      _batchFailed = true;
+      return false;
+    }
+    return true;
+  }
+
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+  {
+    return false;
+  }
+  if (!_pDb->get(transaction, key, &data, len))
+  {
+    transaction.cancel();
+    return true;
+  }
+  if (!_pDb->del(transaction, key))
+  {
+    transaction.cancel();
+    return false;
+  }
+  return transaction.end();
+}
+
+bool RaftLogStore::appendEntry(int index, const raft_entry_t& entry)
+{
+  std::string value;
+  encode_entry(entry, value);
+  return write(entryKey(index), value);
+}
+
+bool RaftLogStore::removeEntry(int index)
+{
+  return erase(entryKey(index));
+}
+
+bool RaftLogStore::setTerm(int term)
+{
+  int32_t value = term;
+  return write(TERM_KEY, std::string((const char*)&value, sizeof(value)));
+}
+
+bool RaftLogStore::setVote(int vote)
+{
+  int32_t value = vote;
+  return write(VOTE_KEY, std::string((const char*)&value, sizeof(value)));
+}
+
+bool RaftLogStore::compact(Transaction& transaction, int lastIndex)
+{
+  std::vector<std::string> keys;
+  LMDB::LMDatabase::Cursor cursor;
+  if (!_pDb->createCursor(transaction, cursor))
+  {
+    return false;
+  }
+
+  int index = 0;
+  for (bool found = cursor.top(); found; found = cursor.next())
+  {
+    if (!parse_entry_key(cursor.key(), index) || index > lastIndex)
+    {
+      break;
+    }
+    keys.push_back(cursor.key());
+  }
+  cursor.destroy();
+
+  for (std::vector<std::string>::const_iterator iter = keys.begin(); iter != keys.end(); iter++)
+  {
+    if (!_pDb->del(transaction, *iter))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RaftLogStore::saveSnapshot(const RaftSnapshot& snapshot)
+{
+  int32_t header[2];
+  header[0] = snapshot.last_idx;
+  header[1] = snapshot.last_term;
+  std::string value((const char*)header, SNAPSHOT_HEADER_LEN);
+  value.append(snapshot.data);
+
+  OSS::mutex_lock lock(_mutex);
+  if (!beginBatch())
+  {
+    endBatch();
+    return false;
+  }
+  if (!_pDb->set(*_pBatch, SNAPSHOT_KEY, value) || !compact(*_pBatch, snapshot.last_idx))
+  {
+    _batchFailed = true;
+  }
+  return endBatch();
+}
+
+bool RaftLogStore::loadSnapshot(RaftSnapshot& snapshot)
+{
+  OSS::mutex_lock lock(_mutex);
+  if (!_pDb)
+  {
+    return false;
+  }
+
+  std::string value;
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+  {
+    return false;
+  }
+  bool found = _pDb->get(transaction, SNAPSHOT_KEY, value);
+  transaction.cancel();
+
+  if (!found || value.size() < SNAPSHOT_HEADER_LEN)
+  {
+    return false;
+  }
+
+  int32_t header[2];
+  memcpy(header, value.data(), SNAPSHOT_HEADER_LEN);
+  snapshot.last_idx = header[0];
+  snapshot.last_term = header[1];
+  snapshot.data = value.substr(SNAPSHOT_HEADER_LEN);
+  return true;
+}
+
+bool RaftLogStore::load(int& term, int& vote, RaftSnapshot& snapshot, Entries& entries)
+{
+  OSS::mutex_lock lock(_mutex);
+  if (!_pDb)
+  {
+    return false;
+  }
+
+  term = 0;
+  vote = -1;
+  snapshot = RaftSnapshot();
+  entries.clear();
+  loadSnapshot(snapshot);
+
+  Transaction transaction(_pDb);
+  if (!transaction.begin())
+  {
+    return false;
+  }
+
+  int32_t value = 0;
+  if (_pDb->get(transaction, TERM_KEY, value))
+  {
+    term = value;
+  }
+  if (_pDb->get(transaction, VOTE_KEY, value))
+  {
+    vote = value;
+  }
+
+  LMDB::LMDatabase::Cursor cursor;
+  if (_pDb->createCursor(transaction, cursor))
+  {
+    int expected = snapshot.last_idx + 1;
+    int index = 0;
+    for (bool found = cursor.top(); found; found = cursor.next())
+    {
+      if (!parse_entry_key(cursor.key(), index))
+      {
+        break;
+      }
+      if (index < expected)
+      {
+        continue;
+      }
+      if (index > expected)
+      {
+        OSS_LOG_ERROR("RaftLogStore::load - Log has a gap after index " << expected - 1 << ".  Ignoring the remaining entries.");
+        break;
+      }
+
+      Entry entry;
+      if (!decode_entry(cursor.value(), entry))
+      {
+        OSS_LOG_ERROR("RaftLogStore::load - Corrupted entry at index " << index);
+        break;
+      }
+      entry.index = index;
+      entries.push_back(entry);
+      expected++;
+    }
+    cursor.destroy();
+  }
+
+  transaction.cancel();
+  return true;
+}
+
+
+} } // OSS::RAFT
+
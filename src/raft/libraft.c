@@ -100,10 +100,11 @@ int log_append_entry(log_t* me_, raft_entry_t* c)
     __raft__ensurecapacity(me);
 
     if (me->cb && me->cb->log_offer)
-        me->cb->log_offer(me->raft, raft_get_udata(me->raft), c, me->back);
+        me->cb->log_offer(me->raft, raft_get_udata(me->raft), c,
+                          me->base + me->count + 1);
     memcpy(&me->entries[me->back], c, sizeof(raft_entry_t));
     me->count++;
-    me->back++;
+    me->back = (me->back + 1) % me->size;
     return 0;
 }
 
@@ -114,7 +115,7 @@ raft_entry_t* log_get_from_idx(log_t* me_, int idx, int *n_etys)
 
     assert(0 <= idx - 1);
 
-    if (me->base + me->count < idx || idx < me->base)
+    if (me->base + me->count < idx || idx <= me->base)
     {
         *n_etys = 0;
         return NULL;
@@ -143,7 +144,7 @@ raft_entry_t* log_get_at_idx(log_t* me_, int idx)
 
     assert(0 <= idx - 1);
 
-    if (me->base + me->count < idx || idx < me->base)
+    if (me->base + me->count < idx || idx <= me->base)
         return NULL;
 
     /* idx starts at 1 */
@@ -170,10 +171,11 @@ void log_delete(log_t* me_, int idx)
 
     for (end = log_count(me_); idx < end; idx++)
     {
+        int back = (me->back + me->size - 1) % me->size;
         if (me->cb && me->cb->log_pop)
             me->cb->log_pop(me->raft, raft_get_udata(me->raft),
-                            &me->entries[me->back - 1], me->back);
-        me->back--;
+                            &me->entries[back], me->base + me->count);
+        me->back = back;
         me->count--;
     }
 }
@@ -188,13 +190,28 @@ void *log_poll(log_t * me_)
     const void *elem = &me->entries[me->front];
     if (me->cb && me->cb->log_poll)
         me->cb->log_poll(me->raft, raft_get_udata(me->raft),
-                         &me->entries[me->front], me->front);
-    me->front++;
+                         &me->entries[me->front], me->base + 1);
+    me->front = (me->front + 1) % me->size;
     me->count--;
     me->base++;
     return (void*)elem;
 }
 
+int log_get_base(log_t* me_)
+{
+    return ((log_private_t*)me_)->base;
+}
+
+void log_set_base(log_t* me_, int base)
+{
+    log_private_t* me = (log_private_t*)me_;
+
+    assert(0 == me->count);
+    me->front = 0;
+    me->back = 0;
+    me->base = base;
+}
+
 raft_entry_t *log_peektail(log_t * me_)
 {
     log_private_t* me = (log_private_t*)me_;
@@ -431,7 +448,11 @@ void raft_set_callbacks(raft_server_t* me_, raft_cbs_t* funcs, void* udata)
 void raft_free(raft_server_t* me_)
 {
     raft_server_private_t* me = (raft_server_private_t*)me_;
+    int i;
 
+    for (i = 0; i < me->num_nodes; i++)
+        free(me->nodes[i]);
+    free(me->nodes);
     log_free(me->log);
     free(me_);
 }
@@ -608,8 +629,8 @@ int raft_recv_appendentries_response(raft_server_t* me_,
 
         if (0 < match_idx)
         {
-            raft_entry_t* ety = raft_get_entry_from_idx(me_, match_idx);
-            if (ety->term == me->current_term && point <= match_idx)
+            if (raft_get_log_term_at_idx(me_, match_idx) == me->current_term &&
+                point <= match_idx)
                 votes++;
         }
     }
@@ -670,7 +691,22 @@ int raft_recv_appendentries(
 
     /* Not the first appendentries we've received */
     /* NOTE: the log starts at 1 */
-    if (0 < ae->prev_log_idx)
+    if (0 < ae->prev_log_idx && ae->prev_log_idx < raft_get_log_base_idx(me_))
+    {
+        /* already compacted, so it has been committed */
+        __raft__log(me_, node, "AE prev_idx %d is behind the snapshot", ae->prev_log_idx);
+        goto fail_with_current_idx;
+    }
+    else if (0 < ae->prev_log_idx && ae->prev_log_idx == raft_get_log_base_idx(me_))
+    {
+        if (me->log_base_term != ae->prev_log_term)
+        {
+            __raft__log(me_, node, "AE term doesn't match snapshot term (ie. %d vs %d)",
+                  me->log_base_term, ae->prev_log_term);
+            goto fail_with_current_idx;
+        }
+    }
+    else if (0 < ae->prev_log_idx)
     {
         raft_entry_t* e = raft_get_entry_from_idx(me_, ae->prev_log_idx);
 
@@ -1018,10 +1054,10 @@ int raft_send_appendentries(raft_server_t* me_, raft_node_t* node)
     /* previous log is the log just before the new logs */
     if (1 < next_idx)
     {
-        raft_entry_t* prev_ety = raft_get_entry_from_idx(me_, next_idx - 1);
+        int prev_term = raft_get_log_term_at_idx(me_, next_idx - 1);
         ae.prev_log_idx = next_idx - 1;
-        if (prev_ety)
-            ae.prev_log_term = prev_ety->term;
+        if (0 <= prev_term)
+            ae.prev_log_term = prev_term;
     }
 
     __raft__log(me_, node, "sending appendentries node: ci:%d t:%d lc:%d pli:%d plt:%d",
@@ -1351,9 +1387,64 @@ int raft_get_last_log_term(raft_server_t* me_)
     int current_idx = raft_get_current_idx(me_);
     if (0 < current_idx)
     {
-        raft_entry_t* ety = raft_get_entry_from_idx(me_, current_idx);
-        if (ety)
-            return ety->term;
+        int term = raft_get_log_term_at_idx(me_, current_idx);
+        if (0 <= term)
+            return term;
     }
     return 0;
 }
+
+int raft_get_log_base_idx(raft_server_t* me_)
+{
+    raft_server_private_t* me = (raft_server_private_t*)me_;
+    return log_get_base(me->log);
+}
+
+int raft_get_log_term_at_idx(raft_server_t* me_, int idx)
+{
+    raft_server_private_t* me = (raft_server_private_t*)me_;
+
+    if (0 == idx)
+        return 0;
+    if (idx == log_get_base(me->log))
+        return me->log_base_term;
+
+    raft_entry_t* ety = raft_get_entry_from_idx(me_, idx);
+    if (!ety)
+        return -1;
+    return ety->term;
+}
+
+int raft_poll_entry(raft_server_t* me_)
+{
+    raft_server_private_t* me = (raft_server_private_t*)me_;
+
+    if (0 == log_count(me->log))
+        return -1;
+
+    int idx = log_get_base(me->log) + 1;
+    if (me->last_applied_idx < idx)
+        return -1;
+
+    raft_entry_t* ety = raft_get_entry_from_idx(me_, idx);
+    me->log_base_term = ety->term;
+    log_poll(me->log);
+    return 0;
+}
+
+void raft_load_snapshot(raft_server_t* me_, int last_idx, int last_term)
+{
+    raft_server_private_t* me = (raft_server_private_t*)me_;
+
+    /* the snapshot supersedes every entry we hold */
+    if (0 < log_count(me->log))
+        log_delete(me->log, log_get_base(me->log) + 1);
+
+    log_set_base(me->log, last_idx);
+    me->log_base_term = last_term;
+    if (me->commit_idx < last_idx)
+        me->commit_idx = last_idx;
+    if (me->last_applied_idx < last_idx)
+        me->last_applied_idx = last_idx;
+    me->voting_cfg_change_log_idx = -1;
+}
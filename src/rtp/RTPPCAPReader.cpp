@@ -27,23 +27,39 @@ namespace RTP {
 
 
 RTPPCAPReader::RTPPCAPReader() :
-  _pCap(0)
+  _pCap(0),
+  _linkType(DLT_EN10MB)
 {
 }
 
-RTPPCAPReader::RTPPCAPReader(const std::string& filename)
+RTPPCAPReader::RTPPCAPReader(const std::string& filename) :
+  _pCap(0),
+  _linkType(DLT_EN10MB)
 {
   open(filename);
 }
 
+RTPPCAPReader::~RTPPCAPReader()
+{
+  close();
+}
+
 bool RTPPCAPReader::open(const std::string& filename)
 {
+  close();
   char errbuff[PCAP_ERRBUF_SIZE];
   _pCap = pcap_open_offline(filename.c_str(), errbuff);
+  if (_pCap)
+    _linkType = pcap_datalink(_pCap);
   return !!(_pCap);
 }
 
-
+void RTPPCAPReader::close()
+{
+  if (_pCap)
+    pcap_close(_pCap);
+  _pCap = 0;
+}
 
 bool RTPPCAPReader::read(RTPPacket& packet)
 {
@@ -65,6 +81,154 @@ bool RTPPCAPReader::read(RTPPacket& packet)
   return ret;
 }
 
+bool RTPPCAPReader::readDatagram(Datagram& datagram)
+{
+  if (!_pCap)
+    return false;
+
+  pcap_pkthdr* pHeader = 0;
+  const u_char* pData = 0;
+  while (pcap_next_ex(_pCap, &pHeader, &pData) >= 0)
+  {
+    if (decodeDatagram(_linkType, pData, pHeader->caplen, datagram))
+    {
+      datagram.timestamp = (OSS::UInt64)pHeader->ts.tv_sec * 1000000 + pHeader->ts.tv_usec;
+      return true;
+    }
+  }
+  return false;
+}
+
+static unsigned short read_uint16(const u_char* pData)
+{
+  return (pData[0] << 8) | pData[1];
+}
+
+bool RTPPCAPReader::decodeDatagram(int linkType, const u_char* pData, std::size_t len, Datagram& datagram)
+{
+  const unsigned short ETHERTYPE_IPV4 = 0x0800;
+  const unsigned short ETHERTYPE_IPV6 = 0x86DD;
+  const unsigned short ETHERTYPE_VLAN = 0x8100;
+  const unsigned short ETHERTYPE_QINQ = 0x88A8;
+  const u_char IPPROTO_UDP_NUMBER = 17;
+  const std::size_t UDP_HEADER_LEN = 8;
+
+  //
+  // Link layer
+  //
+  std::size_t offset = 0;
+  unsigned short etherType = 0;
+  switch (linkType)
+  {
+  case DLT_EN10MB:
+    if (len < 14)
+      return false;
+    etherType = read_uint16(pData + 12);
+    offset = 14;
+    while ((etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ) && len >= offset + 4)
+    {
+      etherType = read_uint16(pData + offset + 2);
+      offset += 4;
+    }
+    break;
+  case DLT_LINUX_SLL:
+    if (len < 16)
+      return false;
+    etherType = read_uint16(pData + 14);
+    offset = 16;
+    break;
+  case DLT_NULL:
+  case DLT_LOOP:
+    //
+    // The address family is in host order for DLT_NULL and network order
+    // for DLT_LOOP.  The IP version nibble is checked below instead.
+    //
+    if (len < 5)
+      return false;
+    offset = 4;
+    etherType = (pData[offset] >> 4) == 6 ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4;
+    break;
+  case DLT_RAW:
+#ifdef DLT_IPV4
+  case DLT_IPV4:
+  case DLT_IPV6:
+#endif
+    if (len < 1)
+      return false;
+    etherType = (pData[0] >> 4) == 6 ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4;
+    break;
+  default:
+    return false;
+  }
+
+  //
+  // Network layer
+  //
+  const u_char* pIp = pData + offset;
+  std::size_t ipLen = len - offset;
+  std::size_t udpOffset = 0;
+  if (etherType == ETHERTYPE_IPV4)
+  {
+    if (ipLen < 20 || (pIp[0] >> 4) != 4)
+      return false;
+    std::size_t headerLen = (pIp[0] & 0x0F) * 4;
+    std::size_t totalLen = read_uint16(pIp + 2);
+    unsigned short fragment = read_uint16(pIp + 6);
+    if (pIp[9] != IPPROTO_UDP_NUMBER || (fragment & 0x3FFF) || headerLen < 20 || totalLen < headerLen || totalLen > ipLen)
+      return false;
+    ipLen = totalLen;
+    udpOffset = headerLen;
+
+    boost::asio::ip::address_v4::bytes_type source;
+    boost::asio::ip::address_v4::bytes_type destination;
+    std::copy(pIp + 12, pIp + 16, source.begin());
+    std::copy(pIp + 16, pIp + 20, destination.begin());
+    datagram.source = OSS::Net::IPAddress(boost::asio::ip::address_v4(source));
+    datagram.destination = OSS::Net::IPAddress(boost::asio::ip::address_v4(destination));
+  }
+  else if (etherType == ETHERTYPE_IPV6)
+  {
+    //
+    // Extension headers are not followed
+    //
+    if (ipLen < 40 || (pIp[0] >> 4) != 6 || pIp[6] != IPPROTO_UDP_NUMBER)
+      return false;
+    std::size_t payloadLen = read_uint16(pIp + 4);
+    if (40 + payloadLen > ipLen)
+      return false;
+    ipLen = 40 + payloadLen;
+    udpOffset = 40;
+
+    boost::asio::ip::address_v6::bytes_type source;
+    boost::asio::ip::address_v6::bytes_type destination;
+    std::copy(pIp + 8, pIp + 24, source.begin());
+    std::copy(pIp + 24, pIp + 40, destination.begin());
+    datagram.source = OSS::Net::IPAddress(boost::asio::ip::address_v6(source));
+    datagram.destination = OSS::Net::IPAddress(boost::asio::ip::address_v6(destination));
+  }
+  else
+  {
+    return false;
+  }
+
+  //
+  // Transport layer
+  //
+  if (ipLen < udpOffset + UDP_HEADER_LEN)
+    return false;
+  const u_char* pUdp = pIp + udpOffset;
+  std::size_t udpLen = read_uint16(pUdp + 4);
+  if (udpLen < UDP_HEADER_LEN || udpOffset + udpLen > ipLen)
+    return false;
+
+  datagram.source.setPort(read_uint16(pUdp));
+  datagram.destination.setPort(read_uint16(pUdp + 2));
+  datagram.source.setProtocol(OSS::Net::IPAddress::UDP);
+  datagram.destination.setProtocol(OSS::Net::IPAddress::UDP);
+  datagram.payload.assign((const char*)pUdp + UDP_HEADER_LEN, udpLen - UDP_HEADER_LEN);
+  return true;
+}
+
 
 
 } } // OSS::RTP
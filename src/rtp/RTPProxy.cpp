@@ -21,6 +21,7 @@
 
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
 #include "OSS/RTP/RTPProxy.h"
 #include "OSS/RTP/RTPProxyManager.h"
 #include "OSS/RTP/RTPProxySession.h"
@@ -31,6 +32,15 @@
 namespace OSS {
 namespace RTP {
 
+static OSS::MetricCounter& gLeg1Packets = OSS::Metrics::instance().counter(
+  "rtp_leg1_packets_total", "Packets read on leg 1 of all relays");
+static OSS::MetricCounter& gLeg1Bytes = OSS::Metrics::instance().counter(
+  "rtp_leg1_bytes_total", "Bytes read on leg 1 of all relays");
+static OSS::MetricCounter& gLeg2Packets = OSS::Metrics::instance().counter(
+  "rtp_leg2_packets_total", "Packets read on leg 2 of all relays");
+static OSS::MetricCounter& gLeg2Bytes = OSS::Metrics::instance().counter(
+  "rtp_leg2_bytes_total", "Bytes read on leg 2 of all relays");
+
 RTPProxy::RTPProxy(Type type, RTPProxyManager* pManager, RTPProxySession* pSession, const std::string& identifier, bool isXORDisabled) :
   _identifier(identifier),
   _pManager(pManager),
@@ -230,6 +240,8 @@ void RTPProxy::handleLeg1FrameRead(
     return;
   }
   
+  gLeg1Packets.increment();
+  gLeg1Bytes.increment(bytes_transferred);
   _timeStamp = OSS::getTime();
     
   if (!e && bytes_transferred >= 2)
@@ -487,6 +499,8 @@ void RTPProxy::handleLeg2FrameRead(
     return;
   }
   
+  gLeg2Packets.increment();
+  gLeg2Bytes.increment(bytes_transferred);
   _timeStamp = OSS::getTime();
   
   if (!e && bytes_transferred >= 2)
@@ -19,11 +19,19 @@
 
 #include "OSS/RTP/RTPProxyManager.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
 
 
 namespace OSS {
 namespace RTP {
 
+static OSS::MetricCounter& gSessionsCreated = OSS::Metrics::instance().counter(
+  "rtp_sessions_created_total", "RTP relay sessions created");
+static OSS::MetricCounter& gSessionsRejected = OSS::Metrics::instance().counter(
+  "rtp_sessions_rejected_total", "RTP relay sessions refused because the session limit was reached");
+static OSS::MetricCounter& gSessionsCollected = OSS::Metrics::instance().counter(
+  "rtp_sessions_collected_total", "RTP relay sessions removed after going inactive");
+
 
 RTPProxyManager::RTPProxyManager(int houseKeepingInterval) :
   _ioService(),
@@ -47,6 +55,15 @@ RTPProxyManager::RTPProxyManager(int houseKeepingInterval) :
 RTPProxyManager::~RTPProxyManager()
 {
   stop();
+
+  //
+  // Sessions queue their removal in the state journal when destroyed.  Release
+  // them while the journal and the redis client are still alive.
+  //
+  _sessionListMutex.lock();
+  _sessionList.clear();
+  _sessionListMutex.unlock();
+  _stateJournal.close();
 }
 
 void RTPProxyManager::run(int threadCount, int readTimeout)
@@ -98,6 +115,10 @@ bool RTPProxyManager::redisConnect(const std::vector<Persistent::RedisClient::Co
       _hasRtpDb = true;
     }
   }
+
+  if (_hasRtpDb)
+    _stateJournal.open(&_redisClient);
+
   return _hasRtpDb;
 }
     /// Connect to redis database for state persistence
@@ -108,15 +129,36 @@ void RTPProxyManager::recycleState()
   if (!_persistStateFiles)
     return;
 
-  if (!boost::filesystem::exists(_rtpStateDirectory))
+  //
+  // Sessions persisted through the state journal
+  //
+  RTPProxyStateJournal::Records records;
+  if (_stateJournal.load(records))
   {
-    boost::filesystem::create_directory(_rtpStateDirectory);
-    if (!boost::filesystem::exists(_rtpStateDirectory))
-      return;
+    for (RTPProxyStateJournal::Records::const_iterator iter = records.begin(); iter != records.end(); iter++)
+    {
+      _sessionListMutex.lock();
+      RTPProxySession::Ptr session = RTPProxySession::reconstructFromRecord(this, iter->second);
+      if (session)
+      {
+        _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>(session->getIdentifier(), session));
+      }
+      _sessionListMutex.unlock();
+    }
   }
 
+  //
+  // Sessions persisted individually by earlier versions
+  //
   if (!_hasRtpDb)
   {
+    if (!boost::filesystem::exists(_rtpStateDirectory))
+    {
+      boost::filesystem::create_directory(_rtpStateDirectory);
+      if (!boost::filesystem::exists(_rtpStateDirectory))
+        return;
+    }
+
     try
     {
       boost::filesystem::directory_iterator end_itr; // default construction yields past-the-end
@@ -130,7 +172,11 @@ void RTPProxyManager::recycleState()
         }
         else
         {
-          boost::filesystem::path currentFile = operator/(_rtpStateDirectory, OSS::boost_file_name(itr->path()));
+          std::string fileName = OSS::boost_file_name(itr->path());
+          if (fileName.find(RTPProxyStateJournal::JOURNAL_FILE_NAME) == 0)
+            continue;
+
+          boost::filesystem::path currentFile = operator/(_rtpStateDirectory, fileName);
           if (boost::filesystem::is_regular(currentFile))
           {
 #if ENABLE_FEATURE_CONFIG 
@@ -139,6 +185,8 @@ void RTPProxyManager::recycleState()
             if (session)
             {
               _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>(session->getIdentifier(), session));
+              session->persistState();
+              boost::filesystem::remove(currentFile);
             }
             
             _sessionListMutex.unlock();
@@ -162,11 +210,15 @@ void RTPProxyManager::recycleState()
     _redisClient.getKeys("*", keys);
     for (std::vector<std::string>::iterator iter = keys.begin(); iter != keys.end(); iter++)
     {
+      if (*iter == RTPProxyStateJournal::REDIS_HASH_KEY)
+        continue;
       _sessionListMutex.lock();
       RTPProxySession::Ptr session = RTPProxySession::reconstructFromRedis(this, *iter);
       if (session)
       {
         _sessionList.insert(std::pair<std::string, RTPProxySession::Ptr>(session->getIdentifier(), session));
+        session->persistState();
+        _redisClient.del(*iter);
       }
       _sessionListMutex.unlock();
     }
@@ -252,10 +304,12 @@ void RTPProxyManager::handleSDP(
       if (_sessionList.size() > _rtpSessionMax)
       {
         _sessionListMutex.unlock();
+        gSessionsRejected.increment();
         OSS::log_critical("RTP Proxy Session Max Reached");
         throw RTPProxyTooManySession();
       }
       proxy = RTPProxySession::Ptr(new RTPProxySession(this, sessionId));
+      gSessionsCreated.increment();
       if (!rtpAttribute.callId.empty())
       {
         proxy->callId() = rtpAttribute.callId;
@@ -507,6 +561,7 @@ void RTPProxyManager::collectInactiveSessions()
 
       proxy->stop();
       iter = _sessionList.erase(iter);
+      gSessionsCollected.increment();
     }else if (!proxy)
     {
       iter = _sessionList.erase(iter);
@@ -17,6 +17,7 @@
  */
 
 
+#include <sstream>
 #include <OSS/UTL/CoreUtils.h>
 #include "OSS/RTP/RTPProxyRecord.h"
 
@@ -89,12 +90,8 @@ RTPProxyRecord::RTPProxyRecord()
   fax.control.isLeg2XOREncrypted = false;
 }
 
-#if ENABLE_FEATURE_REDIS
-
-bool RTPProxyRecord::writeToRedis(Persistent::RedisBroadcastClient& client, const std::string& key) const
+void RTPProxyRecord::toJson(json::Object& params) const
 {
-  json::Object params;
-
   params["timestamp"] = json::Number(OSS::getTime());
   // strings
   params["identifier"] = json::String(identifier);
@@ -239,16 +236,10 @@ bool RTPProxyRecord::writeToRedis(Persistent::RedisBroadcastClient& client, cons
     params["fax_data"] = fax_data;
     params["fax_control"] = fax_control;
   }
-
-  return client.set(key, params, 3600 * 12);
 }
 
-bool RTPProxyRecord::readFromRedis(Persistent::RedisBroadcastClient& client, const std::string& key)
+bool RTPProxyRecord::fromJson(json::Object& params)
 {
-  json::Object params;
-  if (!client.get(key, params))
-    return false;
-
   json::Number timestamp_ = params["timestamp"]; timestamp = (OSS::UInt64)timestamp_.Value();
   // strings
   json::String identifier_ = params["identifier"]; identifier = identifier_.Value();
@@ -405,6 +396,56 @@ bool RTPProxyRecord::readFromRedis(Persistent::RedisBroadcastClient& client, con
   return true;
 }
 
+bool RTPProxyRecord::toString(std::string& buff) const
+{
+  try
+  {
+    json::Object params;
+    toJson(params);
+    std::ostringstream strm;
+    json::Writer::Write(params, strm);
+    buff = strm.str();
+    return true;
+  }
+  catch(std::exception& error)
+  {
+    return false;
+  }
+}
+
+bool RTPProxyRecord::fromString(const std::string& buff)
+{
+  try
+  {
+    json::Object params;
+    std::stringstream strm;
+    strm << buff;
+    json::Reader::Read(params, strm);
+    return fromJson(params);
+  }
+  catch(std::exception& error)
+  {
+    return false;
+  }
+}
+
+#if ENABLE_FEATURE_REDIS
+
+bool RTPProxyRecord::writeToRedis(Persistent::RedisBroadcastClient& client, const std::string& key) const
+{
+  json::Object params;
+  toJson(params);
+  return client.set(key, params, 3600 * 12);
+}
+
+bool RTPProxyRecord::readFromRedis(Persistent::RedisBroadcastClient& client, const std::string& key)
+{
+  json::Object params;
+  if (!client.get(key, params))
+    return false;
+  return fromJson(params);
+}
+
 #endif // OSS_HAVE_HIREDIS
 
 
@@ -84,19 +84,7 @@ RTPProxySession::RTPProxySession(RTPProxyManager* pManager, const std::string& i
 RTPProxySession::~RTPProxySession()
 {
   stop();
-
-#if ENABLE_FEATURE_CONFIG
-  if (!_pManager->hasRtpDb() && _pManager->persistStateFiles())
-  {
-    ClassType::remove(_stateFile);
-  }
-#endif
-#if ENABLE_FEATURE_REDIS
-  else if (_pManager->hasRtpDb())
-  {
-    _pManager->redisClient().del(_identifier);
-  }
-#endif
+  _pManager->stateJournal().remove(_identifier);
 }
 
 void RTPProxySession::stop()
@@ -1059,9 +1047,7 @@ void RTPProxySession::handleInitialSDPAnswer(
   if (_hasOfferedAudioProxy || _hasOfferedVideoProxy || _hasOfferedFaxProxy)
   {
     sdp = offer.toString();
-#if ENABLE_FEATURE_CONFIG
-    dumpStateFile();
-#endif
+    persistState();
   }
   else
   {
@@ -1802,17 +1788,12 @@ void RTPProxySession::handleSDPAnswer(
   if (_hasOfferedAudioProxy || _hasOfferedVideoProxy || _hasOfferedFaxProxy)
   {
     sdp = offer.toString();
-#if ENABLE_FEATURE_CONFIG 
-    dumpStateFile();
-#endif
+    persistState();
   }
 }
 
-#if ENABLE_FEATURE_REDIS
-void RTPProxySession::dumpStateToRedis()
+void RTPProxySession::captureState(RTPProxyRecord& record)
 {
-  RTPProxyRecord record;
-  
   record.identifier = _identifier.c_str();
   record.logId = _logId.c_str();
   record.leg1Identifier = _leg1Identifier.c_str();
@@ -2058,581 +2039,265 @@ void RTPProxySession::dumpStateToRedis()
       record.fax.control.isLeg2XOREncrypted = fax_control._isLeg2XOREncrypted;
     }
   }
-  
-  record.writeToRedis(_pManager->redisClient(), _identifier);
 }
-#endif
 
-#if ENABLE_FEATURE_CONFIG
-void RTPProxySession::dumpStateFile()
+void RTPProxySession::persistState()
 {
-  //
-  // Check if we will be using redis
-  //
-#if ENABLE_FEATURE_REDIS
-  if (_pManager->hasRtpDb())
-  {
-    dumpStateToRedis();
-    return;
-  }
-#endif
-  //
-  // Check if the manager allows persistence of state files to the disc
-  //
-  if (!_pManager->persistStateFiles())
+  RTPProxyStateJournal& journal = _pManager->stateJournal();
+  if (!journal.isOpen())
     return;
 
-  ClassType persistent;
-  DataType root = persistent.self();
-
-  DataType identifier = root.addGroupElement("identifier", DataType::TypeString);
-  identifier = _identifier.c_str();
-
-  DataType logId = root.addGroupElement("logId", DataType::TypeString);
-  logId = _logId.c_str();
-
-  DataType leg1Identifier = root.addGroupElement("leg1Identifier", DataType::TypeString);
-  leg1Identifier = _leg1Identifier.c_str();
+  RTPProxyRecord record;
+  captureState(record);
+  journal.update(record);
+}
 
-  DataType leg2Identifier = root.addGroupElement("leg2Identifier", DataType::TypeString);
-  leg2Identifier = _leg2Identifier.c_str();
+RTPProxySession::Ptr RTPProxySession::reconstructFromRecord(RTPProxyManager* pManager, const RTPProxyRecord& record)
+{
+  RTPProxySession* pSession = new RTPProxySession(pManager, record.identifier);
+  pSession->_logId = record.logId;
+  pSession->_leg1Identifier = record.leg1Identifier;
+  pSession->_leg2Identifier = record.leg2Identifier;
+  pSession->_leg1OriginAddress = record.leg1OriginAddress;
+  pSession->_leg2OriginAddress = record.leg2OriginAddress;
+  pSession->_lastSDPInAck = record.lastSDPInAck;
+  pSession->_isExpectingInitialAnswer = record.isExpectingInitialAnswer;
+  pSession->_hasOfferedAudioProxy = record.hasOfferedAudioProxy;
+  pSession->_hasOfferedVideoProxy = record.hasOfferedVideoProxy;
+  pSession->_hasOfferedFaxProxy = record.hasOfferedFaxProxy;
+  pSession->_isAudioProxyNegotiated = record.isAudioProxyNegotiated;
+  pSession->_isVideoProxyNegotiated = record.isVideoProxyNegotiated;
+  pSession->_isFaxProxyNegotiated = record.isFaxProxyNegotiated;
+  pSession->_verbose = record.verbose;
+  pSession->_state = (State)record.state;
+  pSession->_lastOfferIndex  = record.lastOfferIndex;
   
-  DataType leg1OriginAddress = root.addGroupElement("leg1OriginAddress", DataType::TypeString);
-  leg1OriginAddress = _leg1OriginAddress.c_str();
-
-  DataType leg2OriginAddress = root.addGroupElement("leg2OriginAddress", DataType::TypeString);
-  leg2OriginAddress = _leg2OriginAddress.c_str();
-
-  DataType lastSDPInAck = root.addGroupElement("lastSDPInAck", DataType::TypeString);
-  lastSDPInAck = _lastSDPInAck.c_str();
-
-  DataType isExpectingInitialAnswer = root.addGroupElement("isExpectingInitialAnswer", DataType::TypeBoolean);
-  isExpectingInitialAnswer = _isExpectingInitialAnswer;
-
-  DataType hasOfferedAudioProxy = root.addGroupElement("hasOfferedAudioProxy", DataType::TypeBoolean);
-  hasOfferedAudioProxy = _hasOfferedAudioProxy;
-
-  DataType hasOfferedVideoProxy = root.addGroupElement("hasOfferedVideoProxy", DataType::TypeBoolean);
-  hasOfferedVideoProxy = _hasOfferedVideoProxy;
-
-  DataType hasOfferedFaxProxy = root.addGroupElement("hasOfferedFaxProxy", DataType::TypeBoolean);
-  hasOfferedFaxProxy = _hasOfferedFaxProxy;
-
-  DataType isAudioProxyNegotiated = root.addGroupElement("isAudioProxyNegotiated", DataType::TypeBoolean);
-  isAudioProxyNegotiated = _isAudioProxyNegotiated;
-
-  DataType isVideoProxyNegotiated = root.addGroupElement("isVideoProxyNegotiated", DataType::TypeBoolean);
-  isVideoProxyNegotiated = _isVideoProxyNegotiated;
-
-  DataType isFaxProxyNegotiated = root.addGroupElement("isFaxProxyNegotiated", DataType::TypeBoolean);
-  isFaxProxyNegotiated = _isFaxProxyNegotiated;
-
-  DataType verbose = root.addGroupElement("verbose", DataType::TypeBoolean);
-  verbose = _verbose;
-
-  DataType state = root.addGroupElement("state", DataType::TypeInt);
-  state = _state;
-
-  DataType lastOfferIndex  = root.addGroupElement("lastOfferIndex", DataType::TypeInt);
-  lastOfferIndex = _lastOfferIndex;
-
-  if (_hasOfferedAudioProxy)
+  if (pSession->_hasOfferedAudioProxy)
   {
-    DataType audio = root.addGroupElement("audio", DataType::TypeGroup);
-    DataType data = audio.addGroupElement("data", DataType::TypeGroup);
+    pSession->_audio.data()._identifier = record.audio.data.identifier;
     {
-      RTPProxy& proxy = _audio.data();
-      DataType identifier = data.addGroupElement("identifier", DataType::TypeString);
-      identifier = proxy._identifier.c_str();
-
-      DataType localEndPointLeg1 = data.addGroupElement("localEndPointLeg1", DataType::TypeString);
-      std::ostringstream localEp1Strm;
-      localEp1Strm << proxy._localEndPointLeg1.address().to_string() << ":" << proxy._localEndPointLeg1.port();
-      localEndPointLeg1 = localEp1Strm.str().c_str();
-
-      DataType localEndPointLeg2 = data.addGroupElement("localEndPointLeg2", DataType::TypeString);
-      std::ostringstream localEp2Strm;
-      localEp2Strm << proxy._localEndPointLeg2.address().to_string() << ":" << proxy._localEndPointLeg2.port();
-      localEndPointLeg2 = localEp2Strm.str().c_str();
-
-      DataType senderEndPointLeg1 = data.addGroupElement("senderEndPointLeg1", DataType::TypeString);
-      std::ostringstream senderEp1Strm;
-      senderEp1Strm << proxy._senderEndPointLeg1.address().to_string() << ":" << proxy._senderEndPointLeg1.port();
-      senderEndPointLeg1 = senderEp1Strm.str().c_str();
-
-      DataType senderEndPointLeg2 = data.addGroupElement("senderEndPointLeg2", DataType::TypeString);
-      std::ostringstream senderEp2Strm;
-      senderEp2Strm << proxy._senderEndPointLeg2.address().to_string() << ":" << proxy._senderEndPointLeg2.port();
-      senderEndPointLeg2 = senderEp2Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg1 = data.addGroupElement("lastSenderEndPointLeg1", DataType::TypeString);
-      std::ostringstream lastSenderEp1Strm;
-      lastSenderEp1Strm << proxy._lastSenderEndPointLeg1.address().to_string() << ":" << proxy._lastSenderEndPointLeg1.port();
-      lastSenderEndPointLeg1 = lastSenderEp1Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg2 = data.addGroupElement("lastSenderEndPointLeg2", DataType::TypeString);
-      std::ostringstream lastSenderEp2Strm;
-      lastSenderEp2Strm << proxy._lastSenderEndPointLeg2.address().to_string() << ":" << proxy._lastSenderEndPointLeg2.port();
-      lastSenderEndPointLeg2 = lastSenderEp2Strm.str().c_str();
-
-
-      DataType adjustSenderFromPacketSource = data.addGroupElement("adjustSenderFromPacketSource", DataType::TypeBoolean);
-      adjustSenderFromPacketSource = proxy._adjustSenderFromPacketSource;
-
-      DataType leg1Reset = data.addGroupElement("leg1Reset", DataType::TypeBoolean);
-      leg1Reset = proxy._leg1Reset;
-
-      DataType leg2Reset = data.addGroupElement("leg2Reset", DataType::TypeBoolean);
-      leg2Reset = proxy._leg2Reset;
-
-      DataType isStarted = data.addGroupElement("isStarted", DataType::TypeBoolean);
-      isStarted = proxy._isStarted;
-
-      DataType isInactive = data.addGroupElement("isInactive", DataType::TypeBoolean);
-      isInactive = proxy._isInactive;
-
-      DataType isLeg1XOREncrypted = data.addGroupElement("isLeg1XOREncrypted", DataType::TypeBoolean);
-      isLeg1XOREncrypted = proxy._isLeg1XOREncrypted;
-
-      DataType isLeg2XOREncrypted = data.addGroupElement("isLeg2XOREncrypted", DataType::TypeBoolean);
-      isLeg2XOREncrypted = proxy._isLeg2XOREncrypted;
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg2.c_str());
+
+      pSession->_audio.data()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_audio.data()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_audio.data()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_audio.data()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_audio.data()._adjustSenderFromPacketSource = record.audio.data.adjustSenderFromPacketSource;
+      pSession->_audio.data()._leg1Reset = record.audio.data.leg1Reset;
+      pSession->_audio.data()._leg2Reset = record.audio.data.leg2Reset;
+      pSession->_audio.data()._isStarted = record.audio.data.isStarted;
+      pSession->_audio.data()._isInactive = record.audio.data.isInactive;
+      pSession->_audio.data()._isLeg1XOREncrypted = record.audio.data.isLeg1XOREncrypted;
+      pSession->_audio.data()._isLeg2XOREncrypted = record.audio.data.isLeg2XOREncrypted;
+      if (!pSession->_audio.data().open(localEndPointLeg1, localEndPointLeg2))
+      {
+        delete pSession;
+        return RTPProxySession::Ptr();
+      }
+      pSession->_audio.data().start();
     }
 
-    DataType control = audio.addGroupElement("control", DataType::TypeGroup);
+    pSession->_audio.control()._identifier = record.audio.control.identifier;
     {
-      RTPProxy& proxy = _audio.control();
-      DataType identifier = control.addGroupElement("identifier", DataType::TypeString);
-      identifier = proxy._identifier.c_str();
-
-      DataType localEndPointLeg1 = control.addGroupElement("localEndPointLeg1", DataType::TypeString);
-      std::ostringstream localEp1Strm;
-      localEp1Strm << proxy._localEndPointLeg1.address().to_string() << ":" << proxy._localEndPointLeg1.port();
-      localEndPointLeg1 = localEp1Strm.str().c_str();
-
-      DataType localEndPointLeg2 = control.addGroupElement("localEndPointLeg2", DataType::TypeString);
-      std::ostringstream localEp2Strm;
-      localEp2Strm << proxy._localEndPointLeg2.address().to_string() << ":" << proxy._localEndPointLeg2.port();
-      localEndPointLeg2 = localEp2Strm.str().c_str();
-
-      DataType senderEndPointLeg1 = control.addGroupElement("senderEndPointLeg1", DataType::TypeString);
-      std::ostringstream senderEp1Strm;
-      senderEp1Strm << proxy._senderEndPointLeg1.address().to_string() << ":" << proxy._senderEndPointLeg1.port();
-      senderEndPointLeg1 = senderEp1Strm.str().c_str();
-
-      DataType senderEndPointLeg2 = control.addGroupElement("senderEndPointLeg2", DataType::TypeString);
-      std::ostringstream senderEp2Strm;
-      senderEp2Strm << proxy._senderEndPointLeg2.address().to_string() << ":" << proxy._senderEndPointLeg2.port();
-      senderEndPointLeg2 = senderEp2Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg1 = control.addGroupElement("lastSenderEndPointLeg1", DataType::TypeString);
-      std::ostringstream lastSenderEp1Strm;
-      lastSenderEp1Strm << proxy._lastSenderEndPointLeg1.address().to_string() << ":" << proxy._lastSenderEndPointLeg1.port();
-      lastSenderEndPointLeg1 = lastSenderEp1Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg2 = control.addGroupElement("lastSenderEndPointLeg2", DataType::TypeString);
-      std::ostringstream lastSenderEp2Strm;
-      lastSenderEp2Strm << proxy._lastSenderEndPointLeg2.address().to_string() << ":" << proxy._lastSenderEndPointLeg2.port();
-      lastSenderEndPointLeg2 = lastSenderEp2Strm.str().c_str();
-
-
-      DataType adjustSenderFromPacketSource = control.addGroupElement("adjustSenderFromPacketSource", DataType::TypeBoolean);
-      adjustSenderFromPacketSource = proxy._adjustSenderFromPacketSource;
-
-      DataType leg1Reset = control.addGroupElement("leg1Reset", DataType::TypeBoolean);
-      leg1Reset = proxy._leg1Reset;
-
-      DataType leg2Reset = control.addGroupElement("leg2Reset", DataType::TypeBoolean);
-      leg2Reset = proxy._leg2Reset;
-
-      DataType isStarted = control.addGroupElement("isStarted", DataType::TypeBoolean);
-      isStarted = proxy._isStarted;
-
-      DataType isInactive = control.addGroupElement("isInactive", DataType::TypeBoolean);
-      isInactive = proxy._isInactive;
-
-      DataType isLeg1XOREncrypted = control.addGroupElement("isLeg1XOREncrypted", DataType::TypeBoolean);
-      isLeg1XOREncrypted = proxy._isLeg1XOREncrypted;
-
-      DataType isLeg2XOREncrypted = control.addGroupElement("isLeg2XOREncrypted", DataType::TypeBoolean);
-      isLeg2XOREncrypted = proxy._isLeg2XOREncrypted;
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg2.c_str());
+
+      pSession->_audio.control()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_audio.control()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_audio.control()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_audio.control()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_audio.control()._adjustSenderFromPacketSource = record.audio.control.adjustSenderFromPacketSource;
+      pSession->_audio.control()._leg1Reset = record.audio.control.leg1Reset;
+      pSession->_audio.control()._leg2Reset = record.audio.control.leg2Reset;
+      pSession->_audio.control()._isStarted = record.audio.control.isStarted;
+      pSession->_audio.control()._isInactive = record.audio.control.isInactive;
+      pSession->_audio.control()._isLeg1XOREncrypted = record.audio.control.isLeg1XOREncrypted;
+      pSession->_audio.control()._isLeg2XOREncrypted = record.audio.control.isLeg2XOREncrypted;
+      if (!pSession->_audio.control().open(localEndPointLeg1, localEndPointLeg2))
+      {
+        delete pSession;
+        return RTPProxySession::Ptr();
+      }
+      pSession->_audio.control().start();
     }
   }
 
-  if (_hasOfferedVideoProxy)
+  if (pSession->_hasOfferedVideoProxy)
   {
-    DataType video = root.addGroupElement("video", DataType::TypeGroup);
-    DataType data = video.addGroupElement("data", DataType::TypeGroup);
+    pSession->_video.data()._identifier = record.video.data.identifier;
     {
-      RTPProxy& proxy = _video.data();
-      DataType identifier = data.addGroupElement("identifier", DataType::TypeString);
-      identifier = proxy._identifier.c_str();
-
-      DataType localEndPointLeg1 = data.addGroupElement("localEndPointLeg1", DataType::TypeString);
-      std::ostringstream localEp1Strm;
-      localEp1Strm << proxy._localEndPointLeg1.address().to_string() << ":" << proxy._localEndPointLeg1.port();
-      localEndPointLeg1 = localEp1Strm.str().c_str();
-
-      DataType localEndPointLeg2 = data.addGroupElement("localEndPointLeg2", DataType::TypeString);
-      std::ostringstream localEp2Strm;
-      localEp2Strm << proxy._localEndPointLeg2.address().to_string() << ":" << proxy._localEndPointLeg2.port();
-      localEndPointLeg2 = localEp2Strm.str().c_str();
-
-      DataType senderEndPointLeg1 = data.addGroupElement("senderEndPointLeg1", DataType::TypeString);
-      std::ostringstream senderEp1Strm;
-      senderEp1Strm << proxy._senderEndPointLeg1.address().to_string() << ":" << proxy._senderEndPointLeg1.port();
-      senderEndPointLeg1 = senderEp1Strm.str().c_str();
-
-      DataType senderEndPointLeg2 = data.addGroupElement("senderEndPointLeg2", DataType::TypeString);
-      std::ostringstream senderEp2Strm;
-      senderEp2Strm << proxy._senderEndPointLeg2.address().to_string() << ":" << proxy._senderEndPointLeg2.port();
-      senderEndPointLeg2 = senderEp2Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg1 = data.addGroupElement("lastSenderEndPointLeg1", DataType::TypeString);
-      std::ostringstream lastSenderEp1Strm;
-      lastSenderEp1Strm << proxy._lastSenderEndPointLeg1.address().to_string() << ":" << proxy._lastSenderEndPointLeg1.port();
-      lastSenderEndPointLeg1 = lastSenderEp1Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg2 = data.addGroupElement("lastSenderEndPointLeg2", DataType::TypeString);
-      std::ostringstream lastSenderEp2Strm;
-      lastSenderEp2Strm << proxy._lastSenderEndPointLeg2.address().to_string() << ":" << proxy._lastSenderEndPointLeg2.port();
-      lastSenderEndPointLeg2 = lastSenderEp2Strm.str().c_str();
-
-
-      DataType adjustSenderFromPacketSource = data.addGroupElement("adjustSenderFromPacketSource", DataType::TypeBoolean);
-      adjustSenderFromPacketSource = proxy._adjustSenderFromPacketSource;
-
-      DataType leg1Reset = data.addGroupElement("leg1Reset", DataType::TypeBoolean);
-      leg1Reset = proxy._leg1Reset;
-
-      DataType leg2Reset = data.addGroupElement("leg2Reset", DataType::TypeBoolean);
-      leg2Reset = proxy._leg2Reset;
-
-      DataType isStarted = data.addGroupElement("isStarted", DataType::TypeBoolean);
-      isStarted = proxy._isStarted;
-
-      DataType isInactive = data.addGroupElement("isInactive", DataType::TypeBoolean);
-      isInactive = proxy._isInactive;
-
-      DataType isLeg1XOREncrypted = data.addGroupElement("isLeg1XOREncrypted", DataType::TypeBoolean);
-      isLeg1XOREncrypted = proxy._isLeg1XOREncrypted;
-
-      DataType isLeg2XOREncrypted = data.addGroupElement("isLeg2XOREncrypted", DataType::TypeBoolean);
-      isLeg2XOREncrypted = proxy._isLeg2XOREncrypted;
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg2.c_str());
+
+      pSession->_video.data()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_video.data()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_video.data()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_video.data()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_video.data()._adjustSenderFromPacketSource = record.video.data.adjustSenderFromPacketSource;
+      pSession->_video.data()._leg1Reset = record.video.data.leg1Reset;
+      pSession->_video.data()._leg2Reset = record.video.data.leg2Reset;
+      pSession->_video.data()._isStarted = record.video.data.isStarted;
+      pSession->_video.data()._isInactive = record.video.data.isInactive;
+      pSession->_video.data()._isLeg1XOREncrypted = record.video.data.isLeg1XOREncrypted;
+      pSession->_video.data()._isLeg2XOREncrypted = record.video.data.isLeg2XOREncrypted;
+      if (!pSession->_video.data().open(localEndPointLeg1, localEndPointLeg2))
+      {
+        delete pSession;
+        return RTPProxySession::Ptr();
+      }
+      pSession->_video.data().start();
     }
 
-    DataType control = video.addGroupElement("control", DataType::TypeGroup);
+    pSession->_video.control()._identifier = record.video.control.identifier;
     {
-      RTPProxy& proxy = _video.control();
-      DataType identifier = control.addGroupElement("identifier", DataType::TypeString);
-      identifier = proxy._identifier.c_str();
-
-      DataType localEndPointLeg1 = control.addGroupElement("localEndPointLeg1", DataType::TypeString);
-      std::ostringstream localEp1Strm;
-      localEp1Strm << proxy._localEndPointLeg1.address().to_string() << ":" << proxy._localEndPointLeg1.port();
-      localEndPointLeg1 = localEp1Strm.str().c_str();
-
-      DataType localEndPointLeg2 = control.addGroupElement("localEndPointLeg2", DataType::TypeString);
-      std::ostringstream localEp2Strm;
-      localEp2Strm << proxy._localEndPointLeg2.address().to_string() << ":" << proxy._localEndPointLeg2.port();
-      localEndPointLeg2 = localEp2Strm.str().c_str();
-
-      DataType senderEndPointLeg1 = control.addGroupElement("senderEndPointLeg1", DataType::TypeString);
-      std::ostringstream senderEp1Strm;
-      senderEp1Strm << proxy._senderEndPointLeg1.address().to_string() << ":" << proxy._senderEndPointLeg1.port();
-      senderEndPointLeg1 = senderEp1Strm.str().c_str();
-
-      DataType senderEndPointLeg2 = control.addGroupElement("senderEndPointLeg2", DataType::TypeString);
-      std::ostringstream senderEp2Strm;
-      senderEp2Strm << proxy._senderEndPointLeg2.address().to_string() << ":" << proxy._senderEndPointLeg2.port();
-      senderEndPointLeg2 = senderEp2Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg1 = control.addGroupElement("lastSenderEndPointLeg1", DataType::TypeString);
-      std::ostringstream lastSenderEp1Strm;
-      lastSenderEp1Strm << proxy._lastSenderEndPointLeg1.address().to_string() << ":" << proxy._lastSenderEndPointLeg1.port();
-      lastSenderEndPointLeg1 = lastSenderEp1Strm.str().c_str();
-
-      DataType lastSenderEndPointLeg2 = control.addGroupElement("lastSenderEndPointLeg2", DataType::TypeString);
-      std::ostringstream lastSenderEp2Strm;
-      lastSenderEp2Strm << proxy._lastSenderEndPointLeg2.address().to_string() << ":" << proxy._lastSenderEndPointLeg2.port();
-      lastSenderEndPointLeg2 = lastSenderEp2Strm.str().c_str();
-
-
-      DataType adjustSenderFromPacketSource = control.addGroupElement("adjustSenderFromPacketSource", DataType::TypeBoolean);
-      adjustSenderFromPacketSource = proxy._adjustSenderFromPacketSource;
-
-      DataType leg1Reset = control.addGroupElement("leg1Reset", DataType::TypeBoolean);
-      leg1Reset = proxy._leg1Reset;
-
-      DataType leg2Reset = control.addGroupElement("leg2Reset", DataType::TypeBoolean);
-      leg2Reset = proxy._leg2Reset;
-
-      DataType isStarted = control.addGroupElement("isStarted", DataType::TypeBoolean);
-      isStarted = proxy._isStarted;
-
-      DataType isInactive = control.addGroupElement("isInactive", DataType::TypeBoolean);
-      isInactive = proxy._isInactive;
-
-      DataType isLeg1XOREncrypted = control.addGroupElement("isLeg1XOREncrypted", DataType::TypeBoolean);
-      isLeg1XOREncrypted = proxy._isLeg1XOREncrypted;
-
-      DataType isLeg2XOREncrypted = control.addGroupElement("isLeg2XOREncrypted", DataType::TypeBoolean);
-      isLeg2XOREncrypted = proxy._isLeg2XOREncrypted;
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg2.c_str());
+
+      pSession->_video.control()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_video.control()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_video.control()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_video.control()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_video.control()._adjustSenderFromPacketSource = record.video.control.adjustSenderFromPacketSource;
+      pSession->_video.control()._leg1Reset = record.video.control.leg1Reset;
+      pSession->_video.control()._leg2Reset = record.video.control.leg2Reset;
+      pSession->_video.control()._isStarted = record.video.control.isStarted;
+      pSession->_video.control()._isInactive = record.video.control.isInactive;
+      pSession->_video.control()._isLeg1XOREncrypted = record.video.control.isLeg1XOREncrypted;
+      pSession->_video.control()._isLeg2XOREncrypted = record.video.control.isLeg2XOREncrypted;
+      if (!pSession->_video.control().open(localEndPointLeg1, localEndPointLeg2))
+      {
+        delete pSession;
+        return RTPProxySession::Ptr();
+      }
+      pSession->_video.control().start();
     }
   }
 
-  _stateFile = operator/(this->_pManager->getStateDirectory(), ClassType::createSafeFileName(this->_identifier.c_str()));
-  persistent.persist(_stateFile);
-
-}
-#endif
-
-#if ENABLE_FEATURE_REDIS
-
-RTPProxySession::Ptr RTPProxySession::reconstructFromRedis(RTPProxyManager* pManager, const std::string& identifier)
-{
-  RTPProxySession* pSession = 0;
-  if (pManager->hasRtpDb())
+  if (pSession->_hasOfferedFaxProxy)
   {
-    RTPProxyRecord record;
-    if (record.readFromRedis(pManager->redisClient(), identifier))
+    pSession->_fax.data()._identifier = record.fax.data.identifier;
     {
-      pSession = new RTPProxySession(pManager, record.identifier);
-      pSession->_logId = record.logId;
-      pSession->_leg1Identifier = record.leg1Identifier;
-      pSession->_leg2Identifier = record.leg2Identifier;
-      pSession->_leg1OriginAddress = record.leg1OriginAddress;
-      pSession->_leg2OriginAddress = record.leg2OriginAddress;
-      pSession->_lastSDPInAck = record.lastSDPInAck;
-      pSession->_isExpectingInitialAnswer = record.isExpectingInitialAnswer;
-      pSession->_hasOfferedAudioProxy = record.hasOfferedAudioProxy;
-      pSession->_hasOfferedVideoProxy = record.hasOfferedVideoProxy;
-      pSession->_hasOfferedFaxProxy = record.hasOfferedFaxProxy;
-      pSession->_isAudioProxyNegotiated = record.isAudioProxyNegotiated;
-      pSession->_isVideoProxyNegotiated = record.isVideoProxyNegotiated;
-      pSession->_isFaxProxyNegotiated = record.isFaxProxyNegotiated;
-      pSession->_verbose = record.verbose;
-      pSession->_state = (State)record.state;
-      pSession->_lastOfferIndex  = record.lastOfferIndex;
-    }
-    else
-    {
-      return RTPProxySession::Ptr();
-    }
-    
-    if (pSession->_hasOfferedAudioProxy)
-    {
-      pSession->_audio.data()._identifier = record.audio.data.identifier;
-      {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.data.lastSenderEndPointLeg2.c_str());
-
-        pSession->_audio.data()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_audio.data()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_audio.data()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_audio.data()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_audio.data()._adjustSenderFromPacketSource = record.audio.data.adjustSenderFromPacketSource;
-        pSession->_audio.data()._leg1Reset = record.audio.data.leg1Reset;
-        pSession->_audio.data()._leg2Reset = record.audio.data.leg2Reset;
-        pSession->_audio.data()._isStarted = record.audio.data.isStarted;
-        pSession->_audio.data()._isInactive = record.audio.data.isInactive;
-        pSession->_audio.data()._isLeg1XOREncrypted = record.audio.data.isLeg1XOREncrypted;
-        pSession->_audio.data()._isLeg2XOREncrypted = record.audio.data.isLeg2XOREncrypted;
-        if (!pSession->_audio.data().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_audio.data().start();
-      }
-
-      pSession->_audio.control()._identifier = record.audio.control.identifier;
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg2.c_str());
+
+      pSession->_fax.data()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_fax.data()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_fax.data()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_fax.data()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_fax.data()._adjustSenderFromPacketSource = record.fax.data.adjustSenderFromPacketSource;
+      pSession->_fax.data()._leg1Reset = record.fax.data.leg1Reset;
+      pSession->_fax.data()._leg2Reset = record.fax.data.leg2Reset;
+      pSession->_fax.data()._isStarted = record.fax.data.isStarted;
+      pSession->_fax.data()._isInactive = record.fax.data.isInactive;
+      pSession->_fax.data()._isLeg1XOREncrypted = record.fax.data.isLeg1XOREncrypted;
+      pSession->_fax.data()._isLeg2XOREncrypted = record.fax.data.isLeg2XOREncrypted;
+      if (!pSession->_fax.data().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.audio.control.lastSenderEndPointLeg2.c_str());
-
-        pSession->_audio.control()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_audio.control()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_audio.control()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_audio.control()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_audio.control()._adjustSenderFromPacketSource = record.audio.control.adjustSenderFromPacketSource;
-        pSession->_audio.control()._leg1Reset = record.audio.control.leg1Reset;
-        pSession->_audio.control()._leg2Reset = record.audio.control.leg2Reset;
-        pSession->_audio.control()._isStarted = record.audio.control.isStarted;
-        pSession->_audio.control()._isInactive = record.audio.control.isInactive;
-        pSession->_audio.control()._isLeg1XOREncrypted = record.audio.control.isLeg1XOREncrypted;
-        pSession->_audio.control()._isLeg2XOREncrypted = record.audio.control.isLeg2XOREncrypted;
-        if (!pSession->_audio.control().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_audio.control().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
+      pSession->_fax.data().start();
     }
 
-    if (pSession->_hasOfferedVideoProxy)
+    pSession->_fax.control()._identifier = record.fax.control.identifier;
     {
-      pSession->_video.data()._identifier = record.video.data.identifier;
-      {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.data.lastSenderEndPointLeg2.c_str());
-
-        pSession->_video.data()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_video.data()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_video.data()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_video.data()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_video.data()._adjustSenderFromPacketSource = record.video.data.adjustSenderFromPacketSource;
-        pSession->_video.data()._leg1Reset = record.video.data.leg1Reset;
-        pSession->_video.data()._leg2Reset = record.video.data.leg2Reset;
-        pSession->_video.data()._isStarted = record.video.data.isStarted;
-        pSession->_video.data()._isInactive = record.video.data.isInactive;
-        pSession->_video.data()._isLeg1XOREncrypted = record.video.data.isLeg1XOREncrypted;
-        pSession->_video.data()._isLeg2XOREncrypted = record.video.data.isLeg2XOREncrypted;
-        if (!pSession->_video.data().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_video.data().start();
-      }
-
-      pSession->_video.control()._identifier = record.video.control.identifier;
+      OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg1.c_str());
+      OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg2.c_str());
+      OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg1.c_str());
+      OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg2.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg1.c_str());
+      OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg2.c_str());
+
+      pSession->_fax.control()._senderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
+      pSession->_fax.control()._senderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+
+      pSession->_fax.control()._lastSenderEndPointLeg1 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
+      pSession->_fax.control()._lastSenderEndPointLeg2 =
+        boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+
+      pSession->_fax.control()._adjustSenderFromPacketSource = record.fax.control.adjustSenderFromPacketSource;
+      pSession->_fax.control()._leg1Reset = record.fax.control.leg1Reset;
+      pSession->_fax.control()._leg2Reset = record.fax.control.leg2Reset;
+      pSession->_fax.control()._isStarted = record.fax.control.isStarted;
+      pSession->_fax.control()._isInactive = record.fax.control.isInactive;
+      pSession->_fax.control()._isLeg1XOREncrypted = record.fax.control.isLeg1XOREncrypted;
+      pSession->_fax.control()._isLeg2XOREncrypted = record.fax.control.isLeg2XOREncrypted;
+      if (!pSession->_fax.control().open(localEndPointLeg1, localEndPointLeg2))
       {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.video.control.lastSenderEndPointLeg2.c_str());
-
-        pSession->_video.control()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_video.control()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_video.control()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_video.control()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_video.control()._adjustSenderFromPacketSource = record.video.control.adjustSenderFromPacketSource;
-        pSession->_video.control()._leg1Reset = record.video.control.leg1Reset;
-        pSession->_video.control()._leg2Reset = record.video.control.leg2Reset;
-        pSession->_video.control()._isStarted = record.video.control.isStarted;
-        pSession->_video.control()._isInactive = record.video.control.isInactive;
-        pSession->_video.control()._isLeg1XOREncrypted = record.video.control.isLeg1XOREncrypted;
-        pSession->_video.control()._isLeg2XOREncrypted = record.video.control.isLeg2XOREncrypted;
-        if (!pSession->_video.control().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_video.control().start();
+        delete pSession;
+        return RTPProxySession::Ptr();
       }
+      pSession->_fax.control().start();
     }
+  }
+  return RTPProxySession::Ptr(pSession);
+}
 
-    if (pSession->_hasOfferedFaxProxy)
-    {
-      pSession->_fax.data()._identifier = record.fax.data.identifier;
-      {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.data.lastSenderEndPointLeg2.c_str());
-
-        pSession->_fax.data()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_fax.data()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
-
-        pSession->_fax.data()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_fax.data()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
-
-        pSession->_fax.data()._adjustSenderFromPacketSource = record.fax.data.adjustSenderFromPacketSource;
-        pSession->_fax.data()._leg1Reset = record.fax.data.leg1Reset;
-        pSession->_fax.data()._leg2Reset = record.fax.data.leg2Reset;
-        pSession->_fax.data()._isStarted = record.fax.data.isStarted;
-        pSession->_fax.data()._isInactive = record.fax.data.isInactive;
-        pSession->_fax.data()._isLeg1XOREncrypted = record.fax.data.isLeg1XOREncrypted;
-        pSession->_fax.data()._isLeg2XOREncrypted = record.fax.data.isLeg2XOREncrypted;
-        if (!pSession->_fax.data().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_fax.data().start();
-      }
-
-      pSession->_fax.control()._identifier = record.fax.control.identifier;
-      {
-        OSS::Net::IPAddress localEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg1.c_str());
-        OSS::Net::IPAddress localEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.localEndPointLeg2.c_str());
-        OSS::Net::IPAddress senderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg1.c_str());
-        OSS::Net::IPAddress senderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.senderEndPointLeg2.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg1 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg1.c_str());
-        OSS::Net::IPAddress lastSenderEndPointLeg2 = OSS::Net::IPAddress::fromV4IPPort(record.fax.control.lastSenderEndPointLeg2.c_str());
-
-        pSession->_fax.control()._senderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg1.address(), senderEndPointLeg1.getPort());
-        pSession->_fax.control()._senderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(senderEndPointLeg2.address(), senderEndPointLeg2.getPort());
+#if ENABLE_FEATURE_REDIS
+RTPProxySession::Ptr RTPProxySession::reconstructFromRedis(RTPProxyManager* pManager, const std::string& identifier)
+{
+  if (!pManager->hasRtpDb())
+    return RTPProxySession::Ptr();
 
-        pSession->_fax.control()._lastSenderEndPointLeg1 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg1.address(), lastSenderEndPointLeg1.getPort());
-        pSession->_fax.control()._lastSenderEndPointLeg2 =
-          boost::asio::ip::udp::endpoint(lastSenderEndPointLeg2.address(), lastSenderEndPointLeg2.getPort());
+  RTPProxyRecord record;
+  if (!record.readFromRedis(pManager->redisClient(), identifier))
+    return RTPProxySession::Ptr();
 
-        pSession->_fax.control()._adjustSenderFromPacketSource = record.fax.control.adjustSenderFromPacketSource;
-        pSession->_fax.control()._leg1Reset = record.fax.control.leg1Reset;
-        pSession->_fax.control()._leg2Reset = record.fax.control.leg2Reset;
-        pSession->_fax.control()._isStarted = record.fax.control.isStarted;
-        pSession->_fax.control()._isInactive = record.fax.control.isInactive;
-        pSession->_fax.control()._isLeg1XOREncrypted = record.fax.control.isLeg1XOREncrypted;
-        pSession->_fax.control()._isLeg2XOREncrypted = record.fax.control.isLeg2XOREncrypted;
-        if (!pSession->_fax.control().open(localEndPointLeg1, localEndPointLeg2))
-        {
-          delete pSession;
-          return RTPProxySession::Ptr();
-        }
-        pSession->_fax.control().start();
-      }
-    }
-  }
-  return RTPProxySession::Ptr(pSession);
+  return reconstructFromRecord(pManager, record);
 }
 #endif
 
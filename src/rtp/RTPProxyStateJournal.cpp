@@ -0,0 +1,450 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include "OSS/RTP/RTPProxyStateJournal.h"
+#if ENABLE_FEATURE_RTP
+
+#include <algorithm>
+#include <sstream>
+#include <boost/bind.hpp>
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Logger.h"
+
+
+namespace OSS {
+namespace RTP {
+
+
+const char* RTPProxyStateJournal::JOURNAL_FILE_NAME = "rtp-state.journal";
+const char* RTPProxyStateJournal::REDIS_HASH_KEY = "rtp-proxy-state";
+
+static const std::size_t JOURNAL_COMPACT_MIN_LINES = 4096;
+static const int REDIS_HASH_EXPIRES = 3600 * 12;
+
+static bool is_json_layout_char(char ch)
+{
+  //
+  // The json writer escapes control characters inside strings so any raw
+  // newline or tab in its output is indentation and safe to drop
+  //
+  return ch == '\n' || ch == '\t';
+}
+
+static void compact_json(std::string& json)
+{
+  json.erase(std::remove_if(json.begin(), json.end(), is_json_layout_char), json.end());
+}
+
+RTPProxyStateJournal::RTPProxyStateJournal() :
+  _backend(BACKEND_NONE),
+  _pFlushThread(0),
+  _isTerminating(false),
+  _flushInterval(100),
+  _batchSize(256),
+  _journalLines(0)
+#if ENABLE_FEATURE_REDIS
+  ,_pRedisClient(0)
+#endif
+{
+}
+
+RTPProxyStateJournal::~RTPProxyStateJournal()
+{
+  close();
+}
+
+bool RTPProxyStateJournal::open(const boost::filesystem::path& stateDirectory)
+{
+  OSS::mutex_critic_sec_lock flushLock(_flushMutex);
+  if (_backend == BACKEND_REDIS)
+    return true;
+
+  try
+  {
+    if (!boost::filesystem::exists(stateDirectory))
+      boost::filesystem::create_directories(stateDirectory);
+  }
+  catch(const std::exception& e)
+  {
+    OSS_LOG_ERROR("RTPProxyStateJournal::open - Unable to create " << stateDirectory.string() << " - " << e.what());
+    return false;
+  }
+
+  if (_journal.is_open())
+    _journal.close();
+
+  _journalFile = operator/(stateDirectory, JOURNAL_FILE_NAME);
+  _journal.open(_journalFile.string().c_str(), std::ios::out | std::ios::app);
+  if (!_journal.is_open())
+  {
+    OSS_LOG_ERROR("RTPProxyStateJournal::open - Unable to open " << _journalFile.string());
+    return false;
+  }
+
+  _backend = BACKEND_FILE;
+  start();
+  return true;
+}
+
+#if ENABLE_FEATURE_REDIS
+bool RTPProxyStateJournal::open(Persistent::RedisBroadcastClient* pRedisClient)
+{
+  OSS::mutex_critic_sec_lock flushLock(_flushMutex);
+  if (!pRedisClient)
+    return false;
+
+  if (_journal.is_open())
+    _journal.close();
+
+  _pRedisClient = pRedisClient;
+  _backend = BACKEND_REDIS;
+  start();
+  return true;
+}
+#endif
+
+void RTPProxyStateJournal::close()
+{
+  stop();
+  flush();
+
+  OSS::mutex_critic_sec_lock flushLock(_flushMutex);
+  if (_journal.is_open())
+    _journal.close();
+  _backend = BACKEND_NONE;
+}
+
+void RTPProxyStateJournal::start()
+{
+  if (_pFlushThread)
+    return;
+  _isTerminating = false;
+  _pFlushThread = new boost::thread(boost::bind(&RTPProxyStateJournal::runFlushThread, this));
+}
+
+void RTPProxyStateJournal::stop()
+{
+  if (!_pFlushThread)
+    return;
+  _isTerminating = true;
+  _flushSignal.set();
+  _pFlushThread->join();
+  delete _pFlushThread;
+  _pFlushThread = 0;
+}
+
+void RTPProxyStateJournal::runFlushThread()
+{
+  while (!_isTerminating)
+  {
+    _flushSignal.tryWait(_flushInterval);
+    flush();
+  }
+}
+
+void RTPProxyStateJournal::update(const RTPProxyRecord& record)
+{
+  if (_backend == BACKEND_NONE)
+    return;
+
+  std::size_t pending = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    Change& change = _pending[record.identifier];
+    change.isRemoved = false;
+    change.record = record;
+    pending = _pending.size();
+  }
+
+  if (pending == _batchSize)
+    _flushSignal.set();
+}
+
+void RTPProxyStateJournal::remove(const std::string& identifier)
+{
+  if (_backend == BACKEND_NONE)
+    return;
+
+  std::size_t pending = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    Change& change = _pending[identifier];
+    change.isRemoved = true;
+    change.record = RTPProxyRecord();
+    change.record.identifier = identifier;
+    pending = _pending.size();
+  }
+
+  if (pending == _batchSize)
+    _flushSignal.set();
+}
+
+std::size_t RTPProxyStateJournal::getPendingCount() const
+{
+  OSS::mutex_critic_sec_lock lock(_pendingMutex);
+  return _pending.size();
+}
+
+void RTPProxyStateJournal::flush()
+{
+  //
+  // Only one flush may run at a time.  Changes queued while a batch is being
+  // written land in the next batch so per-session ordering is preserved.
+  //
+  OSS::mutex_critic_sec_lock flushLock(_flushMutex);
+
+  Changes changes;
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    if (_pending.empty())
+      return;
+    changes.swap(_pending);
+  }
+
+  switch (_backend)
+  {
+  case BACKEND_FILE:
+    writeToFile(changes);
+    break;
+  case BACKEND_REDIS:
+    writeToRedis(changes);
+    break;
+  default:
+    break;
+  }
+}
+
+void RTPProxyStateJournal::writeToFile(const Changes& changes)
+{
+  if (!_journal.is_open())
+    return;
+
+  std::ostringstream batch;
+  for (Changes::const_iterator iter = changes.begin(); iter != changes.end(); iter++)
+  {
+    if (iter->second.isRemoved)
+    {
+      if (_snapshot.erase(iter->first))
+      {
+        batch << "D " << iter->first << "\n";
+        ++_journalLines;
+      }
+      continue;
+    }
+
+    std::string json;
+    if (!iter->second.record.toString(json))
+    {
+      OSS_LOG_ERROR("RTPProxyStateJournal::writeToFile - Unable to serialize session " << iter->first);
+      continue;
+    }
+    compact_json(json);
+    batch << "S " << json << "\n";
+    _snapshot[iter->first].swap(json);
+    ++_journalLines;
+  }
+
+  std::string buff = batch.str();
+  if (!buff.empty())
+  {
+    _journal.write(buff.data(), buff.size());
+    _journal.flush();
+  }
+
+  if (_journalLines > JOURNAL_COMPACT_MIN_LINES && _journalLines > 2 * _snapshot.size())
+    compact();
+}
+
+bool RTPProxyStateJournal::compact()
+{
+  boost::filesystem::path tempFile = _journalFile.string() + ".tmp";
+  {
+    std::ofstream snapshot(tempFile.string().c_str(), std::ios::out | std::ios::trunc);
+    if (!snapshot.is_open())
+    {
+      OSS_LOG_ERROR("RTPProxyStateJournal::compact - Unable to open " << tempFile.string());
+      return false;
+    }
+    for (Snapshot::const_iterator iter = _snapshot.begin(); iter != _snapshot.end(); iter++)
+      snapshot << "S " << iter->second << "\n";
+    snapshot.flush();
+    if (!snapshot.good())
+    {
+      OSS_LOG_ERROR("RTPProxyStateJournal::compact - Unable to write " << tempFile.string());
+      return false;
+    }
+  }
+
+  _journal.close();
+  boost::system::error_code ec;
+  boost::filesystem::rename(tempFile, _journalFile, ec);
+  if (ec)
+  {
+    OSS_LOG_ERROR("RTPProxyStateJournal::compact - Unable to replace " << _journalFile.string() << " - " << ec.message());
+  }
+  else
+  {
+    _journalLines = _snapshot.size();
+  }
+  _journal.open(_journalFile.string().c_str(), std::ios::out | std::ios::app);
+  return !ec;
+}
+
+void RTPProxyStateJournal::writeToRedis(const Changes& changes)
+{
+#if ENABLE_FEATURE_REDIS
+  if (!_pRedisClient)
+    return;
+
+  std::vector<std::string> hmset;
+  std::vector<std::string> hdel;
+  for (Changes::const_iterator iter = changes.begin(); iter != changes.end(); iter++)
+  {
+    if (iter->second.isRemoved)
+    {
+      if (hdel.empty())
+      {
+        hdel.push_back("HDEL");
+        hdel.push_back(REDIS_HASH_KEY);
+      }
+      hdel.push_back(iter->first);
+      continue;
+    }
+
+    std::string json;
+    if (!iter->second.record.toString(json))
+    {
+      OSS_LOG_ERROR("RTPProxyStateJournal::writeToRedis - Unable to serialize session " << iter->first);
+      continue;
+    }
+    if (hmset.empty())
+    {
+      hmset.push_back("HMSET");
+      hmset.push_back(REDIS_HASH_KEY);
+    }
+    hmset.push_back(iter->first);
+    hmset.push_back(json);
+  }
+
+  std::vector< std::vector<std::string> > commands;
+  if (!hmset.empty())
+    commands.push_back(hmset);
+  if (!hdel.empty())
+    commands.push_back(hdel);
+  if (commands.empty())
+    return;
+
+  std::vector<std::string> expire;
+  expire.push_back("EXPIRE");
+  expire.push_back(REDIS_HASH_KEY);
+  expire.push_back(OSS::string_from_number(REDIS_HASH_EXPIRES));
+  commands.push_back(expire);
+
+  if (!_pRedisClient->pipeline(commands))
+  {
+    OSS_LOG_ERROR("RTPProxyStateJournal::writeToRedis - Failed to write batch of " << changes.size() << " sessions");
+  }
+#else
+  (void)changes;
+#endif
+}
+
+bool RTPProxyStateJournal::load(Records& records)
+{
+  OSS::mutex_critic_sec_lock flushLock(_flushMutex);
+  switch (_backend)
+  {
+  case BACKEND_FILE:
+    return loadFromFile(records);
+  case BACKEND_REDIS:
+    return loadFromRedis(records);
+  default:
+    return false;
+  }
+}
+
+bool RTPProxyStateJournal::loadFromFile(Records& records)
+{
+  std::ifstream journal(_journalFile.string().c_str());
+  if (!journal.is_open())
+    return false;
+
+  _snapshot.clear();
+  std::string line;
+  while (std::getline(journal, line))
+  {
+    if (line.size() < 3 || line[1] != ' ')
+      continue;
+
+    if (line[0] == 'D')
+    {
+      _snapshot.erase(line.substr(2));
+    }
+    else if (line[0] == 'S')
+    {
+      //
+      // A truncated trailing line left by a crash fails to parse and is skipped
+      //
+      RTPProxyRecord record;
+      std::string json = line.substr(2);
+      if (record.fromString(json) && !record.identifier.empty())
+        _snapshot[record.identifier].swap(json);
+    }
+  }
+  journal.close();
+
+  for (Snapshot::const_iterator iter = _snapshot.begin(); iter != _snapshot.end(); iter++)
+  {
+    RTPProxyRecord& record = records[iter->first];
+    record.fromString(iter->second);
+  }
+
+  compact();
+  return true;
+}
+
+bool RTPProxyStateJournal::loadFromRedis(Records& records)
+{
+#if ENABLE_FEATURE_REDIS
+  if (!_pRedisClient)
+    return false;
+
+  std::vector<std::string> fields;
+  if (!_pRedisClient->hgetall(REDIS_HASH_KEY, fields))
+    return false;
+
+  for (std::size_t i = 0; i + 1 < fields.size(); i += 2)
+  {
+    RTPProxyRecord record;
+    if (record.fromString(fields[i + 1]))
+      records[fields[i]] = record;
+  }
+  return true;
+#else
+  (void)records;
+  return false;
+#endif
+}
+
+
+} } // OSS::RTP
+
+#endif // ENABLE_FEATURE_RTP
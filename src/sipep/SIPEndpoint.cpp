@@ -156,8 +156,7 @@ void SIPEndpoint::sendEndpointRequest(
 static std::string create_retransmission_id(const SIPMessage::Ptr& pRequest, bool asSender)
 {
   std::ostringstream id;
-  OSS::SIP::SIPCSeq cseq(pRequest->hdrGet(OSS::SIP::HDR_CSEQ));
-  id << pRequest->getDialogId(asSender) << "-" << cseq.getNumber();
+  id << pRequest->getDialogId(asSender) << "-" << pRequest->getCSeqNumber();
   return id.str();
 }
 
@@ -23,12 +23,24 @@
 #include "OSS/SIP/SIPTransportService.h"
 #include "OSS/SIP/SIPException.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
 
 namespace OSS {
 namespace SIP {
   
 #define MIN_DATAGRAM_SIZE 10
 
+static OSS::MetricCounter& gMessagesReceived = OSS::Metrics::instance().counter(
+  "sip_messages_received_total", "SIP messages handed over by the transports");
+static OSS::MetricCounter& gParseErrors = OSS::Metrics::instance().counter(
+  "sip_parse_errors_total", "SIP messages dropped because they failed to parse");
+static OSS::MetricCounter& gTransactionsCreated = OSS::Metrics::instance().counter(
+  "sip_transactions_created_total", "SIP transactions created for inbound messages");
+static OSS::MetricCounter& gUnmatchedMessages = OSS::Metrics::instance().counter(
+  "sip_unmatched_messages_total", "Inbound SIP messages that matched no transaction");
+static OSS::LatencyHistogram& gParseLatency = OSS::Metrics::instance().histogram(
+  "sip_parse_microseconds", "Time spent parsing inbound SIP messages");
+
 
 SIPFSMDispatch::SIPFSMDispatch() :
   _transport(boost::bind(&SIPFSMDispatch::onReceivedMessage, this, _1, _2)),
@@ -36,7 +48,7 @@ SIPFSMDispatch::SIPFSMDispatch() :
   _nict(this),
   _ist(this),
   _nist(this),
-  _istBlocker(60),
+  _istBlocker(60000),
   _enableIctForking(false)
 {
 }
@@ -69,12 +81,15 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
     return;
   }
 
+  gMessagesReceived.increment();
   try
   {
+    OSS::Metrics::Timer timer(gParseLatency);
     pMsg->parse();
   }
   catch(OSS::Exception e)
   {
+    gParseErrors.increment();
     std::ostringstream logMsg;
     logMsg << "Incoming message failed to be parsed - " << e.message()
       << " LEN: " << pTransport->getLastReadCount()
@@ -132,6 +147,14 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
       trn = _nict.findTransaction(pMsg, pTransport, false);
     }
   }
+
+  //
+  // Transports hand over inbound messages in single owner mode.  From here
+  // on the message is stored by transactions and read by timers and the
+  // application so it goes back to locking on access.
+  //
+  pMsg->setSingleOwner(false);
+
   if (trn)
   {
     std::ostringstream logMsg;
@@ -142,6 +165,7 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
     }
     else
     {
+      gTransactionsCreated.increment();
       trn->setLogId(pMsg->createContextId(true));
       logMsg << trn->getLogId() << "Transaction " << trn->getId() << " CREATED";
       OSS::log_information(logMsg.str());
@@ -169,6 +193,7 @@ void SIPFSMDispatch::onReceivedMessage(SIPMessage::Ptr pMsg, SIPTransportSession
     }
     else
     {
+      gUnmatchedMessages.increment();
       std::ostringstream logMsg;
       logMsg << pMsg->createContextId(true) << "Unable to match incoming request to a transaction - "
         << pMsg->startLine();
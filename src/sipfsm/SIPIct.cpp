@@ -24,12 +24,16 @@
 #include "OSS/SIP/SIPRequestLine.h"
 #include "OSS/SIP/SIPFSMDispatch.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
 
 namespace OSS {
 namespace SIP {
 
 #define RELIABLE_TIMER_B_VALUE 5000 // default to 5 seconds timeout for TCP and TLS
 
+static OSS::MetricCounter& gRetransmissions = OSS::Metrics::instance().counter(
+  "sip_request_retransmissions_total", "Requests retransmitted by client transactions");
+
 SIPIct::SIPIct(
   boost::asio::io_service& ioService,
   const SIPTransactionTimers& timerProps) :
@@ -213,6 +217,7 @@ void SIPIct::handleRetransmitInvite()
 
   if (pTransaction->getState() == TRYING)
   {
+    gRetransmissions.increment();
     if (pTransaction->transport()->isReliableTransport())
       pTransaction->transport()->writeMessage(_pRequest);
     else
@@ -304,13 +309,11 @@ void SIPIct::handleSendAck(SIPMessage::Ptr pMsg, SIPTransportSession::Ptr pTrans
 
     _pAck->hdrSet(OSS::SIP::HDR_TO, pMsg->hdrGet(OSS::SIP::HDR_TO));
 
-    SIPCSeq cSeq;
-    cSeq = _pRequest->hdrGet(OSS::SIP::HDR_CSEQ);
-    std::string ackCSeq = cSeq.getNumber();
+    std::string ackCSeq = _pRequest->getCSeqNumber();
     ackCSeq += " ACK";
     _pAck->hdrSet(OSS::SIP::HDR_CSEQ, ackCSeq);
 
-    _pAck->body() = "";
+    _pAck->setBody("");
     _pAck->hdrRemove(OSS::SIP::HDR_CONTENT_LENGTH);
     _pAck->hdrRemove(OSS::SIP::HDR_CONTENT_TYPE);
 
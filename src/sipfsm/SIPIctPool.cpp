@@ -20,6 +20,8 @@
 
 #include "OSS/SIP/SIPIctPool.h"
 #include "OSS/SIP/SIPIct.h"
+#include "OSS/UTL/ArenaAllocator.h"
+#include <boost/make_shared.hpp>
 #include "OSS/SIP/SIPFSMDispatch.h"
 #include "OSS/SIP/SIPFrom.h"
 
@@ -42,7 +44,8 @@ void SIPIctPool::onAttachFSM(const SIPTransaction::Ptr& pTransaction)
   if (!pTransaction->fsm())
   {
     pTransaction->type() = SIPTransaction::TYPE_ICT;
-    pTransaction->fsm() = SIPIct::Ptr(new SIPIct(_ioService, _timerProps));
+    pTransaction->fsm() = boost::allocate_shared<SIPIct>(OSS::ArenaAllocator<SIPIct>(pTransaction->arena()),
+      boost::ref(_ioService), boost::ref(_timerProps));
     pTransaction->fsm()->setOwner(new SIPTransaction::WeakPtr(pTransaction));
     pTransaction->fsm()->dispatch() = dispatch();
   }
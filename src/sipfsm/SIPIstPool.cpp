@@ -20,6 +20,8 @@
 
 #include "OSS/SIP/SIPIstPool.h"
 #include "OSS/SIP/SIPIst.h"
+#include "OSS/UTL/ArenaAllocator.h"
+#include <boost/make_shared.hpp>
 #include "OSS/SIP/SIPFSMDispatch.h"
 
 
@@ -41,7 +43,8 @@ void SIPIstPool::onAttachFSM(const SIPTransaction::Ptr& pTransaction)
   if (!pTransaction->fsm())
   {
     pTransaction->type() = SIPTransaction::TYPE_IST;
-    SIPIst::Ptr ist(new SIPIst(_ioService, _timerProps));
+    SIPIst::Ptr ist = boost::allocate_shared<SIPIst>(OSS::ArenaAllocator<SIPIst>(pTransaction->arena()),
+      boost::ref(_ioService), boost::ref(_timerProps));
     dynamic_cast<SIPIst*>(ist.get())->istPool() = this;
     pTransaction->fsm() = ist;
     pTransaction->fsm()->setOwner(new SIPTransaction::WeakPtr(pTransaction));
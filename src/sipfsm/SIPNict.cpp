@@ -22,6 +22,7 @@
 #include "OSS/SIP/SIPTransaction.h"
 #include "OSS/SIP/SIPCSeq.h"
 #include "OSS/SIP/SIPFSMDispatch.h"
+#include "OSS/UTL/Metrics.h"
 
 
 namespace OSS {
@@ -30,6 +31,9 @@ namespace SIP {
 
 #define RELIABLE_TIMER_F_VALUE 5000 // default to 5 seconds timeout for TCP and TLS
 
+static OSS::MetricCounter& gRetransmissions = OSS::Metrics::instance().counter(
+  "sip_request_retransmissions_total", "Requests retransmitted by client transactions");
+
 SIPNict::SIPNict(
   boost::asio::io_service& ioService,
   const SIPTransactionTimers& timerProps) :
@@ -271,6 +275,7 @@ void SIPNict::handleRetransmitRequest()
 
   if (pTransaction->getState() <= PROCEEDING)
   {
+    gRetransmissions.increment();
     if (pTransaction->transport()->isReliableTransport())
       pTransaction->transport()->writeMessage(_pRequest);
     else
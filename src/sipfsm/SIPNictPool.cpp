@@ -20,6 +20,8 @@
 
 #include "OSS/SIP/SIPNictPool.h"
 #include "OSS/SIP/SIPNict.h"
+#include "OSS/UTL/ArenaAllocator.h"
+#include <boost/make_shared.hpp>
 #include "OSS/SIP/SIPFSMDispatch.h"
 
 
@@ -41,7 +43,8 @@ void SIPNictPool::onAttachFSM(const SIPTransaction::Ptr& pTransaction)
   if (!pTransaction->fsm())
   {
     pTransaction->type() = SIPTransaction::TYPE_NICT;
-    pTransaction->fsm() = SIPNict::Ptr(new SIPNict(_ioService, _timerProps));
+    pTransaction->fsm() = boost::allocate_shared<SIPNict>(OSS::ArenaAllocator<SIPNict>(pTransaction->arena()),
+      boost::ref(_ioService), boost::ref(_timerProps));
     pTransaction->fsm()->setOwner(new SIPTransaction::WeakPtr(pTransaction));
     pTransaction->fsm()->dispatch() = dispatch();
   }
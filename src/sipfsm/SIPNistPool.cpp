@@ -20,6 +20,8 @@
 
 #include "OSS/SIP/SIPNistPool.h"
 #include "OSS/SIP/SIPNist.h"
+#include "OSS/UTL/ArenaAllocator.h"
+#include <boost/make_shared.hpp>
 #include "OSS/SIP/SIPFSMDispatch.h"
 
 
@@ -41,7 +43,8 @@ void SIPNistPool::onAttachFSM(const SIPTransaction::Ptr& pTransaction)
   if (!pTransaction->fsm())
   {
     pTransaction->type() = SIPTransaction::TYPE_NIST;
-    pTransaction->fsm() = SIPNist::Ptr(new SIPNist(_ioService, _timerProps));
+    pTransaction->fsm() = boost::allocate_shared<SIPNist>(OSS::ArenaAllocator<SIPNist>(pTransaction->arena()),
+      boost::ref(_ioService), boost::ref(_timerProps));
     pTransaction->fsm()->setOwner(new SIPTransaction::WeakPtr(pTransaction));
     pTransaction->fsm()->dispatch() = dispatch();
   }
@@ -584,6 +584,15 @@ void SIPStack::setTransportThreshold(
   }
 }
 
+bool SIPStack::setTransportBanSet(const std::string& setName)
+{
+  OSS::Net::AccessControl::BanSetPtr banSet(new OSS::Net::NetlinkBanSet(setName));
+  if (!banSet->open())
+    return false;
+  SIPTransportSession::rateLimit().setBanSet(banSet);
+  return true;
+}
+
 #if ENABLE_FEATURE_CONFIG
 
 static void registerConfiguredTransport(OSS::socket_address_list& listeners,
@@ -916,6 +925,15 @@ void SIPStack::initTransportFromConfig(const boost::filesystem::path& cfgFile)
     }
   }
 
+  if (listeners.exists("ban-ipset"))
+  {
+    std::string banSet = (const char*)listeners["ban-ipset"];
+    if (!banSet.empty() && !setTransportBanSet(banSet))
+    {
+      OSS_LOG_ERROR("SIPStack::initTransportFromConfig - Unable to use ipset " << banSet << " for banned sources");
+    }
+  }
+
   transportInit();
 }
 
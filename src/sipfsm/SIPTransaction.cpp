@@ -29,6 +29,16 @@
 #include "OSS/SIP/SIPXOR.h"
 #include "OSS/SIP/SIPFrom.h"
 #include "OSS/SIP/B2BUA/SIPB2BTransaction.h"
+#include <boost/make_shared.hpp>
+
+
+//
+// A chunk holds the state machine of the transaction with its timers and
+// leaves room for the small objects that come after it
+//
+#define ARENA_CHUNK_SIZE 4096
+
+OSS_SLAB_POOL(OSS::SIP::SIPTransaction, "sip_transaction")
 
 
 namespace OSS {
@@ -38,6 +48,7 @@ namespace SIP {
 SIPTransaction::SIPTransaction():
   _type(TYPE_UNKNOWN),
   _owner(0),
+  _arena(boost::make_shared<OSS::MemoryArena>(boost::ref(arenaChunks()))),
   _transportService(0),
   _state(TRN_STATE_IDLE),
   _localAddress(),
@@ -55,6 +66,7 @@ SIPTransaction::SIPTransaction():
 SIPTransaction::SIPTransaction(SIPTransaction::Ptr pParent) :
   _type(pParent->getType()),
   _owner(0),
+  _arena(boost::make_shared<OSS::MemoryArena>(boost::ref(arenaChunks()))),
   _transportService(0),
   _state(TRN_STATE_IDLE),
   _localAddress(),
@@ -86,6 +98,7 @@ SIPTransaction::~SIPTransaction()
 SIPTransaction::SIPTransaction(const SIPTransaction&) :
   _type(TYPE_UNKNOWN),
   _owner(0),
+  _arena(boost::make_shared<OSS::MemoryArena>(boost::ref(arenaChunks()))),
   _transportService(0),
   _state(TRN_STATE_IDLE),
   _localAddress(),
@@ -105,6 +118,12 @@ SIPTransaction& SIPTransaction::operator = (const SIPTransaction&)
   return *this;
 }
 
+OSS::SlabPool& SIPTransaction::arenaChunks()
+{
+  static OSS::SlabPool* pChunks = new OSS::SlabPool("sip_transaction_arena", ARENA_CHUNK_SIZE);
+  return *pChunks;
+}
+
 SIPTransactionPool*& SIPTransaction::owner()
 {
   return _owner;
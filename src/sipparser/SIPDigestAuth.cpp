@@ -20,7 +20,9 @@
 
 #include <vector>
 
+#include <string.h>
 #include "OSS/SIP/SIPDigestAuth.h"
+#include "OSS/SIP/SIPDigestAuthEngine.h"
 #include "OSS/SIP/SIPParser.h"
 
 static std::string MD5_NONCE_KEY = "toadfish";
@@ -51,24 +53,39 @@ std::string SIPDigestAuth::digestCreateA1Hash(
   std::string realm_ = realm;
   SIPParser::unquoteString(userName_);
   SIPParser::unquoteString(realm_);
-  std::ostringstream input;
-  input << userName_ << ":" << realm_ << ":" << password;
-  return OSS::string_md5_hash(input.str().c_str());
+  SIPDigestAuthEngine::Hash hash;
+  SIPDigestAuthEngine::computeHA1(SIPDigestAuthEngine::ALGORITHM_MD5, userName_, realm_, password, hash);
+  return std::string(hash.hex, hash.len);
 }
-    /// Create an A1 MD5 Hash
 
 std::string SIPDigestAuth::digestCreateA2Hash(const std::string& uri, const char* method)
 {
-  std::ostringstream input;
-  input << method << ":" << uri;
-  return OSS::string_md5_hash(input.str().c_str());
+  SIPDigestAuthEngine::Hash hash;
+  SIPDigestAuthEngine::computeHA2(SIPDigestAuthEngine::ALGORITHM_MD5, method, uri, hash);
+  return std::string(hash.hex, hash.len);
 }
 
 std::string SIPDigestAuth::digestCreateNonce(const std::string& key)
 {
-  std::ostringstream input;
-  input << MD5_NONCE_KEY << ":" << key;
-  return OSS::string_md5_hash(input.str().c_str());
+  const char* segments[] = { MD5_NONCE_KEY.data(), key.data() };
+  std::size_t lengths[] = { MD5_NONCE_KEY.size(), key.size() };
+  SIPDigestAuthEngine::Hash hash;
+  SIPDigestAuthEngine::hash(SIPDigestAuthEngine::ALGORITHM_MD5, segments, lengths, 2, hash);
+  return std::string(hash.hex, hash.len);
+}
+
+//
+// The a1 and a2 parameters are hex digests.  We copy them into
+// fixed buffers so the engine can use them without allocation.
+//
+static bool digest_from_hex(const std::string& hex, SIPDigestAuthEngine::Hash& hash)
+{
+  if (hex.size() > SIPDigestAuthEngine::MAX_HASH_HEX_LEN)
+    return false;
+  ::memcpy(hash.hex, hex.data(), hex.size());
+  hash.hex[hex.size()] = 0;
+  hash.len = hex.size();
+  return true;
 }
 
 std::string SIPDigestAuth::digestCreateAuthorization(const std::string& a1,
@@ -76,9 +93,14 @@ std::string SIPDigestAuth::digestCreateAuthorization(const std::string& a1,
 {
   std::string nonce_ = nonce;
   SIPParser::unquoteString(nonce_);
-  std::ostringstream input;
-  input << a1 << ":" << nonce_ << ":" << a2;
-  return OSS::string_md5_hash(input.str().c_str());
+  SIPDigestAuthEngine::Hash ha1;
+  SIPDigestAuthEngine::Hash ha2;
+  SIPDigestAuthEngine::Hash response;
+  if (!digest_from_hex(a1, ha1) || !digest_from_hex(a2, ha2))
+    return std::string();
+  std::string empty;
+  SIPDigestAuthEngine::computeResponse(SIPDigestAuthEngine::ALGORITHM_MD5, ha1, nonce_, empty, empty, empty, ha2, response);
+  return std::string(response.hex, response.len);
 }
 
 std::string SIPDigestAuth::digestCreateAuthorizationQop(
@@ -96,15 +118,26 @@ std::string SIPDigestAuth::digestCreateAuthorizationQop(
   SIPParser::unquoteString(cnonce_);
   SIPParser::unquoteString(qop_);
 
-  std::ostringstream input;
-  input << a1 << ":"
-          << nonce_ << ":"
-          << nonceCount << ":"
-          << cnonce_ << ":"
-          << qop_ << ":"
-          << a2;
-
-  return OSS::string_md5_hash(input.str().c_str());
+  SIPDigestAuthEngine::Hash ha1;
+  SIPDigestAuthEngine::Hash ha2;
+  SIPDigestAuthEngine::Hash response;
+  if (!digest_from_hex(a1, ha1) || !digest_from_hex(a2, ha2))
+    return std::string();
+
+  if (qop_.empty())
+  {
+    //
+    // Preserve the original behavior of hashing the empty qop segment
+    //
+    const char* segments[] = { ha1.hex, nonce_.data(), nonceCount.data(), cnonce_.data(), "", ha2.hex };
+    std::size_t lengths[] = { ha1.len, nonce_.size(), nonceCount.size(), cnonce_.size(), 0, ha2.len };
+    SIPDigestAuthEngine::hash(SIPDigestAuthEngine::ALGORITHM_MD5, segments, lengths, 6, response);
+  }
+  else
+  {
+    SIPDigestAuthEngine::computeResponse(SIPDigestAuthEngine::ALGORITHM_MD5, ha1, nonce_, nonceCount, cnonce_, qop_, ha2, response);
+  }
+  return std::string(response.hex, response.len);
 }
 
-} } // OSS::SIP
\ No newline at end of file
+} } // OSS::SIP
@@ -0,0 +1,523 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include "OSS/SIP/SIPDigestAuthEngine.h"
+#include "OSS/SIP/SIPAuthorization.h"
+#include "OSS/SIP/SIPParser.h"
+
+
+namespace OSS {
+namespace SIP {
+
+
+static const char HEX_CHARS[] = "0123456789abcdef";
+
+static void to_hex(const unsigned char* digest, std::size_t len, char* hex)
+{
+  for (std::size_t i = 0; i < len; i++)
+  {
+    hex[i * 2] = HEX_CHARS[(digest[i] >> 4) & 0x0F];
+    hex[i * 2 + 1] = HEX_CHARS[digest[i] & 0x0F];
+  }
+  hex[len * 2] = 0;
+}
+
+static bool parse_hex32(const char* hex, unsigned int& value)
+{
+  value = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    char c = hex[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9')
+      value |= (c - '0');
+    else if (c >= 'a' && c <= 'f')
+      value |= (c - 'a' + 10);
+    else
+      return false;
+  }
+  return true;
+}
+
+static void format_hex32(unsigned int value, char* hex)
+{
+  for (int i = 7; i >= 0; i--)
+  {
+    hex[i] = HEX_CHARS[value & 0x0F];
+    value >>= 4;
+  }
+}
+
+static const EVP_MD* get_evp_md(SIPDigestAuthEngine::Algorithm algorithm)
+{
+  switch (algorithm)
+  {
+    case SIPDigestAuthEngine::ALGORITHM_MD5:
+    case SIPDigestAuthEngine::ALGORITHM_MD5_SESS:
+      return EVP_md5();
+    case SIPDigestAuthEngine::ALGORITHM_SHA256:
+    case SIPDigestAuthEngine::ALGORITHM_SHA256_SESS:
+      return EVP_sha256();
+    default:
+      return 0;
+  }
+}
+
+static bool is_session_algorithm(SIPDigestAuthEngine::Algorithm algorithm)
+{
+  return algorithm == SIPDigestAuthEngine::ALGORITHM_MD5_SESS ||
+    algorithm == SIPDigestAuthEngine::ALGORITHM_SHA256_SESS;
+}
+
+static SIPDigestAuthEngine::Algorithm get_base_algorithm(SIPDigestAuthEngine::Algorithm algorithm)
+{
+  if (algorithm == SIPDigestAuthEngine::ALGORITHM_MD5_SESS)
+    return SIPDigestAuthEngine::ALGORITHM_MD5;
+  else if (algorithm == SIPDigestAuthEngine::ALGORITHM_SHA256_SESS)
+    return SIPDigestAuthEngine::ALGORITHM_SHA256;
+  return algorithm;
+}
+
+bool SIPDigestAuthEngine::Hash::equals(const char* other, std::size_t otherLen) const
+{
+  if (otherLen != len)
+    return false;
+  //
+  // Constant time compare so we do not leak how much of the response matched
+  //
+  unsigned char diff = 0;
+  for (std::size_t i = 0; i < len; i++)
+    diff |= (unsigned char)(::tolower(other[i]) ^ hex[i]);
+  return diff == 0;
+}
+
+SIPDigestAuthEngine::SIPDigestAuthEngine(const std::string& secret,
+  unsigned int nonceLifetime,
+  std::size_t maxNonces,
+  std::size_t maxHA1) :
+  _secret(secret),
+  _nonceLifetime(nonceLifetime),
+  _maxNonces(maxNonces),
+  _maxHA1(maxHA1),
+  _salt(0),
+  _evictedTimestamp(0)
+{
+  if (RAND_bytes((unsigned char*)&_salt, sizeof(_salt)) != 1)
+    _salt = (unsigned int)::time(0);
+}
+
+SIPDigestAuthEngine::~SIPDigestAuthEngine()
+{
+}
+
+SIPDigestAuthEngine::Algorithm SIPDigestAuthEngine::parseAlgorithm(const std::string& algorithm)
+{
+  if (algorithm.empty() || ::strcasecmp(algorithm.c_str(), "MD5") == 0)
+    return ALGORITHM_MD5;
+  else if (::strcasecmp(algorithm.c_str(), "MD5-sess") == 0)
+    return ALGORITHM_MD5_SESS;
+  else if (::strcasecmp(algorithm.c_str(), "SHA-256") == 0)
+    return ALGORITHM_SHA256;
+  else if (::strcasecmp(algorithm.c_str(), "SHA-256-sess") == 0)
+    return ALGORITHM_SHA256_SESS;
+  return ALGORITHM_UNKNOWN;
+}
+
+const char* SIPDigestAuthEngine::algorithmToString(Algorithm algorithm)
+{
+  switch (algorithm)
+  {
+    case ALGORITHM_MD5:
+      return "MD5";
+    case ALGORITHM_MD5_SESS:
+      return "MD5-sess";
+    case ALGORITHM_SHA256:
+      return "SHA-256";
+    case ALGORITHM_SHA256_SESS:
+      return "SHA-256-sess";
+    default:
+      return "";
+  }
+}
+
+bool SIPDigestAuthEngine::hash(Algorithm algorithm,
+  const char* const* segments,
+  const std::size_t* lengths,
+  std::size_t count,
+  Hash& result)
+{
+  const EVP_MD* md = get_evp_md(algorithm);
+  if (!md)
+    return false;
+
+  EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+  if (!ctx)
+    return false;
+
+  bool ok = EVP_DigestInit_ex(ctx, md, 0) == 1;
+  for (std::size_t i = 0; ok && i < count; i++)
+  {
+    if (i > 0)
+      ok = EVP_DigestUpdate(ctx, ":", 1) == 1;
+    if (ok && lengths[i])
+      ok = EVP_DigestUpdate(ctx, segments[i], lengths[i]) == 1;
+  }
+
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digestLen = 0;
+  if (ok)
+    ok = EVP_DigestFinal_ex(ctx, digest, &digestLen) == 1;
+  EVP_MD_CTX_free(ctx);
+
+  if (!ok || digestLen * 2 > MAX_HASH_HEX_LEN)
+    return false;
+
+  to_hex(digest, digestLen, result.hex);
+  result.len = digestLen * 2;
+  return true;
+}
+
+bool SIPDigestAuthEngine::computeHA1(Algorithm algorithm,
+  const std::string& user,
+  const std::string& realm,
+  const std::string& password,
+  Hash& result)
+{
+  const char* segments[] = { user.data(), realm.data(), password.data() };
+  std::size_t lengths[] = { user.size(), realm.size(), password.size() };
+  return hash(get_base_algorithm(algorithm), segments, lengths, 3, result);
+}
+
+bool SIPDigestAuthEngine::computeSessionHA1(Algorithm algorithm,
+  const Hash& ha1,
+  const std::string& nonce,
+  const std::string& cnonce,
+  Hash& result)
+{
+  const char* segments[] = { ha1.hex, nonce.data(), cnonce.data() };
+  std::size_t lengths[] = { ha1.len, nonce.size(), cnonce.size() };
+  return hash(algorithm, segments, lengths, 3, result);
+}
+
+bool SIPDigestAuthEngine::computeHA2(Algorithm algorithm,
+  const char* method,
+  const std::string& uri,
+  Hash& result)
+{
+  if (!method)
+    return false;
+  const char* segments[] = { method, uri.data() };
+  std::size_t lengths[] = { ::strlen(method), uri.size() };
+  return hash(algorithm, segments, lengths, 2, result);
+}
+
+bool SIPDigestAuthEngine::computeResponse(Algorithm algorithm,
+  const Hash& ha1,
+  const std::string& nonce,
+  const std::string& nonceCount,
+  const std::string& cnonce,
+  const std::string& qop,
+  const Hash& ha2,
+  Hash& result)
+{
+  if (qop.empty())
+  {
+    const char* segments[] = { ha1.hex, nonce.data(), ha2.hex };
+    std::size_t lengths[] = { ha1.len, nonce.size(), ha2.len };
+    return hash(algorithm, segments, lengths, 3, result);
+  }
+
+  const char* segments[] = { ha1.hex, nonce.data(), nonceCount.data(), cnonce.data(), qop.data(), ha2.hex };
+  std::size_t lengths[] = { ha1.len, nonce.size(), nonceCount.size(), cnonce.size(), qop.size(), ha2.len };
+  return hash(algorithm, segments, lengths, 6, result);
+}
+
+bool SIPDigestAuthEngine::signNonce(unsigned int timestamp, unsigned int salt, char* signature) const
+{
+  char data[16];
+  format_hex32(timestamp, data);
+  format_hex32(salt, data + 8);
+
+  unsigned char mac[EVP_MAX_MD_SIZE];
+  unsigned int macLen = 0;
+  if (!HMAC(EVP_sha256(), _secret.data(), (int)_secret.size(),
+    (const unsigned char*)data, sizeof(data), mac, &macLen) || macLen < 16)
+  {
+    return false;
+  }
+
+  //
+  // 128 bits of the signature is plenty for a nonce with a short lifetime
+  //
+  to_hex(mac, 16, signature);
+  return true;
+}
+
+std::string SIPDigestAuthEngine::createNonce() const
+{
+  return createNonce((unsigned int)::time(0));
+}
+
+std::string SIPDigestAuthEngine::createNonce(unsigned int timestamp) const
+{
+  unsigned int salt;
+  {
+    OSS::mutex_critic_sec_lock lock(_nonceMutex);
+    salt = ++_salt;
+  }
+
+  char nonce[NONCE_LEN + 1];
+  format_hex32(timestamp, nonce);
+  format_hex32(salt, nonce + 8);
+  if (!signNonce(timestamp, salt, nonce + 16))
+    return std::string();
+  return std::string(nonce, NONCE_LEN);
+}
+
+SIPDigestAuthEngine::Result SIPDigestAuthEngine::validateNonce(const std::string& nonce) const
+{
+  return validateNonce(nonce, (unsigned int)::time(0));
+}
+
+SIPDigestAuthEngine::Result SIPDigestAuthEngine::validateNonce(const std::string& nonce, unsigned int now) const
+{
+  if (nonce.size() != NONCE_LEN)
+    return AUTH_INVALID_NONCE;
+
+  unsigned int timestamp;
+  unsigned int salt;
+  if (!parse_hex32(nonce.data(), timestamp) || !parse_hex32(nonce.data() + 8, salt))
+    return AUTH_INVALID_NONCE;
+
+  char signature[33];
+  if (!signNonce(timestamp, salt, signature))
+    return AUTH_INVALID_NONCE;
+
+  unsigned char diff = 0;
+  for (std::size_t i = 0; i < 32; i++)
+    diff |= (unsigned char)(nonce[16 + i] ^ signature[i]);
+  if (diff)
+    return AUTH_INVALID_NONCE;
+
+  if (timestamp > now + 1 || now - timestamp > _nonceLifetime)
+    return AUTH_STALE_NONCE;
+
+  return AUTH_OK;
+}
+
+SIPDigestAuthEngine::Result SIPDigestAuthEngine::checkNonceCount(const std::string& nonce, const std::string& nonceCount)
+{
+  if (nonce.size() != NONCE_LEN || nonceCount.empty() || nonceCount.size() > 8)
+    return AUTH_MALFORMED;
+
+  char* end = 0;
+  unsigned long nc = ::strtoul(nonceCount.c_str(), &end, 16);
+  if (!end || *end != 0 || nc == 0)
+    return AUTH_MALFORMED;
+
+  unsigned int timestamp;
+  if (!parse_hex32(nonce.data(), timestamp))
+    return AUTH_INVALID_NONCE;
+
+  OSS::mutex_critic_sec_lock lock(_nonceMutex);
+  NonceCache::iterator iter = _nonces.find(nonce);
+  if (iter != _nonces.end())
+  {
+    if (nc <= iter->second.nonceCount)
+      return AUTH_REPLAY;
+    iter->second.nonceCount = nc;
+    return AUTH_OK;
+  }
+
+  //
+  // A nonce that is not in the cache but is not newer than the last
+  // evicted entry might have been used before.  Report it as stale so
+  // that the client is challenged with a fresh nonce.
+  //
+  if (timestamp <= _evictedTimestamp)
+    return AUTH_STALE_NONCE;
+
+  while (_nonces.size() >= _maxNonces && !_nonceOrder.empty())
+  {
+    NonceCache::iterator oldest = _nonces.find(_nonceOrder.front());
+    if (oldest != _nonces.end())
+    {
+      if (oldest->second.timestamp > _evictedTimestamp)
+        _evictedTimestamp = oldest->second.timestamp;
+      _nonces.erase(oldest);
+    }
+    _nonceOrder.pop_front();
+  }
+
+  NonceEntry entry;
+  entry.nonceCount = nc;
+  entry.timestamp = timestamp;
+  _nonces[nonce] = entry;
+  _nonceOrder.push_back(nonce);
+  return AUTH_OK;
+}
+
+std::string SIPDigestAuthEngine::createHA1Key(const std::string& user, const std::string& realm, Algorithm algorithm)
+{
+  std::string key;
+  key.reserve(user.size() + realm.size() + 3);
+  key += user;
+  key += '\n';
+  key += realm;
+  key += '\n';
+  key += (char)('0' + (int)get_base_algorithm(algorithm));
+  return key;
+}
+
+void SIPDigestAuthEngine::setHA1(const std::string& user, const std::string& realm, Algorithm algorithm, const Hash& ha1)
+{
+  std::string key = createHA1Key(user, realm, algorithm);
+  OSS::mutex_write_lock lock(_ha1Mutex);
+  HA1Cache::iterator iter = _ha1.find(key);
+  if (iter != _ha1.end())
+  {
+    iter->second.ha1 = ha1;
+    return;
+  }
+
+  while (_ha1.size() >= _maxHA1 && !_ha1Order.empty())
+  {
+    _ha1.erase(_ha1Order.front());
+    _ha1Order.pop_front();
+  }
+
+  HA1Entry entry;
+  entry.ha1 = ha1;
+  entry.order = _ha1Order.insert(_ha1Order.end(), key);
+  _ha1[key] = entry;
+}
+
+bool SIPDigestAuthEngine::getHA1(const std::string& user, const std::string& realm, Algorithm algorithm, Hash& ha1) const
+{
+  std::string key = createHA1Key(user, realm, algorithm);
+  OSS::mutex_read_lock lock(_ha1Mutex);
+  HA1Cache::const_iterator iter = _ha1.find(key);
+  if (iter == _ha1.end())
+    return false;
+  ha1 = iter->second.ha1;
+  return true;
+}
+
+void SIPDigestAuthEngine::removeHA1(const std::string& user, const std::string& realm)
+{
+  static const Algorithm algorithms[] = { ALGORITHM_MD5, ALGORITHM_SHA256 };
+  OSS::mutex_write_lock lock(_ha1Mutex);
+  for (std::size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++)
+  {
+    HA1Cache::iterator iter = _ha1.find(createHA1Key(user, realm, algorithms[i]));
+    if (iter != _ha1.end())
+    {
+      _ha1Order.erase(iter->second.order);
+      _ha1.erase(iter);
+    }
+  }
+}
+
+SIPDigestAuthEngine::Result SIPDigestAuthEngine::authenticate(const std::string& authorization, const char* method)
+{
+  return authenticate(authorization, method, (unsigned int)::time(0));
+}
+
+SIPDigestAuthEngine::Result SIPDigestAuthEngine::authenticate(const std::string& authorization, const char* method, unsigned int now)
+{
+  if (!method || authorization.empty())
+    return AUTH_MALFORMED;
+
+  SIPAuthorization auth(authorization);
+  std::string user = auth.getUserName();
+  std::string realm = auth.getRealm();
+  std::string nonce = auth.getNonce();
+  std::string uri = auth.getDigestUri();
+  std::string response = auth.getDigestResponse();
+  std::string qop = auth.getQop();
+  std::string cnonce = auth.getCNonce();
+  std::string nonceCount = auth.getNonceCount();
+  std::string algorithmName = auth.getAlgorithm();
+  SIPParser::unquoteString(algorithmName);
+
+  Algorithm algorithm = parseAlgorithm(algorithmName);
+  if (algorithm == ALGORITHM_UNKNOWN || user.empty() || nonce.empty() || uri.empty() || response.empty())
+    return AUTH_MALFORMED;
+
+  if (!qop.empty() && (cnonce.empty() || nonceCount.empty()))
+    return AUTH_MALFORMED;
+
+  if (is_session_algorithm(algorithm) && cnonce.empty())
+    return AUTH_MALFORMED;
+
+  Result result = validateNonce(nonce, now);
+  if (result != AUTH_OK)
+    return result;
+
+  Hash ha1;
+  if (!getHA1(user, realm, algorithm, ha1))
+  {
+    std::string password;
+    if (!_passwordLookup || !_passwordLookup(user, realm, password))
+      return AUTH_UNKNOWN_USER;
+    if (!computeHA1(algorithm, user, realm, password, ha1))
+      return AUTH_MALFORMED;
+    setHA1(user, realm, algorithm, ha1);
+  }
+
+  if (is_session_algorithm(algorithm))
+  {
+    Hash sessionHA1;
+    if (!computeSessionHA1(algorithm, ha1, nonce, cnonce, sessionHA1))
+      return AUTH_MALFORMED;
+    ha1 = sessionHA1;
+  }
+
+  Hash ha2;
+  Hash expected;
+  if (!computeHA2(algorithm, method, uri, ha2) ||
+    !computeResponse(algorithm, ha1, nonce, nonceCount, cnonce, qop, ha2, expected))
+  {
+    return AUTH_MALFORMED;
+  }
+
+  if (!expected.equals(response.data(), response.size()))
+    return AUTH_INVALID_RESPONSE;
+
+  //
+  // Only record the nonce-count after the response is verified so that
+  // forged requests cannot burn the counter of a legitimate client.
+  //
+  if (!qop.empty())
+    return checkNonceCount(nonce, nonceCount);
+
+  return AUTH_OK;
+}
+
+
+} } // OSS::SIP
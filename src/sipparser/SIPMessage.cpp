@@ -18,6 +18,7 @@
 //
 
 
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <boost/tokenizer.hpp>
@@ -34,8 +35,12 @@
 #include "OSS/SIP/SIPVia.h"
 #include "OSS/SIP/SIPCSeq.h"
 #include "OSS/SIP/SIPFrom.h"
+#include "OSS/SIP/SIPContact.h"
 #include "OSS/SIP/SIPRequestLine.h"
 
+
+OSS_SLAB_POOL(OSS::SIP::SIPMessage, "sip_message")
+
 namespace OSS {
 namespace SIP {
 
@@ -120,6 +125,7 @@ SIPMessage::SIPMessage(const SIPMessage& packet)
   _isRequest = packet._isRequest;
   _userData = packet._userData;
   _logContext = packet._logContext;
+  _headerCache = packet._headerCache;
   _consumeState = IDLE;
 }
 
@@ -138,6 +144,7 @@ void SIPMessage::swap(SIPMessage& packet)
   std::swap(_isResponse, packet._isResponse);
   std::swap(_isRequest, packet._isRequest);
   std::swap(_logContext, packet._logContext);
+  std::swap(_headerCache, packet._headerCache);
 }
 
 SIPMessage & SIPMessage::operator=(const SIPMessage & copy)
@@ -249,13 +256,14 @@ void SIPMessage::parse(std::string& data)
   
   _finalized = false;
   _startLine = "";
-  _body = "";
+  _body.reset();
   _badHeaders.clear();
   _headers.clear();
   _headerOffSet = 0;
   _expectedBodyLen = 0;
   _isResponse = boost::indeterminate;
   _isRequest = boost::indeterminate;
+  _headerCache.invalidate(HeaderCache::CACHE_ALL);
 
   _logContext = std::string();
   
@@ -267,7 +275,15 @@ void SIPMessage::parse(std::string& data)
       break;
   }
 
-  if ( messageSplit(data, headers, _body) )
+  std::string body;
+  bool split = messageSplit(data, headers, body);
+  if (!body.empty())
+  {
+    _body = boost::make_shared<std::string>();
+    _body->swap(body);
+  }
+
+  if (split)
   {
     if (headers.empty())
       return;
@@ -289,18 +305,14 @@ void SIPMessage::parse(std::string& data)
       std::string rawHeaderName = headerName;
       headerName = hdrGetExpandedForm(headerName);
       boost::to_lower(headerName);
-      if (_headers.find(headerName) == _headers.end())
+      HeaderTokensPtr& tokens = _headers[headerName];
+      if (!tokens)
       {
-        SIPHeaderTokens tokens;
-        tokens.rawHeaderName() = rawHeaderName;
-        tokens.headerOffSet() = _headerOffSet++;
-        tokens.push_back(headerValue);
-        _headers[headerName] = tokens;
-      }
-      else
-      {
-        _headers[headerName].push_back(headerValue);
+        tokens = boost::make_shared<SIPHeaderTokens>();
+        tokens->rawHeaderName() = rawHeaderName;
+        tokens->headerOffSet() = _headerOffSet++;
       }
+      tokens->push_back(headerValue);
     }
   }
   _finalized = true;
@@ -423,6 +435,45 @@ bool SIPMessage::messageSplit(
 
 
 
+const SIPHeaderTokens* SIPMessage::findHeader(const std::string& key) const
+{
+  HeaderMap::const_iterator iter = _headers.find(key);
+  if (iter == _headers.end())
+    return 0;
+  return iter->second.get();
+}
+
+SIPHeaderTokens* SIPMessage::modifyHeader(const std::string& key)
+{
+  HeaderMap::iterator iter = _headers.find(key);
+  if (iter == _headers.end())
+    return 0;
+  //
+  // A copy of this message still reads these tokens
+  //
+  if (!iter->second.unique())
+    iter->second = boost::make_shared<SIPHeaderTokens>(*iter->second);
+  return iter->second.get();
+}
+
+SIPHeaderTokens& SIPMessage::createHeader(const std::string& key, const char* rawHeaderName)
+{
+  HeaderTokensPtr& tokens = _headers[key];
+  tokens = boost::make_shared<SIPHeaderTokens>();
+  tokens->rawHeaderName() = rawHeaderName;
+  tokens->headerOffSet() = _headerOffSet++;
+  return *tokens;
+}
+
+std::string& SIPMessage::modifyBody()
+{
+  if (!_body)
+    _body = boost::make_shared<std::string>();
+  else if (!_body.unique())
+    _body = boost::make_shared<std::string>(*_body);
+  return *_body;
+}
+
 size_t SIPMessage::hdrPresent(const char * headerName) const
 {
   ReadLock lock(_rwlock);
@@ -434,11 +485,12 @@ size_t SIPMessage::hdrPresent(const char * headerName) const
 
   std::string key = headerName;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end())
+  const SIPHeaderTokens* tokens = findHeader(key);
+  if (!tokens)
   {
     return 0;
   }
-  return const_cast<SIPMessage*>(this)->_headers[key].size();
+  return tokens->size();
 }
 
 const std::string& SIPMessage::hdrGet(const char * headerName, size_t index) const
@@ -452,19 +504,12 @@ const std::string& SIPMessage::hdrGet(const char * headerName, size_t index) con
 
   std::string key = headerName;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end())
-  {
-    return _headerEmptyRet;
-  }
-  if (const_cast<SIPMessage*>(this)->_headers[key].size() == 0)
-  {
-    return _headerEmptyRet;
-  }
-  if (index >= const_cast<SIPMessage*>(this)->_headers[key].size())
+  const SIPHeaderTokens* tokens = findHeader(key);
+  if (!tokens || index >= tokens->size())
   {
     return _headerEmptyRet;
   }
-  return const_cast<SIPMessage*>(this)->_headers[key][index];
+  return (*tokens)[index];
 }
 
 bool SIPMessage::hdrSet(const char * headerName, const std::string& headerValue)
@@ -478,17 +523,15 @@ bool SIPMessage::hdrSet(const char * headerName, const std::string& headerValue)
 
   std::string key = headerName;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end() || _headers[key].size() == 0)
+  invalidateHeaderCache(key);
+  const SIPHeaderTokens* current = findHeader(key);
+  if (!current || current->empty())
   {
-    SIPHeaderTokens tokens;
-    tokens.push_back(headerValue);
-    tokens.rawHeaderName() = headerName;
-    tokens.headerOffSet() = _headerOffSet++;
-    _headers[key] = tokens;
+    createHeader(key, headerName).push_back(headerValue);
   }
   else
   {
-    _headers[key][0]=headerValue;
+    (*modifyHeader(key))[0] = headerValue;
   }
   return true;
 }
@@ -505,22 +548,20 @@ bool SIPMessage::hdrSet(const char* headerName, const std::string& headerValue,
 
   std::string key = headerName;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end() && index == 0)
+  invalidateHeaderCache(key);
+  const SIPHeaderTokens* current = findHeader(key);
+  if (!current && index == 0)
   {
-    SIPHeaderTokens tokens;
-    tokens.push_back(headerValue);
-    tokens.rawHeaderName() = headerName;
-    tokens.headerOffSet() = _headerOffSet++;
-    _headers[key] = tokens;
+    createHeader(key, headerName).push_back(headerValue);
     return true;
   }
 
-  if (_headers[key].size() == 0 || index >= _headers[key].size())
+  if (!current || index >= current->size())
   {
     return false;
   }
 
-  _headers[key][index]=headerValue;
+  (*modifyHeader(key))[index] = headerValue;
   return true;
 }
 
@@ -533,15 +574,17 @@ bool SIPMessage::hdrRemove(const char* headerName)
   }
   std::string key = headerName;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end())
+  const SIPHeaderTokens* tokens = findHeader(key);
+  if (!tokens)
   {
     return false;
   }
-  if (_headers[key].size() > 1)
+  if (tokens->size() > 1)
   {
     OSS_LOG_WARNING("SIPMessage::hdrRemove - Attempt to remove a header with more than one element! HeaderName: " << headerName);
     return false;
   }
+  invalidateHeaderCache(key);
   _headers.erase(key);
   return true;
 }
@@ -558,18 +601,13 @@ bool SIPMessage::hdrListAppend(const char* name, const std::string & value)
 
   std::string key = name;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end())
-  {
-    SIPHeaderTokens tokens;
-    tokens.push_back(value);
-    tokens.rawHeaderName() = name;
-    tokens.headerOffSet() = _headerOffSet++;
-    _headers[key] = tokens;
-  }
-  else
+  invalidateHeaderCache(key);
+  SIPHeaderTokens* tokens = modifyHeader(key);
+  if (!tokens)
   {
-    _headers[key].push_back(value);
+    tokens = &createHeader(key, name);
   }
+  tokens->push_back(value);
   return true;
 }
 
@@ -584,18 +622,13 @@ bool SIPMessage::hdrListPrepend(const char* name, const std::string& value)
 
   std::string key = name;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end())
-  {
-    SIPHeaderTokens tokens;
-    tokens.push_back(value);
-    tokens.rawHeaderName() = name;
-    tokens.headerOffSet() = _headerOffSet++;
-    _headers[key] = tokens;
-  }
-  else
+  invalidateHeaderCache(key);
+  SIPHeaderTokens* tokens = modifyHeader(key);
+  if (!tokens)
   {
-    _headers[key].push_front(value);
+    tokens = &createHeader(key, name);
   }
+  tokens->push_front(value);
   return true;
 }
 
@@ -608,11 +641,12 @@ std::string SIPMessage::hdrListPopFront(const char* headerName)
   }
   std::string key = headerName;
   boost::to_lower(key);
-  if (_headers.find(key)==_headers.end())
+  const SIPHeaderTokens* current = findHeader(key);
+  if (!current)
     return "";
-  SIPHeaderTokens& tokens = _headers[key];
+  invalidateHeaderCache(key);
   std::string front;
-  if (tokens.empty())
+  if (current->empty())
   {
     //
     // This should never happen but handle it just in case
@@ -620,14 +654,14 @@ std::string SIPMessage::hdrListPopFront(const char* headerName)
     _headers.erase(key);
     return _headerEmptyRet;
   }
-  else if (tokens.size() == 1)
+  else if (current->size() == 1)
   {
-    SIPHeaderTokens::iterator iter = tokens.begin();
-    front = *iter;
+    front = current->front();
     _headers.erase(key);
   }
   else
   {
+    SIPHeaderTokens& tokens = *modifyHeader(key);
     SIPHeaderTokens::iterator iter = tokens.begin();
     front = *iter;
     tokens.erase(iter);
@@ -646,6 +680,7 @@ bool SIPMessage::hdrListRemove(const char* headerName)
   boost::to_lower(key);
   if (_headers.find(key)==_headers.end())
     return false;
+  invalidateHeaderCache(key);
   _headers.erase(key);
   return true;
 }
@@ -663,67 +698,86 @@ const std::string& SIPMessage::hdrListBottom(const char* headerName) const
   }
 }
 
+static bool compareHeaderOffset(
+  const std::pair<size_t, SIPHeaderTokens*>& a,
+  const std::pair<size_t, SIPHeaderTokens*>& b)
+{
+  return a.first < b.first;
+}
+
 bool SIPMessage::commitData(std::string& data)
 {
   WriteLock lock(_rwlock);
 
-  std::ostringstream strm;
-  strm << _startLine << CRLF;
-  SIPHeaderList::iterator iter;
-  typedef std::map<size_t,SIPHeaderTokens*> sorted;
-  sorted sortedHeaders; 
-  for (iter = _headers.begin(); iter != _headers.end(); iter++)
+  //
+  // Headers are written in the order they were first seen.  The exact size
+  // is computed first so the message is assembled in a single allocation.
+  //
+  typedef std::vector<std::pair<size_t, SIPHeaderTokens*> > sorted;
+  sorted sortedHeaders;
+  sortedHeaders.reserve(_headers.size());
+  size_t length = _startLine.size() + 4;
+  for (HeaderMap::iterator iter = _headers.begin(); iter != _headers.end(); iter++)
   {
-    SIPHeaderTokens & tokens = iter->second;
-    sortedHeaders[tokens.headerOffSet()] = &tokens;
+    SIPHeaderTokens& tokens = *iter->second;
+    sortedHeaders.push_back(std::make_pair(tokens.headerOffSet(), &tokens));
+    for (SIPHeaderTokens::const_iterator headerIter = tokens.begin(); headerIter != tokens.end(); headerIter++)
+    {
+      if (!headerIter->empty())
+        length += tokens.rawHeaderName().size() + headerIter->size() + 4;
+    }
   }
+  std::sort(sortedHeaders.begin(), sortedHeaders.end(), compareHeaderOffset);
+  if (_body)
+    length += _body->size();
 
-  sorted::iterator siter;
-  for (siter = sortedHeaders.begin(); siter != sortedHeaders.end(); siter++)
+  std::string strm;
+  strm.reserve(length);
+  strm.append(_startLine).append(CRLF);
+  for (sorted::const_iterator siter = sortedHeaders.begin(); siter != sortedHeaders.end(); siter++)
   {
-    SIPHeaderTokens * tokens = siter->second;
-    SIPHeaderTokens::iterator headerIter;
-    for (headerIter = tokens->begin(); headerIter != tokens->end(); headerIter++)
+    SIPHeaderTokens* tokens = siter->second;
+    for (SIPHeaderTokens::const_iterator headerIter = tokens->begin(); headerIter != tokens->end(); headerIter++)
     {
-      if (!headerIter->empty()) 
-        strm << siter->second->rawHeaderName() << ": " << *headerIter << CRLF;
+      if (!headerIter->empty())
+        strm.append(tokens->rawHeaderName()).append(": ").append(*headerIter).append(CRLF);
     }
   }
-  strm << CRLF;
-  if (!_body.empty())
-    strm << _body;
-  data = strm.str();
+  strm.append(CRLF);
+  if (_body && !_body->empty())
+    strm.append(*_body);
+  data.swap(strm);
   return true;
 }
 
-bool SIPMessage::getTransactionId(std::string& transactionId, const char* method_) const
+bool SIPMessage::getTransactionId(std::string& transactionId, const char* method) const
 {
-  
-  ReadLock lock(_rwlock);
-  std::string viaStr = hdrGet(OSS::SIP::HDR_VIA);
-  std::string callIdStr = hdrGet(OSS::SIP::HDR_CALL_ID);
-  std::string cseqStr = hdrGet(OSS::SIP::HDR_CSEQ);
+  if (method)
+    return computeTransactionId(transactionId, method);
+
+  transactionId = getCachedHeaderValue(HeaderCache::CACHE_TRANSACTION_ID, &HeaderCache::transactionId);
+  return !transactionId.empty();
+}
 
-  if (viaStr.empty() || callIdStr.empty() || cseqStr.empty())
+bool SIPMessage::computeTransactionId(std::string& transactionId, const char* method_) const
+{
+  std::string callIdStr = getCallId();
+  if (callIdStr.empty() || hdrGet(OSS::SIP::HDR_VIA).empty())
     return false;
 
-  SIPCSeq cseq(cseqStr);
   std::string method;
   if (method_ == 0)
-    method = cseq.getMethod();
+    method = getMethod();
   else
     method = method_;
 
-  std::string number = cseq.getNumber();
+  std::string number = getCSeqNumber();
 
   if (method.empty() || number.empty())
     return false;
 
-  SIPVia via(viaStr);
-  std::string id = via.getBranch();
-  if( id.empty() && callIdStr.empty())
-    return false;
-  else if (id.empty())
+  std::string id = getTopViaBranch();
+  if (id.empty())
     id = callIdStr;
 
   boost::to_lower(method);
@@ -874,22 +928,23 @@ boost::tribool SIPMessage::isFinalResponse() const
 
 std::string SIPMessage::getMethod() const
 {
-  SIPCSeq cseq;
-  cseq = hdrGet(OSS::SIP::HDR_CSEQ);
-  return cseq.getMethod();
+  return getCachedHeaderValue(HeaderCache::CACHE_CSEQ, &HeaderCache::cseqMethod);
 }
 
-boost::tribool SIPMessage::isMidDialog() const
+std::string SIPMessage::getCSeqNumber() const
+{
+  return getCachedHeaderValue(HeaderCache::CACHE_CSEQ, &HeaderCache::cseqNumber);
+}
+
+std::string SIPMessage::getCallId() const
 {
-  SIPFrom from;
-  SIPTo to;
-  from = hdrGet(OSS::SIP::HDR_FROM);
-  to = hdrGet(OSS::SIP::HDR_TO);
+  return getCachedHeaderValue(HeaderCache::CACHE_CALL_ID, &HeaderCache::callId);
+}
 
-  std::string fromTag;
-  std::string toTag;
-  fromTag = from.getHeaderParam("tag");
-  toTag = to.getHeaderParam("tag");
+boost::tribool SIPMessage::isMidDialog() const
+{
+  std::string fromTag = getFromTag();
+  std::string toTag = getToTag();
 
   if (!fromTag.empty() && !toTag.empty())
     return true;
@@ -901,15 +956,8 @@ boost::tribool SIPMessage::isMidDialog() const
 
 std::string SIPMessage::getDialogId(bool asSender) const
 {
-  SIPFrom from;
-  SIPTo to;
-  from = hdrGet(OSS::SIP::HDR_FROM);
-  to = hdrGet(OSS::SIP::HDR_TO);
-
-  std::string fromTag;
-  std::string toTag;
-  fromTag = from.getHeaderParam("tag");
-  toTag = to.getHeaderParam("tag");
+  std::string fromTag = getFromTag();
+  std::string toTag = getToTag();
 
   if (fromTag.empty() || toTag.empty())
     return std::string();
@@ -1201,8 +1249,8 @@ boost::tribool SIPMessage::consumeOne(char input)
       return false;
     }
   case EXPECTING_BODY:
-    _body.push_back(input);
-    if (_body.size() < _expectedBodyLen)
+    modifyBody().push_back(input);
+    if (_body->size() < _expectedBodyLen)
     {
       return boost::indeterminate;
     }
@@ -1554,18 +1602,24 @@ void SIPMessage::setData(const std::string& data)
 const std::string& SIPMessage::getBody() const
 {
   ReadLock lock(_rwlock);
-  return _body;
+  return _body ? *_body : _headerEmptyRet;
 }
 
 void SIPMessage::setBody(const std::string& body)
 {
   WriteLock lock(_rwlock);
-  _body = body;
+  //
+  // Never write through a body that a copy of this message still shares
+  //
+  if (body.empty())
+    _body.reset();
+  else
+    _body = boost::make_shared<std::string>(body);
 }
 
 void SIPMessage::updateLength()
 {
-  std::string newLen = OSS::string_from_number<size_t>(_body.length());
+  std::string newLen = OSS::string_from_number<size_t>(_body ? _body->length() : 0);
   hdrSet(OSS::SIP::HDR_CONTENT_LENGTH, newLen);
 }
 
@@ -1585,22 +1639,40 @@ void SIPMessage::setProperty(const std::string& property, const std::string& val
 {
   if (property.empty())
     return;
-  
+
+  PropertyMap::Enum slot = PropertyMap::propertyEnum(property);
+  if (slot != PropertyMap::PROP_Max)
+  {
+    setProperty(slot, value);
+    return;
+  }
+
   WriteLock lock(_rwlock);
   _properties[property] = value;
 }
 
+void SIPMessage::setProperty(PropertyMap::Enum property, const std::string& value)
+{
+  WriteLock lock(_rwlock);
+  _propertyValues.set(property, value);
+}
+
 void SIPMessage::clearProperties()
 {
   WriteLock lock(_rwlock);
   _properties.clear();
+  _propertyValues.clear();
 }
 
 bool SIPMessage::getProperty(const std::string&  property, std::string& value) const
 {
   if (property.empty())
     return false;
-  
+
+  PropertyMap::Enum slot = PropertyMap::propertyEnum(property);
+  if (slot != PropertyMap::PROP_Max)
+    return getProperty(slot, value);
+
   ReadLock lock(_rwlock);
   CustomProperties::const_iterator iter = _properties.find(property);
   if (iter != _properties.end())
@@ -1611,6 +1683,12 @@ bool SIPMessage::getProperty(const std::string&  property, std::string& value) c
   return false;
 }
 
+bool SIPMessage::getProperty(PropertyMap::Enum property, std::string& value) const
+{
+  ReadLock lock(_rwlock);
+  return _propertyValues.get(property, value);
+}
+
 boost::tribool SIPMessage::is1xx(int code) const
 {
   if (!code)
@@ -1716,12 +1794,12 @@ std::string SIPMessage::createLoggerData(SIPMessage* pMsg)
   WriteLock lock(pMsg->_rwlock);
   std::ostringstream strm;
   strm << CRLF << "{" << CRLF << cid << pMsg->_startLine;
-  SIPHeaderList::iterator iter;
+  HeaderMap::iterator iter;
   typedef std::map<size_t,SIPHeaderTokens*> sorted;
   sorted sortedHeaders;
   for (iter = pMsg->_headers.begin(); iter != pMsg->_headers.end(); iter++)
   {
-    SIPHeaderTokens & tokens = iter->second;
+    SIPHeaderTokens & tokens = *iter->second;
     sortedHeaders[tokens.headerOffSet()] = &tokens;
   }
 
@@ -1737,10 +1815,10 @@ std::string SIPMessage::createLoggerData(SIPMessage* pMsg)
     }
   }
   
-  if (!pMsg->_body.empty())
+  if (pMsg->_body && !pMsg->_body->empty())
   {
     strm << CRLF << cid;
-    std::vector<std::string> tokens = OSS::string_tokenize(pMsg->_body, CRLF);
+    std::vector<std::string> tokens = OSS::string_tokenize(*pMsg->_body, CRLF);
     for (std::vector<std::string>::const_iterator iter = tokens.begin(); iter != tokens.end(); iter++)
       strm  << CRLF << cid << *iter;
   }
@@ -1773,13 +1851,7 @@ std::string SIPMessage::createLoggerData(SIPMessage* pMsg)
  
 std::string SIPMessage::getFromTag() const
 {
-  std::string tag;
-  std::string from(hdrGet(OSS::SIP::HDR_FROM));
-  if (!from.empty())
-  {
-    tag = SIPFrom::getTag(from);
-  }
-  return tag;
+  return getCachedHeaderValue(HeaderCache::CACHE_FROM, &HeaderCache::fromTag);
 }
 
 std::string SIPMessage::getFromHost() const
@@ -1816,34 +1888,173 @@ std::string SIPMessage::getToHostPort() const
 
 std::string SIPMessage::getToTag() const
 {
-  std::string tag;
-  std::string to(hdrGet(OSS::SIP::HDR_TO));
-  if (!to.empty())
+  return getCachedHeaderValue(HeaderCache::CACHE_TO, &HeaderCache::toTag);
+}
+
+std::string SIPMessage::getTopViaBranch() const
+{
+  return getCachedHeaderValue(HeaderCache::CACHE_VIA, &HeaderCache::topViaBranch);
+}
+
+std::string SIPMessage::getTopVia() const
+{
+  return getCachedHeaderValue(HeaderCache::CACHE_VIA, &HeaderCache::topVia);
+}
+
+std::string SIPMessage::getTopContact() const
+{
+  return getCachedHeaderValue(HeaderCache::CACHE_CONTACT, &HeaderCache::topContact);
+}
+
+void SIPMessage::getHeaderNames(std::set<std::string>& headers) const
+{
+  for (HeaderMap::const_iterator iter = _headers.begin(); iter != _headers.end(); iter++)
   {
-    tag = SIPFrom::getTag(to);
+    headers.insert(iter->first);
   }
-  return tag;
 }
 
-std::string SIPMessage::getTopViaBranch() const
+std::string SIPMessage::getCachedHeaderValue(HeaderCache::Entry entry, std::string HeaderCache::* field) const
 {
-  std::string branch;
-  std::string via(hdrGet(OSS::SIP::HDR_VIA));
-  if (!via.empty())
+  unsigned int generation = 0;
   {
-    SIPVia::getBranch(via, branch);
+    ReadLock lock(_rwlock);
+    if (_headerCache.valid & entry)
+      return _headerCache.*field;
+    generation = _headerCache.generation;
   }
-  return branch;
+
+  //
+  // Compute outside of the lock.  The hdrGet() calls below acquire
+  // their own read lock.
+  //
+  HeaderCache computed;
+  computeHeaderCache(entry, computed);
+
+  {
+    //
+    // Only store the result if no header was modified while we were
+    // computing it.  Otherwise, we would be caching a stale value.
+    //
+    WriteLock lock(_rwlock);
+    if (_headerCache.generation == generation)
+    {
+      switch (entry)
+      {
+        case HeaderCache::CACHE_VIA:
+          _headerCache.topVia = computed.topVia;
+          _headerCache.topViaBranch = computed.topViaBranch;
+          break;
+        case HeaderCache::CACHE_FROM:
+          _headerCache.fromTag = computed.fromTag;
+          break;
+        case HeaderCache::CACHE_TO:
+          _headerCache.toTag = computed.toTag;
+          break;
+        case HeaderCache::CACHE_CSEQ:
+          _headerCache.cseqMethod = computed.cseqMethod;
+          _headerCache.cseqNumber = computed.cseqNumber;
+          break;
+        case HeaderCache::CACHE_CALL_ID:
+          _headerCache.callId = computed.callId;
+          break;
+        case HeaderCache::CACHE_CONTACT:
+          _headerCache.topContact = computed.topContact;
+          break;
+        case HeaderCache::CACHE_TRANSACTION_ID:
+          _headerCache.transactionId = computed.transactionId;
+          break;
+        default:
+          return computed.*field;
+      }
+      _headerCache.valid |= entry;
+    }
+  }
+
+  return computed.*field;
 }
 
-void SIPMessage::getHeaderNames(std::set<std::string>& headers) const
+void SIPMessage::computeHeaderCache(HeaderCache::Entry entry, HeaderCache& cache) const
 {
-  for (SIPHeaderList::const_iterator iter = _headers.begin(); iter != _headers.end(); iter++)
+  switch (entry)
   {
-    headers.insert(iter->first);
+    case HeaderCache::CACHE_VIA:
+    {
+      std::string via(hdrGet(OSS::SIP::HDR_VIA));
+      if (!via.empty())
+      {
+        SIPVia::getTopVia(via, cache.topVia);
+        SIPVia::getBranch(via, cache.topViaBranch);
+      }
+      break;
+    }
+    case HeaderCache::CACHE_FROM:
+    {
+      std::string from(hdrGet(OSS::SIP::HDR_FROM));
+      if (!from.empty())
+        cache.fromTag = SIPFrom::getTag(from);
+      break;
+    }
+    case HeaderCache::CACHE_TO:
+    {
+      std::string to(hdrGet(OSS::SIP::HDR_TO));
+      if (!to.empty())
+        cache.toTag = SIPFrom::getTag(to);
+      break;
+    }
+    case HeaderCache::CACHE_CSEQ:
+    {
+      SIPCSeq cseq(hdrGet(OSS::SIP::HDR_CSEQ));
+      cache.cseqMethod = cseq.getMethod();
+      cache.cseqNumber = cseq.getNumber();
+      break;
+    }
+    case HeaderCache::CACHE_CALL_ID:
+      cache.callId = hdrGet(OSS::SIP::HDR_CALL_ID);
+      break;
+    case HeaderCache::CACHE_CONTACT:
+    {
+      std::string contact(hdrGet(OSS::SIP::HDR_CONTACT));
+      if (!contact.empty())
+      {
+        ContactURI uri;
+        if (SIPContact::getAt(contact, uri, 0))
+          cache.topContact = uri.data();
+      }
+      break;
+    }
+    case HeaderCache::CACHE_TRANSACTION_ID:
+      computeTransactionId(cache.transactionId, 0);
+      break;
+    default:
+      break;
   }
 }
 
+unsigned int SIPMessage::headerCacheEntries(const std::string& key)
+{
+  if (key == "via" || key == "v")
+    return HeaderCache::CACHE_VIA | HeaderCache::CACHE_TRANSACTION_ID;
+  else if (key == "from" || key == "f")
+    return HeaderCache::CACHE_FROM;
+  else if (key == "to" || key == "t")
+    return HeaderCache::CACHE_TO;
+  else if (key == "cseq")
+    return HeaderCache::CACHE_CSEQ | HeaderCache::CACHE_TRANSACTION_ID;
+  else if (key == "call-id" || key == "i")
+    return HeaderCache::CACHE_CALL_ID | HeaderCache::CACHE_TRANSACTION_ID;
+  else if (key == "contact" || key == "m")
+    return HeaderCache::CACHE_CONTACT;
+  return 0;
+}
+
+void SIPMessage::invalidateHeaderCache(const std::string& key)
+{
+  unsigned int entries = headerCacheEntries(key);
+  if (entries)
+    _headerCache.invalidate(entries);
+}
+
 
 
 
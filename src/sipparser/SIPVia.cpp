@@ -83,11 +83,11 @@ bool SIPVia::getSentBy(const std::string& via, std::string& sentBy)
   typedef ABNFLRSequence5<ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token> _pvar1; //sent-protocol =  protocol-name SLASH protocol-version SLASH transport
   static ABNFLRSequence3<_pvar1, ABNF_SIP_LWS, ABNF_SIP_hostport> parser;
   
-  ABNFTokens tokens;  
-  parser.parseTokens(via.c_str(), tokens);
+  ABNFTokenRanges tokens;
+  parser.parseTokenRanges(via.c_str(), tokens);
   if (tokens.size() != 3)
     return false;
-  sentBy = tokens[2];
+  sentBy.assign(via, tokens[2].offset, tokens[2].length);
   return true;
 }
 
@@ -101,13 +101,14 @@ bool SIPVia::getSentBy(const std::string& via, std::string& sentBy)
    typedef ABNFLRSequence5<ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token> _pvar1; //sent-protocol =  protocol-name SLASH protocol-version SLASH transport
   static ABNFLRSequence3<_pvar1, ABNF_SIP_LWS, ABNF_SIP_hostport> parser;
   
-  ABNFTokens tokens;  
-  parser.parseTokens(via.c_str(), tokens);
+  ABNFTokenRanges tokens;
+  parser.parseTokenRanges(via.c_str(), tokens);
   if (tokens.size() != 3)
     return false;
   
   std::ostringstream newData;
-  newData << tokens[0] << " " << hostPort;
+  newData.write(via.data() + tokens[0].offset, tokens[0].length);
+  newData << " " << hostPort;
   
   //
   // append the parameters
@@ -138,11 +139,11 @@ bool SIPVia::getTransport(const std::string& via, std::string& transport)
 {
   ABNFLRSequence5<ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token> parser; //sent-protocol =  protocol-name SLASH protocol-version SLASH transport
 
-  ABNFTokens tokens;  
-  parser.parseTokens(via.c_str(), tokens);
+  ABNFTokenRanges tokens;
+  parser.parseTokenRanges(via.c_str(), tokens);
   if (tokens.size() != 5)
     return false;
-  transport = tokens[4];
+  transport.assign(via, tokens[4].offset, tokens[4].length);
   return true;
 }
 
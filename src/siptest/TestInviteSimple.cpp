@@ -117,7 +117,7 @@ void uac_send_ack_for_invite(SIPEndpoint* pEndpoint, const SIPEndpoint::Endpoint
   //
   pRequest->hdrRemove(OSS::SIP::HDR_CONTENT_LENGTH);
   pRequest->hdrRemove(OSS::SIP::HDR_CONTENT_TYPE);
-  pRequest->body() = std::string();
+  pRequest->setBody(std::string());
   
   SIPMessage::Ptr pAck(pRequest);
   pEndpoint->sendEndpointRequest(pAck, uacHostPort, uasHostPort);
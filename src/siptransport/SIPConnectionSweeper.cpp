@@ -0,0 +1,91 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <boost/bind.hpp>
+#include "OSS/SIP/SIPConnectionSweeper.h"
+#include "OSS/UTL/Logger.h"
+
+namespace OSS {
+namespace SIP {
+
+
+SIPConnectionSweeper::SIPConnectionSweeper(const std::string& owner, ConnectionIndex& connections) :
+  _owner(owner),
+  _connections(connections),
+  _pTimer(0)
+{
+}
+
+SIPConnectionSweeper::~SIPConnectionSweeper()
+{
+  stop();
+}
+
+void SIPConnectionSweeper::start(boost::asio::io_service& ioService, unsigned int idleTimeout)
+{
+  stop();
+  _connections.setIdleTimeout(idleTimeout);
+  if (!idleTimeout)
+    return;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _pTimer = new boost::asio::deadline_timer(ioService);
+  _pTimer->expires_from_now(boost::posix_time::seconds(1));
+  _pTimer->async_wait(boost::bind(&SIPConnectionSweeper::handleSweep, this, boost::asio::placeholders::error));
+}
+
+void SIPConnectionSweeper::stop()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pTimer)
+  {
+    _pTimer->cancel();
+    delete _pTimer;
+    _pTimer = 0;
+  }
+  _connections.setIdleTimeout(0);
+}
+
+void SIPConnectionSweeper::handleSweep(const boost::system::error_code& e)
+{
+  if (e == boost::asio::error::operation_aborted)
+    return;
+
+  ConnectionIndex::ConnectionList expired;
+  _connections.collectIdle(std::time(0), expired);
+  for (ConnectionIndex::ConnectionList::iterator iter = expired.begin(); iter != expired.end(); iter++)
+  {
+    OSS_LOG_INFO(_owner << " closing idle transport (" << (*iter)->getIdentifier() << ") "
+      << (*iter)->getLocalAddress().toIpPortString() <<
+      "->" << (*iter)->getRemoteAddress().toIpPortString());
+    (*iter)->stop();
+  }
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_pTimer)
+  {
+    _pTimer->expires_from_now(boost::posix_time::seconds(1));
+    _pTimer->async_wait(boost::bind(&SIPConnectionSweeper::handleSweep, this, boost::asio::placeholders::error));
+  }
+}
+
+
+} } // OSS::SIP
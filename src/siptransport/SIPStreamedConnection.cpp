@@ -319,6 +319,8 @@ void SIPStreamedConnection::handleRead(const boost::system::error_code& e, std::
   
   if (!e && bytes_transferred)
   {
+    touch();
+
     //
     // set the last read address
     //
@@ -339,7 +341,10 @@ void SIPStreamedConnection::handleRead(const boost::system::error_code& e, std::
     _readExceptionCount = 0;
 
     if (!_pRequest)
+    {
       _pRequest = SIPMessage::Ptr(new SIPMessage());
+      _pRequest->setSingleOwner(true);
+    }
 
     _bytesRead =  bytes_transferred;
     
@@ -362,8 +367,11 @@ void SIPStreamedConnection::handleRead(const boost::system::error_code& e, std::
       }
       else
       {
-        dispatchMessage(_pRequest->shared_from_this(), shared_from_this());
+        //
+        // The message belongs to the dispatcher once it is handed over
+        //
         rateLimit().logPacket(_lastReadAddress.address(), _pRequest->data().size());
+        dispatchMessage(_pRequest->shared_from_this(), shared_from_this());
       }
       
       if (tail >= end)
@@ -392,6 +400,7 @@ void SIPStreamedConnection::handleRead(const boost::system::error_code& e, std::
           tailIteration++;
           /// Reset the SIP Message
           _pRequest.reset(new SIPMessage());
+          _pRequest->setSingleOwner(true);
 
           ret = _pRequest->consume(tail, end);
           result = ret.get<0>();
@@ -29,6 +29,7 @@ namespace SIP {
 
 
 SIPStreamedConnectionManager::SIPStreamedConnectionManager(const SIPTransportSession::Dispatch& dispatch): 
+  _sweeper("SIPStreamedConnectionManager", _connections),
   _dispatch(dispatch),
   _portBase(10000),
   _portMax(12000)
@@ -48,12 +49,17 @@ void SIPStreamedConnectionManager::deinitialize()
 {
 }
 
+OSS::UInt64 SIPStreamedConnectionManager::nextIdentifier()
+{
+  OSS::mutex_critic_sec_lock lock(_identifierMutex);
+  return ++_currentIdentifier;
+}
+
 void SIPStreamedConnectionManager::add(SIPStreamedConnection::Ptr conn)
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
   if (!conn->getIdentifier())
-    conn->setIdentifier(++_currentIdentifier);
-  _connections[conn->getIdentifier()] = conn;
+    conn->setIdentifier(nextIdentifier());
+  _connections.insert(conn, conn->getRemoteAddress());
   OSS_LOG_INFO("SIPStreamedConnectionManager Added transport (" << conn->getIdentifier() << ") "
     << conn->getLocalAddress().toIpPortString() <<
     "->" << conn->getRemoteAddress().toIpPortString() << " Count: " << _connections.size() );
@@ -61,10 +67,9 @@ void SIPStreamedConnectionManager::add(SIPStreamedConnection::Ptr conn)
 
 void SIPStreamedConnectionManager::start(SIPStreamedConnection::Ptr conn)
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
   if (!conn->getIdentifier())
-    conn->setIdentifier(++_currentIdentifier);
-  _connections[conn->getIdentifier()] = conn;
+    conn->setIdentifier(nextIdentifier());
+  _connections.insert(conn, conn->getRemoteAddress());
   conn->start(_dispatch);
   OSS_LOG_INFO("SIPStreamedConnectionManager started reading from transport (" << conn->getIdentifier() << ") "
     << conn->getLocalAddress().toIpPortString() <<
@@ -73,54 +78,56 @@ void SIPStreamedConnectionManager::start(SIPStreamedConnection::Ptr conn)
 
 void SIPStreamedConnectionManager::stop(SIPStreamedConnection::Ptr conn)
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
+  _connections.remove(conn->getIdentifier());
 
   OSS_LOG_INFO("Deleting SIPStreamedConnection transport (" << conn->getIdentifier() << ") "
     << conn->getLocalAddress().toIpPortString() <<
-    "->" << conn->getRemoteAddress().toIpPortString() << " Count: " << _connections.size() - 1);
+    "->" << conn->getRemoteAddress().toIpPortString() << " Count: " << _connections.size());
 
-  _connections.erase(conn->getIdentifier());
   conn->stop();
 }
 
 void SIPStreamedConnectionManager::stopAll()
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
-  for (std::map<OSS::UInt64, SIPStreamedConnection::Ptr>::iterator iter = _connections.begin();
-    iter != _connections.end(); iter++)
+  ConnectionIndex::ConnectionList connections;
+  _connections.removeAll(connections);
+  for (ConnectionIndex::ConnectionList::iterator iter = connections.begin();
+    iter != connections.end(); iter++)
   {
-    iter->second->stop();
+    (*iter)->stop();
   }
-  _connections.clear();
 }
 
 SIPStreamedConnection::Ptr SIPStreamedConnectionManager::findConnectionByAddress(const OSS::Net::IPAddress& target)
 {
-  OSS::mutex_read_lock rlock(_rwConnectionsMutex);
-  for (std::map<OSS::UInt64, SIPStreamedConnection::Ptr>::iterator iter = _connections.begin();
-    iter != _connections.end(); iter++)
-  {
-    if (iter->second->getRemoteAddress().compare(target, true))
-      return iter->second;
-  }
-  return SIPStreamedConnection::Ptr();
+  return _connections.findByEndpoint(target);
 }
 
 SIPStreamedConnection::Ptr SIPStreamedConnectionManager::findConnectionById(OSS::UInt64 identifier)
 {
-  OSS::mutex_read_lock rlock(_rwConnectionsMutex);
-  if (_connections.find(identifier) != _connections.end())
+  SIPStreamedConnection::Ptr conn = _connections.findById(identifier);
+  if (conn)
   {
-    SIPStreamedConnection::Ptr conn = _connections[identifier];
-    if (conn)
-    {
-      OSS_LOG_INFO("SIPStreamedConnectionManager::findConnectionById got transport (" << conn->getIdentifier() << ") "
-      << conn->getLocalAddress().toIpPortString() <<
-      "->" << conn->getRemoteAddress().toIpPortString() );
-    }
-    return conn;
+    OSS_LOG_INFO("SIPStreamedConnectionManager::findConnectionById got transport (" << conn->getIdentifier() << ") "
+    << conn->getLocalAddress().toIpPortString() <<
+    "->" << conn->getRemoteAddress().toIpPortString() );
   }
-  return SIPStreamedConnection::Ptr();
+  return conn;
+}
+
+std::size_t SIPStreamedConnectionManager::getConnectionCount() const
+{
+  return _connections.size();
+}
+
+void SIPStreamedConnectionManager::startIdleSweeper(boost::asio::io_service& ioService, unsigned int idleTimeout)
+{
+  _sweeper.start(ioService, idleTimeout);
+}
+
+void SIPStreamedConnectionManager::stopIdleSweeper()
+{
+  _sweeper.stop();
 }
 
 } } // OSS::SIP
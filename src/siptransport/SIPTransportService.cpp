@@ -24,11 +24,15 @@
 #include "OSS/SIP/SIPVia.h"
 #include "OSS/SIP/SIPException.h"
 #include "OSS/UTL/Logger.h"
+#include "OSS/UTL/Metrics.h"
 
 
 namespace OSS {
 namespace SIP {
 
+static OSS::LatencyHistogram& gClientTransportLatency = OSS::Metrics::instance().histogram(
+  "sip_client_transport_microseconds", "Time spent finding or connecting the transport of outbound messages");
+
  
 SIPTransportService::SIPTransportService(const SIPTransportSession::Dispatch& dispatch):
   _ioService(),
@@ -51,7 +55,8 @@ SIPTransportService::SIPTransportService(const SIPTransportSession::Dispatch& di
  ,_wsConMgr(_dispatch),
   _wsEnabled(true),
   _wsPortBase(10000),
-  _wsPortMax(20000)
+  _wsPortMax(20000),
+  _wsThreadCount(1)
 #endif
 {
 }
@@ -297,8 +302,23 @@ void SIPTransportService::stop()
   }
 }
 
+void SIPTransportService::setIdleConnectionTimeout(unsigned int seconds)
+{
+  _tcpConMgr.startIdleSweeper(_ioService, seconds);
+  _tlsConMgr.startIdleSweeper(_ioService, seconds);
+#if ENABLE_FEATURE_WEBSOCKETS
+  _wsConMgr.startIdleSweeper(_ioService, seconds);
+#endif
+}
+
 void SIPTransportService::handleStop()
 {
+  _tcpConMgr.stopIdleSweeper();
+  _tlsConMgr.stopIdleSweeper();
+#if ENABLE_FEATURE_WEBSOCKETS
+  _wsConMgr.stopIdleSweeper();
+#endif
+
   UDPListeners::iterator udpIter;
   for (udpIter = _udpListeners.begin(); udpIter != _udpListeners.end(); udpIter++)
     udpIter->second->handleStop();
@@ -488,6 +508,7 @@ void SIPTransportService::addWSTransport(const std::string& ip, const std::strin
     throw OSS::SIP::SIPException("Duplicate WebSocket transport while calling addWSTransport()");
   SIPWebSocketListener::Ptr pWsListener = SIPWebSocketListener::Ptr(new SIPWebSocketListener(this, ip, port, _wsConMgr));
   
+  pWsListener->setThreadCount(_wsThreadCount);
   pWsListener->setVirtual(isVirtualIp);
   pWsListener->setExternalAddress(externalIp);
   pWsListener->subNets() = subnets;
@@ -541,6 +562,8 @@ SIPTransportSession::Ptr SIPTransportService::createClientTransport(
   const std::string& proto_,
   const std::string& transportId)
 {
+  OSS::Metrics::Timer timer(gClientTransportLatency);
+
   std::string logId = pMsg->createContextId(true);
   std::string requirePersistentValue;
   pMsg->getProperty(OSS::PropertyMap::PROP_RequirePersistentConnection, requirePersistentValue);
@@ -785,6 +808,23 @@ void SIPTransportService::sendUDPKeepAlive(const OSS::Net::IPAddress& localAddre
   }
 }
 
+std::size_t SIPTransportService::sendUDPKeepAlive(const OSS::Net::IPAddress& localAddress,
+    const std::vector<OSS::Net::IPAddress>& targets)
+{
+  std::string key;
+  OSS::string_sprintf_string<256>(key, "%s:%u", localAddress.toString().c_str(), localAddress.getPort());
+  UDPListeners::iterator iter = _udpListeners.find(key);
+  if (iter == _udpListeners.end())
+    return 0;
+  SIPTransportSession::Ptr conn = iter->second->connection();
+  if (!conn)
+    return 0;
+  //
+  // UDP listeners always own a SIPUDPConnection
+  //
+  return static_cast<SIPUDPConnection*>(conn.get())->writeKeepAlive(targets);
+}
+
 
 #if 0
 //
@@ -43,7 +43,8 @@ SIPTransportSession::SIPTransportSession(SIPListener* pListener) :
   _isClient(false),
   _isEndpoint(false),
   _isConnected(false),
-  _pListener(pListener)
+  _pListener(pListener),
+  _lastActivity(std::time(0))
 {
 }
 
@@ -34,6 +34,12 @@
 #include "OSS/UTL/PropertyMap.h"
 #include "OSS/SIP/SIPListener.h"
 
+#if OSS_OS == OSS_OS_LINUX
+#include <sys/socket.h>
+#include <cstring>
+#include <cerrno>
+#endif
+
 
 namespace OSS {
 namespace SIP {
@@ -116,7 +122,10 @@ void SIPUDPConnection::handleRead(const boost::system::error_code& e, std::size_
   if (!e)
   {
     if (_pRequest == 0)
+    {
       _pRequest = SIPMessage::Ptr(new SIPMessage());
+      _pRequest->setSingleOwner(true);
+    }
 
     _bytesRead =  bytes_transferred;
     if (_bytesRead > 20)
@@ -306,6 +315,82 @@ bool SIPUDPConnection::writeKeepAlive(const std::string& ip, const std::string&
   return false;
 }
 
+std::size_t SIPUDPConnection::writeKeepAlive(const std::vector<OSS::Net::IPAddress>& targets)
+{
+  static const char crlf[] = "\r\n\r\n";
+
+  if (!_socket.is_open() || targets.empty())
+    return 0;
+
+  std::size_t sent = 0;
+#if OSS_OS == OSS_OS_LINUX
+  enum { BATCH_SIZE = 64 };
+  boost::array<boost::asio::ip::udp::endpoint, BATCH_SIZE> endpoints;
+  boost::array<struct mmsghdr, BATCH_SIZE> headers;
+  struct iovec iov;
+  iov.iov_base = const_cast<char*>(crlf);
+  iov.iov_len = 4;
+
+  std::size_t failed = 0;
+  int lastError = 0;
+  std::size_t next = 0;
+  while (next < targets.size())
+  {
+    unsigned int count = 0;
+    for (; next < targets.size() && count < BATCH_SIZE; next++)
+    {
+      const OSS::Net::IPAddress& target = targets[next];
+      if (!target.isValid())
+        continue;
+      endpoints[count] = boost::asio::ip::udp::endpoint(target.address(), target.getPort() ? target.getPort() : 5060);
+      std::memset(&headers[count], 0, sizeof(struct mmsghdr));
+      headers[count].msg_hdr.msg_name = endpoints[count].data();
+      headers[count].msg_hdr.msg_namelen = endpoints[count].size();
+      headers[count].msg_hdr.msg_iov = &iov;
+      headers[count].msg_hdr.msg_iovlen = 1;
+      ++count;
+    }
+
+    unsigned int done = 0;
+    while (done < count)
+    {
+      int result = ::sendmmsg(_socket.native_handle(), headers.data() + done, count - done, MSG_DONTWAIT);
+      if (result <= 0)
+      {
+        //
+        // sendmmsg stops at the first datagram it cannot send.  Skip that
+        // target so the rest of the batch still gets its keep-alive.
+        //
+        lastError = errno;
+        failed++;
+        done++;
+        continue;
+      }
+      sent += result;
+      done += result;
+    }
+  }
+
+  if (failed)
+  {
+    OSS_LOG_DEBUG("SIPUDPConnection::writeKeepAlive - Unable to send " << failed << " of " << sent + failed
+      << " keep-alives.  ERROR: " << lastError << " " << strerror(lastError));
+  }
+#else
+  for (std::vector<OSS::Net::IPAddress>::const_iterator iter = targets.begin(); iter != targets.end(); iter++)
+  {
+    if (!iter->isValid())
+      continue;
+    boost::asio::ip::udp::endpoint ep(iter->address(), iter->getPort() ? iter->getPort() : 5060);
+    boost::system::error_code ec;
+    _socket.send_to(boost::asio::buffer(crlf, 4), ep, 0, ec);
+    if (!ec)
+      ++sent;
+  }
+#endif
+  return sent;
+}
+
 void SIPUDPConnection::handleWrite(const boost::system::error_code& e)
 {
   // This is only significant for stream based connections (TCP/TLS)
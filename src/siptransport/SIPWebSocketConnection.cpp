@@ -36,13 +36,19 @@ SIPWebSocketConnection::ServerReadWriteHandler::ServerReadWriteHandler(SIPWebSoc
 void SIPWebSocketConnection::ServerReadWriteHandler::on_close(websocketpp::server::connection_ptr pConnection)
 {
 	OSS_LOG_DEBUG("SIPWebSocketConnection::ServerReadWriteHandler::on_close INVOKED");
+	if (_rConnection._pCounters)
+		_rConnection._pCounters->connectionsActive.fetch_sub(1, boost::memory_order_relaxed);
 }
 
 void SIPWebSocketConnection::ServerReadWriteHandler::on_message(websocketpp::server::connection_ptr pConnection, websocketpp::server::handler::message_ptr pMsg)
 {
   	boost::system::error_code ec;
-  	std::string payload = pMsg->get_payload();
-  	_rConnection.handleRead(ec, payload.size(), &payload);
+  	//
+  	// The payload is read in place.  The message buffer stays alive until
+  	// this handler returns.
+  	//
+  	const std::string& payload = pMsg->get_payload();
+  	_rConnection.handleRead(ec, payload.size(), const_cast<std::string*>(&payload));
 }
 
 void SIPWebSocketConnection::ServerReadWriteHandler::on_error(websocketpp::server::connection_ptr pConnection)
@@ -69,6 +75,16 @@ void SIPWebSocketConnection::ServerReadWriteHandler::on_pong_timeout(websocketpp
 }
 
 
+SIPWebSocketConnection::Counters::Counters() :
+  connectionsAccepted(0),
+  connectionsActive(0),
+  framesReceived(0),
+  bytesReceived(0),
+  framesSent(0),
+  bytesSent(0)
+{
+}
+
 SIPWebSocketConnection::SIPWebSocketConnection(SIPWebSocketConnectionManager& manager, SIPListener* pListener) :
     SIPTransportSession(pListener),
 		_connectionManager(manager),
@@ -77,10 +93,11 @@ SIPWebSocketConnection::SIPWebSocketConnection(SIPWebSocketConnectionManager& ma
 	_transportScheme = "ws";
 }
 
-SIPWebSocketConnection::SIPWebSocketConnection(const websocketpp::server::connection_ptr& pConnection, SIPWebSocketConnectionManager& manager, SIPListener* pListener) :
+SIPWebSocketConnection::SIPWebSocketConnection(const websocketpp::server::connection_ptr& pConnection, SIPWebSocketConnectionManager& manager, SIPListener* pListener, const CountersPtr& pCounters) :
   SIPTransportSession(pListener),
   _pServerConnection(pConnection),
   _connectionManager(manager),
+  _pCounters(pCounters),
   _readExceptionCount(0)
 {
 	_transportScheme = "ws";
@@ -123,10 +140,13 @@ void SIPWebSocketConnection::handleRead(const boost::system::error_code& e, std:
 
 			_connectionManager.stop(shared_from_this());
 		}
+		return;
 	}
 
 	OSS_LOG_DEBUG("SIPWebSocketConnection::handleRead STARTING new connection");
-	std::string* buffer = reinterpret_cast<std::string*>(userData);
+	const std::string* buffer = reinterpret_cast<const std::string*>(userData);
+
+	touch();
 
 	//
 	// set the last read address
@@ -153,59 +173,35 @@ void SIPWebSocketConnection::handleRead(const boost::system::error_code& e, std:
 	_readExceptionCount = 0;
 
 	_bytesRead =  bytes_transferred;
-	if (!_pRequest)
+	if (_pCounters)
 	{
-		_pRequest = SIPMessage::Ptr(new SIPMessage());
+		_pCounters->framesReceived.fetch_add(1, boost::memory_order_relaxed);
+		_pCounters->bytesReceived.fetch_add(bytes_transferred, boost::memory_order_relaxed);
 	}
 
-	boost::tribool result;
+	//
+	// A WebSocket message carries exactly one complete SIP message (RFC 7118)
+	// so the payload is parsed in one pass straight from the frame buffer
+	// instead of being fed byte by byte through the stream parser.
+	// Messages holding nothing but CRLF are keep-alives.
+	//
 	const char* begin = buffer->data();
 	const char* end = buffer->data() + bytes_transferred;
+	while (begin != end && (*begin == '\r' || *begin == '\n'))
+		++begin;
 
-	boost::tuple<boost::tribool, const char*> ret =  _pRequest->consume(begin, end);
-	result = ret.get<0>();
-	const char* tail = ret.get<1>();
+	if (begin == end)
+		return;
 
-	if (result)
-	{
-		//
-		// Message has been read in full
-		//
-		dispatchMessage(_pRequest->shared_from_this(), shared_from_this());
-		if (tail >= end)
-		{
-			//
-			// The end of the SIPMessage is reached so we can simply reset the
-			// request buffer and start the read operation all over again
-			//
-			_pRequest.reset();
-
-			//
-			// We are done
-			//
-			return;
-		}
-		else
-		{
-			//
-			// This should not happen as there is one full message per read.
-			// The tail is within the range of the end of the read buffer.
-			//
-			OSS_ASSERT(false);
-		}
-	}
-	else if (!result)
+	SIPMessage::Ptr pRequest(new SIPMessage(begin, end - begin));
+	pRequest->setSingleOwner(true);
+	if (pRequest->getStartLine().empty())
 	{
-		_pRequest.reset();
-	}
-	else
-	{
-		//
-		// This should not happen as there is one full message per read.
-		// Partial message?
-		//
-		OSS_ASSERT(false);
+		OSS_LOG_WARNING("SIPWebSocketConnection::handleRead() dropping unparseable frame of " << bytes_transferred << " bytes");
+		return;
 	}
+
+	dispatchMessage(pRequest, shared_from_this());
 }
 
 void SIPWebSocketConnection::handleWrite(const boost::system::error_code& e)
@@ -221,6 +217,11 @@ void SIPWebSocketConnection::writeMessage(SIPMessage::Ptr msg)
 	if (_pServerConnection)
 	{
 		_pServerConnection->send(msg->data(), websocketpp::frame::opcode::BINARY);
+		if (_pCounters)
+		{
+			_pCounters->framesSent.fetch_add(1, boost::memory_order_relaxed);
+			_pCounters->bytesSent.fetch_add(msg->data().size(), boost::memory_order_relaxed);
+		}
 	}
 }
 
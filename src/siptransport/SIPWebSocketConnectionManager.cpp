@@ -29,6 +29,7 @@ namespace SIP {
 
 
 SIPWebSocketConnectionManager::SIPWebSocketConnectionManager(const SIPTransportSession::Dispatch& dispatch):
+  _sweeper("SIPWebSocketConnectionManager", _connections),
   _dispatch(dispatch),
   _portBase(10000),
   _portMax(12000)
@@ -51,15 +52,13 @@ void SIPWebSocketConnectionManager::deinitialize()
 
 void SIPWebSocketConnectionManager::add(SIPWebSocketConnection::Ptr conn)
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
-
   SIPWebSocketConnection* pConnection = dynamic_cast<SIPWebSocketConnection*>(conn.get());
   OSS_VERIFY_NULL(pConnection);
 
   if (!pConnection->getIdentifier())
     pConnection->setIdentifier((OSS::UInt64)pConnection->_pServerConnection.get());
 
-  _connections[conn->getIdentifier()] = conn;
+  _connections.insert(conn, pConnection->getRemoteAddress());
   OSS_LOG_INFO("SIPWebSocketConnection Added transport (" << pConnection->getIdentifier() << ") "
     << pConnection->getLocalAddress().toIpPortString() <<
     "->" << pConnection->getRemoteAddress().toIpPortString() );
@@ -67,15 +66,13 @@ void SIPWebSocketConnectionManager::add(SIPWebSocketConnection::Ptr conn)
 
 void SIPWebSocketConnectionManager::start(SIPWebSocketConnection::Ptr conn)
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
-
   SIPWebSocketConnection* pConnection = dynamic_cast<SIPWebSocketConnection*>(conn.get());
   OSS_VERIFY_NULL(pConnection);
 
   if (!pConnection->getIdentifier())
     pConnection->setIdentifier((OSS::UInt64)pConnection->_pServerConnection.get());
 
-  _connections[conn->getIdentifier()] = conn;
+  _connections.insert(conn, pConnection->getRemoteAddress());
 
   pConnection->start(_dispatch);
   OSS_LOG_INFO("SIPWebSocketConnection started reading from transport (" << pConnection->getIdentifier() << ") "
@@ -85,54 +82,55 @@ void SIPWebSocketConnectionManager::start(SIPWebSocketConnection::Ptr conn)
 
 void SIPWebSocketConnectionManager::stop(SIPWebSocketConnection::Ptr conn)
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
-
   OSS_LOG_INFO("Deleting SIPWebSocketConnection transport (" << conn->getIdentifier() << ") "
     << conn->getLocalAddress().toIpPortString() <<
     "->" << conn->getRemoteAddress().toIpPortString() );
 
-  _connections.erase(conn->getIdentifier());
+  _connections.remove(conn->getIdentifier());
   conn->stop();
 }
 
 void SIPWebSocketConnectionManager::stopAll()
 {
-  OSS::mutex_write_lock wlock(_rwConnectionsMutex);
-  for (std::map<OSS::UInt64, SIPWebSocketConnection::Ptr>::iterator iter = _connections.begin();
-    iter != _connections.end(); iter++)
+  ConnectionIndex::ConnectionList connections;
+  _connections.removeAll(connections);
+  for (ConnectionIndex::ConnectionList::iterator iter = connections.begin();
+    iter != connections.end(); iter++)
   {
-    iter->second->stop();
+    (*iter)->stop();
   }
-  _connections.clear();
 }
 
 SIPWebSocketConnection::Ptr SIPWebSocketConnectionManager::findConnectionByAddress(const OSS::Net::IPAddress& target)
 {
-  OSS::mutex_read_lock rlock(_rwConnectionsMutex);
-  for (std::map<OSS::UInt64, SIPWebSocketConnection::Ptr>::iterator iter = _connections.begin();
-    iter != _connections.end(); iter++)
-  {
-    if (iter->second->getRemoteAddress().compare(target, true))
-      return iter->second;
-  }
-  return SIPWebSocketConnection::Ptr();
+  return _connections.findByEndpoint(target);
 }
 
 SIPWebSocketConnection::Ptr SIPWebSocketConnectionManager::findConnectionById(OSS::UInt64 identifier)
 {
-  OSS::mutex_read_lock rlock(_rwConnectionsMutex);
-  if (_connections.find(identifier) != _connections.end())
+  SIPWebSocketConnection::Ptr conn = _connections.findById(identifier);
+  if (conn)
   {
-    SIPWebSocketConnection::Ptr conn = _connections[identifier];
-    if (conn)
-    {
-      OSS_LOG_INFO("SIPWebSocketConnectionManager::findConnectionById got transport (" << conn->getIdentifier() << ") "
-      << conn->getLocalAddress().toIpPortString() <<
-      "->" << conn->getRemoteAddress().toIpPortString() );
-    }
-    return conn;
+    OSS_LOG_INFO("SIPWebSocketConnectionManager::findConnectionById got transport (" << conn->getIdentifier() << ") "
+    << conn->getLocalAddress().toIpPortString() <<
+    "->" << conn->getRemoteAddress().toIpPortString() );
   }
-  return SIPWebSocketConnection::Ptr();
+  return conn;
+}
+
+std::size_t SIPWebSocketConnectionManager::getConnectionCount() const
+{
+  return _connections.size();
+}
+
+void SIPWebSocketConnectionManager::startIdleSweeper(boost::asio::io_service& ioService, unsigned int idleTimeout)
+{
+  _sweeper.start(ioService, idleTimeout);
+}
+
+void SIPWebSocketConnectionManager::stopIdleSweeper()
+{
+  _sweeper.stop();
 }
 
 } } // OSS::SIP
@@ -27,8 +27,10 @@
 namespace OSS {
 namespace SIP {
 
-inline SIPWebSocketListener::ServerAcceptHandler::ServerAcceptHandler(SIPWebSocketListener& listener):
-		_rListener(listener)
+inline SIPWebSocketListener::ServerAcceptHandler::ServerAcceptHandler(SIPWebSocketListener& listener,
+  const SIPWebSocketConnection::CountersPtr& pCounters):
+		_rListener(listener),
+		_pCounters(pCounters)
 {
 }
 
@@ -63,7 +65,7 @@ void SIPWebSocketListener::ServerAcceptHandler::on_open(websocketpp::server::con
   	//accept only sip websockets connections
 //  	if (pConnection->get_resource() == "/sip")
 //  	{
-  		_rListener.handleAccept(ec, &pConnection);
+  		_rListener.handleAccept(ec, &pConnection, _pCounters);
 //  	}
 }
 
@@ -72,17 +74,24 @@ void SIPWebSocketListener::ServerAcceptHandler::validate(websocketpp::server::co
   pConnection->select_subprotocol("sip");
 }
 
+SIPWebSocketListener::Shard::Shard() :
+  pServerEndPoint(0),
+  pServerThread(0),
+  pCounters(new SIPWebSocketConnection::Counters())
+{
+}
+
 SIPWebSocketListener::SIPWebSocketListener(
   SIPTransportService* pTransportService,
   const std::string& address,
   const std::string& port,
   SIPWebSocketConnectionManager& connectionManager) :
     SIPListener(pTransportService, address, port),
-    _pServerEndPoint(0),
+    _threadCount(1),
+    _hasFailed(false),
     _connectionManager(connectionManager),
     _resolver(pTransportService->ioService())
 {
-	_pServerThread = 0;
 	_pClientThread = 0;
 }
 
@@ -91,47 +100,103 @@ SIPWebSocketListener::~SIPWebSocketListener()
   handleStop();
 }
 
+void SIPWebSocketListener::setThreadCount(std::size_t threadCount)
+{
+  _threadCount = threadCount ? threadCount : 1;
+}
+
 void SIPWebSocketListener::run()
 {
+  OSS::mutex_critic_sec_lock lock(_shardsMutex);
   if (!_hasStarted)
   {
-    assert(!_pServerThread);
-    _pServerThread = new boost::thread(boost::bind(&SIPWebSocketListener::run_server, this));
+    assert(_shards.empty());
+    _hasFailed = false;
+    for (std::size_t i = 0; i < _threadCount; i++)
+    {
+      Shard* pShard = new Shard();
+      pShard->pServerAcceptHandler = websocketpp::server::handler::ptr(new ServerAcceptHandler(*this, pShard->pCounters));
+      pShard->pServerEndPoint = new websocketpp::server(pShard->pServerAcceptHandler);
+      //
+      // A single thread keeps the plain bind so that a second process
+      // can not silently share the port with us
+      //
+      pShard->pServerEndPoint->set_reuse_port(_threadCount > 1);
+
+      if (PRIO_DEBUG == log_get_level())
+      {
+        pShard->pServerEndPoint->alog().set_level(websocketpp::log::alevel::ALL);
+        pShard->pServerEndPoint->elog().set_level(websocketpp::log::elevel::ALL);
+      }
+      _shards.push_back(pShard);
+    }
+
+    for (Shards::iterator iter = _shards.begin(); iter != _shards.end(); iter++)
+      (*iter)->pServerThread = new boost::thread(boost::bind(&SIPWebSocketListener::run_server, this, *iter));
     _hasStarted = true;
   }
 }
 
-void SIPWebSocketListener::run_server()
+void SIPWebSocketListener::run_server(Shard* pShard)
 {
-  assert(!_pServerEndPoint);
   try
   {
-    _pServerAcceptHandler = websocketpp::server::handler::ptr(new ServerAcceptHandler(*this));
-    _pServerEndPoint = new websocketpp::server(_pServerAcceptHandler);
-
-    if (PRIO_DEBUG == log_get_level())
+    boost::asio::ip::tcp::endpoint endpoint;
     {
-      _pServerEndPoint->alog().set_level(websocketpp::log::alevel::ALL);
-      _pServerEndPoint->elog().set_level(websocketpp::log::elevel::ALL);
+      //
+      // The resolver is shared by all listener threads
+      //
+      OSS::mutex_critic_sec_lock lock(_resolverMutex);
+      boost::asio::ip::tcp::resolver::query query(getAddress(), getPort());
+      endpoint = *_resolver.resolve(query);
     }
-  
-    boost::asio::ip::tcp::resolver::query query(getAddress(), getPort());
-    boost::asio::ip::tcp::endpoint endpoint = *_resolver.resolve(query);
-    _hasStarted = true;
-    _pServerEndPoint->listen(endpoint);
+    pShard->pServerEndPoint->listen(endpoint);
   }
   catch(const std::exception& e)
   {
     OSS_LOG_ERROR("SIPWebSocketListener::run_server " << _address << ":" << _port << " Exception: " << e.what());
-    handleStop();
+    handleServerFailure(pShard);
   }
   catch(...)
   {
     OSS_LOG_ERROR("SIPWebSocketListener::run_server " << _address << ":" << _port << " UNKNOWN EXCEPTION");
-    handleStop();
+    handleServerFailure(pShard);
   }
 }
 
+void SIPWebSocketListener::handleServerFailure(Shard* pFailed)
+{
+  //
+  // A listener that lost one of its threads stops as a whole instead of
+  // serving the port with fewer threads.  This runs on a listener thread
+  // so joining the threads is left to handleStop().
+  //
+  _connectionManager.stopAll();
+
+  OSS::mutex_critic_sec_lock lock(_shardsMutex);
+  _hasFailed = true;
+  _hasStarted = false;
+  for (Shards::iterator iter = _shards.begin(); iter != _shards.end(); iter++)
+  {
+    if (*iter == pFailed)
+      continue;
+    try
+    {
+      (*iter)->pServerEndPoint->stop_listen(true);
+    }
+    catch(const std::exception& e)
+    {
+      OSS_LOG_DEBUG("SIPWebSocketListener::handleServerFailure " << _address << ":" << _port << " Exception: " << e.what());
+    }
+  }
+}
+
+bool SIPWebSocketListener::hasFailed() const
+{
+  OSS::mutex_critic_sec_lock lock(_shardsMutex);
+  return _hasFailed;
+}
+
 void SIPWebSocketListener::run_client()
 {
 	//TODO: Not yet implemented for websocket
@@ -139,6 +204,12 @@ void SIPWebSocketListener::run_client()
 }
 
 void SIPWebSocketListener::handleAccept(const boost::system::error_code& e, OSS_HANDLE connectionPtr)
+{
+  handleAccept(e, connectionPtr, SIPWebSocketConnection::CountersPtr());
+}
+
+void SIPWebSocketListener::handleAccept(const boost::system::error_code& e, OSS_HANDLE connectionPtr,
+  const SIPWebSocketConnection::CountersPtr& pCounters)
 {
   if (!e)
   {
@@ -148,7 +219,17 @@ void SIPWebSocketListener::handleAccept(const boost::system::error_code& e, OSS_
     		reinterpret_cast<websocketpp::server::connection_ptr*>(connectionPtr);
     OSS_VERIFY_NULL(pWsConnection);
 
-    SIPWebSocketConnection::Ptr pNewConnection(new SIPWebSocketConnection(*pWsConnection, _connectionManager, this));
+    //
+    // The counters come from the accept handler of the thread that took
+    // the connection so _shards is not touched here
+    //
+    if (pCounters)
+    {
+      pCounters->connectionsAccepted.fetch_add(1, boost::memory_order_relaxed);
+      pCounters->connectionsActive.fetch_add(1, boost::memory_order_relaxed);
+    }
+
+    SIPWebSocketConnection::Ptr pNewConnection(new SIPWebSocketConnection(*pWsConnection, _connectionManager, this, pCounters));
 
     pNewConnection->setExternalAddress(_externalAddress);
     _connectionManager.start(pNewConnection);
@@ -167,23 +248,42 @@ void SIPWebSocketListener::handleStart()
 void SIPWebSocketListener::handleStop()
 {
   _connectionManager.stopAll();
-  
-  if (_pServerEndPoint)
-  {
-    _pServerEndPoint->stop_listen(true);
-  }
 
-  if (_pServerThread)
+  Shards shards;
   {
-	  _pServerThread->join();
-	  delete _pServerThread;
-	  _pServerThread = 0;
+    OSS::mutex_critic_sec_lock lock(_shardsMutex);
+    for (Shards::iterator iter = _shards.begin(); iter != _shards.end(); iter++)
+    {
+      try
+      {
+        (*iter)->pServerEndPoint->stop_listen(true);
+      }
+      catch(const std::exception& e)
+      {
+        //
+        // The thread never got to listen
+        //
+        OSS_LOG_DEBUG("SIPWebSocketListener::handleStop " << _address << ":" << _port << " Exception: " << e.what());
+      }
+    }
+    shards.swap(_shards);
+    _hasStarted = false;
   }
 
-  if (_pServerEndPoint)
+  //
+  // A thread that failed to listen takes the lock in handleServerFailure()
+  // so the threads are joined without it
+  //
+  for (Shards::iterator iter = shards.begin(); iter != shards.end(); iter++)
   {
-     delete _pServerEndPoint;
-    _pServerEndPoint = 0;
+    Shard* pShard = *iter;
+    if (pShard->pServerThread)
+    {
+      pShard->pServerThread->join();
+      delete pShard->pServerThread;
+    }
+    delete pShard->pServerEndPoint;
+    delete pShard;
   }
 }
 
@@ -204,7 +304,26 @@ void SIPWebSocketListener::closeTemporarily(boost::system::error_code& e)
   
 bool SIPWebSocketListener::canBeRestarted() const
 {
-  return !_pServerThread && !_pServerEndPoint;
+  OSS::mutex_critic_sec_lock lock(_shardsMutex);
+  return _shards.empty();
+}
+
+void SIPWebSocketListener::getStatistics(Statistics& statistics) const
+{
+  OSS::mutex_critic_sec_lock lock(_shardsMutex);
+  statistics.clear();
+  for (Shards::const_iterator iter = _shards.begin(); iter != _shards.end(); iter++)
+  {
+    const SIPWebSocketConnection::Counters& counters = *(*iter)->pCounters;
+    ThreadStatistics stats;
+    stats.connectionsAccepted = counters.connectionsAccepted.load(boost::memory_order_relaxed);
+    stats.connectionsActive = counters.connectionsActive.load(boost::memory_order_relaxed);
+    stats.framesReceived = counters.framesReceived.load(boost::memory_order_relaxed);
+    stats.bytesReceived = counters.bytesReceived.load(boost::memory_order_relaxed);
+    stats.framesSent = counters.framesSent.load(boost::memory_order_relaxed);
+    stats.bytesSent = counters.bytesSent.load(boost::memory_order_relaxed);
+    statistics.push_back(stats);
+  }
 }
 
 
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "OSS/Net/AccessControl.h"
+#include "OSS/Net/NetlinkBanSet.h"
 #include "OSS/UTL/AdaptiveDelay.h"
 
 static const std::string DB_PATH = "access-control";
@@ -80,3 +81,48 @@ TEST(AccessControlTest, LogPacket)
   }
   ASSERT_TRUE(acc.isBannedAddress("192.168.1.100"));
 }
+
+TEST(AccessControlTest, BanSetEncode)
+{
+  OSS::Net::NetlinkBanSet::Addresses addresses;
+  addresses.push_back(boost::asio::ip::address::from_string("192.168.1.1"));
+  addresses.push_back(boost::asio::ip::address::from_string("192.168.1.2"));
+  
+  std::string buffer;
+  ASSERT_TRUE(OSS::Net::NetlinkBanSet::encode(buffer, OSS::Net::NetlinkBanSet::ADD, "oss_banned", addresses, 1));
+  ASSERT_TRUE(buffer.size() > 16 && buffer.size() % 4 == 0);
+  
+  //
+  // The message length leads the netlink header
+  //
+  OSS::UInt32 len = 0;
+  memcpy(&len, buffer.data(), sizeof(len));
+  ASSERT_EQ(buffer.size(), len);
+  
+  //
+  // A second message follows the first one in the same buffer
+  //
+  ASSERT_TRUE(OSS::Net::NetlinkBanSet::encode(buffer, OSS::Net::NetlinkBanSet::DEL, "oss_banned", addresses, 2));
+  ASSERT_EQ(len * 2, buffer.size());
+  
+  addresses.push_back(boost::asio::ip::address::from_string("2001:db8::1"));
+  ASSERT_FALSE(OSS::Net::NetlinkBanSet::encode(buffer, OSS::Net::NetlinkBanSet::ADD, "oss_banned", addresses, 3));
+  ASSERT_FALSE(OSS::Net::NetlinkBanSet::encode(buffer, OSS::Net::NetlinkBanSet::ADD, "oss_banned", OSS::Net::NetlinkBanSet::Addresses(), 4));
+}
+
+TEST(AccessControlTest, BanSetClosed)
+{
+  //
+  // Bans still apply when the kernel set is not available
+  //
+  OSS::Net::AccessControl acc;
+  acc.enabled() = true;
+  acc.setBanSet(OSS::Net::AccessControl::BanSetPtr(new OSS::Net::NetlinkBanSet()));
+  
+  acc.banAddress("192.168.1.1");
+  ASSERT_TRUE(acc.isBannedAddress("192.168.1.1"));
+  ASSERT_EQ(0, acc.getBanSet()->pending());
+  
+  acc.clearAddress(boost::asio::ip::address::from_string("192.168.1.1"), false);
+  ASSERT_FALSE(acc.isBannedAddress("192.168.1.1"));
+}
@@ -77,6 +77,9 @@ using OSS::BSON::BSONDocument;
 using OSS::BSON::BSONQueue;
 #endif
 using OSS::BSON::BSONIterator;
+using OSS::BSON::BSONArena;
+using OSS::BSON::BSONWriter;
+using OSS::BSON::BSONReader;
 
 
 TEST(BSONTest, BSONDoc)
@@ -267,6 +270,130 @@ TEST(BSONTest, BSONDoc)
   
 }
 
+TEST(BSONTest, BSONWriterReader)
+{
+  //
+  // Start in a small stack buffer so the arena has to move to the heap
+  //
+  uint8_t buffer[32];
+  BSONArena arena(buffer, sizeof(buffer));
+  BSONWriter writer(arena);
+  ASSERT_TRUE(writer.appendString("string", "This is a UTF8 string"));
+  ASSERT_TRUE(writer.appendBoolean("bool", true));
+  ASSERT_TRUE(writer.appendDouble("double", 123.456));
+  ASSERT_TRUE(writer.appendInt32("int32", -123456));
+  ASSERT_TRUE(writer.appendInt64("int64", 1234567890123LL));
+  ASSERT_TRUE(writer.appendArrayBegin("array"));
+  ASSERT_TRUE(writer.appendString("0", "Element 1"));
+  ASSERT_TRUE(writer.appendString("1", "Element 2"));
+  ASSERT_FALSE(writer.appendDocumentEnd("array"));
+  ASSERT_TRUE(writer.appendArrayEnd("array"));
+  ASSERT_TRUE(writer.appendDocumentBegin("document"));
+  ASSERT_TRUE(writer.appendInt32("key1", 1));
+  ASSERT_TRUE(writer.appendDocumentEnd("document"));
+  ASSERT_TRUE(writer.finish());
+  ASSERT_FALSE(writer.appendInt32("late", 1));
+  ASSERT_TRUE(arena.data() != buffer);
+
+  //
+  // libbson must accept what the writer produced
+  //
+  BSONParser parser(writer.getData(), writer.getDataLength());
+  std::string string_value;
+  int64_t int64_value = 0;
+  ASSERT_TRUE(parser.getString("string", string_value));
+  ASSERT_STREQ(string_value.c_str(), "This is a UTF8 string");
+  ASSERT_TRUE(parser.getInt64("int64", int64_value));
+  ASSERT_EQ(int64_value, 1234567890123LL);
+
+  BSONReader reader(writer.getData(), writer.getDataLength());
+  ASSERT_TRUE(reader.isValid());
+  ASSERT_TRUE(reader.next());
+  ASSERT_STREQ(reader.getKey(), "string");
+  ASSERT_EQ(reader.getOffset(), (std::size_t)4);
+  const char* str = 0;
+  std::size_t len = 0;
+  ASSERT_TRUE(reader.getString(str, len));
+  ASSERT_EQ(std::string(str, len), "This is a UTF8 string");
+  ASSERT_TRUE((const uint8_t*)str > writer.getData() && (const uint8_t*)str < writer.getData() + writer.getDataLength());
+
+  bool bool_value = false;
+  double double_value = 0;
+  int32_t int32_value = 0;
+  ASSERT_TRUE(reader.next());
+  ASSERT_TRUE(reader.getBoolean(bool_value));
+  ASSERT_TRUE(bool_value);
+  ASSERT_FALSE(reader.getInt32(int32_value));
+  ASSERT_TRUE(reader.next());
+  ASSERT_TRUE(reader.getDouble(double_value));
+  ASSERT_EQ(double_value, 123.456);
+  ASSERT_TRUE(reader.next());
+  ASSERT_TRUE(reader.getInt32(int32_value));
+  ASSERT_EQ(int32_value, -123456);
+  ASSERT_TRUE(reader.next());
+  ASSERT_TRUE(reader.getInt64(int64_value));
+  ASSERT_EQ(int64_value, 1234567890123LL);
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(reader.getType(), BSONValue::TYPE_ARRAY);
+  BSONReader array;
+  ASSERT_TRUE(reader.recurse(array));
+  ASSERT_TRUE(array.next());
+  ASSERT_TRUE(array.getString(string_value));
+  ASSERT_STREQ(string_value.c_str(), "Element 1");
+  ASSERT_TRUE(array.next());
+  ASSERT_TRUE(array.getString(string_value));
+  ASSERT_STREQ(string_value.c_str(), "Element 2");
+  ASSERT_FALSE(array.next());
+
+  ASSERT_TRUE(reader.next());
+  ASSERT_EQ(reader.getType(), BSONValue::TYPE_DOCUMENT);
+  ASSERT_FALSE(reader.next());
+
+  //
+  // A truncated buffer is rejected
+  //
+  BSONReader truncated(writer.getData(), writer.getDataLength() - 1);
+  ASSERT_FALSE(truncated.isValid());
+  ASSERT_FALSE(truncated.next());
+}
+
+TEST(BSONTest, BSONDocumentWriterRoundTrip)
+{
+  BSONDocument doc;
+  doc["string"] = BSONString("This is a UTF8 string");
+  doc["bool"] = BSONBool(false);
+  doc["int32"] = BSONInt32(123456);
+  doc["array"][0] = BSONString("Element 1");
+  doc["array"][1] = BSONInt64(123456);
+  doc["document"]["key1"] = BSONString("Element 1");
+  doc["document"]["key2"][0] = BSONDouble(1.5);
+
+  BSONArena arena;
+  BSONWriter writer(arena);
+  ASSERT_TRUE(doc.toBSON(writer));
+
+  //
+  // The writer must produce the same bytes as libbson
+  //
+  BSONParser parser;
+  doc.toBSON(parser);
+  ASSERT_EQ(writer.getDataLength(), parser.getDataLength());
+  ASSERT_EQ(memcmp(writer.getData(), parser.getData(), parser.getDataLength()), 0);
+
+  BSONDocument copy;
+  ASSERT_TRUE(copy.fromBSON(writer.getData(), writer.getDataLength()));
+  ASSERT_TRUE(copy.toJSON() == doc.toJSON());
+  ASSERT_TRUE(copy["array"][1].asInt64() == 123456);
+  ASSERT_TRUE(copy["document"]["key2"][0].asDouble() == 1.5);
+
+  std::size_t len = 0;
+  uint8_t* data = arena.release(len);
+  ASSERT_EQ(len, parser.getDataLength());
+  ASSERT_EQ(arena.size(), (std::size_t)0);
+  free(data);
+}
+
 #if 0
 
 TEST(BSONTest, BSONBSONQueue)
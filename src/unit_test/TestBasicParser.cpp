@@ -5,6 +5,7 @@
 #include "OSS/SIP/SIPCSeq.h"
 #include "OSS/SIP/SIPURI.h"
 #include "OSS/ABNF/ABNFParser.h"
+#include "OSS/ABNF/ABNFSIPToken.h"
 #include "OSS/ABNF/ABNFSIPUserInfo.h"
 #include "OSS/ABNF/ABNFSIPHostName.h"
 #include "OSS/ABNF/ABNFSIPIPV4Address.h"
@@ -233,7 +234,7 @@ TEST(ParserTest, test_message_construction)
   ack->hdrSet(OSS::SIP::HDR_CSEQ, ackCSeq);
   ASSERT_TRUE(ack->hdrGet(OSS::SIP::HDR_CSEQ) == "1 ACK");
 
-  ack->body() = "";
+  ack->setBody("");
   ack->hdrSet(OSS::SIP::HDR_CONTENT_LENGTH, "0");
   ack->hdrSet(OSS::SIP::HDR_CONTENT_TYPE, "text/plain");
 
@@ -1068,6 +1069,53 @@ TEST(ParserTest, test_abnf_parser)
     ASSERT_TRUE(token == "z9hG4bK776asdhds");
   }
 
+  {
+    // token capture by offset and length
+    typedef ABNFLRSequence5<ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token, ABNF_SIP_SLASH, ABNF_SIP_token> _pvar1;
+    ABNFLRSequence3<_pvar1, ABNF_SIP_LWS, ABNF_SIP_hostport> parser;
+    const char* via = "SIP/2.0/TCP [2001:db8::1]:5060;branch=z9hG4bK776asdhds";
+    ABNFTokenRanges ranges;
+    ABNFTokens tokens;
+    parser.parseTokenRanges(via, ranges);
+    parser.parseTokens(via, tokens);
+    ASSERT_TRUE(ranges.size() == 3);
+    ASSERT_TRUE(ranges.size() == tokens.size());
+    for (std::size_t i = 0; i < ranges.size(); i++)
+      ASSERT_TRUE(ranges.str(via, i) == tokens[i]);
+    ASSERT_TRUE(ranges.str(via, 2) == "[2001:db8::1]:5060");
+    ASSERT_TRUE(ranges[2].offset == 12);
+  }
+
+  {
+    // character tables and first character dispatch
+    ASSERT_TRUE(ABNFCharTable<ABNFCharSetAlphaNumeric>::test('z'));
+    ASSERT_TRUE(ABNFCharTable<ABNFCharSetAlphaNumeric>::test('0'));
+    ASSERT_TRUE(!ABNFCharTable<ABNFCharSetAlphaNumeric>::test('-'));
+    ASSERT_TRUE(!ABNFCharTable<ABNFCharSetAlphaNumeric>::test('\0'));
+    ASSERT_TRUE(!ABNFCharTable<ABNFCharSetAlphaNumeric>::test((char)0xC1));
+    ASSERT_TRUE(ABNFCharTable<ABNFCharSetHex>::test('F'));
+    ASSERT_TRUE(!ABNFCharTable<ABNFCharSetHex>::test('g'));
+    typedef ABNFCharTable< ABNFCharSetChars<'[', ']'> > Brackets;
+    ASSERT_TRUE(Brackets::test(']'));
+    ASSERT_TRUE(!Brackets::test(':'));
+
+    ABNFCharClassLoop<ABNFCharSetDigit, 1, 3> digits;
+    const char* number = "12345";
+    ASSERT_TRUE(digits.parse(number) == number + 3);
+    const char* alpha = "abc";
+    ASSERT_TRUE(digits.parse(alpha) == alpha);
+
+    ABNFSIPHost host;
+    const char* h1 = "pc33.atlanta.com";
+    const char* h2 = "192.168.0.1";
+    const char* h3 = "[2001:db8::1]";
+    const char* h4 = "-invalid";
+    ASSERT_TRUE(host.parse(h1) == h1 + strlen(h1));
+    ASSERT_TRUE(host.parse(h2) == h2 + strlen(h2));
+    ASSERT_TRUE(host.parse(h3) == h3 + strlen(h3));
+    ASSERT_TRUE(host.parse(h4) == h4);
+  }
+
   {
     // Test findNextIterFromRule function template
     const char* cseq = "INVITE           9999";
@@ -1100,4 +1148,188 @@ TEST(ParserTest, test_message_consume_late_crlf)
   ASSERT_TRUE(boost::indeterminate(ret.get<0>()));
   ret = msg.consume(strm1, strm1 + strlen(strm1));
   ASSERT_TRUE(ret.get<0>() == true);
-}
\ No newline at end of file
+}
+TEST(ParserTest, test_message_header_cache)
+{
+  std::ostringstream msg;
+  msg << "INVITE sip:9001@192.168.0.152 SIP/2.0" << CRLF;
+  msg << "To: <sip:9001@192.168.0.152>" << CRLF;
+  msg << "From: 9011<sip:9011@192.168.0.103>;tag=6657e067" << CRLF;
+  msg << "Via: SIP/2.0/UDP 192.168.0.152:9644;branch=z9hG4bK-1;rport" << CRLF;
+  msg << "Via: SIP/2.0/UDP 192.168.0.150:9644;branch=z9hG4bK-2;rport" << CRLF;
+  msg << "Call-ID: 885e5e180c04c509" << CRLF;
+  msg << "CSeq: 1 INVITE" << CRLF;
+  msg << "Contact: <sip:9011@192.168.0.152:9644>" << CRLF;
+  msg << "Content-Length: 0" << CRLF;
+  msg << CRLF;
+
+  SIPMessage invite(msg.str());
+  std::string id;
+  ASSERT_TRUE(invite.getTransactionId(id));
+  ASSERT_STREQ(id.c_str(), "invite1z9hG4bK-1");
+  ASSERT_STREQ(invite.getTopViaBranch().c_str(), "z9hG4bK-1");
+  ASSERT_STREQ(invite.getFromTag().c_str(), "6657e067");
+  ASSERT_TRUE(invite.getToTag().empty());
+  ASSERT_STREQ(invite.getMethod().c_str(), "INVITE");
+  ASSERT_STREQ(invite.getCSeqNumber().c_str(), "1");
+  ASSERT_STREQ(invite.getCallId().c_str(), "885e5e180c04c509");
+  ASSERT_STREQ(invite.getTopContact().c_str(), "<sip:9011@192.168.0.152:9644>");
+
+  //
+  // Modifying a header must invalidate the cached values derived from it
+  //
+  invite.hdrListPopFront(OSS::SIP::HDR_VIA);
+  ASSERT_STREQ(invite.getTopViaBranch().c_str(), "z9hG4bK-2");
+  ASSERT_TRUE(invite.getTransactionId(id));
+  ASSERT_STREQ(id.c_str(), "invite1z9hG4bK-2");
+
+  invite.hdrSet(OSS::SIP::HDR_TO, "<sip:9001@192.168.0.152>;tag=1234");
+  ASSERT_STREQ(invite.getToTag().c_str(), "1234");
+
+  invite.hdrSet(OSS::SIP::HDR_CSEQ, "2 INVITE");
+  ASSERT_TRUE(invite.getTransactionId(id));
+  ASSERT_STREQ(id.c_str(), "invite2z9hG4bK-2");
+
+  //
+  // Copies inherit the cache
+  //
+  SIPMessage copy(invite);
+  ASSERT_STREQ(copy.getToTag().c_str(), "1234");
+  ASSERT_TRUE(copy.getTransactionId(id));
+  ASSERT_STREQ(id.c_str(), "invite2z9hG4bK-2");
+}
+
+TEST(ParserTest, test_message_copy_on_write)
+{
+  std::ostringstream msg;
+  msg << "INVITE sip:9001@192.168.0.152 SIP/2.0" << CRLF;
+  msg << "To: <sip:9001@192.168.0.152>" << CRLF;
+  msg << "From: 9011<sip:9011@192.168.0.103>;tag=6657e067" << CRLF;
+  msg << "Via: SIP/2.0/UDP 192.168.0.152:9644;branch=z9hG4bK-1;rport" << CRLF;
+  msg << "Route: <sip:192.168.0.1;lr>" << CRLF;
+  msg << "Call-ID: 885e5e180c04c509" << CRLF;
+  msg << "CSeq: 1 INVITE" << CRLF;
+  msg << "Contact: <sip:9011@192.168.0.152:9644>" << CRLF;
+  msg << "Content-Length: 4" << CRLF;
+  msg << CRLF;
+  msg << "v=0" << LF;
+
+  SIPMessage invite(msg.str());
+  invite.parse();
+  std::string original = invite.data();
+
+  //
+  // Every change to the copy must leave the source untouched
+  //
+  SIPMessage copy(invite);
+  copy.setStartLine("INVITE sip:9001@192.168.0.200 SIP/2.0");
+  copy.hdrListPrepend(OSS::SIP::HDR_VIA, "SIP/2.0/UDP 192.168.0.1;branch=z9hG4bK-b2b");
+  copy.hdrListPopFront(OSS::SIP::HDR_ROUTE);
+  copy.hdrSet(OSS::SIP::HDR_CONTACT, "<sip:b2b@192.168.0.1>");
+  copy.hdrListAppend("X-Leg", "outbound");
+  copy.setBody("v=1\n");
+  copy.commitData();
+
+  ASSERT_EQ(copy.hdrGetSize(OSS::SIP::HDR_VIA), (size_t)2);
+  ASSERT_EQ(copy.hdrGetSize(OSS::SIP::HDR_ROUTE), (size_t)0);
+  ASSERT_STREQ(copy.hdrGet(OSS::SIP::HDR_CONTACT).c_str(), "<sip:b2b@192.168.0.1>");
+  ASSERT_STREQ(copy.getBody().c_str(), "v=1\n");
+
+  ASSERT_EQ(invite.hdrGetSize(OSS::SIP::HDR_VIA), (size_t)1);
+  ASSERT_EQ(invite.hdrGetSize(OSS::SIP::HDR_ROUTE), (size_t)1);
+  ASSERT_FALSE(invite.hdrPresent("X-Leg"));
+  ASSERT_STREQ(invite.hdrGet(OSS::SIP::HDR_CONTACT).c_str(), "<sip:9011@192.168.0.152:9644>");
+  ASSERT_STREQ(invite.getBody().c_str(), "v=0\n");
+  invite.commitData();
+  ASSERT_STREQ(invite.data().c_str(), original.c_str());
+
+  //
+  // Changing the source after the copy detaches it the same way
+  //
+  SIPMessage second(invite);
+  invite.hdrRemove(OSS::SIP::HDR_ROUTE);
+  ASSERT_EQ(second.hdrGetSize(OSS::SIP::HDR_ROUTE), (size_t)1);
+  second.commitData();
+  ASSERT_STREQ(second.data().c_str(), original.c_str());
+}
+
+TEST(ParserTest, test_message_properties)
+{
+  SIPMessage msg;
+  std::string value;
+  ASSERT_FALSE(msg.getProperty(OSS::PropertyMap::PROP_XOR, value));
+
+  //
+  // Predefined properties are the same slot whether named or enumerated
+  //
+  msg.setProperty(OSS::PropertyMap::PROP_XOR, "1");
+  ASSERT_TRUE(msg.getProperty("xor", value));
+  ASSERT_STREQ(value.c_str(), "1");
+  msg.setProperty("transport-id", "12345");
+  ASSERT_TRUE(msg.getProperty(OSS::PropertyMap::PROP_TransportId, value));
+  ASSERT_STREQ(value.c_str(), "12345");
+  ASSERT_TRUE(msg.properties().empty());
+
+  //
+  // Values longer than the inline storage
+  //
+  std::string contact = "<sip:alice@pc33.atlanta.example.com:5060;transport=tcp;ob>";
+  msg.setProperty(OSS::PropertyMap::PROP_InboundContact, contact);
+  ASSERT_TRUE(msg.getProperty(OSS::PropertyMap::PROP_InboundContact, value));
+  ASSERT_STREQ(value.c_str(), contact.c_str());
+  msg.setProperty(OSS::PropertyMap::PROP_InboundContact, "<sip:a@b>");
+  ASSERT_TRUE(msg.getProperty(OSS::PropertyMap::PROP_InboundContact, value));
+  ASSERT_STREQ(value.c_str(), "<sip:a@b>");
+  msg.setProperty(OSS::PropertyMap::PROP_InboundContact, "");
+  ASSERT_TRUE(msg.getProperty(OSS::PropertyMap::PROP_InboundContact, value));
+  ASSERT_TRUE(value.empty());
+
+  //
+  // Anything else goes to the custom properties
+  //
+  msg.setProperty("script-defined", "yes");
+  ASSERT_TRUE(msg.getProperty("script-defined", value));
+  ASSERT_STREQ(value.c_str(), "yes");
+  ASSERT_EQ(msg.properties().size(), (size_t)1);
+
+  msg.clearProperties();
+  ASSERT_FALSE(msg.getProperty(OSS::PropertyMap::PROP_XOR, value));
+  ASSERT_FALSE(msg.getProperty("transport-id", value));
+  ASSERT_FALSE(msg.getProperty("script-defined", value));
+}
+
+TEST(ParserTest, test_message_single_owner)
+{
+  std::ostringstream msg;
+  msg << "OPTIONS sip:9001@192.168.0.152 SIP/2.0" << CRLF;
+  msg << "To: <sip:9001@192.168.0.152>" << CRLF;
+  msg << "From: 9011<sip:9011@192.168.0.103>;tag=6657e067" << CRLF;
+  msg << "Via: SIP/2.0/UDP 192.168.0.152:9644;branch=z9hG4bK-1;rport" << CRLF;
+  msg << "Call-ID: 885e5e180c04c509" << CRLF;
+  msg << "CSeq: 1 OPTIONS" << CRLF;
+  msg << "Content-Length: 0" << CRLF;
+  msg << CRLF;
+
+  SIPMessage::Ptr pMsg(new SIPMessage());
+  ASSERT_FALSE(pMsg->isSingleOwner());
+  pMsg->setSingleOwner(true);
+  ASSERT_TRUE(pMsg->isSingleOwner());
+
+  pMsg->setData(msg.str());
+  pMsg->parse();
+  std::string id;
+  ASSERT_TRUE(pMsg->getTransactionId(id));
+  ASSERT_STREQ(id.c_str(), "options1z9hG4bK-1");
+  pMsg->hdrListPrepend(OSS::SIP::HDR_VIA, "SIP/2.0/UDP 192.168.0.1;branch=z9hG4bK-2");
+  pMsg->setProperty(OSS::PropertyMap::PROP_TransportId, "1");
+  pMsg->commitData();
+
+  //
+  // Handing the message over to code that shares it
+  //
+  pMsg->setSingleOwner(false);
+  ASSERT_FALSE(pMsg->isSingleOwner());
+  ASSERT_STREQ(pMsg->getTopViaBranch().c_str(), "z9hG4bK-2");
+  ASSERT_TRUE(pMsg->getProperty(OSS::PropertyMap::PROP_TransportId, id));
+  ASSERT_STREQ(id.c_str(), "1");
+}
@@ -59,6 +59,7 @@ See also: For more string comparison tricks (substring, prefix, suffix, and regu
 
 #include "gtest/gtest.h"
 #include "OSS/UTL/Cache.h"
+#include "OSS/UTL/ExpireCache.h"
 
 
 struct MyCacheObj
@@ -66,6 +67,13 @@ struct MyCacheObj
   std::string value;
 };
 
+static OSS::UInt64 gCacheClock = 0;
+
+static OSS::UInt64 cache_clock()
+{
+  return gCacheClock;
+}
+
 TEST(APITest, ExpireCache )
 {
   MyCacheObj obj;
@@ -84,4 +92,80 @@ TEST(APITest, ExpireCache )
   ASSERT_STREQ(boost::any_cast<MyCacheObj&>(data->data()).value.c_str(), "This is a new value");
   cache.remove("123");
   ASSERT_FALSE(cache.has("123"));
-}
\ No newline at end of file
+}
+
+TEST(APITest, ShardedExpireCache)
+{
+  OSS::ExpireCache<std::string, int> cache(60000);
+  int value = 0;
+  ASSERT_FALSE(cache.get("a", value));
+  cache.add("a", 1);
+  cache.add("b", 2);
+  ASSERT_TRUE(cache.get("a", value));
+  ASSERT_EQ(value, 1);
+  ASSERT_TRUE(cache.has("b"));
+  ASSERT_EQ(cache.size(), (std::size_t)2);
+
+  cache.add("a", 3);
+  ASSERT_TRUE(cache.pop("a", value));
+  ASSERT_EQ(value, 3);
+  ASSERT_FALSE(cache.has("a"));
+  cache.remove("b");
+  ASSERT_EQ(cache.size(), (std::size_t)0);
+
+  ASSERT_EQ(cache.getHits(), (OSS::UInt64)3);
+  ASSERT_EQ(cache.getMisses(), (OSS::UInt64)2);
+  ASSERT_EQ(cache.getEvictions(), (OSS::UInt64)0);
+}
+
+TEST(APITest, ShardedExpireCacheExpiry)
+{
+  gCacheClock = 1000;
+  OSS::ExpireCache<std::string, std::string> cache(100, cache_clock);
+  cache.add("expired", "1");
+  cache.add("refreshed", "2");
+  gCacheClock += 60;
+  cache.add("refreshed", "3");
+  gCacheClock += 60;
+
+  //
+  // Expired entries are misses and the lookup sweeps them.  The first
+  // record of the refreshed key is discarded without evicting it.
+  //
+  std::string value;
+  ASSERT_FALSE(cache.get("expired", value));
+  ASSERT_TRUE(cache.get("refreshed", value));
+  ASSERT_EQ(value, "3");
+  ASSERT_EQ(cache.getEvictions(), (OSS::UInt64)1);
+  ASSERT_EQ(cache.sweep(), (std::size_t)0);
+  ASSERT_EQ(cache.size(), (std::size_t)1);
+
+  gCacheClock += 60;
+  ASSERT_EQ(cache.sweep(), (std::size_t)1);
+  ASSERT_EQ(cache.size(), (std::size_t)0);
+  ASSERT_EQ(cache.getEvictions(), (OSS::UInt64)2);
+}
+
+TEST(APITest, ShardedExpireCacheLookupSweeps)
+{
+  gCacheClock = 1000;
+  OSS::ExpireCache<int, int> cache(100, cache_clock);
+  for (int i = 0; i < 1000; i++)
+    cache.add(i, i);
+  ASSERT_EQ(cache.size(), (std::size_t)1000);
+
+  //
+  // Reads alone clear the shards they touch without an explicit sweep
+  //
+  gCacheClock += 100;
+  int value = 0;
+  for (int i = 0; i < 1000; i++)
+    ASSERT_FALSE(cache.has(i));
+  ASSERT_EQ(cache.size(), (std::size_t)0);
+  ASSERT_EQ(cache.getEvictions(), (OSS::UInt64)1000);
+
+  cache.add(1, 1);
+  gCacheClock += 100;
+  ASSERT_FALSE(cache.get(1, value));
+  ASSERT_EQ(cache.size(), (std::size_t)0);
+}
@@ -167,3 +167,101 @@ TEST(TestDigestAuth, SIPProxyAuthenticate)
   std::cout << auth << std::endl;
 }
 
+
+#include "OSS/SIP/SIPDigestAuthEngine.h"
+
+static bool digest_test_password_lookup(const std::string& user, const std::string& realm, std::string& password)
+{
+  if (user != "Mufasa")
+    return false;
+  password = "Circle of Life";
+  return true;
+}
+
+TEST(TestDigestAuth, SIPDigestAuthEngineHashes)
+{
+  //
+  // RFC 2617 section 3.5 example
+  //
+  std::string a1 = SIPDigestAuth::digestCreateA1Hash("Mufasa", "Circle Of Life", "testrealm@host.com");
+  std::string a2 = SIPDigestAuth::digestCreateA2Hash("/dir/index.html", "GET");
+  std::string response = SIPDigestAuth::digestCreateAuthorizationQop(a1,
+    "dcd98b7102dd2f0e8b11d0f600bfb0c093", "00000001", "0a4f113b", "auth", a2);
+  ASSERT_STREQ("6629fae49393a05397450978507c4ef1", response.c_str());
+
+  //
+  // RFC 7616 section 3.9.1 SHA-256 example
+  //
+  SIPDigestAuthEngine::Hash ha1;
+  SIPDigestAuthEngine::Hash ha2;
+  SIPDigestAuthEngine::Hash result;
+  ASSERT_TRUE(SIPDigestAuthEngine::computeHA1(SIPDigestAuthEngine::ALGORITHM_SHA256,
+    "Mufasa", "http-auth@example.org", "Circle of Life", ha1));
+  ASSERT_TRUE(SIPDigestAuthEngine::computeHA2(SIPDigestAuthEngine::ALGORITHM_SHA256,
+    "GET", "/dir/index.html", ha2));
+  ASSERT_TRUE(SIPDigestAuthEngine::computeResponse(SIPDigestAuthEngine::ALGORITHM_SHA256, ha1,
+    "7ypf/xlj9XXwfDPEoM4URrv/xwf94BcCAzFZH4GiTo0v", "00000001",
+    "f2/wE4q74E6zIJEtWaHKaf5wv/H5QzzpXusqGemxURZJ", "auth", ha2, result));
+  ASSERT_STREQ("753927fa0e85d155564e2e272a28d1802ca10daf4496794697cf8db5856cb6c1", result.hex);
+}
+
+TEST(TestDigestAuth, SIPDigestAuthEngineAuthenticate)
+{
+  SIPDigestAuthEngine engine("secret", 300, 2);
+  engine.setPasswordLookup(digest_test_password_lookup);
+
+  unsigned int now = 1000000;
+  std::string nonce = engine.createNonce(now);
+  ASSERT_EQ(engine.validateNonce(nonce, now + 10), SIPDigestAuthEngine::AUTH_OK);
+  ASSERT_EQ(engine.validateNonce(nonce, now + 301), SIPDigestAuthEngine::AUTH_STALE_NONCE);
+  std::string tampered = nonce;
+  tampered[0] = tampered[0] == '0' ? '1' : '0';
+  ASSERT_EQ(engine.validateNonce(tampered, now), SIPDigestAuthEngine::AUTH_INVALID_NONCE);
+
+  SIPDigestAuthEngine::Hash ha1;
+  SIPDigestAuthEngine::Hash ha2;
+  SIPDigestAuthEngine::Hash response;
+  SIPDigestAuthEngine::computeHA1(SIPDigestAuthEngine::ALGORITHM_SHA256, "Mufasa", "domain.com", "Circle of Life", ha1);
+  SIPDigestAuthEngine::computeHA2(SIPDigestAuthEngine::ALGORITHM_SHA256, "REGISTER", "sip:domain.com", ha2);
+  SIPDigestAuthEngine::computeResponse(SIPDigestAuthEngine::ALGORITHM_SHA256, ha1, nonce, "00000001", "abcdef", "auth", ha2, response);
+
+  SIPAuthorization auth;
+  auth.setUserName("Mufasa");
+  auth.setRealm("domain.com");
+  auth.setNonce(nonce.c_str());
+  auth.setDigestUri("sip:domain.com");
+  auth.setAlgorithm("SHA-256");
+  auth.setQop("auth");
+  auth.setCNonce("abcdef");
+  auth.setNonceCount("00000001");
+  auth.setDigestResponse(response.hex);
+
+  ASSERT_EQ(engine.getHA1CacheSize(), 0);
+  ASSERT_EQ(engine.authenticate(auth.data(), "REGISTER", now), SIPDigestAuthEngine::AUTH_OK);
+  ASSERT_EQ(engine.getHA1CacheSize(), 1);
+
+  //
+  // The same nonce-count must be rejected as a replay
+  //
+  ASSERT_EQ(engine.authenticate(auth.data(), "REGISTER", now), SIPDigestAuthEngine::AUTH_REPLAY);
+
+  //
+  // A wrong method produces a different HA2
+  //
+  SIPDigestAuthEngine::computeResponse(SIPDigestAuthEngine::ALGORITHM_SHA256, ha1, nonce, "00000002", "abcdef", "auth", ha2, response);
+  auth.setNonceCount("00000002");
+  auth.setDigestResponse(response.hex);
+  ASSERT_EQ(engine.authenticate(auth.data(), "INVITE", now), SIPDigestAuthEngine::AUTH_INVALID_RESPONSE);
+  ASSERT_EQ(engine.authenticate(auth.data(), "REGISTER", now), SIPDigestAuthEngine::AUTH_OK);
+
+  auth.setUserName("Scar");
+  ASSERT_EQ(engine.authenticate(auth.data(), "REGISTER", now), SIPDigestAuthEngine::AUTH_UNKNOWN_USER);
+
+  //
+  // Filling the replay cache evicts the oldest nonce, which then becomes stale
+  //
+  ASSERT_EQ(engine.checkNonceCount(engine.createNonce(now + 1), "00000001"), SIPDigestAuthEngine::AUTH_OK);
+  ASSERT_EQ(engine.checkNonceCount(engine.createNonce(now + 2), "00000001"), SIPDigestAuthEngine::AUTH_OK);
+  ASSERT_EQ(engine.getNonceCacheSize(), 2);
+  ASSERT_EQ(engine.checkNonceCount(nonce, "00000003"), SIPDigestAuthEngine::AUTH_STALE_NONCE);
+}
@@ -0,0 +1,184 @@
+#include "gtest/gtest.h"
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_NET_EXTRA
+
+#include <cstring>
+#include <vector>
+#include "OSS/Net/FramedTcpConnection.h"
+#include "OSS/Net/FramedTcpListener.h"
+
+using OSS::FramedTcpConnection;
+using OSS::FramedTcpListener;
+
+
+class FrameCollector : public FramedTcpListener
+{
+public:
+  void onIncomingRequest(FramedTcpConnection& connection, const char* data, std::size_t len)
+  {
+    frames.push_back(std::string(data, len));
+  }
+
+  std::size_t poll()
+  {
+    _ioService.reset();
+    return _ioService.poll();
+  }
+
+  std::size_t getConnectionCount() const
+  {
+    return _connections.size();
+  }
+
+  std::vector<std::string> frames;
+};
+
+class FrameFeeder : public FramedTcpConnection
+  /// Hands bytes to the frame parser as if they were read off the socket
+{
+public:
+  explicit FrameFeeder(FramedTcpListener& listener) : FramedTcpConnection(listener) {}
+
+  bool feed(const std::string& bytes)
+  {
+    if (_readBuffer.size() - _readEnd < bytes.size())
+      _readBuffer.resize(_readEnd + bytes.size());
+    if (!bytes.empty())
+      std::memcpy(&_readBuffer[_readEnd], bytes.data(), bytes.size());
+    _readEnd += bytes.size();
+    return processFrames();
+  }
+
+  std::size_t getBufferSize() const
+  {
+    return _readBuffer.size();
+  }
+
+  void armInactivityTimer()
+  {
+    startInactivityTimer();
+  }
+};
+
+static std::string make_frame(const std::string& payload)
+{
+  char header[FTCP_HEADER_SIZE];
+  FramedTcpConnection::encodeHeader(header, payload.size());
+  return std::string(header, FTCP_HEADER_SIZE) + payload;
+}
+
+TEST(FramedTcpTest, test_header)
+{
+  char buffer[FTCP_HEADER_SIZE];
+  FramedTcpConnection::encodeHeader(buffer, 0x01020304);
+  ASSERT_EQ((unsigned char)buffer[0], 0);
+  ASSERT_EQ((unsigned char)buffer[1], FTCP_VERSION);
+  ASSERT_EQ((unsigned char)buffer[4], 0x01);
+  ASSERT_EQ((unsigned char)buffer[7], 0x04);
+
+  FramedTcpConnection::Header header;
+  ASSERT_TRUE(FramedTcpConnection::decodeHeader(buffer, header));
+  ASSERT_EQ(header.version, FTCP_VERSION);
+  ASSERT_EQ(header.key, FTCP_KEY);
+  ASSERT_EQ(header.size, (OSS::UInt32)0x01020304);
+
+  buffer[1] = FTCP_VERSION + 1;
+  ASSERT_FALSE(FramedTcpConnection::decodeHeader(buffer, header));
+  FramedTcpConnection::encodeHeader(buffer, 10);
+  buffer[3] ^= 0xFF;
+  ASSERT_FALSE(FramedTcpConnection::decodeHeader(buffer, header));
+}
+
+TEST(FramedTcpTest, test_invalid_frames)
+{
+  FrameCollector listener;
+
+  FramedTcpConnection::Ptr invalid(new FrameFeeder(listener));
+  std::string frame = make_frame("abc");
+  frame[2] = 0;
+  ASSERT_FALSE(static_cast<FrameFeeder*>(invalid.get())->feed(frame));
+
+  //
+  // An oversized frame is refused from its header alone
+  //
+  FramedTcpConnection::Ptr oversized(new FrameFeeder(listener));
+  char header[FTCP_HEADER_SIZE];
+  FramedTcpConnection::encodeHeader(header, FTCP_MAX_FRAME_SIZE + 1);
+  ASSERT_FALSE(static_cast<FrameFeeder*>(oversized.get())->feed(std::string(header, FTCP_HEADER_SIZE)));
+  ASSERT_TRUE(listener.frames.empty());
+
+  ASSERT_FALSE(oversized->write(std::string(FTCP_MAX_FRAME_SIZE + 1, 'x')));
+}
+
+TEST(FramedTcpTest, test_split_frames)
+{
+  FrameCollector listener;
+  FramedTcpConnection::Ptr connection(new FrameFeeder(listener));
+  FrameFeeder* pFeeder = static_cast<FrameFeeder*>(connection.get());
+
+  //
+  // Frames arrive one byte at a time, across headers and payloads
+  //
+  std::string stream = make_frame("first") + make_frame("") + make_frame("third");
+  for (std::size_t i = 0; i < stream.size(); i++)
+    ASSERT_TRUE(pFeeder->feed(stream.substr(i, 1)));
+  ASSERT_EQ(listener.frames.size(), (std::size_t)3);
+  ASSERT_EQ(listener.frames[0], "first");
+  ASSERT_EQ(listener.frames[1], "");
+  ASSERT_EQ(listener.frames[2], "third");
+
+  //
+  // A frame larger than the read buffer is delivered whole and the buffer
+  // shrinks back once it is consumed
+  //
+  std::string large(FTCP_READ_BUFFER_SIZE * 3, 'z');
+  std::string frame = make_frame(large) + make_frame("tail").substr(0, 3);
+  ASSERT_TRUE(pFeeder->feed(frame.substr(0, 100)));
+  ASSERT_GE(pFeeder->getBufferSize(), large.size() + FTCP_HEADER_SIZE);
+  ASSERT_TRUE(pFeeder->feed(frame.substr(100)));
+  ASSERT_EQ(listener.frames.size(), (std::size_t)4);
+  ASSERT_EQ(listener.frames[3], large);
+  ASSERT_TRUE(pFeeder->feed(make_frame("tail").substr(3)));
+  ASSERT_EQ(listener.frames.size(), (std::size_t)5);
+  ASSERT_EQ(listener.frames[4], "tail");
+  ASSERT_EQ(pFeeder->getBufferSize(), (std::size_t)FTCP_READ_BUFFER_SIZE);
+}
+
+TEST(FramedTcpTest, test_write_error_closes)
+{
+  FrameCollector listener;
+  FramedTcpConnection::Ptr connection(new FrameFeeder(listener));
+
+  //
+  // The socket was never connected so the send fails and the connection
+  // is closed
+  //
+  ASSERT_TRUE(connection->write("data"));
+  listener.poll();
+  ASSERT_FALSE(connection->write("data"));
+}
+
+TEST(FramedTcpTest, test_inactivity_timeout_destroys)
+{
+  FrameCollector listener;
+  listener.setInactivityThreshold(0);
+  boost::shared_ptr<FrameFeeder> connection(new FrameFeeder(listener));
+  listener.addConnection(connection);
+  ASSERT_EQ(listener.getConnectionCount(), 1);
+
+  //
+  // The timer holds the connection alive until it fires and hands it back
+  // to the listener
+  //
+  connection->armInactivityTimer();
+  listener.poll();
+  ASSERT_EQ(listener.getConnectionCount(), 0);
+  ASSERT_FALSE(connection->write("data"));
+}
+
+#else
+
+TEST(NullTest, null_test_framed_tcp){}
+
+#endif // ENABLE_FEATURE_NET_EXTRA
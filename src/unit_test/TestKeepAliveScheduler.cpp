@@ -0,0 +1,162 @@
+#include "gtest/gtest.h"
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <set>
+#include "OSS/SIP/SIPMessage.h"
+#include "OSS/SIP/B2BUA/SIPB2BKeepAliveScheduler.h"
+
+
+using OSS::SIP::B2BUA::RegData;
+using OSS::SIP::B2BUA::SIPB2BKeepAliveBinding;
+using OSS::SIP::B2BUA::SIPB2BKeepAliveScheduler;
+
+static SIPB2BKeepAliveScheduler::BindingPtr createKeepAliveBinding(const std::string& key, int expires)
+{
+  SIPB2BKeepAliveScheduler::BindingPtr binding(new SIPB2BKeepAliveBinding());
+  binding->registration.key = key;
+  binding->registration.aor = "sip:" + key + "@example.com";
+  binding->registration.contact = "sip:" + key + "@192.168.1.10:5060";
+  binding->registration.localInterface = "10.0.0.1:5060";
+  binding->registration.packetSource = "1.2.3.4:5060";
+  binding->registration.expires = expires;
+  binding->transportScheme = "UDP";
+  binding->options.compile(binding->registration, binding->transportScheme, binding->registration.localInterface);
+  return binding;
+}
+
+TEST(KeepAliveSchedulerTest, test_options_template)
+{
+  SIPB2BKeepAliveScheduler::BindingPtr binding = createKeepAliveBinding("sbc-reg-1", 3600);
+  ASSERT_TRUE(binding->options.isCompiled());
+
+  std::string packet;
+  binding->options.render("abcd", 42, packet);
+
+  OSS::SIP::SIPMessage msg(packet);
+  ASSERT_TRUE(msg.isRequest("OPTIONS"));
+  ASSERT_EQ(msg.getStartLine(), "OPTIONS sip:sbc-reg-1@192.168.1.10:5060 SIP/2.0");
+  ASSERT_EQ(msg.hdrGet(OSS::SIP::HDR_CALL_ID), "abcd42");
+  ASSERT_EQ(msg.hdrGet(OSS::SIP::HDR_CSEQ), "42 OPTIONS");
+  ASSERT_EQ(msg.hdrGet(OSS::SIP::HDR_FROM), "sip:sbc-reg-1@example.com;tag=abcd42");
+  ASSERT_EQ(msg.hdrGet(OSS::SIP::HDR_VIA), "SIP/2.0/UDP 10.0.0.1:5060;branch=z9hG4bKabcd42;rport");
+  ASSERT_EQ(msg.hdrGet(OSS::SIP::HDR_CONTACT), "<sip:sbc-reg-1@10.0.0.1:5060>");
+
+  std::string next;
+  binding->options.render("abcd", 43, next);
+  ASSERT_NE(packet, next);
+}
+
+TEST(KeepAliveSchedulerTest, test_options_request)
+{
+  SIPB2BKeepAliveScheduler::BindingPtr binding = createKeepAliveBinding("sbc-reg-1", 3600);
+
+  OSS::SIP::SIPMessage::Ptr first = binding->options.createRequest("abcd", 42);
+  OSS::SIP::SIPMessage::Ptr second = binding->options.createRequest("abcd", 43);
+
+  std::string packet;
+  binding->options.render("abcd", 42, packet);
+  OSS::SIP::SIPMessage rendered(packet);
+  OSS::SIP::SIPMessage parsed(first->data());
+  const char* headers[] = { OSS::SIP::HDR_CALL_ID, OSS::SIP::HDR_CSEQ, OSS::SIP::HDR_FROM,
+    OSS::SIP::HDR_TO, OSS::SIP::HDR_VIA, OSS::SIP::HDR_CONTACT, OSS::SIP::HDR_CONTENT_LENGTH };
+  for (std::size_t i = 0; i < sizeof(headers) / sizeof(headers[0]); i++)
+  {
+    ASSERT_EQ(first->hdrGet(headers[i]), rendered.hdrGet(headers[i]));
+    ASSERT_EQ(parsed.hdrGet(headers[i]), rendered.hdrGet(headers[i]));
+  }
+  ASSERT_EQ(parsed.getStartLine(), rendered.getStartLine());
+
+  std::string firstId, secondId, renderedId;
+  ASSERT_TRUE(first->getTransactionId(firstId));
+  ASSERT_TRUE(second->getTransactionId(secondId));
+  ASSERT_TRUE(rendered.getTransactionId(renderedId));
+  ASSERT_EQ(firstId, renderedId);
+  ASSERT_NE(firstId, secondId);
+  ASSERT_EQ(second->hdrGet(OSS::SIP::HDR_CALL_ID), "abcd43");
+  ASSERT_EQ(second->hdrGet(OSS::SIP::HDR_CSEQ), "43 OPTIONS");
+}
+
+TEST(KeepAliveSchedulerTest, test_spread_and_rearm)
+{
+  const unsigned int interval = 60000;
+  const unsigned int resolution = 1000;
+  const unsigned int bindings = 6000;
+  const OSS::UInt64 start = 1000000;
+
+  SIPB2BKeepAliveScheduler scheduler(interval, resolution);
+  for (unsigned int i = 0; i < bindings; i++)
+    scheduler.schedule(createKeepAliveBinding("sbc-reg-" + OSS::string_from_number(i), 0), start);
+  ASSERT_EQ(scheduler.size(), bindings);
+
+  //
+  // Every binding is visited exactly once per interval and no single tick
+  // carries much more than its fair share.
+  //
+  std::set<std::string> visited;
+  std::size_t largestTick = 0;
+  for (OSS::UInt64 now = start + resolution; now <= start + interval; now += resolution)
+  {
+    SIPB2BKeepAliveScheduler::BindingList due;
+    scheduler.collectDue(now, due);
+    largestTick = std::max(largestTick, due.size());
+    for (SIPB2BKeepAliveScheduler::BindingList::const_iterator iter = due.begin(); iter != due.end(); iter++)
+      ASSERT_TRUE(visited.insert((*iter)->registration.key).second);
+  }
+  ASSERT_EQ(visited.size(), bindings);
+  ASSERT_LT(largestTick, 3 * bindings * resolution / interval);
+
+  //
+  // The second interval visits everything again
+  //
+  std::size_t total = 0;
+  for (OSS::UInt64 now = start + interval + resolution; now <= start + 2 * interval; now += resolution)
+  {
+    SIPB2BKeepAliveScheduler::BindingList due;
+    scheduler.collectDue(now, due);
+    total += due.size();
+  }
+  ASSERT_EQ(total, bindings);
+}
+
+TEST(KeepAliveSchedulerTest, test_unschedule_refresh_and_expire)
+{
+  const OSS::UInt64 start = 1000000;
+  SIPB2BKeepAliveScheduler scheduler(10000, 100);
+
+  scheduler.schedule(createKeepAliveBinding("removed", 0), start);
+  scheduler.schedule(createKeepAliveBinding("expiring", 5), start);
+  scheduler.schedule(createKeepAliveBinding("refreshed", 0), start);
+  ASSERT_EQ(scheduler.size(), 3);
+
+  ASSERT_TRUE(scheduler.unschedule("removed"));
+  ASSERT_FALSE(scheduler.unschedule("removed"));
+  ASSERT_FALSE(scheduler.find("removed"));
+
+  SIPB2BKeepAliveScheduler::BindingPtr refreshed = createKeepAliveBinding("refreshed", 0);
+  refreshed->registration.contact = "sip:refreshed@192.168.1.20:5060";
+  scheduler.schedule(refreshed, start + 10);
+  ASSERT_EQ(scheduler.size(), 2);
+  ASSERT_EQ(scheduler.find("refreshed"), refreshed);
+
+  std::set<std::string> visited;
+  for (OSS::UInt64 now = start + 100; now <= start + 30000; now += 100)
+  {
+    SIPB2BKeepAliveScheduler::BindingList due;
+    scheduler.collectDue(now, due);
+    for (SIPB2BKeepAliveScheduler::BindingList::const_iterator iter = due.begin(); iter != due.end(); iter++)
+    {
+      visited.insert((*iter)->registration.key);
+      if ((*iter)->registration.key == "refreshed")
+        ASSERT_EQ(*iter, refreshed);
+    }
+  }
+
+  ASSERT_EQ(visited.count("removed"), 0);
+  ASSERT_EQ(visited.count("refreshed"), 1);
+  ASSERT_FALSE(scheduler.find("expiring"));
+  ASSERT_EQ(scheduler.size(), 1);
+}
+
+#endif // ENABLE_FEATURE_B2BUA
@@ -296,3 +296,167 @@ TEST(NullTest, null_test_kv){}
 #endif
 #endif
 
+
+#include <boost/filesystem.hpp>
+#include "OSS/Persistent/KeyValueStore.h"
+#include "OSS/UTL/CoreUtils.h"
+
+#define lmdbkvdir "/tmp/oss_core-kv-lmdb.test"
+
+TEST(KeyValueStoreLMDBTest, test_put_get_expires)
+{
+  OSS::Persistent::KeyValueStoreLMDB store;
+  boost::filesystem::remove_all(lmdbkvdir);
+  ASSERT_TRUE(store.open(lmdbkvdir));
+  ASSERT_TRUE(store.isOpen());
+
+  std::string result;
+  ASSERT_TRUE(store.put("plain", "plain-value"));
+  ASSERT_TRUE(store.get("plain", result));
+  ASSERT_STREQ(result.c_str(), "plain-value");
+
+  ASSERT_TRUE(store.put("empty", ""));
+  ASSERT_TRUE(store.get("empty", result));
+  ASSERT_TRUE(result.empty());
+
+  std::string magic("\0KVT-binary", 11);
+  ASSERT_TRUE(store.put("magic", magic));
+  ASSERT_TRUE(store.get("magic", result));
+  ASSERT_EQ(result, magic);
+
+  ASSERT_TRUE(store.put("expiring", "expiring-value", 1));
+  ASSERT_TRUE(store.get("expiring", result));
+  ASSERT_STREQ(result.c_str(), "expiring-value");
+  OSS::thread_sleep(1100);
+  ASSERT_FALSE(store.get("expiring", result));
+  //
+  // Reading an expired record purges it
+  //
+  ASSERT_FALSE(store.getDB().get("expiring", result));
+
+  OSS::Persistent::KVRecords records;
+  ASSERT_TRUE(store.getRecords(records));
+  ASSERT_EQ(records.size(), 3);
+
+  ASSERT_TRUE(store.close());
+  boost::filesystem::remove_all(lmdbkvdir);
+}
+
+TEST(KeyValueStoreLMDBTest, test_write_batch_and_sweep)
+{
+  OSS::Persistent::KeyValueStoreLMDB store;
+  boost::filesystem::remove_all(lmdbkvdir);
+  ASSERT_TRUE(store.open(lmdbkvdir));
+
+  OSS::Persistent::KVWriteBatch batch;
+  for (int i = 0; i < 100; i++)
+  {
+    std::string key = "batch." + OSS::string_from_number(i);
+    if (i % 2)
+      batch.put(key, key, 1);
+    else
+      batch.put(key, key);
+  }
+  batch.del("batch.0");
+  ASSERT_TRUE(store.write(batch));
+
+  std::string result;
+  ASSERT_FALSE(store.get("batch.0", result));
+  ASSERT_TRUE(store.get("batch.1", result));
+  ASSERT_STREQ(result.c_str(), "batch.1");
+
+  //
+  // A record written by an older version with a separate expires key
+  //
+  ASSERT_TRUE(store.getDB().put("legacy", "legacy-value"));
+  ASSERT_TRUE(store.getDB().put(std::string("legacy") + PERSISTENT_STORE_EXPIRES_SUFFIX,
+    OSS::string_from_number<OSS::UInt64>(OSS::getTime() + 60000)));
+  ASSERT_TRUE(store.getDB().put("legacy-expired", "legacy-value"));
+  ASSERT_TRUE(store.getDB().put(std::string("legacy-expired") + PERSISTENT_STORE_EXPIRES_SUFFIX,
+    OSS::string_from_number<OSS::UInt64>(OSS::getTime() - 1000)));
+
+  OSS::thread_sleep(1100);
+
+  //
+  // Sweep in small increments until the cursor wraps
+  //
+  std::size_t reclaimed = 0;
+  for (int i = 0; i < 20; i++)
+    reclaimed += store.sweepExpired(10);
+  ASSERT_EQ(reclaimed, 51);
+
+  OSS::Persistent::KVKeys keys;
+  ASSERT_TRUE(store.getKeys(keys));
+  ASSERT_EQ(keys.size(), 50);
+
+  ASSERT_TRUE(store.get("legacy", result));
+  ASSERT_STREQ(result.c_str(), "legacy-value");
+  ASSERT_FALSE(store.get("legacy-expired", result));
+  ASSERT_FALSE(store.getDB().get(std::string("legacy") + PERSISTENT_STORE_EXPIRES_SUFFIX, result));
+
+  ASSERT_TRUE(store.close());
+  boost::filesystem::remove_all(lmdbkvdir);
+}
+
+TEST(KeyValueStoreLMDBTest, test_legacy_expires_on_open)
+{
+  boost::filesystem::remove_all(lmdbkvdir);
+  {
+    OSS::Persistent::KeyValueStoreLMDB store;
+    ASSERT_TRUE(store.open(lmdbkvdir));
+    ASSERT_TRUE(store.getDB().put("legacy", "legacy-value"));
+    ASSERT_TRUE(store.getDB().put(std::string("legacy") + PERSISTENT_STORE_EXPIRES_SUFFIX,
+      OSS::string_from_number<OSS::UInt64>(OSS::getTime() + 60000)));
+    ASSERT_TRUE(store.getDB().put("legacy-expired", "legacy-value"));
+    ASSERT_TRUE(store.getDB().put(std::string("legacy-expired") + PERSISTENT_STORE_EXPIRES_SUFFIX,
+      OSS::string_from_number<OSS::UInt64>(OSS::getTime() - 1000)));
+    ASSERT_TRUE(store.put("plain", "plain-value"));
+    ASSERT_TRUE(store.close());
+  }
+
+  //
+  // Opening the store folds the old expires keys without a sweeper
+  //
+  OSS::Persistent::KeyValueStoreLMDB store;
+  ASSERT_TRUE(store.open(lmdbkvdir));
+
+  std::string result;
+  ASSERT_FALSE(store.get("legacy-expired", result));
+  ASSERT_TRUE(store.get("legacy", result));
+  ASSERT_STREQ(result.c_str(), "legacy-value");
+  ASSERT_TRUE(store.get("plain", result));
+  ASSERT_STREQ(result.c_str(), "plain-value");
+
+  OSS::Persistent::KVKeys keys;
+  ASSERT_TRUE(store.getKeys(keys));
+  ASSERT_EQ(keys.size(), 2);
+
+  ASSERT_TRUE(store.getDB().get("legacy", result));
+  ASSERT_TRUE(OSS::Persistent::kv_has_ttl_header(result));
+
+  ASSERT_TRUE(store.close());
+  boost::filesystem::remove_all(lmdbkvdir);
+}
+
+TEST(KeyValueStoreLMDBTest, test_background_sweeper)
+{
+  OSS::Persistent::KeyValueStoreLMDB store;
+  boost::filesystem::remove_all(lmdbkvdir);
+  ASSERT_TRUE(store.open(lmdbkvdir));
+
+  for (int i = 0; i < 50; i++)
+    ASSERT_TRUE(store.put("sweep." + OSS::string_from_number(i), "value", 1));
+  ASSERT_TRUE(store.put("keep", "value"));
+
+  store.startSweeper(100, 16);
+  OSS::thread_sleep(2000);
+  store.stopSweeper();
+
+  OSS::Persistent::KVKeys keys;
+  ASSERT_TRUE(store.getKeys(keys));
+  ASSERT_EQ(keys.size(), 1);
+  ASSERT_STREQ(keys[0].c_str(), "keep");
+
+  ASSERT_TRUE(store.close());
+  boost::filesystem::remove_all(lmdbkvdir);
+}
@@ -0,0 +1,169 @@
+#include "gtest/gtest.h"
+
+#include <set>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include "OSS/UTL/LockFreeQueue.h"
+
+
+using OSS::SPSCRing;
+using OSS::MPMCRing;
+using OSS::LockFreeQueue;
+
+#define QUEUE_TEST_PRODUCERS 4
+#define QUEUE_TEST_ITEMS_PER_PRODUCER 50000
+
+static void produce(LockFreeQueue<int>* pQueue, int producer)
+{
+  for (int i = 0; i < QUEUE_TEST_ITEMS_PER_PRODUCER; i++)
+  {
+    int value = producer * QUEUE_TEST_ITEMS_PER_PRODUCER + i;
+    while (!pQueue->enqueue(value))
+      boost::this_thread::yield();
+  }
+}
+
+static void consume(LockFreeQueue<int, SPSCRing<int> >* pQueue, std::vector<int>* pReceived)
+{
+  for (;;)
+  {
+    int value;
+    pQueue->dequeue(value);
+    if (value < 0)
+      break;
+    pReceived->push_back(value);
+  }
+}
+
+TEST(LockFreeQueueTest, test_spsc_ring)
+{
+  SPSCRing<int> ring(5);
+  ASSERT_EQ(ring.capacity(), (std::size_t)8);
+
+  for (int i = 0; i < 8; i++)
+    ASSERT_TRUE(ring.try_enqueue(i));
+  ASSERT_FALSE(ring.try_enqueue(8));
+  ASSERT_EQ(ring.size(), (std::size_t)8);
+  ASSERT_EQ(ring.getHighWatermark(), (std::size_t)8);
+
+  int value = -1;
+  for (int i = 0; i < 8; i++)
+  {
+    ASSERT_TRUE(ring.try_dequeue(value));
+    ASSERT_EQ(value, i);
+  }
+  ASSERT_FALSE(ring.try_dequeue(value));
+  ASSERT_EQ(ring.size(), (std::size_t)0);
+
+  //
+  // Positions keep growing past the capacity
+  //
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_TRUE(ring.try_enqueue(i));
+    ASSERT_TRUE(ring.try_dequeue(value));
+    ASSERT_EQ(value, i);
+  }
+  ASSERT_EQ(ring.getHighWatermark(), (std::size_t)8);
+}
+
+TEST(LockFreeQueueTest, test_mpmc_ring)
+{
+  MPMCRing<std::string> ring(4);
+  ASSERT_TRUE(ring.try_enqueue("a"));
+  ASSERT_TRUE(ring.try_enqueue("b"));
+  ASSERT_TRUE(ring.try_enqueue("c"));
+  ASSERT_TRUE(ring.try_enqueue("d"));
+  ASSERT_FALSE(ring.try_enqueue("e"));
+  ASSERT_EQ(ring.getHighWatermark(), (std::size_t)4);
+
+  std::string value;
+  ASSERT_TRUE(ring.try_dequeue(value));
+  ASSERT_EQ(value, "a");
+  ASSERT_TRUE(ring.try_enqueue("e"));
+  ASSERT_EQ(ring.size(), (std::size_t)4);
+}
+
+TEST(LockFreeQueueTest, test_ring_releases_elements)
+{
+  boost::shared_ptr<int> element(new int(1));
+  MPMCRing< boost::shared_ptr<int> > ring(2);
+  ring.try_enqueue(element);
+  ASSERT_EQ(element.use_count(), 2);
+
+  boost::shared_ptr<int> value;
+  ring.try_dequeue(value);
+  value.reset();
+  ASSERT_EQ(element.use_count(), 1);
+}
+
+TEST(LockFreeQueueTest, test_blocking_dequeue)
+{
+  LockFreeQueue<int> q(16);
+  int x = 999;
+  ASSERT_FALSE(q.try_dequeue(x));
+  ASSERT_FALSE(q.try_dequeue(x, 50));
+  ASSERT_EQ(x, 999);
+
+  for (int i = 0; i < 16; i++)
+    ASSERT_TRUE(q.enqueue(i));
+  ASSERT_FALSE(q.enqueue(16));
+
+  for (int i = 0; i < 16; i++)
+  {
+    q.dequeue(x);
+    ASSERT_EQ(x, i);
+  }
+  ASSERT_EQ(q.getHighWatermark(), (std::size_t)16);
+}
+
+TEST(LockFreeQueueTest, test_multiple_producers)
+{
+  LockFreeQueue<int> q(1024);
+  boost::thread_group producers;
+  for (int i = 0; i < QUEUE_TEST_PRODUCERS; i++)
+    producers.create_thread(boost::bind(produce, &q, i));
+
+  //
+  // Every value must arrive exactly once and each producer's values in order
+  //
+  std::set<int> received;
+  int last[QUEUE_TEST_PRODUCERS];
+  for (int i = 0; i < QUEUE_TEST_PRODUCERS; i++)
+    last[i] = -1;
+
+  for (int i = 0; i < QUEUE_TEST_PRODUCERS * QUEUE_TEST_ITEMS_PER_PRODUCER; i++)
+  {
+    int value;
+    ASSERT_TRUE(q.try_dequeue(value, 5000));
+    int producer = value / QUEUE_TEST_ITEMS_PER_PRODUCER;
+    int sequence = value % QUEUE_TEST_ITEMS_PER_PRODUCER;
+    ASSERT_GT(sequence, last[producer]);
+    last[producer] = sequence;
+    received.insert(value);
+  }
+  producers.join_all();
+
+  ASSERT_EQ(received.size(), (std::size_t)(QUEUE_TEST_PRODUCERS * QUEUE_TEST_ITEMS_PER_PRODUCER));
+  ASSERT_EQ(q.size(), (std::size_t)0);
+  ASSERT_TRUE(q.getHighWatermark() <= q.capacity());
+}
+
+TEST(LockFreeQueueTest, test_spsc_queue)
+{
+  LockFreeQueue<int, SPSCRing<int> > q(64);
+  std::vector<int> received;
+  boost::thread consumer(boost::bind(consume, &q, &received));
+  for (int i = 0; i < 100000; i++)
+  {
+    while (!q.enqueue(i))
+      boost::this_thread::yield();
+  }
+  while (!q.enqueue(-1))
+    boost::this_thread::yield();
+  consumer.join();
+
+  ASSERT_EQ(received.size(), (std::size_t)100000);
+  for (int i = 0; i < 100000; i++)
+    ASSERT_EQ(received[i], i);
+}
@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include "OSS/UTL/Metrics.h"
+
+
+static void countTo(OSS::MetricCounter* counter, int count)
+{
+  for (int i = 0; i < count; i++)
+    counter->increment();
+}
+
+TEST(MetricsTest, test_striped_counter)
+{
+  OSS::MetricCounter counter;
+  boost::thread_group threads;
+  for (int i = 0; i < 8; i++)
+    threads.create_thread(boost::bind(countTo, &counter, 10000));
+  threads.join_all();
+  ASSERT_EQ(counter.value(), 80000);
+
+  counter.increment(5);
+  ASSERT_EQ(counter.value(), 80005);
+  counter.reset();
+  ASSERT_EQ(counter.value(), 0);
+}
+
+TEST(MetricsTest, test_registry)
+{
+  OSS::Metrics metrics;
+  OSS::MetricCounter& packets = metrics.counter("test_packets_total", "Packets");
+  ASSERT_EQ(&packets, &metrics.counter("test_packets_total"));
+  ASSERT_NE(&packets, &metrics.counter("test_bytes_total"));
+  ASSERT_EQ(&metrics.histogram("test_microseconds"), &metrics.histogram("test_microseconds"));
+
+  packets.increment(3);
+  metrics.histogram("test_microseconds").record(100);
+
+  std::string json;
+  metrics.toJson(json);
+  ASSERT_EQ(json, "{\"counters\":{\"test_bytes_total\":0,\"test_packets_total\":3},\"gauges\":{},"
+    "\"histograms\":{\"test_microseconds\":{\"count\":1,\"sum\":100,\"max\":100,\"mean\":100,"
+    "\"p50\":100,\"p90\":100,\"p99\":100,\"p999\":100}}}");
+
+  metrics.reset();
+  ASSERT_EQ(packets.value(), 0);
+}
+
+TEST(MetricsTest, test_gauge)
+{
+  OSS::Metrics metrics;
+  OSS::MetricCounter& live = metrics.gauge("test_live_bytes", "Live");
+  ASSERT_EQ(&live, &metrics.gauge("test_live_bytes"));
+  live.increment(10);
+  live.decrement(4);
+  ASSERT_EQ(live.value(), 6);
+
+  std::string text;
+  metrics.toPrometheus(text);
+  ASSERT_NE(text.find("# HELP test_live_bytes Live\n# TYPE test_live_bytes gauge\ntest_live_bytes 6\n"), std::string::npos);
+
+  metrics.reset();
+  ASSERT_EQ(live.value(), 6);
+}
+
+TEST(MetricsTest, test_prometheus)
+{
+  OSS::Metrics metrics;
+  metrics.counter("test_packets_total", "Packets\nread").increment(7);
+  OSS::LatencyHistogram& latency = metrics.histogram("test_microseconds", "Latency");
+  latency.record(0);
+  latency.record(3);
+  latency.record(100);
+
+  std::string text;
+  metrics.toPrometheus(text);
+  ASSERT_NE(text.find("# HELP test_packets_total Packets\\nread\n# TYPE test_packets_total counter\ntest_packets_total 7\n"), std::string::npos);
+  ASSERT_NE(text.find("# TYPE test_microseconds histogram\n"), std::string::npos);
+  ASSERT_NE(text.find("test_microseconds_bucket{le=\"0\"} 1\n"), std::string::npos);
+  ASSERT_NE(text.find("test_microseconds_bucket{le=\"3\"} 2\n"), std::string::npos);
+  ASSERT_NE(text.find("test_microseconds_bucket{le=\"63\"} 2\n"), std::string::npos);
+  ASSERT_NE(text.find("test_microseconds_bucket{le=\"127\"} 3\n"), std::string::npos);
+  ASSERT_NE(text.find("test_microseconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+  ASSERT_NE(text.find("test_microseconds_sum 103\ntest_microseconds_count 3\n"), std::string::npos);
+}
+
+TEST(MetricsTest, test_histogram_resolution)
+{
+  //
+  // Percentiles are within one sub-bucket of the exact value at any scale
+  //
+  OSS::LatencyHistogram latency;
+  for (OSS::UInt64 i = 1; i <= 1000; i++)
+    latency.record(i * 1000);
+  OSS::LatencyHistogram::Snapshot snapshot;
+  latency.snapshot(snapshot);
+  ASSERT_EQ(snapshot.count, 1000);
+  ASSERT_EQ(snapshot.max, 1000000);
+  ASSERT_EQ(snapshot.percentile(50), 524288);
+  ASSERT_EQ(snapshot.percentile(90), 917504);
+  ASSERT_EQ(snapshot.percentile(99), 1000000);
+
+  latency.reset();
+  latency.record(1000);
+  latency.record(1000);
+  latency.record(1000);
+  latency.record(1100);
+  latency.snapshot(snapshot);
+  ASSERT_EQ(snapshot.percentile(50), 1024);
+  ASSERT_EQ(snapshot.percentile(99), 1100);
+}
+
+TEST(MetricsTest, test_timer)
+{
+  OSS::LatencyHistogram latency;
+  {
+    OSS::Metrics::Timer timer(latency);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(2));
+  }
+  OSS::LatencyHistogram::Snapshot snapshot;
+  latency.snapshot(snapshot);
+  ASSERT_EQ(snapshot.count, 1);
+  ASSERT_GE(snapshot.max, 2000);
+}
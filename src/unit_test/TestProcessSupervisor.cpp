@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+#include "OSS/Exec/ProcessSupervisor.h"
+#include <signal.h>
+#include <sys/wait.h>
+
+
+using OSS::Exec::ProcessSample;
+using OSS::Exec::ProcessSampler;
+using OSS::Exec::ProcessSupervisor;
+
+
+static pid_t spawn_sleeper()
+{
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    execl("/bin/sleep", "sleep", "30", (char*)0);
+    _exit(127);
+  }
+  return pid;
+}
+
+struct SampleCollector
+{
+  OSS::mutex_critic_sec mutex;
+  int alive;
+  int dead;
+  int exitStatus;
+  std::string name;
+  OSS::semaphore deadSync;
+
+  SampleCollector() : alive(0), dead(0), exitStatus(-1) {}
+
+  bool onSample(const ProcessSample& sample)
+  {
+    OSS::mutex_critic_sec_lock lock(mutex);
+    if (sample.alive)
+    {
+      ++alive;
+      name = sample.name;
+      return true;
+    }
+    ++dead;
+    exitStatus = sample.exitStatus;
+    deadSync.set();
+    return false;
+  }
+};
+
+TEST(ProcessSupervisorTest, test_sampler)
+{
+  ProcessSampler self(getpid());
+  ProcessSample sample;
+  ASSERT_TRUE(self.sample(sample));
+  ASSERT_TRUE(sample.alive);
+  ASSERT_GT(sample.residentBytes, 0);
+  ASSERT_FALSE(sample.name.empty());
+
+  std::string name;
+  ASSERT_TRUE(ProcessSampler::readName(getpid(), name));
+  ASSERT_EQ(name, sample.name);
+
+  ProcessSampler none(-1);
+  ASSERT_FALSE(none.sample(sample));
+  ASSERT_FALSE(sample.alive);
+}
+
+TEST(ProcessSupervisorTest, test_watch_and_exit)
+{
+  SampleCollector collector;
+  ProcessSupervisor supervisor;
+
+  pid_t pid = spawn_sleeper();
+  ASSERT_GT(pid, 0);
+
+  ProcessSupervisor::WatchId id = supervisor.watch(pid, 50, 0,
+    boost::bind(&SampleCollector::onSample, &collector, _1));
+  ASSERT_TRUE(supervisor.isWatched(id));
+  ASSERT_FALSE(collector.deadSync.wait(300));
+  {
+    OSS::mutex_critic_sec_lock lock(collector.mutex);
+    ASSERT_GT(collector.alive, 0);
+    ASSERT_EQ(collector.name, "sleep");
+  }
+
+  //
+  // With pidfd_open the death is reported without waiting for the next
+  // interval.  Older kernels only notice it at the next sample.  Either way
+  // the child is reaped.
+  //
+  supervisor.unwatch(id);
+  unsigned int interval = ProcessSampler(pid).pidfd() != -1 ? 60000 : 50;
+  id = supervisor.watch(pid, interval, interval,
+    boost::bind(&SampleCollector::onSample, &collector, _1));
+  ::kill(pid, SIGKILL);
+  ASSERT_TRUE(collector.deadSync.wait(2000));
+  ASSERT_EQ(collector.dead, 1);
+  ASSERT_EQ(collector.exitStatus, SIGKILL);
+  for (int i = 0; i < 100 && supervisor.isWatched(id); i++)
+    OSS::thread_sleep(10);
+  ASSERT_FALSE(supervisor.isWatched(id));
+  ASSERT_EQ(supervisor.size(), 0);
+  supervisor.stop();
+}
+
+TEST(ProcessSupervisorTest, test_unwatch)
+{
+  SampleCollector collector;
+  ProcessSupervisor supervisor;
+
+  pid_t pid = spawn_sleeper();
+  ASSERT_GT(pid, 0);
+
+  ProcessSupervisor::WatchId id = supervisor.watch(pid, 10, 0,
+    boost::bind(&SampleCollector::onSample, &collector, _1));
+  ASSERT_FALSE(collector.deadSync.wait(100));
+  supervisor.unwatch(id);
+  ASSERT_EQ(supervisor.size(), 0);
+
+  int alive = 0;
+  {
+    OSS::mutex_critic_sec_lock lock(collector.mutex);
+    alive = collector.alive;
+  }
+  ASSERT_FALSE(collector.deadSync.wait(100));
+  ASSERT_EQ(collector.alive, alive);
+
+  ::kill(pid, SIGKILL);
+  waitpid(pid, 0, 0);
+  supervisor.stop();
+}
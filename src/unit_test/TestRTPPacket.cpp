@@ -118,6 +118,71 @@ TEST(RTPPacketTest, test_basic_packet_parser)
     ASSERT_EQ(pl1[i], pl[i]);
 }
 
+#if OSS_HAVE_PCAP
+
+TEST(RTPPacketTest, test_pcap_decode_datagram)
+{
+  //
+  // Ethernet with a VLAN tag, IPv4 and UDP carrying four bytes
+  //
+  u_char ethernet[] =
+  {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb,
+    0x81, 0x00, 0x00, 0x64, 0x08, 0x00,
+    0x45, 0x00, 0x00, 0x20, 0x00, 0x01, 0x40, 0x00, 0x40, 0x11, 0x00, 0x00,
+    0x0a, 0x00, 0x00, 0x01, 0x0a, 0x00, 0x00, 0x02,
+    0x13, 0xc4, 0x27, 0x10, 0x00, 0x0c, 0x00, 0x00,
+    'a', 'b', 'c', 'd',
+    0x00, 0x00
+  };
+
+  RTPPCAPReader::Datagram datagram;
+  ASSERT_TRUE(RTPPCAPReader::decodeDatagram(DLT_EN10MB, ethernet, sizeof(ethernet), datagram));
+  ASSERT_EQ(datagram.source.toIpPortString(), "10.0.0.1:5060");
+  ASSERT_EQ(datagram.destination.toIpPortString(), "10.0.0.2:10000");
+  ASSERT_EQ(datagram.payload, "abcd");
+
+  //
+  // The same packet as a raw IP capture.  Ethernet trailer bytes are not
+  // part of the datagram.
+  //
+  ASSERT_TRUE(RTPPCAPReader::decodeDatagram(DLT_RAW, ethernet + 18, sizeof(ethernet) - 18, datagram));
+  ASSERT_EQ(datagram.payload, "abcd");
+
+  //
+  // Fragments, truncated frames and other protocols are skipped
+  //
+  ethernet[24] = 0x20;
+  ASSERT_FALSE(RTPPCAPReader::decodeDatagram(DLT_EN10MB, ethernet, sizeof(ethernet), datagram));
+  ethernet[24] = 0x40;
+  ASSERT_FALSE(RTPPCAPReader::decodeDatagram(DLT_EN10MB, ethernet, 40, datagram));
+  ethernet[27] = 0x06;
+  ASSERT_FALSE(RTPPCAPReader::decodeDatagram(DLT_EN10MB, ethernet, sizeof(ethernet), datagram));
+
+  //
+  // Linux cooked capture with IPv6
+  //
+  u_char cooked[16 + 40 + 8 + 2] =
+  {
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x86, 0xdd,
+    0x60, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x11, 0x40
+  };
+  cooked[16 + 23] = 0x01;
+  cooked[16 + 39] = 0x01;
+  cooked[56] = 0x4e; cooked[57] = 0x20;
+  cooked[58] = 0x4e; cooked[59] = 0x22;
+  cooked[60] = 0x00; cooked[61] = 0x0a;
+  cooked[64] = 0x80; cooked[65] = 0x00;
+  ASSERT_TRUE(RTPPCAPReader::decodeDatagram(DLT_LINUX_SLL, cooked, sizeof(cooked), datagram));
+  ASSERT_TRUE(datagram.source.address().is_v6());
+  ASSERT_EQ(datagram.source.getPort(), 20000);
+  ASSERT_EQ(datagram.destination.getPort(), 20002);
+  ASSERT_EQ(datagram.payload.size(), 2);
+}
+
+#endif // OSS_HAVE_PCAP
+
 #if 0
 
 TEST(RTPPacketTest, test_pcap_reader)
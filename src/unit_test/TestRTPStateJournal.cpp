@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_RTP
+
+#include <boost/filesystem.hpp>
+#include "OSS/RTP/RTPProxyStateJournal.h"
+
+
+using OSS::RTP::RTPProxyRecord;
+using OSS::RTP::RTPProxyStateJournal;
+
+static const char* JOURNAL_TEST_DIR = "/tmp/oss_core-rtp-state-journal";
+
+static RTPProxyRecord createJournalRecord(const std::string& identifier, int state)
+{
+  RTPProxyRecord record;
+  record.identifier = identifier;
+  record.logId = "log-" + identifier;
+  record.state = state;
+  record.hasOfferedAudioProxy = true;
+  record.audio.data.identifier = identifier + "-audio";
+  record.audio.data.localEndPointLeg1 = "127.0.0.1:30000";
+  record.audio.data.localEndPointLeg2 = "127.0.0.1:30002";
+  return record;
+}
+
+TEST(RTPStateJournalTest, test_coalesce_and_reload)
+{
+  boost::filesystem::remove_all(JOURNAL_TEST_DIR);
+
+  {
+    RTPProxyStateJournal journal;
+    journal.setFlushInterval(60000);
+    ASSERT_TRUE(journal.open(boost::filesystem::path(JOURNAL_TEST_DIR)));
+
+    journal.update(createJournalRecord("session-1", 1));
+    journal.update(createJournalRecord("session-2", 1));
+    journal.update(createJournalRecord("session-3", 1));
+    journal.update(createJournalRecord("session-1", 2));
+    journal.update(createJournalRecord("session-1", 3));
+    ASSERT_EQ(journal.getPendingCount(), 3);
+
+    journal.flush();
+    ASSERT_EQ(journal.getPendingCount(), 0);
+
+    journal.remove("session-2");
+    journal.update(createJournalRecord("session-3", 4));
+    journal.close();
+  }
+
+  {
+    RTPProxyStateJournal journal;
+    ASSERT_TRUE(journal.open(boost::filesystem::path(JOURNAL_TEST_DIR)));
+
+    RTPProxyStateJournal::Records records;
+    ASSERT_TRUE(journal.load(records));
+    ASSERT_EQ(records.size(), 2);
+    ASSERT_EQ(records["session-1"].state, 3);
+    ASSERT_EQ(records["session-1"].logId, "log-session-1");
+    ASSERT_EQ(records["session-1"].audio.data.localEndPointLeg2, "127.0.0.1:30002");
+    ASSERT_EQ(records["session-3"].state, 4);
+    ASSERT_TRUE(records.find("session-2") == records.end());
+  }
+
+  boost::filesystem::remove_all(JOURNAL_TEST_DIR);
+}
+
+#endif // ENABLE_FEATURE_RTP
@@ -62,6 +62,8 @@ See also: For more string comparison tricks (substring, prefix, suffix, and regu
 #include "OSS/build.h"
 
 #include "OSS/RAFT/RaftConsensus.h"
+#include "OSS/UTL/CoreUtils.h"
+#include <boost/filesystem.hpp>
 
 
 using OSS::RAFT::RaftConsensus;
@@ -180,3 +182,259 @@ TEST(RAFTTest, TestRaftConsensus)
 #endif
 }
 
+
+
+//
+// Replication tests.  Replicas are wired together with in-process
+// connections that deliver every message synchronously.
+//
+
+using OSS::RAFT::RaftLogStore;
+using OSS::RAFT::RaftSnapshot;
+
+class Replica;
+
+class PipeConnection : public RaftConnection
+{
+public:
+  PipeConnection(Replica* local, RaftNode& node) :
+    RaftConnection((RaftConsensus*)local, node),
+    _remote(0),
+    _reverse(0)
+  {
+  }
+  void shutdown() {}
+  int onSendRequestVote(msg_requestvote_t& data);
+  int onSendAppendEntries(msg_appendentries_t& data);
+  int onSendRequestVoteResponse(msg_requestvote_response_t& data);
+  int onSendAppendEntriesResponse(msg_appendentries_response_t& data);
+  int onSendSnapshot(RaftSnapshot& snapshot);
+
+  Replica* _remote;
+  RaftConnection::Ptr* _reverse;
+  int _appendCount;
+};
+
+class Replica : public RaftConsensus
+{
+public:
+  void tick()
+  {
+    callPeriodicTimer();
+  }
+
+  Connection::Ptr createConnection(Node& node)
+  {
+    return _links[node.getId()];
+  }
+
+  int onApplyEntry(const raft_entry_t& entry)
+  {
+    _applied.push_back(std::string((const char*)entry.data.buf, entry.data.len));
+    return 0;
+  }
+
+  bool onCreateSnapshot(std::string& data)
+  {
+    data.clear();
+    for (std::vector<std::string>::iterator iter = _applied.begin(); iter != _applied.end(); iter++)
+    {
+      data += *iter + "\n";
+    }
+    return true;
+  }
+
+  bool onRestoreSnapshot(const std::string& data)
+  {
+    _applied.clear();
+    std::size_t start = 0;
+    std::size_t end = 0;
+    while ((end = data.find('\n', start)) != std::string::npos)
+    {
+      _applied.push_back(data.substr(start, end - start));
+      start = end + 1;
+    }
+    return true;
+  }
+
+  std::map<int, Connection::Ptr> _links;
+  std::vector<std::string> _applied;
+};
+
+int PipeConnection::onSendRequestVote(msg_requestvote_t& data)
+{
+  return _remote->onReceivedRequestVote(*_reverse, data);
+}
+
+int PipeConnection::onSendAppendEntries(msg_appendentries_t& data)
+{
+  _appendCount++;
+  return _remote->onReceivedAppendEntries(*_reverse, data);
+}
+
+int PipeConnection::onSendRequestVoteResponse(msg_requestvote_response_t& data)
+{
+  return _remote->onReceivedRequestVoteResponse(*_reverse, data);
+}
+
+int PipeConnection::onSendAppendEntriesResponse(msg_appendentries_response_t& data)
+{
+  return _remote->onReceivedAppendEntriesResponse(*_reverse, data);
+}
+
+int PipeConnection::onSendSnapshot(RaftSnapshot& snapshot)
+{
+  return _remote->onReceivedSnapshot(*_reverse, snapshot);
+}
+
+static void link_replicas(Replica& a, int aId, Replica& b, int bId)
+{
+  RaftNode node;
+  a.addNode(bId);
+  b.addNode(aId);
+
+  ASSERT_TRUE(a.findNode(bId, node));
+  PipeConnection* ab = new PipeConnection(&a, node);
+  a._links[bId] = RaftConsensus::Connection::Ptr(ab);
+
+  ASSERT_TRUE(b.findNode(aId, node));
+  PipeConnection* ba = new PipeConnection(&b, node);
+  b._links[aId] = RaftConsensus::Connection::Ptr(ba);
+
+  ab->_remote = &b;
+  ab->_reverse = &b._links[aId];
+  ab->_appendCount = 0;
+  ba->_remote = &a;
+  ba->_reverse = &a._links[bId];
+  ba->_appendCount = 0;
+}
+
+TEST(RAFTTest, TestRaftReplication)
+{
+  Replica replicas[4];
+  RaftConsensus::Options opt;
+  opt.max_entries_per_append = 16;
+  opt.max_inflight_appends = 4;
+
+  for (int i = 0; i < 3; i++)
+  {
+    opt.node_id = i + 1;
+    opt.is_master = (i == 0);
+    ASSERT_TRUE(replicas[i].initialize(opt));
+  }
+  link_replicas(replicas[0], 1, replicas[1], 2);
+  link_replicas(replicas[0], 1, replicas[2], 3);
+  link_replicas(replicas[1], 2, replicas[2], 3);
+
+  ASSERT_TRUE(replicas[0].isLeader());
+  ASSERT_FALSE(replicas[1].submit("not the leader"));
+
+  for (int batch = 0; batch < 4; batch++)
+  {
+    std::vector<std::string> entries;
+    for (int i = 0; i < 50; i++)
+    {
+      entries.push_back(OSS::string_from_number(batch * 50 + i));
+    }
+    ASSERT_TRUE(replicas[0].submit(entries));
+  }
+
+  ASSERT_EQ(replicas[0].getCommitIndex(), 200);
+  ASSERT_EQ(replicas[0]._applied.size(), 200);
+  ASSERT_EQ(replicas[1].getCurrentIndex(), 200);
+  ASSERT_EQ(replicas[2].getCurrentIndex(), 200);
+
+  //
+  // Followers learn the final commit index from the next heartbeat
+  //
+  replicas[0].tick();
+  ASSERT_EQ(replicas[1]._applied.size(), 200);
+  ASSERT_EQ(replicas[1]._applied[199], "199");
+
+  //
+  // Entries are shipped in capped messages rather than one per entry
+  //
+  PipeConnection* pLink = (PipeConnection*)replicas[0]._links[2].get();
+  ASSERT_LE(pLink->_appendCount, 20);
+
+  //
+  // Compact the leader log and catch up a new node from the snapshot
+  //
+  ASSERT_TRUE(replicas[0].takeSnapshot());
+  ASSERT_FALSE(replicas[0].takeSnapshot());
+  ASSERT_EQ(replicas[0].getCurrentIndex(), 200);
+
+  opt.node_id = 4;
+  opt.is_master = false;
+  ASSERT_TRUE(replicas[3].initialize(opt));
+  link_replicas(replicas[0], 1, replicas[3], 4);
+  ASSERT_TRUE(replicas[0].submit("after snapshot"));
+
+  ASSERT_EQ(replicas[3].getCurrentIndex(), 201);
+  ASSERT_EQ(replicas[3]._applied.size(), 201);
+  ASSERT_EQ(replicas[3]._applied[0], "0");
+  ASSERT_EQ(replicas[3]._applied[200], "after snapshot");
+  ASSERT_EQ(replicas[0].getCommitIndex(), 201);
+}
+
+TEST(RAFTTest, TestRaftLogStore)
+{
+  std::string path("/tmp/oss_core-raft-log-store");
+  boost::filesystem::remove_all(path);
+
+  {
+    RaftLogStore store;
+    ASSERT_TRUE(store.open(path));
+    ASSERT_TRUE(store.beginBatch());
+    for (int i = 1; i <= 10; i++)
+    {
+      std::string data = OSS::string_from_number(i);
+      raft_entry_t entry;
+      entry.term = 3;
+      entry.id = i;
+      entry.type = RAFT_LOGTYPE_NORMAL;
+      entry.data.buf = (void*)data.data();
+      entry.data.len = data.size();
+      ASSERT_TRUE(store.appendEntry(i, entry));
+    }
+    ASSERT_TRUE(store.endBatch());
+    ASSERT_TRUE(store.removeEntry(10));
+    ASSERT_TRUE(store.removeEntry(11));
+    ASSERT_TRUE(store.setTerm(3));
+    ASSERT_TRUE(store.setVote(2));
+
+    RaftSnapshot snapshot;
+    snapshot.last_idx = 5;
+    snapshot.last_term = 3;
+    snapshot.data = "state";
+    ASSERT_TRUE(store.saveSnapshot(snapshot));
+  }
+
+  RaftLogStore store;
+  ASSERT_TRUE(store.open(path));
+  int term = 0;
+  int vote = 0;
+  RaftSnapshot snapshot;
+  RaftLogStore::Entries entries;
+  ASSERT_TRUE(store.load(term, vote, snapshot, entries));
+  ASSERT_EQ(term, 3);
+  ASSERT_EQ(vote, 2);
+  ASSERT_EQ(snapshot.last_idx, 5);
+  ASSERT_EQ(snapshot.data, "state");
+  ASSERT_EQ(entries.size(), 4);
+  ASSERT_EQ(entries.front().index, 6);
+  ASSERT_EQ(entries.back().index, 9);
+  ASSERT_EQ(entries.back().data, "9");
+  store.close();
+
+  //
+  // A restarted node resumes from the snapshot and the remaining entries
+  //
+  Replica replica;
+  RaftConsensus::Options opt;
+  opt.node_id = 1;
+  opt.log_store_path = path;
+  ASSERT_TRUE(replica.initialize(opt));
+  ASSERT_EQ(replica.getCurrentIndex(), 9);
+  ASSERT_EQ(replica.getCommitIndex(), 5);
+}
@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+
+#include "OSS/build.h"
+#if ENABLE_FEATURE_B2BUA
+
+#include <boost/bind.hpp>
+#include "OSS/UTL/LatencyHistogram.h"
+#include "OSS/SIP/B2BUA/SIPB2BRequestPipeline.h"
+
+
+using OSS::SIP::B2BUA::SIPB2BRequestPipeline;
+
+static SIPB2BRequestPipeline::Result tagHandler(
+  std::string* trace,
+  const std::string& tag,
+  const SIPB2BRequestPipeline::TransactionPtr&,
+  OSS::SIP::SIPMessage::Ptr&,
+  const SIPB2BRequestPipeline::Resume&)
+{
+  *trace += tag;
+  return SIPB2BRequestPipeline::Continue;
+}
+
+static void runChain(const SIPB2BRequestPipeline::HandlersPtr& handlers)
+{
+  OSS::SIP::SIPMessage::Ptr response;
+  for (SIPB2BRequestPipeline::Handlers::const_iterator iter = handlers->begin(); iter != handlers->end(); iter++)
+    iter->handler(SIPB2BRequestPipeline::TransactionPtr(), response, SIPB2BRequestPipeline::Resume());
+}
+
+TEST(RequestPipelineTest, test_handler_priority)
+{
+  SIPB2BRequestPipeline pipeline;
+  std::string trace;
+  pipeline.addHandler(SIPB2BRequestPipeline::StageRoute, "builtin", SIPB2BRequestPipeline::BUILTIN_PRIORITY,
+    boost::bind(tagHandler, &trace, "B", _1, _2, _3));
+  pipeline.addHandler(SIPB2BRequestPipeline::StageRoute, "after", SIPB2BRequestPipeline::BUILTIN_PRIORITY + 1,
+    boost::bind(tagHandler, &trace, "C", _1, _2, _3));
+  pipeline.addHandler(SIPB2BRequestPipeline::StageRoute, "before", 10,
+    boost::bind(tagHandler, &trace, "A", _1, _2, _3));
+  pipeline.addHandler(SIPB2BRequestPipeline::StageRoute, "builtin-2", SIPB2BRequestPipeline::BUILTIN_PRIORITY,
+    boost::bind(tagHandler, &trace, "b", _1, _2, _3));
+
+  runChain(pipeline.getHandlers(SIPB2BRequestPipeline::StageRoute));
+  ASSERT_EQ(trace, "ABbC");
+
+  ASSERT_TRUE(pipeline.getHandlers(SIPB2BRequestPipeline::StageCreated)->empty());
+  ASSERT_FALSE(pipeline.getHandlers(SIPB2BRequestPipeline::StageMax));
+}
+
+TEST(RequestPipelineTest, test_handler_snapshot)
+{
+  SIPB2BRequestPipeline pipeline;
+  std::string trace;
+  pipeline.addHandler(SIPB2BRequestPipeline::StageAuthenticate, "a", 1,
+    boost::bind(tagHandler, &trace, "A", _1, _2, _3));
+
+  //
+  // A transaction holding the chain does not see later changes
+  //
+  SIPB2BRequestPipeline::HandlersPtr inFlight = pipeline.getHandlers(SIPB2BRequestPipeline::StageAuthenticate);
+  pipeline.addHandler(SIPB2BRequestPipeline::StageAuthenticate, "b", 2,
+    boost::bind(tagHandler, &trace, "B", _1, _2, _3));
+  ASSERT_EQ(inFlight->size(), 1);
+  ASSERT_EQ(pipeline.getHandlers(SIPB2BRequestPipeline::StageAuthenticate)->size(), 2);
+
+  ASSERT_TRUE(pipeline.removeHandler(SIPB2BRequestPipeline::StageAuthenticate, "a"));
+  ASSERT_FALSE(pipeline.removeHandler(SIPB2BRequestPipeline::StageAuthenticate, "a"));
+  runChain(pipeline.getHandlers(SIPB2BRequestPipeline::StageAuthenticate));
+  ASSERT_EQ(trace, "B");
+}
+
+TEST(RequestPipelineTest, test_stage_latency)
+{
+  SIPB2BRequestPipeline pipeline;
+  for (OSS::UInt64 i = 1; i <= 100; i++)
+    pipeline.recordLatency(SIPB2BRequestPipeline::StageRoute, i * 10);
+
+  OSS::LatencyHistogram::Snapshot route;
+  pipeline.getLatency(SIPB2BRequestPipeline::StageRoute, route);
+  ASSERT_EQ(route.count, 100);
+  ASSERT_EQ(route.max, 1000);
+  ASSERT_EQ(route.mean(), 505);
+
+  //
+  // Percentiles resolve to the upper bound of their sub-bucket.  Each power
+  // of two is split in eight so 510us lands in 480-512 and 60us in 56-64.
+  // The 99th percentile sits in 960-1024 and is capped at the largest sample.
+  //
+  ASSERT_EQ(route.percentile(50), 512);
+  ASSERT_EQ(route.percentile(99), 1000);
+  ASSERT_EQ(route.percentile(5), 64);
+
+  OSS::LatencyHistogram::Snapshot created;
+  pipeline.getLatency(SIPB2BRequestPipeline::StageCreated, created);
+  ASSERT_EQ(created.count, 0);
+  ASSERT_EQ(created.percentile(50), 0);
+
+  ASSERT_STREQ(SIPB2BRequestPipeline::stageName(SIPB2BRequestPipeline::StageOutbound), "outbound");
+}
+
+TEST(RequestPipelineTest, test_histogram_buckets)
+{
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(0), 0);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(1), 1);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(15), 15);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(16), 16);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(17), 16);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(18), 17);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(31), 23);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(32), 24);
+  ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(~((OSS::UInt64)0)), OSS::LatencyHistogram::BUCKET_COUNT - 1);
+
+  //
+  // Each bucket ends where the next one starts
+  //
+  for (std::size_t i = 0; i < OSS::LatencyHistogram::BUCKET_COUNT - 1; i++)
+  {
+    ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(OSS::LatencyHistogram::bucketLimit(i) - 1), i);
+    ASSERT_EQ(OSS::LatencyHistogram::bucketIndex(OSS::LatencyHistogram::bucketLimit(i)), i + 1);
+  }
+
+  OSS::LatencyHistogram histogram;
+  histogram.record(3);
+  histogram.record(3);
+  OSS::LatencyHistogram::Snapshot snapshot;
+  histogram.snapshot(snapshot);
+  ASSERT_EQ(snapshot.buckets[3], 2);
+  histogram.reset();
+  histogram.snapshot(snapshot);
+  ASSERT_EQ(snapshot.count, 0);
+}
+
+#endif // ENABLE_FEATURE_B2BUA
@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <boost/thread.hpp>
+#include "OSS/UTL/SharedMemoryRing.h"
+#include "OSS/UTL/IPCQueue.h"
+
+
+using OSS::SharedMemoryRingReader;
+using OSS::SharedMemoryRingWriter;
+
+#define RING_TEST_PATH "/tmp/oss_test_shared_memory_ring"
+#define RING_TEST_RECORDS 20000
+
+static std::string make_record(int index)
+{
+  //
+  // Sizes vary so records wrap at every possible offset
+  //
+  return std::string(1 + (index * 37) % 700, (char)('a' + index % 26));
+}
+
+static void close_reader(SharedMemoryRingReader* pReader)
+{
+  boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+  pReader->close();
+}
+
+TEST(SharedMemoryRingTest, test_variable_length_records)
+{
+  SharedMemoryRingReader reader(RING_TEST_PATH, 4096);
+  SharedMemoryRingWriter writer(RING_TEST_PATH);
+  ASSERT_TRUE(reader.isOpen());
+  ASSERT_TRUE(writer.isOpen());
+  ASSERT_EQ(reader.capacity(), (std::size_t)4096);
+  ASSERT_EQ(reader.getKey(), writer.getKey());
+
+  std::string data;
+  ASSERT_FALSE(reader.read(data, false));
+  ASSERT_FALSE(writer.write(std::string(writer.getMaxRecordSize() + 1, 'x')));
+  ASSERT_TRUE(writer.write(std::string(writer.getMaxRecordSize(), 'x')));
+  ASSERT_TRUE(reader.read(data, false));
+  ASSERT_EQ(data.size(), writer.getMaxRecordSize());
+
+  ASSERT_TRUE(writer.write(""));
+  ASSERT_TRUE(reader.read(data, false));
+  ASSERT_TRUE(data.empty());
+
+  int written = 0;
+  int read = 0;
+  while (read < 1000)
+  {
+    while (writer.write(make_record(written), false))
+      written++;
+    ASSERT_TRUE(reader.size() > 0);
+    while (reader.read(data, false))
+    {
+      ASSERT_EQ(data, make_record(read));
+      read++;
+    }
+    ASSERT_EQ(read, written);
+  }
+
+  writer.write("pending");
+  reader.clear();
+  ASSERT_FALSE(reader.read(data, false));
+}
+
+TEST(SharedMemoryRingTest, test_close_wakes_reader)
+{
+  SharedMemoryRingReader reader(RING_TEST_PATH);
+  SharedMemoryRingWriter writer(RING_TEST_PATH);
+  boost::thread closer(boost::bind(close_reader, &reader));
+  std::string data;
+  ASSERT_FALSE(reader.read(data, true));
+  closer.join();
+  ASSERT_FALSE(reader.isOpen());
+  ASSERT_FALSE(writer.write("data", false));
+}
+
+TEST(SharedMemoryRingTest, test_writer_follows_new_reader)
+{
+  SharedMemoryRingWriter writer(RING_TEST_PATH);
+  std::string data;
+  {
+    SharedMemoryRingReader reader(RING_TEST_PATH);
+    ASSERT_TRUE(writer.write("first"));
+    ASSERT_TRUE(reader.read(data, false));
+    ASSERT_EQ(data, "first");
+  }
+  ASSERT_FALSE(writer.write("lost", false));
+
+  SharedMemoryRingReader reader(RING_TEST_PATH);
+  ASSERT_TRUE(writer.write("second"));
+  ASSERT_TRUE(reader.read(data, false));
+  ASSERT_EQ(data, "second");
+}
+
+TEST(SharedMemoryRingTest, test_writer_leaves_orphaned_ring)
+{
+  SharedMemoryRingWriter writer(RING_TEST_PATH);
+  std::string data;
+
+  //
+  // A new reader unlinks the segment of a reader that died without closing.
+  // The writer moves to the new segment without waiting for the old ring
+  // to fill up.
+  //
+  SharedMemoryRingReader dead(RING_TEST_PATH);
+  ASSERT_TRUE(writer.write("first"));
+  SharedMemoryRingReader reader(RING_TEST_PATH);
+  boost::this_thread::sleep(boost::posix_time::milliseconds(1100));
+  ASSERT_TRUE(writer.write(std::string("second"), false));
+  ASSERT_TRUE(reader.read(data, false));
+  ASSERT_EQ(data, "second");
+  ASSERT_TRUE(dead.read(data, false));
+  ASSERT_EQ(data, "first");
+  ASSERT_FALSE(dead.read(data, false));
+}
+
+TEST(SharedMemoryRingTest, test_across_processes)
+{
+  SharedMemoryRingReader reader(RING_TEST_PATH, 8192);
+
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0)
+  {
+    SharedMemoryRingWriter writer(RING_TEST_PATH);
+    for (int i = 0; i < RING_TEST_RECORDS; i++)
+    {
+      if (!writer.write(make_record(i), true))
+        _exit(1);
+    }
+    _exit(0);
+  }
+
+  std::string data;
+  for (int i = 0; i < RING_TEST_RECORDS; i++)
+  {
+    ASSERT_TRUE(reader.read(data, true));
+    ASSERT_EQ(data, make_record(i));
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(SharedMemoryRingTest, test_ipc_queue)
+{
+  OSS::IPCQueue queue(RING_TEST_PATH, OSS::IPCQueue::READWRITE);
+  ASSERT_TRUE(queue.isOpen());
+
+  //
+  // Larger than the 8000 bytes a SysV message could carry
+  //
+  std::string large(20000, 'z');
+  ASSERT_TRUE(queue.write(large));
+  std::string data;
+  ASSERT_TRUE(queue.read(data, false));
+  ASSERT_EQ(data, large);
+  ASSERT_FALSE(queue.read(data, false));
+}
@@ -0,0 +1,171 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include "OSS/UTL/Metrics.h"
+#include "OSS/UTL/SlabPool.h"
+#include "OSS/UTL/SlabAllocated.h"
+#include "OSS/UTL/MemoryArena.h"
+#include "OSS/UTL/ArenaAllocator.h"
+
+
+class SlabTestObject : public OSS::SlabAllocated<SlabTestObject>
+{
+public:
+  SlabTestObject() : value(0) {}
+  virtual ~SlabTestObject() {}
+  int value;
+};
+
+class SlabTestDerived : public SlabTestObject
+{
+public:
+  char extra[100];
+};
+
+OSS_SLAB_POOL_DECLARE(SlabTestObject)
+OSS_SLAB_POOL(SlabTestObject, "test_slab_object")
+
+static int gDestroyed = 0;
+
+struct ArenaTestObject
+{
+  explicit ArenaTestObject(int v) : value(v) {}
+  ~ArenaTestObject() { gDestroyed++; }
+  int value;
+};
+
+TEST(SlabPoolTest, test_reuse)
+{
+  OSS::SlabPool pool("test_slab_reuse", 40, 4);
+  ASSERT_EQ(pool.getBlockSize(), 48);
+  ASSERT_EQ(pool.getLiveBytes(), 0);
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 4; i++)
+    blocks.push_back(pool.allocate());
+  ASSERT_EQ(pool.getLiveBytes(), 4 * 48);
+  ASSERT_EQ(OSS::Metrics::instance().gauge("memory_test_slab_reuse_live_objects").value(), 4);
+  OSS::UInt64 reserved = pool.getReservedBytes();
+  ASSERT_GE(reserved, 4 * 48);
+
+  void* last = blocks.back();
+  blocks.pop_back();
+  pool.deallocate(last);
+  ASSERT_EQ(pool.getLiveBytes(), 3 * 48);
+  ASSERT_EQ(pool.allocate(), last);
+  ASSERT_EQ(pool.getReservedBytes(), reserved);
+
+  blocks.push_back(last);
+  blocks.push_back(pool.allocate());
+  ASSERT_GT(pool.getReservedBytes(), reserved);
+
+  for (std::size_t i = 0; i < blocks.size(); i++)
+    pool.deallocate(blocks[i]);
+  ASSERT_EQ(pool.getLiveBytes(), 0);
+
+  void* big = pool.allocateOversized(1000);
+  ASSERT_EQ(pool.getLiveBytes(), 1000);
+  pool.deallocateOversized(big, 1000);
+  ASSERT_EQ(pool.getLiveBytes(), 0);
+}
+
+static void allocateAndFree(OSS::SlabPool* pool, std::size_t count, std::vector<void*>* foreign)
+{
+  std::vector<void*> blocks;
+  for (int round = 0; round < 100; round++)
+  {
+    for (std::size_t i = 0; i < count; i++)
+      blocks.push_back(pool->allocate());
+    for (std::size_t i = 0; i < blocks.size(); i++)
+      pool->deallocate(blocks[i]);
+    blocks.clear();
+  }
+
+  //
+  // Blocks allocated by another thread go back through this thread's cache
+  //
+  if (foreign)
+  {
+    for (std::size_t i = 0; i < foreign->size(); i++)
+      pool->deallocate((*foreign)[i]);
+  }
+}
+
+TEST(SlabPoolTest, test_thread_cache)
+{
+  OSS::SlabPool pool("test_slab_thread_cache", 40, 4);
+
+  //
+  // A thread that exits gives its cached blocks back to the pool
+  //
+  boost::thread worker(boost::bind(allocateAndFree, &pool, 4, (std::vector<void*>*)0));
+  worker.join();
+  OSS::UInt64 reserved = pool.getReservedBytes();
+  std::vector<void*> blocks;
+  for (int i = 0; i < 4; i++)
+    blocks.push_back(pool.allocate());
+  ASSERT_EQ(pool.getReservedBytes(), reserved);
+
+  boost::thread_group threads;
+  for (int i = 0; i < 4; i++)
+    threads.create_thread(boost::bind(allocateAndFree, &pool, 50, i ? (std::vector<void*>*)0 : &blocks));
+  threads.join_all();
+  ASSERT_EQ(pool.getLiveBytes(), 0);
+  ASSERT_EQ(OSS::Metrics::instance().gauge("memory_test_slab_thread_cache_live_objects").value(), 0);
+}
+
+TEST(SlabPoolTest, test_arena)
+{
+  OSS::SlabPool chunks("test_slab_arena", 256);
+  {
+    OSS::MemoryArena arena(chunks);
+    char* a = static_cast<char*>(arena.allocate(10));
+    char* b = static_cast<char*>(arena.allocate(10));
+    ASSERT_EQ(reinterpret_cast<std::size_t>(a) % OSS::SlabPool::ALIGNMENT, 0);
+    ASSERT_EQ(b - a, 16);
+    ASSERT_EQ(arena.getUsedBytes(), 32);
+    ASSERT_EQ(chunks.getLiveBytes(), 256);
+
+    arena.allocate(1000);
+    ASSERT_GT(chunks.getLiveBytes(), 256 + 1000);
+    arena.allocate(300);
+    arena.allocate(16);
+  }
+  ASSERT_EQ(chunks.getLiveBytes(), 0);
+}
+
+TEST(SlabPoolTest, test_arena_allocator)
+{
+  OSS::SlabPool chunks("test_slab_arena_allocator", 256);
+  gDestroyed = 0;
+  OSS::MemoryArena::Ptr arena = boost::make_shared<OSS::MemoryArena>(boost::ref(chunks));
+  boost::shared_ptr<ArenaTestObject> object =
+    boost::allocate_shared<ArenaTestObject>(OSS::ArenaAllocator<ArenaTestObject>(arena), 7);
+  ASSERT_GT(arena->getUsedBytes(), 0);
+
+  arena.reset();
+  ASSERT_EQ(object->value, 7);
+  ASSERT_EQ(chunks.getLiveBytes(), 256);
+
+  object.reset();
+  ASSERT_EQ(gDestroyed, 1);
+  ASSERT_EQ(chunks.getLiveBytes(), 0);
+}
+
+TEST(SlabPoolTest, test_slab_allocated)
+{
+  OSS::SlabPool& pool = OSS::SlabAllocated<SlabTestObject>::pool();
+  OSS::UInt64 live = pool.getLiveBytes();
+
+  SlabTestObject* object = new SlabTestObject();
+  ASSERT_EQ(pool.getLiveBytes(), live + pool.getBlockSize());
+  SlabTestObject* derived = new SlabTestDerived();
+  ASSERT_EQ(pool.getLiveBytes(), live + pool.getBlockSize() + sizeof(SlabTestDerived));
+
+  delete object;
+  delete derived;
+  ASSERT_EQ(pool.getLiveBytes(), live);
+}
@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "OSS/UTL/CoreUtils.h"
 #include "OSS/SIP/SIPTransportService.h" 
+#include "OSS/SIP/SIPConnectionIndex.h"
+#include "OSS/SIP/SIPUDPConnection.h"
 #include "OSS/Net/Net.h"
 
 using namespace OSS::SIP;
@@ -111,3 +113,92 @@ TEST(TransportTest, test_get_default_address)
   ASSERT_FALSE(address.empty());
   std::cout << "TransportTest::test_get_default_address result: address=" << address << std::endl;
 }
+
+struct TestIndexedConnection
+{
+  typedef boost::shared_ptr<TestIndexedConnection> Ptr;
+  TestIndexedConnection(OSS::UInt64 id, std::time_t activity) : identifier(id), lastActivity(activity) {}
+  OSS::UInt64 getIdentifier() const { return identifier; }
+  std::time_t getLastActivity() const { return lastActivity; }
+  OSS::UInt64 identifier;
+  std::time_t lastActivity;
+};
+
+TEST(TransportTest, test_connection_index)
+{
+  typedef SIPConnectionIndex<TestIndexedConnection> Index;
+  Index index;
+
+  std::time_t now = std::time(0);
+  TestIndexedConnection::Ptr conn1(new TestIndexedConnection(1, now));
+  TestIndexedConnection::Ptr conn2(new TestIndexedConnection(2, now));
+  TestIndexedConnection::Ptr conn3(new TestIndexedConnection(3, now));
+
+  index.insert(conn1, OSS::Net::IPAddress("192.168.0.1", 5060));
+  index.insert(conn2, OSS::Net::IPAddress("192.168.0.1", 5061));
+  index.insert(conn3, OSS::Net::IPAddress());
+  ASSERT_EQ(index.size(), 3);
+
+  ASSERT_TRUE(index.findById(2) == conn2);
+  ASSERT_TRUE(index.findByEndpoint(OSS::Net::IPAddress("192.168.0.1", 5060)) == conn1);
+  ASSERT_TRUE(index.findByEndpoint(OSS::Net::IPAddress("192.168.0.1", 5061)) == conn2);
+  ASSERT_FALSE(index.findByEndpoint(OSS::Net::IPAddress("192.168.0.2", 5060)));
+
+  //
+  // The remote address of conn3 becomes known later
+  //
+  index.insert(conn3, OSS::Net::IPAddress("::1", 5060));
+  ASSERT_TRUE(index.findByEndpoint(OSS::Net::IPAddress("::1", 5060)) == conn3);
+
+  ASSERT_TRUE(index.remove(1) == conn1);
+  ASSERT_FALSE(index.findById(1));
+  ASSERT_FALSE(index.findByEndpoint(OSS::Net::IPAddress("192.168.0.1", 5060)));
+  ASSERT_FALSE(index.remove(1));
+
+  //
+  // Idle sweeping expires only connections without recent activity
+  //
+  index.setIdleTimeout(30);
+  Index::ConnectionList expired;
+  index.collectIdle(now + 10, expired);
+  ASSERT_TRUE(expired.empty());
+
+  conn2->lastActivity = now + 20;
+  index.collectIdle(now + 31, expired);
+  ASSERT_EQ(expired.size(), 1);
+  ASSERT_TRUE(expired[0] == conn3);
+  ASSERT_FALSE(index.findById(3));
+  ASSERT_TRUE(index.findById(2) == conn2);
+
+  expired.clear();
+  index.collectIdle(now + 51, expired);
+  ASSERT_EQ(expired.size(), 1);
+  ASSERT_TRUE(expired[0] == conn2);
+  ASSERT_EQ(index.size(), 0);
+}
+
+TEST(TransportTest, test_udp_keep_alive_batch)
+{
+  boost::asio::io_service ioService;
+  boost::asio::ip::udp::endpoint local(boost::asio::ip::address::from_string("127.0.0.1"), 0);
+  boost::asio::ip::udp::socket sender(ioService, local);
+  boost::asio::ip::udp::socket receiver(ioService, local);
+  unsigned short port = receiver.local_endpoint().port();
+
+  //
+  // An IPv6 target cannot be reached from an IPv4 socket.  The targets
+  // after it still get their keep-alive.
+  //
+  std::vector<OSS::Net::IPAddress> targets;
+  targets.push_back(OSS::Net::IPAddress("127.0.0.1", port));
+  targets.push_back(OSS::Net::IPAddress("::1", port));
+  targets.push_back(OSS::Net::IPAddress("127.0.0.1", port));
+
+  boost::shared_ptr<SIPUDPConnection> pConnection(new SIPUDPConnection(ioService, sender, 0));
+  ASSERT_EQ(pConnection->writeKeepAlive(targets), 2);
+
+  char buffer[8];
+  boost::asio::ip::udp::endpoint from;
+  ASSERT_EQ(receiver.receive_from(boost::asio::buffer(buffer), from), 4);
+  ASSERT_EQ(receiver.receive_from(boost::asio::buffer(buffer), from), 4);
+}
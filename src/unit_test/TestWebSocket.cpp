@@ -20,6 +20,8 @@
 
 #include "gtest/gtest.h"
 #include "OSS/SIP/SIPWebSocketListener.h"
+#include "OSS/websocketpp/processors/hybi_util.hpp"
+#include "OSS/websocketpp/utf8_validator/utf8_validator.hpp"
 
 using namespace OSS;
 using namespace OSS::SIP;
@@ -32,4 +34,52 @@ TEST(SipTransportTest, test_websocket_listen)
   listener.run();
   OSS::thread_sleep(1000);
 #endif
-}
\ No newline at end of file
+}
+
+TEST(SipTransportTest, test_websocket_unmask)
+{
+  using namespace websocketpp::processor::hybi_util;
+  masking_key_type key;
+  key.c[0] = 0x12; key.c[1] = 0x34; key.c[2] = 0x56; key.c[3] = 0x78;
+
+  std::string payload;
+  for (int i = 0; i < 301; i++)
+    payload.push_back((char)(i * 7));
+
+  //
+  // Unmask in uneven pieces the way the processor sees them off the wire
+  //
+  std::string expected = payload;
+  byte_mask(expected.begin(), expected.end(), key);
+
+  std::string masked = payload;
+  size_t prepared = prepare_masking_key(key);
+  size_t pieces[] = { 3, 17, 1, 64, 33, 183 };
+  char* data = &masked[0];
+  for (int i = 0; i < 6; i++)
+  {
+    prepared = word_mask_circ(data, pieces[i], prepared);
+    data += pieces[i];
+  }
+  ASSERT_EQ(masked, expected);
+}
+
+TEST(SipTransportTest, test_websocket_utf8_validate)
+{
+  std::string ascii = "INVITE sip:bob@example.com SIP/2.0\r\nVia: SIP/2.0/WS df7jal23ls0d.invalid\r\n\r\n";
+  ASSERT_TRUE(utf8_validator::validate(ascii));
+  ASSERT_TRUE(utf8_validator::validate(ascii + "Caf\xc3\xa9 \xe2\x82\xac" + ascii));
+  ASSERT_FALSE(utf8_validator::validate(ascii + "\xc3" + ascii));
+  ASSERT_FALSE(utf8_validator::validate(ascii + "\xff" + ascii));
+
+  //
+  // A sequence split across frames resumes where the previous frame stopped
+  //
+  utf8_validator::validator validator;
+  std::string first = ascii + "\xe2\x82";
+  std::string second = "\xac" + ascii;
+  ASSERT_TRUE(validator.decode(first.data(), first.data() + first.size()));
+  ASSERT_FALSE(validator.complete());
+  ASSERT_TRUE(validator.decode(second.data(), second.data() + second.size()));
+  ASSERT_TRUE(validator.complete());
+}
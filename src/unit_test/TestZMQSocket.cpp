@@ -4,6 +4,9 @@
 #if ENABLE_FEATURE_ZMQ
 
 #include "OSS/ZMQ/ZMQSocket.h"
+#include "OSS/ZMQ/ZMQReactor.h"
+#include "OSS/ZMQ/ZMQRpcClient.h"
+#include "OSS/ZMQ/ZMQRpcServer.h"
 #include "OSS/SIP/SIPTransportService.h" 
 
 using namespace OSS::ZMQ;
@@ -126,6 +129,163 @@ TEST(ZMQ, test_zmq_send_and_receive_inproc)
   }
 }
 
+
+static void rpc_echo_in_reverse(ZMQRpcServer* pServer, std::vector<ZMQRpcServer::Request>* pHeld, const ZMQRpcServer::Request& request)
+{
+  //
+  // Hold every request until "flush" arrives and answer them newest first
+  //
+  if (request.cmd == "flush")
+  {
+    while (!pHeld->empty())
+    {
+      pServer->sendReply(pHeld->back(), pHeld->back().cmd + ":" + pHeld->back().data);
+      pHeld->pop_back();
+    }
+    pServer->sendReply(request, "flushed");
+  }
+  else if (request.cmd != "drop")
+  {
+    pHeld->push_back(request);
+  }
+}
+
+static void rpc_collect_reply(OSS::mutex_critic_sec* pMutex, std::map<std::string, std::string>* pReplies, const std::string& key, bool ok, const std::string& reply)
+{
+  OSS::mutex_critic_sec_lock lock(*pMutex);
+  (*pReplies)[key] = ok ? reply : "failed";
+}
+
+TEST(ZMQ, test_zmq_multipart)
+{
+  ZMQSocket push(ZMQSocket::PUSH);
+  ZMQSocket pull(ZMQSocket::PULL);
+  ASSERT_TRUE(push.bind("inproc://multipart"));
+  ASSERT_TRUE(pull.connect("inproc://multipart"));
+  
+  ZMQSocket::Buffer shared(new std::string(4096, 'x'));
+  ZMQSocket::Buffers frames;
+  frames.push_back(ZMQSocket::Buffer(new std::string("header")));
+  frames.push_back(ZMQSocket::Buffer(new std::string()));
+  frames.push_back(shared);
+  ASSERT_TRUE(push.sendMultipart(frames));
+  ASSERT_TRUE(push.sendMultipart(frames));
+  
+  ZMQSocket::Frames received;
+  for (int i = 0; i < 2; i++)
+  {
+    ASSERT_TRUE(pull.receiveMultipart(received, 1000));
+    ASSERT_EQ(received.size(), (std::size_t)3);
+    ASSERT_STREQ(received[0].c_str(), "header");
+    ASSERT_TRUE(received[1].empty());
+    ASSERT_TRUE(received[2] == *shared);
+  }
+  ASSERT_FALSE(pull.tryReceiveMultipart(received));
+  
+  //
+  // ZeroMQ dropped its references once the frames were delivered
+  //
+  frames.clear();
+  ASSERT_TRUE(shared.unique());
+}
+
+TEST(ZMQ, test_zmq_rpc_pipelining)
+{
+  ZMQReactor reactor;
+  std::vector<ZMQRpcServer::Request> held;
+  ZMQRpcServer* pServer = 0;
+  ZMQRpcServer server(reactor, boost::bind(rpc_echo_in_reverse, boost::ref(pServer), &held, _1));
+  pServer = &server;
+  ZMQRpcClient client(reactor);
+  ASSERT_TRUE(server.bind("inproc://rpc"));
+  ASSERT_TRUE(client.connect("inproc://rpc"));
+  ASSERT_TRUE(reactor.run());
+  
+  OSS::mutex_critic_sec mutex;
+  std::map<std::string, std::string> replies;
+  for (int i = 0; i < 100; i++)
+  {
+    std::string key = OSS::string_from_number(i);
+    ASSERT_TRUE(client.sendRequest("echo", key, boost::bind(rpc_collect_reply, &mutex, &replies, key, _1, _2), 5000) > 0);
+  }
+  client.sendRequest("drop", "", boost::bind(rpc_collect_reply, &mutex, &replies, "dropped", _1, _2), 50);
+  
+  //
+  // Every request above is in flight until the flush is answered
+  //
+  std::string response;
+  ASSERT_TRUE(client.sendAndReceive("flush", "", response, 5000));
+  ASSERT_STREQ(response.c_str(), "flushed");
+  
+  for (int i = 0; i < 100 && client.getPendingCount(); i++)
+    OSS::thread_sleep(10);
+  ASSERT_EQ(client.getPendingCount(), (std::size_t)0);
+  
+  OSS::mutex_critic_sec_lock lock(mutex);
+  ASSERT_EQ(replies.size(), (std::size_t)101);
+  for (int i = 0; i < 100; i++)
+  {
+    std::string key = OSS::string_from_number(i);
+    ASSERT_EQ(replies[key], "echo:" + key);
+  }
+  ASSERT_EQ(replies["dropped"], "failed");
+}
+
+TEST(ZMQ, test_zmq_rpc_close)
+{
+  ZMQReactor reactor;
+  std::vector<ZMQRpcServer::Request> held;
+  ZMQRpcServer* pServer = 0;
+  ZMQRpcServer server(reactor, boost::bind(rpc_echo_in_reverse, boost::ref(pServer), &held, _1));
+  pServer = &server;
+  ZMQRpcClient client(reactor);
+  ASSERT_TRUE(server.bind("inproc://rpc-close"));
+  ASSERT_TRUE(client.connect("inproc://rpc-close"));
+  ASSERT_TRUE(reactor.run());
+  
+  //
+  // The server holds these so they wait for as long as the client is open.
+  // Closing sends them first, then fails them on this thread.
+  //
+  OSS::mutex_critic_sec mutex;
+  std::map<std::string, std::string> replies;
+  for (int i = 0; i < 10; i++)
+  {
+    std::string key = OSS::string_from_number(i);
+    client.sendRequest("echo", key, boost::bind(rpc_collect_reply, &mutex, &replies, key, _1, _2), 0);
+  }
+  client.close();
+  ASSERT_EQ(client.getPendingCount(), (std::size_t)0);
+  
+  OSS::mutex_critic_sec_lock lock(mutex);
+  ASSERT_EQ(replies.size(), (std::size_t)10);
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_EQ(replies[OSS::string_from_number(i)], "failed");
+  }
+}
+
+TEST(ZMQ, test_zmq_rpc_req_compatibility)
+{
+  ZMQReactor reactor;
+  std::vector<ZMQRpcServer::Request> held;
+  ZMQRpcServer* pServer = 0;
+  ZMQRpcServer server(reactor, boost::bind(rpc_echo_in_reverse, boost::ref(pServer), &held, _1));
+  pServer = &server;
+  ASSERT_TRUE(server.bind("tcp://127.0.0.1:50002"));
+  ASSERT_TRUE(reactor.run());
+  
+  ZMQSocket req(ZMQSocket::REQ);
+  ASSERT_TRUE(req.connect("tcp://127.0.0.1:50002"));
+  std::string response;
+  ASSERT_TRUE(req.sendAndReceive("flush", "", response, 1000));
+  ASSERT_STREQ(response.c_str(), "flushed");
+  
+  server.close();
+  reactor.stop();
+  ASSERT_FALSE(reactor.isRunning());
+}
+
 #else
 
 TEST(NullTest, null_test_zmq_pub_sub){}
@@ -19,14 +19,13 @@
 
 
 #include "OSS/UTL/Cache.h"
-#include "Poco/ExpireCache.h"
+#include "OSS/UTL/ExpireCache.h"
 
 
 
 namespace OSS {
 
-typedef Poco::ExpireCache<std::string, OSS::Cacheable::Ptr> ExpireCache;
-typedef Poco::SharedPtr<Cacheable::Ptr> ExpireCacheable;
+typedef ExpireCache<std::string, OSS::Cacheable::Ptr> CacheableExpireCache;
 
 Cacheable::Cacheable(const std::string& id,  const boost::any& data) :
   _data(data),
@@ -36,12 +35,12 @@ Cacheable::Cacheable(const std::string& id,  const boost::any& data) :
 
 CacheManager::CacheManager(int expireInSeconds)
 {
-  _manager = new ExpireCache(expireInSeconds * 1000);
+  _manager = new CacheableExpireCache(expireInSeconds * 1000);
 }
 
 CacheManager::~CacheManager()
 {
-  delete static_cast<ExpireCache*>(_manager);
+  delete static_cast<CacheableExpireCache*>(_manager);
 }
 
 void CacheManager::add(const std::string& id, const boost::any& obj)
@@ -51,50 +50,42 @@ void CacheManager::add(const std::string& id, const boost::any& obj)
 
 void CacheManager::add(Cacheable::Ptr pCacheable)
 {
-  static_cast<ExpireCache*>(_manager)->add(pCacheable->getIdentifier(), pCacheable);
+  static_cast<CacheableExpireCache*>(_manager)->add(pCacheable->getIdentifier(), pCacheable);
 }
 
 Cacheable::Ptr CacheManager::get(const std::string& id) const
 {
-  ExpireCacheable pCacheObj = static_cast<ExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-    return *pCacheObj;
-  
-  return Cacheable::Ptr();
+  Cacheable::Ptr pCacheObj;
+  static_cast<CacheableExpireCache*>(_manager)->get(id, pCacheObj);
+  return pCacheObj;
 }
 
 Cacheable::Ptr CacheManager::pop(const std::string& id)
 {
-  ExpireCacheable pCacheObj = static_cast<ExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-  {
-    static_cast<ExpireCache*>(_manager)->remove(id);
-    return *pCacheObj;
-  }
-
-  return Cacheable::Ptr();
+  Cacheable::Ptr pCacheObj;
+  static_cast<CacheableExpireCache*>(_manager)->pop(id, pCacheObj);
+  return pCacheObj;
 }
 
 void CacheManager::remove(const std::string& id)
 {
-  static_cast<ExpireCache*>(_manager)->remove(id);
+  static_cast<CacheableExpireCache*>(_manager)->remove(id);
 }
 
 bool CacheManager::has(const std::string& id) const
 {
-  return static_cast<ExpireCache*>(_manager)->has(id);
+  return static_cast<CacheableExpireCache*>(_manager)->has(id);
 }
 
 void CacheManager::clear()
 {
-  return static_cast<ExpireCache*>(_manager)->clear();
+  return static_cast<CacheableExpireCache*>(_manager)->clear();
 }
 
 
 /////////////////////////////////
 
-typedef Poco::ExpireCache<std::string, std::string> StringPairExpireCache;
-typedef Poco::SharedPtr<std::string> StringPairExpireCacheable;
+typedef ExpireCache<std::string, std::string> StringPairExpireCache;
 
 
 StringPairCache::StringPairCache(int expireInSeconds)
@@ -114,23 +105,16 @@ void StringPairCache::add(const std::string& id, const std::string& value)
 
 std::string StringPairCache::get(const std::string& id) const
 {
-  StringPairExpireCacheable pCacheObj = static_cast<StringPairExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-    return *pCacheObj;
-
-  return std::string();
+  std::string value;
+  static_cast<StringPairExpireCache*>(_manager)->get(id, value);
+  return value;
 }
 
 std::string StringPairCache::pop(const std::string& id)
 {
-  StringPairExpireCacheable pCacheObj = static_cast<StringPairExpireCache*>(_manager)->get(id);
-  if (pCacheObj)
-  {
-    static_cast<StringPairExpireCache*>(_manager)->remove(id);
-    return *pCacheObj;
-  }
-
-  return std::string();
+  std::string value;
+  static_cast<StringPairExpireCache*>(_manager)->pop(id, value);
+  return value;
 }
 
 void StringPairCache::remove(const std::string& id)
@@ -0,0 +1,102 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/UTL/MemoryArena.h"
+
+
+namespace OSS {
+
+
+static std::size_t chunk_header_size()
+{
+  return (sizeof(void*) + sizeof(std::size_t) + SlabPool::ALIGNMENT - 1) & ~((std::size_t)SlabPool::ALIGNMENT - 1);
+}
+
+MemoryArena::MemoryArena(SlabPool& chunks) :
+  _chunks(chunks),
+  _pChunks(0),
+  _pNext(0),
+  _pEnd(0),
+  _usedBytes(0)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+  while (_pChunks)
+  {
+    Chunk* pNext = _pChunks->next;
+    if (_pChunks->size == _chunks.getBlockSize())
+      _chunks.deallocate(_pChunks);
+    else
+      _chunks.deallocateOversized(_pChunks, _pChunks->size);
+    _pChunks = pNext;
+  }
+}
+
+void* MemoryArena::allocate(std::size_t size)
+{
+  size = (size + SlabPool::ALIGNMENT - 1) & ~((std::size_t)SlabPool::ALIGNMENT - 1);
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  _usedBytes += size;
+  if (_pNext && size <= (std::size_t)(_pEnd - _pNext))
+  {
+    void* ptr = _pNext;
+    _pNext += size;
+    return ptr;
+  }
+
+  std::size_t headerSize = chunk_header_size();
+  Chunk* pChunk = 0;
+  if (headerSize + size <= _chunks.getBlockSize())
+  {
+    pChunk = static_cast<Chunk*>(_chunks.allocate());
+    pChunk->size = _chunks.getBlockSize();
+  }
+  else
+  {
+    //
+    // Too large for a block.  The chunk holds just this request and the
+    // current chunk stays in use for the next ones.
+    //
+    pChunk = static_cast<Chunk*>(_chunks.allocateOversized(headerSize + size));
+    pChunk->size = headerSize + size;
+    pChunk->next = _pChunks;
+    _pChunks = pChunk;
+    return reinterpret_cast<char*>(pChunk) + headerSize;
+  }
+
+  pChunk->next = _pChunks;
+  _pChunks = pChunk;
+  char* ptr = reinterpret_cast<char*>(pChunk) + headerSize;
+  _pNext = ptr + size;
+  _pEnd = reinterpret_cast<char*>(pChunk) + pChunk->size;
+  return ptr;
+}
+
+std::size_t MemoryArena::getUsedBytes() const
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return _usedBytes;
+}
+
+
+} // OSS
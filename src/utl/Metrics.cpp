@@ -0,0 +1,208 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+
+#include <time.h>
+#include <sstream>
+#include "OSS/UTL/Metrics.h"
+
+
+namespace OSS {
+
+
+static void render_help(std::ostringstream& strm, const std::string& name, const std::string& help, const char* type)
+{
+  if (!help.empty())
+  {
+    strm << "# HELP " << name << " ";
+    for (std::string::const_iterator iter = help.begin(); iter != help.end(); iter++)
+    {
+      if (*iter == '\\')
+        strm << "\\\\";
+      else if (*iter == '\n')
+        strm << "\\n";
+      else
+        strm << *iter;
+    }
+    strm << "\n";
+  }
+  strm << "# TYPE " << name << " " << type << "\n";
+}
+
+Metrics::Metrics()
+{
+}
+
+Metrics::~Metrics()
+{
+}
+
+Metrics& Metrics::instance()
+{
+  static Metrics* pMetrics = new Metrics();
+  return *pMetrics;
+}
+
+MetricCounter& Metrics::counter(const std::string& name, const std::string& help)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entry<MetricCounter>& entry = _counters[name];
+  if (!entry.metric)
+  {
+    entry.help = help;
+    entry.metric = boost::shared_ptr<MetricCounter>(new MetricCounter());
+  }
+  return *entry.metric;
+}
+
+MetricCounter& Metrics::gauge(const std::string& name, const std::string& help)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entry<MetricCounter>& entry = _gauges[name];
+  if (!entry.metric)
+  {
+    entry.help = help;
+    entry.metric = boost::shared_ptr<MetricCounter>(new MetricCounter());
+  }
+  return *entry.metric;
+}
+
+LatencyHistogram& Metrics::histogram(const std::string& name, const std::string& help)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  Entry<LatencyHistogram>& entry = _histograms[name];
+  if (!entry.metric)
+  {
+    entry.help = help;
+    entry.metric = boost::shared_ptr<LatencyHistogram>(new LatencyHistogram());
+  }
+  return *entry.metric;
+}
+
+void Metrics::toJson(std::string& json) const
+{
+  std::ostringstream strm;
+  OSS::mutex_critic_sec_lock lock(_mutex);
+
+  strm << "{\"counters\":{";
+  for (Counters::const_iterator iter = _counters.begin(); iter != _counters.end(); iter++)
+  {
+    if (iter != _counters.begin())
+      strm << ",";
+    strm << "\"" << iter->first << "\":" << iter->second.metric->value();
+  }
+
+  strm << "},\"gauges\":{";
+  for (Counters::const_iterator iter = _gauges.begin(); iter != _gauges.end(); iter++)
+  {
+    if (iter != _gauges.begin())
+      strm << ",";
+    strm << "\"" << iter->first << "\":" << iter->second.metric->value();
+  }
+
+  strm << "},\"histograms\":{";
+  for (Histograms::const_iterator iter = _histograms.begin(); iter != _histograms.end(); iter++)
+  {
+    LatencyHistogram::Snapshot snapshot;
+    iter->second.metric->snapshot(snapshot);
+    if (iter != _histograms.begin())
+      strm << ",";
+    strm << "\"" << iter->first << "\":{"
+      << "\"count\":" << snapshot.count
+      << ",\"sum\":" << snapshot.sum
+      << ",\"max\":" << snapshot.max
+      << ",\"mean\":" << snapshot.mean()
+      << ",\"p50\":" << snapshot.percentile(50)
+      << ",\"p90\":" << snapshot.percentile(90)
+      << ",\"p99\":" << snapshot.percentile(99)
+      << ",\"p999\":" << snapshot.percentile(99.9)
+      << "}";
+  }
+  strm << "}}";
+
+  json = strm.str();
+}
+
+void Metrics::toPrometheus(std::string& text) const
+{
+  std::ostringstream strm;
+  OSS::mutex_critic_sec_lock lock(_mutex);
+
+  for (Counters::const_iterator iter = _counters.begin(); iter != _counters.end(); iter++)
+  {
+    render_help(strm, iter->first, iter->second.help, "counter");
+    strm << iter->first << " " << iter->second.metric->value() << "\n";
+  }
+
+  for (Counters::const_iterator iter = _gauges.begin(); iter != _gauges.end(); iter++)
+  {
+    render_help(strm, iter->first, iter->second.help, "gauge");
+    strm << iter->first << " " << iter->second.metric->value() << "\n";
+  }
+
+  for (Histograms::const_iterator iter = _histograms.begin(); iter != _histograms.end(); iter++)
+  {
+    LatencyHistogram::Snapshot snapshot;
+    iter->second.metric->snapshot(snapshot);
+    render_help(strm, iter->first, iter->second.help, "histogram");
+
+    //
+    // Only the buckets that end on a power of two are exported so a scrape
+    // stays small.  Samples are whole microseconds so those bounds are
+    // 2^n - 1.  The last bucket is open ended and becomes +Inf.  The count
+    // is taken from the buckets so it agrees with them even if samples were
+    // recorded while the snapshot was taken.
+    //
+    OSS::UInt64 cumulative = 0;
+    for (std::size_t i = 0; i < LatencyHistogram::BUCKET_COUNT - 1; i++)
+    {
+      cumulative += snapshot.buckets[i];
+      OSS::UInt64 limit = LatencyHistogram::bucketLimit(i);
+      if (limit & (limit - 1))
+        continue;
+      strm << iter->first << "_bucket{le=\"" << limit - 1 << "\"} " << cumulative << "\n";
+    }
+    cumulative += snapshot.buckets[LatencyHistogram::BUCKET_COUNT - 1];
+    strm << iter->first << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+    strm << iter->first << "_sum " << snapshot.sum << "\n";
+    strm << iter->first << "_count " << cumulative << "\n";
+  }
+
+  text = strm.str();
+}
+
+void Metrics::reset()
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  for (Counters::iterator iter = _counters.begin(); iter != _counters.end(); iter++)
+    iter->second.metric->reset();
+  for (Histograms::iterator iter = _histograms.begin(); iter != _histograms.end(); iter++)
+    iter->second.metric->reset();
+}
+
+OSS::UInt64 Metrics::now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (OSS::UInt64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+} // OSS
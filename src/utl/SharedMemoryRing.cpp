@@ -0,0 +1,542 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ipc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "OSS/UTL/SharedMemoryRing.h"
+#include "OSS/UTL/CoreUtils.h"
+
+
+namespace OSS {
+
+
+#define SHM_RING_MAGIC 0x4f53524eU
+#define SHM_RING_PAD 0xffffffffU
+#define SHM_RING_ALIGN 8
+#define SHM_RING_CACHE_LINE 64
+#define SHM_RING_MIN_CAPACITY 4096
+#define SHM_RING_WRITER_WAIT_MS 100
+#define SHM_RING_ORPHAN_CHECK_MS 1000
+
+
+struct SharedMemoryRingHeader
+{
+  //
+  // The header is plain old data so every process sees the same layout.
+  // Shared fields are only accessed through the __atomic builtins.
+  //
+  OSS::UInt32 magic;
+  OSS::UInt32 closed;
+  OSS::UInt64 capacity;
+  char pad0[SHM_RING_CACHE_LINE - 16];
+  OSS::UInt64 head;
+  OSS::UInt32 dataSeq;
+  OSS::UInt32 readerWaiting;
+  char pad1[SHM_RING_CACHE_LINE - 16];
+  OSS::UInt64 tail;
+  OSS::UInt32 spaceSeq;
+  OSS::UInt32 writersWaiting;
+  char pad2[SHM_RING_CACHE_LINE - 16];
+  pthread_mutex_t writeMutex;
+};
+
+static const std::size_t SHM_RING_DATA_OFFSET =
+  (sizeof(SharedMemoryRingHeader) + SHM_RING_CACHE_LINE - 1) & ~(std::size_t)(SHM_RING_CACHE_LINE - 1);
+
+
+static std::size_t shm_ring_record_size(std::size_t len)
+{
+  return (sizeof(OSS::UInt32) + len + SHM_RING_ALIGN - 1) & ~(std::size_t)(SHM_RING_ALIGN - 1);
+}
+
+static void shm_ring_wait(OSS::UInt32* word, OSS::UInt32 expected, long milliseconds)
+  /// Sleep while *word still holds expected.  A negative value waits
+  /// without a time limit.
+{
+#if defined(__linux__)
+  struct timespec timeout;
+  struct timespec* pTimeout = 0;
+  if (milliseconds >= 0)
+  {
+    timeout.tv_sec = milliseconds / 1000;
+    timeout.tv_nsec = (milliseconds % 1000) * 1000000;
+    pTimeout = &timeout;
+  }
+  syscall(SYS_futex, word, FUTEX_WAIT, expected, pTimeout, 0, 0);
+#else
+  if (__atomic_load_n(word, __ATOMIC_ACQUIRE) == expected)
+    usleep(1000);
+#endif
+}
+
+static void shm_ring_wake(OSS::UInt32* word, int count)
+{
+  __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+#if defined(__linux__)
+  syscall(SYS_futex, word, FUTEX_WAKE, count, 0, 0, 0);
+#endif
+}
+
+static bool shm_ring_lock(pthread_mutex_t* mutex)
+{
+  int result = pthread_mutex_lock(mutex);
+  if (result == EOWNERDEAD)
+  {
+    //
+    // The writer died before publishing the tail so its partial record is
+    // simply overwritten by the next one
+    //
+    pthread_mutex_consistent(mutex);
+    return true;
+  }
+  return result == 0;
+}
+
+
+//
+// SharedMemoryRing
+//
+
+SharedMemoryRing::SharedMemoryRing(const std::string& queueName) :
+  _queueName(queueName),
+  _key(-1),
+  _open(false),
+  _fd(-1),
+  _mappedSize(0),
+  _pHeader(0),
+  _pData(0)
+{
+  std::ofstream dummy(queueName.c_str(), std::ios::app);
+  _key = ftok(_queueName.c_str(), 'B');
+}
+
+SharedMemoryRing::SharedMemoryRing(key_t key) :
+  _key(key),
+  _open(false),
+  _fd(-1),
+  _mappedSize(0),
+  _pHeader(0),
+  _pData(0)
+{
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+  detach();
+}
+
+std::string SharedMemoryRing::getSegmentName(key_t key)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "/oss-ipc-%08x", (unsigned int)key);
+  return name;
+}
+
+bool SharedMemoryRing::create(std::size_t capacity, bool reset)
+{
+  if (_key == -1)
+    return false;
+
+  std::string name = getSegmentName(_key);
+  if (reset)
+    shm_unlink(name.c_str());
+
+  _fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0666);
+  if (_fd == -1)
+    return false;
+  fchmod(_fd, 0666);
+
+  std::size_t size = SHM_RING_MIN_CAPACITY;
+  while (size < capacity)
+    size <<= 1;
+  size += SHM_RING_DATA_OFFSET;
+
+  struct stat st;
+  if (fstat(_fd, &st) == -1 || (st.st_size == 0 && ftruncate(_fd, size) == -1))
+  {
+    detach();
+    return false;
+  }
+  if (st.st_size != 0)
+    size = st.st_size;
+
+  void* pSegment = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (pSegment == MAP_FAILED)
+  {
+    detach();
+    return false;
+  }
+  _mappedSize = size;
+  _pHeader = static_cast<SharedMemoryRingHeader*>(pSegment);
+  _pData = static_cast<char*>(pSegment) + SHM_RING_DATA_OFFSET;
+
+  if (__atomic_load_n(&_pHeader->magic, __ATOMIC_ACQUIRE) == SHM_RING_MAGIC &&
+    SHM_RING_DATA_OFFSET + _pHeader->capacity <= _mappedSize)
+  {
+    //
+    // A reader of the same key is taking over a segment left behind
+    //
+    __atomic_store_n(&_pHeader->closed, 0, __ATOMIC_RELEASE);
+  }
+  else
+  {
+    std::memset(_pHeader, 0, SHM_RING_DATA_OFFSET);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&_pHeader->writeMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    _pHeader->capacity = _mappedSize - SHM_RING_DATA_OFFSET;
+    __atomic_store_n(&_pHeader->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+  }
+
+  _open = true;
+  return true;
+}
+
+bool SharedMemoryRing::attach()
+{
+  if (!_queueName.empty())
+  {
+    std::ofstream dummy(_queueName.c_str(), std::ios::app);
+    _key = ftok(_queueName.c_str(), 'B');
+  }
+  if (_key == -1)
+    return false;
+
+  _fd = shm_open(getSegmentName(_key).c_str(), O_RDWR, 0);
+  if (_fd == -1)
+    return false;
+
+  struct stat st;
+  if (fstat(_fd, &st) == -1 || (std::size_t)st.st_size <= SHM_RING_DATA_OFFSET)
+  {
+    detach();
+    return false;
+  }
+
+  void* pSegment = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (pSegment == MAP_FAILED)
+  {
+    detach();
+    return false;
+  }
+  _mappedSize = st.st_size;
+  _pHeader = static_cast<SharedMemoryRingHeader*>(pSegment);
+  _pData = static_cast<char*>(pSegment) + SHM_RING_DATA_OFFSET;
+
+  //
+  // The reader may still be initializing the header
+  //
+  if (__atomic_load_n(&_pHeader->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+    __atomic_load_n(&_pHeader->closed, __ATOMIC_ACQUIRE) ||
+    SHM_RING_DATA_OFFSET + _pHeader->capacity > _mappedSize)
+  {
+    detach();
+    return false;
+  }
+
+  _open = true;
+  return true;
+}
+
+void SharedMemoryRing::detach()
+{
+  _open = false;
+  if (_pHeader)
+    munmap(_pHeader, _mappedSize);
+  if (_fd != -1)
+    ::close(_fd);
+  _fd = -1;
+  _mappedSize = 0;
+  _pHeader = 0;
+  _pData = 0;
+}
+
+bool SharedMemoryRing::isOrphaned() const
+{
+  //
+  // The reader unlinks its segment when it closes or when a new reader
+  // replaces it
+  //
+  struct stat st;
+  return _fd == -1 || fstat(_fd, &st) == -1 || st.st_nlink == 0;
+}
+
+bool SharedMemoryRing::isOpen() const
+{
+  return _open && !__atomic_load_n(&_pHeader->closed, __ATOMIC_ACQUIRE);
+}
+
+std::size_t SharedMemoryRing::capacity() const
+{
+  return _pHeader ? _pHeader->capacity : 0;
+}
+
+std::size_t SharedMemoryRing::getMaxRecordSize() const
+{
+  //
+  // A record never takes more than half of the ring so that, even with the
+  // padding needed to wrap, it fits once the reader has caught up
+  //
+  return _pHeader ? _pHeader->capacity / 2 - sizeof(OSS::UInt32) : 0;
+}
+
+std::size_t SharedMemoryRing::size() const
+{
+  if (!_pHeader)
+    return 0;
+  OSS::UInt64 head = __atomic_load_n(&_pHeader->head, __ATOMIC_ACQUIRE);
+  OSS::UInt64 tail = __atomic_load_n(&_pHeader->tail, __ATOMIC_ACQUIRE);
+  return tail - head;
+}
+
+
+//
+// SharedMemoryRingReader
+//
+
+SharedMemoryRingReader::SharedMemoryRingReader(const std::string& queueName, std::size_t capacity) :
+  SharedMemoryRing(queueName)
+{
+  create(capacity, true);
+}
+
+SharedMemoryRingReader::SharedMemoryRingReader(key_t key, std::size_t capacity) :
+  SharedMemoryRing(key)
+{
+  create(capacity, false);
+}
+
+SharedMemoryRingReader::~SharedMemoryRingReader()
+{
+  close();
+}
+
+void SharedMemoryRingReader::close()
+{
+  if (!_open)
+    return;
+  _open = false;
+  __atomic_store_n(&_pHeader->closed, 1, __ATOMIC_SEQ_CST);
+  shm_ring_wake(&_pHeader->dataSeq, INT_MAX);
+  shm_ring_wake(&_pHeader->spaceSeq, INT_MAX);
+  shm_unlink(getSegmentName(_key).c_str());
+}
+
+bool SharedMemoryRingReader::read(std::string& data, bool blocking)
+{
+  if (!_pHeader)
+    return false;
+
+  SharedMemoryRingHeader* pHeader = _pHeader;
+  OSS::UInt64 mask = pHeader->capacity - 1;
+  OSS::UInt64 head = __atomic_load_n(&pHeader->head, __ATOMIC_RELAXED);
+
+  for (;;)
+  {
+    if (__atomic_load_n(&pHeader->closed, __ATOMIC_ACQUIRE))
+      return false;
+
+    OSS::UInt64 tail = __atomic_load_n(&pHeader->tail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+    {
+      if (!blocking)
+        return false;
+      //
+      // Pairs with the fence in write().  Either we see the new tail or
+      // the writer sees us waiting and bumps the sequence.
+      //
+      __atomic_store_n(&pHeader->readerWaiting, 1, __ATOMIC_SEQ_CST);
+      OSS::UInt32 sequence = __atomic_load_n(&pHeader->dataSeq, __ATOMIC_ACQUIRE);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&pHeader->tail, __ATOMIC_ACQUIRE) == head &&
+        !__atomic_load_n(&pHeader->closed, __ATOMIC_ACQUIRE))
+      {
+        shm_ring_wait(&pHeader->dataSeq, sequence, -1);
+      }
+      __atomic_store_n(&pHeader->readerWaiting, 0, __ATOMIC_RELAXED);
+      continue;
+    }
+
+    OSS::UInt64 pos = head & mask;
+    OSS::UInt32 len;
+    std::memcpy(&len, _pData + pos, sizeof(len));
+    if (len == SHM_RING_PAD)
+    {
+      head += pHeader->capacity - pos;
+      __atomic_store_n(&pHeader->head, head, __ATOMIC_RELEASE);
+      continue;
+    }
+
+    data.assign(_pData + pos + sizeof(len), len);
+    head += shm_ring_record_size(len);
+    __atomic_store_n(&pHeader->head, head, __ATOMIC_RELEASE);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pHeader->writersWaiting, __ATOMIC_RELAXED))
+      shm_ring_wake(&pHeader->spaceSeq, INT_MAX);
+    return true;
+  }
+}
+
+void SharedMemoryRingReader::clear()
+{
+  if (!_open)
+    return;
+  OSS::UInt64 tail = __atomic_load_n(&_pHeader->tail, __ATOMIC_ACQUIRE);
+  __atomic_store_n(&_pHeader->head, tail, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&_pHeader->writersWaiting, __ATOMIC_RELAXED))
+    shm_ring_wake(&_pHeader->spaceSeq, INT_MAX);
+}
+
+
+//
+// SharedMemoryRingWriter
+//
+
+SharedMemoryRingWriter::SharedMemoryRingWriter(const std::string& queueName) :
+  SharedMemoryRing(queueName),
+  _orphanCheckTime(0)
+{
+  attach();
+}
+
+SharedMemoryRingWriter::SharedMemoryRingWriter(key_t key) :
+  SharedMemoryRing(key),
+  _orphanCheckTime(0)
+{
+  attach();
+}
+
+SharedMemoryRingWriter::~SharedMemoryRingWriter()
+{
+  close();
+}
+
+void SharedMemoryRingWriter::close()
+{
+  OSS::mutex_critic_sec_lock lock(_attachMutex);
+  detach();
+}
+
+bool SharedMemoryRingWriter::reattach()
+{
+  detach();
+  return attach();
+}
+
+bool SharedMemoryRingWriter::write(const char* data, std::size_t len, bool blocking)
+{
+  OSS::mutex_critic_sec_lock lock(_attachMutex);
+
+  //
+  // A reader that died without closing leaves the ring open.  The segment
+  // is unlinked once a new reader replaces it so the link count is checked
+  // at a fixed interval rather than only when the ring fills up.
+  //
+  if (_open)
+  {
+    OSS::UInt64 now = OSS::getTime();
+    bool orphanCheck = now >= _orphanCheckTime;
+    if (orphanCheck)
+      _orphanCheckTime = now + SHM_RING_ORPHAN_CHECK_MS;
+    if (__atomic_load_n(&_pHeader->closed, __ATOMIC_ACQUIRE) || (orphanCheck && isOrphaned()))
+      detach();
+  }
+  if (!_open && !attach())
+    return false;
+  if (len > getMaxRecordSize())
+    return false;
+
+  std::size_t need = shm_ring_record_size(len);
+  for (;;)
+  {
+    SharedMemoryRingHeader* pHeader = _pHeader;
+    OSS::UInt64 capacity = pHeader->capacity;
+    if (!shm_ring_lock(&pHeader->writeMutex))
+      return false;
+
+    OSS::UInt64 head = __atomic_load_n(&pHeader->head, __ATOMIC_ACQUIRE);
+    OSS::UInt64 tail = __atomic_load_n(&pHeader->tail, __ATOMIC_RELAXED);
+    OSS::UInt64 pos = tail & (capacity - 1);
+    OSS::UInt64 skip = capacity - pos < need ? capacity - pos : 0;
+
+    if (capacity - (tail - head) >= skip + need)
+    {
+      if (skip)
+      {
+        OSS::UInt32 pad = SHM_RING_PAD;
+        std::memcpy(_pData + pos, &pad, sizeof(pad));
+        tail += skip;
+        pos = 0;
+      }
+      OSS::UInt32 recordLength = (OSS::UInt32)len;
+      std::memcpy(_pData + pos, &recordLength, sizeof(recordLength));
+      std::memcpy(_pData + pos + sizeof(recordLength), data, len);
+      __atomic_store_n(&pHeader->tail, tail + need, __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&pHeader->writeMutex);
+
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&pHeader->readerWaiting, __ATOMIC_RELAXED))
+        shm_ring_wake(&pHeader->dataSeq, 1);
+      return true;
+    }
+    pthread_mutex_unlock(&pHeader->writeMutex);
+
+    //
+    // A full ring may belong to a reader that is gone
+    //
+    if (__atomic_load_n(&pHeader->closed, __ATOMIC_ACQUIRE) || isOrphaned())
+    {
+      if (!reattach() || len > getMaxRecordSize())
+        return false;
+      continue;
+    }
+
+    if (!blocking)
+      return false;
+
+    __atomic_add_fetch(&pHeader->writersWaiting, 1, __ATOMIC_SEQ_CST);
+    OSS::UInt32 sequence = __atomic_load_n(&pHeader->spaceSeq, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pHeader->head, __ATOMIC_ACQUIRE) == head)
+      shm_ring_wait(&pHeader->spaceSeq, sequence, SHM_RING_WRITER_WAIT_MS);
+    __atomic_sub_fetch(&pHeader->writersWaiting, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+
+} // OSS
@@ -0,0 +1,282 @@
+// Library: OSS_CORE - Foundation API for SIP B2BUA
+// Copyright (c) OSS Software Solutions
+// Contributor: Joegen Baclor - mailto:joegen@ossapp.com
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "GNU Lesser General Public License (LGPL)".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <new>
+#include "OSS/UTL/SlabPool.h"
+#include "OSS/UTL/Metrics.h"
+
+
+namespace OSS {
+
+
+static std::size_t align_size(std::size_t size)
+{
+  return (size + SlabPool::ALIGNMENT - 1) & ~((std::size_t)SlabPool::ALIGNMENT - 1);
+}
+
+//
+// boost::thread_specific_ptr looks the cache up in a map.  The caches this
+// thread used last are remembered in a small table indexed by pool address
+// so the hot path is a single compare.  An entry is cleared when its cache
+// is freed, which always happens on the thread that owns it.
+//
+enum { RECENT_CACHE_COUNT = 8 };
+
+struct RecentCache
+{
+  const void* pPool;
+  void* pCache;
+};
+
+static __thread RecentCache recent_caches[RECENT_CACHE_COUNT];
+
+static RecentCache& recent_cache(const void* pPool)
+{
+  return recent_caches[(reinterpret_cast<std::size_t>(pPool) / 64) % RECENT_CACHE_COUNT];
+}
+
+static OSS::mutex_critic_sec& thread_cache_mutex()
+  /// Guards the list of thread caches of every pool and their pool
+  /// pointer.  It is never destroyed because threads may exit after the
+  /// static pools are gone.
+{
+  static OSS::mutex_critic_sec* pMutex = new OSS::mutex_critic_sec();
+  return *pMutex;
+}
+
+SlabPool::SlabPool(const std::string& name, std::size_t blockSize, std::size_t blocksPerSlab) :
+  _name(name),
+  _blockSize(align_size(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize)),
+  _blocksPerSlab(blocksPerSlab),
+  _batchSize(0),
+  _freeList(0),
+  _slabs(0),
+  _threadCache(&SlabPool::releaseThreadCache),
+  _threadCaches(0),
+  _liveBytes(Metrics::instance().gauge("memory_" + name + "_live_bytes", "Bytes in use by " + name)),
+  _liveObjects(Metrics::instance().gauge("memory_" + name + "_live_objects", "Blocks in use by " + name)),
+  _reservedBytes(Metrics::instance().gauge("memory_" + name + "_reserved_bytes", "Bytes held by the " + name + " pool"))
+{
+  if (!_blocksPerSlab)
+    _blocksPerSlab = (std::size_t)SLAB_SIZE > _blockSize ? SLAB_SIZE / _blockSize : 1;
+  _batchSize = _blocksPerSlab < (std::size_t)CACHE_BATCH_SIZE ? _blocksPerSlab : (std::size_t)CACHE_BATCH_SIZE;
+}
+
+SlabPool::~SlabPool()
+{
+  //
+  // Threads that are still running keep their cache object and free it
+  // when they exit.  The blocks in it go away with the slabs.
+  //
+  {
+    OSS::mutex_critic_sec_lock cacheLock(thread_cache_mutex());
+    for (ThreadCache* pCache = _threadCaches; pCache; pCache = pCache->pNext)
+    {
+      pCache->pPool = 0;
+      pCache->freeList = 0;
+      pCache->count = 0;
+    }
+    _threadCaches = 0;
+  }
+
+  //
+  // Blocks still in use are left alone together with their slab
+  //
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (_liveObjects.value())
+    return;
+
+  std::size_t slabSize = ALIGNMENT + _blockSize * _blocksPerSlab;
+  while (_slabs)
+  {
+    void* pNext = *static_cast<void**>(_slabs);
+    ::operator delete(_slabs);
+    _reservedBytes.decrement(slabSize);
+    _slabs = pNext;
+  }
+  _freeList = 0;
+}
+
+void SlabPool::grow()
+{
+  //
+  // The first ALIGNMENT bytes of a slab link it to the previous one
+  //
+  std::size_t slabSize = ALIGNMENT + _blockSize * _blocksPerSlab;
+  char* pSlab = static_cast<char*>(::operator new(slabSize));
+  *reinterpret_cast<void**>(pSlab) = _slabs;
+  _slabs = pSlab;
+  _reservedBytes.increment(slabSize);
+
+  char* pBlock = pSlab + ALIGNMENT;
+  for (std::size_t i = 0; i < _blocksPerSlab; i++, pBlock += _blockSize)
+  {
+    FreeBlock* pFree = reinterpret_cast<FreeBlock*>(pBlock);
+    pFree->next = _freeList;
+    _freeList = pFree;
+  }
+}
+
+SlabPool::ThreadCache& SlabPool::threadCache()
+{
+  RecentCache& recent = recent_cache(this);
+  if (recent.pPool == this && static_cast<ThreadCache*>(recent.pCache)->pPool == this)
+    return *static_cast<ThreadCache*>(recent.pCache);
+
+  ThreadCache* pCache = _threadCache.get();
+  if (pCache && pCache->pPool)
+  {
+    recent.pPool = this;
+    recent.pCache = pCache;
+    return *pCache;
+  }
+
+  //
+  // A cache left behind by a destroyed pool at the same address is taken
+  // over by this one
+  //
+  if (!pCache)
+  {
+    pCache = new ThreadCache();
+    pCache->freeList = 0;
+    pCache->count = 0;
+    _threadCache.reset(pCache);
+  }
+
+  OSS::mutex_critic_sec_lock cacheLock(thread_cache_mutex());
+  pCache->pPool = this;
+  pCache->pPrev = 0;
+  pCache->pNext = _threadCaches;
+  if (_threadCaches)
+    _threadCaches->pPrev = pCache;
+  _threadCaches = pCache;
+  recent.pPool = this;
+  recent.pCache = pCache;
+  return *pCache;
+}
+
+void SlabPool::refill(ThreadCache& cache)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_freeList)
+    grow();
+  while (_freeList && cache.count < _batchSize)
+  {
+    FreeBlock* pBlock = _freeList;
+    _freeList = pBlock->next;
+    pBlock->next = cache.freeList;
+    cache.freeList = pBlock;
+    cache.count++;
+  }
+}
+
+void SlabPool::drain(ThreadCache& cache, std::size_t count)
+{
+  //
+  // Unlink the batch first so the lock is held for a single splice
+  //
+  FreeBlock* pFirst = cache.freeList;
+  FreeBlock* pLast = pFirst;
+  for (std::size_t i = 1; i < count; i++)
+    pLast = pLast->next;
+  cache.freeList = pLast->next;
+  cache.count -= count;
+
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  pLast->next = _freeList;
+  _freeList = pFirst;
+}
+
+void SlabPool::releaseThreadCache(ThreadCache* pCache)
+{
+  for (std::size_t i = 0; i < RECENT_CACHE_COUNT; i++)
+  {
+    if (recent_caches[i].pCache == pCache)
+      recent_caches[i].pPool = recent_caches[i].pCache = 0;
+  }
+
+  {
+    OSS::mutex_critic_sec_lock cacheLock(thread_cache_mutex());
+    SlabPool* pPool = pCache->pPool;
+    if (pPool)
+    {
+      if (pCache->count)
+        pPool->drain(*pCache, pCache->count);
+      if (pCache->pPrev)
+        pCache->pPrev->pNext = pCache->pNext;
+      else
+        pPool->_threadCaches = pCache->pNext;
+      if (pCache->pNext)
+        pCache->pNext->pPrev = pCache->pPrev;
+    }
+  }
+  delete pCache;
+}
+
+void* SlabPool::allocate()
+{
+  ThreadCache& cache = threadCache();
+  if (!cache.count)
+    refill(cache);
+  FreeBlock* pBlock = cache.freeList;
+  cache.freeList = pBlock->next;
+  cache.count--;
+
+  _liveBytes.increment(_blockSize);
+  _liveObjects.increment();
+  return pBlock;
+}
+
+void SlabPool::deallocate(void* pBlock)
+{
+  if (!pBlock)
+    return;
+  _liveBytes.decrement(_blockSize);
+  _liveObjects.decrement();
+
+  ThreadCache& cache = threadCache();
+  FreeBlock* pFree = static_cast<FreeBlock*>(pBlock);
+  pFree->next = cache.freeList;
+  cache.freeList = pFree;
+  if (++cache.count >= 2 * _batchSize)
+    drain(cache, _batchSize);
+}
+
+void* SlabPool::allocateOversized(std::size_t size)
+{
+  void* pBlock = ::operator new(size);
+  _liveBytes.increment(size);
+  _liveObjects.increment();
+  _reservedBytes.increment(size);
+  return pBlock;
+}
+
+void SlabPool::deallocateOversized(void* pBlock, std::size_t size)
+{
+  if (!pBlock)
+    return;
+  ::operator delete(pBlock);
+  _liveBytes.decrement(size);
+  _liveObjects.decrement();
+  _reservedBytes.decrement(size);
+}
+
+
+} // OSS
@@ -0,0 +1,385 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include <fcntl.h>
+#include <unistd.h>
+#include "OSS/ZMQ/ZMQReactor.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Semaphore.h"
+#include "OSS/UTL/Logger.h"
+
+
+#if OSS_HAVE_ZMQ
+
+
+namespace OSS {
+namespace ZMQ {
+
+
+static void reactor_run_and_signal(const ZMQReactor::Task& task, OSS::Semaphore* pDone)
+{
+  task();
+  pDone->signal();
+}
+
+ZMQReactor::ZMQReactor(unsigned int timerInterval) :
+  _timerInterval(timerInterval ? timerInterval : DEFAULT_TIMER_INTERVAL),
+  _pThread(0),
+  _isTerminating(false),
+  _isAccepting(false),
+  _lastTimerId(0)
+{
+  _wakePipe[0] = -1;
+  _wakePipe[1] = -1;
+  if (::pipe(_wakePipe) == 0)
+  {
+    ::fcntl(_wakePipe[0], F_SETFL, ::fcntl(_wakePipe[0], F_GETFL) | O_NONBLOCK);
+    ::fcntl(_wakePipe[1], F_SETFL, ::fcntl(_wakePipe[1], F_GETFL) | O_NONBLOCK);
+  }
+  else
+  {
+    OSS_LOG_ERROR("ZMQReactor::ZMQReactor() - Unable to create wake pipe");
+  }
+}
+
+ZMQReactor::~ZMQReactor()
+{
+  stop();
+  if (_wakePipe[0] != -1)
+    ::close(_wakePipe[0]);
+  if (_wakePipe[1] != -1)
+    ::close(_wakePipe[1]);
+}
+
+bool ZMQReactor::run()
+{
+  if (_pThread || _wakePipe[0] == -1)
+  {
+    return false;
+  }
+  
+  {
+    OSS::mutex_critic_sec_lock lock(_tasksMutex);
+    _isAccepting = true;
+  }
+  _isTerminating = false;
+  _pThread = new boost::thread(boost::bind(&ZMQReactor::runLoop, this));
+  return true;
+}
+
+void ZMQReactor::stop()
+{
+  if (!_pThread)
+  {
+    return;
+  }
+  
+  if (isReactorThread())
+  {
+    //
+    // The thread cannot join itself.  The loop exits after this handler
+    // and the owner joins it on destruction.
+    //
+    _isTerminating = true;
+    return;
+  }
+  
+  post(boost::bind(&ZMQReactor::terminate, this));
+  _pThread->join();
+  delete _pThread;
+  _pThread = 0;
+}
+
+bool ZMQReactor::isRunning() const
+{
+  return _pThread != 0;
+}
+
+bool ZMQReactor::isReactorThread() const
+{
+  return _pThread && boost::this_thread::get_id() == _threadId;
+}
+
+void ZMQReactor::terminate()
+{
+  _isTerminating = true;
+}
+
+void ZMQReactor::wake()
+{
+  char signal = 0;
+  if (::write(_wakePipe[1], &signal, 1) == -1)
+  {
+    //
+    // A full pipe already guarantees a wake up
+    //
+  }
+}
+
+void ZMQReactor::post(const Task& task)
+{
+  bool wasEmpty;
+  {
+    OSS::mutex_critic_sec_lock lock(_tasksMutex);
+    wasEmpty = _tasks.empty();
+    _tasks.push_back(task);
+  }
+  
+  //
+  // The reactor swaps out the whole queue before it runs it so only the
+  // first task of a batch needs to wake it
+  //
+  if (wasEmpty)
+  {
+    wake();
+  }
+}
+
+void ZMQReactor::execute(const Task& task)
+{
+  if (isReactorThread())
+  {
+    task();
+    return;
+  }
+  
+  OSS::Semaphore done;
+  bool wasEmpty;
+  {
+    OSS::mutex_critic_sec_lock lock(_tasksMutex);
+    if (!_isAccepting)
+    {
+      _tasks.push_back(task);
+      return;
+    }
+    wasEmpty = _tasks.empty();
+    _tasks.push_back(boost::bind(reactor_run_and_signal, task, &done));
+  }
+  
+  if (wasEmpty)
+  {
+    wake();
+  }
+  done.wait();
+}
+
+void ZMQReactor::addSocket(ZMQSocket* pSocket, const ReadHandler& handler)
+{
+  post(boost::bind(&ZMQReactor::insertSocket, this, pSocket, handler));
+}
+
+void ZMQReactor::removeSocket(ZMQSocket* pSocket)
+{
+  execute(boost::bind(&ZMQReactor::eraseSocket, this, pSocket));
+}
+
+int ZMQReactor::addTimer(const Task& handler)
+{
+  int timerId = ++_lastTimerId;
+  post(boost::bind(&ZMQReactor::insertTimer, this, timerId, handler));
+  return timerId;
+}
+
+void ZMQReactor::removeTimer(int timerId)
+{
+  execute(boost::bind(&ZMQReactor::eraseTimer, this, timerId));
+}
+
+void ZMQReactor::insertSocket(ZMQSocket* pSocket, const ReadHandler& handler)
+{
+  Registration registration;
+  registration.pSocket = pSocket;
+  registration.handler = handler;
+  _registrations.push_back(registration);
+}
+
+void ZMQReactor::eraseSocket(ZMQSocket* pSocket)
+{
+  //
+  // The entry may be in the middle of a dispatch.  It is only marked here
+  // and erased before the next poll.
+  //
+  for (Registrations::iterator iter = _registrations.begin(); iter != _registrations.end(); iter++)
+  {
+    if (iter->pSocket == pSocket)
+    {
+      iter->pSocket = 0;
+    }
+  }
+}
+
+void ZMQReactor::insertTimer(int timerId, const Task& handler)
+{
+  _timers[timerId] = handler;
+}
+
+void ZMQReactor::eraseTimer(int timerId)
+{
+  _timers.erase(timerId);
+}
+
+void ZMQReactor::runTasks()
+{
+  Tasks tasks;
+  {
+    OSS::mutex_critic_sec_lock lock(_tasksMutex);
+    tasks.swap(_tasks);
+  }
+  
+  for (Tasks::iterator iter = tasks.begin(); iter != tasks.end(); iter++)
+  {
+    (*iter)();
+  }
+}
+
+void ZMQReactor::runTimers()
+{
+  //
+  // A handler may remove itself or another timer
+  //
+  Timers timers = _timers;
+  for (Timers::iterator iter = timers.begin(); iter != timers.end(); iter++)
+  {
+    if (_timers.find(iter->first) != _timers.end())
+    {
+      iter->second();
+    }
+  }
+}
+
+void ZMQReactor::runLoop()
+{
+  _threadId = boost::this_thread::get_id();
+  
+  ZMQSocket::PollItems items;
+  std::vector<std::size_t> indexes;
+  OSS::UInt64 nextTimer = OSS::getTime() + _timerInterval;
+  
+  while (!_isTerminating)
+  {
+    runTasks();
+    if (_isTerminating)
+    {
+      break;
+    }
+    
+    items.clear();
+    indexes.clear();
+    
+    ZMQSocket::PollItem wakeItem;
+    wakeItem.socket = 0;
+    wakeItem.fd = _wakePipe[0];
+    wakeItem.events = ZMQ_POLLIN;
+    wakeItem.revents = 0;
+    items.push_back(wakeItem);
+    
+    for (std::size_t i = 0; i < _registrations.size();)
+    {
+      if (!_registrations[i].pSocket)
+      {
+        _registrations.erase(_registrations.begin() + i);
+        continue;
+      }
+      
+      //
+      // A socket that is closed or waiting to reconnect has no ZMQ socket
+      //
+      zmq::socket_t* socket = _registrations[i].pSocket->socket();
+      if (socket)
+      {
+        ZMQSocket::PollItem item;
+        item.socket = *socket;
+        item.fd = 0;
+        item.events = ZMQ_POLLIN;
+        item.revents = 0;
+        items.push_back(item);
+        indexes.push_back(i);
+      }
+      i++;
+    }
+    
+    OSS::UInt64 now = OSS::getTime();
+    long timeout = nextTimer > now ? (long)(nextTimer - now) : 0;
+    int rc = ZMQSocket::poll(items, timeout);
+    if (rc < 0 && zmq_errno() == ETERM)
+    {
+      OSS_LOG_ERROR("ZMQReactor::runLoop() - ZMQ context terminated");
+      break;
+    }
+    
+    if (rc > 0)
+    {
+      if (items[0].revents & ZMQ_POLLIN)
+      {
+        char buff[64];
+        while (::read(_wakePipe[0], buff, sizeof(buff)) > 0);
+      }
+      
+      for (std::size_t i = 1; i < items.size(); i++)
+      {
+        Registration& registration = _registrations[indexes[i - 1]];
+        if (!(items[i].revents & ZMQ_POLLIN) || !registration.pSocket)
+        {
+          continue;
+        }
+        
+        try
+        {
+          registration.handler(*registration.pSocket);
+        }
+        catch(const std::exception& e)
+        {
+          OSS_LOG_ERROR("ZMQReactor::runLoop() - Exception: " << e.what());
+        }
+      }
+    }
+    
+    now = OSS::getTime();
+    if (now >= nextTimer)
+    {
+      runTimers();
+      nextTimer = now + _timerInterval;
+    }
+  }
+  
+  //
+  // Run whatever was queued before the reactor stopped accepting tasks so
+  // no thread is left waiting in execute()
+  //
+  Tasks tasks;
+  {
+    OSS::mutex_critic_sec_lock lock(_tasksMutex);
+    _isAccepting = false;
+    tasks.swap(_tasks);
+  }
+  for (Tasks::iterator iter = tasks.begin(); iter != tasks.end(); iter++)
+  {
+    (*iter)();
+  }
+}
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
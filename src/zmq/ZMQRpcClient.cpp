@@ -0,0 +1,258 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/ZMQ/ZMQRpcClient.h"
+#include "OSS/UTL/CoreUtils.h"
+#include "OSS/UTL/Semaphore.h"
+#include "OSS/UTL/Logger.h"
+
+
+#if OSS_HAVE_ZMQ
+
+
+namespace OSS {
+namespace ZMQ {
+
+
+struct ZMQRpcSyncReply
+{
+  OSS::Semaphore done;
+  bool ok;
+  std::string reply;
+};
+
+static void rpc_sync_reply(ZMQRpcSyncReply* pSync, bool ok, const std::string& reply)
+{
+  pSync->ok = ok;
+  pSync->reply = reply;
+  pSync->done.signal();
+}
+
+ZMQRpcClient::ZMQRpcClient(ZMQReactor& reactor) :
+  _reactor(reactor),
+  _socket(ZMQSocket::DEALER),
+  _lastId(0),
+  _timerId(0)
+{
+}
+
+ZMQRpcClient::~ZMQRpcClient()
+{
+  close();
+}
+
+bool ZMQRpcClient::connect(const std::string& peerAddress)
+{
+  if (_timerId || !_socket.connect(peerAddress))
+  {
+    return false;
+  }
+  
+  _peerAddress = peerAddress;
+  _reactor.addSocket(&_socket, boost::bind(&ZMQRpcClient::onReadable, this, _1));
+  _timerId = _reactor.addTimer(boost::bind(&ZMQRpcClient::onTimer, this));
+  return true;
+}
+
+void ZMQRpcClient::close()
+{
+  if (_timerId)
+  {
+    _reactor.removeSocket(&_socket);
+    _reactor.removeTimer(_timerId);
+    _timerId = 0;
+  }
+  
+  //
+  // The socket belongs to the reactor thread.  Close it there, after the
+  // sends that were posted before this call.
+  //
+  if (_reactor.isRunning())
+  {
+    _reactor.execute(boost::bind(&ZMQSocket::close, &_socket));
+  }
+  else
+  {
+    _socket.close();
+  }
+  
+  failPending();
+}
+
+void ZMQRpcClient::failPending()
+{
+  PendingRequests pending;
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    pending.swap(_pending);
+  }
+  for (PendingRequests::iterator iter = pending.begin(); iter != pending.end(); iter++)
+  {
+    iter->second.handler(false, std::string());
+  }
+}
+
+OSS::UInt64 ZMQRpcClient::sendRequest(const std::string& cmd, const std::string& data, const ReplyHandler& handler, unsigned int timeoutms)
+{
+  return sendRequest(cmd, ZMQSocket::Buffer(new std::string(data)), handler, timeoutms);
+}
+
+OSS::UInt64 ZMQRpcClient::sendRequest(const std::string& cmd, const ZMQSocket::Buffer& data, const ReplyHandler& handler, unsigned int timeoutms)
+{
+  OSS::UInt64 id = ++_lastId;
+  
+  PendingRequest request;
+  request.handler = handler;
+  request.deadline = timeoutms ? OSS::getTime() + timeoutms : (OSS::UInt64)-1;
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    _pending[id] = request;
+  }
+  
+  ZMQSocket::Buffers frames;
+  frames.push_back(ZMQSocket::Buffer(new std::string()));
+  frames.push_back(ZMQSocket::Buffer(new std::string((const char*)&id, sizeof(id))));
+  frames.push_back(ZMQSocket::Buffer(new std::string(cmd)));
+  frames.push_back(data);
+  _reactor.post(boost::bind(&ZMQRpcClient::onSend, this, id, frames));
+  return id;
+}
+
+bool ZMQRpcClient::sendAndReceive(const std::string& cmd, const std::string& data, std::string& response, unsigned int timeoutms)
+{
+  if (!_reactor.isRunning() || _reactor.isReactorThread())
+  {
+    return false;
+  }
+  
+  //
+  // The handler always runs, on reply, on timeout or on close, so the
+  // stack object outlives every reference to it
+  //
+  ZMQRpcSyncReply sync;
+  sync.ok = false;
+  sendRequest(cmd, data, boost::bind(rpc_sync_reply, &sync, _1, _2), timeoutms);
+  sync.done.wait();
+  if (sync.ok)
+  {
+    response = sync.reply;
+  }
+  return sync.ok;
+}
+
+std::size_t ZMQRpcClient::getPendingCount() const
+{
+  OSS::mutex_critic_sec_lock lock(_pendingMutex);
+  return _pending.size();
+}
+
+void ZMQRpcClient::onSend(OSS::UInt64 id, const ZMQSocket::Buffers& frames)
+{
+  if (!_socket.sendMultipart(frames))
+  {
+    //
+    // A request cut short leaves the socket in the middle of a multipart
+    // message and the next request would be appended to it.  Start over on
+    // a new socket.  Replies to requests sent on the old one can no longer
+    // arrive so those requests fail now.
+    //
+    OSS_LOG_WARNING("ZMQRpcClient::onSend() - Failed to send request " << id << ".  Reopening socket to " << _peerAddress);
+    _socket.close();
+    failPending();
+    if (!_peerAddress.empty())
+    {
+      _socket.connect(_peerAddress);
+    }
+  }
+}
+
+void ZMQRpcClient::onReadable(ZMQSocket& socket)
+{
+  ZMQSocket::Frames frames;
+  while (socket.tryReceiveMultipart(frames))
+  {
+    //
+    // [empty][id][reply]
+    //
+    std::size_t i = 0;
+    if (i < frames.size() && frames[i].empty())
+    {
+      i++;
+    }
+    if (i >= frames.size() || frames[i].size() != sizeof(OSS::UInt64))
+    {
+      OSS_LOG_WARNING("ZMQRpcClient::onReadable() - Dropping reply without a request id");
+      continue;
+    }
+    
+    OSS::UInt64 id;
+    memcpy(&id, frames[i].data(), sizeof(id));
+    complete(id, true, i + 1 < frames.size() ? frames[i + 1] : std::string());
+  }
+}
+
+void ZMQRpcClient::onTimer()
+{
+  std::vector<OSS::UInt64> expired;
+  OSS::UInt64 now = OSS::getTime();
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    for (PendingRequests::iterator iter = _pending.begin(); iter != _pending.end(); iter++)
+    {
+      if (iter->second.deadline <= now)
+      {
+        expired.push_back(iter->first);
+      }
+    }
+  }
+  
+  for (std::vector<OSS::UInt64>::iterator iter = expired.begin(); iter != expired.end(); iter++)
+  {
+    complete(*iter, false, std::string());
+  }
+}
+
+void ZMQRpcClient::complete(OSS::UInt64 id, bool ok, const std::string& reply)
+{
+  ReplyHandler handler;
+  {
+    OSS::mutex_critic_sec_lock lock(_pendingMutex);
+    PendingRequests::iterator iter = _pending.find(id);
+    if (iter == _pending.end())
+    {
+      //
+      // Late reply to a request that already timed out
+      //
+      return;
+    }
+    handler = iter->second.handler;
+    _pending.erase(iter);
+  }
+  handler(ok, reply);
+}
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
@@ -0,0 +1,144 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/ZMQ/ZMQRpcServer.h"
+#include "OSS/UTL/Logger.h"
+
+
+#if OSS_HAVE_ZMQ
+
+
+namespace OSS {
+namespace ZMQ {
+
+
+ZMQRpcServer::ZMQRpcServer(ZMQReactor& reactor, const RequestHandler& handler) :
+  _reactor(reactor),
+  _socket(ZMQSocket::ROUTER),
+  _handler(handler),
+  _isBound(false)
+{
+}
+
+ZMQRpcServer::~ZMQRpcServer()
+{
+  close();
+}
+
+bool ZMQRpcServer::bind(const std::string& bindAddress)
+{
+  if (_isBound || !_socket.bind(bindAddress))
+  {
+    return false;
+  }
+  
+  _reactor.addSocket(&_socket, boost::bind(&ZMQRpcServer::onReadable, this, _1));
+  _isBound = true;
+  return true;
+}
+
+void ZMQRpcServer::close()
+{
+  if (_isBound)
+  {
+    _reactor.removeSocket(&_socket);
+    _isBound = false;
+  }
+  _socket.close();
+}
+
+void ZMQRpcServer::sendReply(const Request& request, const std::string& reply)
+{
+  sendReply(request, ZMQSocket::Buffer(new std::string(reply)));
+}
+
+void ZMQRpcServer::sendReply(const Request& request, const ZMQSocket::Buffer& reply)
+{
+  ZMQSocket::Buffers frames;
+  frames.push_back(ZMQSocket::Buffer(new std::string(request.identity)));
+  frames.push_back(ZMQSocket::Buffer(new std::string()));
+  if (!request.id.empty())
+  {
+    frames.push_back(ZMQSocket::Buffer(new std::string(request.id)));
+  }
+  frames.push_back(reply);
+  
+  if (_reactor.isReactorThread())
+  {
+    onSendReply(frames);
+  }
+  else
+  {
+    _reactor.post(boost::bind(&ZMQRpcServer::onSendReply, this, frames));
+  }
+}
+
+void ZMQRpcServer::onSendReply(const ZMQSocket::Buffers& frames)
+{
+  if (!_socket.sendMultipart(frames))
+  {
+    OSS_LOG_WARNING("ZMQRpcServer::onSendReply() - Unable to send reply");
+  }
+}
+
+void ZMQRpcServer::onReadable(ZMQSocket& socket)
+{
+  ZMQSocket::Frames frames;
+  while (socket.tryReceiveMultipart(frames))
+  {
+    //
+    // ZMQRpcClient sends [identity][empty][id][cmd][data].  A REQ socket
+    // sends [identity][empty][cmd][data] or [identity][empty][data].
+    //
+    if (frames.size() < 3 || !frames[1].empty())
+    {
+      OSS_LOG_WARNING("ZMQRpcServer::onReadable() - Dropping malformed request with " << frames.size() << " frames");
+      continue;
+    }
+    
+    Request request;
+    request.identity = frames[0];
+    switch (frames.size())
+    {
+    case 3:
+      request.data = frames[2];
+      break;
+    case 4:
+      request.cmd = frames[2];
+      request.data = frames[3];
+      break;
+    default:
+      request.id = frames[2];
+      request.cmd = frames[3];
+      request.data = frames[4];
+      break;
+    }
+    _handler(request);
+  }
+}
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ
@@ -30,6 +30,11 @@
 #if OSS_HAVE_ZMQ
 
 
+#ifndef ZMQ_DONTWAIT
+#define ZMQ_DONTWAIT ZMQ_NOBLOCK
+#endif
+
+
 namespace OSS {
 namespace ZMQ {
   
@@ -49,6 +54,20 @@ static bool zeromq_send (zmq::socket_t & socket, const std::string & data)
   return (rc);
 }
 
+//  Sends a buffer without copying it.  The message frees it when done.
+static bool zeromq_send (zmq::socket_t & socket, void* data, std::size_t size, zmq::free_fn* freeFunc)
+{
+  zmq::message_t message(data, size, freeFunc, 0);
+  bool rc = socket.send(message);
+  return (rc);
+}
+
+//  Drops the reference a zero-copy frame held on its buffer
+static void zeromq_release_buffer (void *data, void *hint)
+{
+  delete static_cast<ZMQSocket::Buffer*>(hint);
+}
+
 //  Sends string as 0MQ string, as multipart non-terminal
 static bool zeromq_sendmore (zmq::socket_t & socket, const std::string & data)
 {
@@ -68,6 +87,18 @@ static void zeromq_receive (zmq::socket_t& socket, std::string& value)
   value = std::string(static_cast<char*>(message.data()), message.size());
 } 
 
+static bool zeromq_has_more (zmq::socket_t& socket)
+{
+#if ZMQ_VERSION_MAJOR < 3
+  int64_t more = 0;
+#else
+  int more = 0;
+#endif
+  size_t size = sizeof(more);
+  socket.getsockopt(ZMQ_RCVMORE, &more, &size);
+  return more != 0;
+}
+
 static zmq::socket_t* zeromq_create_socket(zmq::context_t* context, int type)
 {
   zmq::socket_t* socket = new zmq::socket_t(*context, type);
@@ -173,6 +204,16 @@ bool ZMQSocket::bind(const std::string& bindAddress)
       _socket = zeromq_create_socket(_context, ZMQ_PUB);
     }
     break;
+  case ROUTER:
+    if (_isInproc)
+    {
+      _socket = zeromq_create_socket(_inproc_context, ZMQ_ROUTER);
+    }
+    else
+    {
+      _socket = zeromq_create_socket(_context, ZMQ_ROUTER);
+    }
+    break;
   default:
     return false;
   }
@@ -260,6 +301,16 @@ bool ZMQSocket::internal_connect(const std::string& peerAddress)
       _socket = zeromq_create_socket(_context, ZMQ_SUB);
     }
     break;
+  case DEALER:
+    if (_isInproc)
+    {
+      _socket = zeromq_create_socket(_inproc_context, ZMQ_DEALER);
+    }
+    else
+    {
+      _socket = zeromq_create_socket(_context, ZMQ_DEALER);
+    }
+    break;
   default:
     return false;
   }
@@ -355,17 +406,38 @@ bool ZMQSocket::sendRequest(const std::string& cmd, const std::string& data)
   return internal_send_request(cmd, data);
 }
 
+bool ZMQSocket::sendRequest(const std::string& cmd, void* data, std::size_t size, FreeFunc* freeFunc)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return internal_send_request(cmd, data, size, freeFunc);
+}
+
 bool ZMQSocket::internal_send_request(const std::string& cmd, const std::string& data)
+{
+  char * buff = (char*)malloc(data.size());
+  memcpy(buff, data.data(), data.size());
+  return internal_send_request(cmd, buff, data.size(), zeromq_free);
+}
+
+bool ZMQSocket::internal_send_request(const std::string& cmd, void* data, std::size_t size, FreeFunc* freeFunc)
 {  
   //
   // reconnect the socket 
   //
   if (!_socket && _peerAddress.empty())
   {
+    freeFunc(data, 0);
     return false;
   }
   else if (!_socket && _canReconnect && !internal_connect(_peerAddress))
   {
+    freeFunc(data, 0);
+    return false;
+  }
+  
+  if (!_socket)
+  {
+    freeFunc(data, 0);
     return false;
   }
   
@@ -374,10 +446,11 @@ bool ZMQSocket::internal_send_request(const std::string& cmd, const std::string&
     OSS_LOG_ERROR("ZMQSocket::send() - Exception: zeromq_sendmore(cmd) failed");
     _canReconnect = true;
     internal_close();    
+    freeFunc(data, 0);
     return false;
   }
   
-  if (!zeromq_send(*_socket, data))
+  if (!zeromq_send(*_socket, data, size, freeFunc))
   {
     OSS_LOG_ERROR("ZMQSocket::send() - Exception: zeromq_send(data) failed");
     _canReconnect = true;
@@ -460,6 +533,94 @@ bool ZMQSocket::internal_receive_request(std::string& cmd, std::string& data, un
   return true;
 }
 
+bool ZMQSocket::sendMultipart(const Buffers& frames)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return internal_send_multipart(frames);
+}
+
+bool ZMQSocket::internal_send_multipart(const Buffers& frames)
+{
+  if (!_socket || frames.empty())
+  {
+    return false;
+  }
+  
+  try
+  {
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+      zmq::message_t message((void*)frames[i]->data(), frames[i]->size(), zeromq_release_buffer, new Buffer(frames[i]));
+      if (!_socket->send(message, i + 1 < frames.size() ? ZMQ_SNDMORE : 0))
+      {
+        return false;
+      }
+    }
+  }
+  catch(zmq::error_t& error_)
+  {
+    OSS_LOG_ERROR("ZMQSocket::sendMultipart() - ZMQ Exception:  " << error_.what());
+    return false;
+  }
+  return true;
+}
+
+bool ZMQSocket::receiveMultipart(Frames& frames, unsigned int timeoutms)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  if (!_socket)
+  {
+    return false;
+  }
+  
+  if (timeoutms && !zeromq_poll_read(_socket, timeoutms))
+  {
+    return false;
+  }
+  return internal_receive_multipart(frames, 0);
+}
+
+bool ZMQSocket::tryReceiveMultipart(Frames& frames)
+{
+  OSS::mutex_critic_sec_lock lock(_mutex);
+  return internal_receive_multipart(frames, ZMQ_DONTWAIT);
+}
+
+bool ZMQSocket::internal_receive_multipart(Frames& frames, int flags)
+{
+  frames.clear();
+  if (!_socket)
+  {
+    return false;
+  }
+  
+  try
+  {
+    for (;;)
+    {
+      zmq::message_t message;
+      if (!_socket->recv(&message, flags))
+      {
+        return false;
+      }
+      frames.push_back(std::string(static_cast<char*>(message.data()), message.size()));
+      if (!zeromq_has_more(*_socket))
+      {
+        return true;
+      }
+      //
+      // The remaining frames of a message are delivered together
+      //
+      flags = 0;
+    }
+  }
+  catch(zmq::error_t& error_)
+  {
+    OSS_LOG_ERROR("ZMQSocket::receiveMultipart() - ZMQ Exception:  " << error_.what());
+  }
+  return false;
+}
+
 int ZMQSocket::poll(ZMQSocket::PollItems& pollItems, long timeoutms)
 {
   zmq::pollitem_t* items = pollItems.data();
@@ -0,0 +1,89 @@
+// OSS Software Solutions Application Programmer Interface
+//
+// Author: Joegen E. Baclor - mailto:joegen@ossapp.com
+//
+// Package: SBC
+//
+// Copyright (c) OSS Software Solutions
+//
+// Permission is hereby granted, to any person or organization
+// obtaining a copy of the software and accompanying documentation covered by
+// this license (the "Software") to use, execute, and to prepare
+// derivative works of the Software, all subject to the
+// "OSS Software Solutions OSS API General License Agreement".
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+// FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+
+
+#include "OSS/ZMQ/ZMQStatsService.h"
+#include "OSS/UTL/Logger.h"
+
+
+#if OSS_HAVE_ZMQ
+
+
+namespace OSS {
+namespace ZMQ {
+
+
+ZMQStatsService::ZMQStatsService(ZMQReactor& reactor, Metrics& metrics) :
+  _metrics(metrics),
+  _server(reactor, boost::bind(&ZMQStatsService::onRequest, this, _1))
+{
+}
+
+ZMQStatsService::~ZMQStatsService()
+{
+  close();
+}
+
+bool ZMQStatsService::bind(const std::string& bindAddress)
+{
+  return _server.bind(bindAddress);
+}
+
+void ZMQStatsService::close()
+{
+  _server.close();
+}
+
+void ZMQStatsService::onRequest(const ZMQRpcServer::Request& request)
+{
+  //
+  // Plain REQ sockets send a single frame which lands in data
+  //
+  const std::string& cmd = request.cmd.empty() ? request.data : request.cmd;
+  
+  std::string reply;
+  if (cmd == "stats.prometheus")
+  {
+    _metrics.toPrometheus(reply);
+  }
+  else if (cmd == "stats.reset")
+  {
+    _metrics.reset();
+    reply = "OK";
+  }
+  else if (cmd.empty() || cmd == "stats" || cmd == "stats.json")
+  {
+    _metrics.toJson(reply);
+  }
+  else
+  {
+    OSS_LOG_WARNING("ZMQStatsService::onRequest() - Unknown command " << cmd);
+    reply = "ERROR unknown command";
+  }
+  _server.sendReply(request, reply);
+}
+
+
+} } // OSS::ZMQ
+
+#endif // OSS_HAVE_ZMQ